@@ -37,6 +37,7 @@
 
 #include "tizchromecast.hpp"
 #include "tizchromecastctx.hpp"
+#include "tizpygil.hpp"
 
 namespace bp = boost::python;
 
@@ -45,6 +46,7 @@ namespace bp = boost::python;
 #define try_catch_wrapper(expr)                                  \
   do                                                             \
     {                                                            \
+      tiz::scoped_gil gil;                                       \
       try                                                        \
         {                                                        \
           (expr);                                                \
@@ -67,6 +69,7 @@ namespace bp = boost::python;
     }                                                            \
   while (0)
 
+
 tizchromecast::tizchromecast (const tizchromecastctx &cc_ctx,
                               const std::string &name_or_ip,
                               const tiz_chromecast_callbacks_t *ap_cbacks,
@@ -256,6 +259,7 @@ tiz_chromecast_error_t tizchromecast::media_unmute ()
 void tizchromecast::new_cast_status (const std::string &status,
                                      const float &volume)
 {
+  tiz::scoped_gil_release nogil;
   const int vol = volume * (float)100;
   // std::cout << "tizchromecast::new_cast_status: " << status << " volume "
   //             << volume << " pid " << getpid () << std::endl;
@@ -291,6 +295,7 @@ void tizchromecast::new_cast_status (const std::string &status,
 void tizchromecast::new_media_status (const std::string &status,
                                       const int &volume)
 {
+  tiz::scoped_gil_release nogil;
   // std::cout << "tizchromecast::new_media_status: " << status << " volume "
   //           << volume << " pid " << getpid () << std::endl;
   if (!status.compare ("UNKNOWN"))
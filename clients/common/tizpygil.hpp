@@ -0,0 +1,103 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizpygil.hpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - GIL handling shared by the service client libraries
+ *
+ * All the client libraries in a process share one embedded interpreter, and
+ * each may call into it from any thread (e.g. the component's thread and the
+ * http source's url resolver). So the interpreter is initialised once and the
+ * GIL is only held while Python code runs: every call into Python takes it
+ * with a scoped_gil, and native code called back from Python gives it up with
+ * a scoped_gil_release.
+ */
+
+#ifndef TIZPYGIL_HPP
+#define TIZPYGIL_HPP
+
+#include <boost/python.hpp>
+
+namespace tiz
+{
+  /**
+   * Holds the GIL while in scope.
+   */
+  class scoped_gil
+  {
+  public:
+    scoped_gil () : state_ (PyGILState_Ensure ())
+    {
+    }
+    ~scoped_gil ()
+    {
+      PyGILState_Release (state_);
+    }
+
+  private:
+    scoped_gil (const scoped_gil &);
+    scoped_gil &operator= (const scoped_gil &);
+
+  private:
+    PyGILState_STATE state_;
+  };
+
+  /**
+   * Releases the GIL while in scope. To be used in calls that Python makes
+   * into native code.
+   */
+  class scoped_gil_release
+  {
+  public:
+    scoped_gil_release () : p_state_ (PyEval_SaveThread ())
+    {
+    }
+    ~scoped_gil_release ()
+    {
+      PyEval_RestoreThread (p_state_);
+    }
+
+  private:
+    scoped_gil_release (const scoped_gil_release &);
+    scoped_gil_release &operator= (const scoped_gil_release &);
+
+  private:
+    PyThreadState *p_state_;
+  };
+
+  /**
+   * Initialises the interpreter, if no other client has done it yet, and
+   * releases the GIL that Py_Initialize leaves with the calling thread.
+   */
+  inline void init_python ()
+  {
+    if (!Py_IsInitialized ())
+      {
+        Py_Initialize ();
+#if PY_VERSION_HEX < 0x03070000
+        PyEval_InitThreads ();
+#endif
+        (void)PyEval_SaveThread ();
+      }
+  }
+}  // namespace tiz
+
+#endif  // TIZPYGIL_HPP
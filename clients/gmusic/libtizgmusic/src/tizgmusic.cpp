@@ -33,6 +33,7 @@
 #include <boost/lexical_cast.hpp>
 
 #include "tizgmusic.hpp"
+#include "tizpygil.hpp"
 
 namespace bp = boost::python;
 
@@ -40,6 +41,7 @@ namespace bp = boost::python;
 #define try_catch_wrapper(expr)                                  \
   do                                                             \
     {                                                            \
+      tiz::scoped_gil gil;                                       \
       try                                                        \
         {                                                        \
           if (!rc)                                               \
@@ -70,7 +72,8 @@ namespace
   int check_deps ()
   {
     int rc = 1;
-    Py_Initialize ();
+    tiz::init_python ();
+    tiz::scoped_gil gil;
 
     try
       {
@@ -157,6 +160,11 @@ tizgmusic::tizgmusic (const std::string &user, const std::string &pass,
 
 tizgmusic::~tizgmusic ()
 {
+  // Drop the references to the proxy with the GIL held
+  tiz::scoped_gil gil;
+  py_gm_proxy_ = bp::object ();
+  py_global_ = bp::object ();
+  py_main_ = bp::object ();
 }
 
 int tizgmusic::init ()
@@ -302,6 +310,7 @@ int tizgmusic::play_promoted_tracks ()
 
 const char *tizgmusic::get_url (const int a_position)
 {
+  tiz::scoped_gil gil;
   try
     {
       int queue_index = 0;
@@ -328,6 +337,7 @@ const char *tizgmusic::get_url (const int a_position)
 
 const char *tizgmusic::get_next_url ()
 {
+  tiz::scoped_gil gil;
   current_url_.clear ();
   try
     {
@@ -347,6 +357,7 @@ const char *tizgmusic::get_next_url ()
 
 const char *tizgmusic::get_prev_url ()
 {
+  tiz::scoped_gil gil;
   current_url_.clear ();
   try
     {
@@ -477,6 +488,7 @@ void tizgmusic::set_playback_mode (const playback_mode mode)
 
 void tizgmusic::get_current_track ()
 {
+  tiz::scoped_gil gil;
   current_track_index_.clear ();
   current_queue_length_.clear ();
   current_artist_.clear ();
@@ -558,6 +570,7 @@ void tizgmusic::get_current_track ()
 void tizgmusic::get_current_track_queue_index_and_length (int &queue_index,
                                                           int &queue_length)
 {
+  tiz::scoped_gil gil;
   const bp::tuple &queue_info = bp::extract< bp::tuple > (
       py_gm_proxy_.attr ("current_track_queue_index_and_queue_length") ());
   queue_index = bp::extract< int > (queue_info[0]);
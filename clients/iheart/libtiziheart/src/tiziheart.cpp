@@ -34,6 +34,7 @@
 #include <iostream>
 
 #include "tiziheart.hpp"
+#include "tizpygil.hpp"
 
 namespace bp = boost::python;
 
@@ -41,6 +42,7 @@ namespace bp = boost::python;
 #define try_catch_wrapper(expr)                                  \
   do                                                             \
     {                                                            \
+      tiz::scoped_gil gil;                                       \
       try                                                        \
         {                                                        \
           (expr);                                                \
@@ -66,7 +68,8 @@ namespace
   int check_deps ()
   {
     int rc = 1;
-    Py_Initialize ();
+    tiz::init_python ();
+    tiz::scoped_gil gil;
 
     try
       {
@@ -135,6 +138,11 @@ tiziheart::tiziheart ()
 
 tiziheart::~tiziheart ()
 {
+  // Drop the references to the proxy with the GIL held
+  tiz::scoped_gil gil;
+  py_iheart_proxy_ = bp::object ();
+  py_global_ = bp::object ();
+  py_main_ = bp::object ();
 }
 
 int tiziheart::init ()
@@ -180,6 +188,7 @@ int tiziheart::play_radios (const std::string &query,
 
 const char *tiziheart::get_url (const int a_position)
 {
+  tiz::scoped_gil gil;
   try
     {
       int queue_length = get_current_queue_length_as_int();
@@ -204,6 +213,7 @@ const char *tiziheart::get_url (const int a_position)
 
 const char *tiziheart::get_next_url (const bool a_remove_current_url)
 {
+  tiz::scoped_gil gil;
   current_url_.clear ();
   try
     {
@@ -227,6 +237,7 @@ const char *tiziheart::get_next_url (const bool a_remove_current_url)
 
 const char *tiziheart::get_prev_url (const bool a_remove_current_url)
 {
+  tiz::scoped_gil gil;
   current_url_.clear ();
   try
     {
@@ -331,6 +342,7 @@ int tiziheart::get_current_queue_length_as_int ()
 
 const char *tiziheart::get_current_queue_progress ()
 {
+  tiz::scoped_gil gil;
     const bp::tuple &queue_info = bp::extract< bp::tuple > (
       py_iheart_proxy_.attr ("current_radio_queue_index_and_queue_length") ());
   const int queue_index = bp::extract< int > (queue_info[0]);
@@ -374,6 +386,7 @@ void tiziheart::set_playback_mode (const playback_mode mode)
 
 void tiziheart::get_current_radio ()
 {
+  tiz::scoped_gil gil;
   current_radio_name_.clear ();
 
   obtain_current_queue_progress ();
@@ -403,6 +416,7 @@ void tiziheart::get_current_radio ()
 
 void tiziheart::obtain_current_queue_progress ()
 {
+  tiz::scoped_gil gil;
   current_radio_index_.clear ();
   current_queue_length_.clear ();
 
@@ -33,6 +33,7 @@
 #include <iostream>
 
 #include "tizplex.hpp"
+#include "tizpygil.hpp"
 
 namespace bp = boost::python;
 
@@ -40,6 +41,7 @@ namespace bp = boost::python;
 #define try_catch_wrapper(expr)                                  \
   do                                                             \
     {                                                            \
+      tiz::scoped_gil gil;                                       \
       try                                                        \
         {                                                        \
           if (!rc)                                               \
@@ -70,7 +72,8 @@ namespace
   int check_deps ()
   {
     int rc = 1;
-    Py_Initialize ();
+    tiz::init_python ();
+    tiz::scoped_gil gil;
 
     try
       {
@@ -158,6 +161,11 @@ tizplex::tizplex (const std::string &base_url, const std::string &auth_token,
 
 tizplex::~tizplex ()
 {
+  // Drop the references to the proxy with the GIL held
+  tiz::scoped_gil gil;
+  py_plex_proxy_ = bp::object ();
+  py_global_ = bp::object ();
+  py_main_ = bp::object ();
 }
 
 int tizplex::init ()
@@ -224,6 +232,7 @@ int tizplex::play_audio_playlist (const std::string &playlist)
 
 const char *tizplex::get_url (const int a_position)
 {
+  tiz::scoped_gil gil;
   try
     {
       int queue_index = 0;
@@ -250,6 +259,7 @@ const char *tizplex::get_url (const int a_position)
 
 const char *tizplex::get_next_url (const bool a_remove_current_url)
 {
+  tiz::scoped_gil gil;
   current_url_.clear ();
   try
     {
@@ -273,6 +283,7 @@ const char *tizplex::get_next_url (const bool a_remove_current_url)
 
 const char *tizplex::get_prev_url (const bool a_remove_current_url)
 {
+  tiz::scoped_gil gil;
   current_url_.clear ();
   try
     {
@@ -414,6 +425,7 @@ const char *tizplex::get_current_audio_track_album_art ()
 
 void tizplex::get_current_track ()
 {
+  tiz::scoped_gil gil;
   current_track_index_.clear ();
   current_queue_length_.clear ();
   current_track_title_.clear ();
@@ -508,6 +520,7 @@ void tizplex::get_current_track ()
 void tizplex::get_current_track_queue_index_and_length (int &queue_index,
                                                         int &queue_length)
 {
+  tiz::scoped_gil gil;
   const bp::tuple &queue_info = bp::extract< bp::tuple > (
       py_plex_proxy_.attr ("current_audio_track_queue_index_and_queue_length") ());
   queue_index = bp::extract< int > (queue_info[0]);
@@ -34,6 +34,7 @@
 #include <iostream>
 
 #include "tizsoundcloud.hpp"
+#include "tizpygil.hpp"
 
 namespace bp = boost::python;
 
@@ -41,6 +42,7 @@ namespace bp = boost::python;
 #define try_catch_wrapper(expr)                                  \
   do                                                             \
     {                                                            \
+      tiz::scoped_gil gil;                                       \
       try                                                        \
         {                                                        \
           if (!rc)                                               \
@@ -71,7 +73,8 @@ namespace
   int check_deps ()
   {
     int rc = 1;
-    Py_Initialize ();
+    tiz::init_python ();
+    tiz::scoped_gil gil;
 
     try
       {
@@ -153,6 +156,11 @@ tizsoundcloud::tizsoundcloud (const std::string &oauth_token)
 
 tizsoundcloud::~tizsoundcloud ()
 {
+  // Drop the references to the proxy with the GIL held
+  tiz::scoped_gil gil;
+  py_sc_proxy_ = bp::object ();
+  py_global_ = bp::object ();
+  py_main_ = bp::object ();
 }
 
 int tizsoundcloud::init ()
@@ -247,6 +255,7 @@ int tizsoundcloud::play_tags (const std::string &tags)
 
 const char *tizsoundcloud::get_next_url ()
 {
+  tiz::scoped_gil gil;
   current_url_.clear ();
   try
     {
@@ -266,6 +275,7 @@ const char *tizsoundcloud::get_next_url ()
 
 const char *tizsoundcloud::get_url (const int a_position)
 {
+  tiz::scoped_gil gil;
   try
     {
       int queue_index = 0;
@@ -292,6 +302,7 @@ const char *tizsoundcloud::get_url (const int a_position)
 
 const char *tizsoundcloud::get_prev_url ()
 {
+  tiz::scoped_gil gil;
   current_url_.clear ();
   try
     {
@@ -420,6 +431,7 @@ void tizsoundcloud::set_playback_mode (const playback_mode mode)
 
 void tizsoundcloud::get_current_track ()
 {
+  tiz::scoped_gil gil;
   current_track_index_.clear ();
   current_queue_length_.clear ();
   current_user_.clear ();
@@ -498,6 +510,7 @@ void tizsoundcloud::get_current_track ()
 void tizsoundcloud::get_current_track_queue_index_and_length (int &queue_index,
                                                               int &queue_length)
 {
+  tiz::scoped_gil gil;
   const bp::tuple &queue_info = bp::extract< bp::tuple > (
       py_sc_proxy_.attr ("current_track_queue_index_and_queue_length") ());
   queue_index = bp::extract< int > (queue_info[0]);
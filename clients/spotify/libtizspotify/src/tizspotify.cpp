@@ -33,6 +33,7 @@
 #include <iostream>
 
 #include "tizspotify.hpp"
+#include "tizpygil.hpp"
 
 namespace bp = boost::python;
 
@@ -40,6 +41,7 @@ namespace bp = boost::python;
 #define try_catch_wrapper(expr)                                  \
   do                                                             \
     {                                                            \
+      tiz::scoped_gil gil;                                       \
       try                                                        \
         {                                                        \
           if (!rc)                                               \
@@ -70,7 +72,8 @@ namespace
   int check_deps ()
   {
     int rc = 1;
-    Py_Initialize ();
+    tiz::init_python ();
+    tiz::scoped_gil gil;
 
     try
       {
@@ -154,6 +157,11 @@ tizspotify::tizspotify (const std::string &user, const std::string &pass)
 
 tizspotify::~tizspotify ()
 {
+  // Drop the references to the proxy with the GIL held
+  tiz::scoped_gil gil;
+  py_spotify_proxy_ = bp::object ();
+  py_global_ = bp::object ();
+  py_main_ = bp::object ();
 }
 
 int tizspotify::init ()
@@ -354,6 +362,7 @@ int tizspotify::play_current_user_playlist (const std::string &playlist)
 
 const char *tizspotify::get_uri (const int a_position)
 {
+  tiz::scoped_gil gil;
   try
     {
       int queue_index = 0;
@@ -380,6 +389,7 @@ const char *tizspotify::get_uri (const int a_position)
 
 const char *tizspotify::get_next_uri (const bool a_remove_current_uri)
 {
+  tiz::scoped_gil gil;
   current_uri_.clear ();
   try
     {
@@ -410,6 +420,7 @@ const char *tizspotify::get_next_uri (const bool a_remove_current_uri)
 
 const char *tizspotify::get_prev_uri (const bool a_remove_current_uri)
 {
+  tiz::scoped_gil gil;
   current_uri_.clear ();
   try
     {
@@ -583,6 +594,7 @@ const char *tizspotify::get_current_track_explicitness ()
 
 void tizspotify::get_current_track ()
 {
+  tiz::scoped_gil gil;
   current_track_index_.clear ();
   current_queue_length_.clear ();
   current_track_title_.clear ();
@@ -672,6 +684,7 @@ void tizspotify::get_current_track ()
 void tizspotify::get_current_track_queue_index_and_length (int &queue_index,
                                                            int &queue_length)
 {
+  tiz::scoped_gil gil;
   const bp::tuple &queue_info = bp::extract< bp::tuple > (
       py_spotify_proxy_.attr ("current_track_queue_index_and_queue_length") ());
   queue_index = bp::extract< int > (queue_info[0]);
@@ -36,6 +36,7 @@
 #include <iostream>
 
 #include "tiztunein.hpp"
+#include "tizpygil.hpp"
 
 namespace bp = boost::python;
 
@@ -43,6 +44,7 @@ namespace bp = boost::python;
 #define try_catch_wrapper(expr)                                  \
   do                                                             \
     {                                                            \
+      tiz::scoped_gil gil;                                       \
       try                                                        \
         {                                                        \
           (expr);                                                \
@@ -68,7 +70,8 @@ namespace
   int check_deps ()
   {
     int rc = 1;
-    Py_Initialize ();
+    tiz::init_python ();
+    tiz::scoped_gil gil;
 
     try
       {
@@ -137,6 +140,11 @@ tiztunein::tiztunein ()
 
 tiztunein::~tiztunein ()
 {
+  // Drop the references to the proxy with the GIL held
+  tiz::scoped_gil gil;
+  py_tunein_proxy_ = bp::object ();
+  py_global_ = bp::object ();
+  py_main_ = bp::object ();
 }
 
 int tiztunein::init ()
@@ -194,6 +202,7 @@ int tiztunein::play_category (const std::string &category,
 
 const char *tiztunein::get_url (const int a_position)
 {
+  tiz::scoped_gil gil;
   try
     {
       int queue_length = get_current_queue_length_as_int();
@@ -218,6 +227,7 @@ const char *tiztunein::get_url (const int a_position)
 
 const char *tiztunein::get_next_url (const bool a_remove_current_url)
 {
+  tiz::scoped_gil gil;
   current_url_.clear ();
   try
     {
@@ -241,6 +251,7 @@ const char *tiztunein::get_next_url (const bool a_remove_current_url)
 
 const char *tiztunein::get_prev_url (const bool a_remove_current_url)
 {
+  tiz::scoped_gil gil;
   current_url_.clear ();
   try
     {
@@ -351,6 +362,7 @@ int tiztunein::get_current_queue_length_as_int ()
 
 const char *tiztunein::get_current_queue_progress ()
 {
+  tiz::scoped_gil gil;
     const bp::tuple &queue_info = bp::extract< bp::tuple > (
       py_tunein_proxy_.attr ("current_radio_queue_index_and_queue_length") ());
   const int queue_index = bp::extract< int > (queue_info[0]);
@@ -426,6 +438,7 @@ void tiztunein::set_search_mode (const search_mode mode)
 
 void tiztunein::get_current_radio ()
 {
+  tiz::scoped_gil gil;
   current_radio_name_.clear ();
 
   obtain_current_queue_progress ();
@@ -456,6 +469,7 @@ void tiztunein::get_current_radio ()
 
 void tiztunein::obtain_current_queue_progress ()
 {
+  tiz::scoped_gil gil;
   current_radio_index_.clear ();
   current_queue_length_.clear ();
 
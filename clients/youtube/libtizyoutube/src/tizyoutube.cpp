@@ -39,6 +39,7 @@
 #include <boost/algorithm/string/join.hpp>
 
 #include "tizyoutube.hpp"
+#include "tizpygil.hpp"
 
 namespace bp = boost::python;
 
@@ -46,6 +47,7 @@ namespace bp = boost::python;
 #define try_catch_wrapper(expr)                                  \
   do                                                             \
     {                                                            \
+      tiz::scoped_gil gil;                                       \
       try                                                        \
         {                                                        \
           if (!rc)                                               \
@@ -76,7 +78,8 @@ namespace
   int check_deps ()
   {
     int rc = 1;
-    Py_Initialize ();
+    tiz::init_python ();
+    tiz::scoped_gil gil;
 
     try
       {
@@ -175,6 +178,11 @@ tizyoutube::tizyoutube (const std::string &api_key)
 
 tizyoutube::~tizyoutube ()
 {
+  // Drop the references to the proxy with the GIL held
+  tiz::scoped_gil gil;
+  py_yt_proxy_ = bp::object ();
+  py_global_ = bp::object ();
+  py_main_ = bp::object ();
 }
 
 int tizyoutube::init ()
@@ -279,6 +287,7 @@ int tizyoutube::play_audio_channel_playlist (
 
 const char *tizyoutube::get_url (const int a_position)
 {
+  tiz::scoped_gil gil;
   try
     {
       int queue_index = 0;
@@ -305,6 +314,7 @@ const char *tizyoutube::get_url (const int a_position)
 
 const char *tizyoutube::get_next_url (const bool a_remove_current_url)
 {
+  tiz::scoped_gil gil;
   current_url_.clear ();
   try
     {
@@ -327,6 +337,7 @@ const char *tizyoutube::get_next_url (const bool a_remove_current_url)
 
 const char *tizyoutube::get_prev_url (const bool a_remove_current_url)
 {
+  tiz::scoped_gil gil;
   current_url_.clear ();
   try
     {
@@ -347,6 +358,13 @@ const char *tizyoutube::get_prev_url (const bool a_remove_current_url)
   return current_url_.empty () ? NULL : current_url_.c_str ();
 }
 
+int tizyoutube::prefetch_url (const int a_offset)
+{
+  int rc = 0;
+  try_catch_wrapper (py_yt_proxy_.attr ("prefetch_url") (bp::object (a_offset)));
+  return rc;
+}
+
 void tizyoutube::clear_queue ()
 {
   int rc = 0;
@@ -477,6 +495,7 @@ const char *tizyoutube::get_current_audio_stream_published ()
 
 void tizyoutube::get_current_stream ()
 {
+  tiz::scoped_gil gil;
   current_stream_index_.clear ();
   current_queue_length_.clear ();
   current_stream_title_.clear ();
@@ -593,6 +612,7 @@ void tizyoutube::get_current_stream ()
 void tizyoutube::get_current_stream_queue_index_and_length (int &queue_index,
                                                             int &queue_length)
 {
+  tiz::scoped_gil gil;
   const bp::tuple &queue_info = bp::extract< bp::tuple > (py_yt_proxy_.attr (
       "current_audio_stream_queue_index_and_queue_length") ());
   queue_index = bp::extract< int > (queue_info[0]);
@@ -75,6 +75,7 @@ public:
   const char *get_url (const int a_position);
   const char *get_next_url (const bool a_remove_current_url);
   const char *get_prev_url (const bool a_remove_current_url);
+  int prefetch_url (const int a_offset);
 
   const char *get_current_audio_stream_title ();
   const char *get_current_audio_stream_author ();
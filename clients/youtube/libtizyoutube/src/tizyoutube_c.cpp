@@ -233,6 +233,14 @@ extern "C" const char *tiz_youtube_get_prev_url (
   return ap_youtube->p_proxy_->get_prev_url (a_remove_current_url);
 }
 
+extern "C" int tiz_youtube_prefetch_url (tiz_youtube_t *ap_youtube,
+                                         const int a_offset)
+{
+  assert (ap_youtube);
+  assert (ap_youtube->p_proxy_);
+  return ap_youtube->p_proxy_->prefetch_url (a_offset);
+}
+
 extern "C" const char *tiz_youtube_get_current_audio_stream_title (
     tiz_youtube_t *ap_youtube)
 {
@@ -311,6 +311,22 @@ extern "C"
   const char *tiz_youtube_get_prev_url (tiz_youtube_t *ap_youtube,
                                         const bool a_remove_current_url);
 
+  /**
+   * Resolve ahead of time the url of a stream that comes after the current one
+   * in the playback queue, so that moving to it later does not have to wait.
+   *
+   * The playback queue pointer does not move.
+   *
+   * @ingroup libtizyoutube
+   *
+   * @param ap_youtube The tiz_youtube handle.
+   * @param a_offset The position of the stream relative to the current one
+   * (1 is the next stream).
+   *
+   * @return 0 on success.
+   */
+  int tiz_youtube_prefetch_url (tiz_youtube_t *ap_youtube, const int a_offset);
+
   /**
    * Retrieve the current audio stream's title.
    *
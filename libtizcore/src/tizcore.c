@@ -30,6 +30,7 @@
 #endif
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <stdbool.h>
 #include <assert.h>
 #include <sys/types.h>
@@ -68,6 +69,9 @@
 #define TIZ_IL_CORE_RM_NAME "OMX.Aratelia.ilcore"
 #define TIZ_DEFAULT_COMP_ENTRY_POINT_NAME "OMX_ComponentInit"
 #define TIZ_CORE_QUEUE_MAX_ITEMS 30
+#define TIZ_CORE_REGISTRY_CACHE_MAGIC "TIZCOREREG1"
+#define TIZ_CORE_REGISTRY_CACHE_NAME "tizonia/ilcore-registry.cache"
+#define TIZ_CORE_REGISTRY_CACHE_FIELDS 8
 
 typedef struct role_list_item role_list_item_t;
 typedef role_list_item_t * role_list_t;
@@ -434,6 +438,33 @@ get_component_roles (OMX_COMPONENTTYPE * ap_hdl, role_list_t * app_role_list)
   return rc;
 }
 
+static void
+append_to_registry (tiz_core_registry_item_t * ap_reg_item)
+{
+  tiz_core_t * p_core = get_core ();
+  tiz_core_registry_item_t * p_registry_last = NULL;
+
+  assert (p_core);
+  assert (ap_reg_item);
+
+  if (NULL == (p_core->p_registry))
+    {
+      /* First entry in the registry */
+      TIZ_LOG (TIZ_PRIORITY_TRACE, "Component added (first component)");
+      p_core->p_registry = ap_reg_item;
+    }
+  else
+    {
+      /* Find the last entry in the registry */
+      p_registry_last = p_core->p_registry;
+      while (p_registry_last->p_next)
+        {
+          p_registry_last = p_registry_last->p_next;
+        }
+      p_registry_last->p_next = ap_reg_item;
+    }
+}
+
 static OMX_ERRORTYPE
 add_to_comp_registry (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name,
                       OMX_PTR ap_entry_point, OMX_PTR ap_dl_hdl,
@@ -506,6 +537,8 @@ add_to_comp_registry (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name,
                comp_name);
       tiz_mem_free (p_registry_new);
       (void) ap_hdl->ComponentDeInit ((OMX_HANDLETYPE) ap_hdl);
+      /* Let the caller know which entry is already there */
+      *app_reg_item = p_registry_last;
       return OMX_ErrorUndefined;
     }
 
@@ -529,31 +562,7 @@ add_to_comp_registry (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name,
     {
 
       /* Add to registry */
-      if (NULL == (p_core->p_registry))
-        {
-          /* First entry in the registry */
-          TIZ_LOG (TIZ_PRIORITY_TRACE, "Component added (first component) [%s]",
-                   comp_name);
-
-          p_core->p_registry = p_registry_new;
-        }
-      else
-        {
-          /* Find the last entry in the registry */
-          p_registry_last = p_core->p_registry;
-          while (true)
-            {
-              if (p_registry_last->p_next)
-                {
-                  p_registry_last = p_registry_last->p_next;
-                }
-              else
-                {
-                  break;
-                }
-            }
-          p_registry_last->p_next = p_registry_new;
-        }
+      append_to_registry (p_registry_new);
 
       /* Finish filling the registry entry... */
       p_registry_new->p_comp_name
@@ -671,7 +680,8 @@ instantiate_comp_lib (const OMX_STRING ap_path, const OMX_STRING ap_name,
 }
 
 static OMX_ERRORTYPE
-cache_comp_info (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name)
+cache_comp_info (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name,
+                 tiz_core_registry_item_t ** app_reg_item)
 {
   OMX_PTR p_dl_hdl = NULL;
   OMX_PTR p_entry_point = NULL;
@@ -679,6 +689,8 @@ cache_comp_info (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name)
   OMX_COMPONENTTYPE * p_hdl = NULL;
   tiz_core_registry_item_t * p_reg_item = NULL;
 
+  assert (app_reg_item);
+
   TIZ_LOG (TIZ_PRIORITY_TRACE, "dl_name [%s]", ap_dl_name);
 
   rc = instantiate_comp_lib (
@@ -722,6 +734,7 @@ cache_comp_info (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name)
       rc = OMX_ErrorNone;
     }
 
+  *app_reg_item = p_reg_item;
   return rc;
 }
 
@@ -767,6 +780,583 @@ free_paths (char ** pp_paths, unsigned long npaths)
   tiz_mem_free (pp_paths);
 }
 
+/* A registry cache entry records what a component library contained when it
+   was last probed (its component name and roles, or nothing if it turned out
+   not to be a usable component), together with the attributes the file had
+   at that time. The entry is trusted only while those attributes stay the
+   same. */
+typedef struct tiz_core_cache_item tiz_core_cache_item_t;
+struct tiz_core_cache_item
+{
+  OMX_STRING p_dl_path;
+  OMX_STRING p_dl_name;
+  unsigned long long dev;
+  unsigned long long ino;
+  unsigned long long size;
+  unsigned long long mtime_sec;
+  unsigned long long mtime_nsec;
+  OMX_STRING p_comp_name;
+  role_list_t p_roles;
+  bool in_use;
+  tiz_core_cache_item_t * p_next;
+};
+
+/* NOTE: The IL Core thread has a small stack; path buffers live here */
+typedef struct tiz_core_cache tiz_core_cache_t;
+struct tiz_core_cache
+{
+  char file[PATH_MAX];
+  char scratch[PATH_MAX + 32];
+  tiz_core_cache_item_t * p_items;
+  tiz_core_cache_item_t * p_last;
+  bool dirty;
+};
+
+static void
+free_cache_item (tiz_core_cache_item_t * ap_item)
+{
+  if (ap_item)
+    {
+      tiz_mem_free (ap_item->p_dl_path);
+      tiz_mem_free (ap_item->p_dl_name);
+      tiz_mem_free (ap_item->p_comp_name);
+      free_roles (ap_item->p_roles);
+      tiz_mem_free (ap_item);
+    }
+}
+
+static void
+free_cache_items (tiz_core_cache_t * ap_cache)
+{
+  tiz_core_cache_item_t * p_next = NULL;
+
+  assert (ap_cache);
+
+  while (ap_cache->p_items)
+    {
+      p_next = ap_cache->p_items->p_next;
+      free_cache_item (ap_cache->p_items);
+      ap_cache->p_items = p_next;
+    }
+  ap_cache->p_last = NULL;
+}
+
+static void
+append_cache_item (tiz_core_cache_t * ap_cache,
+                   tiz_core_cache_item_t * ap_item)
+{
+  assert (ap_cache);
+  assert (ap_item);
+
+  if (ap_cache->p_last)
+    {
+      ap_cache->p_last->p_next = ap_item;
+    }
+  else
+    {
+      ap_cache->p_items = ap_item;
+    }
+  ap_cache->p_last = ap_item;
+}
+
+static OMX_ERRORTYPE
+copy_roles (const role_list_item_t * ap_src, role_list_t * app_dst)
+{
+  role_list_item_t * p_role = NULL;
+  role_list_item_t * p_last = NULL;
+
+  assert (app_dst);
+  *app_dst = NULL;
+
+  for (; ap_src; ap_src = ap_src->p_next)
+    {
+      if (NULL == (p_role = (role_list_item_t *) tiz_mem_calloc (
+                     1, sizeof (role_list_item_t))))
+        {
+          free_roles (*app_dst);
+          *app_dst = NULL;
+          return OMX_ErrorInsufficientResources;
+        }
+      memcpy (p_role->role, ap_src->role, OMX_MAX_STRINGNAME_SIZE);
+      if (p_last)
+        {
+          p_last->p_next = p_role;
+        }
+      else
+        {
+          *app_dst = p_role;
+        }
+      p_last = p_role;
+    }
+
+  return OMX_ErrorNone;
+}
+
+static bool
+parse_cache_number (const char * ap_str, unsigned long long * ap_num)
+{
+  char * p_end = NULL;
+
+  assert (ap_str);
+  assert (ap_num);
+
+  errno = 0;
+  *ap_num = strtoull (ap_str, &p_end, 10);
+  return (0 == errno && p_end != ap_str && '\0' == *p_end);
+}
+
+/* Each line of the cache file describes one library, with tab-separated
+   fields: directory, file name, device, inode, size, mtime (seconds and
+   nanoseconds), component name (empty if the library is not a usable
+   component) and, after that, the component's roles. */
+static tiz_core_cache_item_t *
+parse_cache_line (char * ap_line)
+{
+  char * p_fields[TIZ_CORE_REGISTRY_CACHE_FIELDS];
+  char * p_role_str = NULL;
+  role_list_item_t * p_role = NULL;
+  role_list_item_t * p_last = NULL;
+  tiz_core_cache_item_t * p_item = NULL;
+  int i = 0;
+
+  assert (ap_line);
+
+  for (i = 0; i < TIZ_CORE_REGISTRY_CACHE_FIELDS; ++i)
+    {
+      if (NULL == (p_fields[i] = strsep (&ap_line, "\t")))
+        {
+          return NULL;
+        }
+    }
+
+  if ('\0' == p_fields[0][0] || '\0' == p_fields[1][0]
+      || strlen (p_fields[7]) >= OMX_MAX_STRINGNAME_SIZE
+      || NULL == (p_item = (tiz_core_cache_item_t *) tiz_mem_calloc (
+                    1, sizeof (tiz_core_cache_item_t))))
+    {
+      return NULL;
+    }
+
+  if (!parse_cache_number (p_fields[2], &p_item->dev)
+      || !parse_cache_number (p_fields[3], &p_item->ino)
+      || !parse_cache_number (p_fields[4], &p_item->size)
+      || !parse_cache_number (p_fields[5], &p_item->mtime_sec)
+      || !parse_cache_number (p_fields[6], &p_item->mtime_nsec)
+      || NULL == (p_item->p_dl_path = strndup (p_fields[0], PATH_MAX))
+      || NULL == (p_item->p_dl_name = strndup (p_fields[1], NAME_MAX))
+      || ('\0' != p_fields[7][0]
+          && NULL == (p_item->p_comp_name
+                      = strndup (p_fields[7], OMX_MAX_STRINGNAME_SIZE))))
+    {
+      free_cache_item (p_item);
+      return NULL;
+    }
+
+  while ((p_role_str = strsep (&ap_line, "\t")))
+    {
+      if (NULL == p_item->p_comp_name || '\0' == p_role_str[0]
+          || strlen (p_role_str) >= OMX_MAX_STRINGNAME_SIZE
+          || NULL == (p_role = (role_list_item_t *) tiz_mem_calloc (
+                        1, sizeof (role_list_item_t))))
+        {
+          free_cache_item (p_item);
+          return NULL;
+        }
+      strncpy ((char *) p_role->role, p_role_str, OMX_MAX_STRINGNAME_SIZE);
+      if (p_last)
+        {
+          p_last->p_next = p_role;
+        }
+      else
+        {
+          p_item->p_roles = p_role;
+        }
+      p_last = p_role;
+    }
+
+  /* Components with no roles are never registered */
+  if (p_item->p_comp_name && NULL == p_item->p_roles)
+    {
+      free_cache_item (p_item);
+      return NULL;
+    }
+
+  return p_item;
+}
+
+static bool
+get_cache_file (char * ap_file, size_t a_len)
+{
+  const char * p_value = NULL;
+
+  assert (ap_file);
+
+  if (0 == tiz_rcfile_compare_value ("il-core", "registry-cache", "false"))
+    {
+      return false;
+    }
+
+  if ((p_value = tiz_rcfile_get_value ("il-core", "registry-cache.file"))
+      && '\0' != p_value[0])
+    {
+      snprintf (ap_file, a_len, "%s", p_value);
+    }
+  else if ((p_value = getenv ("XDG_CACHE_HOME")) && '\0' != p_value[0])
+    {
+      snprintf (ap_file, a_len, "%s/%s", p_value,
+                TIZ_CORE_REGISTRY_CACHE_NAME);
+    }
+  else if ((p_value = getenv ("HOME")) && '\0' != p_value[0])
+    {
+      snprintf (ap_file, a_len, "%s/.cache/%s", p_value,
+                TIZ_CORE_REGISTRY_CACHE_NAME);
+    }
+  else
+    {
+      return false;
+    }
+
+  return true;
+}
+
+static void
+free_cache (tiz_core_cache_t * ap_cache)
+{
+  if (ap_cache)
+    {
+      free_cache_items (ap_cache);
+      tiz_mem_free (ap_cache);
+    }
+}
+
+/* Returns NULL if the cache is disabled */
+static tiz_core_cache_t *
+load_cache (void)
+{
+  tiz_core_cache_t * p_cache = NULL;
+  FILE * p_file = NULL;
+  char * p_line = NULL;
+  size_t line_size = 0;
+  ssize_t len = 0;
+  tiz_core_cache_item_t * p_item = NULL;
+
+  if (NULL == (p_cache = (tiz_core_cache_t *) tiz_mem_calloc (
+                 1, sizeof (tiz_core_cache_t))))
+    {
+      return NULL;
+    }
+
+  if (!get_cache_file (p_cache->file, sizeof (p_cache->file)))
+    {
+      TIZ_LOG (TIZ_PRIORITY_TRACE, "Component registry cache disabled");
+      tiz_mem_free (p_cache);
+      return NULL;
+    }
+
+  if (NULL == (p_file = fopen (p_cache->file, "r")))
+    {
+      TIZ_LOG (TIZ_PRIORITY_TRACE, "No component registry cache at [%s]",
+               p_cache->file);
+      p_cache->dirty = true;
+      return p_cache;
+    }
+
+  if ((len = getline (&p_line, &line_size, p_file)) <= 0
+      || 0 != strcmp (p_line, TIZ_CORE_REGISTRY_CACHE_MAGIC "\n"))
+    {
+      len = -2;
+    }
+
+  while (len > 0 && (len = getline (&p_line, &line_size, p_file)) > 0)
+    {
+      if ('\n' != p_line[len - 1])
+        {
+          /* Truncated file */
+          len = -2;
+          break;
+        }
+      p_line[len - 1] = '\0';
+      if (NULL == (p_item = parse_cache_line (p_line)))
+        {
+          len = -2;
+          break;
+        }
+      append_cache_item (p_cache, p_item);
+    }
+
+  if (-2 == len)
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE,
+               "Discarding invalid component registry cache [%s]",
+               p_cache->file);
+      free_cache_items (p_cache);
+      p_cache->dirty = true;
+    }
+
+  free (p_line);
+  (void) fclose (p_file);
+  return p_cache;
+}
+
+static bool
+is_cacheable_str (const char * ap_str)
+{
+  return (NULL == ap_str || NULL == strpbrk (ap_str, "\t\n"));
+}
+
+static void
+make_parent_dirs (tiz_core_cache_t * ap_cache)
+{
+  char * p_dir = ap_cache->scratch;
+  char * p_sep = NULL;
+
+  snprintf (p_dir, sizeof (ap_cache->scratch), "%s", ap_cache->file);
+  for (p_sep = strchr (p_dir + 1, '/'); p_sep; p_sep = strchr (p_sep + 1, '/'))
+    {
+      *p_sep = '\0';
+      (void) mkdir (p_dir, 0755);
+      *p_sep = '/';
+    }
+}
+
+/* Entries of libraries that were not found during the scan are dropped. The
+   file is replaced atomically, so concurrent processes either see the old or
+   the new version. */
+static void
+save_cache (tiz_core_cache_t * ap_cache)
+{
+  FILE * p_file = NULL;
+  char * p_tmp_file = NULL;
+  const tiz_core_cache_item_t * p_item = NULL;
+  const role_list_item_t * p_role = NULL;
+  bool ok = true;
+
+  assert (ap_cache);
+
+  for (p_item = ap_cache->p_items; p_item && !ap_cache->dirty;
+       p_item = p_item->p_next)
+    {
+      ap_cache->dirty = !p_item->in_use;
+    }
+
+  if (!ap_cache->dirty)
+    {
+      return;
+    }
+
+  make_parent_dirs (ap_cache);
+  p_tmp_file = ap_cache->scratch;
+  snprintf (p_tmp_file, sizeof (ap_cache->scratch), "%s.%ld", ap_cache->file,
+            (long) getpid ());
+  if (NULL == (p_file = fopen (p_tmp_file, "w")))
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE,
+               "Could not write the component registry cache [%s] - [%s]",
+               p_tmp_file, strerror (errno));
+      return;
+    }
+
+  ok = (fputs (TIZ_CORE_REGISTRY_CACHE_MAGIC "\n", p_file) >= 0);
+  for (p_item = ap_cache->p_items; p_item && ok; p_item = p_item->p_next)
+    {
+      if (!p_item->in_use || !is_cacheable_str (p_item->p_dl_path)
+          || !is_cacheable_str (p_item->p_dl_name)
+          || !is_cacheable_str (p_item->p_comp_name))
+        {
+          continue;
+        }
+      ok = (fprintf (p_file, "%s\t%s\t%llu\t%llu\t%llu\t%llu\t%llu\t%s",
+                     p_item->p_dl_path, p_item->p_dl_name, p_item->dev,
+                     p_item->ino, p_item->size, p_item->mtime_sec,
+                     p_item->mtime_nsec,
+                     p_item->p_comp_name ? p_item->p_comp_name : "")
+            >= 0);
+      for (p_role = p_item->p_roles; p_role && ok; p_role = p_role->p_next)
+        {
+          ok = is_cacheable_str ((const char *) p_role->role)
+               && (fprintf (p_file, "\t%s", p_role->role) >= 0);
+        }
+      ok = ok && (fputc ('\n', p_file) != EOF);
+    }
+
+  ok = (0 == fclose (p_file)) && ok;
+  if (!ok || 0 != rename (p_tmp_file, ap_cache->file))
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE,
+               "Could not write the component registry cache [%s]",
+               ap_cache->file);
+      (void) unlink (p_tmp_file);
+      return;
+    }
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "Component registry cache [%s] updated",
+           ap_cache->file);
+}
+
+static tiz_core_cache_item_t *
+find_cache_item (const tiz_core_cache_t * ap_cache,
+                 const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name)
+{
+  tiz_core_cache_item_t * p_item = NULL;
+
+  assert (ap_cache);
+
+  for (p_item = ap_cache->p_items; p_item; p_item = p_item->p_next)
+    {
+      if (!p_item->in_use && 0 == strcmp (p_item->p_dl_name, ap_dl_name)
+          && 0 == strcmp (p_item->p_dl_path, ap_dl_path))
+        {
+          break;
+        }
+    }
+
+  return p_item;
+}
+
+static bool
+cache_item_matches (const tiz_core_cache_item_t * ap_item,
+                    const struct stat * ap_st)
+{
+  assert (ap_item);
+  assert (ap_st);
+
+  return (ap_item->dev == (unsigned long long) ap_st->st_dev
+          && ap_item->ino == (unsigned long long) ap_st->st_ino
+          && ap_item->size == (unsigned long long) ap_st->st_size
+          && ap_item->mtime_sec == (unsigned long long) ap_st->st_mtim.tv_sec
+          && ap_item->mtime_nsec
+               == (unsigned long long) ap_st->st_mtim.tv_nsec);
+}
+
+static void
+add_cache_item (tiz_core_cache_t * ap_cache, const OMX_STRING ap_dl_path,
+                const OMX_STRING ap_dl_name, const struct stat * ap_st,
+                const tiz_core_registry_item_t * ap_reg_item)
+{
+  tiz_core_cache_item_t * p_item = NULL;
+
+  assert (ap_cache);
+  assert (ap_st);
+
+  if (NULL == (p_item = (tiz_core_cache_item_t *) tiz_mem_calloc (
+                 1, sizeof (tiz_core_cache_item_t)))
+      || NULL == (p_item->p_dl_path = strndup (ap_dl_path, PATH_MAX))
+      || NULL == (p_item->p_dl_name = strndup (ap_dl_name, NAME_MAX))
+      || (ap_reg_item
+          && (NULL == (p_item->p_comp_name = strndup (
+                         ap_reg_item->p_comp_name, OMX_MAX_STRINGNAME_SIZE))
+              || OMX_ErrorNone
+                   != copy_roles (ap_reg_item->p_roles, &p_item->p_roles))))
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "[%s] : not cached (out of memory)",
+               ap_dl_name);
+      free_cache_item (p_item);
+      return;
+    }
+
+  p_item->dev = (unsigned long long) ap_st->st_dev;
+  p_item->ino = (unsigned long long) ap_st->st_ino;
+  p_item->size = (unsigned long long) ap_st->st_size;
+  p_item->mtime_sec = (unsigned long long) ap_st->st_mtim.tv_sec;
+  p_item->mtime_nsec = (unsigned long long) ap_st->st_mtim.tv_nsec;
+  p_item->in_use = true;
+  append_cache_item (ap_cache, p_item);
+  ap_cache->dirty = true;
+}
+
+/* Register a component from its cache entry. The library is not loaded until
+   the component is instantiated with OMX_GetHandle. */
+static OMX_ERRORTYPE
+add_cached_to_comp_registry (const tiz_core_cache_item_t * ap_item)
+{
+  tiz_core_registry_item_t * p_reg_item = NULL;
+
+  assert (ap_item);
+  assert (ap_item->p_comp_name);
+
+  if (find_comp_in_registry (ap_item->p_comp_name))
+    {
+      return OMX_ErrorNone;
+    }
+
+  if (NULL == (p_reg_item = (tiz_core_registry_item_t *) tiz_mem_calloc (
+                 1, sizeof (tiz_core_registry_item_t)))
+      || NULL == (p_reg_item->p_comp_name
+                  = strndup (ap_item->p_comp_name, OMX_MAX_STRINGNAME_SIZE))
+      || NULL == (p_reg_item->p_dl_name = strndup (ap_item->p_dl_name, NAME_MAX))
+      || NULL == (p_reg_item->p_dl_path = strndup (ap_item->p_dl_path, PATH_MAX))
+      || OMX_ErrorNone != copy_roles (ap_item->p_roles, &p_reg_item->p_roles))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "[OMX_ErrorInsufficientResources] : "
+               "Could not allocate memory for registry item.");
+      if (p_reg_item)
+        {
+          tiz_mem_free (p_reg_item->p_comp_name);
+          tiz_mem_free (p_reg_item->p_dl_name);
+          tiz_mem_free (p_reg_item->p_dl_path);
+          tiz_mem_free (p_reg_item);
+        }
+      return OMX_ErrorInsufficientResources;
+    }
+
+  append_to_registry (p_reg_item);
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "Component [%s] added from cache [%s].",
+           p_reg_item->p_comp_name, p_reg_item->p_dl_name);
+
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+register_comp_lib (tiz_core_cache_t * ap_cache, const OMX_STRING ap_dl_path,
+                   const OMX_STRING ap_dl_name)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  tiz_core_cache_item_t * p_item = NULL;
+  tiz_core_registry_item_t * p_reg_item = NULL;
+  struct stat st;
+
+  if (NULL == ap_cache)
+    {
+      return cache_comp_info (ap_dl_path, ap_dl_name, &p_reg_item);
+    }
+
+  snprintf (ap_cache->scratch, sizeof (ap_cache->scratch), "%s/%s",
+            ap_dl_path, ap_dl_name);
+  if (0 != stat (ap_cache->scratch, &st))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "Could not stat [%s] - [%s]",
+               ap_cache->scratch, strerror (errno));
+      return OMX_ErrorUndefined;
+    }
+
+  if ((p_item = find_cache_item (ap_cache, ap_dl_path, ap_dl_name))
+      && cache_item_matches (p_item, &st))
+    {
+      p_item->in_use = true;
+      return p_item->p_comp_name ? add_cached_to_comp_registry (p_item)
+                                 : OMX_ErrorNone;
+    }
+
+  /* This is a new or modified library; probe it */
+  rc = cache_comp_info (ap_dl_path, ap_dl_name, &p_reg_item);
+
+  if (OMX_ErrorNone == rc && p_reg_item)
+    {
+      add_cache_item (ap_cache, ap_dl_path, ap_dl_name, &st, p_reg_item);
+    }
+  else if (OMX_ErrorNone != rc && OMX_ErrorInsufficientResources != rc
+           && NULL == p_reg_item)
+    {
+      /* Not a usable component; remember that too, so that the library is
+         not loaded again until it changes. Libraries providing a component
+         that is already registered are not cached. */
+      add_cache_item (ap_cache, ap_dl_path, ap_dl_name, &st, NULL);
+    }
+
+  return rc;
+}
+
 static OMX_ERRORTYPE
 scan_component_folders (void)
 {
@@ -775,6 +1365,8 @@ scan_component_folders (void)
   char ** pp_paths;
   unsigned long npaths = 0;
   struct dirent * p_dir_entry = NULL;
+  tiz_core_cache_t * p_cache = NULL;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
 
   if (NULL == (pp_paths = find_component_paths (&npaths)))
     {
@@ -782,7 +1374,9 @@ scan_component_folders (void)
       return OMX_ErrorInsufficientResources;
     }
 
-  for (i = 0; i < (int) npaths; i++)
+  p_cache = load_cache ();
+
+  for (i = 0; i < (int) npaths && OMX_ErrorInsufficientResources != rc; i++)
     {
       TIZ_LOG (TIZ_PRIORITY_TRACE, "Looking for component plugins : %s",
                pp_paths[i]);
@@ -796,7 +1390,8 @@ scan_component_folders (void)
         }
       else
         {
-          while ((p_dir_entry = readdir (p_dir)))
+          while (OMX_ErrorInsufficientResources != rc
+                 && (p_dir_entry = readdir (p_dir)))
             {
               if (p_dir_entry->d_name[0] != '.'
                   && p_dir_entry->d_name[strlen (p_dir_entry->d_name) - 1]
@@ -805,13 +1400,8 @@ scan_component_folders (void)
                   TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s]", p_dir_entry->d_name);
                   if (p_dir_entry->d_type == DT_REG)
                     {
-                      if (OMX_ErrorInsufficientResources
-                          == cache_comp_info (pp_paths[i], p_dir_entry->d_name))
-                        {
-                          (void) closedir (p_dir);
-                          free_paths (pp_paths, npaths);
-                          return OMX_ErrorInsufficientResources;
-                        }
+                      rc = register_comp_lib (p_cache, pp_paths[i],
+                                              p_dir_entry->d_name);
                     }
                 }
             } /* while */
@@ -822,7 +1412,16 @@ scan_component_folders (void)
 
   free_paths (pp_paths, npaths);
 
-  return OMX_ErrorNone;
+  if (p_cache)
+    {
+      if (OMX_ErrorInsufficientResources != rc)
+        {
+          save_cache (p_cache);
+        }
+      free_cache (p_cache);
+    }
+
+  return OMX_ErrorInsufficientResources == rc ? rc : OMX_ErrorNone;
 }
 
 static tiz_core_registry_item_t *
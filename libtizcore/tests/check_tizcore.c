@@ -40,6 +40,8 @@
 #include <sys/types.h>
 #include <signal.h>
 #include <limits.h>
+#include <string.h>
+#include <time.h>
 
 #include <tizplatform.h>
 
@@ -54,6 +56,8 @@
 #define TIZ_CORE_TEST_COMPONENT_ROLE "default"
 #define AUDIO_RENDERER "OMX.Aratelia.audio_renderer.alsa.pcm"
 #define FILE_READER "OMX.Aratelia.file_reader.binary"
+#define REGISTRY_CACHE_MAGIC "TIZCOREREG1"
+#define REGISTRY_BENCH_ITERATIONS 20
 
 char *pg_rmd_path;
 pid_t g_rmd_pid;
@@ -284,7 +288,140 @@ START_TEST (test_ilcore_role_of_comp_enum)
   fail_if (error != OMX_ErrorNone);
 }
 
-END_TEST Suite * tizcore_suite (void)
+END_TEST
+
+static double
+elapsed_ms (const struct timespec * ap_start)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - ap_start->tv_sec) * 1e3
+         + (now.tv_nsec - ap_start->tv_nsec) / 1e6;
+}
+
+static char *
+get_registry_cache_file (void)
+{
+  /* NOTE: The value returned by tiz_rcfile_get_value does not outlive the
+     next lookup; keep a copy */
+  const char * p_value
+    = tiz_rcfile_get_value ("il-core", "registry-cache.file");
+  fail_if (NULL == p_value);
+  return strndup (p_value, PATH_MAX);
+}
+
+static bool
+registry_cache_is_valid (const char * ap_cache_file)
+{
+  char line[64];
+  bool rv = false;
+  FILE * p_file = fopen (ap_cache_file, "r");
+
+  if (p_file)
+    {
+      rv = (NULL != fgets (line, sizeof (line), p_file)
+            && 0 == strcmp (line, REGISTRY_CACHE_MAGIC "\n"));
+      fclose (p_file);
+    }
+  return rv;
+}
+
+static void
+get_and_free_test_component (void)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  OMX_HANDLETYPE p_hdl = NULL;
+  OMX_U32 appData;
+  OMX_CALLBACKTYPE callBacks;
+  OMX_S8 role[OMX_MAX_STRINGNAME_SIZE];
+
+  error = OMX_RoleOfComponentEnum ((OMX_STRING) role,
+                                   TIZ_CORE_TEST_COMPONENT_NAME, 0);
+  fail_if (error != OMX_ErrorNone);
+  fail_if (0 != strcmp ((const char *) role, TIZ_CORE_TEST_COMPONENT_ROLE));
+
+  error = OMX_GetHandle (&p_hdl, TIZ_CORE_TEST_COMPONENT_NAME,
+                         (OMX_PTR *) (&appData), &callBacks);
+  fail_if (error != OMX_ErrorNone);
+
+  error = OMX_FreeHandle (p_hdl);
+  fail_if (error != OMX_ErrorNone);
+}
+
+START_TEST (test_ilcore_registry_cache)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  char * p_cache_file = get_registry_cache_file ();
+  FILE * p_file = NULL;
+
+  /* An invalid cache is discarded, and rebuilt */
+  p_file = fopen (p_cache_file, "w");
+  fail_if (NULL == p_file);
+  fputs ("garbage\n", p_file);
+  fclose (p_file);
+
+  error = OMX_Init ();
+  fail_if (error != OMX_ErrorNone);
+  get_and_free_test_component ();
+  error = OMX_Deinit ();
+  fail_if (error != OMX_ErrorNone);
+
+  fail_if (!registry_cache_is_valid (p_cache_file));
+
+  /* Now the registry comes from the cache; the component library is only
+     loaded when the component is instantiated */
+  error = OMX_Init ();
+  fail_if (error != OMX_ErrorNone);
+  get_and_free_test_component ();
+  error = OMX_Deinit ();
+  fail_if (error != OMX_ErrorNone);
+
+  free (p_cache_file);
+}
+END_TEST
+
+START_TEST (test_ilcore_init_benchmark)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  char * p_cache_file = get_registry_cache_file ();
+  struct timespec start;
+  double cold_ms = 0;
+  double warm_ms = 0;
+  int i = 0;
+
+  /* Cold start: every component library is loaded and probed */
+  unlink (p_cache_file);
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  error = OMX_Init ();
+  cold_ms = elapsed_ms (&start);
+  fail_if (error != OMX_ErrorNone);
+  error = OMX_Deinit ();
+  fail_if (error != OMX_ErrorNone);
+
+  fail_if (!registry_cache_is_valid (p_cache_file));
+
+  /* Warm starts: libraries are only stat'ed */
+  for (i = 0; i < REGISTRY_BENCH_ITERATIONS; ++i)
+    {
+      clock_gettime (CLOCK_MONOTONIC, &start);
+      error = OMX_Init ();
+      warm_ms += elapsed_ms (&start);
+      fail_if (error != OMX_ErrorNone);
+      error = OMX_Deinit ();
+      fail_if (error != OMX_ErrorNone);
+    }
+  warm_ms /= REGISTRY_BENCH_ITERATIONS;
+
+  fprintf (stderr,
+           "OMX_Init benchmark: cold (no registry cache) %.3f ms, "
+           "warm %.3f ms (average of %d)\n",
+           cold_ms, warm_ms, REGISTRY_BENCH_ITERATIONS);
+
+  free (p_cache_file);
+}
+END_TEST
+
+Suite * tizcore_suite (void)
 {
   TCase *tc_ilcore;
   Suite *s = suite_create ("libtizcore");
@@ -302,6 +439,8 @@ END_TEST Suite * tizcore_suite (void)
   /*   tcase_add_test (tc_ilcore, test_ilcore_setup_tunnel_tear_down_tunnel); */
   tcase_add_test (tc_ilcore, test_ilcore_comp_of_role_enum);
   tcase_add_test (tc_ilcore, test_ilcore_role_of_comp_enum);
+  tcase_add_test (tc_ilcore, test_ilcore_registry_cache);
+  tcase_add_test (tc_ilcore, test_ilcore_init_benchmark);
 
   /* TODO: Negative case for OMX_ErrorPortsNotConnected error */
 
@@ -127,12 +127,16 @@ init_ports_and_lists (void * ap_obj)
   tiz_check_omx_ret_oom (
     tiz_vector_init (&(p_obj->p_ports_), sizeof (OMX_PTR)));
   tiz_check_omx_ret_oom (
-    tiz_vector_init (&(p_obj->p_ingress_), sizeof (tiz_vector_t *)));
+    tiz_vector_init (&(p_obj->p_ingress_), sizeof (tiz_krn_hdrlst_t *)));
   tiz_check_omx_ret_oom (
-    tiz_vector_init (&(p_obj->p_egress_), sizeof (tiz_vector_t *)));
+    tiz_vector_init (&(p_obj->p_egress_), sizeof (tiz_krn_hdrlst_t *)));
+  tiz_check_null_ret_oom ((p_obj->p_idx_tbl_ = tiz_mem_calloc (
+                             IDX_TBL_MIN_CAPACITY, sizeof (tiz_krn_idx_slot_t))));
 
   p_obj->p_cport_ = NULL;
   p_obj->p_proc_ = NULL;
+  p_obj->idx_tbl_cap_ = IDX_TBL_MIN_CAPACITY;
+  p_obj->idx_tbl_len_ = 0;
   p_obj->eos_ = false;
   p_obj->rm_ = 0;
   p_obj->rm_cbacks_.pf_waitend = &wait_complete;
@@ -156,7 +160,7 @@ deinit_ports_and_lists (void * ap_obj)
 {
   tiz_krn_t * p_obj = ap_obj;
   OMX_PTR * pp_port = NULL;
-  tiz_vector_t * p_list = NULL;
+  tiz_krn_hdrlst_t * p_list = NULL;
 
   /* delete the config port */
   factory_delete (p_obj->p_cport_);
@@ -173,12 +177,17 @@ deinit_ports_and_lists (void * ap_obj)
   tiz_vector_destroy (p_obj->p_ports_);
   p_obj->p_ports_ = NULL;
 
+  /* delete the index lookup table */
+  tiz_mem_free (p_obj->p_idx_tbl_);
+  p_obj->p_idx_tbl_ = NULL;
+  p_obj->idx_tbl_cap_ = 0;
+  p_obj->idx_tbl_len_ = 0;
+
   /* delete the ingress and egress lists */
   while (tiz_vector_length (p_obj->p_ingress_) > 0)
     {
-      p_list = *(tiz_vector_t **) tiz_vector_back (p_obj->p_ingress_);
-      tiz_vector_clear (p_list);
-      tiz_vector_destroy (p_list);
+      p_list = *(tiz_krn_hdrlst_t **) tiz_vector_back (p_obj->p_ingress_);
+      hdrlst_destroy (p_list);
       tiz_vector_pop_back (p_obj->p_ingress_);
     }
   tiz_vector_destroy (p_obj->p_ingress_);
@@ -186,9 +195,8 @@ deinit_ports_and_lists (void * ap_obj)
 
   while (tiz_vector_length (p_obj->p_egress_) > 0)
     {
-      p_list = *(tiz_vector_t **) tiz_vector_back (p_obj->p_egress_);
-      tiz_vector_clear (p_list);
-      tiz_vector_destroy (p_list);
+      p_list = *(tiz_krn_hdrlst_t **) tiz_vector_back (p_obj->p_egress_);
+      hdrlst_destroy (p_list);
       tiz_vector_pop_back (p_obj->p_egress_);
     }
   tiz_vector_destroy (p_obj->p_egress_);
@@ -1288,19 +1296,18 @@ krn_register_port (void * ap_obj, OMX_PTR ap_port, const bool ais_config)
       assert (NULL == p_obj->p_cport_);
       p_obj->p_cport_ = ap_port;
       tiz_port_set_index (ap_port, TIZ_PORT_CONFIG_PORT_INDEX);
+      idx_tbl_add_port (p_obj, ap_port, TIZ_PORT_CONFIG_PORT_INDEX);
       return OMX_ErrorNone;
     }
 
   {
     /* Create the corresponding ingress and egress lists */
-    tiz_vector_t * p_in_list = NULL;
-    tiz_vector_t * p_out_list = NULL;
+    tiz_krn_hdrlst_t * p_in_list = NULL;
+    tiz_krn_hdrlst_t * p_out_list = NULL;
     OMX_U32 pid = 0;
-    tiz_check_omx (
-      tiz_vector_init (&(p_in_list), sizeof (OMX_BUFFERHEADERTYPE *)));
+    tiz_check_omx (hdrlst_init (&(p_in_list)));
     assert (p_in_list);
-    tiz_check_omx (
-      tiz_vector_init (&(p_out_list), sizeof (OMX_BUFFERHEADERTYPE *)));
+    tiz_check_omx (hdrlst_init (&(p_out_list)));
     assert (p_out_list);
     tiz_check_omx (tiz_vector_push_back (p_obj->p_ingress_, &p_in_list));
     tiz_check_omx (tiz_vector_push_back (p_obj->p_egress_, &p_out_list));
@@ -1361,7 +1368,9 @@ krn_register_port (void * ap_obj, OMX_PTR ap_port, const bool ais_config)
                p_obj->audio_init_.nPorts, p_obj->video_init_.nPorts,
                p_obj->image_init_.nPorts, p_obj->other_init_.nPorts);
     /* TODO Assert that this port is not repeated in the array */
-    return tiz_vector_push_back (p_obj->p_ports_, &ap_port);
+    tiz_check_omx (tiz_vector_push_back (p_obj->p_ports_, &ap_port));
+    idx_tbl_add_port (p_obj, ap_port, pid);
+    return OMX_ErrorNone;
   }
 }
 
@@ -1420,7 +1429,24 @@ krn_find_managing_port (const tiz_krn_t * ap_krn, const OMX_INDEXTYPE a_index,
   assert (app_port);
   assert (ap_struct);
 
-  if (OMX_ErrorNone == tiz_port_find_index (ap_krn->p_cport_, a_index))
+  if (ap_krn->p_idx_tbl_)
+    {
+      const tiz_krn_idx_slot_t * p_slot = idx_tbl_lookup (ap_krn, a_index);
+      if (p_slot && p_slot->in_cport)
+        {
+          *app_port = ap_krn->p_cport_;
+          TIZ_TRACE (handleOf (ap_krn),
+                     "[%s] : Config port being searched. "
+                     "Returning...",
+                     tiz_idx_to_str (a_index));
+          return OMX_ErrorNone;
+        }
+      if (p_slot && p_slot->nports > 0)
+        {
+          rc = OMX_ErrorNone;
+        }
+    }
+  else if (OMX_ErrorNone == tiz_port_find_index (ap_krn->p_cport_, a_index))
     {
       *app_port = ap_krn->p_cport_;
       TIZ_TRACE (handleOf (ap_krn),
@@ -1442,27 +1468,26 @@ krn_find_managing_port (const tiz_krn_t * ap_krn, const OMX_INDEXTYPE a_index,
               break;
             }
         }
+    }
 
-      if (OMX_ErrorNone == rc)
-        {
-          /* Now we retrieve the port index from the struct. */
-          /* TODO: This is not the best way to do this */
-          p_port_index = (OMX_U32 *) ap_struct
-                         + sizeof (OMX_U32) / sizeof (OMX_U32)
-                         + sizeof (OMX_VERSIONTYPE) / sizeof (OMX_U32);
-
-          if (OMX_ErrorNone != (rc = check_pid (ap_krn, *p_port_index)))
-            {
-              return rc;
-            }
-
-          TIZ_TRACE (handleOf (ap_krn), "[%s] : Found in port index [%d]...",
-                     tiz_idx_to_str (a_index), *p_port_index);
+  if (OMX_ErrorNone == rc)
+    {
+      /* Now we retrieve the port index from the struct. */
+      /* TODO: This is not the best way to do this */
+      p_port_index = (OMX_U32 *) ap_struct
+                     + sizeof (OMX_U32) / sizeof (OMX_U32)
+                     + sizeof (OMX_VERSIONTYPE) / sizeof (OMX_U32);
 
-          pp_port = tiz_vector_at (ap_krn->p_ports_, *p_port_index);
-          *app_port = *pp_port;
+      if (OMX_ErrorNone != (rc = check_pid (ap_krn, *p_port_index)))
+        {
           return rc;
         }
+
+      TIZ_TRACE (handleOf (ap_krn), "[%s] : Found in port index [%d]...",
+                 tiz_idx_to_str (a_index), *p_port_index);
+
+      *app_port = get_port (ap_krn, *p_port_index);
+      return rc;
     }
 
   TIZ_TRACE (handleOf (ap_krn), "[%s] : Could not find the managing port...",
@@ -1589,7 +1614,7 @@ krn_select (const void * ap_obj, const OMX_U32 a_nports, tiz_pd_set_t * ap_set)
   const tiz_krn_t * p_obj = ap_obj;
   OMX_S32 i = 0;
   OMX_S32 nports = 0;
-  tiz_vector_t * p_list = NULL;
+  tiz_krn_hdrlst_t * p_list = NULL;
 
   assert (ap_obj);
   assert (ap_set);
@@ -1605,7 +1630,7 @@ krn_select (const void * ap_obj, const OMX_U32 a_nports, tiz_pd_set_t * ap_set)
   for (i = 0; i < nports; ++i)
     {
       p_list = get_ingress_lst (p_obj, i);
-      if (tiz_vector_length (p_list) > 0)
+      if (hdrlst_length (p_list) > 0)
         {
           TIZ_PD_SET (i, ap_set);
         }
@@ -1639,7 +1664,7 @@ krn_claim_buffer (const void * ap_obj, const OMX_U32 a_pid, const OMX_U32 a_pos,
   tiz_krn_t * p_obj = (tiz_krn_t *) ap_obj;
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   OMX_BUFFERHEADERTYPE * p_hdr = NULL;
-  tiz_vector_t * p_list = NULL;
+  tiz_krn_hdrlst_t * p_list = NULL;
   OMX_PTR p_port = NULL;
 
   assert (ap_obj);
@@ -1665,10 +1690,10 @@ krn_claim_buffer (const void * ap_obj, const OMX_U32 a_pid, const OMX_U32 a_pos,
   p_list = get_ingress_lst (p_obj, a_pid);
 
   /* Ingress list's size shall not be larger than the port's buffer count */
-  assert (tiz_vector_length (p_list) <= tiz_port_buffer_count (p_port));
+  assert (hdrlst_length (p_list) <= tiz_port_buffer_count (p_port));
 
   /* Only try to retrieve the buffer if that position exists in the list */
-  if (a_pos < tiz_vector_length (p_list))
+  if (a_pos < hdrlst_length (p_list))
     {
       OMX_DIRTYPE pdir = OMX_DirMax;
 
@@ -1679,7 +1704,7 @@ krn_claim_buffer (const void * ap_obj, const OMX_U32 a_pid, const OMX_U32 a_pos,
       TIZ_TRACE (handleOf (p_obj),
                  "port's [%d] HEADER [%p] BUFFER [%p] ingress "
                  "list length [%d]...",
-                 a_pid, p_hdr, p_hdr->pBuffer, tiz_vector_length (p_list));
+                 a_pid, p_hdr, p_hdr->pBuffer, hdrlst_length (p_list));
 
       pdir = tiz_port_dir (p_port);
 
@@ -1700,7 +1725,7 @@ krn_claim_buffer (const void * ap_obj, const OMX_U32 a_pid, const OMX_U32 a_pos,
         }
 
       /* ... and delete it from the list */
-      tiz_vector_erase (p_list, a_pos, 1);
+      hdrlst_erase (p_list, a_pos);
 
       /* Now increment by one the claimed buffers count on this port */
       (void) TIZ_PORT_INC_CLAIMED_COUNT (p_port);
@@ -1763,7 +1788,7 @@ krn_release_buffer (const void * ap_obj, const OMX_U32 a_pid,
                     OMX_BUFFERHEADERTYPE * ap_hdr)
 {
   tiz_krn_t * p_obj = (tiz_krn_t *) ap_obj;
-  tiz_vector_t * p_list = NULL;
+  tiz_krn_hdrlst_t * p_list = NULL;
   OMX_PTR p_port = NULL;
 
   assert (ap_obj);
@@ -1786,9 +1811,9 @@ krn_release_buffer (const void * ap_obj, const OMX_U32 a_pid,
   p_list = get_egress_lst (p_obj, a_pid);
 
   TIZ_TRACE (handleOf (p_obj), "HEADER [%p] pid [%d] egress length [%d]...",
-             ap_hdr, a_pid, tiz_vector_length (p_list));
+             ap_hdr, a_pid, hdrlst_length (p_list));
 
-  assert (tiz_vector_length (p_list) < tiz_port_buffer_count (p_port));
+  assert (hdrlst_length (p_list) < tiz_port_buffer_count (p_port));
 
   return enqueue_callback_msg (p_obj, ap_hdr, a_pid, tiz_port_dir (p_port));
 }
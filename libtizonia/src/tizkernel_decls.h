@@ -105,6 +105,30 @@ struct tiz_krn_msg_str
   OMX_STRING str;
 };
 
+/* Per-port FIFO of buffer headers. This is a circular array that grows on
+   demand, so that headers can be added at the back and claimed from the
+   front in constant time. */
+typedef struct tiz_krn_hdrlst tiz_krn_hdrlst_t;
+struct tiz_krn_hdrlst
+{
+  OMX_BUFFERHEADERTYPE ** pp_hdrs;
+  OMX_S32 head;
+  OMX_S32 len;
+  OMX_S32 cap; /* Always zero or a power of two */
+};
+
+/* Entry in the open-addressing table that maps an OMX index to the ports
+   that manage it: the number of regular ports that have registered the index,
+   and whether the config port has. */
+typedef struct tiz_krn_idx_slot tiz_krn_idx_slot_t;
+struct tiz_krn_idx_slot
+{
+  OMX_INDEXTYPE index;
+  OMX_U32 nports;
+  bool in_cport;
+  bool used;
+};
+
 typedef struct tiz_krn tiz_krn_t;
 struct tiz_krn
 {
@@ -115,6 +139,9 @@ struct tiz_krn
   tiz_vector_t * p_egress_;
   OMX_PTR p_cport_;
   OMX_PTR p_proc_;
+  tiz_krn_idx_slot_t * p_idx_tbl_;
+  OMX_U32 idx_tbl_cap_; /* Zero or a power of two */
+  OMX_U32 idx_tbl_len_;
   bool eos_;
   tiz_rm_t rm_;
   tiz_rm_proxy_callbacks_t rm_cbacks_;
@@ -94,26 +94,309 @@ static void preemption_complete (OMX_U32 rid, OMX_PTR ap_data)
   deliver_pluggable_event (rid, ap_data);
 }
 
-static inline tiz_vector_t *get_ingress_lst (const tiz_krn_t *ap_obj,
-                                             OMX_U32 a_pid)
+#define HDRLST_MIN_CAPACITY 8
+
+static inline OMX_ERRORTYPE hdrlst_init (tiz_krn_hdrlst_t **app_lst)
+{
+  tiz_krn_hdrlst_t *p_lst = NULL;
+  assert (app_lst);
+  p_lst = tiz_mem_calloc (1, sizeof (tiz_krn_hdrlst_t));
+  *app_lst = p_lst;
+  return p_lst ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
+}
+
+static inline void hdrlst_destroy (tiz_krn_hdrlst_t *ap_lst)
+{
+  if (ap_lst)
+    {
+      tiz_mem_free (ap_lst->pp_hdrs);
+      tiz_mem_free (ap_lst);
+    }
+}
+
+static inline OMX_S32 hdrlst_length (const tiz_krn_hdrlst_t *ap_lst)
+{
+  assert (ap_lst);
+  return ap_lst->len;
+}
+
+static inline OMX_BUFFERHEADERTYPE **hdrlst_slot (const tiz_krn_hdrlst_t *ap_lst,
+                                                  const OMX_S32 a_index)
+{
+  return &(ap_lst->pp_hdrs[(ap_lst->head + a_index) & (ap_lst->cap - 1)]);
+}
+
+static inline void hdrlst_clear (tiz_krn_hdrlst_t *ap_lst)
+{
+  assert (ap_lst);
+  ap_lst->head = 0;
+  ap_lst->len = 0;
+}
+
+static OMX_ERRORTYPE hdrlst_reserve (tiz_krn_hdrlst_t *ap_lst,
+                                     const OMX_S32 a_count)
+{
+  OMX_BUFFERHEADERTYPE **pp_hdrs = NULL;
+  OMX_S32 cap = MAX (ap_lst->cap, HDRLST_MIN_CAPACITY);
+  OMX_S32 i = 0;
+
+  assert (ap_lst);
+
+  if (a_count <= ap_lst->cap)
+    {
+      return OMX_ErrorNone;
+    }
+
+  while (cap < a_count)
+    {
+      cap *= 2;
+    }
+
+  if (!(pp_hdrs = tiz_mem_alloc (cap * sizeof (OMX_BUFFERHEADERTYPE *))))
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+
+  /* Unwrap the current contents into the new array */
+  for (i = 0; i < ap_lst->len; ++i)
+    {
+      pp_hdrs[i] = *hdrlst_slot (ap_lst, i);
+    }
+
+  tiz_mem_free (ap_lst->pp_hdrs);
+  ap_lst->pp_hdrs = pp_hdrs;
+  ap_lst->head = 0;
+  ap_lst->cap = cap;
+  return OMX_ErrorNone;
+}
+
+static inline OMX_ERRORTYPE hdrlst_push_back (tiz_krn_hdrlst_t *ap_lst,
+                                              OMX_BUFFERHEADERTYPE *ap_hdr)
+{
+  assert (ap_lst);
+  if (ap_lst->len == ap_lst->cap)
+    {
+      tiz_check_omx (hdrlst_reserve (ap_lst, ap_lst->len + 1));
+    }
+  *hdrlst_slot (ap_lst, ap_lst->len) = ap_hdr;
+  ap_lst->len++;
+  return OMX_ErrorNone;
+}
+
+static inline void hdrlst_erase (tiz_krn_hdrlst_t *ap_lst, const OMX_S32 a_pos)
+{
+  OMX_S32 i = 0;
+
+  assert (ap_lst);
+  assert (a_pos >= 0 && a_pos < ap_lst->len);
+
+  /* Close the gap from whichever end is nearer; erasing from the front, which
+     is the common case, is just a matter of moving the head */
+  if (a_pos < ap_lst->len / 2)
+    {
+      for (i = a_pos; i > 0; --i)
+        {
+          *hdrlst_slot (ap_lst, i) = *hdrlst_slot (ap_lst, i - 1);
+        }
+      ap_lst->head = (ap_lst->head + 1) & (ap_lst->cap - 1);
+    }
+  else
+    {
+      for (i = a_pos; i < ap_lst->len - 1; ++i)
+        {
+          *hdrlst_slot (ap_lst, i) = *hdrlst_slot (ap_lst, i + 1);
+        }
+    }
+
+  if (0 == --ap_lst->len)
+    {
+      ap_lst->head = 0;
+    }
+}
+
+static OMX_ERRORTYPE hdrlst_append (tiz_krn_hdrlst_t *ap_dst,
+                                    const tiz_krn_hdrlst_t *ap_src)
+{
+  OMX_S32 i = 0;
+  assert (ap_dst);
+  assert (ap_src);
+  tiz_check_omx (hdrlst_reserve (ap_dst, ap_dst->len + ap_src->len));
+  for (i = 0; i < ap_src->len; ++i)
+    {
+      (void)hdrlst_push_back (ap_dst, *hdrlst_slot (ap_src, i));
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE hdrlst_append_vector (tiz_krn_hdrlst_t *ap_dst,
+                                           const tiz_vector_t *ap_src)
+{
+  const OMX_S32 nhdrs = tiz_vector_length (ap_src);
+  OMX_S32 i = 0;
+  assert (ap_dst);
+  assert (ap_src);
+  tiz_check_omx (hdrlst_reserve (ap_dst, ap_dst->len + nhdrs));
+  for (i = 0; i < nhdrs; ++i)
+    {
+      OMX_BUFFERHEADERTYPE **pp_hdr = tiz_vector_at (ap_src, i);
+      assert (pp_hdr && *pp_hdr);
+      (void)hdrlst_push_back (ap_dst, *pp_hdr);
+    }
+  return OMX_ErrorNone;
+}
+
+static inline tiz_krn_hdrlst_t *get_hdrlst (const tiz_vector_t *ap_lists,
+                                            OMX_U32 a_pid)
+{
+  tiz_krn_hdrlst_t **pp_list = NULL;
+  assert (ap_lists);
+  assert (tiz_vector_length (ap_lists) >= a_pid);
+  pp_list = tiz_vector_at (ap_lists, a_pid);
+  assert (pp_list && *pp_list);
+  return *pp_list;
+}
+
+static inline tiz_krn_hdrlst_t *get_ingress_lst (const tiz_krn_t *ap_obj,
+                                                 OMX_U32 a_pid)
 {
-  tiz_vector_t *p_list = NULL;
   assert (ap_obj);
   /* Grab the port's ingress list */
-  p_list = tiz_vector_at (ap_obj->p_ingress_, a_pid);
-  assert (p_list && *(tiz_vector_t **)p_list);
-  return (*(tiz_vector_t **)p_list);
+  return get_hdrlst (ap_obj->p_ingress_, a_pid);
 }
 
-static inline tiz_vector_t *get_egress_lst (const tiz_krn_t *ap_obj,
-                                            OMX_U32 a_pid)
+static inline tiz_krn_hdrlst_t *get_egress_lst (const tiz_krn_t *ap_obj,
+                                                OMX_U32 a_pid)
 {
-  tiz_vector_t *p_list = NULL;
   assert (ap_obj);
   /* Grab the port's egress list */
-  p_list = tiz_vector_at (ap_obj->p_egress_, a_pid);
-  assert (p_list && *(tiz_vector_t **)p_list);
-  return (*(tiz_vector_t **)p_list);
+  return get_hdrlst (ap_obj->p_egress_, a_pid);
+}
+
+#define IDX_TBL_MIN_CAPACITY 64
+
+static inline OMX_U32 idx_tbl_hash (const OMX_INDEXTYPE a_index,
+                                    const OMX_U32 a_cap)
+{
+  return ((OMX_U32)a_index * 2654435761u) & (a_cap - 1);
+}
+
+static inline tiz_krn_idx_slot_t *idx_tbl_lookup (const tiz_krn_t *ap_obj,
+                                                  const OMX_INDEXTYPE a_index)
+{
+  OMX_U32 i = 0;
+  assert (ap_obj);
+  assert (ap_obj->p_idx_tbl_);
+  i = idx_tbl_hash (a_index, ap_obj->idx_tbl_cap_);
+  while (ap_obj->p_idx_tbl_[i].used)
+    {
+      if (a_index == ap_obj->p_idx_tbl_[i].index)
+        {
+          return &(ap_obj->p_idx_tbl_[i]);
+        }
+      i = (i + 1) & (ap_obj->idx_tbl_cap_ - 1);
+    }
+  return NULL;
+}
+
+static tiz_krn_idx_slot_t *idx_tbl_insert (tiz_krn_idx_slot_t *ap_tbl,
+                                           const OMX_U32 a_cap,
+                                           const OMX_INDEXTYPE a_index)
+{
+  OMX_U32 i = idx_tbl_hash (a_index, a_cap);
+  while (ap_tbl[i].used && a_index != ap_tbl[i].index)
+    {
+      i = (i + 1) & (a_cap - 1);
+    }
+  ap_tbl[i].index = a_index;
+  ap_tbl[i].used = true;
+  return &(ap_tbl[i]);
+}
+
+static OMX_ERRORTYPE idx_tbl_reserve (tiz_krn_t *ap_obj, const OMX_U32 a_len)
+{
+  tiz_krn_idx_slot_t *p_tbl = NULL;
+  OMX_U32 cap = ap_obj->idx_tbl_cap_;
+  OMX_U32 i = 0;
+
+  assert (ap_obj->p_idx_tbl_);
+  assert (cap >= IDX_TBL_MIN_CAPACITY);
+
+  /* Keep the load factor under 1/2 */
+  while (cap < 2 * a_len)
+    {
+      cap *= 2;
+    }
+
+  if (cap == ap_obj->idx_tbl_cap_)
+    {
+      return OMX_ErrorNone;
+    }
+
+  tiz_check_null_ret_oom (
+    (p_tbl = tiz_mem_calloc (cap, sizeof (tiz_krn_idx_slot_t))));
+
+  for (i = 0; i < ap_obj->idx_tbl_cap_; ++i)
+    {
+      if (ap_obj->p_idx_tbl_[i].used)
+        {
+          *idx_tbl_insert (p_tbl, cap, ap_obj->p_idx_tbl_[i].index)
+            = ap_obj->p_idx_tbl_[i];
+        }
+    }
+
+  tiz_mem_free (ap_obj->p_idx_tbl_);
+  ap_obj->p_idx_tbl_ = p_tbl;
+  ap_obj->idx_tbl_cap_ = cap;
+  return OMX_ErrorNone;
+}
+
+/* Record the indexes that a port manages. This happens at port registration
+   time; ports register their indexes from their constructors. If memory
+   runs out, the table is dropped (p_idx_tbl_ becomes NULL) and
+   find_managing_port falls back to searching the ports one by one. */
+static void idx_tbl_add_port (tiz_krn_t *ap_obj, const OMX_PTR ap_port,
+                              const OMX_U32 a_pid)
+{
+  const OMX_U32 nindexes = tiz_port_index_count (ap_port);
+  OMX_U32 i = 0;
+
+  assert (ap_obj);
+  assert (ap_port);
+
+  if (!ap_obj->p_idx_tbl_)
+    {
+      return;
+    }
+
+  if (OMX_ErrorNone
+      != idx_tbl_reserve (ap_obj, ap_obj->idx_tbl_len_ + nindexes))
+    {
+      tiz_mem_free (ap_obj->p_idx_tbl_);
+      ap_obj->p_idx_tbl_ = NULL;
+      ap_obj->idx_tbl_cap_ = 0;
+      return;
+    }
+
+  for (i = 0; i < nindexes; ++i)
+    {
+      const OMX_INDEXTYPE index = tiz_port_index_at (ap_port, i);
+      tiz_krn_idx_slot_t *p_slot = idx_tbl_lookup (ap_obj, index);
+      if (!p_slot)
+        {
+          p_slot = idx_tbl_insert (ap_obj->p_idx_tbl_, ap_obj->idx_tbl_cap_,
+                                   index);
+          ap_obj->idx_tbl_len_++;
+        }
+
+      if (TIZ_PORT_CONFIG_PORT_INDEX == a_pid)
+        {
+          p_slot->in_cport = true;
+        }
+      else
+        {
+          p_slot->nports++;
+        }
+    }
 }
 
 static inline OMX_PTR get_port (const tiz_krn_t *ap_obj, const OMX_U32 a_pid)
@@ -126,71 +409,63 @@ static inline OMX_PTR get_port (const tiz_krn_t *ap_obj, const OMX_U32 a_pid)
   return *pp_port;
 }
 
-static inline OMX_BUFFERHEADERTYPE *get_header (const tiz_vector_t *ap_list,
+static inline OMX_BUFFERHEADERTYPE *get_header (const tiz_krn_hdrlst_t *ap_list,
                                                 OMX_U32 a_index)
 {
-  OMX_BUFFERHEADERTYPE **pp_hdr = NULL;
+  OMX_BUFFERHEADERTYPE *p_hdr = NULL;
   assert (ap_list);
-  assert (a_index < tiz_vector_length (ap_list));
+  assert (a_index < hdrlst_length (ap_list));
   /* Retrieve the header... */
-  pp_hdr = tiz_vector_at (ap_list, a_index);
-  assert (pp_hdr && *pp_hdr);
-  return *pp_hdr;
+  p_hdr = *hdrlst_slot (ap_list, a_index);
+  assert (p_hdr);
+  return p_hdr;
 }
 
 static OMX_S32 move_to_ingress (void *ap_obj, OMX_U32 a_pid)
 {
 
   tiz_krn_t *p_obj = ap_obj;
-  tiz_vector_t *p_elist = NULL;
-  tiz_vector_t *p_ilist = NULL;
+  tiz_krn_hdrlst_t *p_elist = NULL;
+  tiz_krn_hdrlst_t *p_ilist = NULL;
   const OMX_S32 nports = tiz_vector_length (p_obj->p_ports_);
   OMX_ERRORTYPE rc = OMX_ErrorNone;
 
   assert (a_pid < nports);
 
-  p_elist = tiz_vector_at (p_obj->p_egress_, a_pid);
-  p_ilist = tiz_vector_at (p_obj->p_ingress_, a_pid);
-  assert (p_elist && *(tiz_vector_t **)p_elist);
-  p_elist = *(tiz_vector_t **)p_elist;
-  assert (p_ilist && *(tiz_vector_t **)p_elist);
-  p_ilist = *(tiz_vector_t **)p_ilist;
-  rc = tiz_vector_append (p_ilist, p_elist);
-  tiz_vector_clear (p_elist);
+  p_elist = get_egress_lst (p_obj, a_pid);
+  p_ilist = get_ingress_lst (p_obj, a_pid);
+  rc = hdrlst_append (p_ilist, p_elist);
+  hdrlst_clear (p_elist);
 
   if (OMX_ErrorNone != rc)
     {
       return -1;
     }
 
-  return tiz_vector_length (p_ilist);
+  return hdrlst_length (p_ilist);
 }
 
 static OMX_S32 move_to_egress (void *ap_obj, OMX_U32 a_pid)
 {
   tiz_krn_t *p_obj = ap_obj;
   const OMX_S32 nports = tiz_vector_length (p_obj->p_ports_);
-  tiz_vector_t *p_elist = NULL;
-  tiz_vector_t *p_ilist = NULL;
+  tiz_krn_hdrlst_t *p_elist = NULL;
+  tiz_krn_hdrlst_t *p_ilist = NULL;
   OMX_ERRORTYPE rc = OMX_ErrorNone;
 
   assert (a_pid < nports);
 
-  p_elist = tiz_vector_at (p_obj->p_egress_, a_pid);
-  p_ilist = tiz_vector_at (p_obj->p_ingress_, a_pid);
-  assert (p_elist && *(tiz_vector_t **)p_elist);
-  p_elist = *(tiz_vector_t **)p_elist;
-  assert (p_ilist && *(tiz_vector_t **)p_ilist);
-  p_ilist = *(tiz_vector_t **)p_ilist;
-  rc = tiz_vector_append (p_elist, p_ilist);
-  tiz_vector_clear (p_ilist);
+  p_elist = get_egress_lst (p_obj, a_pid);
+  p_ilist = get_ingress_lst (p_obj, a_pid);
+  rc = hdrlst_append (p_elist, p_ilist);
+  hdrlst_clear (p_ilist);
 
   if (OMX_ErrorNone != rc)
     {
       return -1;
     }
 
-  return tiz_vector_length (p_elist);
+  return hdrlst_length (p_elist);
 }
 
 static OMX_S32 add_to_buflst (void *ap_obj, tiz_vector_t *ap_dst2darr,
@@ -198,51 +473,46 @@ static OMX_S32 add_to_buflst (void *ap_obj, tiz_vector_t *ap_dst2darr,
                               const void *ap_port)
 {
   const tiz_krn_t *p_obj = ap_obj;
-  tiz_vector_t *p_list = NULL;
+  tiz_krn_hdrlst_t *p_list = NULL;
   const OMX_U32 pid = tiz_port_index (ap_port);
 
   assert (ap_obj);
   assert (ap_dst2darr);
   assert (ap_hdr);
-  assert (tiz_vector_length (ap_dst2darr) >= pid);
 
-  p_list = tiz_vector_at (ap_dst2darr, pid);
-  assert (p_list && *(tiz_vector_t **)p_list);
-  p_list = *(tiz_vector_t **)p_list;
+  p_list = get_hdrlst (ap_dst2darr, pid);
 
   TIZ_TRACE (handleOf (p_obj),
              "HEADER [%p] BUFFER [%p] PID [%d] "
              "list size [%d] buf count [%d]",
-             ap_hdr, ap_hdr->pBuffer, pid, tiz_vector_length (p_list),
+             ap_hdr, ap_hdr->pBuffer, pid, hdrlst_length (p_list),
              tiz_port_buffer_count (ap_port));
 
-  assert (tiz_vector_length (p_list) < tiz_port_buffer_count (ap_port));
+  assert (hdrlst_length (p_list) < tiz_port_buffer_count (ap_port));
 
-  if (OMX_ErrorNone != tiz_vector_push_back (p_list, &ap_hdr))
+  if (OMX_ErrorNone
+      != hdrlst_push_back (p_list, (OMX_BUFFERHEADERTYPE *)ap_hdr))
     {
       return -1;
     }
   else
     {
-      assert (tiz_vector_length (p_list) <= tiz_port_buffer_count (ap_port));
-      return tiz_vector_length (p_list);
+      assert (hdrlst_length (p_list) <= tiz_port_buffer_count (ap_port));
+      return hdrlst_length (p_list);
     }
 }
 
 static OMX_S32 clear_hdr_contents (tiz_vector_t *ap_hdr_lst, OMX_U32 a_pid)
 {
-  tiz_vector_t *p_list = NULL;
+  tiz_krn_hdrlst_t *p_list = NULL;
   OMX_BUFFERHEADERTYPE *p_hdr = NULL;
   OMX_S32 i, hdr_count = 0;
 
   assert (ap_hdr_lst);
-  assert (tiz_vector_length (ap_hdr_lst) >= a_pid);
 
-  p_list = tiz_vector_at (ap_hdr_lst, a_pid);
-  assert (p_list && *(tiz_vector_t **)p_list);
-  p_list = *(tiz_vector_t **)p_list;
+  p_list = get_hdrlst (ap_hdr_lst, a_pid);
 
-  hdr_count = tiz_vector_length (p_list);
+  hdr_count = hdrlst_length (p_list);
   for (i = 0; i < hdr_count; ++i)
     {
       p_hdr = get_header (p_list, i);
@@ -256,25 +526,21 @@ static OMX_ERRORTYPE append_buflsts (tiz_vector_t *ap_dst2darr,
                                      const tiz_vector_t *ap_srclst,
                                      OMX_U32 a_pid)
 {
-  tiz_vector_t *p_list = NULL;
+  tiz_krn_hdrlst_t *p_list = NULL;
   assert (ap_dst2darr);
   assert (ap_srclst);
-  assert (tiz_vector_length (ap_dst2darr) >= a_pid);
 
-  p_list = tiz_vector_at (ap_dst2darr, a_pid);
-  assert (p_list && *(tiz_vector_t **)p_list);
-  p_list = *(tiz_vector_t **)p_list;
+  p_list = get_hdrlst (ap_dst2darr, a_pid);
 
   /* Make sure the list is empty, before appending anything */
-  tiz_vector_clear (p_list);
+  hdrlst_clear (p_list);
 
-  return tiz_vector_append (p_list, ap_srclst);
+  return hdrlst_append_vector (p_list, ap_srclst);
 }
 
 static void clear_hdr_lsts (void *ap_obj, const OMX_U32 a_pid)
 {
   tiz_krn_t *p_obj = ap_obj;
-  tiz_vector_t *p_list = NULL;
   OMX_S32 i = 0;
   OMX_U32 pid = 0;
   OMX_S32 nports = 0;
@@ -286,15 +552,8 @@ static void clear_hdr_lsts (void *ap_obj, const OMX_U32 a_pid)
     {
       pid = ((OMX_ALL != a_pid) ? a_pid : i);
 
-      p_list = tiz_vector_at (p_obj->p_ingress_, pid);
-      assert (p_list && *(tiz_vector_t **)p_list);
-      p_list = *(tiz_vector_t **)p_list;
-      tiz_vector_clear (p_list);
-
-      p_list = tiz_vector_at (p_obj->p_egress_, pid);
-      assert (p_list && *(tiz_vector_t **)p_list);
-      p_list = *(tiz_vector_t **)p_list;
-      tiz_vector_clear (p_list);
+      hdrlst_clear (get_ingress_lst (p_obj, pid));
+      hdrlst_clear (get_egress_lst (p_obj, pid));
 
       ++i;
     }
@@ -343,7 +602,7 @@ static OMX_ERRORTYPE propagate_ingress (void *ap_obj, OMX_U32 a_pid)
 {
   tiz_krn_t *p_obj = ap_obj;
   void *p_prc = NULL;
-  tiz_vector_t *p_list = NULL;
+  tiz_krn_hdrlst_t *p_list = NULL;
   OMX_PTR p_port = NULL;
   OMX_BUFFERHEADERTYPE *p_hdr = NULL;
   OMX_S32 i = 0;
@@ -370,9 +629,9 @@ static OMX_ERRORTYPE propagate_ingress (void *ap_obj, OMX_U32 a_pid)
       /* Grab the port's ingress list */
       p_list = get_ingress_lst (p_obj, pid);
       TIZ_TRACE (handleOf (p_obj), "port [%d]'s ingress list length [%d]...",
-                 pid, tiz_vector_length (p_list));
+                 pid, hdrlst_length (p_list));
 
-      nbufs = tiz_vector_length (p_list);
+      nbufs = hdrlst_length (p_list);
       for (j = 0; j < nbufs; ++j)
         {
           /* Retrieve the header... */
@@ -579,7 +838,7 @@ static OMX_ERRORTYPE flush_egress (void *ap_obj, const OMX_U32 a_pid,
                                    const OMX_BOOL a_clear)
 {
   tiz_krn_t *p_obj = ap_obj;
-  tiz_vector_t *p_list = NULL;
+  tiz_krn_hdrlst_t *p_list = NULL;
   OMX_PTR p_port = NULL;
   OMX_BUFFERHEADERTYPE *p_hdr = NULL;
   OMX_S32 i = 0;
@@ -609,9 +868,9 @@ static OMX_ERRORTYPE flush_egress (void *ap_obj, const OMX_U32 a_pid,
       TIZ_TRACE (p_hdl,
                  "pid [%d] loop index=[%d] egress length [%d] "
                  "- p_thdl [%p]...",
-                 pid, i, tiz_vector_length (p_list), p_thdl);
+                 pid, i, hdrlst_length (p_list), p_thdl);
 
-      while (tiz_vector_length (p_list) > 0)
+      while (hdrlst_length (p_list) > 0)
         {
           /* Retrieve the header... */
           p_hdr = get_header (p_list, 0);
@@ -671,11 +930,19 @@ static OMX_ERRORTYPE flush_egress (void *ap_obj, const OMX_U32 a_pid,
                   }
               }
 
-            /* get rid of the buffer */
-            tiz_srv_issue_buf_callback ((OMX_PTR)ap_obj, p_hdr, pid, pdir,
-                                        p_thdl);
+            /* get rid of the buffer; tunneled peers in this process may take
+             * it straight into their handoff queue */
+            if (!p_thdl
+                || OMX_ErrorNotImplemented
+                     == tiz_comp_buffer_handoff (
+                          p_thdl, p_hdr,
+                          OMX_DirInput == pdir ? OMX_TRUE : OMX_FALSE))
+              {
+                tiz_srv_issue_buf_callback ((OMX_PTR)ap_obj, p_hdr, pid, pdir,
+                                            p_thdl);
+              }
             /* ... and delete it from the list. */
-            tiz_vector_erase (p_list, 0, 1);
+            hdrlst_erase (p_list, 0);
           }
         }
       ++i;
@@ -1238,7 +1505,7 @@ static bool all_buffers_returned (void *ap_obj)
   tiz_krn_t *p_obj = ap_obj;
   OMX_S32 nports = 0;
   OMX_PTR p_port = NULL;
-  tiz_vector_t *p_list = NULL;
+  tiz_krn_hdrlst_t *p_list = NULL;
   OMX_U32 i;
   OMX_S32 nbuf = 0, nbufin = 0;
 
@@ -1260,7 +1527,7 @@ static bool all_buffers_returned (void *ap_obj)
         {
           p_list = get_ingress_lst (p_obj, i);
 
-          if ((nbufin = tiz_vector_length (p_list)) != nbuf)
+          if ((nbufin = hdrlst_length (p_list)) != nbuf)
             {
               int j = 0;
               OMX_BUFFERHEADERTYPE *p_hdr = NULL;
@@ -228,6 +228,66 @@ free_buffer (void * ap_obj, OMX_PTR ap_buf, OMX_PTR /*@null@*/ ap_portPrivate)
                                   p_obj->opts_.mem_hooks.p_args);
 }
 
+#define HDR_IDX_MIN_CAPACITY 16
+
+static inline OMX_U32
+hdr_idx_hash (const OMX_BUFFERHEADERTYPE * ap_hdr, const OMX_U32 a_cap)
+{
+  return ((OMX_U32) ((uintptr_t) ap_hdr >> 4) * 2654435761u) & (a_cap - 1);
+}
+
+static void
+hdr_idx_insert (tiz_port_t * ap_obj, const OMX_BUFFERHEADERTYPE * ap_hdr,
+                const OMX_S32 a_pos)
+{
+  OMX_U32 i = hdr_idx_hash (ap_hdr, ap_obj->hdr_idx_cap_);
+  while (ap_obj->p_hdr_idx_[i].p_hdr)
+    {
+      i = (i + 1) & (ap_obj->hdr_idx_cap_ - 1);
+    }
+  ap_obj->p_hdr_idx_[i].p_hdr = ap_hdr;
+  ap_obj->p_hdr_idx_[i].pos = a_pos;
+}
+
+/* Re-create the header index from scratch. This only happens when buffers
+   are registered or unregistered. If memory is short, the index is dropped
+   and find_buffer falls back to a linear search. */
+static void
+hdr_idx_rebuild (tiz_port_t * ap_obj)
+{
+  const OMX_S32 hdr_count = tiz_vector_length (ap_obj->p_hdrs_info_);
+  OMX_U32 cap = HDR_IDX_MIN_CAPACITY;
+  OMX_S32 i = 0;
+
+  while (cap < 2 * (OMX_U32) hdr_count)
+    {
+      cap *= 2;
+    }
+
+  if (cap != ap_obj->hdr_idx_cap_)
+    {
+      tiz_mem_free (ap_obj->p_hdr_idx_);
+      ap_obj->hdr_idx_cap_ = 0;
+      if (!(ap_obj->p_hdr_idx_
+            = tiz_mem_calloc (cap, sizeof (tiz_port_hdr_slot_t))))
+        {
+          return;
+        }
+      ap_obj->hdr_idx_cap_ = cap;
+    }
+  else
+    {
+      tiz_mem_set (ap_obj->p_hdr_idx_, 0, cap * sizeof (tiz_port_hdr_slot_t));
+    }
+
+  for (i = 0; i < hdr_count; ++i)
+    {
+      tiz_port_buf_props_t ** pp_bps = tiz_vector_at (ap_obj->p_hdrs_info_, i);
+      assert (pp_bps && *pp_bps);
+      hdr_idx_insert (ap_obj, (*pp_bps)->p_hdr, i);
+    }
+}
+
 /* NOTE: Ignore splint warnings in this section of code */
 /*@ignore@*/
 static OMX_ERRORTYPE
@@ -254,6 +314,18 @@ register_header (const void * ap_obj, OMX_BUFFERHEADERTYPE * ap_hdr,
       return OMX_ErrorInsufficientResources;
     }
 
+  {
+    const OMX_S32 hdr_count = tiz_vector_length (p_obj->p_hdrs_info_);
+    if (2 * (OMX_U32) hdr_count > p_obj->hdr_idx_cap_)
+      {
+        hdr_idx_rebuild (p_obj);
+      }
+    else
+      {
+        hdr_idx_insert (p_obj, ap_hdr, hdr_count - 1);
+      }
+  }
+
   return OMX_ErrorNone;
 }
 /*@end@*/
@@ -269,6 +341,24 @@ find_buffer (const void * ap_obj, const OMX_BUFFERHEADERTYPE * ap_hdr,
   assert (ap_hdr);
   assert (ap_is_owned);
 
+  if (p_obj->p_hdr_idx_)
+    {
+      OMX_U32 j = hdr_idx_hash (ap_hdr, p_obj->hdr_idx_cap_);
+      while (p_obj->p_hdr_idx_[j].p_hdr)
+        {
+          if (ap_hdr == p_obj->p_hdr_idx_[j].p_hdr)
+            {
+              p_bps = get_buffer_properties (p_obj,
+                                             (OMX_U32) p_obj->p_hdr_idx_[j].pos);
+              assert (p_bps->p_hdr == ap_hdr);
+              *ap_is_owned = p_bps->owned;
+              return p_obj->p_hdr_idx_[j].pos;
+            }
+          j = (j + 1) & (p_obj->hdr_idx_cap_ - 1);
+        }
+      return TIZ_HDR_NOT_FOUND;
+    }
+
   for (i = 0; i < hdr_count; ++i)
     {
       p_bps = get_buffer_properties (p_obj, (OMX_U32) i);
@@ -297,6 +387,8 @@ unregister_header (const void * ap_obj, OMX_S32 hdr_pos)
       p_hdr = p_bps->p_hdr;
       tiz_mem_free (p_bps);
       tiz_vector_erase (p_obj->p_hdrs_info_, hdr_pos, 1);
+      /* Positions have shifted */
+      hdr_idx_rebuild (p_obj);
     }
   return p_hdr;
 }
@@ -329,6 +421,8 @@ port_ctor (void * ap_obj, va_list * app)
   /* Init buffer headers list */
   tiz_check_omx_ret_null (
     tiz_vector_init (&(p_obj->p_hdrs_info_), sizeof (tiz_port_buf_props_t *)));
+  p_obj->p_hdr_idx_ = NULL;
+  p_obj->hdr_idx_cap_ = 0;
   tiz_check_omx_ret_null (
     tiz_vector_init (&(p_obj->p_hdrs_), sizeof (OMX_BUFFERHEADERTYPE *)));
 
@@ -426,6 +520,8 @@ port_dtor (void * ap_obj)
   /* TODO : Delete tiz_port_buf_props_t items, if any */
   tiz_vector_clear (p_obj->p_hdrs_info_);
   tiz_vector_destroy (p_obj->p_hdrs_info_);
+  tiz_mem_free (p_obj->p_hdr_idx_);
+  p_obj->p_hdr_idx_ = NULL;
 
   tiz_vector_clear (p_obj->p_hdrs_);
   tiz_vector_destroy (p_obj->p_hdrs_);
@@ -1261,6 +1357,29 @@ tiz_port_super_find_index (const void * a_class, const void * ap_obj,
   return superclass->find_index (ap_obj, a_index);
 }
 
+/* The indexes that have been registered with the port. These two are not
+   class methods; the kernel uses them to build its index lookup table when
+   the port is registered. */
+OMX_U32
+tiz_port_index_count (const void * ap_obj)
+{
+  const tiz_port_t * p_obj = ap_obj;
+  assert (p_obj);
+  return (OMX_U32) tiz_vector_length (p_obj->p_indexes_);
+}
+
+OMX_INDEXTYPE
+tiz_port_index_at (const void * ap_obj, const OMX_U32 a_pos)
+{
+  const tiz_port_t * p_obj = ap_obj;
+  OMX_INDEXTYPE * p_index = NULL;
+  assert (p_obj);
+  assert (a_pos < (OMX_U32) tiz_vector_length (p_obj->p_indexes_));
+  p_index = tiz_vector_at (p_obj->p_indexes_, (OMX_S32) a_pos);
+  assert (p_index);
+  return *p_index;
+}
+
 static OMX_U32
 port_index (const void * ap_obj)
 {
@@ -107,6 +107,12 @@ tiz_port_register_index (const void * ap_obj, OMX_INDEXTYPE a_index);
 OMX_ERRORTYPE
 tiz_port_find_index (const void * ap_obj, OMX_INDEXTYPE a_index);
 
+OMX_U32
+tiz_port_index_count (const void * ap_obj);
+
+OMX_INDEXTYPE
+tiz_port_index_at (const void * ap_obj, const OMX_U32 a_pos);
+
 OMX_U32
 tiz_port_index (const void * ap_obj);
 
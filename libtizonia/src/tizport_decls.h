@@ -39,6 +39,15 @@ extern "C" {
 #include "OMX_Component.h"
 #include "OMX_TizoniaExt.h"
 
+/* Entry in the open-addressing index that maps a buffer header to its
+   position in the port's header list */
+typedef struct tiz_port_hdr_slot tiz_port_hdr_slot_t;
+struct tiz_port_hdr_slot
+{
+  const OMX_BUFFERHEADERTYPE * p_hdr;
+  OMX_S32 pos;
+};
+
 typedef struct tiz_port tiz_port_t;
 struct tiz_port
 {
@@ -46,6 +55,8 @@ struct tiz_port
   const tiz_api_t _;
   tiz_vector_t * p_indexes_;
   tiz_vector_t * p_hdrs_info_;
+  tiz_port_hdr_slot_t * p_hdr_idx_;
+  OMX_U32 hdr_idx_cap_; /* Zero or a power of two */
   tiz_vector_t * p_hdrs_;
   tiz_vector_t * p_marks_;
   OMX_U32 pid_;
@@ -31,6 +31,8 @@
 #endif
 
 #include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <OMX_Core.h>
@@ -55,6 +57,27 @@
 
 #define SCHED_OMX_DEFAULT_ROLE "default"
 #define SCHED_QUEUE_MAX_ITEMS 30
+/* Extra messages for APIs invoked from the scheduler thread itself (those are
+   dispatched without going through the queue) and for blocked senders */
+#define SCHED_MSG_POOL_HEADROOM 10
+#define SCHED_MSG_POOL_SIZE (SCHED_QUEUE_MAX_ITEMS + SCHED_MSG_POOL_HEADROOM)
+#define SCHED_MSG_NOT_POOLED -1
+#define SCHED_RCFILE_QUEUE_TYPE_KEY "scheduler.queue-type"
+#define SCHED_RCFILE_TUNNEL_HANDOFF_KEY "scheduler.tunnel-handoff"
+#define SCHED_RCFILE_MODE_KEY "scheduler.mode"
+#define SCHED_RCFILE_POOL_SIZE_KEY "scheduler.pool-size"
+#define SCHED_RCFILE_EVENT_LOOP_SHARD_KEY "event-loop.shard."
+#define SCHED_POOL_THREAD_NAME "tizsched"
+/* Messages a component may process in one go before giving other components
+   a chance to run on the same pool worker */
+#define SCHED_POOL_TASK_MAX_MSGS 16
+/* A header can only be sitting once in a peer's handoff queue, so this only
+   needs to be larger than the number of buffers that can be tunneled into a
+   single component. */
+#define SCHED_HANDOFF_MAX_ITEMS 256
+/* Headers are at least pointer-aligned; the lowest bit of a queued header
+   tells FillThisBuffer handoffs apart from EmptyThisBuffer ones */
+#define SCHED_HANDOFF_FTB_TAG ((uintptr_t) 0x1)
 
 #ifndef S_SPLINT_S
 #define TIZ_COMP_INIT_MSG(hdl, msg, msgtype)         \
@@ -130,9 +153,14 @@ struct tiz_scheduler
   char cname[OMX_MAX_STRINGNAME_SIZE + 4096];
   tiz_thread_t thread;
   OMX_S32 thread_id;
+  tiz_wpool_task_t * p_task; /* Only in worker pool mode; no thread then */
   tiz_mutex_t mutex;
   tiz_sem_t sem;
   tiz_queue_t * p_queue;
+  tiz_mpscq_t * p_mpscq; /* Only when the lock-free queue has been selected */
+  tiz_mpscq_t * p_handoff_q; /* Only when tunnel handoffs are enabled */
+  int32_t handoff_pending;   /* A handoff wakeup message is in flight */
+  struct tiz_sched_msg_pool * p_msg_pool;
   tiz_soa_t * p_soa;
   tiz_os_t * p_objsys;
   OMX_S32 error;
@@ -175,6 +203,7 @@ enum tiz_sched_msg_class
   ETIZSchedMsgEvIo,
   ETIZSchedMsgEvTimer,
   ETIZSchedMsgEvStat,
+  ETIZSchedMsgBufferHandoff,
   ETIZSchedMsgMax,
 };
 
@@ -353,6 +382,7 @@ typedef struct tiz_sched_msg tiz_sched_msg_t;
 struct tiz_sched_msg
 {
   OMX_HANDLETYPE p_hdl;
+  OMX_S32 pool_slot; /* SCHED_MSG_NOT_POOLED if allocated on the heap */
   OMX_BOOL will_block;
   OMX_BOOL may_block;
   tiz_sched_msg_class_t class;
@@ -383,6 +413,19 @@ struct tiz_sched_msg
   };
 };
 
+/* Pre-allocated messages. Any thread may take a message out of the pool;
+   messages are normally returned to it by the scheduler thread once they have
+   been dispatched. */
+typedef struct tiz_sched_msg_pool tiz_sched_msg_pool_t;
+struct tiz_sched_msg_pool
+{
+  tiz_sched_msg_t msgs[SCHED_MSG_POOL_SIZE];
+  int32_t in_use[SCHED_MSG_POOL_SIZE];
+  uint32_t hint;
+  uint64_t pool_allocs;
+  uint64_t heap_allocs;
+};
+
 /* Forward declarations */
 static OMX_ERRORTYPE
 do_init (tiz_scheduler_t *, tiz_sched_state_t *, tiz_sched_msg_t *);
@@ -440,6 +483,8 @@ static OMX_ERRORTYPE
 do_etmr (tiz_scheduler_t *, tiz_sched_state_t *, tiz_sched_msg_t *);
 static OMX_ERRORTYPE
 do_estat (tiz_scheduler_t *, tiz_sched_state_t *, tiz_sched_msg_t *);
+static OMX_ERRORTYPE
+do_bho (tiz_scheduler_t *, tiz_sched_state_t *, tiz_sched_msg_t *);
 
 static OMX_ERRORTYPE
 init_servants (tiz_scheduler_t *, tiz_sched_msg_t *);
@@ -466,6 +511,7 @@ static const tiz_sched_msg_dispatch_f tiz_sched_msg_to_fnt_tbl[] = {
   do_sconfig, do_gei,    do_gs,    do_tr,   do_ub,     do_ab,     do_fb,
   do_etb,     do_ftb,    do_scbs,  do_uei,  do_cre,    do_plgevt, do_rr,
   do_rt,      do_rph,    do_reh,   do_rreh, do_eio,    do_etmr,   do_estat,
+  do_bho,
 };
 
 static OMX_BOOL
@@ -509,6 +555,7 @@ static tiz_sched_msg_str_t tiz_sched_msg_to_str_tbl[] = {
   {ETIZSchedMsgEvIo, "{ETIZSchedMsgEvIo,"},
   {ETIZSchedMsgEvTimer, "ETIZSchedMsgEvTimer"},
   {ETIZSchedMsgEvStat, "ETIZSchedMsgEvStat"},
+  {ETIZSchedMsgBufferHandoff, "ETIZSchedMsgBufferHandoff"},
   {ETIZSchedMsgMax, "ETIZSchedMsgMax"},
 };
 
@@ -569,6 +616,7 @@ static OMX_BOOL tiz_sched_blocking_apis_tbl[] = {
   OMX_FALSE,    /* ETIZSchedMsgEvIo */
   OMX_FALSE,    /* ETIZSchedMsgEvTimer */
   OMX_FALSE,    /* ETIZSchedMsgEvStat */
+  OMX_FALSE,    /* ETIZSchedMsgBufferHandoff */
   OMX_BOOL_MAX, /* ETIZSchedMsgMax */
 };
 
@@ -765,13 +813,75 @@ store_hooks (tiz_map_t ** app_map, OMX_U32 a_pid, const void * ap_hooks,
   return rc;
 }
 
+static inline OMX_ERRORTYPE
+sched_queue_send (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
+{
+  assert (ap_sched);
+  return ap_sched->p_mpscq ? tiz_mpscq_send (ap_sched->p_mpscq, ap_msg)
+                           : tiz_queue_send (ap_sched->p_queue, ap_msg);
+}
+
+static inline OMX_ERRORTYPE
+sched_queue_receive (tiz_scheduler_t * ap_sched, OMX_PTR * app_data)
+{
+  assert (ap_sched);
+  return ap_sched->p_mpscq ? tiz_mpscq_receive (ap_sched->p_mpscq, app_data)
+                           : tiz_queue_receive (ap_sched->p_queue, app_data);
+}
+
+static inline OMX_ERRORTYPE
+sched_queue_try_receive (tiz_scheduler_t * ap_sched, OMX_PTR * app_data)
+{
+  assert (ap_sched);
+  return ap_sched->p_mpscq
+           ? tiz_mpscq_timed_receive (ap_sched->p_mpscq, app_data, 0)
+           : tiz_queue_timed_receive (ap_sched->p_queue, app_data, 0);
+}
+
+static inline OMX_S32
+sched_queue_length (tiz_scheduler_t * ap_sched)
+{
+  assert (ap_sched);
+  return ap_sched->p_mpscq ? tiz_mpscq_length (ap_sched->p_mpscq)
+                           : tiz_queue_length (ap_sched->p_queue);
+}
+
+static OMX_ERRORTYPE
+sched_post (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
+{
+  assert (ap_sched);
+  assert (ap_msg);
+
+  if (!ap_sched->p_task)
+    {
+      return sched_queue_send (ap_sched, ap_msg);
+    }
+
+  /* A pool worker must not park on a full queue: the component that is
+     supposed to drain it might be waiting for a worker. Drain it here. */
+  while (sched_queue_length (ap_sched) >= SCHED_QUEUE_MAX_ITEMS
+         && tiz_wpool_task_try_run (ap_sched->p_task))
+    {
+    }
+
+  tiz_check_omx (sched_queue_send (ap_sched, ap_msg));
+  tiz_wpool_task_signal (ap_sched->p_task);
+  return OMX_ErrorNone;
+}
+
 static inline OMX_ERRORTYPE
 send_msg_blocking (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
 {
   assert (ap_msg);
   assert (ap_sched);
   ap_msg->will_block = OMX_TRUE;
-  tiz_check_omx_ret_oom (tiz_queue_send (ap_sched->p_queue, ap_msg));
+  tiz_check_omx_ret_oom (sched_post (ap_sched, ap_msg));
+  if (ap_sched->p_task)
+    {
+      /* Same reasoning as in sched_post: when called from a pool worker,
+         serve the request here instead of waiting for another worker */
+      (void) tiz_wpool_task_try_run (ap_sched->p_task);
+    }
   tiz_check_omx_ret_oom (tiz_sem_wait (&(ap_sched->sem)));
   return ap_sched->error;
 }
@@ -782,7 +892,7 @@ send_msg_non_blocking (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
   assert (ap_msg);
   assert (ap_sched);
   ap_msg->will_block = OMX_FALSE;
-  return tiz_queue_send (ap_sched->p_queue, ap_msg);
+  return sched_post (ap_sched, ap_msg);
 }
 
 static inline OMX_ERRORTYPE
@@ -794,7 +904,9 @@ send_msg (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
   assert (ap_sched);
   assert (ap_msg);
 
-  if (tid == ap_sched->thread_id && ap_msg->class != ETIZSchedMsgPluggableEvent)
+  if ((tid == ap_sched->thread_id
+       || tiz_wpool_task_is_current (ap_sched->p_task))
+      && ap_msg->class != ETIZSchedMsgPluggableEvent)
     {
       TIZ_WARN (ap_sched->child.p_hdl,
                 "WARNING: (API %s called from IL callback context...)",
@@ -1657,19 +1769,139 @@ do_estat (tiz_scheduler_t * ap_sched, tiz_sched_state_t * ap_state,
                              p_msg_estat->id, p_msg_estat->events);
 }
 
+static OMX_ERRORTYPE
+do_bho (tiz_scheduler_t * ap_sched, tiz_sched_state_t * ap_state,
+        tiz_sched_msg_t * ap_msg)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  OMX_PTR p_data = NULL;
+
+  assert (ap_sched);
+  assert (ap_msg);
+  assert (ap_state && ETIZSchedStateStarted == *ap_state);
+  assert (ap_sched->p_handoff_q);
+
+  /* Re-arm the wakeup before draining. A header queued after this point
+     either gets picked up below or triggers another wakeup message.
+
+     NOTE: This drains every header queued so far, including any that were
+     handed over after a command (e.g. a flush or a port disable) that is
+     still waiting in the main queue behind this wakeup. Headers are only ever
+     delivered earlier than their EmptyThisBuffer/FillThisBuffer message would
+     have been, never later, and always before the command has been looked
+     at. That is an order the standard path can produce too, when the peer's
+     call reaches the queue just ahead of the IL client's command; the
+     command then deals with the header as usual (e.g. a flush returns it). */
+  (void) __atomic_exchange_n (&(ap_sched->handoff_pending), 0,
+                              __ATOMIC_SEQ_CST);
+
+  while (OMX_ErrorNone
+         == tiz_mpscq_timed_receive (ap_sched->p_handoff_q, &p_data, 0))
+    {
+      const uintptr_t item = (uintptr_t) p_data;
+      OMX_BUFFERHEADERTYPE * p_hdr
+        = (OMX_BUFFERHEADERTYPE *) (item & ~SCHED_HANDOFF_FTB_TAG);
+      OMX_ERRORTYPE hdr_rc = OMX_ErrorNone;
+
+      /* Same validation as the standard path; the fsm decides whether the
+         header is accepted in the current state */
+      if (item & SCHED_HANDOFF_FTB_TAG)
+        {
+          hdr_rc = tiz_api_FillThisBuffer (ap_sched->child.p_fsm, ap_msg->p_hdl,
+                                           p_hdr);
+        }
+      else
+        {
+          hdr_rc = tiz_api_EmptyThisBuffer (ap_sched->child.p_fsm,
+                                            ap_msg->p_hdl, p_hdr);
+        }
+
+      if (OMX_ErrorNone != hdr_rc)
+        {
+          TIZ_ERROR (ap_msg->p_hdl, "[%s] : HEADER [%p] handoff rejected",
+                     tiz_err_to_str (hdr_rc), p_hdr);
+          rc = hdr_rc;
+        }
+    }
+
+  return rc;
+}
+
 /* NOTE: Start ignoring splint warnings in this section of code */
 /*@ignore@*/
+static inline tiz_sched_msg_t *
+get_pooled_message (tiz_sched_msg_pool_t * ap_pool)
+{
+  const uint32_t start
+    = __atomic_fetch_add (&(ap_pool->hint), 1, __ATOMIC_RELAXED);
+  OMX_S32 i = 0;
+
+  for (i = 0; i < SCHED_MSG_POOL_SIZE; ++i)
+    {
+      const OMX_S32 slot = (start + i) % SCHED_MSG_POOL_SIZE;
+      int32_t expected = 0;
+      if (0 == __atomic_load_n (&(ap_pool->in_use[slot]), __ATOMIC_RELAXED)
+          && __atomic_compare_exchange_n (&(ap_pool->in_use[slot]), &expected,
+                                          1, false, __ATOMIC_ACQUIRE,
+                                          __ATOMIC_RELAXED))
+        {
+          tiz_sched_msg_t * p_msg = &(ap_pool->msgs[slot]);
+          (void) __atomic_add_fetch (&(ap_pool->pool_allocs), 1,
+                                     __ATOMIC_RELAXED);
+          memset (p_msg, 0, sizeof (tiz_sched_msg_t));
+          p_msg->pool_slot = slot;
+          return p_msg;
+        }
+    }
+
+  return NULL;
+}
+
+static inline void
+release_scheduler_message (tiz_scheduler_t * ap_sched,
+                           tiz_sched_msg_t * ap_msg)
+{
+  assert (ap_sched);
+  assert (ap_msg);
+
+  if (SCHED_MSG_NOT_POOLED == ap_msg->pool_slot)
+    {
+      tiz_mem_free (ap_msg);
+    }
+  else
+    {
+      assert (ap_sched->p_msg_pool);
+      assert (ap_msg == &(ap_sched->p_msg_pool->msgs[ap_msg->pool_slot]));
+      __atomic_store_n (&(ap_sched->p_msg_pool->in_use[ap_msg->pool_slot]), 0,
+                        __ATOMIC_RELEASE);
+    }
+}
+
 static inline tiz_sched_msg_t *
 init_scheduler_message (OMX_HANDLETYPE ap_hdl,
                         tiz_sched_msg_class_t a_msg_class)
 {
   tiz_sched_msg_t * p_msg = NULL;
+  tiz_sched_msg_pool_t * p_pool = NULL;
 
   assert (ap_hdl);
   assert (a_msg_class < ETIZSchedMsgMax);
 
-  if (!(p_msg
-        = (tiz_sched_msg_t *) tiz_mem_calloc (1, sizeof (tiz_sched_msg_t))))
+  p_pool = get_sched (ap_hdl)->p_msg_pool;
+  assert (p_pool);
+
+  if (!(p_msg = get_pooled_message (p_pool)))
+    {
+      /* Pool exhausted; fall back to the heap */
+      (void) __atomic_add_fetch (&(p_pool->heap_allocs), 1, __ATOMIC_RELAXED);
+      if ((p_msg
+           = (tiz_sched_msg_t *) tiz_mem_calloc (1, sizeof (tiz_sched_msg_t))))
+        {
+          p_msg->pool_slot = SCHED_MSG_NOT_POOLED;
+        }
+    }
+
+  if (!p_msg)
     {
       TIZ_ERROR (ap_hdl,
                  "[OMX_ErrorInsufficientResources] : "
@@ -1760,6 +1992,7 @@ sched_ComponentDeInit (OMX_HANDLETYPE ap_hdl)
   assert (p_msg);
   rc = send_msg (p_sched, p_msg);
   delete_scheduler (p_sched);
+  tiz_event_loop_unpin (ap_hdl);
   return rc;
 }
 
@@ -1948,7 +2181,7 @@ sched_SetConfig (OMX_HANDLETYPE ap_hdl, OMX_INDEXTYPE a_index,
       if (!(p_msg_sconf->p_struct
             = tiz_mem_calloc (1, (*(OMX_U32 *) ap_struct))))
         {
-          tiz_mem_free (p_msg);
+          release_scheduler_message (p_sched, p_msg);
           TIZ_ERROR (ap_hdl,
                      "[OMX_ErrorInsufficientResources] : "
                      "(While allocating memory for config struct)");
@@ -2324,7 +2557,7 @@ dispatch_msg (tiz_scheduler_t * ap_sched, tiz_sched_state_t * ap_state,
   /* Return error to client */
   ap_sched->error = rc;
 
-  tiz_mem_free (ap_msg);
+  release_scheduler_message (ap_sched, ap_msg);
 
   return signal_client;
 }
@@ -2374,7 +2607,7 @@ schedule_servants (tiz_scheduler_t * ap_sched, const tiz_sched_state_t ap_state)
           rc = tiz_srv_tick (p_ready);
         }
 
-      if (tiz_queue_length (ap_sched->p_queue) > 0)
+      if (sched_queue_length (ap_sched) > 0)
         {
           break;
         }
@@ -2403,7 +2636,7 @@ il_sched_thread_func (void * p_arg)
 
   for (;;)
     {
-      tiz_check_omx_ret_null (tiz_queue_receive (p_sched->p_queue, &p_data));
+      tiz_check_omx_ret_null (sched_queue_receive (p_sched, &p_data));
 
       assert (p_data);
       signal_client
@@ -2425,11 +2658,96 @@ il_sched_thread_func (void * p_arg)
   return NULL;
 }
 
+/* Pool mode counterpart of il_sched_thread_func. The pool guarantees that
+   this never runs concurrently for the same component. */
+static void
+sched_task_func (void * p_arg)
+{
+  tiz_scheduler_t * p_sched = (tiz_scheduler_t *) (p_arg);
+  OMX_PTR p_data = NULL;
+  OMX_BOOL signal_client = OMX_FALSE;
+  OMX_S32 nmsgs = 0;
+
+  assert (p_sched);
+
+  while (ETIZSchedStateStopped != p_sched->state
+         && nmsgs++ < SCHED_POOL_TASK_MAX_MSGS
+         && OMX_ErrorNone == sched_queue_try_receive (p_sched, &p_data))
+    {
+      assert (p_data);
+      signal_client
+        = dispatch_msg (p_sched, &(p_sched->state), (tiz_sched_msg_t *) p_data);
+
+      if (OMX_TRUE == signal_client)
+        {
+          (void) tiz_sem_post (&(p_sched->sem));
+        }
+
+      if (ETIZSchedStateStopped == p_sched->state)
+        {
+          return;
+        }
+
+      schedule_servants (p_sched, p_sched->state);
+    }
+
+  /* Come back later for whatever is left */
+  if (ETIZSchedStateStopped != p_sched->state
+      && sched_queue_length (p_sched) > 0)
+    {
+      tiz_wpool_task_signal (p_sched->p_task);
+    }
+}
+
+static pthread_once_t g_sched_pool_once = PTHREAD_ONCE_INIT;
+/* Shared by all the components of the process that run in pool mode. It is
+   never destroyed. */
+static tiz_wpool_t * gp_sched_pool = NULL;
+
+static void
+init_sched_pool (void)
+{
+  const char * p_size
+    = tiz_rcfile_get_value ("ilcore", SCHED_RCFILE_POOL_SIZE_KEY);
+  const OMX_S32 nworkers = p_size ? MAX (atoi (p_size), 0) : 0;
+
+  if (OMX_ErrorNone
+      != tiz_wpool_init (&gp_sched_pool, nworkers, SCHED_POOL_THREAD_NAME))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "[OMX_ErrorInsufficientResources] : "
+               "Unable to create the scheduler pool; "
+               "using one thread per component");
+      gp_sched_pool = NULL;
+    }
+}
+
+static tiz_wpool_t *
+get_sched_pool (void)
+{
+  const char * p_mode = tiz_rcfile_get_value ("ilcore", SCHED_RCFILE_MODE_KEY);
+  if (!p_mode || 0 != strncmp (p_mode, "pool", 4))
+    {
+      return NULL;
+    }
+  (void) pthread_once (&g_sched_pool_once, init_sched_pool);
+  return gp_sched_pool;
+}
+
 static OMX_ERRORTYPE
 start_scheduler (tiz_scheduler_t * ap_sched)
 {
+  tiz_wpool_t * p_pool = NULL;
+
   assert (ap_sched);
 
+  if ((p_pool = get_sched_pool ()))
+    {
+      /* No thread; the component runs on the pool's workers */
+      return tiz_wpool_task_init (p_pool, &(ap_sched->p_task),
+                                  sched_task_func, ap_sched);
+    }
+
   /* Create scheduler thread */
   tiz_check_omx_ret_oom (tiz_mutex_lock (&(ap_sched->mutex)));
   tiz_check_omx_ret_oom (tiz_thread_create (&(ap_sched->thread), 0, 0,
@@ -2446,7 +2764,15 @@ delete_scheduler (tiz_scheduler_t * ap_sched)
 {
   OMX_PTR p_result = NULL;
   assert (ap_sched);
-  (void) tiz_thread_join (&(ap_sched->thread), &p_result);
+  if (ap_sched->p_task)
+    {
+      tiz_wpool_task_destroy (ap_sched->p_task);
+      ap_sched->p_task = NULL;
+    }
+  else
+    {
+      (void) tiz_thread_join (&(ap_sched->thread), &p_result);
+    }
   delete_roles (ap_sched);
   delete_hooks (ap_sched, ap_sched->child.p_alloc_hooks_map);
   ap_sched->child.p_alloc_hooks_map = NULL;
@@ -2456,9 +2782,69 @@ delete_scheduler (tiz_scheduler_t * ap_sched)
   (void) tiz_sem_destroy (&(ap_sched->sem));
   tiz_queue_destroy (ap_sched->p_queue);
   ap_sched->p_queue = NULL;
+  tiz_mpscq_destroy (ap_sched->p_mpscq);
+  ap_sched->p_mpscq = NULL;
+  tiz_mpscq_destroy (ap_sched->p_handoff_q);
+  ap_sched->p_handoff_q = NULL;
+  if (ap_sched->p_msg_pool)
+    {
+      TIZ_LOG (TIZ_PRIORITY_DEBUG,
+               "[%s] message pool : pool allocs [%llu] heap allocs [%llu]",
+               ap_sched->cname,
+               (unsigned long long) ap_sched->p_msg_pool->pool_allocs,
+               (unsigned long long) ap_sched->p_msg_pool->heap_allocs);
+    }
+  tiz_mem_free (ap_sched->p_msg_pool);
+  ap_sched->p_msg_pool = NULL;
   tiz_mem_free (ap_sched);
 }
 
+static OMX_BOOL
+use_lockfree_queue (void)
+{
+  const char * p_queue_type
+    = tiz_rcfile_get_value ("ilcore", SCHED_RCFILE_QUEUE_TYPE_KEY);
+  return (p_queue_type && 0 == strncmp (p_queue_type, "lockfree", 8))
+           ? OMX_TRUE
+           : OMX_FALSE;
+}
+
+static OMX_BOOL
+use_tunnel_handoff (void)
+{
+  const char * p_handoff
+    = tiz_rcfile_get_value ("ilcore", SCHED_RCFILE_TUNNEL_HANDOFF_KEY);
+  return (p_handoff && 0 == strncmp (p_handoff, "true", 4)) ? OMX_TRUE
+                                                             : OMX_FALSE;
+}
+
+/* Components that have a shard configured for them get their watchers on
+   that event loop shard; the rest are placed by the event loop itself */
+static void
+pin_event_loop_shard (tiz_scheduler_t * ap_sched)
+{
+  char key[sizeof (SCHED_RCFILE_EVENT_LOOP_SHARD_KEY)
+           + OMX_MAX_STRINGNAME_SIZE];
+  const char * p_shard = NULL;
+
+  assert (ap_sched);
+
+  /* The component name is never longer than OMX_MAX_STRINGNAME_SIZE - 1 (see
+     instantiate_scheduler), though its buffer is larger */
+  snprintf (key, sizeof (key), "%s%.*s", SCHED_RCFILE_EVENT_LOOP_SHARD_KEY,
+            OMX_MAX_STRINGNAME_SIZE - 1, ap_sched->cname);
+  if ((p_shard = tiz_rcfile_get_value ("ilcore", key)))
+    {
+      const OMX_ERRORTYPE rc
+        = tiz_event_loop_pin (ap_sched->child.p_hdl, atoi (p_shard));
+      if (OMX_ErrorNone != rc)
+        {
+          TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s] : Unable to use event loop [%s]",
+                   tiz_err_to_str (rc), p_shard);
+        }
+    }
+}
+
 static tiz_scheduler_t *
 instantiate_scheduler (OMX_HANDLETYPE ap_hdl, const char * ap_cname)
 {
@@ -2477,8 +2863,35 @@ instantiate_scheduler (OMX_HANDLETYPE ap_hdl, const char * ap_cname)
 
   tiz_check_omx_ret_null (tiz_mutex_init (&(p_sched->mutex)));
   tiz_check_omx_ret_null (tiz_sem_init (&(p_sched->sem), 0));
-  tiz_check_omx_ret_null (
-    tiz_queue_init (&(p_sched->p_queue), SCHED_QUEUE_MAX_ITEMS));
+  if (use_lockfree_queue ())
+    {
+      tiz_check_omx_ret_null (
+        tiz_mpscq_init (&(p_sched->p_mpscq), SCHED_QUEUE_MAX_ITEMS));
+    }
+  else
+    {
+      tiz_check_omx_ret_null (
+        tiz_queue_init (&(p_sched->p_queue), SCHED_QUEUE_MAX_ITEMS));
+    }
+  if (use_tunnel_handoff ())
+    {
+      tiz_check_omx_ret_null (
+        tiz_mpscq_init (&(p_sched->p_handoff_q), SCHED_HANDOFF_MAX_ITEMS));
+    }
+  if (!(p_sched->p_msg_pool
+        = tiz_mem_calloc (1, sizeof (tiz_sched_msg_pool_t))))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "[OMX_ErrorInsufficientResources] : "
+               "(Could not allocate the message pool)");
+      (void) tiz_mutex_destroy (&(p_sched->mutex));
+      (void) tiz_sem_destroy (&(p_sched->sem));
+      tiz_queue_destroy (p_sched->p_queue);
+      tiz_mpscq_destroy (p_sched->p_mpscq);
+      tiz_mpscq_destroy (p_sched->p_handoff_q);
+      tiz_mem_free (p_sched);
+      return NULL;
+    }
 
   p_sched->child.p_fsm = NULL;
   p_sched->child.p_ker = NULL;
@@ -2550,7 +2963,10 @@ init_servants (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
   assert (ap_sched);
   assert (ap_msg);
 
-  tiz_check_omx_ret_oom (set_thread_name (ap_sched));
+  if (!ap_sched->p_task)
+    {
+      tiz_check_omx_ret_oom (set_thread_name (ap_sched));
+    }
 
   p_hdl = ap_sched->child.p_hdl;
 
@@ -2642,6 +3058,7 @@ deinit_servants (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
   ap_sched->p_objsys = NULL;
 
   /* Destroy the small object allocator used by the servants */
+  tiz_soa_dump (ap_sched->p_soa, ap_sched->cname);
   tiz_soa_destroy (ap_sched->p_soa);
   ap_sched->p_soa = NULL;
 
@@ -2835,6 +3252,8 @@ tiz_comp_init (const OMX_HANDLETYPE ap_hdl, const char * ap_cname)
       return OMX_ErrorInsufficientResources;
     }
 
+  pin_event_loop_shard (p_sched);
+
   tiz_check_omx_ret_oom (start_scheduler (p_sched));
 
   TIZ_COMP_INIT_MSG_OOM (ap_hdl, p_msg, ETIZSchedMsgComponentInit);
@@ -3039,12 +3458,81 @@ tiz_comp_event_stat (const OMX_HANDLETYPE ap_hdl, tiz_event_stat_t * ap_ev_stat,
   (void) send_msg (get_sched (ap_hdl), p_msg);
 }
 
+void
+tiz_comp_msg_pool_stats (const OMX_HANDLETYPE ap_hdl, OMX_U64 * ap_pool_allocs,
+                         OMX_U64 * ap_heap_allocs)
+{
+  tiz_scheduler_t * p_sched = get_sched (ap_hdl);
+  assert (p_sched);
+  assert (p_sched->p_msg_pool);
+  if (ap_pool_allocs)
+    {
+      *ap_pool_allocs = __atomic_load_n (&(p_sched->p_msg_pool->pool_allocs),
+                                         __ATOMIC_RELAXED);
+    }
+  if (ap_heap_allocs)
+    {
+      *ap_heap_allocs = __atomic_load_n (&(p_sched->p_msg_pool->heap_allocs),
+                                         __ATOMIC_RELAXED);
+    }
+}
+
+OMX_ERRORTYPE
+tiz_comp_buffer_handoff (const OMX_HANDLETYPE ap_peer_hdl,
+                         OMX_BUFFERHEADERTYPE * ap_hdr, const OMX_BOOL a_fill)
+{
+  tiz_scheduler_t * p_peer = NULL;
+  tiz_sched_msg_t * p_msg = NULL;
+  uintptr_t item = (uintptr_t) ap_hdr;
+
+  assert (ap_peer_hdl);
+  assert (ap_hdr);
+  assert (0 == (item & SCHED_HANDOFF_FTB_TAG));
+
+  /* Only Tizonia components loaded in this process are able to take headers
+     this way */
+  if (sched_EmptyThisBuffer
+      != ((OMX_COMPONENTTYPE *) ap_peer_hdl)->EmptyThisBuffer)
+    {
+      return OMX_ErrorNotImplemented;
+    }
+
+  p_peer = get_sched (ap_peer_hdl);
+  if (!p_peer || !p_peer->p_handoff_q)
+    {
+      return OMX_ErrorNotImplemented;
+    }
+
+  if (OMX_TRUE == a_fill)
+    {
+      item |= SCHED_HANDOFF_FTB_TAG;
+    }
+
+  /* This does not block in practice; see SCHED_HANDOFF_MAX_ITEMS */
+  tiz_check_omx (tiz_mpscq_send (p_peer->p_handoff_q, (OMX_PTR) item));
+
+  /* Wake up the peer only if there is not a wakeup on its way already */
+  if (0
+      == __atomic_exchange_n (&(p_peer->handoff_pending), 1, __ATOMIC_SEQ_CST))
+    {
+      if (!(p_msg = init_scheduler_message (ap_peer_hdl,
+                                            ETIZSchedMsgBufferHandoff)))
+        {
+          __atomic_store_n (&(p_peer->handoff_pending), 0, __ATOMIC_SEQ_CST);
+          return OMX_ErrorInsufficientResources;
+        }
+      return send_msg (p_peer, p_msg);
+    }
+
+  return OMX_ErrorNone;
+}
+
 size_t
 tiz_comp_event_queue_unused_spaces (const OMX_HANDLETYPE ap_hdl)
 {
   tiz_scheduler_t * p_sched = get_sched (ap_hdl);
   assert (p_sched);
-  return SCHED_QUEUE_MAX_ITEMS - tiz_queue_length (p_sched->p_queue);
+  return SCHED_QUEUE_MAX_ITEMS - sched_queue_length (p_sched);
 }
 
 void *
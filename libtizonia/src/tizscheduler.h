@@ -403,6 +403,41 @@ void
 tiz_comp_event_stat (const OMX_HANDLETYPE ap_hdl, tiz_event_stat_t * ap_ev_stat,
                      void * ap_arg, const uint32_t a_id, const int a_events);
 
+/**
+ * Retrieve the scheduler message pool counters. In steady state, every
+ * OpenMAX IL API call should be served from the pool, i.e. the heap
+ * allocations counter should not grow.
+ * @ingroup tizscheduler
+ * @param ap_hdl The OpenMAX IL handle.
+ * @param ap_pool_allocs Number of messages served from the pool (may be NULL).
+ * @param ap_heap_allocs Number of messages that had to be allocated on the
+ * heap because the pool was exhausted (may be NULL).
+ */
+void
+tiz_comp_msg_pool_stats (const OMX_HANDLETYPE ap_hdl, OMX_U64 * ap_pool_allocs,
+                         OMX_U64 * ap_heap_allocs);
+
+/**
+ * Hand a buffer header directly over to a tunneled peer component. The header
+ * is placed in the peer's handoff queue and the peer's scheduler is woken up
+ * once for any number of headers queued in a row, instead of receiving one
+ * EmptyThisBuffer/FillThisBuffer message per header. Headers handed over
+ * while a command is pending in the peer's queue may reach the peer ahead of
+ * that command (but never behind a command queued after them).
+ * @ingroup tizscheduler
+ * @param ap_peer_hdl The OpenMAX IL handle of the tunneled peer.
+ * @param ap_hdr The buffer header.
+ * @param a_fill OMX_TRUE to deliver the header as FillThisBuffer, OMX_FALSE
+ * to deliver it as EmptyThisBuffer.
+ * @return OMX_ErrorNotImplemented if the peer does not accept direct
+ * handoffs (i.e. it is not a Tizonia component, or handoffs are disabled in
+ * tizonia.conf); in this case the header has not been delivered and the
+ * standard OpenMAX IL API must be used instead. OMX_ErrorNone on success.
+ */
+OMX_ERRORTYPE
+tiz_comp_buffer_handoff (const OMX_HANDLETYPE ap_peer_hdl,
+                         OMX_BUFFERHEADERTYPE * ap_hdr, const OMX_BOOL a_fill);
+
 /**
  * Retrieve the current maximum number of items that could be insterted into the queue.
  * @ingroup tizscheduler
@@ -86,34 +86,30 @@ struct tiz_pd_set
 #define TIZ_CBUF(hdl) \
   (((OMX_COMPONENTTYPE *) hdl)->pComponentPrivate + OMX_MAX_STRINGNAME_SIZE)
 
-#define TIZ_LOGN(priority, hdl, format, args...)                              \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME, priority, \
-           TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, ##args);
-
-#define TIZ_ERROR(hdl, format, args...)                                 \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME,     \
-           TIZ_PRIORITY_ERROR, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
-           ##args);
-
-#define TIZ_WARN(hdl, format, args...)                                 \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME,    \
-           TIZ_PRIORITY_WARN, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
-           ##args);
-
-#define TIZ_NOTICE(hdl, format, args...)                                 \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME,      \
-           TIZ_PRIORITY_NOTICE, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
-           ##args);
-
-#define TIZ_DEBUG(hdl, format, args...)                                 \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME,     \
-           TIZ_PRIORITY_DEBUG, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
-           ##args);
-
-#define TIZ_TRACE(hdl, format, args...)                                 \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME,     \
-           TIZ_PRIORITY_TRACE, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
-           ##args);
+/* None of the arguments (including hdl) are evaluated when the priority is
+   not enabled; see TIZ_LOG_SITE. */
+#define TIZ_LOGN(priority, hdl, format, args...)                         \
+  TIZ_LOG_SITE (priority, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, ##args);
+
+#define TIZ_ERROR(hdl, format, args...)                                  \
+  TIZ_LOG_SITE (TIZ_PRIORITY_ERROR, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
+                ##args);
+
+#define TIZ_WARN(hdl, format, args...)                                  \
+  TIZ_LOG_SITE (TIZ_PRIORITY_WARN, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
+                ##args);
+
+#define TIZ_NOTICE(hdl, format, args...)                                  \
+  TIZ_LOG_SITE (TIZ_PRIORITY_NOTICE, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
+                ##args);
+
+#define TIZ_DEBUG(hdl, format, args...)                                  \
+  TIZ_LOG_SITE (TIZ_PRIORITY_DEBUG, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
+                ##args);
+
+#define TIZ_TRACE(hdl, format, args...)                                  \
+  TIZ_LOG_SITE (TIZ_PRIORITY_TRACE, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
+                ##args);
 
 void
 tiz_clear_header (OMX_BUFFERHEADERTYPE * ap_hdr);
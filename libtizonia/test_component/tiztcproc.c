@@ -116,7 +116,8 @@ tcprc_buffers_ready (const void *ap_obj)
   if (OMX_ErrorNone == rc && p_hdr)
     {
       OMX_PTR p_eglimage = NULL;
-      tiz_check_omx (tiz_krn_claim_eglimage (p_krn, 0, p_hdr, &p_eglimage));
+      /* Only headers set up with UseEGLImage have an EGLImage to claim */
+      (void)tiz_krn_claim_eglimage (p_krn, 0, p_hdr, &p_eglimage);
       TIZ_PRINTF_DBG_MAG ("eglimage [%p]\n", p_eglimage);
       tiz_check_omx (tiztc_proc_render_buffer (p_hdr));
       if ((p_hdr->nFlags & OMX_BUFFERFLAG_EOS) != 0)
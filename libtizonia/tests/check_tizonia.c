@@ -35,6 +35,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <sys/time.h>
+#include <time.h>
 #include <check.h>
 #include <sys/types.h>
 #include <signal.h>
@@ -71,6 +72,16 @@ pid_t g_rmd_pid;
 /* duration of event timeout in msec when we don't expect event to be set */
 #define TIMEOUT_EXPECTING_FAILURE 2000
 
+#define MSG_POOL_TEST_MAX_BUFFERS 32
+#define MSG_POOL_TEST_WARMUP_ITERATIONS 100
+#define MSG_POOL_TEST_ITERATIONS 10000
+#define KRN_BENCH_BUFFERS 32
+#define KRN_BENCH_ROUNDS 500
+#define KRN_BENCH_CONFIG_CALLS 100000
+#define LOG_BENCH_ROUND_TRIPS 5000
+#define LOG_BENCH_STATEMENTS 1000000
+#define HANDOFF_TEST_ROUNDS 200
+
 typedef void *cc_ctx_t;
 typedef struct check_common_context check_common_context_t;
 struct check_common_context
@@ -82,6 +93,8 @@ struct check_common_context
   OMX_ERRORTYPE error;
   OMX_U32 port;
   OMX_BUFFERHEADERTYPE *p_hdr;
+  OMX_U32 ebd_count;
+  OMX_U32 flush_count;
 };
 
 static bool
@@ -206,6 +219,8 @@ _ctx_init (cc_ctx_t * app_ctx)
   p_ctx->error = OMX_ErrorMax;
   p_ctx->port = OMX_ALL;
   p_ctx->p_hdr = NULL;
+  p_ctx->ebd_count = 0;
+  p_ctx->flush_count = 0;
 
   * app_ctx = p_ctx;
 
@@ -326,6 +341,70 @@ _ctx_reset (cc_ctx_t * app_ctx)
   p_ctx->error = OMX_ErrorMax;
   p_ctx->port = OMX_ALL;
   p_ctx->p_hdr = NULL;
+  p_ctx->ebd_count = 0;
+  p_ctx->flush_count = 0;
+
+  tiz_mutex_unlock (&p_ctx->mutex);
+
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+_ctx_wait_ebds (cc_ctx_t * app_ctx, OMX_U32 a_count, OMX_U32 a_millis,
+                OMX_BOOL * ap_has_timedout)
+{
+  check_common_context_t *p_ctx = NULL;
+  assert (app_ctx);
+  p_ctx = * app_ctx;
+
+  * ap_has_timedout = OMX_FALSE;
+
+  if (tiz_mutex_lock (&p_ctx->mutex))
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  while (p_ctx->ebd_count < a_count)
+    {
+      if (OMX_ErrorNone != tiz_cond_timedwait (&p_ctx->cond,
+                                               &p_ctx->mutex, a_millis)
+          && p_ctx->ebd_count < a_count)
+        {
+          * ap_has_timedout = OMX_TRUE;
+          break;
+        }
+    }
+
+  tiz_mutex_unlock (&p_ctx->mutex);
+
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+_ctx_wait_flushes (cc_ctx_t * app_ctx, OMX_U32 a_count, OMX_U32 a_millis,
+                   OMX_BOOL * ap_has_timedout)
+{
+  check_common_context_t *p_ctx = NULL;
+  assert (app_ctx);
+  p_ctx = * app_ctx;
+
+  * ap_has_timedout = OMX_FALSE;
+
+  if (tiz_mutex_lock (&p_ctx->mutex))
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  while (p_ctx->flush_count < a_count)
+    {
+      if (OMX_ErrorNone != tiz_cond_timedwait (&p_ctx->cond,
+                                               &p_ctx->mutex, a_millis)
+          && p_ctx->flush_count < a_count)
+        {
+          * ap_has_timedout = OMX_TRUE;
+          break;
+        }
+    }
 
   tiz_mutex_unlock (&p_ctx->mutex);
 
@@ -381,6 +460,18 @@ check_EventHandler (OMX_HANDLETYPE ap_hdl,
           }
           break;
 
+        case OMX_CommandFlush:
+          {
+            TIZ_LOG (TIZ_PRIORITY_TRACE, "Port  [%d] flushed", nData2);
+            tiz_mutex_lock (&p_ctx->mutex);
+            p_ctx->port = (OMX_STATETYPE) (nData2);
+            p_ctx->error = (OMX_ERRORTYPE) (pEventData);
+            p_ctx->flush_count++;
+            tiz_mutex_unlock (&p_ctx->mutex);
+            _ctx_signal (pp_ctx);
+          }
+          break;
+
         default:
           {
             TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] received!!",
@@ -420,6 +511,10 @@ OMX_ERRORTYPE check_EmptyBufferDone
   pp_ctx = (cc_ctx_t *) ap_app_data;
   p_ctx = *pp_ctx;
 
+  tiz_mutex_lock (&p_ctx->mutex);
+  p_ctx->ebd_count++;
+  tiz_mutex_unlock (&p_ctx->mutex);
+
   p_ctx->p_hdr = ap_buf;
   _ctx_signal (pp_ctx);
 
@@ -905,6 +1000,559 @@ START_TEST (test_tizonia_move_to_exe_and_transfer_with_allocbuffer)
 }
 END_TEST
 
+START_TEST (test_tizonia_scheduler_msg_pool_steady_state)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  OMX_HANDLETYPE p_hdl = 0;
+  OMX_COMMANDTYPE cmd = OMX_CommandStateSet;
+  OMX_STATETYPE state = OMX_StateIdle;
+  cc_ctx_t ctx;
+  check_common_context_t *p_ctx = NULL;
+  OMX_BOOL timedout = OMX_FALSE;
+  OMX_PARAM_PORTDEFINITIONTYPE port_def;
+  OMX_BUFFERHEADERTYPE *p_hdrs[MSG_POOL_TEST_MAX_BUFFERS];
+  OMX_U64 pool_allocs = 0;
+  OMX_U64 heap_allocs_warm = 0;
+  OMX_U64 heap_allocs = 0;
+  OMX_U32 i;
+
+  error = _ctx_init (&ctx);
+  fail_if (OMX_ErrorNone != error);
+
+  p_ctx = (check_common_context_t *) (ctx);
+
+  error = OMX_Init ();
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_GetHandle (&p_hdl, COMPONENT_NAME, (OMX_PTR *) (&ctx),
+                         &_check_cbacks);
+  fail_if (OMX_ErrorNone != error);
+
+  port_def.nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+  port_def.nVersion.nVersion = OMX_VERSION;
+  port_def.nPortIndex = 0;
+  error = OMX_GetParameter (p_hdl, OMX_IndexParamPortDefinition, &port_def);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (port_def.nBufferCountActual > MSG_POOL_TEST_MAX_BUFFERS);
+
+  /* Loaded -> Idle */
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  for (i = 0; i < port_def.nBufferCountActual; ++i)
+    {
+      error = OMX_AllocateBuffer (p_hdl, &p_hdrs[i], 0, 0,
+                                  port_def.nBufferSize);
+      fail_if (OMX_ErrorNone != error);
+    }
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateIdle != p_ctx->state);
+
+  /* Idle -> Executing */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateExecuting;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateExecuting != p_ctx->state);
+
+  /* Exchange buffers for a while; once warmed up, no scheduler message must
+     come from the heap */
+  for (i = 0; i < MSG_POOL_TEST_ITERATIONS; ++i)
+    {
+      OMX_BUFFERHEADERTYPE *p_hdr
+        = p_hdrs[i % port_def.nBufferCountActual];
+      if (MSG_POOL_TEST_WARMUP_ITERATIONS == i)
+        {
+          tiz_comp_msg_pool_stats (p_hdl, NULL, &heap_allocs_warm);
+        }
+      error = _ctx_reset (&ctx);
+      p_hdr->nFilledLen = p_hdr->nAllocLen;
+      error = OMX_EmptyThisBuffer (p_hdl, p_hdr);
+      fail_if (OMX_ErrorNone != error);
+      error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+      fail_if (OMX_ErrorNone != error);
+      fail_if (OMX_TRUE == timedout);
+      fail_if (p_ctx->p_hdr != p_hdr);
+    }
+
+  tiz_comp_msg_pool_stats (p_hdl, &pool_allocs, &heap_allocs);
+  TIZ_LOG (TIZ_PRIORITY_TRACE,
+           "scheduler msg pool : pool allocs [%llu] heap allocs [%llu]",
+           (unsigned long long) pool_allocs, (unsigned long long) heap_allocs);
+  fail_if (heap_allocs != heap_allocs_warm);
+  fail_if (pool_allocs < MSG_POOL_TEST_ITERATIONS);
+
+  /* Executing -> Idle */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateIdle;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateIdle != p_ctx->state);
+
+  /* Idle -> Loaded */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateLoaded;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  for (i = 0; i < port_def.nBufferCountActual; ++i)
+    {
+      error = OMX_FreeBuffer (p_hdl, 0, p_hdrs[i]);
+      fail_if (OMX_ErrorNone != error);
+    }
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateLoaded != p_ctx->state);
+
+  error = OMX_FreeHandle (p_hdl);
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_Deinit ();
+  fail_if (OMX_ErrorNone != error);
+
+  _ctx_destroy(&ctx);
+}
+END_TEST
+
+START_TEST (test_tizonia_kernel_claim_release_throughput)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  OMX_HANDLETYPE p_hdl = 0;
+  OMX_COMMANDTYPE cmd = OMX_CommandStateSet;
+  OMX_STATETYPE state = OMX_StateIdle;
+  cc_ctx_t ctx;
+  check_common_context_t *p_ctx = NULL;
+  OMX_BOOL timedout = OMX_FALSE;
+  OMX_PARAM_PORTDEFINITIONTYPE port_def;
+  OMX_BUFFERHEADERTYPE *p_hdrs[KRN_BENCH_BUFFERS];
+  struct timespec start, end;
+  double secs = 0;
+  OMX_U32 i, j;
+
+  error = _ctx_init (&ctx);
+  fail_if (OMX_ErrorNone != error);
+
+  p_ctx = (check_common_context_t *) (ctx);
+
+  error = OMX_Init ();
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_GetHandle (&p_hdl, COMPONENT_NAME, (OMX_PTR *) (&ctx),
+                         &_check_cbacks);
+  fail_if (OMX_ErrorNone != error);
+
+  /* Use as many buffers as a typical video port would */
+  port_def.nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+  port_def.nVersion.nVersion = OMX_VERSION;
+  port_def.nPortIndex = 0;
+  error = OMX_GetParameter (p_hdl, OMX_IndexParamPortDefinition, &port_def);
+  fail_if (OMX_ErrorNone != error);
+  port_def.nBufferCountActual = KRN_BENCH_BUFFERS;
+  error = OMX_SetParameter (p_hdl, OMX_IndexParamPortDefinition, &port_def);
+  fail_if (OMX_ErrorNone != error);
+
+  /* Loaded -> Idle */
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  for (i = 0; i < KRN_BENCH_BUFFERS; ++i)
+    {
+      error = OMX_AllocateBuffer (p_hdl, &p_hdrs[i], 0, 0,
+                                  port_def.nBufferSize);
+      fail_if (OMX_ErrorNone != error);
+    }
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateIdle != p_ctx->state);
+
+  /* Idle -> Executing */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateExecuting;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateExecuting != p_ctx->state);
+
+  /* Keep every buffer queued in the kernel, so that each claim and release
+     happens with a full ingress or egress list */
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (i = 0; i < KRN_BENCH_ROUNDS; ++i)
+    {
+      error = _ctx_reset (&ctx);
+      for (j = 0; j < KRN_BENCH_BUFFERS; ++j)
+        {
+          p_hdrs[j]->nFilledLen = p_hdrs[j]->nAllocLen;
+          error = OMX_EmptyThisBuffer (p_hdl, p_hdrs[j]);
+          fail_if (OMX_ErrorNone != error);
+        }
+      error = _ctx_wait_ebds (&ctx, KRN_BENCH_BUFFERS,
+                              TIMEOUT_EXPECTING_SUCCESS, &timedout);
+      fail_if (OMX_ErrorNone != error);
+      fail_if (OMX_TRUE == timedout);
+    }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+
+  secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  fprintf (stderr,
+           "kernel claim/release: %d buffers x %d rounds in %.3f s "
+           "(%.0f cycles/s)\n",
+           KRN_BENCH_BUFFERS, KRN_BENCH_ROUNDS, secs,
+           (KRN_BENCH_BUFFERS * KRN_BENCH_ROUNDS) / secs);
+
+  /* Executing -> Idle */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateIdle;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateIdle != p_ctx->state);
+
+  /* Idle -> Loaded */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateLoaded;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  for (i = 0; i < KRN_BENCH_BUFFERS; ++i)
+    {
+      error = OMX_FreeBuffer (p_hdl, 0, p_hdrs[i]);
+      fail_if (OMX_ErrorNone != error);
+    }
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateLoaded != p_ctx->state);
+
+  error = OMX_FreeHandle (p_hdl);
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_Deinit ();
+  fail_if (OMX_ErrorNone != error);
+
+  _ctx_destroy(&ctx);
+}
+END_TEST
+
+START_TEST (test_tizonia_etb_round_trip_with_logging_disabled)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  OMX_HANDLETYPE p_hdl = 0;
+  OMX_COMMANDTYPE cmd = OMX_CommandStateSet;
+  OMX_STATETYPE state = OMX_StateIdle;
+  cc_ctx_t ctx;
+  check_common_context_t *p_ctx = NULL;
+  OMX_BOOL timedout = OMX_FALSE;
+  OMX_PARAM_PORTDEFINITIONTYPE port_def;
+  OMX_BUFFERHEADERTYPE *p_hdr = NULL;
+  tiz_log_site_t site = {NULL, 0, 0, 0};
+  struct timespec start, end;
+  double secs = 0;
+  OMX_U32 i;
+
+  error = _ctx_init (&ctx);
+  fail_if (OMX_ErrorNone != error);
+
+  p_ctx = (check_common_context_t *) (ctx);
+
+  error = OMX_Init ();
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_GetHandle (&p_hdl, COMPONENT_NAME, (OMX_PTR *) (&ctx),
+                         &_check_cbacks);
+  fail_if (OMX_ErrorNone != error);
+
+  port_def.nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+  port_def.nVersion.nVersion = OMX_VERSION;
+  port_def.nPortIndex = 0;
+  error = OMX_GetParameter (p_hdl, OMX_IndexParamPortDefinition, &port_def);
+  fail_if (OMX_ErrorNone != error);
+  port_def.nBufferCountActual = 1;
+  error = OMX_SetParameter (p_hdl, OMX_IndexParamPortDefinition, &port_def);
+  fail_if (OMX_ErrorNone != error);
+
+  /* Loaded -> Idle */
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  error = OMX_AllocateBuffer (p_hdl, &p_hdr, 0, 0, port_def.nBufferSize);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateIdle != p_ctx->state);
+
+  /* Idle -> Executing */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateExecuting;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateExecuting != p_ctx->state);
+
+  /* One buffer at a time, so that each iteration is a full trip through the
+     scheduler, the kernel and the processor, and their trace statements */
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (i = 0; i < LOG_BENCH_ROUND_TRIPS; ++i)
+    {
+      error = _ctx_reset (&ctx);
+      p_hdr->nFilledLen = p_hdr->nAllocLen;
+      error = OMX_EmptyThisBuffer (p_hdl, p_hdr);
+      fail_if (OMX_ErrorNone != error);
+      error = _ctx_wait_ebds (&ctx, 1, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+      fail_if (OMX_ErrorNone != error);
+      fail_if (OMX_TRUE == timedout);
+    }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+
+  secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  fprintf (stderr, "ETB round trip: %d trips in %.3f s (%.2f us/trip)\n",
+           LOG_BENCH_ROUND_TRIPS, secs, secs * 1e6 / LOG_BENCH_ROUND_TRIPS);
+
+  /* Compare the cost of a disabled trace statement, with and without the
+     call-site cache (a direct tiz_log call is what every statement used to
+     expand to) */
+  if (!tiz_log_site_is_enabled (&site, TIZ_LOG_CATEGORY_NAME,
+                                TIZ_PRIORITY_TRACE))
+    {
+      double uncached = 0;
+      clock_gettime (CLOCK_MONOTONIC, &start);
+      for (i = 0; i < LOG_BENCH_STATEMENTS; ++i)
+        {
+          tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME,
+                   TIZ_PRIORITY_TRACE, NULL, NULL, "[%s] trip [%u]",
+                   tiz_state_to_str (p_ctx->state), i);
+        }
+      clock_gettime (CLOCK_MONOTONIC, &end);
+      uncached
+        = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+      clock_gettime (CLOCK_MONOTONIC, &start);
+      for (i = 0; i < LOG_BENCH_STATEMENTS; ++i)
+        {
+          TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] trip [%u]",
+                   tiz_state_to_str (p_ctx->state), i);
+        }
+      clock_gettime (CLOCK_MONOTONIC, &end);
+      secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+      fprintf (stderr,
+               "disabled trace statement: %.1f ns uncached, %.1f ns cached\n",
+               uncached * 1e9 / LOG_BENCH_STATEMENTS,
+               secs * 1e9 / LOG_BENCH_STATEMENTS);
+    }
+
+  /* Executing -> Idle */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateIdle;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateIdle != p_ctx->state);
+
+  /* Idle -> Loaded */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateLoaded;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  error = OMX_FreeBuffer (p_hdl, 0, p_hdr);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateLoaded != p_ctx->state);
+
+  error = OMX_FreeHandle (p_hdl);
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_Deinit ();
+  fail_if (OMX_ErrorNone != error);
+
+  _ctx_destroy(&ctx);
+}
+END_TEST
+
+START_TEST (test_tizonia_kernel_setconfig_throughput)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  OMX_HANDLETYPE p_hdl = 0;
+  OMX_U32 appData;
+  OMX_CALLBACKTYPE callBacks;
+  OMX_AUDIO_CONFIG_VOLUMETYPE volume;
+  struct timespec start, end;
+  double secs = 0;
+  OMX_U32 i;
+
+  error = OMX_Init ();
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_GetHandle (&p_hdl,
+                         COMPONENT_NAME, (OMX_PTR *) (&appData), &callBacks);
+  fail_if (OMX_ErrorNone != error);
+
+  /* The volume index is managed by the pcm port, so every call goes past the
+     config port's (much larger) index set before reaching port 0 */
+  volume.nSize = sizeof (OMX_AUDIO_CONFIG_VOLUMETYPE);
+  volume.nVersion.nVersion = OMX_VERSION;
+  volume.nPortIndex = 0;
+  error = OMX_GetConfig (p_hdl, OMX_IndexConfigAudioVolume, &volume);
+  fail_if (OMX_ErrorNone != error);
+
+  /* SetConfig is posted to the component without waiting for it to complete;
+     GetConfig goes through the same port lookup and returns the result */
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (i = 0; i < KRN_BENCH_CONFIG_CALLS; ++i)
+    {
+      error = OMX_GetConfig (p_hdl, OMX_IndexConfigAudioVolume, &volume);
+      fail_if (OMX_ErrorNone != error);
+    }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+
+  secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  fprintf (stderr,
+           "kernel GetConfig: %d calls in %.3f s (%.0f calls/s)\n",
+           KRN_BENCH_CONFIG_CALLS, secs, KRN_BENCH_CONFIG_CALLS / secs);
+
+  /* An index that no port manages must still be rejected */
+  error = OMX_GetConfig (p_hdl, OMX_IndexConfigVideoBitrate, &volume);
+  fail_if (OMX_ErrorUnsupportedIndex != error);
+
+  error = OMX_FreeHandle (p_hdl);
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_Deinit ();
+  fail_if (OMX_ErrorNone != error);
+}
+END_TEST
+
+START_TEST (test_tizonia_buffer_handoff_with_flush_pending)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  OMX_HANDLETYPE p_hdl = 0;
+  OMX_COMMANDTYPE cmd = OMX_CommandStateSet;
+  OMX_STATETYPE state = OMX_StateIdle;
+  cc_ctx_t ctx;
+  check_common_context_t *p_ctx = NULL;
+  OMX_BOOL timedout = OMX_FALSE;
+  OMX_PARAM_PORTDEFINITIONTYPE port_def;
+  OMX_BUFFERHEADERTYPE *p_hdr = NULL;
+  OMX_U32 i;
+
+  error = _ctx_init (&ctx);
+  fail_if (OMX_ErrorNone != error);
+
+  p_ctx = (check_common_context_t *) (ctx);
+
+  error = OMX_Init ();
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_GetHandle (&p_hdl, COMPONENT_NAME, (OMX_PTR *) (&ctx),
+                         &_check_cbacks);
+  fail_if (OMX_ErrorNone != error);
+
+  port_def.nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+  port_def.nVersion.nVersion = OMX_VERSION;
+  port_def.nPortIndex = 0;
+  error = OMX_GetParameter (p_hdl, OMX_IndexParamPortDefinition, &port_def);
+  fail_if (OMX_ErrorNone != error);
+  port_def.nBufferCountActual = 1;
+  error = OMX_SetParameter (p_hdl, OMX_IndexParamPortDefinition, &port_def);
+  fail_if (OMX_ErrorNone != error);
+
+  /* Loaded -> Idle */
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  error = OMX_AllocateBuffer (p_hdl, &p_hdr, 0, 0, port_def.nBufferSize);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateIdle != p_ctx->state);
+
+  /* Idle -> Executing */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateExecuting;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateExecuting != p_ctx->state);
+
+  /* Hand the header over right after a flush has been queued. Whichever
+     order the component sees them in, the header must come back exactly
+     once and the flush must complete. */
+  for (i = 0; i < HANDOFF_TEST_ROUNDS; ++i)
+    {
+      error = _ctx_reset (&ctx);
+      p_hdr->nFilledLen = p_hdr->nAllocLen;
+      error = OMX_SendCommand (p_hdl, OMX_CommandFlush, 0, NULL);
+      fail_if (OMX_ErrorNone != error);
+      error = tiz_comp_buffer_handoff (p_hdl, p_hdr, OMX_FALSE);
+      /* The test config file enables the handoffs */
+      fail_if (OMX_ErrorNone != error);
+      error = _ctx_wait_flushes (&ctx, 1, TIMEOUT_EXPECTING_SUCCESS,
+                                 &timedout);
+      fail_if (OMX_ErrorNone != error);
+      fail_if (OMX_TRUE == timedout);
+      fail_if (0 != p_ctx->port);
+      fail_if (OMX_ErrorNone != p_ctx->error);
+      error = _ctx_wait_ebds (&ctx, 1, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+      fail_if (OMX_ErrorNone != error);
+      fail_if (OMX_TRUE == timedout);
+      fail_if (p_ctx->p_hdr != p_hdr);
+      fail_if (1 != p_ctx->ebd_count);
+    }
+
+  /* Nothing else may come back */
+  error = _ctx_wait_ebds (&ctx, 2, TIMEOUT_EXPECTING_FAILURE, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_FALSE == timedout);
+
+  /* Executing -> Idle */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateIdle;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateIdle != p_ctx->state);
+
+  /* Idle -> Loaded */
+  error = _ctx_reset (&ctx);
+  state = OMX_StateLoaded;
+  error = OMX_SendCommand (p_hdl, cmd, state, NULL);
+  fail_if (OMX_ErrorNone != error);
+  error = OMX_FreeBuffer (p_hdl, 0, p_hdr);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (OMX_StateLoaded != p_ctx->state);
+
+  error = OMX_FreeHandle (p_hdl);
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_Deinit ();
+  fail_if (OMX_ErrorNone != error);
+
+  _ctx_destroy(&ctx);
+}
+END_TEST
+
 START_TEST (test_tizonia_command_cancellation_loaded_to_idle_no_buffers)
 {
   OMX_ERRORTYPE error = OMX_ErrorNone;
@@ -2051,6 +2699,11 @@ tiz_suite (void)
   tcase_add_test (tc_tizonia, test_tizonia_getparameter);
   tcase_add_test (tc_tizonia, test_tizonia_roles);
   tcase_add_test (tc_tizonia, test_tizonia_preannouncements_extension);
+  tcase_add_test (tc_tizonia, test_tizonia_scheduler_msg_pool_steady_state);
+  tcase_add_test (tc_tizonia, test_tizonia_kernel_claim_release_throughput);
+  tcase_add_test (tc_tizonia, test_tizonia_kernel_setconfig_throughput);
+  tcase_add_test (tc_tizonia, test_tizonia_etb_round_trip_with_logging_disabled);
+  tcase_add_test (tc_tizonia, test_tizonia_buffer_handoff_with_flush_pending);
   /* TEST DISABLED */
 /*   tcase_add_test (tc_tizonia, */
 /*                   test_tizonia_move_to_exe_and_transfer_with_allocbuffer); */
@@ -31,9 +31,13 @@
 #endif
 
 #include <assert.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 
 #include "tizmem.h"
 #include "tizlog.h"
@@ -45,6 +49,10 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.platform.buffer"
 #endif
 
+/* In ring mode, a store that has grown beyond this many times its original
+   size is shrunk back when it becomes empty */
+#define RING_SHRINK_FACTOR 4
+
 struct tiz_buffer
 {
   unsigned char * p_store;
@@ -52,6 +60,7 @@ struct tiz_buffer
   int filled_len;
   int offset;
   int seek_mode;
+  int ring_min_len;
 };
 
 static long
@@ -61,6 +70,136 @@ abs_of (const long v)
   return (v + mask) ^ mask;
 }
 
+static inline bool
+is_ring (const tiz_buffer_t * ap_buf)
+{
+  return (TIZ_BUFFER_RING == ap_buf->seek_mode);
+}
+
+static inline bool
+is_consistent (const tiz_buffer_t * ap_buf)
+{
+  return is_ring (ap_buf)
+           ? (ap_buf->filled_len <= ap_buf->alloc_len
+              && (0 == ap_buf->alloc_len || ap_buf->offset < ap_buf->alloc_len))
+           : (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
+}
+
+static size_t
+ring_size (const size_t a_nbytes)
+{
+  const size_t page_sz = sysconf (_SC_PAGESIZE);
+  const size_t nbytes = a_nbytes > 0 ? a_nbytes : page_sz;
+  return ((nbytes + page_sz - 1) / page_sz) * page_sz;
+}
+
+/* Map a_len bytes of memory twice in a row, so that the store wraps around
+   transparently */
+static unsigned char *
+ring_map (const size_t a_len)
+{
+  unsigned char * p_base = NULL;
+#if defined(SYS_memfd_create)
+  int fd = syscall (SYS_memfd_create, "tizbuffer", 0);
+  if (fd >= 0)
+    {
+      if (0 == ftruncate (fd, a_len))
+        {
+          unsigned char * p_area
+            = mmap (NULL, 2 * a_len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1, 0);
+          if (MAP_FAILED != p_area)
+            {
+              if (MAP_FAILED != mmap (p_area, a_len, PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_FIXED, fd, 0)
+                  && MAP_FAILED
+                       != mmap (p_area + a_len, a_len, PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_FIXED, fd, 0))
+                {
+                  p_base = p_area;
+                }
+              else
+                {
+                  (void) munmap (p_area, 2 * a_len);
+                }
+            }
+        }
+      (void) close (fd);
+    }
+#else
+  (void) a_len;
+#endif
+  if (!p_base)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "Unable to map a ring of [%zu] bytes",
+               a_len);
+    }
+  return p_base;
+}
+
+static inline void
+ring_unmap (unsigned char * ap_base, const size_t a_len)
+{
+  if (ap_base)
+    {
+      (void) munmap (ap_base, 2 * a_len);
+    }
+}
+
+/* Move the data available into a new store. Any data behind the current
+   position is discarded. */
+static int
+relocate_data_store (tiz_buffer_t * ap_buf, const int a_seek_mode,
+                     const size_t a_nbytes)
+{
+  const bool to_ring = (TIZ_BUFFER_RING == a_seek_mode);
+  const size_t len = to_ring ? ring_size (a_nbytes) : a_nbytes;
+  unsigned char * p_new_store = NULL;
+
+  assert (ap_buf);
+  assert (len >= (size_t) ap_buf->filled_len);
+
+  p_new_store = to_ring ? ring_map (len) : tiz_mem_calloc (1, len);
+  if (!p_new_store)
+    {
+      return -1;
+    }
+
+  if (ap_buf->filled_len > 0)
+    {
+      memcpy (p_new_store, ap_buf->p_store + ap_buf->offset,
+              ap_buf->filled_len);
+    }
+
+  if (is_ring (ap_buf))
+    {
+      ring_unmap (ap_buf->p_store, ap_buf->alloc_len);
+    }
+  else
+    {
+      tiz_mem_free (ap_buf->p_store);
+    }
+
+  ap_buf->p_store = p_new_store;
+  ap_buf->alloc_len = len;
+  ap_buf->offset = 0;
+  ap_buf->seek_mode = a_seek_mode;
+  return 0;
+}
+
+static inline void
+ring_maybe_shrink (tiz_buffer_t * ap_buf)
+{
+  assert (ap_buf);
+  if (is_ring (ap_buf) && 0 == ap_buf->filled_len
+      && ap_buf->alloc_len > RING_SHRINK_FACTOR * ap_buf->ring_min_len)
+    {
+      /* If this fails, the larger ring is simply kept */
+      (void) relocate_data_store (ap_buf, TIZ_BUFFER_RING,
+                                  ap_buf->ring_min_len);
+    }
+}
+
 static inline void *
 alloc_data_store (tiz_buffer_t * ap_buf, const size_t nbytes)
 {
@@ -89,7 +228,14 @@ dealloc_data_store (
 {
   if (ap_buf)
     {
-      tiz_mem_free (ap_buf->p_store);
+      if (is_ring (ap_buf))
+        {
+          ring_unmap (ap_buf->p_store, ap_buf->alloc_len);
+        }
+      else
+        {
+          tiz_mem_free (ap_buf->p_store);
+        }
       ap_buf->p_store = NULL;
       ap_buf->alloc_len = 0;
       ap_buf->filled_len = 0;
@@ -150,10 +296,26 @@ tiz_buffer_seek_mode (tiz_buffer_t * ap_buf, const int a_seek_mode)
 {
   int old_val = -1;
   if (a_seek_mode == TIZ_BUFFER_SEEKABLE
-      || a_seek_mode == TIZ_BUFFER_NON_SEEKABLE)
+      || a_seek_mode == TIZ_BUFFER_NON_SEEKABLE
+      || a_seek_mode == TIZ_BUFFER_RING)
     {
       assert (ap_buf);
       old_val = ap_buf->seek_mode;
+      if (TIZ_BUFFER_RING == a_seek_mode && !is_ring (ap_buf))
+        {
+          if (relocate_data_store (ap_buf, a_seek_mode, ap_buf->alloc_len))
+            {
+              return -1;
+            }
+          ap_buf->ring_min_len = ap_buf->alloc_len;
+        }
+      else if (TIZ_BUFFER_RING != a_seek_mode && is_ring (ap_buf))
+        {
+          if (relocate_data_store (ap_buf, a_seek_mode, ap_buf->alloc_len))
+            {
+              return -1;
+            }
+        }
       ap_buf->seek_mode = a_seek_mode;
     }
   return old_val;
@@ -166,9 +328,18 @@ tiz_buffer_push (tiz_buffer_t * ap_buf, const void * ap_data,
   OMX_U32 nbytes_to_copy = 0;
 
   assert (ap_buf);
-  assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
+  assert (is_consistent (ap_buf));
 
-  if (ap_data && a_nbytes > 0)
+  if (ap_data && a_nbytes > 0 && is_ring (ap_buf))
+    {
+      void * p_dst = tiz_buffer_reserve (ap_buf, a_nbytes);
+      if (p_dst)
+        {
+          memcpy (p_dst, ap_data, a_nbytes);
+          nbytes_to_copy = tiz_buffer_commit (ap_buf, a_nbytes);
+        }
+    }
+  else if (ap_data && a_nbytes > 0)
     {
       size_t avail = 0;
 
@@ -202,11 +373,104 @@ tiz_buffer_push (tiz_buffer_t * ap_buf, const void * ap_data,
   return nbytes_to_copy;
 }
 
+void *
+tiz_buffer_reserve (tiz_buffer_t * ap_buf, const size_t a_nbytes)
+{
+  size_t avail = 0;
+  size_t need = 0;
+
+  assert (ap_buf);
+  assert (is_consistent (ap_buf));
+
+  if (is_ring (ap_buf))
+    {
+      int wpos = 0;
+      avail = ap_buf->alloc_len - ap_buf->filled_len;
+      if (a_nbytes > avail)
+        {
+          need = ap_buf->alloc_len;
+          while (need - ap_buf->filled_len < a_nbytes)
+            {
+              need *= 2;
+            }
+          if (relocate_data_store (ap_buf, TIZ_BUFFER_RING, need))
+            {
+              return NULL;
+            }
+        }
+      wpos = ap_buf->offset + ap_buf->filled_len;
+      if (wpos >= ap_buf->alloc_len)
+        {
+          wpos -= ap_buf->alloc_len;
+        }
+      return ap_buf->p_store + wpos;
+    }
+
+  avail = ap_buf->alloc_len - (ap_buf->offset + ap_buf->filled_len);
+  if (a_nbytes > avail && ap_buf->seek_mode == TIZ_BUFFER_NON_SEEKABLE
+      && ap_buf->offset > 0)
+    {
+      memmove (ap_buf->p_store, (ap_buf->p_store + ap_buf->offset),
+               ap_buf->filled_len);
+      ap_buf->offset = 0;
+      avail = ap_buf->alloc_len - ap_buf->filled_len;
+    }
+
+  if (a_nbytes > avail)
+    {
+      OMX_U8 * p_new_store = NULL;
+      need = MAX (ap_buf->alloc_len, 1);
+      while (need - (ap_buf->offset + ap_buf->filled_len) < a_nbytes)
+        {
+          need *= 2;
+        }
+      if (!(p_new_store = tiz_mem_realloc (ap_buf->p_store, need)))
+        {
+          return NULL;
+        }
+      ap_buf->p_store = p_new_store;
+      ap_buf->alloc_len = need;
+    }
+
+  return ap_buf->p_store + ap_buf->offset + ap_buf->filled_len;
+}
+
+int
+tiz_buffer_commit (tiz_buffer_t * ap_buf, const size_t a_nbytes)
+{
+  size_t avail = 0;
+  int nbytes = 0;
+
+  assert (ap_buf);
+
+  avail = is_ring (ap_buf)
+            ? ap_buf->alloc_len - ap_buf->filled_len
+            : ap_buf->alloc_len - (ap_buf->offset + ap_buf->filled_len);
+  nbytes = MIN (avail, a_nbytes);
+  ap_buf->filled_len += nbytes;
+  return nbytes;
+}
+
+void *
+tiz_buffer_peek (const tiz_buffer_t * ap_buf, size_t * ap_nbytes)
+{
+  assert (ap_buf);
+  assert (ap_nbytes);
+  *ap_nbytes = ap_buf->filled_len;
+  return (ap_buf->p_store + ap_buf->offset);
+}
+
+int
+tiz_buffer_consume (tiz_buffer_t * ap_buf, const size_t a_nbytes)
+{
+  return tiz_buffer_advance (ap_buf, MIN (a_nbytes, INT_MAX));
+}
+
 int
 tiz_buffer_available (const tiz_buffer_t * ap_buf)
 {
   assert (ap_buf);
-  assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
+  assert (is_consistent (ap_buf));
   return ap_buf->filled_len;
 }
 
@@ -214,7 +478,7 @@ int
 tiz_buffer_offset (const tiz_buffer_t * ap_buf)
 {
   assert (ap_buf);
-  assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
+  assert (is_consistent (ap_buf));
   return ap_buf->offset;
 }
 
@@ -222,7 +486,7 @@ void *
 tiz_buffer_get (const tiz_buffer_t * ap_buf)
 {
   assert (ap_buf);
-  assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
+  assert (is_consistent (ap_buf));
   return (ap_buf->p_store + ap_buf->offset);
 }
 
@@ -236,6 +500,18 @@ tiz_buffer_advance (tiz_buffer_t * ap_buf, const int nbytes)
       min_nbytes = MIN (nbytes, tiz_buffer_available (ap_buf));
       ap_buf->offset += min_nbytes;
       ap_buf->filled_len -= min_nbytes;
+      if (is_ring (ap_buf))
+        {
+          if (ap_buf->offset >= ap_buf->alloc_len)
+            {
+              ap_buf->offset -= ap_buf->alloc_len;
+            }
+          if (0 == ap_buf->filled_len)
+            {
+              ap_buf->offset = 0;
+              ring_maybe_shrink (ap_buf);
+            }
+        }
     }
   return min_nbytes;
 }
@@ -245,7 +521,27 @@ tiz_buffer_seek (tiz_buffer_t * ap_buf, const long offset, const int whence)
 {
   int rc = -1;
   assert (ap_buf);
-  assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
+  assert (is_consistent (ap_buf));
+
+  if (is_ring (ap_buf))
+    {
+      /* Data behind the current position is gone; only seek forward */
+      if (whence == TIZ_BUFFER_SEEK_CUR && offset >= 0)
+        {
+          (void) tiz_buffer_advance (ap_buf, MIN (offset, INT_MAX));
+          rc = 0;
+        }
+      else if (whence == TIZ_BUFFER_SEEK_END && offset <= 0)
+        {
+          unsigned int r = abs_of (offset);
+          if (r < (unsigned int) ap_buf->filled_len)
+            {
+              (void) tiz_buffer_advance (ap_buf, ap_buf->filled_len - r);
+            }
+          rc = 0;
+        }
+      return rc;
+    }
 
   int total = ap_buf->offset + ap_buf->filled_len;
   if (whence == TIZ_BUFFER_SEEK_SET)
@@ -277,7 +573,7 @@ tiz_buffer_seek (tiz_buffer_t * ap_buf, const long offset, const int whence)
       ap_buf->filled_len = total - ap_buf->offset;
     }
   assert (total == ap_buf->offset + ap_buf->filled_len);
-  assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
+  assert (is_consistent (ap_buf));
 
   return rc;
 }
@@ -289,5 +585,6 @@ tiz_buffer_clear (tiz_buffer_t * ap_buf)
     {
       ap_buf->offset = 0;
       ap_buf->filled_len = 0;
+      ring_maybe_shrink (ap_buf);
     }
 }
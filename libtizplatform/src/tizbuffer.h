@@ -52,6 +52,12 @@ extern "C" {
 #define TIZ_BUFFER_SEEKABLE \
   1 /** Data pushed on to the buffer is only discarded explicitely when
         'tiz_clear_buffer' is used. */
+#define TIZ_BUFFER_RING \
+  2 /** The data store is a ring mapped twice in a row in virtual memory, so
+        that data is never moved on push and any span of available data or
+        free space is contiguous. Like TIZ_BUFFER_NON_SEEKABLE, data behind
+        the current position is discarded. Only forward seeks are
+        supported. */
 
 /* The possibilities for the third argument to 'tiz_buffer_seek'.
    These values should not be changed.  */
@@ -89,11 +95,16 @@ tiz_buffer_destroy (tiz_buffer_t * ap_buf);
 /**
  * Set a new overwrite mode.
  *
+ * Switching in or out of TIZ_BUFFER_RING mode relocates the data currently
+ * available into a new data store.
+ *
  * @ingroup tizbuffer
  * @param ap_buf The dynamic buffer handle.
- * @param a_seek_mode TIZ_BUFFER_NON_SEEKABLE (default) or
- * TIZ_BUFFER_SEEKABLE.
- * @return The old seek mode, or -1 on error.
+ * @param a_seek_mode TIZ_BUFFER_NON_SEEKABLE (default), TIZ_BUFFER_SEEKABLE
+ * or TIZ_BUFFER_RING.
+ * @return The old seek mode, or -1 on error (e.g. the platform does not
+ * support the mirrored mapping needed by TIZ_BUFFER_RING; the buffer is left
+ * untouched in that case).
  */
 int
 tiz_buffer_seek_mode (tiz_buffer_t * ap_buf, const int a_seek_mode);
@@ -111,6 +122,60 @@ int
 tiz_buffer_push (tiz_buffer_t * ap_buf, const void * ap_data,
                  const size_t a_nbytes);
 
+/**
+ * @brief Obtain a contiguous span of free space at the back of the buffer.
+ *
+ * This lets producers write directly into the data store. The data written
+ * becomes available after a call to tiz_buffer_commit. The pointer returned
+ * is valid until the next operation that modifies the buffer.
+ *
+ * @ingroup tizbuffer
+ * @param ap_buf The dynamic buffer handle.
+ * @param a_nbytes The minimum number of bytes of free space needed.
+ * @return A pointer to the free space, or NULL if the data store could not be
+ * grown.
+ */
+void *
+tiz_buffer_reserve (tiz_buffer_t * ap_buf, const size_t a_nbytes);
+
+/**
+ * @brief Make available data written into space obtained with
+ * tiz_buffer_reserve.
+ *
+ * @ingroup tizbuffer
+ * @param ap_buf The dynamic buffer handle.
+ * @param a_nbytes The number of bytes written.
+ * @return The number of bytes actually committed.
+ */
+int
+tiz_buffer_commit (tiz_buffer_t * ap_buf, const size_t a_nbytes);
+
+/**
+ * @brief Retrieve the contiguous span of data available at the current
+ * position, without consuming it.
+ *
+ * @ingroup tizbuffer
+ * @param ap_buf The dynamic buffer handle.
+ * @param ap_nbytes On return, the number of bytes in the span.
+ * @return The pointer to the current position in the buffer.
+ */
+void *
+tiz_buffer_peek (const tiz_buffer_t * ap_buf, size_t * ap_nbytes);
+
+/**
+ * @brief Discard data from the current position.
+ *
+ * In TIZ_BUFFER_RING mode, a data store that has grown well beyond its
+ * original size is shrunk back once all the data has been consumed.
+ *
+ * @ingroup tizbuffer
+ * @param ap_buf The dynamic buffer handle.
+ * @param a_nbytes The number of bytes to discard.
+ * @return The number of bytes actually discarded.
+ */
+int
+tiz_buffer_consume (tiz_buffer_t * ap_buf, const size_t a_nbytes);
+
 /**
  * @brief Reset the position marker.
  *
@@ -66,10 +66,19 @@
 #endif
 
 #define TIZ_EVENT_LOOP_THREAD_NAME "evloop"
+#define TIZ_EVENT_LOOP_RCFILE_SHARDS_KEY "event-loop.shards"
+#define TIZ_EVENT_LOOP_MAX_SHARDS 16
+#define TIZ_EVENT_LOOP_MAX_PINS 64
+/* Upper bound of the first timer jitter bucket, in microseconds; each of the
+   following buckets doubles the previous one */
+#define TIZ_EVENT_LOOP_JITTER_BASE_US 100.0
+
+typedef struct tiz_event_loop tiz_event_loop_t;
 
 struct tiz_event_io
 {
   ev_io io;
+  tiz_event_loop_t * p_lp; /* The shard that runs this watcher */
   tiz_event_io_cb_f pf_cback;
   void * p_arg0;
   void * p_arg1;
@@ -82,17 +91,22 @@ struct tiz_event_io
 struct tiz_event_timer
 {
   ev_timer timer;
+  tiz_event_loop_t * p_lp;
   tiz_event_timer_cb_f pf_cback;
   void * p_arg0;
   void * p_arg1;
   bool once;
   uint32_t id;
   bool started;
+  double after;
+  double repeat;
+  double expected; /* When the timer is due to fire next */
 };
 
 struct tiz_event_stat
 {
   ev_stat stat;
+  tiz_event_loop_t * p_lp;
   tiz_event_stat_cb_f pf_cback;
   void * p_arg0;
   void * p_arg1;
@@ -110,9 +124,9 @@ enum tiz_event_loop_state
   ETIZEventLoopStateStopped
 };
 
-typedef struct tiz_event_loop tiz_event_loop_t;
 struct tiz_event_loop
 {
+  OMX_U32 index;
   tiz_thread_t thread;
   tiz_mutex_t mutex;
   tiz_sem_t sem;
@@ -122,11 +136,31 @@ struct tiz_event_loop
   struct ev_loop * p_loop;
   tiz_event_loop_state_t state;
   tiz_rcfile_t * p_rcfile;
+  tiz_event_loop_jitter_t jitter;
 };
 
+typedef struct tiz_event_loop_pin tiz_event_loop_pin_t;
+struct tiz_event_loop_pin
+{
+  const void * p_arg0;
+  OMX_U32 shard;
+};
+
+/* The first shard; it is also the owner of the rc file */
 static pthread_once_t g_event_loop_once = PTHREAD_ONCE_INIT;
 static tiz_event_loop_t * gp_event_loop = NULL;
 
+/* The rest of the shards are only created once the rc file is available */
+static pthread_once_t g_event_shards_once = PTHREAD_ONCE_INIT;
+static tiz_event_loop_t * gp_event_shards[TIZ_EVENT_LOOP_MAX_SHARDS];
+static OMX_U32 g_event_nshards = 1;
+
+static pthread_mutex_t g_event_pins_mutex = PTHREAD_MUTEX_INITIALIZER;
+static tiz_event_loop_pin_t g_event_pins[TIZ_EVENT_LOOP_MAX_PINS];
+
+/* The shard that owns the current thread, if any */
+static __thread tiz_event_loop_t * tl_p_event_loop = NULL;
+
 typedef enum tiz_event_loop_msg_class tiz_event_loop_msg_class_t;
 enum tiz_event_loop_msg_class
 {
@@ -182,28 +216,28 @@ struct tiz_event_loop_msg
 
 /* Forward declarations */
 static OMX_ERRORTYPE
-do_io_start (tiz_event_loop_msg_t *);
+do_io_start (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_io_stop (tiz_event_loop_msg_t *);
+do_io_stop (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_io_destroy (tiz_event_loop_msg_t *);
+do_io_destroy (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_timer_start (tiz_event_loop_msg_t *);
+do_timer_start (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_timer_restart (tiz_event_loop_msg_t *);
+do_timer_restart (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_timer_stop (tiz_event_loop_msg_t *);
+do_timer_stop (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_timer_destroy (tiz_event_loop_msg_t *);
+do_timer_destroy (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_stat_start (tiz_event_loop_msg_t *);
+do_stat_start (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_stat_stop (tiz_event_loop_msg_t *);
+do_stat_stop (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_stat_destroy (tiz_event_loop_msg_t *);
+do_stat_destroy (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 
 typedef OMX_ERRORTYPE (*tiz_event_loop_msg_dispatch_f) (
-  tiz_event_loop_msg_t * ap_msg);
+  tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg);
 static const tiz_event_loop_msg_dispatch_f tiz_event_loop_msg_to_fnt_tbl[] = {
   do_io_start,
   do_io_stop,
@@ -221,7 +255,7 @@ static const tiz_event_loop_msg_dispatch_f tiz_event_loop_msg_to_fnt_tbl[] = {
 };
 
 static void
-dispatch_msg (tiz_event_loop_msg_t * ap_msg);
+dispatch_msg (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg);
 
 typedef struct tiz_event_loop_msg_str tiz_event_loop_msg_str_t;
 struct tiz_event_loop_msg_str
@@ -327,33 +361,55 @@ init_event_loop_msg (tiz_event_loop_t * ap_event_loop,
 /*@end@*/
 /* NOTE: Stop ignoring splint warnings in this section  */
 
+/* Called with the shard's mutex held. When the request comes from the shard's
+   own thread (i.e. from one of its watcher callbacks), the message is
+   processed right away instead of being queued */
+static OMX_ERRORTYPE
+send_msg (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
+{
+  assert (ap_lp);
+  assert (ap_msg);
+
+  if (tl_p_event_loop == ap_lp)
+    {
+      dispatch_msg (ap_lp, ap_msg);
+      tiz_soa_free (ap_lp->p_soa, ap_msg);
+      return OMX_ErrorNone;
+    }
+
+  tiz_check_omx (tiz_pqueue_send (ap_lp->p_pq, ap_msg, ap_msg->priority));
+  ev_async_send (ap_lp->p_loop, ap_lp->p_async_watcher);
+  return OMX_ErrorNone;
+}
+
 static OMX_ERRORTYPE
 enqueue_io_msg (tiz_event_io_t * ap_ev_io, const uint32_t a_id,
                 const tiz_event_loop_msg_class_t a_class)
 {
   OMX_ERRORTYPE rc = OMX_ErrorUndefined;
+  tiz_event_loop_t * p_lp = NULL;
   tiz_event_loop_msg_t * p_msg = NULL;
   tiz_event_loop_msg_io_t * p_msg_io = NULL;
 
   assert (ap_ev_io);
+  assert (ap_ev_io->p_lp);
   assert (ETIZEventLoopMsgIoStart == a_class
           || ETIZEventLoopMsgIoStop == a_class
           || ETIZEventLoopMsgIoDestroy == a_class);
 
-  tiz_check_omx (tiz_mutex_lock (&(gp_event_loop->mutex)));
+  p_lp = ap_ev_io->p_lp;
+  tiz_check_omx (tiz_mutex_lock (&(p_lp->mutex)));
   tiz_goto_end_on_null (
-    (p_msg = init_event_loop_msg (gp_event_loop, (a_class))),
+    (p_msg = init_event_loop_msg (p_lp, (a_class))),
     "Failed to initialise the event loop");
 
   assert (p_msg);
   p_msg_io = &(p_msg->io);
   p_msg_io->p_ev_io = ap_ev_io;
   p_msg_io->id = a_id;
-  tiz_goto_end_on_omx_err (
-    (rc = tiz_pqueue_send (gp_event_loop->p_pq, p_msg, p_msg->priority)),
-    "Failed to insert into the queue");
-  tiz_check_omx (tiz_mutex_unlock (&(gp_event_loop->mutex)));
-  ev_async_send (gp_event_loop->p_loop, gp_event_loop->p_async_watcher);
+  tiz_goto_end_on_omx_err ((rc = send_msg (p_lp, p_msg)),
+                           "Failed to deliver the message");
+  tiz_check_omx (tiz_mutex_unlock (&(p_lp->mutex)));
 
   /* All good */
   rc = OMX_ErrorNone;
@@ -362,7 +418,7 @@ enqueue_io_msg (tiz_event_io_t * ap_ev_io, const uint32_t a_id,
 
   if (OMX_ErrorNone != rc)
     {
-      tiz_check_omx (tiz_mutex_unlock (&(gp_event_loop->mutex)));
+      tiz_check_omx (tiz_mutex_unlock (&(p_lp->mutex)));
     }
 
   return OMX_ErrorNone;
@@ -373,29 +429,30 @@ enqueue_timer_msg (tiz_event_timer_t * ap_ev_timer, const uint32_t a_id,
                    const tiz_event_loop_msg_class_t a_class)
 {
   OMX_ERRORTYPE rc = OMX_ErrorUndefined;
+  tiz_event_loop_t * p_lp = NULL;
   tiz_event_loop_msg_t * p_msg = NULL;
   tiz_event_loop_msg_timer_t * p_msg_timer = NULL;
 
   assert (ap_ev_timer);
+  assert (ap_ev_timer->p_lp);
   assert (ETIZEventLoopMsgTimerStart == a_class
           || ETIZEventLoopMsgTimerStop == a_class
           || ETIZEventLoopMsgTimerRestart == a_class
           || ETIZEventLoopMsgTimerDestroy == a_class);
 
-  tiz_check_omx (tiz_mutex_lock (&(gp_event_loop->mutex)));
+  p_lp = ap_ev_timer->p_lp;
+  tiz_check_omx (tiz_mutex_lock (&(p_lp->mutex)));
   tiz_goto_end_on_null (
-    (p_msg = init_event_loop_msg (gp_event_loop, (a_class))),
+    (p_msg = init_event_loop_msg (p_lp, (a_class))),
     "Failed to initialise the event loop");
 
   assert (p_msg);
   p_msg_timer = &(p_msg->timer);
   p_msg_timer->p_ev_timer = ap_ev_timer;
   p_msg_timer->id = a_id;
-  tiz_goto_end_on_omx_err (
-    (rc = tiz_pqueue_send (gp_event_loop->p_pq, p_msg, p_msg->priority)),
-    "Failed to insert into the queue");
-  tiz_check_omx (tiz_mutex_unlock (&(gp_event_loop->mutex)));
-  ev_async_send (gp_event_loop->p_loop, gp_event_loop->p_async_watcher);
+  tiz_goto_end_on_omx_err ((rc = send_msg (p_lp, p_msg)),
+                           "Failed to deliver the message");
+  tiz_check_omx (tiz_mutex_unlock (&(p_lp->mutex)));
 
   /* All good */
   rc = OMX_ErrorNone;
@@ -404,7 +461,7 @@ enqueue_timer_msg (tiz_event_timer_t * ap_ev_timer, const uint32_t a_id,
 
   if (OMX_ErrorNone != rc)
     {
-      tiz_check_omx (tiz_mutex_unlock (&(gp_event_loop->mutex)));
+      tiz_check_omx (tiz_mutex_unlock (&(p_lp->mutex)));
     }
 
   return rc;
@@ -415,27 +472,28 @@ enqueue_stat_msg (tiz_event_stat_t * ap_ev_stat, const uint32_t a_id,
                   const tiz_event_loop_msg_class_t a_class)
 {
   OMX_ERRORTYPE rc = OMX_ErrorUndefined;
+  tiz_event_loop_t * p_lp = NULL;
   tiz_event_loop_msg_t * p_msg = NULL;
   tiz_event_loop_msg_stat_t * p_msg_stat = NULL;
 
   assert (ap_ev_stat);
+  assert (ap_ev_stat->p_lp);
   assert (ETIZEventLoopMsgStatStart == a_class
           || ETIZEventLoopMsgStatStop == a_class
           || ETIZEventLoopMsgStatDestroy == a_class);
 
-  tiz_check_omx (tiz_mutex_lock (&(gp_event_loop->mutex)));
-  tiz_goto_end_on_null ((p_msg = init_event_loop_msg (gp_event_loop, (a_class))),
+  p_lp = ap_ev_stat->p_lp;
+  tiz_check_omx (tiz_mutex_lock (&(p_lp->mutex)));
+  tiz_goto_end_on_null ((p_msg = init_event_loop_msg (p_lp, (a_class))),
                         "Failed to initialise the event loop");
 
   assert (p_msg);
   p_msg_stat = &(p_msg->stat);
   p_msg_stat->p_ev_stat = ap_ev_stat;
   p_msg_stat->id = a_id;
-  tiz_goto_end_on_omx_err (
-    (rc = tiz_pqueue_send (gp_event_loop->p_pq, p_msg, p_msg->priority)),
-    "Failed to insert into the queue");
-  tiz_check_omx (tiz_mutex_unlock (&(gp_event_loop->mutex)));
-  ev_async_send (gp_event_loop->p_loop, gp_event_loop->p_async_watcher);
+  tiz_goto_end_on_omx_err ((rc = send_msg (p_lp, p_msg)),
+                           "Failed to deliver the message");
+  tiz_check_omx (tiz_mutex_unlock (&(p_lp->mutex)));
 
   /* All good */
   rc = OMX_ErrorNone;
@@ -444,19 +502,20 @@ enqueue_stat_msg (tiz_event_stat_t * ap_ev_stat, const uint32_t a_id,
 
   if (OMX_ErrorNone != rc)
     {
-      tiz_check_omx (tiz_mutex_unlock (&(gp_event_loop->mutex)));
+      tiz_check_omx (tiz_mutex_unlock (&(p_lp->mutex)));
     }
 
   return OMX_ErrorNone;
 }
 
 static void
-dispatch_msg (tiz_event_loop_msg_t * ap_msg)
+dispatch_msg (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
+  assert (ap_lp);
   assert (ap_msg);
   assert (ap_msg->class < ETIZEventLoopMsgMax);
 
-  (void) tiz_event_loop_msg_to_fnt_tbl[ap_msg->class](ap_msg);
+  (void) tiz_event_loop_msg_to_fnt_tbl[ap_msg->class](ap_lp, ap_msg);
 }
 
 static OMX_S32
@@ -599,14 +658,15 @@ ev_stat_msg_dequeue (void * ap_elem, OMX_S32 a_data1, void * ap_data2)
 }
 
 static OMX_ERRORTYPE
-do_io_start (tiz_event_loop_msg_t * ap_msg)
+do_io_start (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_io_t * p_msg_io = NULL;
   tiz_event_io_t * p_ev_io = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_io = &(ap_msg->io);
   assert (p_msg_io);
@@ -624,20 +684,21 @@ do_io_start (tiz_event_loop_msg_t * ap_msg)
       assert (!p_ev_io->started);
     }
   p_ev_io->started = true;
-  ev_io_start (gp_event_loop->p_loop, (ev_io *) (p_ev_io));
+  ev_io_start (ap_lp->p_loop, (ev_io *) (p_ev_io));
 
   return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
-do_io_stop (tiz_event_loop_msg_t * ap_msg)
+do_io_stop (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_io_t * p_msg_io = NULL;
   tiz_event_io_t * p_ev_io = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_io = &(ap_msg->io);
   assert (p_msg_io);
@@ -646,7 +707,7 @@ do_io_stop (tiz_event_loop_msg_t * ap_msg)
   if (p_ev_io->started)
     {
       /* The io watcher has been started, let's stop it */
-      ev_io_stop (gp_event_loop->p_loop, (ev_io *) (p_ev_io));
+      ev_io_stop (ap_lp->p_loop, (ev_io *) (p_ev_io));
       p_ev_io->started = false;
     }
   else
@@ -655,21 +716,22 @@ do_io_stop (tiz_event_loop_msg_t * ap_msg)
          start requests left behind in the queue */
       const tiz_event_loop_msg_class_t class_to_be_deleted
         = ETIZEventLoopMsgIoStart;
-      tiz_pqueue_remove_func (gp_event_loop->p_pq, ev_io_msg_dequeue,
+      tiz_pqueue_remove_func (ap_lp->p_pq, ev_io_msg_dequeue,
                               (OMX_S32) class_to_be_deleted, p_ev_io);
     }
   return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
-do_io_destroy (tiz_event_loop_msg_t * ap_msg)
+do_io_destroy (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_io_t * p_msg_io = NULL;
   tiz_event_io_t * p_ev_io = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_io = &(ap_msg->io);
   assert (p_msg_io);
@@ -678,14 +740,14 @@ do_io_destroy (tiz_event_loop_msg_t * ap_msg)
   if (p_ev_io->started)
     {
       /* The io watcher has been started, let's stop it */
-      ev_io_stop (gp_event_loop->p_loop, (ev_io *) (p_ev_io));
+      ev_io_stop (ap_lp->p_loop, (ev_io *) (p_ev_io));
     }
 
   {
     /* Now remove any references to this watcher that might be present in the
        queue */
     tiz_event_loop_msg_class_t class_to_be_deleted = ETIZEventLoopMsgIoAny;
-    tiz_pqueue_remove_func (gp_event_loop->p_pq, ev_io_msg_dequeue,
+    tiz_pqueue_remove_func (ap_lp->p_pq, ev_io_msg_dequeue,
                             (OMX_S32) class_to_be_deleted, p_ev_io);
   }
 
@@ -697,14 +759,15 @@ do_io_destroy (tiz_event_loop_msg_t * ap_msg)
 }
 
 static OMX_ERRORTYPE
-do_timer_start (tiz_event_loop_msg_t * ap_msg)
+do_timer_start (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_timer_t * p_msg_timer = NULL;
   tiz_event_timer_t * p_ev_timer = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_timer = &(ap_msg->timer);
   assert (p_msg_timer);
@@ -717,20 +780,22 @@ do_timer_start (tiz_event_loop_msg_t * ap_msg)
     }
   p_ev_timer->id = p_msg_timer->id;
   p_ev_timer->started = true;
-  ev_timer_start (gp_event_loop->p_loop, (ev_timer *) (p_ev_timer));
+  p_ev_timer->expected = ev_now (ap_lp->p_loop) + p_ev_timer->after;
+  ev_timer_start (ap_lp->p_loop, (ev_timer *) (p_ev_timer));
 
   return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
-do_timer_restart (tiz_event_loop_msg_t * ap_msg)
+do_timer_restart (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_timer_t * p_msg_timer = NULL;
   tiz_event_timer_t * p_ev_timer = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_timer = &(ap_msg->timer);
   assert (p_msg_timer);
@@ -743,20 +808,22 @@ do_timer_restart (tiz_event_loop_msg_t * ap_msg)
     }
   p_ev_timer->id = p_msg_timer->id;
   p_ev_timer->started = true;
-  ev_timer_again (gp_event_loop->p_loop, (ev_timer *) (p_ev_timer));
+  p_ev_timer->expected = ev_now (ap_lp->p_loop) + p_ev_timer->repeat;
+  ev_timer_again (ap_lp->p_loop, (ev_timer *) (p_ev_timer));
 
   return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
-do_timer_stop (tiz_event_loop_msg_t * ap_msg)
+do_timer_stop (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_timer_t * p_msg_timer = NULL;
   tiz_event_timer_t * p_ev_timer = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_timer = &(ap_msg->timer);
   assert (p_msg_timer);
@@ -765,7 +832,7 @@ do_timer_stop (tiz_event_loop_msg_t * ap_msg)
   if (p_ev_timer->started)
     {
       /* The timer watcher has been started, let's stop it */
-      ev_timer_stop (gp_event_loop->p_loop, (ev_timer *) (p_ev_timer));
+      ev_timer_stop (ap_lp->p_loop, (ev_timer *) (p_ev_timer));
       p_ev_timer->started = false;
     }
   else
@@ -775,7 +842,7 @@ do_timer_stop (tiz_event_loop_msg_t * ap_msg)
          requests in the queue */
       const tiz_event_loop_msg_class_t class_to_be_deleted
         = ETIZEventLoopMsgTimerStart;
-      tiz_pqueue_remove_func (gp_event_loop->p_pq, ev_timer_msg_dequeue,
+      tiz_pqueue_remove_func (ap_lp->p_pq, ev_timer_msg_dequeue,
                               (OMX_S32) class_to_be_deleted, p_ev_timer);
     }
 
@@ -783,14 +850,15 @@ do_timer_stop (tiz_event_loop_msg_t * ap_msg)
 }
 
 static OMX_ERRORTYPE
-do_timer_destroy (tiz_event_loop_msg_t * ap_msg)
+do_timer_destroy (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_timer_t * p_msg_timer = NULL;
   tiz_event_timer_t * p_ev_timer = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_timer = &(ap_msg->timer);
   assert (p_msg_timer);
@@ -799,13 +867,13 @@ do_timer_destroy (tiz_event_loop_msg_t * ap_msg)
   if (p_ev_timer->started)
     {
       /* The timer watcher has been started, let's stop it */
-      ev_timer_stop (gp_event_loop->p_loop, (ev_timer *) (p_ev_timer));
+      ev_timer_stop (ap_lp->p_loop, (ev_timer *) (p_ev_timer));
     }
   {
     /* Now remove any references to this watcher that might be present in the
        queue */
     tiz_event_loop_msg_class_t class_to_be_deleted = ETIZEventLoopMsgTimerAny;
-    tiz_pqueue_remove_func (gp_event_loop->p_pq, ev_timer_msg_dequeue,
+    tiz_pqueue_remove_func (ap_lp->p_pq, ev_timer_msg_dequeue,
                             (OMX_S32) class_to_be_deleted, p_ev_timer);
   }
 
@@ -817,14 +885,15 @@ do_timer_destroy (tiz_event_loop_msg_t * ap_msg)
 }
 
 static OMX_ERRORTYPE
-do_stat_start (tiz_event_loop_msg_t * ap_msg)
+do_stat_start (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_stat_t * p_msg_stat = NULL;
   tiz_event_stat_t * p_ev_stat = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_stat = &(ap_msg->stat);
   assert (p_msg_stat);
@@ -842,20 +911,21 @@ do_stat_start (tiz_event_loop_msg_t * ap_msg)
       assert (!p_ev_stat->started);
     }
   p_ev_stat->started = true;
-  ev_stat_start (gp_event_loop->p_loop, (ev_stat *) (p_ev_stat));
+  ev_stat_start (ap_lp->p_loop, (ev_stat *) (p_ev_stat));
 
   return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
-do_stat_stop (tiz_event_loop_msg_t * ap_msg)
+do_stat_stop (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_stat_t * p_msg_stat = NULL;
   tiz_event_stat_t * p_ev_stat = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_stat = &(ap_msg->stat);
   assert (p_msg_stat);
@@ -864,7 +934,7 @@ do_stat_stop (tiz_event_loop_msg_t * ap_msg)
   if (p_ev_stat->started)
     {
       /* The stat watcher has been started, let's stop it */
-      ev_stat_stop (gp_event_loop->p_loop, (ev_stat *) (p_ev_stat));
+      ev_stat_stop (ap_lp->p_loop, (ev_stat *) (p_ev_stat));
       p_ev_stat->started = false;
     }
   else
@@ -874,21 +944,22 @@ do_stat_stop (tiz_event_loop_msg_t * ap_msg)
          requests in the queue */
       const tiz_event_loop_msg_class_t class_to_be_deleted
         = ETIZEventLoopMsgStatStart;
-      tiz_pqueue_remove_func (gp_event_loop->p_pq, ev_stat_msg_dequeue,
+      tiz_pqueue_remove_func (ap_lp->p_pq, ev_stat_msg_dequeue,
                               (OMX_S32) class_to_be_deleted, p_ev_stat);
     }
   return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
-do_stat_destroy (tiz_event_loop_msg_t * ap_msg)
+do_stat_destroy (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_stat_t * p_msg_stat = NULL;
   tiz_event_stat_t * p_ev_stat = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_stat = &(ap_msg->stat);
   assert (p_msg_stat);
@@ -897,14 +968,14 @@ do_stat_destroy (tiz_event_loop_msg_t * ap_msg)
   if (p_ev_stat->started)
     {
       /* The stat watcher has been started, let's stop it */
-      ev_stat_stop (gp_event_loop->p_loop, (ev_stat *) (p_ev_stat));
+      ev_stat_stop (ap_lp->p_loop, (ev_stat *) (p_ev_stat));
     }
 
   {
     /* Now remove any references to this watcher that might be present in the
        queue */
     tiz_event_loop_msg_class_t class_to_be_deleted = ETIZEventLoopMsgStatAny;
-    tiz_pqueue_remove_func (gp_event_loop->p_pq, ev_stat_msg_dequeue,
+    tiz_pqueue_remove_func (ap_lp->p_pq, ev_stat_msg_dequeue,
                             (OMX_S32) class_to_be_deleted, p_ev_stat);
   }
 
@@ -918,35 +989,33 @@ static void
 async_watcher_cback (struct ev_loop * ap_loop, ev_async * ap_watcher,
                      int a_revents)
 {
-  (void) ap_loop;
+  tiz_event_loop_t * p_lp = ev_userdata (ap_loop);
   (void) ap_watcher;
   (void) a_revents;
 
-  if (gp_event_loop)
+  if (p_lp)
     {
-      if (ETIZEventLoopStateStopping == gp_event_loop->state)
-        {
-          ev_break (gp_event_loop->p_loop, EVBREAK_ONE);
-        }
-      else if (ETIZEventLoopStateStarted == gp_event_loop->state)
-        {
-          void * p_msg = NULL;
+      void * p_msg = NULL;
 
-          /* Process all items from the queue */
-          (void) tiz_mutex_lock (&(gp_event_loop->mutex));
-          while (0 < tiz_pqueue_length (gp_event_loop->p_pq))
+      /* Process all items from the queue; when stopping, this takes care of
+         the watchers that were destroyed just before the loop */
+      (void) tiz_mutex_lock (&(p_lp->mutex));
+      while (0 < tiz_pqueue_length (p_lp->p_pq))
+        {
+          if (OMX_ErrorNone != tiz_pqueue_receive (p_lp->p_pq, &p_msg))
             {
-              if (OMX_ErrorNone
-                  != tiz_pqueue_receive (gp_event_loop->p_pq, &p_msg))
-                {
-                  break;
-                }
-              /* Process the message */
-              dispatch_msg (p_msg);
-              /* Delete the message */
-              tiz_soa_free (gp_event_loop->p_soa, p_msg);
+              break;
             }
-          (void) tiz_mutex_unlock (&(gp_event_loop->mutex));
+          /* Process the message */
+          dispatch_msg (p_lp, p_msg);
+          /* Delete the message */
+          tiz_soa_free (p_lp->p_soa, p_msg);
+        }
+      (void) tiz_mutex_unlock (&(p_lp->mutex));
+
+      if (ETIZEventLoopStateStopping == p_lp->state)
+        {
+          ev_break (p_lp->p_loop, EVBREAK_ONE);
         }
     }
 }
@@ -955,7 +1024,6 @@ static void
 io_watcher_cback (struct ev_loop * ap_loop, ev_io * ap_watcher, int a_revents)
 {
   tiz_event_io_t * p_io_event = (tiz_event_io_t *) ap_watcher;
-  (void) ap_loop;
 
   if (gp_event_loop)
     {
@@ -965,7 +1033,7 @@ io_watcher_cback (struct ev_loop * ap_loop, ev_io * ap_watcher, int a_revents)
       if (p_io_event->once)
         {
           p_io_event->started = false;
-          ev_io_stop (gp_event_loop->p_loop, (ev_io *) p_io_event);
+          ev_io_stop (ap_loop, (ev_io *) p_io_event);
         }
       p_io_event->pf_cback (p_io_event->p_arg0, p_io_event, p_io_event->p_arg1,
                             p_io_event->id, ((ev_io *) p_io_event)->fd,
@@ -973,11 +1041,45 @@ io_watcher_cback (struct ev_loop * ap_loop, ev_io * ap_watcher, int a_revents)
     }
 }
 
+static void
+record_timer_jitter (tiz_event_loop_t * ap_lp, tiz_event_timer_t * ap_ev_timer)
+{
+  tiz_event_loop_jitter_t * p_jitter = NULL;
+  const double now = ev_time ();
+  const double late_us = MAX (now - ap_ev_timer->expected, 0.0) * 1e6;
+  double limit_us = TIZ_EVENT_LOOP_JITTER_BASE_US;
+  OMX_U32 bucket = 0;
+
+  assert (ap_lp);
+  assert (ap_ev_timer);
+
+  while (late_us >= limit_us && bucket < TIZ_EVENT_LOOP_JITTER_BUCKETS - 1)
+    {
+      limit_us *= 2;
+      ++bucket;
+    }
+
+  (void) tiz_mutex_lock (&(ap_lp->mutex));
+  p_jitter = &(ap_lp->jitter);
+  p_jitter->buckets[bucket]++;
+  p_jitter->count++;
+  p_jitter->total_us += late_us;
+  p_jitter->max_us = MAX (p_jitter->max_us, late_us);
+  (void) tiz_mutex_unlock (&(ap_lp->mutex));
+
+  /* libev keeps repeating timers on their original schedule, unless they
+     have fallen a whole period behind */
+  if (ap_ev_timer->repeat > 0.0)
+    {
+      ap_ev_timer->expected += ap_ev_timer->repeat;
+      ap_ev_timer->expected = MAX (ap_ev_timer->expected, now);
+    }
+}
+
 static void
 timer_watcher_cback (struct ev_loop * ap_loop, ev_timer * ap_watcher,
                      int a_revents)
 {
-  (void) ap_loop;
   (void) a_revents;
 
   if (gp_event_loop)
@@ -985,6 +1087,7 @@ timer_watcher_cback (struct ev_loop * ap_loop, ev_timer * ap_watcher,
       tiz_event_timer_t * p_timer_event = (tiz_event_timer_t *) ap_watcher;
       assert (p_timer_event);
       assert (p_timer_event->pf_cback);
+      record_timer_jitter (ev_userdata (ap_loop), p_timer_event);
       p_timer_event->pf_cback (p_timer_event->p_arg0, p_timer_event,
                                p_timer_event->p_arg1, p_timer_event->id);
     }
@@ -1012,14 +1115,25 @@ event_loop_thread_func (void * p_arg)
 {
   tiz_event_loop_t * p_event_loop = p_arg;
   struct ev_loop * p_loop = NULL;
+  char name[16];
 
   assert (p_event_loop);
 
   p_loop = p_event_loop->p_loop;
   assert (p_loop);
 
-  (void) tiz_thread_setname (&(p_event_loop->thread),
-                             (const OMX_STRING) TIZ_EVENT_LOOP_THREAD_NAME);
+  if (0 == p_event_loop->index)
+    {
+      snprintf (name, sizeof (name), "%s", TIZ_EVENT_LOOP_THREAD_NAME);
+    }
+  else
+    {
+      snprintf (name, sizeof (name), "%s%u", TIZ_EVENT_LOOP_THREAD_NAME,
+                (unsigned int) p_event_loop->index);
+    }
+  (void) tiz_thread_setname (&(p_event_loop->thread), (const OMX_STRING) name);
+
+  tl_p_event_loop = p_event_loop;
 
   TIZ_LOG (TIZ_PRIORITY_TRACE, "Entering the dispatcher...");
   tiz_sem_post (&(p_event_loop->sem));
@@ -1072,18 +1186,124 @@ clean_up_thread_data (tiz_event_loop_t * ap_lp)
           ap_lp->p_soa = NULL;
         }
 
-      tiz_mem_free (gp_event_loop);
-      gp_event_loop = NULL;
+      tiz_mem_free (ap_lp);
+    }
+}
+
+static OMX_ERRORTYPE
+create_event_loop (tiz_event_loop_t ** app_lp, const OMX_U32 a_index)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorInsufficientResources;
+  tiz_event_loop_t * p_lp = NULL;
+
+  assert (app_lp);
+
+  tiz_goto_end_on_null (
+    (p_lp = (tiz_event_loop_t *) tiz_mem_calloc (1, sizeof (tiz_event_loop_t))),
+    "Error allocating thread data struct.");
+
+  p_lp->index = a_index;
+  p_lp->state = ETIZEventLoopStateStarting;
+
+  tiz_goto_end_on_null ((p_lp->p_loop = ev_loop_new (EVFLAG_AUTO)),
+                        "Error instantiating ev_loop.");
+
+  tiz_goto_end_on_null (
+    (p_lp->p_async_watcher = (ev_async *) tiz_mem_calloc (1, sizeof (ev_async))),
+    "Error initializing async watcher.");
+
+  tiz_goto_end_on_omx_err (tiz_mutex_init (&(p_lp->mutex)),
+                           "Error initializing mutex.");
+
+  tiz_goto_end_on_omx_err (tiz_sem_init (&(p_lp->sem), 0),
+                           "Error initializing sem.");
+
+  /* Init the small object allocator */
+  tiz_goto_end_on_omx_err (tiz_soa_init (&(p_lp->p_soa)),
+                           "Error initializing the small object allocator.");
+
+  /* Init the priority queue */
+  tiz_goto_end_on_omx_err (tiz_pqueue_init (&p_lp->p_pq, 2, &pqueue_cmp,
+                                            p_lp->p_soa,
+                                            TIZ_EVENT_LOOP_THREAD_NAME),
+                           "Error initializing pqueue.");
+
+  /* All good */
+  rc = OMX_ErrorNone;
+
+  ev_set_userdata (p_lp->p_loop, p_lp);
+  ev_async_init (p_lp->p_async_watcher, async_watcher_cback);
+  ev_async_start (p_lp->p_loop, p_lp->p_async_watcher);
+
+end:
+
+  if (OMX_ErrorNone != rc)
+    {
+      clean_up_thread_data (p_lp);
+      p_lp = NULL;
+    }
+
+  *app_lp = p_lp;
+  return rc;
+}
+
+static void
+start_event_loop (tiz_event_loop_t * ap_lp)
+{
+  assert (ap_lp);
+  ap_lp->state = ETIZEventLoopStateStarted;
+  /* Create event loop thread */
+  tiz_thread_create (&(ap_lp->thread), 0, 0, event_loop_thread_func, ap_lp);
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "Now in ETIZEventLoopStateStarted state...");
+
+  (void) tiz_mutex_lock (&(ap_lp->mutex));
+  /* This is to prevent the event loop from exiting when there are no
+   * more active events */
+  ev_ref (ap_lp->p_loop);
+  (void) tiz_mutex_unlock (&(ap_lp->mutex));
+  tiz_sem_wait (&(ap_lp->sem));
+}
+
+static void
+stop_event_loop (tiz_event_loop_t * ap_lp)
+{
+  tiz_event_loop_jitter_t * p_jitter = NULL;
+  OMX_PTR p_result = NULL;
+
+  assert (ap_lp);
+
+  (void) tiz_mutex_lock (&(ap_lp->mutex));
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "destroying event loop thread [%p].", ap_lp);
+  ap_lp->state = ETIZEventLoopStateStopping;
+  ev_unref (ap_lp->p_loop);
+  ev_async_send (ap_lp->p_loop, ap_lp->p_async_watcher);
+  (void) tiz_mutex_unlock (&(ap_lp->mutex));
+
+  tiz_thread_join (&(ap_lp->thread), &p_result);
+
+  p_jitter = &(ap_lp->jitter);
+  if (p_jitter->count > 0)
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE,
+               "event loop [%u] : [%llu] timer expirations - jitter mean "
+               "[%.1f] us max [%.1f] us",
+               (unsigned int) ap_lp->index,
+               (unsigned long long) p_jitter->count,
+               p_jitter->total_us / p_jitter->count, p_jitter->max_us);
     }
 }
 
 static void
 child_event_loop_reset (void)
 {
-  /* Reset the once control */
+  /* Reset the once controls */
   pthread_once_t once = PTHREAD_ONCE_INIT;
   memcpy (&g_event_loop_once, &once, sizeof (g_event_loop_once));
+  memcpy (&g_event_shards_once, &once, sizeof (g_event_shards_once));
   gp_event_loop = NULL;
+  memset (gp_event_shards, 0, sizeof (gp_event_shards));
+  g_event_nshards = 1;
+  tl_p_event_loop = NULL;
 }
 
 static void
@@ -1093,53 +1313,17 @@ init_event_loop_thread (void)
 
   if (!gp_event_loop)
     {
-      /* Let's return OOM error if something goes wrong */
-      rc = OMX_ErrorInsufficientResources;
-
       /* Register a handler to reset the pthread_once_t global variable to try
          to cope with the scenario of a process forking without exec. The idea
          is to make sure that the loop thread is re-created in the child
          process */
       pthread_atfork (NULL, NULL, child_event_loop_reset);
 
-      tiz_goto_end_on_null (
-        (gp_event_loop
-         = (tiz_event_loop_t *) tiz_mem_calloc (1, sizeof (tiz_event_loop_t))),
-        "Error allocating thread data struct.");
-
-      gp_event_loop->state = ETIZEventLoopStateStarting;
+      tiz_goto_end_on_omx_err (create_event_loop (&gp_event_loop, 0),
+                               "Error creating the event loop.");
 
       tiz_goto_end_on_omx_err (tiz_rcfile_init (&(gp_event_loop->p_rcfile)),
-                           "Error opening configuration file.");
-
-      tiz_goto_end_on_null ((gp_event_loop->p_loop = ev_loop_new (EVFLAG_AUTO)),
-                            "Error instantiating ev_loop.");
-
-      tiz_goto_end_on_null ((gp_event_loop->p_async_watcher
-                            = (ev_async *) tiz_mem_calloc (1, sizeof (ev_async))),
-                           "Error initializing async watcher.");
-
-      tiz_goto_end_on_omx_err (tiz_mutex_init (&(gp_event_loop->mutex)),
-                           "Error initializing mutex.");
-
-      tiz_goto_end_on_omx_err (tiz_sem_init (&(gp_event_loop->sem), 0),
-                           "Error initializing sem.");
-
-      /* Init the small object allocator */
-      tiz_goto_end_on_omx_err (tiz_soa_init (&(gp_event_loop->p_soa)),
-                           "Error initializing the small object allocator.");
-
-      /* Init the priority queue */
-      tiz_goto_end_on_omx_err (
-        tiz_pqueue_init (&gp_event_loop->p_pq, 2, &pqueue_cmp,
-                         gp_event_loop->p_soa, TIZ_EVENT_LOOP_THREAD_NAME),
-        "Error initializing pqueue.");
-
-      /* All good */
-      rc = OMX_ErrorNone;
-
-      ev_async_init (gp_event_loop->p_async_watcher, async_watcher_cback);
-      ev_async_start (gp_event_loop->p_loop, gp_event_loop->p_async_watcher);
+                               "Error opening configuration file.");
 
       assert (gp_event_loop);
     }
@@ -1148,23 +1332,12 @@ end:
 
   if (OMX_ErrorNone == rc)
     {
-      tiz_event_loop_t * p_lp = gp_event_loop;
-      p_lp->state = ETIZEventLoopStateStarted;
-      /* Create event loop thread */
-      tiz_thread_create (&(p_lp->thread), 0, 0, event_loop_thread_func, p_lp);
-      TIZ_LOG (TIZ_PRIORITY_TRACE, "Now in ETIZEventLoopStateStarted state...");
-
-      (void) tiz_mutex_lock (&(p_lp->mutex));
-      /* This is to prevent the event loop from exiting when there are no
-       * more active events */
-      ev_ref (p_lp->p_loop);
-      (void) tiz_mutex_unlock (&(p_lp->mutex));
-      tiz_sem_wait (&(p_lp->sem));
+      start_event_loop (gp_event_loop);
+      gp_event_shards[0] = gp_event_loop;
     }
   else
     {
       clean_up_thread_data (gp_event_loop);
-      tiz_mem_free (gp_event_loop);
       gp_event_loop = NULL;
     }
 }
@@ -1176,10 +1349,93 @@ get_event_loop (void)
   return gp_event_loop;
 }
 
+static void
+init_event_loop_shards (void)
+{
+  const char * p_nshards
+    = tiz_rcfile_get_value ("ilcore", TIZ_EVENT_LOOP_RCFILE_SHARDS_KEY);
+  OMX_S32 nshards = p_nshards ? atoi (p_nshards) : 1;
+  OMX_S32 i = 0;
+
+  nshards = MIN (MAX (nshards, 1), TIZ_EVENT_LOOP_MAX_SHARDS);
+
+  for (i = 1; i < nshards; ++i)
+    {
+      if (OMX_ErrorNone != create_event_loop (&(gp_event_shards[i]), i))
+        {
+          TIZ_LOG (TIZ_PRIORITY_ERROR,
+                   "[OMX_ErrorInsufficientResources] : "
+                   "Unable to create event loop [%d]; running [%d] loops",
+                   i, i);
+          break;
+        }
+      start_event_loop (gp_event_shards[i]);
+    }
+
+  g_event_nshards = i;
+}
+
+static OMX_U32
+get_event_loop_shards (void)
+{
+  if (get_event_loop ())
+    {
+      (void) pthread_once (&g_event_shards_once, init_event_loop_shards);
+    }
+  return g_event_nshards;
+}
+
+static OMX_S32
+find_pin (const void * ap_arg0)
+{
+  OMX_S32 i = 0;
+  for (i = 0; i < TIZ_EVENT_LOOP_MAX_PINS; ++i)
+    {
+      if (ap_arg0 == g_event_pins[i].p_arg0)
+        {
+          return i;
+        }
+    }
+  return -1;
+}
+
+/* Watchers created with the same first argument (the component handle, in
+   practice) always end up in the same shard */
+static tiz_event_loop_t *
+select_event_loop (const void * ap_arg0)
+{
+  const OMX_U32 nshards = get_event_loop_shards ();
+  OMX_U32 shard = 0;
+
+  if (nshards > 1 && ap_arg0)
+    {
+      OMX_S32 pin = -1;
+      (void) pthread_mutex_lock (&g_event_pins_mutex);
+      if ((pin = find_pin (ap_arg0)) >= 0)
+        {
+          shard = g_event_pins[pin].shard;
+        }
+      (void) pthread_mutex_unlock (&g_event_pins_mutex);
+
+      if (pin < 0)
+        {
+          /* Fibonacci hashing; the lowest bits of a heap pointer carry
+             little information */
+          const uint64_t hash
+            = ((uint64_t) (uintptr_t) ap_arg0 >> 4) * 11400714819323198485ULL;
+          shard = (OMX_U32) ((hash >> 32) % nshards);
+        }
+    }
+
+  assert (shard < nshards);
+  return gp_event_shards[shard];
+}
+
 OMX_ERRORTYPE
 tiz_event_loop_init (void)
 {
-  return get_event_loop () ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
+  (void) get_event_loop_shards ();
+  return gp_event_loop ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
 }
 
 void
@@ -1190,22 +1446,91 @@ tiz_event_loop_destroy (void)
 
   if (gp_event_loop)
     {
-      (void) tiz_mutex_lock (&(gp_event_loop->mutex));
-      TIZ_LOG (TIZ_PRIORITY_TRACE, "destroying event loop thread [%p].",
-               gp_event_loop);
-      gp_event_loop->state = ETIZEventLoopStateStopping;
-      ev_unref (gp_event_loop->p_loop);
-      ev_async_send (gp_event_loop->p_loop, gp_event_loop->p_async_watcher);
-      (void) tiz_mutex_unlock (&(gp_event_loop->mutex));
-
-      {
-        OMX_PTR p_result = NULL;
-        tiz_thread_join (&(gp_event_loop->thread), &p_result);
-        clean_up_thread_data (gp_event_loop);
-        tiz_mem_free (gp_event_loop);
-        gp_event_loop = NULL;
-      }
+      OMX_S32 i = 0;
+      for (i = g_event_nshards - 1; i >= 0; --i)
+        {
+          stop_event_loop (gp_event_shards[i]);
+          if (i > 0)
+            {
+              clean_up_thread_data (gp_event_shards[i]);
+            }
+          gp_event_shards[i] = NULL;
+        }
+      g_event_nshards = 1;
+      clean_up_thread_data (gp_event_loop);
+      gp_event_loop = NULL;
+    }
+}
+
+OMX_U32
+tiz_event_loop_get_shard_count (void)
+{
+  return get_event_loop_shards ();
+}
+
+OMX_ERRORTYPE
+tiz_event_loop_pin (const void * ap_arg0, const OMX_U32 a_shard)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  OMX_S32 pin = -1;
+
+  if (!ap_arg0 || a_shard >= get_event_loop_shards ())
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  (void) pthread_mutex_lock (&g_event_pins_mutex);
+  if ((pin = find_pin (ap_arg0)) < 0)
+    {
+      pin = find_pin (NULL);
+    }
+  if (pin >= 0)
+    {
+      g_event_pins[pin].p_arg0 = ap_arg0;
+      g_event_pins[pin].shard = a_shard;
     }
+  else
+    {
+      rc = OMX_ErrorInsufficientResources;
+    }
+  (void) pthread_mutex_unlock (&g_event_pins_mutex);
+
+  return rc;
+}
+
+void
+tiz_event_loop_unpin (const void * ap_arg0)
+{
+  OMX_S32 pin = -1;
+  if (ap_arg0)
+    {
+      (void) pthread_mutex_lock (&g_event_pins_mutex);
+      if ((pin = find_pin (ap_arg0)) >= 0)
+        {
+          g_event_pins[pin].p_arg0 = NULL;
+        }
+      (void) pthread_mutex_unlock (&g_event_pins_mutex);
+    }
+}
+
+OMX_ERRORTYPE
+tiz_event_loop_get_timer_jitter (const OMX_U32 a_shard,
+                                 tiz_event_loop_jitter_t * ap_jitter)
+{
+  tiz_event_loop_t * p_lp = NULL;
+
+  if (!ap_jitter || a_shard >= get_event_loop_shards ())
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  p_lp = gp_event_shards[a_shard];
+  assert (p_lp);
+  tiz_check_omx (tiz_mutex_lock (&(p_lp->mutex)));
+  *ap_jitter = p_lp->jitter;
+  tiz_check_omx (tiz_mutex_unlock (&(p_lp->mutex)));
+
+  return OMX_ErrorNone;
 }
 
 /*
@@ -1226,6 +1551,7 @@ tiz_event_io_init (tiz_event_io_t ** app_ev_io, void * ap_arg0,
   if ((p_ev_io
        = (tiz_event_io_t *) tiz_mem_calloc (1, sizeof (tiz_event_io_t))))
     {
+      p_ev_io->p_lp = select_event_loop (ap_arg0);
       p_ev_io->pf_cback = ap_cback;
       p_ev_io->p_arg0 = ap_arg0;
       p_ev_io->p_arg1 = ap_arg1;
@@ -1306,6 +1632,7 @@ tiz_event_timer_init (tiz_event_timer_t ** app_ev_timer, void * ap_arg0,
   if ((p_ev_timer
        = (tiz_event_timer_t *) tiz_mem_calloc (1, sizeof (tiz_event_timer_t))))
     {
+      p_ev_timer->p_lp = select_event_loop (ap_arg0);
       p_ev_timer->pf_cback = ap_cback;
       p_ev_timer->p_arg0 = ap_arg0;
       p_ev_timer->p_arg1 = ap_arg1;
@@ -1328,6 +1655,8 @@ tiz_event_timer_set (tiz_event_timer_t * ap_ev_timer, double a_after,
   assert (ap_ev_timer);
   (void) get_event_loop ();
   ap_ev_timer->once = a_repeat ? false : true;
+  ap_ev_timer->after = a_after;
+  ap_ev_timer->repeat = a_repeat;
   ev_timer_set ((ev_timer *) ap_ev_timer, a_after, a_repeat);
 }
 
@@ -1392,6 +1721,7 @@ tiz_event_stat_init (tiz_event_stat_t ** app_ev_stat, void * ap_arg0,
   if ((p_ev_stat
        = (tiz_event_stat_t *) tiz_mem_calloc (1, sizeof (tiz_event_stat_t))))
     {
+      p_ev_stat->p_lp = select_event_loop (ap_arg0);
       p_ev_stat->pf_cback = ap_cback;
       p_ev_stat->p_arg0 = ap_arg0;
       p_ev_stat->p_arg1 = ap_arg1;
@@ -36,7 +36,13 @@ extern "C" {
 /**
  * @defgroup tizevent Global event loop, async io and timers.
  *
- * Global event loop, async io and timers.
+ * Global event loop, async io and timers. The loop can be split into several
+ * shards, each one running on its own thread (see the 'event-loop.shards'
+ * key in the [ilcore] section of tizonia.conf). Every watcher belongs to one
+ * shard, chosen when the watcher is created from its first argument (i.e. the
+ * component handle), so all the watchers of a component run on the same
+ * thread. Watcher operations requested from the thread that runs the watcher
+ * take effect immediately; those requested from other threads are queued.
  *
  * @ingroup libtizplatform
  */
@@ -89,6 +95,27 @@ typedef void (*tiz_event_stat_cb_f) (void * ap_arg0,
                                      void * ap_arg1, const uint32_t a_id,
                                      int a_events);
 
+/**
+ * Number of buckets in a timer jitter histogram.
+ * @ingroup tizevent
+ */
+#define TIZ_EVENT_LOOP_JITTER_BUCKETS 12
+
+/**
+ * Histogram of the delay between the time a timer was due and the time its
+ * callback ran. Bucket 0 counts delays under 100 microseconds, and bucket i
+ * (0 < i < TIZ_EVENT_LOOP_JITTER_BUCKETS - 1) those from 100 * 2^(i-1) up to
+ * 100 * 2^i microseconds. The last bucket counts everything else.
+ * @ingroup tizevent
+ */
+typedef struct tiz_event_loop_jitter
+{
+  OMX_U64 buckets[TIZ_EVENT_LOOP_JITTER_BUCKETS];
+  OMX_U64 count;   /**< Number of timer expirations */
+  double total_us; /**< Sum of all the delays */
+  double max_us;   /**< Longest delay */
+} tiz_event_loop_jitter_t;
+
 typedef enum tiz_event_io_event {
   TIZ_EVENT_READ = 0x01,  /* ev_io detected read will not block */
   TIZ_EVENT_WRITE = 0x02, /* ev_io detected write will not block */
@@ -125,6 +152,57 @@ tiz_event_loop_init (void);
 void
 tiz_event_loop_destroy (void);
 
+/**
+ * Retrieve the number of event loop shards.
+ *
+ * @ingroup tizevent
+ *
+ * @return The number of shards (at least one).
+ */
+OMX_U32
+tiz_event_loop_get_shard_count (void);
+
+/**
+ * Assign a shard to the watchers that will be created with ap_arg0 as their
+ * first argument, instead of the one that would be chosen by hashing
+ * ap_arg0. Watchers that already exist are not moved.
+ *
+ * @ingroup tizevent
+ *
+ * @param ap_arg0 The first argument of the watchers (e.g. a component
+ * handle).
+ * @param a_shard The shard index, from 0 to the number of shards - 1.
+ *
+ * @return OMX_ErrorNone if success, OMX_ErrorBadParameter if the shard does
+ * not exist, OMX_ErrorInsufficientResources if too many pins are in use.
+ */
+OMX_ERRORTYPE
+tiz_event_loop_pin (const void * ap_arg0, const OMX_U32 a_shard);
+
+/**
+ * Remove the shard assignment made with tiz_event_loop_pin, if any.
+ *
+ * @ingroup tizevent
+ *
+ * @param ap_arg0 The first argument of the watchers.
+ */
+void
+tiz_event_loop_unpin (const void * ap_arg0);
+
+/**
+ * Retrieve the timer jitter histogram of a shard.
+ *
+ * @ingroup tizevent
+ *
+ * @param a_shard The shard index.
+ * @param ap_jitter The histogram (output).
+ *
+ * @return OMX_ErrorNone if success, OMX_ErrorBadParameter otherwise.
+ */
+OMX_ERRORTYPE
+tiz_event_loop_get_timer_jitter (const OMX_U32 a_shard,
+                                 tiz_event_loop_jitter_t * ap_jitter);
+
 OMX_ERRORTYPE
 tiz_event_io_init (tiz_event_io_t ** app_ev_io, void * ap_arg0,
                    tiz_event_io_cb_f ap_cback, void * ap_arg1);
@@ -30,6 +30,7 @@
 #include <config.h>
 #endif
 
+#include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -39,13 +40,26 @@
 #include <sys/syscall.h>
 #include <time.h>
 #include <alloca.h>
+#include <limits.h>
 
 #include <log4c.h>
 #include <log4c/appender.h>
 #include <log4c/appender_type_rollingfile.h>
 #include <log4c/rollingpolicy.h>
 
+#include <OMX_Core.h>
+
 #include "tizlog.h"
+#include "tizlogring.h"
+#include "tizrc.h"
+#include "tizplatform_internal.h"
+
+#define TIZ_LOG_RCFILE_RING_KEY "log.ring-buffer"
+#define TIZ_LOG_RCFILE_RING_FILE_KEY "log.ring-buffer.file"
+#define TIZ_LOG_RCFILE_RING_SIZE_KEY "log.ring-buffer.size-kb"
+
+/* Starts at 1 so that a zero-initialised tiz_log_site_t is always stale */
+unsigned int tiz_log_generation = 1;
 
 typedef struct user_locinfo user_locinfo_t;
 struct user_locinfo
@@ -139,12 +153,38 @@ log_formatters_init (void)
   return rc;
 }
 
+static void
+log_ring_init (void)
+{
+  const char * p_enabled
+    = tiz_rcfile_get_value ("ilcore", TIZ_LOG_RCFILE_RING_KEY);
+  if (p_enabled && 0 == strncmp (p_enabled, "true", 4))
+    {
+      const char * p_file
+        = tiz_rcfile_get_value ("ilcore", TIZ_LOG_RCFILE_RING_FILE_KEY);
+      const char * p_size
+        = tiz_rcfile_get_value ("ilcore", TIZ_LOG_RCFILE_RING_SIZE_KEY);
+      char path[PATH_MAX];
+      if (p_file)
+        {
+          /* Several processes may share the same configuration */
+          snprintf (path, sizeof (path), "%s.%i", p_file, getpid ());
+        }
+      (void) tiz_log_ring_start (p_file ? path : NULL,
+                                 p_size ? atoi (p_size) * 1024 : 0);
+    }
+}
+
 int
 tiz_log_init (void)
 {
 #ifndef WITHOUT_LOG4C
+  int rc = 0;
   log_formatters_init ();
-  return log4c_init ();
+  rc = log4c_init ();
+  __atomic_add_fetch (&tiz_log_generation, 1, __ATOMIC_RELEASE);
+  log_ring_init ();
+  return rc;
 #else
   return 0;
 #endif
@@ -197,51 +237,153 @@ int
 tiz_log_deinit (void)
 {
 #ifndef WITHOUT_LOG4C
+  tiz_log_ring_stop ();
+  /* Invalidate the category handles cached at the call sites first */
+  __atomic_add_fetch (&tiz_log_generation, 1, __ATOMIC_RELEASE);
   return log4c_fini ();
 #else
   return 0;
 #endif
 }
 
+#ifndef WITHOUT_LOG4C
+static void
+log_category_va (const log4c_category_t * ap_category, const char * ap_file,
+                 int a_line, const char * ap_func, int a_priority,
+                 const char * ap_cname, char * ap_cbuf,
+                 const char * ap_format, va_list a_va)
+{
+  log4c_location_info_t locinfo;
+  user_locinfo_t user_locinfo;
+  /* TODO: 4096 - this value should be obtained at config time */
+  char * buffer = alloca (4096);
+  user_locinfo.pid = getpid ();
+  user_locinfo.tid = syscall (SYS_gettid);
+  user_locinfo.cname = ap_cname;
+  user_locinfo.cbuf = ap_cbuf;
+  locinfo.loc_file = ap_file;
+  locinfo.loc_line = a_line;
+  locinfo.loc_function = ap_func;
+  /*          locinfo.loc_data = NULL; */
+  locinfo.loc_data = &user_locinfo;
+
+  vsprintf (buffer, ap_format, a_va);
+  log4c_category_log_locinfo (ap_category, &locinfo, a_priority, "%s", buffer);
+}
+#endif
+
+void
+tiz_log_site_update (tiz_log_site_t * ap_site, const char * ap_cat_name)
+{
+  const unsigned int generation
+    = __atomic_load_n (&tiz_log_generation, __ATOMIC_ACQUIRE);
+  assert (ap_site);
+#ifndef WITHOUT_LOG4C
+  {
+    const log4c_category_t * p_category = log4c_category_get (ap_cat_name);
+    ap_site->p_category = p_category;
+    ap_site->priority = log4c_category_get_chainedpriority (p_category);
+  }
+#else
+  (void) ap_cat_name;
+  ap_site->priority = TIZ_PRIORITY_TRACE;
+#endif
+  __atomic_store_n (&ap_site->generation, generation, __ATOMIC_RELEASE);
+}
+
 void
 tiz_log (const char * ap_file, int a_line, const char * ap_func,
          const char * ap_cat_name, int a_priority, const char * ap_cname,
          char * ap_cbuf, const char * ap_format, ...)
 {
+  va_list va;
+  va_start (va, ap_format);
 #ifndef WITHOUT_LOG4C
-  log4c_location_info_t locinfo;
-  user_locinfo_t user_locinfo;
+  {
+    const log4c_category_t * p_category = log4c_category_get (ap_cat_name);
+    if (log4c_category_is_priority_enabled (p_category, a_priority))
+      {
+        log_category_va (p_category, ap_file, a_line, ap_func, a_priority,
+                         ap_cname, ap_cbuf, ap_format, va);
+      }
+  }
+#else
+  vprintf (ap_format, va);
+  printf ("\n");
+#endif
+  va_end (va);
+}
+
+void
+tiz_log_at_site (tiz_log_site_t * ap_site, const char * ap_file,
+                 int a_line, const char * ap_func, const char * ap_cat_name,
+                 int a_priority, const char * ap_cname, char * ap_cbuf,
+                 const char * ap_format, ...)
+{
+  va_list va;
+  assert (ap_site);
+  va_start (va, ap_format);
+  if (tiz_log_ring_is_active ())
+    {
+      OMX_BOOL done = OMX_FALSE;
+      va_list va_ring;
+      va_copy (va_ring, va);
+      done = tiz_log_ring_write (ap_site, ap_file, a_line, ap_func,
+                                 ap_cat_name, a_priority, ap_cname, ap_format,
+                                 va_ring);
+      va_end (va_ring);
+      if (done)
+        {
+          va_end (va);
+          return;
+        }
+    }
+#ifndef WITHOUT_LOG4C
+  /* The caller has already checked the priority against the site's cache */
+  (void) ap_cat_name;
+  log_category_va (ap_site->p_category, ap_file, a_line, ap_func, a_priority,
+                   ap_cname, ap_cbuf, ap_format, va);
+#else
+  (void) ap_cat_name;
+  vprintf (ap_format, va);
+  printf ("\n");
+#endif
+  va_end (va);
+}
 
+void
+tiz_log_forward (const char * ap_cat_name, const char * ap_file, int a_line,
+                 const char * ap_func, int a_priority, int a_tid,
+                 const char * ap_cname, const char * ap_msg)
+{
+#ifndef WITHOUT_LOG4C
   const log4c_category_t * p_category = log4c_category_get (ap_cat_name);
   if (log4c_category_is_priority_enabled (p_category, a_priority))
     {
+      log4c_location_info_t locinfo;
+      user_locinfo_t user_locinfo;
       /* TODO: 4096 - this value should be obtained at config time */
       char * buffer = alloca (4096);
       user_locinfo.pid = getpid ();
-      user_locinfo.tid = syscall (SYS_gettid);
+      user_locinfo.tid = a_tid;
       user_locinfo.cname = ap_cname;
-      user_locinfo.cbuf = ap_cbuf;
+      user_locinfo.cbuf = buffer;
       locinfo.loc_file = ap_file;
       locinfo.loc_line = a_line;
       locinfo.loc_function = ap_func;
-      /*          locinfo.loc_data = NULL; */
       locinfo.loc_data = &user_locinfo;
-
-      va_list va;
-      va_start (va, ap_format);
-      vsprintf (buffer, ap_format, va);
-      va_end (va);
       log4c_category_log_locinfo (p_category, &locinfo, a_priority, "%s",
-                                  buffer);
+                                  ap_msg);
     }
 #else
-
-  va_list va;
-  va_start (va, ap_format);
-  vprintf (ap_format, va);
-  va_end (va);
-  printf ("\n");
-
+  (void) ap_cat_name;
+  (void) ap_file;
+  (void) a_line;
+  (void) ap_func;
+  (void) a_priority;
+  (void) a_tid;
+  (void) ap_cname;
+  printf ("%s\n", ap_msg);
 #endif
 }
 
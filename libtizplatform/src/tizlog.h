@@ -41,10 +41,6 @@ extern "C" {
 
 /* #define WITHOUT_LOG4C 1 */
 
-#define TIZ_LOG(priority, format, args...)                                    \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME, priority, \
-           NULL, NULL, format, ##args);
-
 #ifndef WITHOUT_LOG4C
 #define TIZ_PRIORITY_ERROR LOG4C_PRIORITY_ERROR
 #define TIZ_PRIORITY_WARN LOG4C_PRIORITY_WARN
@@ -59,6 +55,66 @@ extern "C" {
 #define TIZ_PRIORITY_TRACE 5
 #endif
 
+/**
+ * Log statements less important than this priority are compiled out. This is
+ * normally set at configuration time (e.g. meson's 'log-level' option).
+ */
+#ifndef TIZ_LOG_MAX_PRIORITY
+#define TIZ_LOG_MAX_PRIORITY TIZ_PRIORITY_TRACE
+#endif
+
+/**
+ * Per-call-site cache of a log category handle and its effective
+ * priority. Every TIZ_LOG statement owns one of these (a function-local
+ * static), so that the category lookup happens only once, and not on every
+ * call. The cache is invalidated by bumping tiz_log_generation, which
+ * tiz_log_init and tiz_log_deinit do.
+ */
+typedef struct tiz_log_site tiz_log_site_t;
+struct tiz_log_site
+{
+  const void * p_category;
+  int priority;
+  unsigned int generation;
+  unsigned int id; /* Used by the asynchronous backend (see tizlogring.h) */
+};
+
+extern unsigned int tiz_log_generation;
+
+void
+tiz_log_site_update (tiz_log_site_t * ap_site, const char * ap_cat_name);
+
+static inline int
+tiz_log_site_is_enabled (tiz_log_site_t * ap_site, const char * ap_cat_name,
+                         const int a_priority)
+{
+  if (__atomic_load_n (&ap_site->generation, __ATOMIC_ACQUIRE)
+      != __atomic_load_n (&tiz_log_generation, __ATOMIC_RELAXED))
+    {
+      tiz_log_site_update (ap_site, ap_cat_name);
+    }
+  return ap_site->priority >= a_priority;
+}
+
+/* The priority is checked before any of the arguments are evaluated. */
+#define TIZ_LOG_SITE(priority, p_cname, p_cbuf, format, args...)             \
+  do                                                                         \
+    {                                                                        \
+      static tiz_log_site_t tiz_log_site_ = {NULL, 0, 0, 0};                 \
+      if ((priority) <= TIZ_LOG_MAX_PRIORITY                                 \
+          && tiz_log_site_is_enabled (&tiz_log_site_, TIZ_LOG_CATEGORY_NAME, \
+                                      (priority)))                           \
+        {                                                                    \
+          tiz_log_at_site (&tiz_log_site_, __FILE__, __LINE__, __FUNCTION__, \
+                           TIZ_LOG_CATEGORY_NAME, (priority), p_cname,       \
+                           p_cbuf, format, ##args);                          \
+        }                                                                    \
+    }                                                                        \
+  while (0)
+
+#define TIZ_LOG(priority, format, args...) \
+  TIZ_LOG_SITE (priority, NULL, NULL, format, ##args);
+
 int
 tiz_log_init (void);
 void
@@ -72,6 +128,13 @@ tiz_log (const char * __p_file, int __line, const char * __p_func,
          /*@null@ */ const char * __p_cname,
          /*@null@ */ char * __p_cbuf,
          /*@null@ */ const char * __p_format, ...);
+void
+tiz_log_at_site (tiz_log_site_t * ap_site, const char * __p_file,
+                 int __line, const char * __p_func, const char * __p_cat_name,
+                 int __priority,
+                 /*@null@ */ const char * __p_cname,
+                 /*@null@ */ char * __p_cbuf,
+                 /*@null@ */ const char * __p_format, ...);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,1296 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizlogring.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia Platform - Asynchronous binary logging backend
+ *
+ * Each thread owns a single-producer, single-consumer byte ring. Records are
+ * variable-length and 8-byte aligned; one that does not fit before the end of
+ * the ring is preceded by a padding record that takes up the remaining space.
+ *
+ * Call sites are interned the first time they are recorded: their file,
+ * function, category and format strings are copied into a table that lives
+ * for as long as the process (so that a record remains decodable even if the
+ * plugin that produced it has been unloaded), and the table index is cached in
+ * the tiz_log_site_t. Records only carry that index.
+ *
+ * The arguments are captured by walking the conversions in the format string,
+ * and are rendered later by walking it again, one conversion at a time.
+ *
+ * This file must not use the TIZ_LOG macros.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "tizlogring.h"
+#include "tizplatform_internal.h"
+
+#define LOG_RING_FILE_MAGIC "TIZLOG01"
+#define LOG_RING_MAX_RECORD 1024
+#define LOG_RING_MAX_STRING 256
+#define LOG_RING_MAX_TEXT 4096
+#define LOG_RING_SITE_CHUNK 256
+#define LOG_RING_MAX_SITE_CHUNKS 1024
+#define LOG_RING_DRAIN_PERIOD_MS 20
+#define LOG_RING_PADDING UINT32_MAX
+
+/* Log file chunk types */
+#define LOG_RING_CHUNK_SITE 1
+#define LOG_RING_CHUNK_RECORD 2
+#define LOG_RING_CHUNK_DROPPED 3
+
+#define LOG_RING_ALIGN(n) (((n) + 7) & ~((size_t) 7))
+
+typedef enum log_arg log_arg_t;
+enum log_arg
+{
+  LOG_ARG_NONE = 0, /* "%%" */
+  LOG_ARG_INT,
+  LOG_ARG_LONG,
+  LOG_ARG_LLONG,
+  LOG_ARG_INTMAX,
+  LOG_ARG_SIZE,
+  LOG_ARG_PTRDIFF,
+  LOG_ARG_DOUBLE,
+  LOG_ARG_LDOUBLE,
+  LOG_ARG_PTR,
+  LOG_ARG_STR,
+  LOG_ARG_BAD
+};
+
+typedef struct log_conv log_conv_t;
+struct log_conv
+{
+  const char * p_start; /* The '%' */
+  size_t len;
+  int nstars; /* '*' width and precision arguments */
+  log_arg_t arg;
+};
+
+/* The fixed part of a record; it is followed by the component name
+   (NUL-terminated, possibly empty) and then the arguments */
+typedef struct log_rec log_rec_t;
+struct log_rec
+{
+  uint32_t size; /* Bytes, this header included; a multiple of 8 */
+  uint32_t site_id;
+  uint64_t timestamp; /* Nanoseconds since the epoch */
+  int32_t tid;
+  int32_t priority;
+};
+
+typedef struct log_site_info log_site_info_t;
+struct log_site_info
+{
+  const tiz_log_site_t * p_site;
+  const char * p_format_orig;
+  char * p_cat;
+  char * p_file;
+  char * p_func;
+  char * p_format;
+  int line;
+};
+
+typedef struct log_ring log_ring_t;
+struct log_ring
+{
+  uint8_t * p_data;
+  size_t size;
+  int32_t tid;
+  bool orphaned;
+  log_ring_t * p_next;
+  char pad0[64];
+  uint64_t head; /* Written by the owner thread */
+  uint64_t dropped;
+  char pad1[64];
+  uint64_t tail; /* Written by the drain thread */
+  uint64_t dropped_reported;
+};
+
+static bool g_log_ring_active = false;
+static size_t g_log_ring_size = TIZ_LOG_RING_DEFAULT_SIZE;
+static FILE * gp_log_ring_file = NULL;
+static pthread_t g_log_ring_thread;
+static bool g_log_ring_stopping = false;
+static pthread_mutex_t g_log_ring_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_log_ring_drain_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_log_ring_drain_cond = PTHREAD_COND_INITIALIZER;
+static uint64_t g_log_ring_records = 0;
+static uint64_t g_log_ring_dropped = 0;
+
+/* Registered rings; the list is only modified with g_log_ring_list_lock
+   held */
+static log_ring_t * gp_log_rings = NULL;
+static pthread_mutex_t g_log_ring_list_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t g_log_ring_key;
+static pthread_once_t g_log_ring_key_once = PTHREAD_ONCE_INIT;
+static __thread log_ring_t * tl_p_log_ring = NULL;
+
+/* Interned call sites. Index 0 is never used. Entries never move, so the
+   drain thread reads them without taking the lock. */
+static log_site_info_t * gp_log_sites[LOG_RING_MAX_SITE_CHUNKS];
+static uint32_t g_log_site_count = 0;
+static pthread_mutex_t g_log_site_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t g_log_sites_written = 0;
+
+static inline log_site_info_t *
+site_info (const uint32_t a_id)
+{
+  return &gp_log_sites[a_id / LOG_RING_SITE_CHUNK][a_id % LOG_RING_SITE_CHUNK];
+}
+
+static const char *
+next_conversion (const char * ap_fmt, log_conv_t * ap_conv)
+{
+  const char * p = strchr (ap_fmt, '%');
+  int lmod = 0; /* 'H' for hh, 'Q' for ll, the modifier otherwise */
+
+  if (NULL == p)
+    {
+      return NULL;
+    }
+
+  ap_conv->p_start = p++;
+  ap_conv->nstars = 0;
+  ap_conv->arg = LOG_ARG_BAD;
+
+  if ('%' == *p)
+    {
+      ap_conv->arg = LOG_ARG_NONE;
+      ap_conv->len = 2;
+      return p + 1;
+    }
+
+  while (*p && strchr ("-+ #0'", *p))
+    {
+      ++p;
+    }
+  if ('*' == *p)
+    {
+      ap_conv->nstars++;
+      ++p;
+    }
+  while (isdigit ((unsigned char) *p))
+    {
+      ++p;
+    }
+  if ('.' == *p)
+    {
+      ++p;
+      if ('*' == *p)
+        {
+          ap_conv->nstars++;
+          ++p;
+        }
+      while (isdigit ((unsigned char) *p))
+        {
+          ++p;
+        }
+    }
+
+  switch (*p)
+    {
+      case 'h':
+        lmod = ('h' == p[1]) ? (++p, 'H') : 'h';
+        ++p;
+        break;
+      case 'l':
+        lmod = ('l' == p[1]) ? (++p, 'Q') : 'l';
+        ++p;
+        break;
+      case 'q':
+        lmod = 'Q';
+        ++p;
+        break;
+      case 'j':
+      case 'z':
+      case 't':
+      case 'L':
+        lmod = *p++;
+        break;
+      default:
+        break;
+    };
+
+  switch (*p)
+    {
+      case 'd':
+      case 'i':
+      case 'u':
+      case 'x':
+      case 'X':
+      case 'o':
+      case 'c':
+        {
+          if ('c' == *p && 0 != lmod)
+            {
+              break; /* wint_t */
+            }
+          switch (lmod)
+            {
+              case 0:
+              case 'h':
+              case 'H':
+                ap_conv->arg = LOG_ARG_INT;
+                break;
+              case 'l':
+                ap_conv->arg = LOG_ARG_LONG;
+                break;
+              case 'Q':
+                ap_conv->arg = LOG_ARG_LLONG;
+                break;
+              case 'j':
+                ap_conv->arg = LOG_ARG_INTMAX;
+                break;
+              case 'z':
+                ap_conv->arg = LOG_ARG_SIZE;
+                break;
+              case 't':
+                ap_conv->arg = LOG_ARG_PTRDIFF;
+                break;
+              default:
+                break;
+            };
+        }
+        break;
+      case 'f':
+      case 'F':
+      case 'e':
+      case 'E':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+        {
+          if (0 == lmod || 'l' == lmod)
+            {
+              ap_conv->arg = LOG_ARG_DOUBLE;
+            }
+          else if ('L' == lmod)
+            {
+              ap_conv->arg = LOG_ARG_LDOUBLE;
+            }
+        }
+        break;
+      case 'p':
+        {
+          ap_conv->arg = (0 == lmod) ? LOG_ARG_PTR : LOG_ARG_BAD;
+        }
+        break;
+      case 's':
+        {
+          ap_conv->arg = (0 == lmod) ? LOG_ARG_STR : LOG_ARG_BAD;
+        }
+        break;
+      default:
+        /* %n, %m, wide strings, etc, can not be recorded */
+        break;
+    };
+
+  if ('\0' == *p)
+    {
+      ap_conv->arg = LOG_ARG_BAD;
+      ap_conv->len = p - ap_conv->p_start;
+      return p;
+    }
+
+  ap_conv->len = p + 1 - ap_conv->p_start;
+  return p + 1;
+}
+
+static void
+ring_thread_exit (void * ap_ring)
+{
+  log_ring_t * p_ring = ap_ring;
+  if (p_ring)
+    {
+      __atomic_store_n (&p_ring->orphaned, true, __ATOMIC_RELEASE);
+    }
+}
+
+static void
+make_ring_key (void)
+{
+  (void) pthread_key_create (&g_log_ring_key, ring_thread_exit);
+}
+
+static log_ring_t *
+register_ring (void)
+{
+  log_ring_t * p_ring = calloc (1, sizeof (log_ring_t));
+  if (p_ring)
+    {
+      p_ring->size = __atomic_load_n (&g_log_ring_size, __ATOMIC_RELAXED);
+      p_ring->p_data = malloc (p_ring->size);
+      if (NULL == p_ring->p_data)
+        {
+          free (p_ring);
+          return NULL;
+        }
+      p_ring->tid = syscall (SYS_gettid);
+      (void) pthread_once (&g_log_ring_key_once, make_ring_key);
+      (void) pthread_setspecific (g_log_ring_key, p_ring);
+      pthread_mutex_lock (&g_log_ring_list_lock);
+      p_ring->p_next = gp_log_rings;
+      gp_log_rings = p_ring;
+      pthread_mutex_unlock (&g_log_ring_list_lock);
+      tl_p_log_ring = p_ring;
+    }
+  return p_ring;
+}
+
+static char *
+copy_string (const char * ap_str)
+{
+  return strdup (ap_str ? ap_str : "");
+}
+
+static uint32_t
+intern_site (tiz_log_site_t * ap_site, const char * ap_file, int a_line,
+             const char * ap_func, const char * ap_cat_name,
+             const char * ap_format)
+{
+  uint32_t id = 0;
+  log_site_info_t * p_info = NULL;
+
+  pthread_mutex_lock (&g_log_site_lock);
+  if (0 == g_log_site_count)
+    {
+      g_log_site_count = 1; /* 0 means "not interned" */
+    }
+  id = g_log_site_count;
+  if (id / LOG_RING_SITE_CHUNK >= LOG_RING_MAX_SITE_CHUNKS)
+    {
+      id = 0;
+      goto end;
+    }
+  if (NULL == gp_log_sites[id / LOG_RING_SITE_CHUNK])
+    {
+      gp_log_sites[id / LOG_RING_SITE_CHUNK]
+        = calloc (LOG_RING_SITE_CHUNK, sizeof (log_site_info_t));
+      if (NULL == gp_log_sites[id / LOG_RING_SITE_CHUNK])
+        {
+          id = 0;
+          goto end;
+        }
+    }
+
+  p_info = site_info (id);
+  p_info->p_site = ap_site;
+  p_info->p_format_orig = ap_format;
+  p_info->p_cat = copy_string (ap_cat_name);
+  p_info->p_file = copy_string (ap_file);
+  p_info->p_func = copy_string (ap_func);
+  p_info->p_format = copy_string (ap_format);
+  p_info->line = a_line;
+  __atomic_store_n (&g_log_site_count, id + 1, __ATOMIC_RELEASE);
+  __atomic_store_n (&ap_site->id, id, __ATOMIC_RELAXED);
+
+end:
+  pthread_mutex_unlock (&g_log_site_lock);
+  return id;
+}
+
+static uint32_t
+lookup_site (tiz_log_site_t * ap_site, const char * ap_file, int a_line,
+             const char * ap_func, const char * ap_cat_name,
+             const char * ap_format)
+{
+  uint32_t id = __atomic_load_n (&ap_site->id, __ATOMIC_RELAXED);
+  if (id > 0)
+    {
+      const log_site_info_t * p_info = site_info (id);
+      if (p_info->p_site == ap_site)
+        {
+          /* The same site with a different format string can not be
+             recorded */
+          return (p_info->p_format_orig == ap_format) ? id : 0;
+        }
+    }
+  return intern_site (ap_site, ap_file, a_line, ap_func, ap_cat_name,
+                      ap_format);
+}
+
+static inline bool
+put_bytes (uint8_t ** app_pos, const uint8_t * ap_end, const void * ap_src,
+           size_t a_len)
+{
+  if (*app_pos + a_len > ap_end)
+    {
+      return false;
+    }
+  memcpy (*app_pos, ap_src, a_len);
+  *app_pos += a_len;
+  return true;
+}
+
+static inline bool
+put_string (uint8_t ** app_pos, const uint8_t * ap_end, const char * ap_str)
+{
+  size_t len = strnlen (ap_str, LOG_RING_MAX_STRING - 1);
+  if (*app_pos + len + 1 > ap_end)
+    {
+      if (*app_pos + 1 > ap_end)
+        {
+          return false;
+        }
+      len = ap_end - *app_pos - 1;
+    }
+  memcpy (*app_pos, ap_str, len);
+  (*app_pos)[len] = '\0';
+  *app_pos += len + 1;
+  return true;
+}
+
+static bool
+ring_push (log_ring_t * ap_ring, const uint8_t * ap_rec, const uint32_t a_size)
+{
+  const uint64_t head = ap_ring->head;
+  const uint64_t tail = __atomic_load_n (&ap_ring->tail, __ATOMIC_ACQUIRE);
+  size_t pos = head & (ap_ring->size - 1);
+  const size_t contiguous = ap_ring->size - pos;
+  const size_t needed = a_size + (contiguous < a_size ? contiguous : 0);
+  uint64_t new_head = head;
+
+  if (ap_ring->size - (head - tail) < needed)
+    {
+      __atomic_add_fetch (&ap_ring->dropped, 1, __ATOMIC_RELAXED);
+      return false;
+    }
+
+  if (contiguous < a_size)
+    {
+      log_rec_t * p_pad = (log_rec_t *) (ap_ring->p_data + pos);
+      p_pad->size = contiguous;
+      p_pad->site_id = LOG_RING_PADDING;
+      new_head += contiguous;
+      pos = 0;
+    }
+
+  memcpy (ap_ring->p_data + pos, ap_rec, a_size);
+  __atomic_store_n (&ap_ring->head, new_head + a_size, __ATOMIC_RELEASE);
+  return true;
+}
+
+OMX_BOOL
+tiz_log_ring_write (tiz_log_site_t * ap_site, const char * ap_file,
+                    int a_line, const char * ap_func,
+                    const char * ap_cat_name, int a_priority,
+                    const char * ap_cname, const char * ap_format,
+                    va_list a_va)
+{
+  uint64_t rec_buf[LOG_RING_MAX_RECORD / sizeof (uint64_t)];
+  uint8_t * p_buf = (uint8_t *) rec_buf;
+  uint8_t * p_pos = p_buf + sizeof (log_rec_t);
+  const uint8_t * p_end = p_buf + sizeof (rec_buf);
+  log_rec_t * p_rec = (log_rec_t *) p_buf;
+  log_ring_t * p_ring = tl_p_log_ring;
+  const char * p_fmt = ap_format;
+  log_conv_t conv;
+  struct timespec ts;
+  uint32_t id = 0;
+  bool full = false;
+
+  assert (ap_site);
+
+  if (NULL == ap_format
+      || 0
+           == (id = lookup_site (ap_site, ap_file, a_line, ap_func,
+                                 ap_cat_name, ap_format)))
+    {
+      return OMX_FALSE;
+    }
+
+  if (NULL == p_ring && NULL == (p_ring = register_ring ()))
+    {
+      return OMX_FALSE;
+    }
+
+  (void) put_string (&p_pos, p_end, ap_cname ? ap_cname : "");
+
+  while (!full && NULL != (p_fmt = next_conversion (p_fmt, &conv)))
+    {
+      int64_t ival = 0;
+      int i = 0;
+
+      for (i = 0; i < conv.nstars; ++i)
+        {
+          ival = va_arg (a_va, int);
+          full = full || !put_bytes (&p_pos, p_end, &ival, sizeof (ival));
+        }
+
+      switch (conv.arg)
+        {
+          case LOG_ARG_NONE:
+            break;
+          case LOG_ARG_INT:
+            ival = va_arg (a_va, int);
+            break;
+          case LOG_ARG_LONG:
+            ival = va_arg (a_va, long);
+            break;
+          case LOG_ARG_LLONG:
+            ival = va_arg (a_va, long long);
+            break;
+          case LOG_ARG_INTMAX:
+            ival = va_arg (a_va, intmax_t);
+            break;
+          case LOG_ARG_SIZE:
+            ival = va_arg (a_va, size_t);
+            break;
+          case LOG_ARG_PTRDIFF:
+            ival = va_arg (a_va, ptrdiff_t);
+            break;
+          case LOG_ARG_DOUBLE:
+          case LOG_ARG_LDOUBLE:
+            {
+              double dval = (LOG_ARG_DOUBLE == conv.arg)
+                              ? va_arg (a_va, double)
+                              : (double) va_arg (a_va, long double);
+              full = full || !put_bytes (&p_pos, p_end, &dval, sizeof (dval));
+            }
+            break;
+          case LOG_ARG_PTR:
+            ival = (intptr_t) va_arg (a_va, void *);
+            break;
+          case LOG_ARG_STR:
+            {
+              const char * p_str = va_arg (a_va, const char *);
+              full = full || !put_string (&p_pos, p_end, p_str ? p_str : "(null)");
+            }
+            break;
+          default:
+            return OMX_FALSE;
+        };
+
+      if (LOG_ARG_NONE != conv.arg && LOG_ARG_DOUBLE != conv.arg
+          && LOG_ARG_LDOUBLE != conv.arg && LOG_ARG_STR != conv.arg)
+        {
+          full = full || !put_bytes (&p_pos, p_end, &ival, sizeof (ival));
+        }
+    }
+
+  clock_gettime (CLOCK_REALTIME, &ts);
+  p_rec->size = LOG_RING_ALIGN (p_pos - p_buf);
+  p_rec->site_id = id;
+  p_rec->timestamp = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  p_rec->tid = p_ring->tid;
+  p_rec->priority = a_priority;
+  (void) ring_push (p_ring, p_buf, p_rec->size);
+  return OMX_TRUE;
+}
+
+static inline bool
+get_bytes (const uint8_t ** app_pos, const uint8_t * ap_end, void * ap_dst,
+           size_t a_len)
+{
+  if (*app_pos + a_len > ap_end)
+    {
+      return false;
+    }
+  memcpy (ap_dst, *app_pos, a_len);
+  *app_pos += a_len;
+  return true;
+}
+
+static inline const char *
+get_string (const uint8_t ** app_pos, const uint8_t * ap_end)
+{
+  const char * p_str = (const char *) *app_pos;
+  const uint8_t * p_nul = memchr (*app_pos, '\0', ap_end - *app_pos);
+  if (NULL == p_nul)
+    {
+      return NULL;
+    }
+  *app_pos = p_nul + 1;
+  return p_str;
+}
+
+#define RENDER_CONV(buf, len, spec, stars, value)                        \
+  (0 == (stars) ? snprintf (buf, len, spec, value)                       \
+                : (1 == (stars) ? snprintf (buf, len, spec, (int) star[0], \
+                                            value)                       \
+                                : snprintf (buf, len, spec, (int) star[0], \
+                                            (int) star[1], value)))
+
+/* Renders the message of a record into ap_text. On return, *app_cname points
+   to the component name recorded, or is NULL. */
+static void
+render_message (const log_site_info_t * ap_info, const uint8_t * ap_payload,
+                const uint8_t * ap_end, const char ** app_cname,
+                char * ap_text, size_t a_text_len)
+{
+  const char * p_fmt = ap_info->p_format;
+  const char * p_lit = p_fmt;
+  size_t used = 0;
+  log_conv_t conv;
+  char spec[64];
+
+  *app_cname = get_string (&ap_payload, ap_end);
+  if (*app_cname && '\0' == **app_cname)
+    {
+      *app_cname = NULL;
+    }
+
+  ap_text[0] = '\0';
+  while (used < a_text_len - 1
+         && NULL != (p_fmt = next_conversion (p_lit, &conv)))
+    {
+      int64_t star[2] = {0, 0};
+      int64_t ival = 0;
+      double dval = 0;
+      const char * p_str = NULL;
+      bool ok = true;
+      int n = 0;
+      int i = 0;
+
+      /* The literal text before the conversion */
+      n = snprintf (ap_text + used, a_text_len - used, "%.*s",
+                    (int) (conv.p_start - p_lit), p_lit);
+      used += (n > 0) ? n : 0;
+      used = used < a_text_len ? used : a_text_len - 1;
+      p_lit = p_fmt;
+
+      if (LOG_ARG_NONE == conv.arg)
+        {
+          n = snprintf (ap_text + used, a_text_len - used, "%%");
+          used += (n > 0) ? n : 0;
+          used = used < a_text_len ? used : a_text_len - 1;
+          continue;
+        }
+
+      if (conv.len >= sizeof (spec))
+        {
+          break;
+        }
+      memcpy (spec, conv.p_start, conv.len);
+      spec[conv.len] = '\0';
+
+      for (i = 0; i < conv.nstars && ok; ++i)
+        {
+          ok = get_bytes (&ap_payload, ap_end, &star[i], sizeof (int64_t));
+        }
+      if (ok)
+        {
+          if (LOG_ARG_STR == conv.arg)
+            {
+              ok = NULL != (p_str = get_string (&ap_payload, ap_end));
+            }
+          else if (LOG_ARG_DOUBLE == conv.arg || LOG_ARG_LDOUBLE == conv.arg)
+            {
+              ok = get_bytes (&ap_payload, ap_end, &dval, sizeof (dval));
+            }
+          else
+            {
+              ok = get_bytes (&ap_payload, ap_end, &ival, sizeof (ival));
+            }
+        }
+      if (!ok)
+        {
+          /* Truncated record */
+          n = snprintf (ap_text + used, a_text_len - used, "...");
+          used += (n > 0) ? n : 0;
+          p_lit = "";
+          break;
+        }
+
+      switch (conv.arg)
+        {
+          case LOG_ARG_INT:
+            n = RENDER_CONV (ap_text + used, a_text_len - used, spec,
+                             conv.nstars, (int) ival);
+            break;
+          case LOG_ARG_LONG:
+            n = RENDER_CONV (ap_text + used, a_text_len - used, spec,
+                             conv.nstars, (long) ival);
+            break;
+          case LOG_ARG_LLONG:
+            n = RENDER_CONV (ap_text + used, a_text_len - used, spec,
+                             conv.nstars, (long long) ival);
+            break;
+          case LOG_ARG_INTMAX:
+            n = RENDER_CONV (ap_text + used, a_text_len - used, spec,
+                             conv.nstars, (intmax_t) ival);
+            break;
+          case LOG_ARG_SIZE:
+            n = RENDER_CONV (ap_text + used, a_text_len - used, spec,
+                             conv.nstars, (size_t) ival);
+            break;
+          case LOG_ARG_PTRDIFF:
+            n = RENDER_CONV (ap_text + used, a_text_len - used, spec,
+                             conv.nstars, (ptrdiff_t) ival);
+            break;
+          case LOG_ARG_DOUBLE:
+            n = RENDER_CONV (ap_text + used, a_text_len - used, spec,
+                             conv.nstars, dval);
+            break;
+          case LOG_ARG_LDOUBLE:
+            n = RENDER_CONV (ap_text + used, a_text_len - used, spec,
+                             conv.nstars, (long double) dval);
+            break;
+          case LOG_ARG_PTR:
+            n = RENDER_CONV (ap_text + used, a_text_len - used, spec,
+                             conv.nstars, (void *) (intptr_t) ival);
+            break;
+          case LOG_ARG_STR:
+            n = RENDER_CONV (ap_text + used, a_text_len - used, spec,
+                             conv.nstars, p_str);
+            break;
+          default:
+            n = 0;
+            break;
+        };
+      used += (n > 0) ? n : 0;
+      used = used < a_text_len ? used : a_text_len - 1;
+    }
+
+  /* The literal text after the last conversion */
+  if (used < a_text_len - 1)
+    {
+      snprintf (ap_text + used, a_text_len - used, "%s", p_lit);
+    }
+}
+
+static bool
+write_chunk (FILE * ap_file, const uint32_t a_type, const void * ap_data,
+             const uint32_t a_len)
+{
+  const uint32_t hdr[2] = {a_type, a_len};
+  return (1 == fwrite (hdr, sizeof (hdr), 1, ap_file)
+          && (0 == a_len || 1 == fwrite (ap_data, a_len, 1, ap_file)));
+}
+
+static void
+write_new_sites (FILE * ap_file)
+{
+  const uint32_t count
+    = __atomic_load_n (&g_log_site_count, __ATOMIC_ACQUIRE);
+  uint32_t id = g_log_sites_written > 0 ? g_log_sites_written : 1;
+
+  for (; id < count; ++id)
+    {
+      const log_site_info_t * p_info = site_info (id);
+      const size_t cat_len = strlen (p_info->p_cat) + 1;
+      const size_t file_len = strlen (p_info->p_file) + 1;
+      const size_t func_len = strlen (p_info->p_func) + 1;
+      const size_t fmt_len = strlen (p_info->p_format) + 1;
+      const size_t len = 2 * sizeof (int32_t) + cat_len + file_len + func_len
+                         + fmt_len;
+      uint8_t * p_chunk = malloc (len);
+      if (p_chunk)
+        {
+          uint8_t * p = p_chunk;
+          const int32_t line = p_info->line;
+          memcpy (p, &id, sizeof (id));
+          p += sizeof (id);
+          memcpy (p, &line, sizeof (line));
+          p += sizeof (line);
+          memcpy (p, p_info->p_cat, cat_len);
+          p += cat_len;
+          memcpy (p, p_info->p_file, file_len);
+          p += file_len;
+          memcpy (p, p_info->p_func, func_len);
+          p += func_len;
+          memcpy (p, p_info->p_format, fmt_len);
+          (void) write_chunk (ap_file, LOG_RING_CHUNK_SITE, p_chunk, len);
+          free (p_chunk);
+        }
+    }
+  g_log_sites_written = count;
+}
+
+static void
+process_record (const log_rec_t * ap_rec)
+{
+  const uint32_t count
+    = __atomic_load_n (&g_log_site_count, __ATOMIC_ACQUIRE);
+
+  if (0 == ap_rec->site_id || ap_rec->site_id >= count)
+    {
+      return;
+    }
+
+  if (gp_log_ring_file)
+    {
+      if (ap_rec->site_id >= g_log_sites_written)
+        {
+          write_new_sites (gp_log_ring_file);
+        }
+      (void) write_chunk (gp_log_ring_file, LOG_RING_CHUNK_RECORD, ap_rec,
+                          ap_rec->size);
+    }
+  else
+    {
+      const log_site_info_t * p_info = site_info (ap_rec->site_id);
+      const char * p_cname = NULL;
+      char text[LOG_RING_MAX_TEXT];
+      render_message (p_info, (const uint8_t *) (ap_rec + 1),
+                      (const uint8_t *) ap_rec + ap_rec->size, &p_cname, text,
+                      sizeof (text));
+      tiz_log_forward (p_info->p_cat, p_info->p_file, p_info->line,
+                       p_info->p_func, ap_rec->priority, ap_rec->tid, p_cname,
+                       text);
+    }
+  g_log_ring_records++;
+}
+
+static void
+drain_ring (log_ring_t * ap_ring)
+{
+  const uint64_t head = __atomic_load_n (&ap_ring->head, __ATOMIC_ACQUIRE);
+  const uint64_t dropped
+    = __atomic_load_n (&ap_ring->dropped, __ATOMIC_RELAXED);
+  uint64_t tail = ap_ring->tail;
+
+  while (tail < head)
+    {
+      const log_rec_t * p_rec
+        = (const log_rec_t *) (ap_ring->p_data
+                               + (tail & (ap_ring->size - 1)));
+      if (LOG_RING_PADDING != p_rec->site_id)
+        {
+          process_record (p_rec);
+        }
+      tail += p_rec->size;
+    }
+  __atomic_store_n (&ap_ring->tail, tail, __ATOMIC_RELEASE);
+
+  if (dropped > ap_ring->dropped_reported)
+    {
+      const uint64_t lost = dropped - ap_ring->dropped_reported;
+      ap_ring->dropped_reported = dropped;
+      g_log_ring_dropped += lost;
+      if (gp_log_ring_file)
+        {
+          const int64_t data[2] = {ap_ring->tid, (int64_t) lost};
+          (void) write_chunk (gp_log_ring_file, LOG_RING_CHUNK_DROPPED, data,
+                              sizeof (data));
+        }
+      else
+        {
+          char text[64];
+          snprintf (text, sizeof (text), "%llu log records dropped",
+                    (unsigned long long) lost);
+          tiz_log_forward ("root", __FILE__, __LINE__, __FUNCTION__,
+                           TIZ_PRIORITY_WARN, ap_ring->tid, NULL, text);
+        }
+    }
+}
+
+static void
+drain_rings (void)
+{
+  log_ring_t ** pp_ring = NULL;
+
+  pthread_mutex_lock (&g_log_ring_list_lock);
+  pp_ring = &gp_log_rings;
+  while (*pp_ring)
+    {
+      log_ring_t * p_ring = *pp_ring;
+      const bool orphaned
+        = __atomic_load_n (&p_ring->orphaned, __ATOMIC_ACQUIRE);
+      drain_ring (p_ring);
+      if (orphaned)
+        {
+          *pp_ring = p_ring->p_next;
+          free (p_ring->p_data);
+          free (p_ring);
+        }
+      else
+        {
+          pp_ring = &p_ring->p_next;
+        }
+    }
+  pthread_mutex_unlock (&g_log_ring_list_lock);
+
+  if (gp_log_ring_file)
+    {
+      (void) fflush (gp_log_ring_file);
+    }
+}
+
+static void *
+drain_thread_func (void * ap_arg)
+{
+  bool stopping = false;
+  (void) ap_arg;
+  (void) pthread_setname_np (pthread_self (), "tizlogring");
+
+  while (!stopping)
+    {
+      struct timespec deadline;
+      clock_gettime (CLOCK_REALTIME, &deadline);
+      deadline.tv_nsec += LOG_RING_DRAIN_PERIOD_MS * 1000000L;
+      if (deadline.tv_nsec >= 1000000000L)
+        {
+          deadline.tv_sec++;
+          deadline.tv_nsec -= 1000000000L;
+        }
+      pthread_mutex_lock (&g_log_ring_drain_lock);
+      if (!g_log_ring_stopping)
+        {
+          (void) pthread_cond_timedwait (&g_log_ring_drain_cond,
+                                         &g_log_ring_drain_lock, &deadline);
+        }
+      stopping = g_log_ring_stopping;
+      pthread_mutex_unlock (&g_log_ring_drain_lock);
+      drain_rings ();
+    }
+
+  return NULL;
+}
+
+OMX_ERRORTYPE
+tiz_log_ring_start (const char * ap_file, size_t a_ring_size)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  size_t size = TIZ_LOG_RING_DEFAULT_SIZE;
+
+  pthread_mutex_lock (&g_log_ring_lock);
+
+  if (__atomic_load_n (&g_log_ring_active, __ATOMIC_RELAXED))
+    {
+      rc = OMX_ErrorIncorrectStateOperation;
+      goto end;
+    }
+
+  if (ap_file)
+    {
+      const uint32_t hdr[2] = {(uint32_t) getpid (), 0};
+      gp_log_ring_file = fopen (ap_file, "wb");
+      if (NULL == gp_log_ring_file
+          || 1 != fwrite (LOG_RING_FILE_MAGIC, 8, 1, gp_log_ring_file)
+          || 1 != fwrite (hdr, sizeof (hdr), 1, gp_log_ring_file))
+        {
+          rc = OMX_ErrorInsufficientResources;
+          goto end;
+        }
+    }
+
+  /* A power of two, with room for a few of the largest records */
+  if (a_ring_size > 0)
+    {
+      size = 4 * LOG_RING_MAX_RECORD;
+      while (size < a_ring_size)
+        {
+          size <<= 1;
+        }
+    }
+  __atomic_store_n (&g_log_ring_size, size, __ATOMIC_RELAXED);
+
+  g_log_ring_records = 0;
+  g_log_ring_dropped = 0;
+  g_log_sites_written = 0;
+  g_log_ring_stopping = false;
+  if (0 != pthread_create (&g_log_ring_thread, NULL, drain_thread_func, NULL))
+    {
+      rc = OMX_ErrorInsufficientResources;
+      goto end;
+    }
+
+  __atomic_store_n (&g_log_ring_active, true, __ATOMIC_RELEASE);
+
+end:
+  if (OMX_ErrorNone != rc && OMX_ErrorIncorrectStateOperation != rc
+      && gp_log_ring_file)
+    {
+      fclose (gp_log_ring_file);
+      gp_log_ring_file = NULL;
+    }
+  pthread_mutex_unlock (&g_log_ring_lock);
+  return rc;
+}
+
+void
+tiz_log_ring_stop (void)
+{
+  pthread_mutex_lock (&g_log_ring_lock);
+
+  if (__atomic_load_n (&g_log_ring_active, __ATOMIC_RELAXED))
+    {
+      __atomic_store_n (&g_log_ring_active, false, __ATOMIC_RELEASE);
+
+      pthread_mutex_lock (&g_log_ring_drain_lock);
+      g_log_ring_stopping = true;
+      pthread_cond_signal (&g_log_ring_drain_cond);
+      pthread_mutex_unlock (&g_log_ring_drain_lock);
+      (void) pthread_join (g_log_ring_thread, NULL);
+
+      if (gp_log_ring_file)
+        {
+          fclose (gp_log_ring_file);
+          gp_log_ring_file = NULL;
+        }
+
+      /* The calling thread's ring has been drained and is not in use */
+      if (tl_p_log_ring)
+        {
+          (void) pthread_setspecific (g_log_ring_key, NULL);
+          ring_thread_exit (tl_p_log_ring);
+          tl_p_log_ring = NULL;
+          drain_rings ();
+        }
+    }
+
+  pthread_mutex_unlock (&g_log_ring_lock);
+}
+
+OMX_BOOL
+tiz_log_ring_is_active (void)
+{
+  return __atomic_load_n (&g_log_ring_active, __ATOMIC_RELAXED) ? OMX_TRUE
+                                                                  : OMX_FALSE;
+}
+
+void
+tiz_log_ring_get_stats (tiz_log_ring_stats_t * ap_stats)
+{
+  assert (ap_stats);
+  pthread_mutex_lock (&g_log_ring_lock);
+  ap_stats->records = g_log_ring_records;
+  ap_stats->dropped = g_log_ring_dropped;
+  pthread_mutex_unlock (&g_log_ring_lock);
+}
+
+static const char *
+priority_to_str (const int a_priority)
+{
+  switch (a_priority)
+    {
+      case TIZ_PRIORITY_ERROR:
+        return "ERROR";
+      case TIZ_PRIORITY_WARN:
+        return "WARN";
+      case TIZ_PRIORITY_NOTICE:
+        return "NOTICE";
+      case TIZ_PRIORITY_DEBUG:
+        return "DEBUG";
+      case TIZ_PRIORITY_TRACE:
+        return "TRACE";
+      default:
+        break;
+    };
+  return "UNKNOWN";
+}
+
+static void
+dump_record (FILE * ap_out, const uint32_t a_pid,
+             const log_site_info_t * ap_sites, const uint32_t a_nsites,
+             const log_rec_t * ap_rec)
+{
+  const log_site_info_t * p_info = NULL;
+  const char * p_cname = NULL;
+  char text[LOG_RING_MAX_TEXT];
+  time_t secs = ap_rec->timestamp / 1000000000ULL;
+  long millis = (ap_rec->timestamp % 1000000000ULL) / 1000000;
+  struct tm tm;
+
+  if (ap_rec->site_id >= a_nsites || NULL == ap_sites[ap_rec->site_id].p_format)
+    {
+      fprintf (ap_out, "[PID:%u][TID:%i] --- unknown call site [%u]\n", a_pid,
+               ap_rec->tid, ap_rec->site_id);
+      return;
+    }
+
+  p_info = &ap_sites[ap_rec->site_id];
+  render_message (p_info, (const uint8_t *) (ap_rec + 1),
+                  (const uint8_t *) ap_rec + ap_rec->size, &p_cname, text,
+                  sizeof (text));
+  gmtime_r (&secs, &tm);
+  fprintf (ap_out,
+           "%02d-%02d-%04d %02d:%02d:%02d.%03ld - "
+           "[PID:%u][TID:%i] [%s] [%s] [%s:%s:%i] --- %s\n",
+           tm.tm_mday, tm.tm_mon + 1, tm.tm_year + 1900, tm.tm_hour, tm.tm_min,
+           tm.tm_sec, millis, a_pid, ap_rec->tid,
+           priority_to_str (ap_rec->priority),
+           p_cname ? p_cname : p_info->p_cat, p_info->p_file, p_info->p_func,
+           p_info->line, text);
+}
+
+static bool
+dump_site (const uint8_t * ap_chunk, const uint32_t a_len,
+           log_site_info_t ** app_sites, uint32_t * ap_nsites)
+{
+  const uint8_t * p = ap_chunk + 2 * sizeof (int32_t);
+  const uint8_t * p_end = ap_chunk + a_len;
+  log_site_info_t info;
+  uint32_t id = 0;
+  int32_t line = 0;
+
+  if (a_len < 2 * sizeof (int32_t))
+    {
+      return false;
+    }
+  memcpy (&id, ap_chunk, sizeof (id));
+  memcpy (&line, ap_chunk + sizeof (id), sizeof (line));
+  memset (&info, 0, sizeof (info));
+  info.line = line;
+  if (NULL == (info.p_cat = (char *) get_string (&p, p_end))
+      || NULL == (info.p_file = (char *) get_string (&p, p_end))
+      || NULL == (info.p_func = (char *) get_string (&p, p_end))
+      || NULL == (info.p_format = (char *) get_string (&p, p_end))
+      || id >= LOG_RING_MAX_SITE_CHUNKS * LOG_RING_SITE_CHUNK)
+    {
+      return false;
+    }
+
+  if (id >= *ap_nsites)
+    {
+      log_site_info_t * p_sites
+        = realloc (*app_sites, (id + 1) * sizeof (log_site_info_t));
+      if (NULL == p_sites)
+        {
+          return false;
+        }
+      memset (p_sites + *ap_nsites, 0,
+              (id + 1 - *ap_nsites) * sizeof (log_site_info_t));
+      *app_sites = p_sites;
+      *ap_nsites = id + 1;
+    }
+
+  info.p_cat = copy_string (info.p_cat);
+  info.p_file = copy_string (info.p_file);
+  info.p_func = copy_string (info.p_func);
+  info.p_format = copy_string (info.p_format);
+  free ((*app_sites)[id].p_cat);
+  free ((*app_sites)[id].p_file);
+  free ((*app_sites)[id].p_func);
+  free ((*app_sites)[id].p_format);
+  (*app_sites)[id] = info;
+  return true;
+}
+
+OMX_ERRORTYPE
+tiz_log_ring_dump (const char * ap_file, FILE * ap_out)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  log_site_info_t * p_sites = NULL;
+  uint32_t nsites = 0;
+  uint64_t chunk_buf[LOG_RING_MAX_TEXT / sizeof (uint64_t)];
+  uint8_t * p_chunk = (uint8_t *) chunk_buf;
+  char magic[8];
+  uint32_t hdr[2];
+  uint32_t pid = 0;
+  uint32_t i = 0;
+  FILE * p_file = NULL;
+
+  assert (ap_file);
+  assert (ap_out);
+
+  if (NULL == (p_file = fopen (ap_file, "rb")))
+    {
+      return OMX_ErrorContentURIError;
+    }
+
+  if (1 != fread (magic, sizeof (magic), 1, p_file)
+      || 0 != memcmp (magic, LOG_RING_FILE_MAGIC, sizeof (magic))
+      || 1 != fread (hdr, sizeof (hdr), 1, p_file))
+    {
+      rc = OMX_ErrorStreamCorrupt;
+      goto end;
+    }
+  pid = hdr[0];
+
+  while (1 == fread (hdr, sizeof (hdr), 1, p_file))
+    {
+      if (hdr[1] > sizeof (chunk_buf)
+          || (hdr[1] > 0 && 1 != fread (p_chunk, hdr[1], 1, p_file)))
+        {
+          rc = OMX_ErrorStreamCorrupt;
+          goto end;
+        }
+
+      switch (hdr[0])
+        {
+          case LOG_RING_CHUNK_SITE:
+            {
+              if (!dump_site (p_chunk, hdr[1], &p_sites, &nsites))
+                {
+                  rc = OMX_ErrorStreamCorrupt;
+                  goto end;
+                }
+            }
+            break;
+          case LOG_RING_CHUNK_RECORD:
+            {
+              const log_rec_t * p_rec = (const log_rec_t *) p_chunk;
+              if (hdr[1] < sizeof (log_rec_t) || p_rec->size != hdr[1])
+                {
+                  rc = OMX_ErrorStreamCorrupt;
+                  goto end;
+                }
+              dump_record (ap_out, pid, p_sites, nsites, p_rec);
+            }
+            break;
+          case LOG_RING_CHUNK_DROPPED:
+            {
+              int64_t data[2];
+              if (hdr[1] != sizeof (data))
+                {
+                  rc = OMX_ErrorStreamCorrupt;
+                  goto end;
+                }
+              memcpy (data, p_chunk, sizeof (data));
+              fprintf (ap_out, "[PID:%u][TID:%i] --- %lld log records dropped\n",
+                       pid, (int) data[0], (long long) data[1]);
+            }
+            break;
+          default:
+            /* Unknown chunks are skipped */
+            break;
+        };
+    }
+
+  if (!feof (p_file))
+    {
+      rc = OMX_ErrorStreamCorrupt;
+    }
+
+end:
+  for (i = 0; i < nsites; ++i)
+    {
+      free (p_sites[i].p_cat);
+      free (p_sites[i].p_file);
+      free (p_sites[i].p_func);
+      free (p_sites[i].p_format);
+    }
+  free (p_sites);
+  fclose (p_file);
+  return rc;
+}
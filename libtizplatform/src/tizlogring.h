@@ -0,0 +1,160 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizlogring.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia Platform - Asynchronous binary logging backend
+ *
+ *
+ */
+
+#ifndef TIZLOGRING_H
+#define TIZLOGRING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup tizlogring Asynchronous binary logging backend
+ *
+ * An optional backend for the TIZ_LOG family of macros that keeps formatting
+ * and I/O off the calling thread. While it is active, every enabled log
+ * statement stores a small binary record (timestamp, thread id, call-site id
+ * and the raw values of its arguments) into a lock-free ring that belongs to
+ * the calling thread. A background thread drains the rings, and either
+ * appends the records to a binary log file, to be rendered later with
+ * tiz_log_ring_dump (e.g. 'tizonia --dump-log'), or formats them and hands
+ * them over to log4c.
+ *
+ * When a thread's ring is full, its new records are dropped (and counted)
+ * rather than blocking the caller.
+ *
+ * The backend is normally started by tiz_log_init, when the
+ * 'log.ring-buffer' key in tizonia.conf is set to true.
+ *
+ * @ingroup libtizplatform
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stddef.h>
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+#include "tizlog.h"
+
+/**
+ * The default size in bytes of each thread's ring.
+ * @ingroup tizlogring
+ */
+#define TIZ_LOG_RING_DEFAULT_SIZE (64 * 1024)
+
+/**
+ * Backend statistics.
+ * @ingroup tizlogring
+ */
+typedef struct tiz_log_ring_stats tiz_log_ring_stats_t;
+struct tiz_log_ring_stats
+{
+  OMX_U64 records; /**< Records drained so far */
+  OMX_U64 dropped; /**< Records dropped because a ring was full */
+};
+
+/**
+ * Start the backend. From now on, enabled log statements are recorded into
+ * per-thread rings.
+ *
+ * @ingroup tizlogring
+ * @param ap_file The binary log file to write to (it is truncated), or NULL
+ * to format the records in the background and pass them on to log4c.
+ * @param a_ring_size The size of each thread's ring, in bytes (rounded up to
+ * a power of two), or 0 for TIZ_LOG_RING_DEFAULT_SIZE.
+ * @return OMX_ErrorNone on success, OMX_ErrorInsufficientResources if the
+ * file or the drain thread could not be created, OMX_ErrorIncorrectStateOperation
+ * if the backend is already running.
+ */
+OMX_ERRORTYPE
+tiz_log_ring_start (const char * ap_file, size_t a_ring_size);
+
+/**
+ * Stop the backend. Any pending records are drained before this function
+ * returns. If the backend is not running, no operation is performed.
+ *
+ * @ingroup tizlogring
+ */
+void
+tiz_log_ring_stop (void);
+
+/**
+ * Find out whether the backend is running.
+ *
+ * @ingroup tizlogring
+ * @return OMX_TRUE if running, OMX_FALSE otherwise.
+ */
+OMX_BOOL
+tiz_log_ring_is_active (void);
+
+/**
+ * Retrieve the backend statistics of the current (or the last) run.
+ *
+ * @ingroup tizlogring
+ * @param ap_stats The statistics (output).
+ */
+void
+tiz_log_ring_get_stats (tiz_log_ring_stats_t * ap_stats);
+
+/**
+ * Render a binary log file as text, in the same layout as the log4c
+ * appenders use.
+ *
+ * @ingroup tizlogring
+ * @param ap_file The binary log file.
+ * @param ap_out The stream to write the text to.
+ * @return OMX_ErrorNone on success, OMX_ErrorContentURIError if the file can
+ * not be opened, or OMX_ErrorStreamCorrupt if it is not a valid log file (the
+ * records found before the corruption are still rendered).
+ */
+OMX_ERRORTYPE
+tiz_log_ring_dump (const char * ap_file, FILE * ap_out);
+
+/**
+ * Record a log statement into the calling thread's ring.
+ *
+ * @private
+ *
+ * @return OMX_TRUE if the statement has been dealt with (recorded or
+ * dropped), OMX_FALSE if the caller should log it synchronously instead
+ * (e.g. its format string has conversions that can not be recorded).
+ */
+OMX_BOOL
+tiz_log_ring_write (tiz_log_site_t * ap_site, const char * ap_file,
+                    int a_line, const char * ap_func,
+                    const char * ap_cat_name, int a_priority,
+                    const char * ap_cname, const char * ap_format,
+                    va_list a_va);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIZLOGRING_H */
@@ -0,0 +1,366 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizmpscq.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Lock-free multi-producer, single-consumer message queue
+ *
+ * This is a bounded array of cells, each one tagged with a sequence number,
+ * along the lines of Dmitry Vyukov's bounded MPMC queue. Producers claim a
+ * slot by CAS-ing the tail index; the single consumer owns the head index and
+ * needs no atomic read-modify-write at all.
+ *
+ * Blocking is implemented with two futex-based event counts. The waker only
+ * issues a FUTEX_WAKE when it observes that the other side is parked, so in
+ * the common case a send/receive pair costs no system calls.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include "tizplatform.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.platform.mpscq"
+#endif
+
+#define TIZ_MPSCQ_CACHE_LINE_SIZE 64
+
+typedef struct tiz_mpscq_cell tiz_mpscq_cell_t;
+struct tiz_mpscq_cell
+{
+  uint64_t seq;
+  OMX_PTR p_data;
+};
+
+struct tiz_mpscq
+{
+  tiz_mpscq_cell_t * p_cells;
+  OMX_S32 capacity;
+  char pad0[TIZ_MPSCQ_CACHE_LINE_SIZE];
+  /* Written by producers */
+  uint64_t tail;
+  char pad1[TIZ_MPSCQ_CACHE_LINE_SIZE];
+  /* Written by the consumer */
+  uint64_t head;
+  char pad2[TIZ_MPSCQ_CACHE_LINE_SIZE];
+  /* Event count the consumer sleeps on when the queue is empty */
+  int32_t not_empty;
+  int32_t consumer_parked;
+  char pad3[TIZ_MPSCQ_CACHE_LINE_SIZE];
+  /* Event count producers sleep on when the queue is full */
+  int32_t not_full;
+  int32_t producers_parked;
+};
+
+static inline int
+futex_wait (int32_t * ap_addr, int32_t a_val, const struct timespec * ap_ts)
+{
+  return syscall (SYS_futex, ap_addr, FUTEX_WAIT_PRIVATE, a_val, ap_ts, NULL,
+                  0);
+}
+
+static inline void
+futex_wake (int32_t * ap_addr, int32_t a_count)
+{
+  (void) syscall (SYS_futex, ap_addr, FUTEX_WAKE_PRIVATE, a_count, NULL, NULL,
+                  0);
+}
+
+static inline uint64_t
+now_millis (void)
+{
+  struct timespec ts;
+  (void) clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+}
+
+static bool
+try_push (tiz_mpscq_t * ap_q, OMX_PTR ap_data)
+{
+  tiz_mpscq_cell_t * p_cell = NULL;
+  uint64_t pos = __atomic_load_n (&(ap_q->tail), __ATOMIC_RELAXED);
+
+  for (;;)
+    {
+      uint64_t seq = 0;
+      int64_t dif = 0;
+      p_cell = &(ap_q->p_cells[pos % ap_q->capacity]);
+      seq = __atomic_load_n (&(p_cell->seq), __ATOMIC_ACQUIRE);
+      dif = (int64_t) seq - (int64_t) pos;
+      if (0 == dif)
+        {
+          if (__atomic_compare_exchange_n (&(ap_q->tail), &pos, pos + 1, true,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+              break;
+            }
+        }
+      else if (dif < 0)
+        {
+          /* Full */
+          return false;
+        }
+      else
+        {
+          pos = __atomic_load_n (&(ap_q->tail), __ATOMIC_RELAXED);
+        }
+    }
+
+  p_cell->p_data = ap_data;
+  __atomic_store_n (&(p_cell->seq), pos + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+static bool
+try_pop (tiz_mpscq_t * ap_q, OMX_PTR * app_data)
+{
+  const uint64_t pos = __atomic_load_n (&(ap_q->head), __ATOMIC_RELAXED);
+  tiz_mpscq_cell_t * p_cell = &(ap_q->p_cells[pos % ap_q->capacity]);
+  const uint64_t seq = __atomic_load_n (&(p_cell->seq), __ATOMIC_ACQUIRE);
+
+  if ((int64_t) seq - (int64_t) (pos + 1) < 0)
+    {
+      /* Empty */
+      return false;
+    }
+
+  *app_data = p_cell->p_data;
+  p_cell->p_data = NULL;
+  __atomic_store_n (&(p_cell->seq), pos + ap_q->capacity, __ATOMIC_RELEASE);
+  __atomic_store_n (&(ap_q->head), pos + 1, __ATOMIC_RELAXED);
+  return true;
+}
+
+static inline void
+wake_consumer (tiz_mpscq_t * ap_q)
+{
+  /* Pairs with the fence in wait_not_empty */
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  if (__atomic_load_n (&(ap_q->consumer_parked), __ATOMIC_RELAXED))
+    {
+      (void) __atomic_add_fetch (&(ap_q->not_empty), 1, __ATOMIC_RELEASE);
+      futex_wake (&(ap_q->not_empty), 1);
+    }
+}
+
+static inline void
+wake_producers (tiz_mpscq_t * ap_q)
+{
+  /* Pairs with the fence in tiz_mpscq_send */
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  if (__atomic_load_n (&(ap_q->producers_parked), __ATOMIC_RELAXED) > 0)
+    {
+      (void) __atomic_add_fetch (&(ap_q->not_full), 1, __ATOMIC_RELEASE);
+      futex_wake (&(ap_q->not_full), INT_MAX);
+    }
+}
+
+/* Returns false if a_millis elapsed without an item being retrieved. A
+   negative a_millis means 'wait forever'. */
+static bool
+wait_and_pop (tiz_mpscq_t * ap_q, OMX_PTR * app_data, int64_t a_millis)
+{
+  const uint64_t deadline = a_millis < 0 ? 0 : now_millis () + a_millis;
+
+  for (;;)
+    {
+      struct timespec ts;
+      struct timespec * p_ts = NULL;
+      int32_t key = 0;
+
+      if (try_pop (ap_q, app_data))
+        {
+          return true;
+        }
+
+      if (a_millis >= 0)
+        {
+          const uint64_t now = now_millis ();
+          if (now >= deadline)
+            {
+              return false;
+            }
+          ts.tv_sec = (deadline - now) / 1000;
+          ts.tv_nsec = ((deadline - now) % 1000) * 1000000;
+          p_ts = &ts;
+        }
+
+      key = __atomic_load_n (&(ap_q->not_empty), __ATOMIC_ACQUIRE);
+      __atomic_store_n (&(ap_q->consumer_parked), 1, __ATOMIC_RELAXED);
+      /* Pairs with the fence in wake_consumer */
+      __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+      if (try_pop (ap_q, app_data))
+        {
+          __atomic_store_n (&(ap_q->consumer_parked), 0, __ATOMIC_RELAXED);
+          return true;
+        }
+
+      (void) futex_wait (&(ap_q->not_empty), key, p_ts);
+      __atomic_store_n (&(ap_q->consumer_parked), 0, __ATOMIC_RELAXED);
+    }
+}
+
+OMX_ERRORTYPE
+tiz_mpscq_init (tiz_mpscq_ptr_t * app_q, OMX_S32 a_capacity)
+{
+  tiz_mpscq_t * p_q = NULL;
+  OMX_S32 i = 0;
+
+  assert (app_q);
+  assert (a_capacity > 0);
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "queue capacity [%d]", a_capacity);
+
+  if (!(p_q = (tiz_mpscq_t *) tiz_mem_calloc (1, sizeof (tiz_mpscq_t))))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "OMX_ErrorInsufficientResources: "
+               "Could not instantiate queue struct.");
+      return OMX_ErrorInsufficientResources;
+    }
+
+  if (!(p_q->p_cells = (tiz_mpscq_cell_t *) tiz_mem_calloc (
+          a_capacity, sizeof (tiz_mpscq_cell_t))))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "[OMX_ErrorInsufficientResources]: "
+               "Could not instantiate queue items.");
+      tiz_mem_free (p_q);
+      return OMX_ErrorInsufficientResources;
+    }
+
+  p_q->capacity = a_capacity;
+  for (i = 0; i < a_capacity; ++i)
+    {
+      p_q->p_cells[i].seq = i;
+    }
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "queue created [%p]", p_q);
+  *app_q = p_q;
+  return OMX_ErrorNone;
+}
+
+void
+tiz_mpscq_destroy (tiz_mpscq_t * ap_q)
+{
+  if (ap_q)
+    {
+      tiz_mem_free (ap_q->p_cells);
+      tiz_mem_free (ap_q);
+    }
+}
+
+OMX_ERRORTYPE
+tiz_mpscq_send (tiz_mpscq_t * ap_q, OMX_PTR ap_data)
+{
+  assert (ap_q);
+  assert (ap_data);
+
+  while (!try_push (ap_q, ap_data))
+    {
+      const int32_t key = __atomic_load_n (&(ap_q->not_full), __ATOMIC_ACQUIRE);
+      (void) __atomic_add_fetch (&(ap_q->producers_parked), 1,
+                                 __ATOMIC_RELAXED);
+      /* Pairs with the fence in wake_producers */
+      __atomic_thread_fence (__ATOMIC_SEQ_CST);
+      if (!try_push (ap_q, ap_data))
+        {
+          (void) futex_wait (&(ap_q->not_full), key, NULL);
+          (void) __atomic_sub_fetch (&(ap_q->producers_parked), 1,
+                                     __ATOMIC_RELAXED);
+        }
+      else
+        {
+          (void) __atomic_sub_fetch (&(ap_q->producers_parked), 1,
+                                     __ATOMIC_RELAXED);
+          break;
+        }
+    }
+
+  wake_consumer (ap_q);
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_mpscq_receive (tiz_mpscq_t * ap_q, OMX_PTR * app_data)
+{
+  assert (ap_q);
+  assert (app_data);
+
+  (void) wait_and_pop (ap_q, app_data, -1);
+  assert (*app_data);
+  wake_producers (ap_q);
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_mpscq_timed_receive (tiz_mpscq_t * ap_q, OMX_PTR * app_data,
+                         OMX_U32 a_millis)
+{
+  assert (ap_q);
+  assert (app_data);
+
+  if (!wait_and_pop (ap_q, app_data, a_millis))
+    {
+      return OMX_ErrorTimeout;
+    }
+
+  wake_producers (ap_q);
+  return OMX_ErrorNone;
+}
+
+OMX_S32
+tiz_mpscq_capacity (tiz_mpscq_t * ap_q)
+{
+  assert (ap_q);
+  return ap_q->capacity;
+}
+
+OMX_S32
+tiz_mpscq_length (tiz_mpscq_t * ap_q)
+{
+  uint64_t head = 0;
+  uint64_t tail = 0;
+
+  assert (ap_q);
+
+  head = __atomic_load_n (&(ap_q->head), __ATOMIC_ACQUIRE);
+  tail = __atomic_load_n (&(ap_q->tail), __ATOMIC_ACQUIRE);
+
+  /* tail counts claimed (possibly not yet published) slots */
+  return tail > head ? (OMX_S32) MIN (tail - head, (uint64_t) ap_q->capacity)
+                     : 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizmpscq.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Lock-free multi-producer, single-consumer message queue
+ *
+ *
+ */
+
+#ifndef TIZMPSCQ_H
+#define TIZMPSCQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup tizmpscq Lock-free MPSC message queue
+ *
+ * Bounded, lock-free FIFO queue that supports any number of concurrent
+ * producers and exactly one consumer. Threads only enter the kernel (via
+ * futex) when the consumer is parked on an empty queue or a producer is
+ * parked on a full one. The API mirrors @ref tizqueue so that it can be used
+ * as a drop-in replacement where the single-consumer restriction holds.
+ *
+ * @ingroup libtizplatform
+ */
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+/**
+ * MPSC queue opaque structure.
+ * @ingroup tizmpscq
+ */
+typedef struct tiz_mpscq tiz_mpscq_t;
+typedef /*@null@ */ tiz_mpscq_t * tiz_mpscq_ptr_t;
+
+/**
+ * Initialize a new empty queue.
+ *
+ * @ingroup tizmpscq
+ *
+ * @param a_capacity Maximum number of items that can be send into the queue.
+ *
+ * @return OMX_ErrorNone if success, OMX_ErrorInsufficientResources otherwise.
+ */
+OMX_ERRORTYPE
+tiz_mpscq_init (/*@out@*/ tiz_mpscq_ptr_t * app_q, OMX_S32 a_capacity);
+
+/**
+ * Destroy a queue. If ap_q is NULL, no operation is performed.
+ *
+ * @ingroup tizmpscq
+ *
+ */
+void
+tiz_mpscq_destroy (/*@null@ */ tiz_mpscq_t * ap_q);
+
+/**
+ * Add an item onto the end of the queue. May be called concurrently from any
+ * number of threads. If the queue is full, it blocks until a space becomes
+ * available.
+ *
+ * @ingroup tizmpscq
+ *
+ */
+OMX_ERRORTYPE
+tiz_mpscq_send (tiz_mpscq_t * ap_q, OMX_PTR ap_data);
+
+/**
+ * Retrieve an item from the head of the queue. If the queue is empty, it
+ * blocks until an item becomes available. Only one thread may be receiving at
+ * any given time.
+ *
+ * @ingroup tizmpscq
+ *
+ */
+OMX_ERRORTYPE
+tiz_mpscq_receive (tiz_mpscq_t * ap_q, OMX_PTR * app_data);
+
+/**
+ * Retrieve an item from the head of the queue. If the queue is empty, it waits
+ * for up to a_millis milliseconds or until an item becomes available.
+ *
+ * @ingroup tizmpscq
+ *
+ * @return OMX_ErrorNone if an item was retrieved, OMX_ErrorTimeout otherwise.
+ */
+OMX_ERRORTYPE
+tiz_mpscq_timed_receive (tiz_mpscq_t * ap_q, OMX_PTR * app_data,
+                         OMX_U32 a_millis);
+
+/**
+ * Retrieve the maximum number of items that can be stored in the queue.
+ *
+ * @ingroup tizmpscq
+ *
+ */
+OMX_S32
+tiz_mpscq_capacity (tiz_mpscq_t * ap_q);
+
+/**
+ * Retrieve the number of items currently stored in the queue. The value is a
+ * snapshot and may be stale by the time it is returned when producers are
+ * active.
+ *
+ * @ingroup tizmpscq
+ *
+ */
+OMX_S32
+tiz_mpscq_length (tiz_mpscq_t * ap_q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIZMPSCQ_H */
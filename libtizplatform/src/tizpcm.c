@@ -0,0 +1,1122 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizpcm.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia Platform - PCM sample processing kernels
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "tizplatform.h"
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TIZ_PCM_X86 1
+#include <immintrin.h>
+#define TIZ_PCM_SSE2 __attribute__ ((target ("sse2")))
+#define TIZ_PCM_AVX2 __attribute__ ((target ("avx2")))
+#elif defined(__aarch64__)
+#define TIZ_PCM_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.platform.pcm"
+#endif
+
+/* Largest float values that still convert to a valid integer sample. Every
+   implementation clamps to these before the conversion, so that all of them
+   round and saturate in exactly the same way. */
+#define PCM_S16_MAX 32767.f
+#define PCM_S16_MIN -32768.f
+#define PCM_S24_MAX 8388607.f
+#define PCM_S24_MIN -8388608.f
+#define PCM_S32_MAX 2147483520.f
+#define PCM_S32_MIN -2147483648.f
+
+typedef void (*pcm_gain_s16_f) (int16_t * ap_pcm, size_t a_n, float a_gain);
+typedef void (*pcm_gain_s32_f) (int32_t * ap_pcm, size_t a_n, float a_gain);
+typedef void (*pcm_gain_flt_f) (float * ap_pcm, size_t a_n, float a_gain);
+typedef void (*pcm_ramp_s16_f) (int16_t * ap_pcm, size_t a_nframes,
+                                unsigned a_nch, float a_from, float a_step);
+typedef void (*pcm_ramp_flt_f) (float * ap_pcm, size_t a_nframes,
+                                unsigned a_nch, float a_from, float a_step);
+typedef void (*pcm_swap16_f) (uint16_t * ap_pcm, size_t a_n);
+typedef void (*pcm_swap32_f) (uint32_t * ap_pcm, size_t a_n);
+typedef void (*pcm_dup16_f) (int16_t * ap_dst, const int16_t * ap_src,
+                             size_t a_nframes);
+typedef void (*pcm_dup32_f) (int32_t * ap_dst, const int32_t * ap_src,
+                             size_t a_nframes);
+
+/* The kernels that have vectorized implementations. Everything else (packed
+   24-bit samples, unusual channel layouts) is handled in plain C. */
+typedef struct tiz_pcm_ops tiz_pcm_ops_t;
+struct tiz_pcm_ops
+{
+  tiz_pcm_isa_t isa;
+  pcm_gain_s16_f pf_gain_s16;
+  pcm_gain_s32_f pf_gain_s32;
+  pcm_gain_flt_f pf_gain_flt;
+  pcm_ramp_s16_f pf_ramp_s16; /* 1, 2 or 4 channels */
+  pcm_ramp_flt_f pf_ramp_flt; /* 1, 2 or 4 channels */
+  pcm_swap16_f pf_swap16;
+  pcm_swap32_f pf_swap32;
+  pcm_dup16_f pf_dup16; /* mono to stereo */
+  pcm_dup32_f pf_dup32; /* mono to stereo */
+};
+
+static pthread_once_t g_pcm_once = PTHREAD_ONCE_INIT;
+static const tiz_pcm_ops_t * gp_pcm_ops = NULL;
+
+/*
+ * Scalar kernels. The vectorized kernels use these for the samples left
+ * over at the end of the buffer.
+ */
+
+static inline float
+clampf (const float a_val, const float a_min, const float a_max)
+{
+  return a_val > a_max ? a_max : (a_val < a_min ? a_min : a_val);
+}
+
+static inline int32_t
+s24_load (const uint8_t * ap_pcm)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  const uint32_t u = ((uint32_t) ap_pcm[0] << 24) | ((uint32_t) ap_pcm[1] << 16)
+                     | ((uint32_t) ap_pcm[2] << 8);
+#else
+  const uint32_t u = ((uint32_t) ap_pcm[2] << 24) | ((uint32_t) ap_pcm[1] << 16)
+                     | ((uint32_t) ap_pcm[0] << 8);
+#endif
+  return (int32_t) u >> 8;
+}
+
+static inline void
+s24_store (uint8_t * ap_pcm, const int32_t a_val)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  ap_pcm[0] = (uint8_t) (a_val >> 16);
+  ap_pcm[1] = (uint8_t) (a_val >> 8);
+  ap_pcm[2] = (uint8_t) a_val;
+#else
+  ap_pcm[0] = (uint8_t) a_val;
+  ap_pcm[1] = (uint8_t) (a_val >> 8);
+  ap_pcm[2] = (uint8_t) (a_val >> 16);
+#endif
+}
+
+static void
+gain_s16_scalar (int16_t * ap_pcm, size_t a_n, float a_gain)
+{
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i)
+    {
+      const float f = clampf ((float) ap_pcm[i] * a_gain, PCM_S16_MIN,
+                              PCM_S16_MAX);
+      ap_pcm[i] = (int16_t) lrintf (f);
+    }
+}
+
+static void
+gain_s24_scalar (uint8_t * ap_pcm, size_t a_n, float a_gain)
+{
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i, ap_pcm += 3)
+    {
+      const float f = clampf ((float) s24_load (ap_pcm) * a_gain, PCM_S24_MIN,
+                              PCM_S24_MAX);
+      s24_store (ap_pcm, (int32_t) lrintf (f));
+    }
+}
+
+static void
+gain_s32_scalar (int32_t * ap_pcm, size_t a_n, float a_gain)
+{
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i)
+    {
+      const float f = clampf ((float) ap_pcm[i] * a_gain, PCM_S32_MIN,
+                              PCM_S32_MAX);
+      ap_pcm[i] = (int32_t) lrintf (f);
+    }
+}
+
+static void
+gain_flt_scalar (float * ap_pcm, size_t a_n, float a_gain)
+{
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i)
+    {
+      ap_pcm[i] = clampf (ap_pcm[i] * a_gain, -1.f, 1.f);
+    }
+}
+
+/* The ramp kernels process frames [a_first, a_nframes). */
+static void
+ramp_scalar (void * ap_pcm, const tiz_pcm_fmt_t a_fmt, size_t a_first,
+             size_t a_nframes, unsigned a_nch, float a_from, float a_step)
+{
+  size_t i = 0;
+  unsigned c = 0;
+  for (i = a_first; i < a_nframes; ++i)
+    {
+      const float gain = a_from + a_step * (float) i;
+      for (c = 0; c < a_nch; ++c)
+        {
+          const size_t s = i * a_nch + c;
+          switch (a_fmt)
+            {
+              case TIZ_PCM_FMT_S16:
+                {
+                  gain_s16_scalar ((int16_t *) ap_pcm + s, 1, gain);
+                }
+                break;
+              case TIZ_PCM_FMT_S24:
+                {
+                  gain_s24_scalar ((uint8_t *) ap_pcm + s * 3, 1, gain);
+                }
+                break;
+              case TIZ_PCM_FMT_S32:
+                {
+                  gain_s32_scalar ((int32_t *) ap_pcm + s, 1, gain);
+                }
+                break;
+              case TIZ_PCM_FMT_FLOAT:
+                {
+                  gain_flt_scalar ((float *) ap_pcm + s, 1, gain);
+                }
+                break;
+              default:
+                {
+                  assert (0);
+                }
+                break;
+            };
+        }
+    }
+}
+
+static void
+ramp_s16_scalar (int16_t * ap_pcm, size_t a_nframes, unsigned a_nch,
+                 float a_from, float a_step)
+{
+  ramp_scalar (ap_pcm, TIZ_PCM_FMT_S16, 0, a_nframes, a_nch, a_from, a_step);
+}
+
+static void
+ramp_flt_scalar (float * ap_pcm, size_t a_nframes, unsigned a_nch,
+                 float a_from, float a_step)
+{
+  ramp_scalar (ap_pcm, TIZ_PCM_FMT_FLOAT, 0, a_nframes, a_nch, a_from,
+               a_step);
+}
+
+static void
+swap16_scalar (uint16_t * ap_pcm, size_t a_n)
+{
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i)
+    {
+      ap_pcm[i] = (uint16_t) ((ap_pcm[i] << 8) | (ap_pcm[i] >> 8));
+    }
+}
+
+static void
+swap24_scalar (uint8_t * ap_pcm, size_t a_n)
+{
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i, ap_pcm += 3)
+    {
+      const uint8_t b = ap_pcm[0];
+      ap_pcm[0] = ap_pcm[2];
+      ap_pcm[2] = b;
+    }
+}
+
+static void
+swap32_scalar (uint32_t * ap_pcm, size_t a_n)
+{
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i)
+    {
+      const uint32_t u = ap_pcm[i];
+      ap_pcm[i] = (u << 24) | ((u << 8) & 0x00ff0000u)
+                  | ((u >> 8) & 0x0000ff00u) | (u >> 24);
+    }
+}
+
+static void
+dup16_scalar (int16_t * ap_dst, const int16_t * ap_src, size_t a_nframes)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nframes; ++i)
+    {
+      ap_dst[2 * i] = ap_dst[2 * i + 1] = ap_src[i];
+    }
+}
+
+static void
+dup32_scalar (int32_t * ap_dst, const int32_t * ap_src, size_t a_nframes)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nframes; ++i)
+    {
+      ap_dst[2 * i] = ap_dst[2 * i + 1] = ap_src[i];
+    }
+}
+
+static void
+upmix_scalar (uint8_t * ap_dst, const uint8_t * ap_src, size_t a_nframes,
+              size_t a_sample_size, unsigned a_in, unsigned a_out)
+{
+  size_t i = 0;
+  unsigned c = 0;
+  for (i = 0; i < a_nframes; ++i)
+    {
+      for (c = 0; c < a_out; ++c)
+        {
+          memcpy (ap_dst, ap_src + (c % a_in) * a_sample_size, a_sample_size);
+          ap_dst += a_sample_size;
+        }
+      ap_src += a_in * a_sample_size;
+    }
+}
+
+static const tiz_pcm_ops_t scalar_ops = {
+  TIZ_PCM_ISA_SCALAR, gain_s16_scalar, gain_s32_scalar, gain_flt_scalar,
+  ramp_s16_scalar,    ramp_flt_scalar, swap16_scalar,   swap32_scalar,
+  dup16_scalar,       dup32_scalar,
+};
+
+#ifdef TIZ_PCM_X86
+
+/*
+ * SSE2 kernels
+ */
+
+static TIZ_PCM_SSE2 inline __m128i
+s16x8_scale_sse2 (const __m128i a_pcm, const __m128 a_g_lo, const __m128 a_g_hi)
+{
+  const __m128 vmax = _mm_set1_ps (PCM_S16_MAX);
+  const __m128 vmin = _mm_set1_ps (PCM_S16_MIN);
+  /* Sign-extend to 32 bits */
+  const __m128i lo = _mm_srai_epi32 (_mm_unpacklo_epi16 (a_pcm, a_pcm), 16);
+  const __m128i hi = _mm_srai_epi32 (_mm_unpackhi_epi16 (a_pcm, a_pcm), 16);
+  __m128 flo = _mm_mul_ps (_mm_cvtepi32_ps (lo), a_g_lo);
+  __m128 fhi = _mm_mul_ps (_mm_cvtepi32_ps (hi), a_g_hi);
+  flo = _mm_max_ps (_mm_min_ps (flo, vmax), vmin);
+  fhi = _mm_max_ps (_mm_min_ps (fhi, vmax), vmin);
+  return _mm_packs_epi32 (_mm_cvtps_epi32 (flo), _mm_cvtps_epi32 (fhi));
+}
+
+static TIZ_PCM_SSE2 void
+gain_s16_sse2 (int16_t * ap_pcm, size_t a_n, float a_gain)
+{
+  const __m128 vg = _mm_set1_ps (a_gain);
+  size_t i = 0;
+  for (; i + 8 <= a_n; i += 8)
+    {
+      __m128i * p = (__m128i *) (ap_pcm + i);
+      _mm_storeu_si128 (p, s16x8_scale_sse2 (_mm_loadu_si128 (p), vg, vg));
+    }
+  gain_s16_scalar (ap_pcm + i, a_n - i, a_gain);
+}
+
+static TIZ_PCM_SSE2 void
+gain_s32_sse2 (int32_t * ap_pcm, size_t a_n, float a_gain)
+{
+  const __m128 vg = _mm_set1_ps (a_gain);
+  const __m128 vmax = _mm_set1_ps (PCM_S32_MAX);
+  const __m128 vmin = _mm_set1_ps (PCM_S32_MIN);
+  size_t i = 0;
+  for (; i + 4 <= a_n; i += 4)
+    {
+      __m128i * p = (__m128i *) (ap_pcm + i);
+      __m128 f = _mm_mul_ps (_mm_cvtepi32_ps (_mm_loadu_si128 (p)), vg);
+      f = _mm_max_ps (_mm_min_ps (f, vmax), vmin);
+      _mm_storeu_si128 (p, _mm_cvtps_epi32 (f));
+    }
+  gain_s32_scalar (ap_pcm + i, a_n - i, a_gain);
+}
+
+static TIZ_PCM_SSE2 void
+gain_flt_sse2 (float * ap_pcm, size_t a_n, float a_gain)
+{
+  const __m128 vg = _mm_set1_ps (a_gain);
+  const __m128 vmax = _mm_set1_ps (1.f);
+  const __m128 vmin = _mm_set1_ps (-1.f);
+  size_t i = 0;
+  for (; i + 4 <= a_n; i += 4)
+    {
+      __m128 f = _mm_mul_ps (_mm_loadu_ps (ap_pcm + i), vg);
+      _mm_storeu_ps (ap_pcm + i, _mm_max_ps (_mm_min_ps (f, vmax), vmin));
+    }
+  gain_flt_scalar (ap_pcm + i, a_n - i, a_gain);
+}
+
+/* Frame number of each of the four lanes that follow frame a_first */
+static TIZ_PCM_SSE2 inline __m128
+lane_frames_sse2 (const float a_first, const unsigned a_nch)
+{
+  return _mm_set_ps (a_first + (float) (3 / a_nch), a_first + (float) (2 / a_nch),
+                     a_first + (float) (1 / a_nch), a_first);
+}
+
+static TIZ_PCM_SSE2 void
+ramp_s16_sse2 (int16_t * ap_pcm, size_t a_nframes, unsigned a_nch,
+               float a_from, float a_step)
+{
+  const size_t n = a_nframes * a_nch;
+  const __m128 vfrom = _mm_set1_ps (a_from);
+  const __m128 vstep = _mm_set1_ps (a_step);
+  const __m128 vinc = _mm_set1_ps ((float) (8 / a_nch));
+  __m128 fr_lo = lane_frames_sse2 (0.f, a_nch);
+  __m128 fr_hi = lane_frames_sse2 ((float) (4 / a_nch), a_nch);
+  size_t i = 0;
+  assert (a_nch == 1 || a_nch == 2 || a_nch == 4);
+  for (; i + 8 <= n; i += 8)
+    {
+      __m128i * p = (__m128i *) (ap_pcm + i);
+      const __m128 g_lo = _mm_add_ps (vfrom, _mm_mul_ps (vstep, fr_lo));
+      const __m128 g_hi = _mm_add_ps (vfrom, _mm_mul_ps (vstep, fr_hi));
+      _mm_storeu_si128 (p, s16x8_scale_sse2 (_mm_loadu_si128 (p), g_lo, g_hi));
+      fr_lo = _mm_add_ps (fr_lo, vinc);
+      fr_hi = _mm_add_ps (fr_hi, vinc);
+    }
+  ramp_scalar (ap_pcm, TIZ_PCM_FMT_S16, i / a_nch, a_nframes, a_nch, a_from,
+               a_step);
+}
+
+static TIZ_PCM_SSE2 void
+ramp_flt_sse2 (float * ap_pcm, size_t a_nframes, unsigned a_nch, float a_from,
+               float a_step)
+{
+  const size_t n = a_nframes * a_nch;
+  const __m128 vfrom = _mm_set1_ps (a_from);
+  const __m128 vstep = _mm_set1_ps (a_step);
+  const __m128 vinc = _mm_set1_ps ((float) (4 / a_nch));
+  const __m128 vmax = _mm_set1_ps (1.f);
+  const __m128 vmin = _mm_set1_ps (-1.f);
+  __m128 fr = lane_frames_sse2 (0.f, a_nch);
+  size_t i = 0;
+  assert (a_nch == 1 || a_nch == 2 || a_nch == 4);
+  for (; i + 4 <= n; i += 4)
+    {
+      const __m128 g = _mm_add_ps (vfrom, _mm_mul_ps (vstep, fr));
+      __m128 f = _mm_mul_ps (_mm_loadu_ps (ap_pcm + i), g);
+      _mm_storeu_ps (ap_pcm + i, _mm_max_ps (_mm_min_ps (f, vmax), vmin));
+      fr = _mm_add_ps (fr, vinc);
+    }
+  ramp_scalar (ap_pcm, TIZ_PCM_FMT_FLOAT, i / a_nch, a_nframes, a_nch, a_from,
+               a_step);
+}
+
+static TIZ_PCM_SSE2 void
+swap16_sse2 (uint16_t * ap_pcm, size_t a_n)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_n; i += 8)
+    {
+      __m128i * p = (__m128i *) (ap_pcm + i);
+      const __m128i x = _mm_loadu_si128 (p);
+      _mm_storeu_si128 (p,
+                        _mm_or_si128 (_mm_slli_epi16 (x, 8), _mm_srli_epi16 (x, 8)));
+    }
+  swap16_scalar (ap_pcm + i, a_n - i);
+}
+
+static TIZ_PCM_SSE2 void
+swap32_sse2 (uint32_t * ap_pcm, size_t a_n)
+{
+  size_t i = 0;
+  for (; i + 4 <= a_n; i += 4)
+    {
+      __m128i * p = (__m128i *) (ap_pcm + i);
+      __m128i x = _mm_loadu_si128 (p);
+      /* Swap the 16-bit halves, then the bytes within each half */
+      x = _mm_shufflelo_epi16 (x, _MM_SHUFFLE (2, 3, 0, 1));
+      x = _mm_shufflehi_epi16 (x, _MM_SHUFFLE (2, 3, 0, 1));
+      _mm_storeu_si128 (p,
+                        _mm_or_si128 (_mm_slli_epi16 (x, 8), _mm_srli_epi16 (x, 8)));
+    }
+  swap32_scalar (ap_pcm + i, a_n - i);
+}
+
+static TIZ_PCM_SSE2 void
+dup16_sse2 (int16_t * ap_dst, const int16_t * ap_src, size_t a_nframes)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_nframes; i += 8)
+    {
+      const __m128i x = _mm_loadu_si128 ((const __m128i *) (ap_src + i));
+      __m128i * p = (__m128i *) (ap_dst + 2 * i);
+      _mm_storeu_si128 (p, _mm_unpacklo_epi16 (x, x));
+      _mm_storeu_si128 (p + 1, _mm_unpackhi_epi16 (x, x));
+    }
+  dup16_scalar (ap_dst + 2 * i, ap_src + i, a_nframes - i);
+}
+
+static TIZ_PCM_SSE2 void
+dup32_sse2 (int32_t * ap_dst, const int32_t * ap_src, size_t a_nframes)
+{
+  size_t i = 0;
+  for (; i + 4 <= a_nframes; i += 4)
+    {
+      const __m128i x = _mm_loadu_si128 ((const __m128i *) (ap_src + i));
+      __m128i * p = (__m128i *) (ap_dst + 2 * i);
+      _mm_storeu_si128 (p, _mm_unpacklo_epi32 (x, x));
+      _mm_storeu_si128 (p + 1, _mm_unpackhi_epi32 (x, x));
+    }
+  dup32_scalar (ap_dst + 2 * i, ap_src + i, a_nframes - i);
+}
+
+static const tiz_pcm_ops_t sse2_ops = {
+  TIZ_PCM_ISA_SSE2, gain_s16_sse2, gain_s32_sse2, gain_flt_sse2,
+  ramp_s16_sse2,    ramp_flt_sse2, swap16_sse2,   swap32_sse2,
+  dup16_sse2,       dup32_sse2,
+};
+
+/*
+ * AVX2 kernels
+ */
+
+static TIZ_PCM_AVX2 inline __m256i
+s16x16_scale_avx2 (const __m256i a_pcm, const __m256 a_g_lo,
+                   const __m256 a_g_hi)
+{
+  const __m256 vmax = _mm256_set1_ps (PCM_S16_MAX);
+  const __m256 vmin = _mm256_set1_ps (PCM_S16_MIN);
+  const __m256i lo = _mm256_cvtepi16_epi32 (_mm256_castsi256_si128 (a_pcm));
+  const __m256i hi = _mm256_cvtepi16_epi32 (_mm256_extracti128_si256 (a_pcm, 1));
+  __m256 flo = _mm256_mul_ps (_mm256_cvtepi32_ps (lo), a_g_lo);
+  __m256 fhi = _mm256_mul_ps (_mm256_cvtepi32_ps (hi), a_g_hi);
+  flo = _mm256_max_ps (_mm256_min_ps (flo, vmax), vmin);
+  fhi = _mm256_max_ps (_mm256_min_ps (fhi, vmax), vmin);
+  /* packs works within 128-bit lanes; put the quadwords back in order */
+  return _mm256_permute4x64_epi64 (
+    _mm256_packs_epi32 (_mm256_cvtps_epi32 (flo), _mm256_cvtps_epi32 (fhi)),
+    _MM_SHUFFLE (3, 1, 2, 0));
+}
+
+static TIZ_PCM_AVX2 void
+gain_s16_avx2 (int16_t * ap_pcm, size_t a_n, float a_gain)
+{
+  const __m256 vg = _mm256_set1_ps (a_gain);
+  size_t i = 0;
+  for (; i + 16 <= a_n; i += 16)
+    {
+      __m256i * p = (__m256i *) (ap_pcm + i);
+      _mm256_storeu_si256 (p,
+                           s16x16_scale_avx2 (_mm256_loadu_si256 (p), vg, vg));
+    }
+  gain_s16_scalar (ap_pcm + i, a_n - i, a_gain);
+}
+
+static TIZ_PCM_AVX2 void
+gain_s32_avx2 (int32_t * ap_pcm, size_t a_n, float a_gain)
+{
+  const __m256 vg = _mm256_set1_ps (a_gain);
+  const __m256 vmax = _mm256_set1_ps (PCM_S32_MAX);
+  const __m256 vmin = _mm256_set1_ps (PCM_S32_MIN);
+  size_t i = 0;
+  for (; i + 8 <= a_n; i += 8)
+    {
+      __m256i * p = (__m256i *) (ap_pcm + i);
+      __m256 f = _mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_loadu_si256 (p)), vg);
+      f = _mm256_max_ps (_mm256_min_ps (f, vmax), vmin);
+      _mm256_storeu_si256 (p, _mm256_cvtps_epi32 (f));
+    }
+  gain_s32_scalar (ap_pcm + i, a_n - i, a_gain);
+}
+
+static TIZ_PCM_AVX2 void
+gain_flt_avx2 (float * ap_pcm, size_t a_n, float a_gain)
+{
+  const __m256 vg = _mm256_set1_ps (a_gain);
+  const __m256 vmax = _mm256_set1_ps (1.f);
+  const __m256 vmin = _mm256_set1_ps (-1.f);
+  size_t i = 0;
+  for (; i + 8 <= a_n; i += 8)
+    {
+      __m256 f = _mm256_mul_ps (_mm256_loadu_ps (ap_pcm + i), vg);
+      _mm256_storeu_ps (ap_pcm + i,
+                        _mm256_max_ps (_mm256_min_ps (f, vmax), vmin));
+    }
+  gain_flt_scalar (ap_pcm + i, a_n - i, a_gain);
+}
+
+/* Frame number of each of the eight lanes that follow frame a_first */
+static TIZ_PCM_AVX2 inline __m256
+lane_frames_avx2 (const float a_first, const unsigned a_nch)
+{
+  return _mm256_set_ps (
+    a_first + (float) (7 / a_nch), a_first + (float) (6 / a_nch),
+    a_first + (float) (5 / a_nch), a_first + (float) (4 / a_nch),
+    a_first + (float) (3 / a_nch), a_first + (float) (2 / a_nch),
+    a_first + (float) (1 / a_nch), a_first);
+}
+
+static TIZ_PCM_AVX2 void
+ramp_s16_avx2 (int16_t * ap_pcm, size_t a_nframes, unsigned a_nch,
+               float a_from, float a_step)
+{
+  const size_t n = a_nframes * a_nch;
+  const __m256 vfrom = _mm256_set1_ps (a_from);
+  const __m256 vstep = _mm256_set1_ps (a_step);
+  const __m256 vinc = _mm256_set1_ps ((float) (16 / a_nch));
+  __m256 fr_lo = lane_frames_avx2 (0.f, a_nch);
+  __m256 fr_hi = lane_frames_avx2 ((float) (8 / a_nch), a_nch);
+  size_t i = 0;
+  assert (a_nch == 1 || a_nch == 2 || a_nch == 4);
+  for (; i + 16 <= n; i += 16)
+    {
+      __m256i * p = (__m256i *) (ap_pcm + i);
+      const __m256 g_lo = _mm256_add_ps (vfrom, _mm256_mul_ps (vstep, fr_lo));
+      const __m256 g_hi = _mm256_add_ps (vfrom, _mm256_mul_ps (vstep, fr_hi));
+      _mm256_storeu_si256 (
+        p, s16x16_scale_avx2 (_mm256_loadu_si256 (p), g_lo, g_hi));
+      fr_lo = _mm256_add_ps (fr_lo, vinc);
+      fr_hi = _mm256_add_ps (fr_hi, vinc);
+    }
+  ramp_scalar (ap_pcm, TIZ_PCM_FMT_S16, i / a_nch, a_nframes, a_nch, a_from,
+               a_step);
+}
+
+static TIZ_PCM_AVX2 void
+ramp_flt_avx2 (float * ap_pcm, size_t a_nframes, unsigned a_nch, float a_from,
+               float a_step)
+{
+  const size_t n = a_nframes * a_nch;
+  const __m256 vfrom = _mm256_set1_ps (a_from);
+  const __m256 vstep = _mm256_set1_ps (a_step);
+  const __m256 vinc = _mm256_set1_ps ((float) (8 / a_nch));
+  const __m256 vmax = _mm256_set1_ps (1.f);
+  const __m256 vmin = _mm256_set1_ps (-1.f);
+  __m256 fr = lane_frames_avx2 (0.f, a_nch);
+  size_t i = 0;
+  assert (a_nch == 1 || a_nch == 2 || a_nch == 4);
+  for (; i + 8 <= n; i += 8)
+    {
+      const __m256 g = _mm256_add_ps (vfrom, _mm256_mul_ps (vstep, fr));
+      __m256 f = _mm256_mul_ps (_mm256_loadu_ps (ap_pcm + i), g);
+      _mm256_storeu_ps (ap_pcm + i,
+                        _mm256_max_ps (_mm256_min_ps (f, vmax), vmin));
+      fr = _mm256_add_ps (fr, vinc);
+    }
+  ramp_scalar (ap_pcm, TIZ_PCM_FMT_FLOAT, i / a_nch, a_nframes, a_nch, a_from,
+               a_step);
+}
+
+static TIZ_PCM_AVX2 void
+swap16_avx2 (uint16_t * ap_pcm, size_t a_n)
+{
+  const __m256i mask
+    = _mm256_setr_epi8 (1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1,
+                        0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  size_t i = 0;
+  for (; i + 16 <= a_n; i += 16)
+    {
+      __m256i * p = (__m256i *) (ap_pcm + i);
+      _mm256_storeu_si256 (p, _mm256_shuffle_epi8 (_mm256_loadu_si256 (p), mask));
+    }
+  swap16_scalar (ap_pcm + i, a_n - i);
+}
+
+static TIZ_PCM_AVX2 void
+swap32_avx2 (uint32_t * ap_pcm, size_t a_n)
+{
+  const __m256i mask
+    = _mm256_setr_epi8 (3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3,
+                        2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  size_t i = 0;
+  for (; i + 8 <= a_n; i += 8)
+    {
+      __m256i * p = (__m256i *) (ap_pcm + i);
+      _mm256_storeu_si256 (p, _mm256_shuffle_epi8 (_mm256_loadu_si256 (p), mask));
+    }
+  swap32_scalar (ap_pcm + i, a_n - i);
+}
+
+static TIZ_PCM_AVX2 void
+dup16_avx2 (int16_t * ap_dst, const int16_t * ap_src, size_t a_nframes)
+{
+  size_t i = 0;
+  for (; i + 16 <= a_nframes; i += 16)
+    {
+      const __m256i x = _mm256_loadu_si256 ((const __m256i *) (ap_src + i));
+      const __m256i lo = _mm256_unpacklo_epi16 (x, x);
+      const __m256i hi = _mm256_unpackhi_epi16 (x, x);
+      __m256i * p = (__m256i *) (ap_dst + 2 * i);
+      /* unpack works within 128-bit lanes */
+      _mm256_storeu_si256 (p, _mm256_permute2x128_si256 (lo, hi, 0x20));
+      _mm256_storeu_si256 (p + 1, _mm256_permute2x128_si256 (lo, hi, 0x31));
+    }
+  dup16_scalar (ap_dst + 2 * i, ap_src + i, a_nframes - i);
+}
+
+static TIZ_PCM_AVX2 void
+dup32_avx2 (int32_t * ap_dst, const int32_t * ap_src, size_t a_nframes)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_nframes; i += 8)
+    {
+      const __m256i x = _mm256_loadu_si256 ((const __m256i *) (ap_src + i));
+      const __m256i lo = _mm256_unpacklo_epi32 (x, x);
+      const __m256i hi = _mm256_unpackhi_epi32 (x, x);
+      __m256i * p = (__m256i *) (ap_dst + 2 * i);
+      _mm256_storeu_si256 (p, _mm256_permute2x128_si256 (lo, hi, 0x20));
+      _mm256_storeu_si256 (p + 1, _mm256_permute2x128_si256 (lo, hi, 0x31));
+    }
+  dup32_scalar (ap_dst + 2 * i, ap_src + i, a_nframes - i);
+}
+
+static const tiz_pcm_ops_t avx2_ops = {
+  TIZ_PCM_ISA_AVX2, gain_s16_avx2, gain_s32_avx2, gain_flt_avx2,
+  ramp_s16_avx2,    ramp_flt_avx2, swap16_avx2,   swap32_avx2,
+  dup16_avx2,       dup32_avx2,
+};
+
+#endif /* TIZ_PCM_X86 */
+
+#ifdef TIZ_PCM_NEON
+
+/*
+ * NEON kernels (AArch64)
+ */
+
+static inline int16x8_t
+s16x8_scale_neon (const int16x8_t a_pcm, const float32x4_t a_g_lo,
+                  const float32x4_t a_g_hi)
+{
+  const float32x4_t vmax = vdupq_n_f32 (PCM_S16_MAX);
+  const float32x4_t vmin = vdupq_n_f32 (PCM_S16_MIN);
+  float32x4_t flo
+    = vmulq_f32 (vcvtq_f32_s32 (vmovl_s16 (vget_low_s16 (a_pcm))), a_g_lo);
+  float32x4_t fhi
+    = vmulq_f32 (vcvtq_f32_s32 (vmovl_s16 (vget_high_s16 (a_pcm))), a_g_hi);
+  flo = vmaxq_f32 (vminq_f32 (flo, vmax), vmin);
+  fhi = vmaxq_f32 (vminq_f32 (fhi, vmax), vmin);
+  return vcombine_s16 (vmovn_s32 (vcvtnq_s32_f32 (flo)),
+                       vmovn_s32 (vcvtnq_s32_f32 (fhi)));
+}
+
+static void
+gain_s16_neon (int16_t * ap_pcm, size_t a_n, float a_gain)
+{
+  const float32x4_t vg = vdupq_n_f32 (a_gain);
+  size_t i = 0;
+  for (; i + 8 <= a_n; i += 8)
+    {
+      vst1q_s16 (ap_pcm + i, s16x8_scale_neon (vld1q_s16 (ap_pcm + i), vg, vg));
+    }
+  gain_s16_scalar (ap_pcm + i, a_n - i, a_gain);
+}
+
+static void
+gain_s32_neon (int32_t * ap_pcm, size_t a_n, float a_gain)
+{
+  const float32x4_t vg = vdupq_n_f32 (a_gain);
+  const float32x4_t vmax = vdupq_n_f32 (PCM_S32_MAX);
+  const float32x4_t vmin = vdupq_n_f32 (PCM_S32_MIN);
+  size_t i = 0;
+  for (; i + 4 <= a_n; i += 4)
+    {
+      float32x4_t f = vmulq_f32 (vcvtq_f32_s32 (vld1q_s32 (ap_pcm + i)), vg);
+      f = vmaxq_f32 (vminq_f32 (f, vmax), vmin);
+      vst1q_s32 (ap_pcm + i, vcvtnq_s32_f32 (f));
+    }
+  gain_s32_scalar (ap_pcm + i, a_n - i, a_gain);
+}
+
+static void
+gain_flt_neon (float * ap_pcm, size_t a_n, float a_gain)
+{
+  const float32x4_t vg = vdupq_n_f32 (a_gain);
+  const float32x4_t vmax = vdupq_n_f32 (1.f);
+  const float32x4_t vmin = vdupq_n_f32 (-1.f);
+  size_t i = 0;
+  for (; i + 4 <= a_n; i += 4)
+    {
+      const float32x4_t f = vmulq_f32 (vld1q_f32 (ap_pcm + i), vg);
+      vst1q_f32 (ap_pcm + i, vmaxq_f32 (vminq_f32 (f, vmax), vmin));
+    }
+  gain_flt_scalar (ap_pcm + i, a_n - i, a_gain);
+}
+
+static inline float32x4_t
+lane_frames_neon (const float a_first, const unsigned a_nch)
+{
+  const float frames[4]
+    = {a_first, a_first + (float) (1 / a_nch), a_first + (float) (2 / a_nch),
+       a_first + (float) (3 / a_nch)};
+  return vld1q_f32 (frames);
+}
+
+static void
+ramp_s16_neon (int16_t * ap_pcm, size_t a_nframes, unsigned a_nch,
+               float a_from, float a_step)
+{
+  const size_t n = a_nframes * a_nch;
+  const float32x4_t vfrom = vdupq_n_f32 (a_from);
+  const float32x4_t vstep = vdupq_n_f32 (a_step);
+  const float32x4_t vinc = vdupq_n_f32 ((float) (8 / a_nch));
+  float32x4_t fr_lo = lane_frames_neon (0.f, a_nch);
+  float32x4_t fr_hi = lane_frames_neon ((float) (4 / a_nch), a_nch);
+  size_t i = 0;
+  assert (a_nch == 1 || a_nch == 2 || a_nch == 4);
+  for (; i + 8 <= n; i += 8)
+    {
+      const float32x4_t g_lo = vaddq_f32 (vfrom, vmulq_f32 (vstep, fr_lo));
+      const float32x4_t g_hi = vaddq_f32 (vfrom, vmulq_f32 (vstep, fr_hi));
+      vst1q_s16 (ap_pcm + i,
+                 s16x8_scale_neon (vld1q_s16 (ap_pcm + i), g_lo, g_hi));
+      fr_lo = vaddq_f32 (fr_lo, vinc);
+      fr_hi = vaddq_f32 (fr_hi, vinc);
+    }
+  ramp_scalar (ap_pcm, TIZ_PCM_FMT_S16, i / a_nch, a_nframes, a_nch, a_from,
+               a_step);
+}
+
+static void
+ramp_flt_neon (float * ap_pcm, size_t a_nframes, unsigned a_nch, float a_from,
+               float a_step)
+{
+  const size_t n = a_nframes * a_nch;
+  const float32x4_t vfrom = vdupq_n_f32 (a_from);
+  const float32x4_t vstep = vdupq_n_f32 (a_step);
+  const float32x4_t vinc = vdupq_n_f32 ((float) (4 / a_nch));
+  const float32x4_t vmax = vdupq_n_f32 (1.f);
+  const float32x4_t vmin = vdupq_n_f32 (-1.f);
+  float32x4_t fr = lane_frames_neon (0.f, a_nch);
+  size_t i = 0;
+  assert (a_nch == 1 || a_nch == 2 || a_nch == 4);
+  for (; i + 4 <= n; i += 4)
+    {
+      const float32x4_t g = vaddq_f32 (vfrom, vmulq_f32 (vstep, fr));
+      const float32x4_t f = vmulq_f32 (vld1q_f32 (ap_pcm + i), g);
+      vst1q_f32 (ap_pcm + i, vmaxq_f32 (vminq_f32 (f, vmax), vmin));
+      fr = vaddq_f32 (fr, vinc);
+    }
+  ramp_scalar (ap_pcm, TIZ_PCM_FMT_FLOAT, i / a_nch, a_nframes, a_nch, a_from,
+               a_step);
+}
+
+static void
+swap16_neon (uint16_t * ap_pcm, size_t a_n)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_n; i += 8)
+    {
+      uint8_t * p = (uint8_t *) (ap_pcm + i);
+      vst1q_u8 (p, vrev16q_u8 (vld1q_u8 (p)));
+    }
+  swap16_scalar (ap_pcm + i, a_n - i);
+}
+
+static void
+swap32_neon (uint32_t * ap_pcm, size_t a_n)
+{
+  size_t i = 0;
+  for (; i + 4 <= a_n; i += 4)
+    {
+      uint8_t * p = (uint8_t *) (ap_pcm + i);
+      vst1q_u8 (p, vrev32q_u8 (vld1q_u8 (p)));
+    }
+  swap32_scalar (ap_pcm + i, a_n - i);
+}
+
+static void
+dup16_neon (int16_t * ap_dst, const int16_t * ap_src, size_t a_nframes)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_nframes; i += 8)
+    {
+      int16x8x2_t x;
+      x.val[0] = x.val[1] = vld1q_s16 (ap_src + i);
+      vst2q_s16 (ap_dst + 2 * i, x);
+    }
+  dup16_scalar (ap_dst + 2 * i, ap_src + i, a_nframes - i);
+}
+
+static void
+dup32_neon (int32_t * ap_dst, const int32_t * ap_src, size_t a_nframes)
+{
+  size_t i = 0;
+  for (; i + 4 <= a_nframes; i += 4)
+    {
+      int32x4x2_t x;
+      x.val[0] = x.val[1] = vld1q_s32 (ap_src + i);
+      vst2q_s32 (ap_dst + 2 * i, x);
+    }
+  dup32_scalar (ap_dst + 2 * i, ap_src + i, a_nframes - i);
+}
+
+static const tiz_pcm_ops_t neon_ops = {
+  TIZ_PCM_ISA_NEON, gain_s16_neon, gain_s32_neon, gain_flt_neon,
+  ramp_s16_neon,    ramp_flt_neon, swap16_neon,   swap32_neon,
+  dup16_neon,       dup32_neon,
+};
+
+#endif /* TIZ_PCM_NEON */
+
+/*
+ * Runtime selection
+ */
+
+static const tiz_pcm_ops_t *
+isa_ops (const tiz_pcm_isa_t a_isa)
+{
+#ifdef TIZ_PCM_X86
+  __builtin_cpu_init ();
+  if (TIZ_PCM_ISA_AVX2 == a_isa && __builtin_cpu_supports ("avx2"))
+    {
+      return &avx2_ops;
+    }
+  if (TIZ_PCM_ISA_SSE2 == a_isa && __builtin_cpu_supports ("sse2"))
+    {
+      return &sse2_ops;
+    }
+#endif
+#ifdef TIZ_PCM_NEON
+  if (TIZ_PCM_ISA_NEON == a_isa)
+    {
+      return &neon_ops;
+    }
+#endif
+  return TIZ_PCM_ISA_SCALAR == a_isa ? &scalar_ops : NULL;
+}
+
+static void
+init_pcm_ops (void)
+{
+  static const tiz_pcm_isa_t preference[]
+    = {TIZ_PCM_ISA_AVX2, TIZ_PCM_ISA_NEON, TIZ_PCM_ISA_SSE2};
+  size_t i = 0;
+  gp_pcm_ops = &scalar_ops;
+  for (i = 0; i < sizeof (preference) / sizeof (preference[0]); ++i)
+    {
+      const tiz_pcm_ops_t * p_ops = isa_ops (preference[i]);
+      if (p_ops)
+        {
+          gp_pcm_ops = p_ops;
+          break;
+        }
+    }
+}
+
+static inline const tiz_pcm_ops_t *
+pcm_ops (void)
+{
+  (void) pthread_once (&g_pcm_once, init_pcm_ops);
+  assert (gp_pcm_ops);
+  return gp_pcm_ops;
+}
+
+/*
+ * Public API
+ */
+
+size_t
+tiz_pcm_sample_size (const tiz_pcm_fmt_t a_fmt)
+{
+  assert (a_fmt < TIZ_PCM_FMT_MAX);
+  return TIZ_PCM_FMT_S16 == a_fmt ? 2 : (TIZ_PCM_FMT_S24 == a_fmt ? 3 : 4);
+}
+
+float
+tiz_pcm_db_to_gain (const float a_db)
+{
+  return powf (10.f, a_db / 20.f);
+}
+
+void
+tiz_pcm_gain (void * ap_samples, const size_t a_nsamples,
+              const tiz_pcm_fmt_t a_fmt, const float a_gain)
+{
+  const tiz_pcm_ops_t * p_ops = pcm_ops ();
+  assert (ap_samples || 0 == a_nsamples);
+  switch (a_fmt)
+    {
+      case TIZ_PCM_FMT_S16:
+        {
+          p_ops->pf_gain_s16 (ap_samples, a_nsamples, a_gain);
+        }
+        break;
+      case TIZ_PCM_FMT_S24:
+        {
+          gain_s24_scalar (ap_samples, a_nsamples, a_gain);
+        }
+        break;
+      case TIZ_PCM_FMT_S32:
+        {
+          p_ops->pf_gain_s32 (ap_samples, a_nsamples, a_gain);
+        }
+        break;
+      case TIZ_PCM_FMT_FLOAT:
+        {
+          p_ops->pf_gain_flt (ap_samples, a_nsamples, a_gain);
+        }
+        break;
+      default:
+        {
+          assert (0);
+        }
+        break;
+    };
+}
+
+void
+tiz_pcm_gain_ramp (void * ap_samples, const size_t a_nframes,
+                   const OMX_U32 a_nchannels, const tiz_pcm_fmt_t a_fmt,
+                   const float a_from, const float a_to)
+{
+  const tiz_pcm_ops_t * p_ops = pcm_ops ();
+  const bool vectorizable
+    = (1 == a_nchannels || 2 == a_nchannels || 4 == a_nchannels);
+  float step = 0.f;
+
+  assert (ap_samples || 0 == a_nframes);
+  assert (a_nchannels > 0);
+
+  if (0 == a_nframes)
+    {
+      return;
+    }
+
+  step = (a_to - a_from) / (float) a_nframes;
+  if (vectorizable && TIZ_PCM_FMT_S16 == a_fmt)
+    {
+      p_ops->pf_ramp_s16 (ap_samples, a_nframes, a_nchannels, a_from, step);
+    }
+  else if (vectorizable && TIZ_PCM_FMT_FLOAT == a_fmt)
+    {
+      p_ops->pf_ramp_flt (ap_samples, a_nframes, a_nchannels, a_from, step);
+    }
+  else
+    {
+      ramp_scalar (ap_samples, a_fmt, 0, a_nframes, a_nchannels, a_from,
+                   step);
+    }
+}
+
+void
+tiz_pcm_byteswap (void * ap_samples, const size_t a_nsamples,
+                  const tiz_pcm_fmt_t a_fmt)
+{
+  const tiz_pcm_ops_t * p_ops = pcm_ops ();
+  assert (ap_samples || 0 == a_nsamples);
+  switch (a_fmt)
+    {
+      case TIZ_PCM_FMT_S16:
+        {
+          p_ops->pf_swap16 (ap_samples, a_nsamples);
+        }
+        break;
+      case TIZ_PCM_FMT_S24:
+        {
+          swap24_scalar (ap_samples, a_nsamples);
+        }
+        break;
+      case TIZ_PCM_FMT_S32:
+      case TIZ_PCM_FMT_FLOAT:
+        {
+          p_ops->pf_swap32 (ap_samples, a_nsamples);
+        }
+        break;
+      default:
+        {
+          assert (0);
+        }
+        break;
+    };
+}
+
+void
+tiz_pcm_upmix (void * ap_dst, const void * ap_src, const size_t a_nframes,
+               const tiz_pcm_fmt_t a_fmt, const OMX_U32 a_in_channels,
+               const OMX_U32 a_out_channels)
+{
+  const tiz_pcm_ops_t * p_ops = pcm_ops ();
+  const size_t sample_size = tiz_pcm_sample_size (a_fmt);
+
+  assert (ap_dst || 0 == a_nframes);
+  assert (ap_src || 0 == a_nframes);
+  assert (a_in_channels > 0);
+  assert (a_out_channels >= a_in_channels);
+
+  if (a_in_channels == a_out_channels)
+    {
+      memcpy (ap_dst, ap_src, a_nframes * a_in_channels * sample_size);
+    }
+  else if (1 == a_in_channels && 2 == a_out_channels && 2 == sample_size)
+    {
+      p_ops->pf_dup16 (ap_dst, ap_src, a_nframes);
+    }
+  else if (1 == a_in_channels && 2 == a_out_channels && 4 == sample_size)
+    {
+      p_ops->pf_dup32 (ap_dst, ap_src, a_nframes);
+    }
+  else
+    {
+      upmix_scalar (ap_dst, ap_src, a_nframes, sample_size, a_in_channels,
+                    a_out_channels);
+    }
+}
+
+tiz_pcm_isa_t
+tiz_pcm_get_isa (void)
+{
+  return pcm_ops ()->isa;
+}
+
+OMX_ERRORTYPE
+tiz_pcm_set_isa (const tiz_pcm_isa_t a_isa)
+{
+  const tiz_pcm_ops_t * p_ops = NULL;
+  (void) pcm_ops ();
+  if (a_isa >= TIZ_PCM_ISA_MAX || !(p_ops = isa_ops (a_isa)))
+    {
+      return OMX_ErrorUnsupportedSetting;
+    }
+  gp_pcm_ops = p_ops;
+  return OMX_ErrorNone;
+}
+
+const char *
+tiz_pcm_isa_to_str (const tiz_pcm_isa_t a_isa)
+{
+  static const char * isa_names[]
+    = {"scalar", "sse2", "avx2", "neon", "unknown"};
+  return isa_names[a_isa < TIZ_PCM_ISA_MAX ? a_isa : TIZ_PCM_ISA_MAX];
+}
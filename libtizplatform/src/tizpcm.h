@@ -0,0 +1,201 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizpcm.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - PCM sample processing kernels
+ *
+ *
+ */
+
+#ifndef TIZPCM_H
+#define TIZPCM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup tizpcm PCM sample processing kernels
+ *
+ * Gain, volume ramps, byte-order swapping and channel up-mixing of
+ * interleaved PCM samples. The implementation (SSE2, AVX2, NEON or plain C)
+ * is selected at runtime, the first time any of these functions is used,
+ * according to what the CPU supports. All implementations produce the same
+ * output.
+ *
+ * Unless noted otherwise, samples are expected in host byte order.
+ *
+ * @ingroup libtizplatform
+ */
+
+#include <stddef.h>
+
+#include <OMX_Types.h>
+
+/**
+ * PCM sample formats.
+ * @ingroup tizpcm
+ */
+typedef enum tiz_pcm_fmt
+{
+  TIZ_PCM_FMT_S16 = 0, /**< Signed 16-bit */
+  TIZ_PCM_FMT_S24,     /**< Signed 24-bit, packed in 3 bytes */
+  TIZ_PCM_FMT_S32,     /**< Signed 32-bit */
+  TIZ_PCM_FMT_FLOAT,   /**< 32-bit float, nominal range [-1.0, 1.0] */
+  TIZ_PCM_FMT_MAX
+} tiz_pcm_fmt_t;
+
+/**
+ * Instruction sets that the kernels may be implemented with.
+ * @ingroup tizpcm
+ */
+typedef enum tiz_pcm_isa
+{
+  TIZ_PCM_ISA_SCALAR = 0,
+  TIZ_PCM_ISA_SSE2,
+  TIZ_PCM_ISA_AVX2,
+  TIZ_PCM_ISA_NEON,
+  TIZ_PCM_ISA_MAX
+} tiz_pcm_isa_t;
+
+/**
+ * Retrieve the size in bytes of one sample.
+ *
+ * @ingroup tizpcm
+ * @param a_fmt The sample format.
+ * @return The sample size in bytes.
+ */
+size_t
+tiz_pcm_sample_size (const tiz_pcm_fmt_t a_fmt);
+
+/**
+ * Convert a gain in decibels into a linear scale factor.
+ *
+ * @ingroup tizpcm
+ * @param a_db The gain in dB.
+ * @return The linear gain.
+ */
+float
+tiz_pcm_db_to_gain (const float a_db);
+
+/**
+ * Scale samples in place. Integer results are rounded to the nearest value
+ * and saturated; float results are clamped to [-1.0, 1.0].
+ *
+ * @ingroup tizpcm
+ * @param ap_samples The interleaved samples.
+ * @param a_nsamples The number of samples (frames times channels).
+ * @param a_fmt The sample format.
+ * @param a_gain The linear gain.
+ */
+void
+tiz_pcm_gain (void * ap_samples, const size_t a_nsamples,
+              const tiz_pcm_fmt_t a_fmt, const float a_gain);
+
+/**
+ * Scale samples in place, with a gain that changes linearly from one frame
+ * to the next. Frame i is scaled by a_from + i * (a_to - a_from) /
+ * a_nframes. Rounding and saturation are as in tiz_pcm_gain.
+ *
+ * @ingroup tizpcm
+ * @param ap_samples The interleaved samples.
+ * @param a_nframes The number of frames.
+ * @param a_nchannels The number of channels per frame.
+ * @param a_fmt The sample format.
+ * @param a_from The linear gain applied to the first frame.
+ * @param a_to The linear gain that would be applied to the frame following
+ * the last one.
+ */
+void
+tiz_pcm_gain_ramp (void * ap_samples, const size_t a_nframes,
+                   const OMX_U32 a_nchannels, const tiz_pcm_fmt_t a_fmt,
+                   const float a_from, const float a_to);
+
+/**
+ * Reverse the byte order of every sample, in place. This function does not
+ * require samples in host byte order.
+ *
+ * @ingroup tizpcm
+ * @param ap_samples The samples.
+ * @param a_nsamples The number of samples.
+ * @param a_fmt The sample format.
+ */
+void
+tiz_pcm_byteswap (void * ap_samples, const size_t a_nsamples,
+                  const tiz_pcm_fmt_t a_fmt);
+
+/**
+ * Copy frames to a destination with as many or more channels. Output
+ * channel c is taken from input channel (c % a_in_channels), so mono is
+ * duplicated across all output channels. This function does not require
+ * samples in host byte order.
+ *
+ * @ingroup tizpcm
+ * @param ap_dst The destination; room for a_nframes * a_out_channels
+ * samples. It must not overlap the source.
+ * @param ap_src The source frames.
+ * @param a_nframes The number of frames.
+ * @param a_fmt The sample format.
+ * @param a_in_channels The number of channels in the source.
+ * @param a_out_channels The number of channels in the destination.
+ */
+void
+tiz_pcm_upmix (void * ap_dst, const void * ap_src, const size_t a_nframes,
+               const tiz_pcm_fmt_t a_fmt, const OMX_U32 a_in_channels,
+               const OMX_U32 a_out_channels);
+
+/**
+ * Retrieve the instruction set currently in use.
+ *
+ * @ingroup tizpcm
+ * @return The instruction set.
+ */
+tiz_pcm_isa_t
+tiz_pcm_get_isa (void);
+
+/**
+ * Force the use of a particular instruction set. This is meant for testing
+ * and benchmarking.
+ *
+ * @ingroup tizpcm
+ * @param a_isa The instruction set.
+ * @return OMX_ErrorNone on success, OMX_ErrorUnsupportedSetting if the CPU
+ * (or the build) does not support a_isa.
+ */
+OMX_ERRORTYPE
+tiz_pcm_set_isa (const tiz_pcm_isa_t a_isa);
+
+/**
+ * Retrieve the name of an instruction set.
+ *
+ * @ingroup tizpcm
+ * @param a_isa The instruction set.
+ * @return A null-terminated string.
+ */
+const char *
+tiz_pcm_isa_to_str (const tiz_pcm_isa_t a_isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIZPCM_H */
@@ -38,13 +38,17 @@
 
 #include "tizmacros.h"
 #include "tizlog.h"
+#include "tizlogring.h"
 #include "tizmem.h"
 #include "tizqueue.h"
+#include "tizmpscq.h"
+#include "tizspscring.h"
 #include "tizpqueue.h"
 #include "tizbuffer.h"
 #include "tizvector.h"
 #include "tizsync.h"
 #include "tizthread.h"
+#include "tizwpool.h"
 #include "tizuuid.h"
 #include "tizomxutils.h"
 #include "tizrc.h"
@@ -55,6 +59,7 @@
 #include "tizlimits.h"
 #include "tizprintf.h"
 #include "tizshufflelst.h"
+#include "tizpcm.h"
 #include "tizurltransfer.h"
 
 /** @} */
@@ -102,4 +102,18 @@ tiz_rcfile_destroy (tiz_rcfile_t * rcfile);
 tiz_rcfile_t *
 tiz_rcfile_get_handle (void);
 
+/**
+ * Log an already formatted message through log4c, on behalf of another
+ * thread. This is used by the asynchronous logging backend's drain thread.
+ *
+ * @private
+ *
+ * @param a_tid The id of the thread that produced the message.
+ * @param ap_cname The component name, or NULL.
+ */
+void
+tiz_log_forward (const char * ap_cat_name, const char * ap_file, int a_line,
+                 const char * ap_func, int a_priority, int a_tid,
+                 const char * ap_cname, const char * ap_msg);
+
 #endif /* TIZINT_H */
@@ -209,9 +209,16 @@ get_node (const tiz_rcfile_t * ap_rc, char * str, keyval_t ** app_kv)
   assert (str);
   assert (app_kv);
 
-  TIZ_LOG (TIZ_PRIORITY_TRACE, "key : [%s]", trimwhitespace (key));
-  TIZ_LOG (TIZ_PRIORITY_TRACE, "val : [%s]",
-           trimlistseparator (trimwhitespace (value)));
+  /* Drop the blanks between the key and the '=' sign. NOTE: This must not be
+     done inside the TIZ_LOG statements below, as their arguments are not
+     evaluated when tracing is disabled. */
+  if (key)
+    {
+      (void) trimwhitespace (key);
+    }
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "key : [%s]", key);
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "val : [%s]", value);
 
 /*   if (strstr (value, "\"")) */
 /*     { */
@@ -33,6 +33,7 @@
 #include "tizplatform.h"
 
 #include <assert.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -41,9 +42,12 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.platform.soa"
 #endif
 
-#define SOA_MAX_SLICE_SIZE 256
+/* Slices of up to this size (including the slice header) are looked up in
+   chunk_class_tbl; larger ones go to the power-of-two classes. */
+#define SOA_SMALL_SLICE_SIZE 256
+#define SOA_FIRST_LARGE_CLASS 5
+#define SOA_MAX_SLICE_SIZE 4096
 #define SOA_SLICE_ALIGN 8
-#define SOA_CHUNK_SZ 4096
 
 static const int32_t chunk_class_tbl[] = {
   0, 0, 0, 0, 0,                                 /* 32 bytes */
@@ -54,23 +58,38 @@ static const int32_t chunk_class_tbl[] = {
 };
 
 static const size_t slice_sz_tbl[TIZ_SOA_NUM_CHUNK_CLASSES]
-  = {32, 64, 96, 128, 256};
+  = {32, 64, 96, 128, 256, 512, 1024, 2048, 4096};
+
+/* Large classes get bigger chunks so that a chunk holds 8 slices */
+static const size_t chunk_sz_tbl[TIZ_SOA_NUM_CHUNK_CLASSES]
+  = {4096, 4096, 4096, 4096, 4096, 4096, 8192, 16384, 32768};
+
+typedef struct slice slice_t;
 
 typedef struct chunk chunk_t;
 struct chunk
 {
+  /* All the chunks */
+  chunk_t * p_prev;
   chunk_t * p_next;
+  /* Chunks of the same class with at least one free slice */
+  chunk_t * p_prev_avail;
+  chunk_t * p_next_avail;
   tiz_soa_t * p_soa;
+  /* Slices that have been freed */
+  slice_t * p_free;
   int32_t n_allocated_slices;
+  /* Slices handed out at least once; the rest have never been touched */
+  int32_t n_carved_slices;
+  int32_t n_slices;
   int32_t class;
-  uint8_t data[SOA_CHUNK_SZ];
+  uint8_t data[];
 };
 
-typedef struct slice slice_t;
 struct slice
 {
   size_t size;
-  chunk_t * p_chunk;
+  chunk_t * p_chunk; /* NULL if the object was too large for a slice */
   slice_t * p_next_free;
 };
 #define SLICE_PREAMBLE_SZ (sizeof (size_t) + sizeof (chunk_t *))
@@ -87,21 +106,81 @@ get_slice_ptr (void * p_usr)
   return ((slice_t *) ((uint8_t *) p_usr - SLICE_PREAMBLE_SZ));
 }
 
+typedef struct soa_class soa_class_t;
+struct soa_class
+{
+  chunk_t * p_avail;
+  int32_t n_chunks;
+  int32_t n_slices;
+  int32_t high_water;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t reclaimed;
+};
+
 struct tiz_soa
 {
-  slice_t * p_slice_store[TIZ_SOA_NUM_CHUNK_CLASSES];
-  slice_t * p_pending_chain;
+  soa_class_t classes[TIZ_SOA_NUM_CHUNK_CLASSES];
   chunk_t * p_chunk_lst;
   int32_t n_chunks;
   int32_t n_allocated_objects;
+  int32_t n_large_objects;
 };
 
-/*@null@*/ static slice_t *
+static inline int32_t
+get_chunk_class (const size_t a_alloc_sz)
+{
+  int32_t chunk_class = SOA_FIRST_LARGE_CLASS;
+
+  if (a_alloc_sz <= SOA_SMALL_SLICE_SIZE)
+    {
+      return chunk_class_tbl[a_alloc_sz / SOA_SLICE_ALIGN];
+    }
+
+  while (slice_sz_tbl[chunk_class] < a_alloc_sz)
+    {
+      ++chunk_class;
+    }
+
+  assert (chunk_class < TIZ_SOA_NUM_CHUNK_CLASSES);
+  return chunk_class;
+}
+
+static inline void
+link_avail (soa_class_t * ap_class, chunk_t * ap_chunk)
+{
+  ap_chunk->p_prev_avail = NULL;
+  ap_chunk->p_next_avail = ap_class->p_avail;
+  if (ap_class->p_avail)
+    {
+      ap_class->p_avail->p_prev_avail = ap_chunk;
+    }
+  ap_class->p_avail = ap_chunk;
+}
+
+static inline void
+unlink_avail (soa_class_t * ap_class, chunk_t * ap_chunk)
+{
+  if (ap_chunk->p_prev_avail)
+    {
+      ap_chunk->p_prev_avail->p_next_avail = ap_chunk->p_next_avail;
+    }
+  else
+    {
+      assert (ap_class->p_avail == ap_chunk);
+      ap_class->p_avail = ap_chunk->p_next_avail;
+    }
+  if (ap_chunk->p_next_avail)
+    {
+      ap_chunk->p_next_avail->p_prev_avail = ap_chunk->p_prev_avail;
+    }
+  ap_chunk->p_prev_avail = NULL;
+  ap_chunk->p_next_avail = NULL;
+}
+
+/*@null@*/ static chunk_t *
 alloc_chunk (tiz_soa_t * p_soa, int32_t chunk_class)
 {
-  slice_t * p_slice = NULL;
-  int32_t num_slices = 0;
-  size_t slice_sz = 0;
   chunk_t * p_new_chunk = NULL;
 
   TIZ_LOG (TIZ_PRIORITY_TRACE, "chunk_class [%d] ", chunk_class);
@@ -109,36 +188,87 @@ alloc_chunk (tiz_soa_t * p_soa, int32_t chunk_class)
   assert (p_soa != NULL);
   assert (chunk_class < TIZ_SOA_NUM_CHUNK_CLASSES);
 
-  slice_sz = slice_sz_tbl[chunk_class];
-
-  if ((p_new_chunk = tiz_mem_calloc (1, sizeof (chunk_t))))
+  /* Slices are carved out lazily, so there is no need to clear the data */
+  if ((p_new_chunk = tiz_mem_alloc (sizeof (chunk_t)
+                                    + chunk_sz_tbl[chunk_class])))
     {
       p_new_chunk->p_soa = p_soa;
-      p_new_chunk->p_next = p_soa->p_chunk_lst;
+      p_new_chunk->p_free = NULL;
       p_new_chunk->n_allocated_slices = 0;
+      p_new_chunk->n_carved_slices = 0;
+      p_new_chunk->n_slices
+        = chunk_sz_tbl[chunk_class] / slice_sz_tbl[chunk_class];
       p_new_chunk->class = chunk_class;
-      p_soa->p_chunk_lst = p_new_chunk;
-      p_soa->n_chunks += 1;
-      num_slices = SOA_CHUNK_SZ / slice_sz - 2;
-      p_soa->p_slice_store[chunk_class] = p_slice
-        = (slice_t *) (p_new_chunk->data + slice_sz);
-      do
+
+      p_new_chunk->p_prev = NULL;
+      p_new_chunk->p_next = p_soa->p_chunk_lst;
+      if (p_soa->p_chunk_lst)
         {
-          slice_t * p_next = (slice_t *) ((uint8_t *) p_slice + slice_sz);
-          p_slice->p_chunk = p_new_chunk;
-          p_slice->size = 0;
-          p_slice->p_next_free = p_next;
-          p_slice = p_next;
+          p_soa->p_chunk_lst->p_prev = p_new_chunk;
         }
-      while (--num_slices != 0);
+      p_soa->p_chunk_lst = p_new_chunk;
+      p_soa->n_chunks += 1;
 
-      p_slice->p_chunk = p_new_chunk;
-      p_slice->size = 0;
-      p_slice->p_next_free = NULL;
-      p_slice = (slice_t *) p_new_chunk->data;
-      p_slice->p_chunk = p_new_chunk;
+      link_avail (&(p_soa->classes[chunk_class]), p_new_chunk);
+      p_soa->classes[chunk_class].n_chunks += 1;
     }
 
+  return p_new_chunk;
+}
+
+static void
+reclaim_chunk (tiz_soa_t * p_soa, chunk_t * p_chunk)
+{
+  soa_class_t * p_class = NULL;
+
+  assert (p_soa != NULL);
+  assert (p_chunk != NULL);
+  assert (0 == p_chunk->n_allocated_slices);
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "chunk_class [%d] ", p_chunk->class);
+
+  p_class = &(p_soa->classes[p_chunk->class]);
+  unlink_avail (p_class, p_chunk);
+  p_class->n_chunks -= 1;
+  p_class->reclaimed += 1;
+
+  if (p_chunk->p_prev)
+    {
+      p_chunk->p_prev->p_next = p_chunk->p_next;
+    }
+  else
+    {
+      p_soa->p_chunk_lst = p_chunk->p_next;
+    }
+  if (p_chunk->p_next)
+    {
+      p_chunk->p_next->p_prev = p_chunk->p_prev;
+    }
+  p_soa->n_chunks -= 1;
+
+  tiz_mem_free (p_chunk);
+}
+
+static inline slice_t *
+take_slice (chunk_t * p_chunk)
+{
+  slice_t * p_slice = p_chunk->p_free;
+
+  if (p_slice)
+    {
+      p_chunk->p_free = p_slice->p_next_free;
+    }
+  else
+    {
+      assert (p_chunk->n_carved_slices < p_chunk->n_slices);
+      p_slice = (slice_t *) (p_chunk->data
+                             + p_chunk->n_carved_slices
+                                 * slice_sz_tbl[p_chunk->class]);
+      p_slice->p_chunk = p_chunk;
+      p_chunk->n_carved_slices += 1;
+    }
+
+  p_chunk->n_allocated_slices += 1;
   return p_slice;
 }
 
@@ -201,27 +331,51 @@ tiz_soa_calloc (tiz_soa_t * p_soa, size_t size)
 
   assert (p_soa);
   assert (alloc_sz > 0);
-  assert (alloc_sz <= SOA_MAX_SLICE_SIZE);
+
+  if (alloc_sz > SOA_MAX_SLICE_SIZE)
+    {
+      /* Too large for a slice; use the heap, but keep the same header so
+         that tiz_soa_free can tell the difference */
+      slice_t * p_slice = tiz_mem_calloc (1, alloc_sz);
+      if (p_slice)
+        {
+          p_slice->size = alloc_sz;
+          p_slice->p_chunk = NULL;
+          p_soa->n_large_objects += 1;
+          p_usr = get_usr_ptr (p_slice);
+        }
+      return p_usr;
+    }
 
   {
-    int32_t chunk_class = chunk_class_tbl[alloc_sz / SOA_SLICE_ALIGN];
+    int32_t chunk_class = get_chunk_class (alloc_sz);
+    soa_class_t * p_class = &(p_soa->classes[chunk_class]);
+    chunk_t * p_chunk = p_class->p_avail;
     slice_t * p_slice = NULL;
 
-    p_slice = p_soa->p_slice_store[chunk_class];
-
-    if (NULL == p_slice)
+    if (NULL == p_chunk)
       {
-        p_slice = alloc_chunk (p_soa, chunk_class);
+        p_class->misses += 1;
+        p_chunk = alloc_chunk (p_soa, chunk_class);
       }
     else
       {
-        p_soa->p_slice_store[chunk_class] = p_slice->p_next_free;
+        p_class->hits += 1;
       }
 
-    if (p_slice)
+    if (p_chunk)
       {
-        p_slice->p_chunk->n_allocated_slices += 1;
+        p_slice = take_slice (p_chunk);
+        if (p_chunk->n_allocated_slices == p_chunk->n_slices)
+          {
+            unlink_avail (p_class, p_chunk);
+          }
         p_soa->n_allocated_objects += 1;
+        p_class->n_slices += 1;
+        if (p_class->n_slices > p_class->high_water)
+          {
+            p_class->high_water = p_class->n_slices;
+          }
         p_slice->size = alloc_sz;
         p_usr = get_usr_ptr (p_slice);
         (void) tiz_mem_set (p_usr, 0, size);
@@ -239,19 +393,43 @@ tiz_soa_free (tiz_soa_t * p_soa, void * p_addr)
   if (p_addr)
     {
       slice_t * p_slice = get_slice_ptr (p_addr);
+      chunk_t * p_chunk = NULL;
 
       assert (p_slice != NULL);
+
+      if (NULL == (p_chunk = p_slice->p_chunk))
+        {
+          assert (p_slice->size > SOA_MAX_SLICE_SIZE);
+          p_soa->n_large_objects -= 1;
+          tiz_mem_free (p_slice);
+          return;
+        }
+
       assert (p_slice->size <= SOA_MAX_SLICE_SIZE);
-      {
-        chunk_t * p_chunk = p_slice->p_chunk;
-        int32_t chunk_class = chunk_class_tbl[p_slice->size / SOA_SLICE_ALIGN];
+      assert (p_chunk->p_soa == p_soa);
 
-        assert (p_chunk != NULL);
+      {
+        soa_class_t * p_class = &(p_soa->classes[p_chunk->class]);
+        const bool was_full = (p_chunk->n_allocated_slices == p_chunk->n_slices);
 
-        p_slice->p_chunk->n_allocated_slices -= 1;
+        p_slice->p_next_free = p_chunk->p_free;
+        p_chunk->p_free = p_slice;
+        p_chunk->n_allocated_slices -= 1;
+        p_class->n_slices -= 1;
         p_soa->n_allocated_objects -= 1;
-        p_slice->p_next_free = p_soa->p_slice_store[chunk_class];
-        p_soa->p_slice_store[chunk_class] = p_slice;
+
+        if (was_full)
+          {
+            link_avail (p_class, p_chunk);
+          }
+
+        /* Give the chunk back, but always keep one around for each class
+           so that a single object going back and forth does not cause a
+           chunk to be allocated and freed every time */
+        if (0 == p_chunk->n_allocated_slices && p_class->n_chunks > 1)
+          {
+            reclaim_chunk (p_soa, p_chunk);
+          }
       }
     }
 }
@@ -260,27 +438,61 @@ void
 tiz_soa_info (tiz_soa_t * p_soa, tiz_soa_info_t * p_info)
 {
   int32_t i = 0;
-  chunk_t * p_chunk = NULL;
 
   assert (p_soa != NULL);
   assert (p_info != NULL);
 
   (void) tiz_mem_set (p_info, 0, sizeof (tiz_soa_info_t));
 
-  p_info->chunks = p_soa->n_chunks;
-  p_chunk = p_soa->p_chunk_lst;
-
-  for (i = p_soa->n_chunks; i > 0; --i)
+  for (i = 0; i < TIZ_SOA_NUM_CHUNK_CLASSES; ++i)
     {
-      p_info->slices[p_chunk->class] = p_chunk->n_allocated_slices;
-      p_chunk = p_chunk->p_next;
+      const soa_class_t * p_class = &(p_soa->classes[i]);
+      tiz_soa_class_info_t * p_ci = &(p_info->classes[i]);
+      p_info->slices[i] = p_class->n_slices;
+      p_ci->slice_size = slice_sz_tbl[i];
+      p_ci->chunks = p_class->n_chunks;
+      p_ci->high_water = p_class->high_water;
+      p_ci->hits = p_class->hits;
+      p_ci->misses = p_class->misses;
+      p_ci->reclaimed = p_class->reclaimed;
     }
 
-  assert (p_chunk == NULL);
-
   p_info->chunks = p_soa->n_chunks;
   p_info->objects = p_soa->n_allocated_objects;
+  p_info->large_objects = p_soa->n_large_objects;
 
   TIZ_LOG (TIZ_PRIORITY_TRACE, "objects [%d] chunks [%d]", p_info->objects,
            p_info->chunks);
 }
+
+void
+tiz_soa_dump (tiz_soa_t * p_soa, const char * ap_name)
+{
+  tiz_soa_info_t info;
+  int32_t i = 0;
+
+  assert (p_soa != NULL);
+
+  tiz_soa_info (p_soa, &info);
+
+  TIZ_LOG (TIZ_PRIORITY_DEBUG,
+           "[%s] soa [%p] chunks [%d] objects [%d] large objects [%d]",
+           ap_name ? ap_name : "", p_soa, info.chunks, info.objects,
+           info.large_objects);
+
+  for (i = 0; i < TIZ_SOA_NUM_CHUNK_CLASSES; ++i)
+    {
+      const tiz_soa_class_info_t * p_ci = &(info.classes[i]);
+      if (p_ci->hits + p_ci->misses > 0)
+        {
+          TIZ_LOG (TIZ_PRIORITY_DEBUG,
+                   "[%s] class [%4u] in use [%d] high water [%d] chunks [%d] "
+                   "hits [%llu] misses [%llu] reclaimed [%llu]",
+                   ap_name ? ap_name : "", (unsigned int) p_ci->slice_size,
+                   info.slices[i], p_ci->high_water, p_ci->chunks,
+                   (unsigned long long) p_ci->hits,
+                   (unsigned long long) p_ci->misses,
+                   (unsigned long long) p_ci->reclaimed);
+        }
+    }
+}
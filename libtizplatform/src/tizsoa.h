@@ -39,7 +39,7 @@ extern "C" {
 #include <OMX_Types.h>
 #include <OMX_Core.h>
 
-#define TIZ_SOA_NUM_CHUNK_CLASSES 5
+#define TIZ_SOA_NUM_CHUNK_CLASSES 9
 
 typedef struct tiz_soa tiz_soa_t;
 typedef /*@null@ */ tiz_soa_t * tiz_soa_ptr_t;
@@ -59,6 +59,23 @@ tiz_soa_calloc (tiz_soa_t * p_soa, size_t a_size);
 void
 tiz_soa_free (tiz_soa_t * p_soa, void * ap_addr);
 
+typedef struct tiz_soa_class_info tiz_soa_class_info_t;
+struct tiz_soa_class_info
+{
+  /* Slice size, including the per-slice header */
+  size_t slice_size;
+  /* Number of chunks currently allocated for this class */
+  int32_t chunks;
+  /* Maximum number of slices that have been in use at any one time */
+  int32_t high_water;
+  /* Allocations served from an existing chunk */
+  uint64_t hits;
+  /* Allocations that required a new chunk */
+  uint64_t misses;
+  /* Chunks given back after all their slices were freed */
+  uint64_t reclaimed;
+};
+
 typedef struct tiz_soa_info tiz_soa_info_t;
 struct tiz_soa_info
 {
@@ -68,11 +85,24 @@ struct tiz_soa_info
   int32_t objects;
   /* Number of slices currently in use in each chunk class */
   int32_t slices[TIZ_SOA_NUM_CHUNK_CLASSES];
+  /* Per-class statistics */
+  tiz_soa_class_info_t classes[TIZ_SOA_NUM_CHUNK_CLASSES];
+  /* Objects too large for any class, currently allocated on the heap */
+  int32_t large_objects;
 };
 
 void
 tiz_soa_info (tiz_soa_t * p_soa, tiz_soa_info_t * p_info);
 
+/**
+ * Log the allocator's per-class statistics (debug priority).
+ *
+ * @param p_soa The small object allocator.
+ * @param ap_name A name to prefix the log lines with (may be NULL).
+ */
+void
+tiz_soa_dump (tiz_soa_t * p_soa, const char * ap_name);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,213 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizspscring.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Lock-free single-producer, single-consumer byte ring
+ *
+ * The read and write indexes grow monotonically and are reduced modulo the
+ * (power of two) capacity only when the storage is accessed, so the ring is
+ * empty when they are equal and full when they differ by the capacity. Each
+ * index is written by one side only; the other side reads it with acquire
+ * semantics, which pairs with the release store that publishes it.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "tizplatform.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.platform.spscring"
+#endif
+
+#define TIZ_SPSCRING_CACHE_LINE_SIZE 64
+
+struct tiz_spscring
+{
+  OMX_U8 * p_data;
+  uint64_t capacity;
+  uint64_t mask;
+  char pad0[TIZ_SPSCRING_CACHE_LINE_SIZE];
+  /* Written by the producer */
+  uint64_t write;
+  char pad1[TIZ_SPSCRING_CACHE_LINE_SIZE];
+  /* Written by the consumer */
+  uint64_t read;
+};
+
+static uint64_t
+next_pow2 (const uint64_t a_value)
+{
+  uint64_t pow2 = 1;
+  while (pow2 < a_value)
+    {
+      pow2 <<= 1;
+    }
+  return pow2;
+}
+
+OMX_ERRORTYPE
+tiz_spscring_init (tiz_spscring_ptr_t * app_ring, OMX_U32 a_capacity)
+{
+  tiz_spscring_t * p_ring = NULL;
+  const uint64_t capacity = next_pow2 (a_capacity);
+
+  assert (app_ring);
+  assert (a_capacity > 0);
+  assert (a_capacity <= (1U << 31));
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "ring capacity [%u] -> [%llu]", a_capacity,
+           (unsigned long long) capacity);
+
+  if (!(p_ring
+        = (tiz_spscring_t *) tiz_mem_calloc (1, sizeof (tiz_spscring_t))))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "OMX_ErrorInsufficientResources: "
+               "Could not instantiate ring struct.");
+      return OMX_ErrorInsufficientResources;
+    }
+
+  if (!(p_ring->p_data = (OMX_U8 *) tiz_mem_calloc (capacity, 1)))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "[OMX_ErrorInsufficientResources]: "
+               "Could not instantiate ring storage.");
+      tiz_mem_free (p_ring);
+      return OMX_ErrorInsufficientResources;
+    }
+
+  p_ring->capacity = capacity;
+  p_ring->mask = capacity - 1;
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "ring created [%p]", p_ring);
+  *app_ring = p_ring;
+  return OMX_ErrorNone;
+}
+
+void
+tiz_spscring_destroy (tiz_spscring_t * ap_ring)
+{
+  if (ap_ring)
+    {
+      tiz_mem_free (ap_ring->p_data);
+      tiz_mem_free (ap_ring);
+    }
+}
+
+OMX_U32
+tiz_spscring_write (tiz_spscring_t * ap_ring, const void * ap_data,
+                    OMX_U32 a_nbytes)
+{
+  const OMX_U8 * p_src = ap_data;
+  uint64_t wr = 0;
+  uint64_t rd = 0;
+  uint64_t nbytes = 0;
+  uint64_t offset = 0;
+  uint64_t first = 0;
+
+  assert (ap_ring);
+  assert (ap_data || 0 == a_nbytes);
+
+  wr = __atomic_load_n (&(ap_ring->write), __ATOMIC_RELAXED);
+  rd = __atomic_load_n (&(ap_ring->read), __ATOMIC_ACQUIRE);
+  nbytes = MIN ((uint64_t) a_nbytes, ap_ring->capacity - (wr - rd));
+
+  if (nbytes > 0)
+    {
+      offset = wr & ap_ring->mask;
+      first = MIN (nbytes, ap_ring->capacity - offset);
+      memcpy (ap_ring->p_data + offset, p_src, first);
+      memcpy (ap_ring->p_data, p_src + first, nbytes - first);
+      __atomic_store_n (&(ap_ring->write), wr + nbytes, __ATOMIC_RELEASE);
+    }
+
+  return (OMX_U32) nbytes;
+}
+
+OMX_U32
+tiz_spscring_read (tiz_spscring_t * ap_ring, void * ap_data,
+                   OMX_U32 a_nbytes)
+{
+  OMX_U8 * p_dst = ap_data;
+  uint64_t wr = 0;
+  uint64_t rd = 0;
+  uint64_t nbytes = 0;
+  uint64_t offset = 0;
+  uint64_t first = 0;
+
+  assert (ap_ring);
+  assert (ap_data || 0 == a_nbytes);
+
+  rd = __atomic_load_n (&(ap_ring->read), __ATOMIC_RELAXED);
+  wr = __atomic_load_n (&(ap_ring->write), __ATOMIC_ACQUIRE);
+  nbytes = MIN ((uint64_t) a_nbytes, wr - rd);
+
+  if (nbytes > 0)
+    {
+      offset = rd & ap_ring->mask;
+      first = MIN (nbytes, ap_ring->capacity - offset);
+      memcpy (p_dst, ap_ring->p_data + offset, first);
+      memcpy (p_dst + first, ap_ring->p_data, nbytes - first);
+      __atomic_store_n (&(ap_ring->read), rd + nbytes, __ATOMIC_RELEASE);
+    }
+
+  return (OMX_U32) nbytes;
+}
+
+void
+tiz_spscring_clear (tiz_spscring_t * ap_ring)
+{
+  assert (ap_ring);
+  __atomic_store_n (&(ap_ring->read),
+                    __atomic_load_n (&(ap_ring->write), __ATOMIC_ACQUIRE),
+                    __ATOMIC_RELEASE);
+}
+
+OMX_U32
+tiz_spscring_available (const tiz_spscring_t * ap_ring)
+{
+  assert (ap_ring);
+  return (OMX_U32) (__atomic_load_n (&(ap_ring->write), __ATOMIC_ACQUIRE)
+                    - __atomic_load_n (&(ap_ring->read), __ATOMIC_ACQUIRE));
+}
+
+OMX_U32
+tiz_spscring_space (const tiz_spscring_t * ap_ring)
+{
+  assert (ap_ring);
+  return (OMX_U32) (ap_ring->capacity - tiz_spscring_available (ap_ring));
+}
+
+OMX_U32
+tiz_spscring_capacity (const tiz_spscring_t * ap_ring)
+{
+  assert (ap_ring);
+  return (OMX_U32) ap_ring->capacity;
+}
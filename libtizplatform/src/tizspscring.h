@@ -0,0 +1,148 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizspscring.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Lock-free single-producer, single-consumer byte ring
+ *
+ *
+ */
+
+#ifndef TIZSPSCRING_H
+#define TIZSPSCRING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup tizspscring Lock-free SPSC byte ring
+ *
+ * Bounded byte FIFO with exactly one writer thread and one reader thread. The
+ * storage is allocated once, at init time, and neither side ever blocks,
+ * allocates or enters the kernel: a write that does not fit is truncated and
+ * a read of an empty ring returns zero bytes. This makes it suitable for
+ * moving data out of callbacks that run on threads owned by third-party
+ * libraries.
+ *
+ * @ingroup libtizplatform
+ */
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+/**
+ * SPSC ring opaque structure.
+ * @ingroup tizspscring
+ */
+typedef struct tiz_spscring tiz_spscring_t;
+typedef /*@null@ */ tiz_spscring_t * tiz_spscring_ptr_t;
+
+/**
+ * Initialize a new empty ring.
+ *
+ * @ingroup tizspscring
+ *
+ * @param a_capacity Minimum number of bytes the ring must be able to hold. It
+ * is rounded up to the next power of two.
+ *
+ * @return OMX_ErrorNone if success, OMX_ErrorInsufficientResources otherwise.
+ */
+OMX_ERRORTYPE
+tiz_spscring_init (/*@out@*/ tiz_spscring_ptr_t * app_ring,
+                   OMX_U32 a_capacity);
+
+/**
+ * Destroy a ring. If ap_ring is NULL, no operation is performed.
+ *
+ * @ingroup tizspscring
+ *
+ */
+void
+tiz_spscring_destroy (/*@null@ */ tiz_spscring_t * ap_ring);
+
+/**
+ * Copy up to a_nbytes into the ring. Producer side only.
+ *
+ * @ingroup tizspscring
+ *
+ * @return The number of bytes actually written, which is less than a_nbytes
+ * if the ring did not have enough free space.
+ */
+OMX_U32
+tiz_spscring_write (tiz_spscring_t * ap_ring, const void * ap_data,
+                    OMX_U32 a_nbytes);
+
+/**
+ * Copy up to a_nbytes out of the ring. Consumer side only.
+ *
+ * @ingroup tizspscring
+ *
+ * @return The number of bytes actually read, which is less than a_nbytes
+ * if the ring did not hold enough data.
+ */
+OMX_U32
+tiz_spscring_read (tiz_spscring_t * ap_ring, void * ap_data,
+                   OMX_U32 a_nbytes);
+
+/**
+ * Discard all the data currently stored in the ring. Consumer side only.
+ *
+ * @ingroup tizspscring
+ *
+ */
+void
+tiz_spscring_clear (tiz_spscring_t * ap_ring);
+
+/**
+ * Retrieve the number of bytes available for reading. From the consumer's
+ * point of view, this is a lower bound; from the producer's, an upper bound.
+ *
+ * @ingroup tizspscring
+ *
+ */
+OMX_U32
+tiz_spscring_available (const tiz_spscring_t * ap_ring);
+
+/**
+ * Retrieve the number of bytes that can be written. From the producer's
+ * point of view, this is a lower bound; from the consumer's, an upper bound.
+ *
+ * @ingroup tizspscring
+ *
+ */
+OMX_U32
+tiz_spscring_space (const tiz_spscring_t * ap_ring);
+
+/**
+ * Retrieve the total number of bytes the ring can hold.
+ *
+ * @ingroup tizspscring
+ *
+ */
+OMX_U32
+tiz_spscring_capacity (const tiz_spscring_t * ap_ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIZSPSCRING_H */
@@ -946,6 +946,9 @@ allocate_temp_data_store (tiz_urltrans_t * ap_trans)
   assert (ap_trans->p_store_ == NULL);
   tiz_check_omx (
     tiz_buffer_init (&(ap_trans->p_store_), ap_trans->store_bytes_));
+  /* Avoid moving the cached data around on every push; if the ring can't be
+     mapped, the buffer simply stays in its default mode */
+  (void) tiz_buffer_seek_mode (ap_trans->p_store_, TIZ_BUFFER_RING);
   return OMX_ErrorNone;
 }
 
@@ -0,0 +1,633 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizwpool.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Work-stealing worker pool of serialized tasks
+ *
+ * Each worker owns a mutex-protected FIFO run queue. Tasks signalled from a
+ * worker go to that worker's queue; tasks signalled from other threads are
+ * spread round-robin. A worker that runs out of work steals from the other
+ * queues before parking on the pool's condition variable.
+ *
+ * Tasks move between four states (idle, queued, running, running and
+ * signalled) with atomic compare-and-swap, which is what guarantees that a
+ * task never runs on two workers at once. A run queue may hold stale entries
+ * for tasks that were claimed by tiz_wpool_task_try_run; those are discarded
+ * when popped, since their state is no longer 'queued'.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tizplatform.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.platform.wpool"
+#endif
+
+#define TIZ_WPOOL_RUNQ_INITIAL_CAPACITY 64
+#define TIZ_WPOOL_DESTROY_POLL_USEC 500
+#define TIZ_WPOOL_THREAD_NAME_LEN 16
+
+typedef enum tiz_wpool_task_state tiz_wpool_task_state_t;
+enum tiz_wpool_task_state
+{
+  ETIZWPoolTaskIdle = 0,
+  ETIZWPoolTaskQueued,
+  ETIZWPoolTaskRunning,
+  ETIZWPoolTaskRunningSignalled,
+};
+
+struct tiz_wpool_task
+{
+  tiz_wpool_t * p_pool;
+  tiz_wpool_task_f pf_run;
+  void * p_arg;
+  int32_t state;
+};
+
+typedef struct tiz_wpool_runq tiz_wpool_runq_t;
+struct tiz_wpool_runq
+{
+  tiz_mutex_t mutex;
+  tiz_wpool_task_t ** pp_tasks;
+  OMX_S32 capacity;
+  OMX_S32 head;
+  OMX_S32 length;
+};
+
+typedef struct tiz_wpool_worker tiz_wpool_worker_t;
+struct tiz_wpool_worker
+{
+  tiz_wpool_t * p_pool;
+  tiz_thread_t thread;
+  OMX_S32 index;
+  tiz_wpool_runq_t runq;
+};
+
+struct tiz_wpool
+{
+  tiz_wpool_worker_t * p_workers;
+  OMX_S32 nworkers;
+  char name[TIZ_WPOOL_THREAD_NAME_LEN];
+  /* Idle workers park here */
+  tiz_mutex_t mutex;
+  tiz_cond_t cond;
+  /* Number of entries across all the run queues */
+  int32_t queued;
+  /* Number of parked workers */
+  int32_t parked;
+  bool stopping;
+  /* Round-robin cursor for tasks signalled from non-worker threads */
+  uint32_t next;
+};
+
+/* The worker the calling thread belongs to, if any */
+static __thread tiz_wpool_worker_t * tl_p_worker = NULL;
+/* The task the calling thread is running, if any */
+static __thread tiz_wpool_task_t * tl_p_current = NULL;
+
+static OMX_ERRORTYPE
+runq_init (tiz_wpool_runq_t * ap_rq)
+{
+  assert (ap_rq);
+  tiz_check_omx (tiz_mutex_init (&(ap_rq->mutex)));
+  tiz_check_null_ret_oom (
+    (ap_rq->pp_tasks = tiz_mem_calloc (TIZ_WPOOL_RUNQ_INITIAL_CAPACITY,
+                                       sizeof (tiz_wpool_task_t *))));
+  ap_rq->capacity = TIZ_WPOOL_RUNQ_INITIAL_CAPACITY;
+  ap_rq->head = 0;
+  ap_rq->length = 0;
+  return OMX_ErrorNone;
+}
+
+static void
+runq_destroy (tiz_wpool_runq_t * ap_rq)
+{
+  assert (ap_rq);
+  assert (0 == ap_rq->length);
+  tiz_mem_free (ap_rq->pp_tasks);
+  ap_rq->pp_tasks = NULL;
+  (void) tiz_mutex_destroy (&(ap_rq->mutex));
+}
+
+static OMX_ERRORTYPE
+runq_grow (tiz_wpool_runq_t * ap_rq)
+{
+  tiz_wpool_task_t ** pp_tasks = NULL;
+  OMX_S32 i = 0;
+
+  assert (ap_rq);
+
+  tiz_check_null_ret_oom (
+    (pp_tasks
+     = tiz_mem_calloc (ap_rq->capacity * 2, sizeof (tiz_wpool_task_t *))));
+
+  for (i = 0; i < ap_rq->length; ++i)
+    {
+      pp_tasks[i] = ap_rq->pp_tasks[(ap_rq->head + i) % ap_rq->capacity];
+    }
+
+  tiz_mem_free (ap_rq->pp_tasks);
+  ap_rq->pp_tasks = pp_tasks;
+  ap_rq->capacity *= 2;
+  ap_rq->head = 0;
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+runq_push (tiz_wpool_t * ap_pool, tiz_wpool_runq_t * ap_rq,
+           tiz_wpool_task_t * ap_task)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (ap_pool);
+  assert (ap_rq);
+  assert (ap_task);
+
+  (void) tiz_mutex_lock (&(ap_rq->mutex));
+  if (ap_rq->length == ap_rq->capacity)
+    {
+      rc = runq_grow (ap_rq);
+    }
+  if (OMX_ErrorNone == rc)
+    {
+      ap_rq->pp_tasks[(ap_rq->head + ap_rq->length) % ap_rq->capacity]
+        = ap_task;
+      ap_rq->length++;
+      (void) __atomic_add_fetch (&(ap_pool->queued), 1, __ATOMIC_SEQ_CST);
+    }
+  (void) tiz_mutex_unlock (&(ap_rq->mutex));
+
+  return rc;
+}
+
+/* Returns a task that has been moved to the 'running' state, or NULL */
+static tiz_wpool_task_t *
+runq_pop (tiz_wpool_t * ap_pool, tiz_wpool_runq_t * ap_rq)
+{
+  tiz_wpool_task_t * p_task = NULL;
+
+  assert (ap_pool);
+  assert (ap_rq);
+
+  (void) tiz_mutex_lock (&(ap_rq->mutex));
+  while (ap_rq->length > 0 && !p_task)
+    {
+      int32_t expected = ETIZWPoolTaskQueued;
+      tiz_wpool_task_t * p_next = ap_rq->pp_tasks[ap_rq->head];
+      ap_rq->head = (ap_rq->head + 1) % ap_rq->capacity;
+      ap_rq->length--;
+      (void) __atomic_sub_fetch (&(ap_pool->queued), 1, __ATOMIC_SEQ_CST);
+      /* The entry is stale if somebody else claimed the task already */
+      if (__atomic_compare_exchange_n (&(p_next->state), &expected,
+                                       ETIZWPoolTaskRunning, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+          p_task = p_next;
+        }
+    }
+  (void) tiz_mutex_unlock (&(ap_rq->mutex));
+
+  return p_task;
+}
+
+static void
+runq_purge (tiz_wpool_t * ap_pool, tiz_wpool_runq_t * ap_rq,
+            const tiz_wpool_task_t * ap_task)
+{
+  OMX_S32 i = 0;
+  OMX_S32 kept = 0;
+
+  assert (ap_pool);
+  assert (ap_rq);
+
+  (void) tiz_mutex_lock (&(ap_rq->mutex));
+  for (i = 0; i < ap_rq->length; ++i)
+    {
+      tiz_wpool_task_t * p_task
+        = ap_rq->pp_tasks[(ap_rq->head + i) % ap_rq->capacity];
+      if (p_task != ap_task)
+        {
+          ap_rq->pp_tasks[(ap_rq->head + kept) % ap_rq->capacity] = p_task;
+          ++kept;
+        }
+    }
+  (void) __atomic_sub_fetch (&(ap_pool->queued), ap_rq->length - kept,
+                             __ATOMIC_SEQ_CST);
+  ap_rq->length = kept;
+  (void) tiz_mutex_unlock (&(ap_rq->mutex));
+}
+
+static void
+enqueue_task (tiz_wpool_t * ap_pool, tiz_wpool_task_t * ap_task)
+{
+  tiz_wpool_worker_t * p_worker = tl_p_worker;
+
+  assert (ap_pool);
+  assert (ap_task);
+
+  if (!p_worker || p_worker->p_pool != ap_pool)
+    {
+      const uint32_t next
+        = __atomic_fetch_add (&(ap_pool->next), 1, __ATOMIC_RELAXED);
+      p_worker = &(ap_pool->p_workers[next % ap_pool->nworkers]);
+    }
+
+  if (OMX_ErrorNone != runq_push (ap_pool, &(p_worker->runq), ap_task))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "[OMX_ErrorInsufficientResources] : "
+               "Could not queue task [%p]",
+               ap_task);
+      return;
+    }
+
+  /* Pairs with the 'parked' increment in worker_thread_func */
+  if (__atomic_load_n (&(ap_pool->parked), __ATOMIC_SEQ_CST) > 0)
+    {
+      (void) tiz_mutex_lock (&(ap_pool->mutex));
+      (void) tiz_cond_signal (&(ap_pool->cond));
+      (void) tiz_mutex_unlock (&(ap_pool->mutex));
+    }
+}
+
+static void
+execute_task (tiz_wpool_task_t * ap_task)
+{
+  tiz_wpool_task_t * p_prev = tl_p_current;
+  int32_t expected = ETIZWPoolTaskRunning;
+
+  assert (ap_task);
+  assert (ap_task->pf_run);
+
+  tl_p_current = ap_task;
+  ap_task->pf_run (ap_task->p_arg);
+  tl_p_current = p_prev;
+
+  if (!__atomic_compare_exchange_n (&(ap_task->state), &expected,
+                                    ETIZWPoolTaskIdle, false, __ATOMIC_ACQ_REL,
+                                    __ATOMIC_ACQUIRE))
+    {
+      /* Signalled while running; go to the back of the queue */
+      assert (ETIZWPoolTaskRunningSignalled == expected);
+      __atomic_store_n (&(ap_task->state), ETIZWPoolTaskQueued,
+                        __ATOMIC_RELEASE);
+      enqueue_task (ap_task->p_pool, ap_task);
+    }
+}
+
+static tiz_wpool_task_t *
+find_task (tiz_wpool_t * ap_pool, tiz_wpool_worker_t * ap_worker)
+{
+  tiz_wpool_task_t * p_task = NULL;
+  OMX_S32 i = 0;
+
+  assert (ap_pool);
+  assert (ap_worker);
+
+  if (!(p_task = runq_pop (ap_pool, &(ap_worker->runq))))
+    {
+      for (i = 1; i < ap_pool->nworkers && !p_task; ++i)
+        {
+          p_task = runq_pop (
+            ap_pool,
+            &(ap_pool->p_workers[(ap_worker->index + i) % ap_pool->nworkers]
+                .runq));
+        }
+    }
+
+  return p_task;
+}
+
+static void *
+worker_thread_func (void * ap_arg)
+{
+  tiz_wpool_worker_t * p_worker = ap_arg;
+  tiz_wpool_t * p_pool = NULL;
+  char name[TIZ_WPOOL_THREAD_NAME_LEN];
+  bool done = false;
+
+  assert (p_worker);
+  p_pool = p_worker->p_pool;
+  assert (p_pool);
+
+  tl_p_worker = p_worker;
+  /* The pool's name leaves room for a three-digit index; this bounds both, so
+     that the name always fits */
+  (void) snprintf (name, sizeof (name), "%.*s%u",
+                   TIZ_WPOOL_THREAD_NAME_LEN - 4, p_pool->name,
+                   (unsigned int) (p_worker->index % 1000));
+  (void) tiz_thread_setname (&(p_worker->thread), name);
+
+  while (!done)
+    {
+      tiz_wpool_task_t * p_task = find_task (p_pool, p_worker);
+      if (p_task)
+        {
+          execute_task (p_task);
+          continue;
+        }
+
+      (void) tiz_mutex_lock (&(p_pool->mutex));
+      (void) __atomic_add_fetch (&(p_pool->parked), 1, __ATOMIC_SEQ_CST);
+      /* Pairs with the 'parked' load in enqueue_task */
+      while (0 == __atomic_load_n (&(p_pool->queued), __ATOMIC_SEQ_CST)
+             && !p_pool->stopping)
+        {
+          (void) tiz_cond_wait (&(p_pool->cond), &(p_pool->mutex));
+        }
+      (void) __atomic_sub_fetch (&(p_pool->parked), 1, __ATOMIC_SEQ_CST);
+      done = p_pool->stopping
+             && 0 == __atomic_load_n (&(p_pool->queued), __ATOMIC_SEQ_CST);
+      (void) tiz_mutex_unlock (&(p_pool->mutex));
+    }
+
+  return NULL;
+}
+
+static void
+stop_workers (tiz_wpool_t * ap_pool, const OMX_S32 a_nstarted)
+{
+  OMX_S32 i = 0;
+
+  assert (ap_pool);
+
+  (void) tiz_mutex_lock (&(ap_pool->mutex));
+  ap_pool->stopping = true;
+  (void) tiz_cond_broadcast (&(ap_pool->cond));
+  (void) tiz_mutex_unlock (&(ap_pool->mutex));
+
+  for (i = 0; i < a_nstarted; ++i)
+    {
+      OMX_PTR p_result = NULL;
+      (void) tiz_thread_join (&(ap_pool->p_workers[i].thread), &p_result);
+    }
+}
+
+static void
+free_pool (tiz_wpool_t * ap_pool)
+{
+  OMX_S32 i = 0;
+
+  assert (ap_pool);
+
+  for (i = 0; ap_pool->p_workers && i < ap_pool->nworkers; ++i)
+    {
+      if (ap_pool->p_workers[i].runq.pp_tasks)
+        {
+          runq_destroy (&(ap_pool->p_workers[i].runq));
+        }
+    }
+
+  tiz_mem_free (ap_pool->p_workers);
+  (void) tiz_cond_destroy (&(ap_pool->cond));
+  (void) tiz_mutex_destroy (&(ap_pool->mutex));
+  tiz_mem_free (ap_pool);
+}
+
+OMX_ERRORTYPE
+tiz_wpool_init (tiz_wpool_ptr_t * app_pool, OMX_S32 a_nworkers,
+                const char * ap_name)
+{
+  tiz_wpool_t * p_pool = NULL;
+  OMX_ERRORTYPE rc = OMX_ErrorInsufficientResources;
+  OMX_S32 nstarted = 0;
+  OMX_S32 i = 0;
+
+  assert (app_pool);
+  assert (a_nworkers >= 0);
+
+  if (0 == a_nworkers)
+    {
+      const long nprocs = sysconf (_SC_NPROCESSORS_ONLN);
+      a_nworkers = nprocs > 0 ? (OMX_S32) nprocs : 1;
+    }
+
+  tiz_check_null_ret_oom ((p_pool = tiz_mem_calloc (1, sizeof (tiz_wpool_t))));
+
+  /* Leave room for the worker index in the thread names */
+  (void) snprintf (p_pool->name, TIZ_WPOOL_THREAD_NAME_LEN - 3, "%s",
+                   ap_name ? ap_name : "tizwpool");
+
+  tiz_goto_end_on_omx_err (tiz_mutex_init (&(p_pool->mutex)),
+                           "Error initializing mutex.");
+  tiz_goto_end_on_omx_err (tiz_cond_init (&(p_pool->cond)),
+                           "Error initializing cond.");
+  tiz_goto_end_on_null ((p_pool->p_workers = tiz_mem_calloc (
+                           a_nworkers, sizeof (tiz_wpool_worker_t))),
+                        "Error allocating workers.");
+  p_pool->nworkers = a_nworkers;
+
+  for (i = 0; i < a_nworkers; ++i)
+    {
+      p_pool->p_workers[i].p_pool = p_pool;
+      p_pool->p_workers[i].index = i;
+      tiz_goto_end_on_omx_err (runq_init (&(p_pool->p_workers[i].runq)),
+                               "Error initializing run queue.");
+    }
+
+  for (nstarted = 0; nstarted < a_nworkers; ++nstarted)
+    {
+      tiz_goto_end_on_omx_err (
+        tiz_thread_create (&(p_pool->p_workers[nstarted].thread), 0, 0,
+                           worker_thread_func, &(p_pool->p_workers[nstarted])),
+        "Error creating worker thread.");
+    }
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "pool [%p] workers [%d]", p_pool, a_nworkers);
+  rc = OMX_ErrorNone;
+
+end:
+
+  if (OMX_ErrorNone != rc)
+    {
+      stop_workers (p_pool, nstarted);
+      free_pool (p_pool);
+      p_pool = NULL;
+    }
+
+  *app_pool = p_pool;
+  return rc;
+}
+
+void
+tiz_wpool_destroy (tiz_wpool_t * ap_pool)
+{
+  if (!ap_pool)
+    {
+      return;
+    }
+
+  assert (!tl_p_worker || tl_p_worker->p_pool != ap_pool);
+  assert (0 == ap_pool->queued);
+
+  stop_workers (ap_pool, ap_pool->nworkers);
+  free_pool (ap_pool);
+}
+
+OMX_S32
+tiz_wpool_size (tiz_wpool_t * ap_pool)
+{
+  assert (ap_pool);
+  return ap_pool->nworkers;
+}
+
+OMX_ERRORTYPE
+tiz_wpool_task_init (tiz_wpool_t * ap_pool, tiz_wpool_task_ptr_t * app_task,
+                     tiz_wpool_task_f a_pf_run, void * ap_arg)
+{
+  tiz_wpool_task_t * p_task = NULL;
+
+  assert (ap_pool);
+  assert (app_task);
+  assert (a_pf_run);
+
+  tiz_check_null_ret_oom (
+    (p_task = tiz_mem_calloc (1, sizeof (tiz_wpool_task_t))));
+
+  p_task->p_pool = ap_pool;
+  p_task->pf_run = a_pf_run;
+  p_task->p_arg = ap_arg;
+  p_task->state = ETIZWPoolTaskIdle;
+
+  *app_task = p_task;
+  return OMX_ErrorNone;
+}
+
+void
+tiz_wpool_task_destroy (tiz_wpool_task_t * ap_task)
+{
+  tiz_wpool_t * p_pool = NULL;
+  OMX_S32 i = 0;
+
+  if (!ap_task)
+    {
+      return;
+    }
+
+  p_pool = ap_task->p_pool;
+  assert (p_pool);
+  assert (tl_p_current != ap_task);
+
+  /* Let any pending run complete */
+  while (ETIZWPoolTaskIdle
+         != __atomic_load_n (&(ap_task->state), __ATOMIC_ACQUIRE))
+    {
+      if (!tiz_wpool_task_try_run (ap_task))
+        {
+          (void) tiz_sleep (TIZ_WPOOL_DESTROY_POLL_USEC);
+        }
+    }
+
+  /* Get rid of any stale entries still pointing to this task */
+  for (i = 0; i < p_pool->nworkers; ++i)
+    {
+      runq_purge (p_pool, &(p_pool->p_workers[i].runq), ap_task);
+    }
+
+  tiz_mem_free (ap_task);
+}
+
+void
+tiz_wpool_task_signal (tiz_wpool_task_t * ap_task)
+{
+  assert (ap_task);
+
+  for (;;)
+    {
+      int32_t state = __atomic_load_n (&(ap_task->state), __ATOMIC_ACQUIRE);
+      switch (state)
+        {
+          case ETIZWPoolTaskIdle:
+            {
+              if (__atomic_compare_exchange_n (
+                    &(ap_task->state), &state, ETIZWPoolTaskQueued, false,
+                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                {
+                  enqueue_task (ap_task->p_pool, ap_task);
+                  return;
+                }
+            }
+            break;
+          case ETIZWPoolTaskRunning:
+            {
+              if (__atomic_compare_exchange_n (
+                    &(ap_task->state), &state, ETIZWPoolTaskRunningSignalled,
+                    false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                {
+                  return;
+                }
+            }
+            break;
+          default:
+            {
+              /* Already queued, or due to run again */
+              return;
+            }
+        };
+    }
+}
+
+OMX_BOOL
+tiz_wpool_task_try_run (tiz_wpool_task_t * ap_task)
+{
+  assert (ap_task);
+
+  if (!tl_p_worker || tl_p_worker->p_pool != ap_task->p_pool)
+    {
+      return OMX_FALSE;
+    }
+
+  for (;;)
+    {
+      int32_t state = __atomic_load_n (&(ap_task->state), __ATOMIC_ACQUIRE);
+      if (ETIZWPoolTaskIdle != state && ETIZWPoolTaskQueued != state)
+        {
+          return OMX_FALSE;
+        }
+      /* If the task was queued, its run queue entry becomes stale */
+      if (__atomic_compare_exchange_n (&(ap_task->state), &state,
+                                       ETIZWPoolTaskRunning, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+          execute_task (ap_task);
+          return OMX_TRUE;
+        }
+    }
+}
+
+OMX_BOOL
+tiz_wpool_task_is_current (const tiz_wpool_task_t * ap_task)
+{
+  return (ap_task && tl_p_current == ap_task) ? OMX_TRUE : OMX_FALSE;
+}
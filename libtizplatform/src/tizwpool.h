@@ -0,0 +1,161 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizwpool.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Work-stealing worker pool of serialized tasks
+ *
+ *
+ */
+
+#ifndef TIZWPOOL_H
+#define TIZWPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup tizwpool Worker pool
+ *
+ * A fixed set of worker threads that run tasks. Each worker owns a run
+ * queue, and idle workers steal from their peers. A task is never run by two
+ * workers at the same time: signalling a task that is already queued is a
+ * no-op, and signalling a task that is running makes it run once more after
+ * the current run completes.
+ *
+ * @ingroup libtizplatform
+ */
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+/**
+ * Worker pool opaque structure.
+ * @ingroup tizwpool
+ */
+typedef struct tiz_wpool tiz_wpool_t;
+typedef /*@null@ */ tiz_wpool_t * tiz_wpool_ptr_t;
+
+/**
+ * Task opaque structure.
+ * @ingroup tizwpool
+ */
+typedef struct tiz_wpool_task tiz_wpool_task_t;
+typedef /*@null@ */ tiz_wpool_task_t * tiz_wpool_task_ptr_t;
+
+/**
+ * The task's body. It is run by one of the pool's workers every time the task
+ * is signalled.
+ * @ingroup tizwpool
+ */
+typedef void (*tiz_wpool_task_f) (void * ap_arg);
+
+/**
+ * Create a new worker pool.
+ *
+ * @ingroup tizwpool
+ *
+ * @param a_nworkers The number of worker threads. If zero, the number of
+ * online processors is used.
+ *
+ * @param ap_name A name prefix for the worker threads (may be NULL).
+ *
+ * @return OMX_ErrorNone if success, OMX_ErrorInsufficientResources otherwise.
+ */
+OMX_ERRORTYPE
+tiz_wpool_init (/*@out@*/ tiz_wpool_ptr_t * app_pool, OMX_S32 a_nworkers,
+                const char * ap_name);
+
+/**
+ * Stop and join the worker threads and destroy the pool. All tasks must have
+ * been destroyed before calling this function. If ap_pool is NULL, no
+ * operation is performed.
+ *
+ * @ingroup tizwpool
+ */
+void
+tiz_wpool_destroy (/*@null@ */ tiz_wpool_t * ap_pool);
+
+/**
+ * Retrieve the number of worker threads in the pool.
+ *
+ * @ingroup tizwpool
+ */
+OMX_S32
+tiz_wpool_size (tiz_wpool_t * ap_pool);
+
+/**
+ * Create a new task. The task is idle until it is signalled.
+ *
+ * @ingroup tizwpool
+ *
+ * @return OMX_ErrorNone if success, OMX_ErrorInsufficientResources otherwise.
+ */
+OMX_ERRORTYPE
+tiz_wpool_task_init (tiz_wpool_t * ap_pool,
+                     /*@out@*/ tiz_wpool_task_ptr_t * app_task,
+                     tiz_wpool_task_f a_pf_run, void * ap_arg);
+
+/**
+ * Destroy a task. If the task is queued or running, this function waits until
+ * the task becomes idle. The task must not be signalled once this function
+ * has been called. If ap_task is NULL, no operation is performed.
+ *
+ * @ingroup tizwpool
+ */
+void
+tiz_wpool_task_destroy (/*@null@ */ tiz_wpool_task_t * ap_task);
+
+/**
+ * Request a run of the task. May be called from any thread.
+ *
+ * @ingroup tizwpool
+ */
+void
+tiz_wpool_task_signal (tiz_wpool_task_t * ap_task);
+
+/**
+ * Run the task on the calling thread, provided that the calling thread is one
+ * of the pool's workers and the task is not currently running elsewhere. This
+ * allows a worker that is about to block waiting on a task to run the task
+ * itself, instead of waiting for another worker to become available.
+ *
+ * @ingroup tizwpool
+ *
+ * @return OMX_TRUE if the task has been run, OMX_FALSE otherwise.
+ */
+OMX_BOOL
+tiz_wpool_task_try_run (tiz_wpool_task_t * ap_task);
+
+/**
+ * Find out whether the calling thread is currently running the task.
+ *
+ * @ingroup tizwpool
+ */
+OMX_BOOL
+tiz_wpool_task_is_current (const tiz_wpool_task_t * ap_task);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIZWPOOL_H */
@@ -0,0 +1,270 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_buffer.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Dynamic buffer unit tests
+ *
+ *
+ */
+
+#include <stdbool.h>
+
+static void
+buffer_test_fill (unsigned char *ap_data, const size_t a_nbytes,
+                  const unsigned int a_seed)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nbytes; ++i)
+    {
+      ap_data[i] = (unsigned char) ((a_seed + i) * 31);
+    }
+}
+
+static bool
+buffer_test_verify (const unsigned char *ap_data, const size_t a_nbytes,
+                    const unsigned int a_seed)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nbytes; ++i)
+    {
+      if (ap_data[i] != (unsigned char) ((a_seed + i) * 31))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+START_TEST (test_buffer_ring_push_and_get)
+{
+  tiz_buffer_t *p_buf = NULL;
+  unsigned char data[3000];
+  unsigned int seed = 0;
+  int i = 0;
+
+  fail_if (OMX_ErrorNone != tiz_buffer_init (&p_buf, 4096));
+  fail_if (TIZ_BUFFER_NON_SEEKABLE
+           != tiz_buffer_seek_mode (p_buf, TIZ_BUFFER_RING));
+
+  /* Push and consume in steps that don't divide the ring size, so that the
+     data regularly straddles the end of the store */
+  for (i = 0; i < 100; ++i)
+    {
+      buffer_test_fill (data, sizeof (data), seed);
+      fail_if (sizeof (data) != tiz_buffer_push (p_buf, data, sizeof (data)));
+      fail_if (sizeof (data) != tiz_buffer_available (p_buf));
+      fail_if (!buffer_test_verify (tiz_buffer_get (p_buf), sizeof (data),
+                                    seed));
+      fail_if (1000 != tiz_buffer_advance (p_buf, 1000));
+      fail_if (!buffer_test_verify (tiz_buffer_get (p_buf), 2000, seed + 1000));
+      fail_if (2000 != tiz_buffer_advance (p_buf, 2000));
+      fail_if (0 != tiz_buffer_available (p_buf));
+      seed += 7;
+    }
+
+  /* Backwards seeks are not supported */
+  fail_if (-1 != tiz_buffer_seek (p_buf, 0, TIZ_BUFFER_SEEK_SET));
+  fail_if (-1 != tiz_buffer_seek (p_buf, -1, TIZ_BUFFER_SEEK_CUR));
+
+  buffer_test_fill (data, sizeof (data), 0);
+  fail_if (sizeof (data) != tiz_buffer_push (p_buf, data, sizeof (data)));
+  fail_if (0 != tiz_buffer_seek (p_buf, 100, TIZ_BUFFER_SEEK_CUR));
+  fail_if (!buffer_test_verify (tiz_buffer_get (p_buf), 2900, 100));
+  fail_if (0 != tiz_buffer_seek (p_buf, -50, TIZ_BUFFER_SEEK_END));
+  fail_if (50 != tiz_buffer_available (p_buf));
+  fail_if (!buffer_test_verify (tiz_buffer_get (p_buf), 50, 2950));
+
+  /* Back to linear mode; the data available is preserved */
+  fail_if (TIZ_BUFFER_RING
+           != tiz_buffer_seek_mode (p_buf, TIZ_BUFFER_NON_SEEKABLE));
+  fail_if (50 != tiz_buffer_available (p_buf));
+  fail_if (0 != tiz_buffer_offset (p_buf));
+  fail_if (!buffer_test_verify (tiz_buffer_get (p_buf), 50, 2950));
+
+  tiz_buffer_destroy (p_buf);
+}
+END_TEST
+
+START_TEST (test_buffer_ring_reserve_commit)
+{
+  tiz_buffer_t *p_buf = NULL;
+  unsigned char *p_dst = NULL;
+  size_t nbytes = 0;
+  void *p_src = NULL;
+
+  fail_if (OMX_ErrorNone != tiz_buffer_init (&p_buf, 4096));
+  fail_if (TIZ_BUFFER_NON_SEEKABLE
+           != tiz_buffer_seek_mode (p_buf, TIZ_BUFFER_RING));
+
+  /* Move the position near the end of the store */
+  fail_if (NULL == (p_dst = tiz_buffer_reserve (p_buf, 4000)));
+  fail_if (4000 != tiz_buffer_commit (p_buf, 4000));
+  fail_if (3990 != tiz_buffer_consume (p_buf, 3990));
+
+  /* A reserved span across the end of the store is contiguous */
+  fail_if (NULL == (p_dst = tiz_buffer_reserve (p_buf, 2000)));
+  buffer_test_fill (p_dst, 2000, 3);
+  fail_if (2000 != tiz_buffer_commit (p_buf, 2000));
+  p_src = tiz_buffer_peek (p_buf, &nbytes);
+  fail_if (2010 != nbytes);
+  fail_if (!buffer_test_verify ((unsigned char *) p_src + 10, 2000, 3));
+
+  /* Growing keeps the data */
+  fail_if (NULL == (p_dst = tiz_buffer_reserve (p_buf, 1024 * 1024)));
+  buffer_test_fill (p_dst, 1024 * 1024, 5);
+  fail_if (1024 * 1024 != tiz_buffer_commit (p_buf, 1024 * 1024));
+  p_src = tiz_buffer_peek (p_buf, &nbytes);
+  fail_if (2010 + 1024 * 1024 != nbytes);
+  fail_if (!buffer_test_verify ((unsigned char *) p_src + 10, 2000, 3));
+  fail_if (
+    !buffer_test_verify ((unsigned char *) p_src + 2010, 1024 * 1024, 5));
+
+  /* Commits never go beyond the free space */
+  fail_if (NULL == tiz_buffer_reserve (p_buf, 1));
+  fail_if (tiz_buffer_commit (p_buf, 64 * 1024 * 1024)
+           > 64 * 1024 * 1024 - 2010 - 1024 * 1024);
+
+  tiz_buffer_clear (p_buf);
+  fail_if (0 != tiz_buffer_available (p_buf));
+
+  /* Once drained, the store is small again and still works */
+  fail_if (NULL == (p_dst = tiz_buffer_reserve (p_buf, 100)));
+  buffer_test_fill (p_dst, 100, 9);
+  fail_if (100 != tiz_buffer_commit (p_buf, 100));
+  fail_if (!buffer_test_verify (tiz_buffer_get (p_buf), 100, 9));
+
+  tiz_buffer_destroy (p_buf);
+}
+END_TEST
+
+START_TEST (test_buffer_linear_reserve_commit)
+{
+  tiz_buffer_t *p_buf = NULL;
+  unsigned char *p_dst = NULL;
+  size_t nbytes = 0;
+
+  fail_if (OMX_ErrorNone != tiz_buffer_init (&p_buf, 1024));
+
+  fail_if (NULL == (p_dst = tiz_buffer_reserve (p_buf, 1000)));
+  buffer_test_fill (p_dst, 1000, 1);
+  fail_if (1000 != tiz_buffer_commit (p_buf, 1000));
+  fail_if (900 != tiz_buffer_consume (p_buf, 900));
+
+  /* Fits once the consumed data is dropped */
+  fail_if (NULL == (p_dst = tiz_buffer_reserve (p_buf, 900)));
+  buffer_test_fill (p_dst, 900, 1001);
+  fail_if (900 != tiz_buffer_commit (p_buf, 900));
+  fail_if (0 != tiz_buffer_offset (p_buf));
+  fail_if (!buffer_test_verify (tiz_buffer_peek (p_buf, &nbytes), 1000, 901));
+  fail_if (1000 != nbytes);
+
+  /* Needs to grow */
+  fail_if (NULL == (p_dst = tiz_buffer_reserve (p_buf, 5000)));
+  fail_if (5000 != tiz_buffer_commit (p_buf, 5000));
+  fail_if (6000 != tiz_buffer_available (p_buf));
+
+  tiz_buffer_destroy (p_buf);
+}
+END_TEST
+
+#define BUFFER_BENCH_TOTAL_BYTES (256 * 1024 * 1024)
+#define BUFFER_BENCH_BACKLOG 4
+
+/* Push chunks of a_chunk_sz bytes while the consumer lags behind by a few
+   chunks, which is how demuxers and http sources tend to use the buffer */
+static double
+buffer_bench_run (const int a_seek_mode, const bool a_reserve,
+                  const size_t a_chunk_sz)
+{
+  tiz_buffer_t *p_buf = NULL;
+  unsigned char *p_chunk = NULL;
+  const size_t nchunks = BUFFER_BENCH_TOTAL_BYTES / a_chunk_sz;
+  OMX_U64 start = 0;
+  OMX_U64 elapsed = 0;
+  size_t i = 0;
+
+  fail_if (NULL == (p_chunk = malloc (a_chunk_sz)));
+  buffer_test_fill (p_chunk, a_chunk_sz, 0);
+  fail_if (OMX_ErrorNone != tiz_buffer_init (&p_buf, a_chunk_sz));
+  fail_if (-1 == tiz_buffer_seek_mode (p_buf, a_seek_mode));
+
+  start = mpscq_test_now_ns ();
+  for (i = 0; i < nchunks; ++i)
+    {
+      if (a_reserve)
+        {
+          void *p_dst = tiz_buffer_reserve (p_buf, a_chunk_sz);
+          fail_if (NULL == p_dst);
+          memcpy (p_dst, p_chunk, a_chunk_sz);
+          fail_if (a_chunk_sz != tiz_buffer_commit (p_buf, a_chunk_sz));
+        }
+      else
+        {
+          fail_if (a_chunk_sz != tiz_buffer_push (p_buf, p_chunk, a_chunk_sz));
+        }
+      if (i >= BUFFER_BENCH_BACKLOG)
+        {
+          size_t nbytes = 0;
+          (void) tiz_buffer_peek (p_buf, &nbytes);
+          fail_if (nbytes < a_chunk_sz);
+          fail_if (a_chunk_sz != tiz_buffer_consume (p_buf, a_chunk_sz));
+        }
+    }
+  elapsed = mpscq_test_now_ns () - start;
+
+  tiz_buffer_destroy (p_buf);
+  free (p_chunk);
+
+  return ((double) nchunks * a_chunk_sz / (1024.0 * 1024.0))
+         / ((double) elapsed / 1e9);
+}
+
+START_TEST (test_buffer_benchmark)
+{
+  const size_t chunk_sizes[] = {4 * 1024, 64 * 1024, 1024 * 1024};
+  size_t i = 0;
+
+  fprintf (stderr, "buffer benchmark: %d MB pushed, consumer lagging %d "
+                   "chunks behind\n",
+           BUFFER_BENCH_TOTAL_BYTES / (1024 * 1024), BUFFER_BENCH_BACKLOG);
+  fprintf (stderr, "  %-8s %18s %18s %18s\n", "chunk", "non-seekable push",
+           "ring push", "ring reserve");
+  for (i = 0; i < sizeof (chunk_sizes) / sizeof (chunk_sizes[0]); ++i)
+    {
+      const double linear_mbs
+        = buffer_bench_run (TIZ_BUFFER_NON_SEEKABLE, false, chunk_sizes[i]);
+      const double ring_mbs
+        = buffer_bench_run (TIZ_BUFFER_RING, false, chunk_sizes[i]);
+      const double reserve_mbs
+        = buffer_bench_run (TIZ_BUFFER_RING, true, chunk_sizes[i]);
+      fprintf (stderr, "  %6zuKB %13.0f MB/s %13.0f MB/s %13.0f MB/s\n",
+               chunk_sizes[i] / 1024, linear_mbs, ring_mbs, reserve_mbs);
+    }
+}
+END_TEST
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
@@ -35,6 +35,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <time.h>
+#include <pthread.h>
 
 #define CHECK_IO_SERV_PORT 9877
 #define CHECK_IO_MAXLINE 4096
@@ -43,6 +44,9 @@
 
 #define CHECK_TIMER_PERIOD 1.5
 
+#define CHECK_SHARDS_TIMER_PERIOD 0.02
+#define CHECK_SHARDS_TIMEOUTS 3
+
 #define CHECK_STAT_FILE "/tmp/check_event.txt"
 #define CHECK_STAT_RM_CMD "/bin/bash -c \"rm -f /tmp/check_event.txt\""
 #define CHECK_STAT_TOUCH_CMD "/bin/bash -c \"touch /tmp/check_event.txt\""
@@ -53,6 +57,8 @@ static int g_timeout_count = 5;
 static int g_restart_count = 2;
 static bool g_timer_restarted = false;
 static bool g_file_status_changed = false;
+static pthread_t g_shard_threads[2];
+static int g_shard_timeout_counts[2];
 
 static void
 check_event_io_cback (OMX_HANDLETYPE p_hdl, tiz_event_io_t * ap_ev_io, void *ap_arg1,
@@ -166,6 +172,27 @@ check_event_stat_cback (OMX_HANDLETYPE p_hdl, tiz_event_stat_t * ap_ev_stat,
   fail_if (OMX_ErrorNone != error);
 }
 
+static void
+check_event_shard_timer_cback (OMX_HANDLETYPE p_hdl,
+                               tiz_event_timer_t * ap_ev_timer, void * ap_arg,
+                               const uint32_t a_id)
+{
+  const int idx = (int) (intptr_t) ap_arg;
+
+  fail_if (NULL == ap_ev_timer);
+  fail_if (idx < 0 || idx > 1);
+
+  g_shard_threads[idx] = pthread_self ();
+
+  /* The timer is stopped from its own event loop thread; this takes effect
+     right away, so there must be no more timeouts after this one */
+  fail_if (g_shard_timeout_counts[idx] >= CHECK_SHARDS_TIMEOUTS);
+  if (++g_shard_timeout_counts[idx] == CHECK_SHARDS_TIMEOUTS)
+    {
+      fail_if (OMX_ErrorNone != tiz_event_timer_stop (ap_ev_timer));
+    }
+}
+
 /* TESTS */
 
 START_TEST (test_event_loop_init_and_destroy)
@@ -341,6 +368,62 @@ START_TEST (test_event_stat)
 }
 END_TEST
 
+START_TEST (test_event_loop_shards)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_event_timer_t * p_ev_timers[2];
+  tiz_event_loop_jitter_t jitter;
+  /* Two fake component handles */
+  int hdls[2];
+  int i = 0;
+
+  error = tiz_event_loop_init ();
+  fail_if (error != OMX_ErrorNone);
+
+  /* See tizonia.conf in this directory */
+  fail_if (2 != tiz_event_loop_get_shard_count ());
+
+  fail_if (OMX_ErrorBadParameter != tiz_event_loop_pin (&hdls[0], 2));
+
+  for (i = 0; i < 2; ++i)
+    {
+      error = tiz_event_loop_pin (&hdls[i], i);
+      fail_if (error != OMX_ErrorNone);
+
+      error = tiz_event_timer_init (&p_ev_timers[i], &hdls[i],
+                                    check_event_shard_timer_cback,
+                                    (void *) (intptr_t) i);
+      fail_if (error != OMX_ErrorNone);
+
+      tiz_event_timer_set (p_ev_timers[i], CHECK_SHARDS_TIMER_PERIOD,
+                           CHECK_SHARDS_TIMER_PERIOD);
+
+      error = tiz_event_timer_start (p_ev_timers[i], i + 1);
+      fail_if (error != OMX_ErrorNone);
+    }
+
+  sleep (1);
+
+  /* Each timer ran on its own shard's thread */
+  fail_if (pthread_equal (g_shard_threads[0], g_shard_threads[1]));
+
+  for (i = 0; i < 2; ++i)
+    {
+      fail_if (CHECK_SHARDS_TIMEOUTS != g_shard_timeout_counts[i]);
+
+      error = tiz_event_loop_get_timer_jitter (i, &jitter);
+      fail_if (error != OMX_ErrorNone);
+      fail_if (CHECK_SHARDS_TIMEOUTS != jitter.count);
+      fail_if (jitter.max_us < 0.);
+
+      tiz_event_timer_destroy (p_ev_timers[i]);
+      tiz_event_loop_unpin (&hdls[i]);
+    }
+
+  tiz_event_loop_destroy ();
+}
+END_TEST
+
 /* Local Variables: */
 /* c-default-style: gnu */
 /* fill-column: 79 */
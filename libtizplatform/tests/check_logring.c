@@ -0,0 +1,208 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_logring.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Asynchronous logging backend unit tests and micro-benchmark
+ *
+ *
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LOGRING_TEST_THREADS 4
+#define LOGRING_TEST_RECORDS 100
+#define LOGRING_BENCH_CALLS 200000
+/* Well within the benchmark's 1 MiB ring, so that nothing is dropped */
+#define LOGRING_BENCH_BATCH 2000
+
+static void *
+logring_test_thread (void *ap_arg)
+{
+  static tiz_log_site_t site = {NULL, 0, 0, 0};
+  const long id = (long) ap_arg;
+  int i = 0;
+
+  for (i = 0; i < LOGRING_TEST_RECORDS; ++i)
+    {
+      tiz_log_at_site (&site, __FILE__, __LINE__, __FUNCTION__,
+                       TIZ_LOG_CATEGORY_NAME, TIZ_PRIORITY_TRACE, NULL, NULL,
+                       "thread [%ld] record [%03d] [%s] [%.2f] [%-*d] [%zu]",
+                       id, i, "str", 0.5, 4, -i, (size_t) 42);
+    }
+  return NULL;
+}
+
+/* Wait until the drain thread has taken the first a_records records */
+static void
+logring_test_wait_drained (const uint64_t a_records)
+{
+  const struct timespec period = {0, 1000000};
+  tiz_log_ring_stats_t stats;
+
+  for (tiz_log_ring_get_stats (&stats); stats.records < a_records;
+       tiz_log_ring_get_stats (&stats))
+    {
+      nanosleep (&period, NULL);
+    }
+}
+
+/* CPU time of the calling thread; the drain thread's work is not included */
+static uint64_t
+logring_test_thread_ns (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static char *
+logring_test_dump (const char *ap_file)
+{
+  char *p_text = NULL;
+  size_t len = 0;
+  FILE *p_out = open_memstream (&p_text, &len);
+
+  fail_if (p_out == NULL);
+  fail_if (OMX_ErrorNone != tiz_log_ring_dump (ap_file, p_out));
+  fclose (p_out);
+  return p_text;
+}
+
+START_TEST (test_log_ring_record_and_dump)
+{
+  char file[] = "/tmp/check_logring.XXXXXX";
+  pthread_t threads[LOGRING_TEST_THREADS];
+  tiz_log_ring_stats_t stats;
+  char *p_text = NULL;
+  long i = 0;
+  int fd = mkstemp (file);
+
+  fail_if (fd < 0);
+  close (fd);
+
+  fail_if (OMX_ErrorNone != tiz_log_ring_start (file, 0));
+  fail_if (OMX_TRUE != tiz_log_ring_is_active ());
+  fail_if (OMX_ErrorIncorrectStateOperation
+           != tiz_log_ring_start (file, 0));
+
+  for (i = 0; i < LOGRING_TEST_THREADS; ++i)
+    {
+      fail_if (0 != pthread_create (&threads[i], NULL, logring_test_thread,
+                                    (void *) i));
+    }
+  for (i = 0; i < LOGRING_TEST_THREADS; ++i)
+    {
+      pthread_join (threads[i], NULL);
+    }
+
+  /* A conversion that can not be recorded is logged synchronously */
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "wide [%ls]", L"abc");
+
+  tiz_log_ring_stop ();
+  fail_if (OMX_FALSE != tiz_log_ring_is_active ());
+
+  tiz_log_ring_get_stats (&stats);
+  fail_if (LOGRING_TEST_THREADS * LOGRING_TEST_RECORDS != stats.records);
+  fail_if (0 != stats.dropped);
+
+  p_text = logring_test_dump (file);
+  fail_if (NULL == strstr (p_text, "[TRACE] [" TIZ_LOG_CATEGORY_NAME "]"));
+  fail_if (NULL
+           == strstr (p_text, "thread [3] record [099] [str] [0.50] [-99 ] [42]"));
+  fail_if (NULL != strstr (p_text, "wide"));
+
+  free (p_text);
+  unlink (file);
+}
+END_TEST
+
+START_TEST (test_log_ring_benchmark)
+{
+  static tiz_log_site_t site = {NULL, 0, 0, 0};
+  char file[] = "/tmp/check_logring.XXXXXX";
+  tiz_log_ring_stats_t stats;
+  char text[4096];
+  uint64_t start = 0;
+  uint64_t rec_ns = 0;
+  double ns = 0;
+  double fmt_ns = 0;
+  int i = 0;
+  int j = 0;
+  int fd = mkstemp (file);
+
+  fail_if (fd < 0);
+  close (fd);
+
+  /* For reference, what the synchronous path spends on formatting alone */
+  start = logring_test_thread_ns ();
+  for (i = 0; i < LOGRING_BENCH_CALLS; ++i)
+    {
+      snprintf (text, sizeof (text),
+                "buffer [%p] nFilledLen [%u] nOffset [%u] [%s]", &i, i, 0,
+                "OMX_StateExecuting");
+    }
+  fmt_ns = (double) (logring_test_thread_ns () - start) / LOGRING_BENCH_CALLS;
+
+  fail_if (OMX_ErrorNone != tiz_log_ring_start (file, 1024 * 1024));
+
+  /* Only the recording calls are timed. The ring is drained between batches,
+     so that every call is recorded rather than dropped */
+  for (i = 0; i < LOGRING_BENCH_CALLS; i += LOGRING_BENCH_BATCH)
+    {
+      start = logring_test_thread_ns ();
+      for (j = i; j < i + LOGRING_BENCH_BATCH; ++j)
+        {
+          tiz_log_at_site (&site, __FILE__, __LINE__, __FUNCTION__,
+                           TIZ_LOG_CATEGORY_NAME, TIZ_PRIORITY_TRACE, NULL,
+                           NULL, "buffer [%p] nFilledLen [%u] nOffset [%u] [%s]",
+                           &j, j, 0, "OMX_StateExecuting");
+        }
+      rec_ns += logring_test_thread_ns () - start;
+      logring_test_wait_drained (i + LOGRING_BENCH_BATCH);
+    }
+  ns = (double) rec_ns / LOGRING_BENCH_CALLS;
+
+  tiz_log_ring_stop ();
+  tiz_log_ring_get_stats (&stats);
+
+  fprintf (stderr,
+           "log ring benchmark: %d calls, %.1f ns/call recording "
+           "(%llu recorded, %llu dropped; snprintf alone: %.1f ns)\n",
+           LOGRING_BENCH_CALLS, ns, (unsigned long long) stats.records,
+           (unsigned long long) stats.dropped, fmt_ns);
+  fail_if (LOGRING_BENCH_CALLS != stats.records);
+  fail_if (0 != stats.dropped);
+
+  unlink (file);
+}
+END_TEST
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
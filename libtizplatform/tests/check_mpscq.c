@@ -0,0 +1,327 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_mpscq.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Lock-free MPSC queue API unit tests and micro-benchmark
+ *
+ *
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#define MPSCQ_TEST_CAPACITY 30
+#define MPSCQ_TEST_MAX_PRODUCERS 8
+#define MPSCQ_TEST_ITEMS_PER_PRODUCER 20000
+
+typedef struct mpscq_test_item mpscq_test_item_t;
+struct mpscq_test_item
+{
+  OMX_U64 sent_ns;
+  OMX_S32 producer;
+  OMX_S32 seq;
+};
+
+typedef OMX_ERRORTYPE (*mpscq_test_send_f) (void * ap_q, OMX_PTR ap_data);
+typedef OMX_ERRORTYPE (*mpscq_test_recv_f) (void * ap_q, OMX_PTR * app_data);
+
+typedef struct mpscq_test_producer mpscq_test_producer_t;
+struct mpscq_test_producer
+{
+  void * p_q;
+  mpscq_test_send_f pf_send;
+  OMX_S32 id;
+  OMX_S32 nitems;
+  mpscq_test_item_t * p_items;
+};
+
+static OMX_U64
+mpscq_test_now_ns (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (OMX_U64) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int
+mpscq_test_cmp_u64 (const void * ap_a, const void * ap_b)
+{
+  const OMX_U64 a = *(const OMX_U64 *) ap_a;
+  const OMX_U64 b = *(const OMX_U64 *) ap_b;
+  return (a > b) - (a < b);
+}
+
+static OMX_ERRORTYPE
+mpscq_test_queue_send (void * ap_q, OMX_PTR ap_data)
+{
+  return tiz_queue_send (ap_q, ap_data);
+}
+
+static OMX_ERRORTYPE
+mpscq_test_queue_receive (void * ap_q, OMX_PTR * app_data)
+{
+  return tiz_queue_receive (ap_q, app_data);
+}
+
+static OMX_ERRORTYPE
+mpscq_test_mpscq_send (void * ap_q, OMX_PTR ap_data)
+{
+  return tiz_mpscq_send (ap_q, ap_data);
+}
+
+static OMX_ERRORTYPE
+mpscq_test_mpscq_receive (void * ap_q, OMX_PTR * app_data)
+{
+  return tiz_mpscq_receive (ap_q, app_data);
+}
+
+static void *
+mpscq_test_producer_thread (void * ap_arg)
+{
+  mpscq_test_producer_t * p_prod = ap_arg;
+  OMX_S32 i = 0;
+
+  for (i = 0; i < p_prod->nitems; ++i)
+    {
+      mpscq_test_item_t * p_item = &(p_prod->p_items[i]);
+      p_item->producer = p_prod->id;
+      p_item->seq = i;
+      p_item->sent_ns = mpscq_test_now_ns ();
+      fail_if (OMX_ErrorNone != p_prod->pf_send (p_prod->p_q, p_item));
+    }
+
+  return NULL;
+}
+
+/* Runs a_nproducers threads against a single consumer (the calling thread)
+   and reports messages/sec and the p50/p99 send-to-receive latency. */
+static void
+mpscq_test_run (const char * ap_name, void * ap_q, mpscq_test_send_f apf_send,
+                mpscq_test_recv_f apf_recv, OMX_S32 a_nproducers)
+{
+  const OMX_S32 total = a_nproducers * MPSCQ_TEST_ITEMS_PER_PRODUCER;
+  mpscq_test_producer_t prods[MPSCQ_TEST_MAX_PRODUCERS];
+  tiz_thread_t threads[MPSCQ_TEST_MAX_PRODUCERS];
+  OMX_S32 next_seq[MPSCQ_TEST_MAX_PRODUCERS];
+  OMX_U64 * p_lat = tiz_mem_calloc (total, sizeof (OMX_U64));
+  OMX_U64 start_ns = 0;
+  OMX_U64 elapsed_ns = 0;
+  OMX_S32 i = 0;
+
+  fail_if (NULL == p_lat);
+
+  for (i = 0; i < a_nproducers; ++i)
+    {
+      prods[i].p_q = ap_q;
+      prods[i].pf_send = apf_send;
+      prods[i].id = i;
+      prods[i].nitems = MPSCQ_TEST_ITEMS_PER_PRODUCER;
+      prods[i].p_items = tiz_mem_calloc (MPSCQ_TEST_ITEMS_PER_PRODUCER,
+                                         sizeof (mpscq_test_item_t));
+      fail_if (NULL == prods[i].p_items);
+      next_seq[i] = 0;
+    }
+
+  start_ns = mpscq_test_now_ns ();
+
+  for (i = 0; i < a_nproducers; ++i)
+    {
+      fail_if (OMX_ErrorNone
+               != tiz_thread_create (&(threads[i]), 0, 0,
+                                     mpscq_test_producer_thread, &(prods[i])));
+    }
+
+  for (i = 0; i < total; ++i)
+    {
+      OMX_PTR p_data = NULL;
+      mpscq_test_item_t * p_item = NULL;
+      fail_if (OMX_ErrorNone != apf_recv (ap_q, &p_data));
+      p_item = p_data;
+      p_lat[i] = mpscq_test_now_ns () - p_item->sent_ns;
+      /* Per-producer FIFO order must be preserved */
+      fail_if (p_item->seq != next_seq[p_item->producer]);
+      next_seq[p_item->producer]++;
+    }
+
+  elapsed_ns = mpscq_test_now_ns () - start_ns;
+
+  for (i = 0; i < a_nproducers; ++i)
+    {
+      void * p_result = NULL;
+      tiz_thread_join (&(threads[i]), &p_result);
+      tiz_mem_free (prods[i].p_items);
+    }
+
+  qsort (p_lat, total, sizeof (OMX_U64), mpscq_test_cmp_u64);
+
+  fprintf (stderr,
+           "[%-6s] producers [%d] msgs/sec [%10.0f] "
+           "latency p50 [%6llu ns] p99 [%8llu ns]\n",
+           ap_name, (int) a_nproducers,
+           (double) total * 1000000000.0 / (double) elapsed_ns,
+           (unsigned long long) p_lat[total / 2],
+           (unsigned long long) p_lat[(total * 99) / 100]);
+
+  tiz_mem_free (p_lat);
+}
+
+START_TEST (test_mpscq_init_and_destroy)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_mpscq_t * p_queue = NULL;
+
+  error = tiz_mpscq_init (&p_queue, 10);
+
+  fail_if (error != OMX_ErrorNone);
+  fail_if (10 != tiz_mpscq_capacity (p_queue));
+  fail_if (0 != tiz_mpscq_length (p_queue));
+
+  tiz_mpscq_destroy (p_queue);
+}
+END_TEST
+
+START_TEST (test_mpscq_send_and_receive)
+{
+  OMX_U32 i;
+  OMX_PTR p_received = NULL;
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  int * p_item = NULL;
+  tiz_mpscq_t * p_queue = NULL;
+
+  error = tiz_mpscq_init (&p_queue, 10);
+
+  fail_if (error != OMX_ErrorNone);
+
+  /* Go around the ring a few times */
+  for (i = 0; i < 30; i++)
+    {
+      p_item = (int *) tiz_mem_alloc (sizeof (int));
+      fail_if (p_item == NULL);
+      *p_item = i;
+      error = tiz_mpscq_send (p_queue, p_item);
+      fail_if (error != OMX_ErrorNone);
+      fail_if (1 != tiz_mpscq_length (p_queue));
+
+      error = tiz_mpscq_receive (p_queue, &p_received);
+      fail_if (error != OMX_ErrorNone);
+      fail_if (p_received == NULL);
+      fail_if (*((int *) p_received) != i);
+      tiz_mem_free (p_received);
+    }
+
+  for (i = 0; i < 10; i++)
+    {
+      p_item = (int *) tiz_mem_alloc (sizeof (int));
+      fail_if (p_item == NULL);
+      *p_item = i;
+      error = tiz_mpscq_send (p_queue, p_item);
+      fail_if (error != OMX_ErrorNone);
+    }
+
+  fail_if (10 != tiz_mpscq_length (p_queue));
+
+  for (i = 0; i < 10; i++)
+    {
+      error = tiz_mpscq_receive (p_queue, &p_received);
+      fail_if (error != OMX_ErrorNone);
+      fail_if (p_received == NULL);
+      p_item = (int *) p_received;
+      fail_if (*p_item != i);
+      tiz_mem_free (p_received);
+    }
+
+  tiz_mpscq_destroy (p_queue);
+}
+END_TEST
+
+START_TEST (test_mpscq_timed_receive)
+{
+  OMX_PTR p_received = NULL;
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_mpscq_t * p_queue = NULL;
+  int item = 7;
+
+  error = tiz_mpscq_init (&p_queue, 4);
+  fail_if (error != OMX_ErrorNone);
+
+  error = tiz_mpscq_timed_receive (p_queue, &p_received, 50);
+  fail_if (error != OMX_ErrorTimeout);
+  fail_if (p_received != NULL);
+
+  error = tiz_mpscq_send (p_queue, &item);
+  fail_if (error != OMX_ErrorNone);
+
+  error = tiz_mpscq_timed_receive (p_queue, &p_received, 50);
+  fail_if (error != OMX_ErrorNone);
+  fail_if (p_received != &item);
+
+  tiz_mpscq_destroy (p_queue);
+}
+END_TEST
+
+START_TEST (test_mpscq_multiple_producers)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_mpscq_t * p_queue = NULL;
+
+  /* A small queue forces both the producer and consumer parking paths */
+  error = tiz_mpscq_init (&p_queue, 2);
+  fail_if (error != OMX_ErrorNone);
+
+  mpscq_test_run ("mpscq", p_queue, mpscq_test_mpscq_send,
+                  mpscq_test_mpscq_receive, 4);
+  fail_if (0 != tiz_mpscq_length (p_queue));
+
+  tiz_mpscq_destroy (p_queue);
+}
+END_TEST
+
+START_TEST (test_mpscq_benchmark)
+{
+  OMX_S32 nprods = 0;
+
+  for (nprods = 1; nprods <= MPSCQ_TEST_MAX_PRODUCERS; nprods *= 2)
+    {
+      tiz_queue_t * p_queue = NULL;
+      tiz_mpscq_t * p_mpscq = NULL;
+
+      fail_if (OMX_ErrorNone
+               != tiz_queue_init (&p_queue, MPSCQ_TEST_CAPACITY));
+      mpscq_test_run ("queue", p_queue, mpscq_test_queue_send,
+                      mpscq_test_queue_receive, nprods);
+      tiz_queue_destroy (p_queue);
+
+      fail_if (OMX_ErrorNone
+               != tiz_mpscq_init (&p_mpscq, MPSCQ_TEST_CAPACITY));
+      mpscq_test_run ("mpscq", p_mpscq, mpscq_test_mpscq_send,
+                      mpscq_test_mpscq_receive, nprods);
+      tiz_mpscq_destroy (p_mpscq);
+    }
+}
+END_TEST
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
@@ -0,0 +1,366 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_pcm.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  PCM sample processing kernels unit tests
+ *
+ *
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Odd on purpose, so that the scalar tails of the vector kernels run too */
+#define PCM_TEST_SAMPLES 1027
+#define PCM_BENCH_FRAMES (64 * 1024)
+#define PCM_BENCH_ROUNDS 200
+
+static void
+pcm_test_fill (void *ap_data, const size_t a_nsamples, const tiz_pcm_fmt_t a_fmt,
+               unsigned int a_seed)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      a_seed = a_seed * 1103515245u + 12345u;
+      switch (a_fmt)
+        {
+          case TIZ_PCM_FMT_S16:
+            ((int16_t *) ap_data)[i] = (int16_t) (a_seed >> 16);
+            break;
+          case TIZ_PCM_FMT_S24:
+            memcpy ((uint8_t *) ap_data + 3 * i, &a_seed, 3);
+            break;
+          case TIZ_PCM_FMT_S32:
+            ((int32_t *) ap_data)[i] = (int32_t) a_seed;
+            break;
+          default:
+            ((float *) ap_data)[i] = (float) ((int32_t) a_seed) / 2147483648.f;
+            break;
+        };
+    }
+}
+
+/* Run a_fn once per instruction set supported, on a copy of the same data,
+   and check that the output matches the plain C implementation within
+   a_tolerance (in units of the sample format). */
+typedef void (*pcm_test_op_f) (void *ap_data, const size_t a_nsamples,
+                               const tiz_pcm_fmt_t a_fmt);
+
+static void
+pcm_test_ops_agree (pcm_test_op_f a_fn, const tiz_pcm_fmt_t a_fmt,
+                    const double a_tolerance)
+{
+  const size_t nbytes = PCM_TEST_SAMPLES * tiz_pcm_sample_size (a_fmt);
+  uint8_t *p_ref = tiz_mem_alloc (nbytes);
+  uint8_t *p_out = tiz_mem_alloc (nbytes);
+  const tiz_pcm_isa_t best = tiz_pcm_get_isa ();
+  int isa = 0;
+  size_t i = 0;
+
+  fail_if (!p_ref || !p_out);
+
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (TIZ_PCM_ISA_SCALAR));
+  pcm_test_fill (p_ref, PCM_TEST_SAMPLES, a_fmt, 7);
+  a_fn (p_ref, PCM_TEST_SAMPLES, a_fmt);
+
+  for (isa = TIZ_PCM_ISA_SCALAR + 1; isa < TIZ_PCM_ISA_MAX; ++isa)
+    {
+      if (OMX_ErrorNone != tiz_pcm_set_isa ((tiz_pcm_isa_t) isa))
+        {
+          continue;
+        }
+      pcm_test_fill (p_out, PCM_TEST_SAMPLES, a_fmt, 7);
+      a_fn (p_out, PCM_TEST_SAMPLES, a_fmt);
+      for (i = 0; i < PCM_TEST_SAMPLES; ++i)
+        {
+          double ref = 0, out = 0;
+          switch (a_fmt)
+            {
+              case TIZ_PCM_FMT_S16:
+                ref = ((int16_t *) p_ref)[i];
+                out = ((int16_t *) p_out)[i];
+                break;
+              case TIZ_PCM_FMT_S24:
+                ref = memcmp (p_ref + 3 * i, p_out + 3 * i, 3) ? 1e9 : 0;
+                break;
+              case TIZ_PCM_FMT_S32:
+                ref = ((int32_t *) p_ref)[i];
+                out = ((int32_t *) p_out)[i];
+                break;
+              default:
+                ref = ((float *) p_ref)[i];
+                out = ((float *) p_out)[i];
+                break;
+            };
+          if (fabs (ref - out) > a_tolerance)
+            {
+              fprintf (stderr, "%s: sample %zu differs (%f vs %f)\n",
+                       tiz_pcm_isa_to_str ((tiz_pcm_isa_t) isa), i, ref, out);
+            }
+          fail_if (fabs (ref - out) > a_tolerance);
+        }
+    }
+
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (best));
+  tiz_mem_free (p_ref);
+  tiz_mem_free (p_out);
+}
+
+static void
+pcm_test_gain (void *ap_data, const size_t a_nsamples,
+               const tiz_pcm_fmt_t a_fmt)
+{
+  tiz_pcm_gain (ap_data, a_nsamples, a_fmt, tiz_pcm_db_to_gain (3.5f));
+}
+
+static void
+pcm_test_ramp_mono (void *ap_data, const size_t a_nsamples,
+                    const tiz_pcm_fmt_t a_fmt)
+{
+  tiz_pcm_gain_ramp (ap_data, a_nsamples, 1, a_fmt, 0.f, 1.5f);
+}
+
+static void
+pcm_test_ramp_stereo (void *ap_data, const size_t a_nsamples,
+                      const tiz_pcm_fmt_t a_fmt)
+{
+  tiz_pcm_gain_ramp (ap_data, a_nsamples / 2, 2, a_fmt, 1.2f, 0.1f);
+}
+
+static void
+pcm_test_swap (void *ap_data, const size_t a_nsamples,
+               const tiz_pcm_fmt_t a_fmt)
+{
+  tiz_pcm_byteswap (ap_data, a_nsamples, a_fmt);
+}
+
+START_TEST (test_pcm_gain_and_clamp)
+{
+  int16_t s16[] = {100, -100, 20000, -20000, 32767, -32768, 0, 3};
+  int32_t s32[] = {1000, -1000, 2000000000, -2000000000};
+  float flt[] = {0.25f, -0.25f, 0.75f, -0.75f};
+  uint8_t s24[6];
+  int fmt = 0;
+
+  tiz_pcm_gain (s16, 8, TIZ_PCM_FMT_S16, 2.f);
+  fail_if (200 != s16[0] || -200 != s16[1]);
+  fail_if (32767 != s16[2] || -32768 != s16[3]);
+  fail_if (32767 != s16[4] || -32768 != s16[5]);
+  fail_if (0 != s16[6] || 6 != s16[7]);
+
+  tiz_pcm_gain (s32, 4, TIZ_PCM_FMT_S32, 2.f);
+  fail_if (2000 != s32[0] || -2000 != s32[1]);
+  fail_if (s32[2] < 2147483000 || s32[3] != INT32_MIN);
+
+  tiz_pcm_gain (flt, 4, TIZ_PCM_FMT_FLOAT, 2.f);
+  fail_if (0.5f != flt[0] || -0.5f != flt[1]);
+  fail_if (1.f != flt[2] || -1.f != flt[3]);
+
+  /* 0x001000 and -0x001000 */
+  s24[0] = 0x00, s24[1] = 0x10, s24[2] = 0x00;
+  s24[3] = 0x00, s24[4] = 0xf0, s24[5] = 0xff;
+  tiz_pcm_byteswap (s24, 2, TIZ_PCM_FMT_S24);
+  tiz_pcm_byteswap (s24, 2, TIZ_PCM_FMT_S24);
+  tiz_pcm_gain (s24, 2, TIZ_PCM_FMT_S24, 0.5f);
+  fail_if (0x00 != s24[0] || 0x08 != s24[1] || 0x00 != s24[2]);
+  fail_if (0x00 != s24[3] || 0xf8 != s24[4] || 0xff != s24[5]);
+
+  fail_if (fabsf (tiz_pcm_db_to_gain (20.f) - 10.f) > 1e-4f);
+  fail_if (fabsf (tiz_pcm_db_to_gain (0.f) - 1.f) > 1e-6f);
+
+  for (fmt = 0; fmt < TIZ_PCM_FMT_MAX; ++fmt)
+    {
+      pcm_test_ops_agree (pcm_test_gain, (tiz_pcm_fmt_t) fmt, 0);
+    }
+}
+END_TEST
+
+START_TEST (test_pcm_gain_ramp)
+{
+  int16_t s16[8] = {1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000};
+  int fmt = 0;
+
+  /* 4 stereo frames, from silence to unity */
+  tiz_pcm_gain_ramp (s16, 4, 2, TIZ_PCM_FMT_S16, 0.f, 1.f);
+  fail_if (0 != s16[0] || 0 != s16[1]);
+  fail_if (250 != s16[2] || 250 != s16[3]);
+  fail_if (500 != s16[4] || 500 != s16[5]);
+  fail_if (750 != s16[6] || 750 != s16[7]);
+
+  for (fmt = 0; fmt < TIZ_PCM_FMT_MAX; ++fmt)
+    {
+      /* Allow for fused multiply-adds in the plain C version */
+      const double tolerance = (TIZ_PCM_FMT_FLOAT == fmt ? 1e-6 : 1);
+      pcm_test_ops_agree (pcm_test_ramp_mono, (tiz_pcm_fmt_t) fmt, tolerance);
+      pcm_test_ops_agree (pcm_test_ramp_stereo, (tiz_pcm_fmt_t) fmt,
+                          tolerance);
+    }
+}
+END_TEST
+
+START_TEST (test_pcm_byteswap_and_upmix)
+{
+  uint16_t u16[] = {0x1234, 0xabcd};
+  uint32_t u32[] = {0x11223344, 0xa1b2c3d4};
+  int16_t mono[PCM_TEST_SAMPLES];
+  int16_t stereo[2 * PCM_TEST_SAMPLES];
+  int16_t quad[4 * PCM_TEST_SAMPLES];
+  float fmono[PCM_TEST_SAMPLES];
+  float fstereo[2 * PCM_TEST_SAMPLES];
+  uint8_t s24[3 * 3] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  uint8_t s24_out[3 * 3 * 2];
+  const tiz_pcm_isa_t best = tiz_pcm_get_isa ();
+  int isa = 0;
+  int fmt = 0;
+  size_t i = 0;
+
+  tiz_pcm_byteswap (u16, 2, TIZ_PCM_FMT_S16);
+  fail_if (0x3412 != u16[0] || 0xcdab != u16[1]);
+  tiz_pcm_byteswap (u32, 2, TIZ_PCM_FMT_S32);
+  fail_if (0x44332211 != u32[0] || 0xd4c3b2a1 != u32[1]);
+
+  for (fmt = 0; fmt < TIZ_PCM_FMT_MAX; ++fmt)
+    {
+      pcm_test_ops_agree (pcm_test_swap, (tiz_pcm_fmt_t) fmt, 0);
+    }
+
+  pcm_test_fill (mono, PCM_TEST_SAMPLES, TIZ_PCM_FMT_S16, 3);
+  pcm_test_fill (fmono, PCM_TEST_SAMPLES, TIZ_PCM_FMT_FLOAT, 5);
+  for (isa = TIZ_PCM_ISA_SCALAR; isa < TIZ_PCM_ISA_MAX; ++isa)
+    {
+      if (OMX_ErrorNone != tiz_pcm_set_isa ((tiz_pcm_isa_t) isa))
+        {
+          continue;
+        }
+      tiz_pcm_upmix (stereo, mono, PCM_TEST_SAMPLES, TIZ_PCM_FMT_S16, 1, 2);
+      tiz_pcm_upmix (quad, stereo, PCM_TEST_SAMPLES, TIZ_PCM_FMT_S16, 2, 4);
+      tiz_pcm_upmix (fstereo, fmono, PCM_TEST_SAMPLES, TIZ_PCM_FMT_FLOAT, 1,
+                     2);
+      for (i = 0; i < PCM_TEST_SAMPLES; ++i)
+        {
+          fail_if (stereo[2 * i] != mono[i] || stereo[2 * i + 1] != mono[i]);
+          fail_if (quad[4 * i] != mono[i] || quad[4 * i + 3] != mono[i]);
+          fail_if (fstereo[2 * i] != fmono[i]
+                   || fstereo[2 * i + 1] != fmono[i]);
+        }
+    }
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (best));
+
+  tiz_pcm_upmix (s24_out, s24, 3, TIZ_PCM_FMT_S24, 1, 2);
+  for (i = 0; i < 3; ++i)
+    {
+      fail_if (memcmp (s24_out + 6 * i, s24 + 3 * i, 3));
+      fail_if (memcmp (s24_out + 6 * i + 3, s24 + 3 * i, 3));
+    }
+}
+END_TEST
+
+static double
+pcm_bench_run (const int a_op, const tiz_pcm_fmt_t a_fmt,
+               const OMX_U32 a_nch, void *ap_src, void *ap_dst)
+{
+  const size_t nsamples = PCM_BENCH_FRAMES * a_nch;
+  const uint64_t start = mpscq_test_now_ns ();
+  int i = 0;
+
+  for (i = 0; i < PCM_BENCH_ROUNDS; ++i)
+    {
+      switch (a_op)
+        {
+          case 0:
+            tiz_pcm_gain (ap_src, nsamples, a_fmt, i & 1 ? 0.5f : 2.f);
+            break;
+          case 1:
+            tiz_pcm_gain_ramp (ap_src, PCM_BENCH_FRAMES, a_nch, a_fmt,
+                               i & 1 ? 0.5f : 1.f, i & 1 ? 1.f : 0.5f);
+            break;
+          case 2:
+            tiz_pcm_byteswap (ap_src, nsamples, a_fmt);
+            break;
+          default:
+            tiz_pcm_upmix (ap_dst, ap_src, PCM_BENCH_FRAMES, a_fmt, a_nch, 2);
+            break;
+        };
+    }
+
+  /* Millions of input samples per second */
+  return ((double) nsamples * PCM_BENCH_ROUNDS)
+         / ((mpscq_test_now_ns () - start) / 1e9) / 1e6;
+}
+
+START_TEST (test_pcm_benchmark)
+{
+  static const char *fmt_names[] = {"s16", "s24", "s32", "float"};
+  const tiz_pcm_isa_t best = tiz_pcm_get_isa ();
+  const size_t max_bytes = PCM_BENCH_FRAMES * 2 * 4;
+  void *p_src = tiz_mem_alloc (max_bytes);
+  void *p_dst = tiz_mem_alloc (2 * max_bytes);
+  int isa = 0;
+  int fmt = 0;
+  OMX_U32 nch = 0;
+
+  fail_if (!p_src || !p_dst);
+
+  fprintf (stderr, "pcm benchmark: %d frames x %d rounds, "
+                   "Msamples/s (default: %s)\n",
+           PCM_BENCH_FRAMES, PCM_BENCH_ROUNDS, tiz_pcm_isa_to_str (best));
+  fprintf (stderr, "  %-7s %-6s %3s %10s %10s %10s %10s\n", "isa", "format",
+           "ch", "gain", "ramp", "byteswap", "upmix->2");
+  for (isa = TIZ_PCM_ISA_SCALAR; isa < TIZ_PCM_ISA_MAX; ++isa)
+    {
+      if (OMX_ErrorNone != tiz_pcm_set_isa ((tiz_pcm_isa_t) isa))
+        {
+          continue;
+        }
+      for (fmt = 0; fmt < TIZ_PCM_FMT_MAX; ++fmt)
+        {
+          for (nch = 1; nch <= 2; ++nch)
+            {
+              pcm_test_fill (p_src, PCM_BENCH_FRAMES * nch,
+                             (tiz_pcm_fmt_t) fmt, 11);
+              fprintf (
+                stderr, "  %-7s %-6s %3lu %10.0f %10.0f %10.0f %10.0f\n",
+                tiz_pcm_isa_to_str ((tiz_pcm_isa_t) isa), fmt_names[fmt],
+                (unsigned long) nch,
+                pcm_bench_run (0, (tiz_pcm_fmt_t) fmt, nch, p_src, p_dst),
+                pcm_bench_run (1, (tiz_pcm_fmt_t) fmt, nch, p_src, p_dst),
+                pcm_bench_run (2, (tiz_pcm_fmt_t) fmt, nch, p_src, p_dst),
+                pcm_bench_run (3, (tiz_pcm_fmt_t) fmt, nch, p_src, p_dst));
+            }
+        }
+    }
+
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (best));
+  tiz_mem_free (p_src);
+  tiz_mem_free (p_dst);
+}
+END_TEST
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
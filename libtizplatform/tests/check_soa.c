@@ -255,6 +255,275 @@ START_TEST (test_soa_reserve_life_cycle)
 }
 END_TEST
 
+START_TEST (test_soa_large_classes)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_soa_t *p_soa = NULL;
+  const size_t sizes[] = {300, 900, 2000, 4000};
+  void *objs[4][8];
+  void *p_large = NULL;
+  int i = 0;
+  int j = 0;
+  tiz_soa_info_t info;
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_soa_large_classes - begin");
+
+  error = tiz_soa_init (&p_soa);
+  fail_if (error != OMX_ErrorNone);
+
+  /* Each large class fits 8 slices in a chunk */
+  for (i = 0; i < 4; i++)
+    {
+      for (j = 0; j < 8; j++)
+        {
+          fail_if (NULL == (objs[i][j] = tiz_soa_calloc (p_soa, sizes[i])));
+          memset (objs[i][j], 0xA5, sizes[i]);
+        }
+    }
+
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.chunks != 4);
+  fail_if (info.objects != 32);
+  for (i = 5; i < TIZ_SOA_NUM_CHUNK_CLASSES; i++)
+    {
+      fail_if (info.slices[i] != 8);
+      fail_if (info.classes[i].chunks != 1);
+      fail_if (info.classes[i].misses != 1);
+      fail_if (info.classes[i].hits != 7);
+      fail_if (info.classes[i].high_water != 8);
+    }
+
+  /* Anything larger than the largest class goes to the heap */
+  fail_if (NULL == (p_large = tiz_soa_calloc (p_soa, 10000)));
+  memset (p_large, 0xA5, 10000);
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.large_objects != 1);
+  fail_if (info.objects != 32);
+  tiz_soa_free (p_soa, p_large);
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.large_objects != 0);
+
+  for (i = 0; i < 4; i++)
+    {
+      for (j = 0; j < 8; j++)
+        {
+          tiz_soa_free (p_soa, objs[i][j]);
+        }
+    }
+
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.objects != 0);
+  for (i = 5; i < TIZ_SOA_NUM_CHUNK_CLASSES; i++)
+    {
+      fail_if (info.slices[i] != 0);
+      fail_if (info.classes[i].high_water != 8);
+    }
+
+  tiz_soa_dump (p_soa, "test_soa_large_classes");
+  tiz_soa_destroy (p_soa);
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_soa_large_classes - end");
+}
+END_TEST
+
+START_TEST (test_soa_chunk_reclamation)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_soa_t *p_soa = NULL;
+  size_t class0 = 8;
+  void *class0_objs[3 * MAX_CLASS0_OBJS];
+  int i = 0;
+  tiz_soa_info_t info;
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_soa_chunk_reclamation - begin");
+
+  error = tiz_soa_init (&p_soa);
+  fail_if (error != OMX_ErrorNone);
+
+  /* Enough class #0 objects to need three chunks */
+  for (i = 0; i < 3 * MAX_CLASS0_OBJS; i++)
+    {
+      fail_if (NULL == (class0_objs[i] = tiz_soa_calloc (p_soa, class0)));
+    }
+
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.chunks != 3);
+  fail_if (info.classes[0].chunks != 3);
+  fail_if (info.classes[0].misses != 3);
+  fail_if (info.classes[0].high_water != 3 * MAX_CLASS0_OBJS);
+
+  /* Free every other object; no chunk becomes empty */
+  for (i = 0; i < 3 * MAX_CLASS0_OBJS; i += 2)
+    {
+      tiz_soa_free (p_soa, class0_objs[i]);
+      class0_objs[i] = NULL;
+    }
+
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.chunks != 3);
+  fail_if (info.classes[0].reclaimed != 0);
+
+  /* Freed slices are reused before any new chunk is allocated */
+  for (i = 0; i < 3 * MAX_CLASS0_OBJS; i += 2)
+    {
+      fail_if (NULL == (class0_objs[i] = tiz_soa_calloc (p_soa, class0)));
+    }
+
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.chunks != 3);
+  fail_if (info.classes[0].misses != 3);
+
+  /* Free everything; all but one chunk go back to the system */
+  for (i = 0; i < 3 * MAX_CLASS0_OBJS; i++)
+    {
+      tiz_soa_free (p_soa, class0_objs[i]);
+    }
+
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.objects != 0);
+  fail_if (info.chunks != 1);
+  fail_if (info.classes[0].chunks != 1);
+  fail_if (info.classes[0].reclaimed != 2);
+  fail_if (info.classes[0].high_water != 3 * MAX_CLASS0_OBJS);
+
+  /* A single object going back and forth keeps reusing the last chunk */
+  for (i = 0; i < 1000; i++)
+    {
+      void *p_obj = tiz_soa_calloc (p_soa, class0);
+      fail_if (NULL == p_obj);
+      tiz_soa_free (p_soa, p_obj);
+    }
+
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.chunks != 1);
+  fail_if (info.classes[0].misses != 3);
+  fail_if (info.classes[0].reclaimed != 2);
+
+  tiz_soa_destroy (p_soa);
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_soa_chunk_reclamation - end");
+}
+END_TEST
+
+#define SOA_BENCH_SLOTS 1024
+#define SOA_BENCH_OPS 2000000
+
+typedef void *(*soa_bench_alloc_f) (void *ap_arg, size_t a_size);
+typedef void (*soa_bench_free_f) (void *ap_arg, void *ap_addr);
+
+static void *
+soa_bench_soa_alloc (void *ap_arg, size_t a_size)
+{
+  return tiz_soa_calloc (ap_arg, a_size);
+}
+
+static void
+soa_bench_soa_free (void *ap_arg, void *ap_addr)
+{
+  tiz_soa_free (ap_arg, ap_addr);
+}
+
+static void *
+soa_bench_libc_alloc (void *ap_arg, size_t a_size)
+{
+  (void) ap_arg;
+  return calloc (1, a_size);
+}
+
+static void
+soa_bench_libc_free (void *ap_arg, void *ap_addr)
+{
+  (void) ap_arg;
+  free (ap_addr);
+}
+
+/* Random allocs and frees over a fixed number of slots, with object sizes
+   that mimic scheduler messages, list nodes, and http parser state */
+static double
+soa_bench_run (soa_bench_alloc_f apf_alloc, soa_bench_free_f apf_free,
+               void *ap_arg)
+{
+  static const size_t sizes[] = {24, 48, 48, 64, 96, 96, 200, 400, 1500, 3000};
+  void *slots[SOA_BENCH_SLOTS];
+  uint32_t seed = 0x12345678;
+  OMX_U64 start = 0;
+  OMX_U64 elapsed = 0;
+  int i = 0;
+
+  memset (slots, 0, sizeof (slots));
+  start = mpscq_test_now_ns ();
+  for (i = 0; i < SOA_BENCH_OPS; i++)
+    {
+      uint32_t slot = 0;
+      seed = seed * 1103515245 + 12345;
+      slot = (seed >> 8) % SOA_BENCH_SLOTS;
+      if (slots[slot])
+        {
+          apf_free (ap_arg, slots[slot]);
+          slots[slot] = NULL;
+        }
+      else
+        {
+          slots[slot] = apf_alloc (
+            ap_arg, sizes[(seed >> 20) % (sizeof (sizes) / sizeof (sizes[0]))]);
+          fail_if (NULL == slots[slot]);
+        }
+    }
+  for (i = 0; i < SOA_BENCH_SLOTS; i++)
+    {
+      if (slots[i])
+        {
+          apf_free (ap_arg, slots[i]);
+        }
+    }
+  elapsed = mpscq_test_now_ns () - start;
+
+  return (double) elapsed / SOA_BENCH_OPS;
+}
+
+START_TEST (test_soa_benchmark)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_soa_t *p_soa = NULL;
+  tiz_soa_info_t info;
+  double soa_ns = 0;
+  double libc_ns = 0;
+  int i = 0;
+
+  error = tiz_soa_init (&p_soa);
+  fail_if (error != OMX_ErrorNone);
+
+  /* Warm up both allocators once */
+  (void) soa_bench_run (soa_bench_libc_alloc, soa_bench_libc_free, NULL);
+  (void) soa_bench_run (soa_bench_soa_alloc, soa_bench_soa_free, p_soa);
+
+  libc_ns = soa_bench_run (soa_bench_libc_alloc, soa_bench_libc_free, NULL);
+  soa_ns = soa_bench_run (soa_bench_soa_alloc, soa_bench_soa_free, p_soa);
+
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.objects != 0);
+
+  fprintf (stderr, "soa benchmark: %d ops over %d slots\n", SOA_BENCH_OPS,
+           SOA_BENCH_SLOTS);
+  fprintf (stderr, "  calloc/free      : %6.1f ns/op\n", libc_ns);
+  fprintf (stderr, "  tiz_soa          : %6.1f ns/op\n", soa_ns);
+  fprintf (stderr, "  chunks left      : %d\n", info.chunks);
+  for (i = 0; i < TIZ_SOA_NUM_CHUNK_CLASSES; i++)
+    {
+      const tiz_soa_class_info_t *p_ci = &(info.classes[i]);
+      fprintf (stderr,
+               "  class %4u : hits %9llu misses %5llu high water %5d "
+               "reclaimed %5llu\n",
+               (unsigned int) p_ci->slice_size,
+               (unsigned long long) p_ci->hits,
+               (unsigned long long) p_ci->misses, p_ci->high_water,
+               (unsigned long long) p_ci->reclaimed);
+    }
+
+  tiz_soa_destroy (p_soa);
+}
+END_TEST
+
 /* Local Variables: */
 /* c-default-style: gnu */
 /* fill-column: 79 */
@@ -0,0 +1,186 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_spscring.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Lock-free SPSC byte ring unit tests
+ *
+ *
+ */
+
+#include <sched.h>
+
+#define SPSCRING_TEST_CAPACITY 1000
+#define SPSCRING_TEST_TOTAL_BYTES (8 * 1024 * 1024)
+#define SPSCRING_TEST_CHUNK 733
+
+typedef struct spscring_test_producer spscring_test_producer_t;
+struct spscring_test_producer
+{
+  tiz_spscring_t * p_ring;
+  OMX_U32 total;
+};
+
+static void *
+spscring_test_producer_thread (void * ap_arg)
+{
+  spscring_test_producer_t * p_prod = ap_arg;
+  OMX_U8 chunk[SPSCRING_TEST_CHUNK];
+  OMX_U32 sent = 0;
+
+  while (sent < p_prod->total)
+    {
+      const OMX_U32 len = MIN (SPSCRING_TEST_CHUNK, p_prod->total - sent);
+      OMX_U32 done = 0;
+      OMX_U32 i = 0;
+      for (i = 0; i < len; ++i)
+        {
+          chunk[i] = (OMX_U8) ((sent + i) & 0xff);
+        }
+      while (done < len)
+        {
+          const OMX_U32 n
+            = tiz_spscring_write (p_prod->p_ring, chunk + done, len - done);
+          if (0 == n)
+            {
+              sched_yield ();
+            }
+          done += n;
+        }
+      sent += len;
+    }
+
+  return NULL;
+}
+
+START_TEST (test_spscring_init_and_destroy)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_spscring_t * p_ring = NULL;
+
+  error = tiz_spscring_init (&p_ring, SPSCRING_TEST_CAPACITY);
+
+  fail_if (error != OMX_ErrorNone);
+  /* Rounded up to the next power of two */
+  fail_if (1024 != tiz_spscring_capacity (p_ring));
+  fail_if (0 != tiz_spscring_available (p_ring));
+  fail_if (1024 != tiz_spscring_space (p_ring));
+
+  tiz_spscring_destroy (p_ring);
+}
+END_TEST
+
+START_TEST (test_spscring_write_and_read)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_spscring_t * p_ring = NULL;
+  OMX_U8 in[48];
+  OMX_U8 out[48];
+  OMX_U32 i = 0;
+  OMX_U32 round = 0;
+
+  error = tiz_spscring_init (&p_ring, 32);
+  fail_if (error != OMX_ErrorNone);
+
+  for (i = 0; i < sizeof (in); ++i)
+    {
+      in[i] = (OMX_U8) i;
+    }
+
+  /* Writes that do not fit are truncated */
+  fail_if (32 != tiz_spscring_write (p_ring, in, sizeof (in)));
+  fail_if (0 != tiz_spscring_space (p_ring));
+  fail_if (0 != tiz_spscring_write (p_ring, in, 1));
+
+  /* Reads of more than what is available are truncated too */
+  fail_if (32 != tiz_spscring_read (p_ring, out, sizeof (out)));
+  fail_if (0 != memcmp (in, out, 32));
+  fail_if (0 != tiz_spscring_read (p_ring, out, 1));
+
+  /* Exercise the wrap-around at every possible offset */
+  for (round = 0; round < 64; ++round)
+    {
+      const OMX_U32 len = 1 + (round % 31);
+      memset (out, 0, sizeof (out));
+      fail_if (len != tiz_spscring_write (p_ring, in + (round % 16), len));
+      fail_if (len != tiz_spscring_available (p_ring));
+      fail_if (len != tiz_spscring_read (p_ring, out, len));
+      fail_if (0 != memcmp (in + (round % 16), out, len));
+    }
+
+  /* Clearing discards whatever is stored */
+  fail_if (20 != tiz_spscring_write (p_ring, in, 20));
+  tiz_spscring_clear (p_ring);
+  fail_if (0 != tiz_spscring_available (p_ring));
+  fail_if (32 != tiz_spscring_space (p_ring));
+
+  tiz_spscring_destroy (p_ring);
+}
+END_TEST
+
+START_TEST (test_spscring_producer_consumer)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_spscring_t * p_ring = NULL;
+  spscring_test_producer_t prod;
+  tiz_thread_t thread;
+  void * p_result = NULL;
+  OMX_U8 out[SPSCRING_TEST_CHUNK];
+  OMX_U32 received = 0;
+
+  error = tiz_spscring_init (&p_ring, SPSCRING_TEST_CAPACITY);
+  fail_if (error != OMX_ErrorNone);
+
+  prod.p_ring = p_ring;
+  prod.total = SPSCRING_TEST_TOTAL_BYTES;
+  fail_if (OMX_ErrorNone
+           != tiz_thread_create (&thread, 0, 0,
+                                 spscring_test_producer_thread, &prod));
+
+  while (received < SPSCRING_TEST_TOTAL_BYTES)
+    {
+      /* An odd read size so that reads and writes never line up */
+      const OMX_U32 n = tiz_spscring_read (p_ring, out, sizeof (out) - 100);
+      OMX_U32 i = 0;
+      if (0 == n)
+        {
+          sched_yield ();
+        }
+      for (i = 0; i < n; ++i)
+        {
+          fail_if (out[i] != (OMX_U8) ((received + i) & 0xff));
+        }
+      received += n;
+    }
+
+  tiz_thread_join (&thread, &p_result);
+  fail_if (0 != tiz_spscring_available (p_ring));
+
+  tiz_spscring_destroy (p_ring);
+}
+END_TEST
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
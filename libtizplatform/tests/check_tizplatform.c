@@ -44,15 +44,28 @@
 #include "./check_sem.c"
 #include "./check_mutex.c"
 #include "./check_queue.c"
+#include "./check_mpscq.c"
+#include "./check_spscring.c"
+#include "./check_wpool.c"
 #include "./check_pqueue.c"
 #include "./check_vector.c"
 #include "./check_rc.c"
 #include "./check_soa.c"
+#include "./check_buffer.c"
+#include "./check_pcm.c"
+#include "./check_logring.c"
 #include "./check_event.c"
 #include "./check_http_parser.c"
 #include "./check_map.c"
 
 #define EVENT_API_TEST_TIMEOUT 100
+#define MPSCQ_API_TEST_TIMEOUT 100
+#define SPSCRING_API_TEST_TIMEOUT 100
+#define WPOOL_API_TEST_TIMEOUT 300
+#define SOA_API_TEST_TIMEOUT 100
+#define BUFFER_API_TEST_TIMEOUT 100
+#define PCM_API_TEST_TIMEOUT 100
+#define LOGRING_API_TEST_TIMEOUT 100
 
 Suite *
 platform_mem_suite (void)
@@ -108,6 +121,59 @@ platform_queue_suite (void)
   return s;
 }
 
+Suite *
+platform_mpscq_suite (void)
+{
+  TCase *tc_mpscq = NULL;
+  Suite *s = suite_create ("Lock-free MPSC queue");
+
+  /* mpscq API test case */
+  tc_mpscq = tcase_create ("mpscq");
+  tcase_set_timeout (tc_mpscq, MPSCQ_API_TEST_TIMEOUT);
+  tcase_add_test (tc_mpscq, test_mpscq_init_and_destroy);
+  tcase_add_test (tc_mpscq, test_mpscq_send_and_receive);
+  tcase_add_test (tc_mpscq, test_mpscq_timed_receive);
+  tcase_add_test (tc_mpscq, test_mpscq_multiple_producers);
+  tcase_add_test (tc_mpscq, test_mpscq_benchmark);
+  suite_add_tcase (s, tc_mpscq);
+
+  return s;
+}
+
+Suite *
+platform_spscring_suite (void)
+{
+  TCase *tc_spscring = NULL;
+  Suite *s = suite_create ("Lock-free SPSC byte ring");
+
+  /* spscring API test case */
+  tc_spscring = tcase_create ("spscring");
+  tcase_set_timeout (tc_spscring, SPSCRING_API_TEST_TIMEOUT);
+  tcase_add_test (tc_spscring, test_spscring_init_and_destroy);
+  tcase_add_test (tc_spscring, test_spscring_write_and_read);
+  tcase_add_test (tc_spscring, test_spscring_producer_consumer);
+  suite_add_tcase (s, tc_spscring);
+
+  return s;
+}
+
+Suite *
+platform_wpool_suite (void)
+{
+  TCase *tc_wpool = NULL;
+  Suite *s = suite_create ("Worker pool");
+
+  /* wpool API test case */
+  tc_wpool = tcase_create ("wpool");
+  tcase_set_timeout (tc_wpool, WPOOL_API_TEST_TIMEOUT);
+  tcase_add_test (tc_wpool, test_wpool_init_and_destroy);
+  tcase_add_test (tc_wpool, test_wpool_task_serialized);
+  tcase_add_test (tc_wpool, test_wpool_benchmark);
+  suite_add_tcase (s, tc_wpool);
+
+  return s;
+}
+
 Suite *
 platform_pqueue_suite (void)
 {
@@ -171,13 +237,69 @@ platform_soa_suite (void)
 
   /* small object allocation API test cases */
   tc_soa = tcase_create ("soa");
+  tcase_set_timeout (tc_soa, SOA_API_TEST_TIMEOUT);
   tcase_add_test (tc_soa, test_soa_basic_life_cycle);
   tcase_add_test (tc_soa, test_soa_reserve_life_cycle);
+  tcase_add_test (tc_soa, test_soa_large_classes);
+  tcase_add_test (tc_soa, test_soa_chunk_reclamation);
+  tcase_add_test (tc_soa, test_soa_benchmark);
   suite_add_tcase (s, tc_soa);
 
   return s;
 }
 
+Suite *
+platform_buffer_suite (void)
+{
+  TCase *tc_buffer = NULL;
+  Suite *s = suite_create ("Dynamic buffer APIs");
+
+  /* dynamic buffer API test cases */
+  tc_buffer = tcase_create ("buffer");
+  tcase_set_timeout (tc_buffer, BUFFER_API_TEST_TIMEOUT);
+  tcase_add_test (tc_buffer, test_buffer_ring_push_and_get);
+  tcase_add_test (tc_buffer, test_buffer_ring_reserve_commit);
+  tcase_add_test (tc_buffer, test_buffer_linear_reserve_commit);
+  tcase_add_test (tc_buffer, test_buffer_benchmark);
+  suite_add_tcase (s, tc_buffer);
+
+  return s;
+}
+
+Suite *
+platform_pcm_suite (void)
+{
+  TCase *tc_pcm = NULL;
+  Suite *s = suite_create ("PCM sample processing APIs");
+
+  /* pcm kernels test cases */
+  tc_pcm = tcase_create ("pcm");
+  tcase_set_timeout (tc_pcm, PCM_API_TEST_TIMEOUT);
+  tcase_add_test (tc_pcm, test_pcm_gain_and_clamp);
+  tcase_add_test (tc_pcm, test_pcm_gain_ramp);
+  tcase_add_test (tc_pcm, test_pcm_byteswap_and_upmix);
+  tcase_add_test (tc_pcm, test_pcm_benchmark);
+  suite_add_tcase (s, tc_pcm);
+
+  return s;
+}
+
+Suite *
+platform_logring_suite (void)
+{
+  TCase *tc_logring = NULL;
+  Suite *s = suite_create ("Asynchronous logging APIs");
+
+  /* asynchronous logging backend test cases */
+  tc_logring = tcase_create ("logring");
+  tcase_set_timeout (tc_logring, LOGRING_API_TEST_TIMEOUT);
+  tcase_add_test (tc_logring, test_log_ring_record_and_dump);
+  tcase_add_test (tc_logring, test_log_ring_benchmark);
+  suite_add_tcase (s, tc_logring);
+
+  return s;
+}
+
 Suite *
 platform_event_suite (void)
 {
@@ -196,6 +318,22 @@ platform_event_suite (void)
   return s;
 }
 
+Suite *
+platform_event_shards_suite (void)
+{
+  TCase  *tc_shards;
+  Suite *s = suite_create ("event loop shards");
+
+  /* NOTE: Unlike the rest of the event loop tests, this one needs no
+     external commands, so it runs even while "events" is disabled */
+  tc_shards = tcase_create ("event loop shards API");
+  tcase_set_timeout (tc_shards, EVENT_API_TEST_TIMEOUT);
+  tcase_add_test (tc_shards, test_event_loop_shards);
+  suite_add_tcase (s, tc_shards);
+
+  return s;
+}
+
 Suite *
 platform_http_parser_suite (void)
 {
@@ -240,13 +378,20 @@ main (void)
   sr = srunner_create (platform_mem_suite ());
   srunner_add_suite (sr, platform_sync_suite ());
   srunner_add_suite (sr, platform_queue_suite ());
+  srunner_add_suite (sr, platform_mpscq_suite ());
+  srunner_add_suite (sr, platform_spscring_suite ());
+  srunner_add_suite (sr, platform_wpool_suite ());
   srunner_add_suite (sr, platform_pqueue_suite ());
   srunner_add_suite (sr, platform_vector_suite ());
   srunner_add_suite (sr, platform_rcfile_suite ());
   srunner_add_suite (sr, platform_soa_suite ());
+  srunner_add_suite (sr, platform_buffer_suite ());
+  srunner_add_suite (sr, platform_pcm_suite ());
+  srunner_add_suite (sr, platform_logring_suite ());
   srunner_add_suite (sr, platform_http_parser_suite ());
   srunner_add_suite (sr, platform_map_suite ());
 /*   srunner_add_suite (sr, platform_event_suite ()); */
+  srunner_add_suite (sr, platform_event_shards_suite ());
   srunner_run_all (sr, CK_VERBOSE);
   number_failed = srunner_ntests_failed (sr);
   srunner_free (sr);
@@ -0,0 +1,424 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_wpool.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Worker pool API unit tests and thread-per-component vs pool
+ * benchmark
+ *
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#define WPOOL_TEST_NSIGNALLERS 4
+#define WPOOL_TEST_SIGNALS_PER_THREAD 5000
+#define WPOOL_TEST_BENCH_STAGES 3
+#define WPOOL_TEST_BENCH_TOKENS 4
+#define WPOOL_TEST_BENCH_BUFFERS 500
+#define WPOOL_TEST_BENCH_WORK 2000
+#define WPOOL_TEST_BENCH_QUEUE_CAPACITY 8
+
+/*
+ * Serialization test
+ */
+
+typedef struct wpool_test_counter wpool_test_counter_t;
+struct wpool_test_counter
+{
+  tiz_wpool_task_t * p_task;
+  int32_t requested;
+  int32_t processed;
+  int32_t inside;
+  int32_t overlaps;
+  int32_t runs;
+};
+
+static void
+wpool_test_counter_run (void * ap_arg)
+{
+  wpool_test_counter_t * p_cnt = ap_arg;
+  if (1 != __atomic_add_fetch (&(p_cnt->inside), 1, __ATOMIC_SEQ_CST))
+    {
+      (void) __atomic_add_fetch (&(p_cnt->overlaps), 1, __ATOMIC_SEQ_CST);
+    }
+  p_cnt->runs++;
+  (void) __atomic_add_fetch (
+    &(p_cnt->processed),
+    __atomic_exchange_n (&(p_cnt->requested), 0, __ATOMIC_SEQ_CST),
+    __ATOMIC_SEQ_CST);
+  (void) __atomic_sub_fetch (&(p_cnt->inside), 1, __ATOMIC_SEQ_CST);
+}
+
+static void *
+wpool_test_signaller_thread (void * ap_arg)
+{
+  wpool_test_counter_t * p_cnt = ap_arg;
+  OMX_S32 i = 0;
+
+  for (i = 0; i < WPOOL_TEST_SIGNALS_PER_THREAD; ++i)
+    {
+      (void) __atomic_add_fetch (&(p_cnt->requested), 1, __ATOMIC_SEQ_CST);
+      tiz_wpool_task_signal (p_cnt->p_task);
+    }
+
+  return NULL;
+}
+
+/*
+ * Benchmark: G graphs of three stages (source -> decoder -> sink) pass a
+ * small set of buffers around. In 'thread' mode each stage has its own thread
+ * blocked on a queue, which is what a component scheduler does today; in
+ * 'pool' mode each stage is a task on a shared worker pool.
+ */
+
+typedef struct wpool_test_graph wpool_test_graph_t;
+
+typedef struct wpool_test_stage wpool_test_stage_t;
+struct wpool_test_stage
+{
+  wpool_test_graph_t * p_graph;
+  OMX_S32 index;
+  tiz_queue_t * p_queue;
+  tiz_thread_t thread;
+  tiz_mpscq_t * p_inbox;
+  tiz_wpool_task_t * p_task;
+  OMX_U32 acc;
+};
+
+struct wpool_test_graph
+{
+  wpool_test_stage_t stages[WPOOL_TEST_BENCH_STAGES];
+  OMX_S32 tokens[WPOOL_TEST_BENCH_TOKENS];
+  OMX_S32 produced;
+  OMX_S32 retired;
+  OMX_BOOL pool_mode;
+  tiz_sem_t * p_done;
+};
+
+static OMX_S32 wpool_test_stop_token = 0;
+
+static OMX_S32
+wpool_test_thread_count (void)
+{
+  char line[128];
+  OMX_S32 nthreads = -1;
+  FILE * p_file = fopen ("/proc/self/status", "r");
+
+  if (p_file)
+    {
+      while (fgets (line, sizeof (line), p_file))
+        {
+          if (0 == strncmp (line, "Threads:", 8))
+            {
+              nthreads = atoi (line + 8);
+              break;
+            }
+        }
+      fclose (p_file);
+    }
+
+  return nthreads;
+}
+
+static void
+wpool_test_forward (wpool_test_graph_t * ap_graph, OMX_S32 a_stage,
+                    OMX_PTR ap_token)
+{
+  wpool_test_stage_t * p_stage = &(ap_graph->stages[a_stage]);
+  if (OMX_TRUE == ap_graph->pool_mode)
+    {
+      fail_if (OMX_ErrorNone != tiz_mpscq_send (p_stage->p_inbox, ap_token));
+      tiz_wpool_task_signal (p_stage->p_task);
+    }
+  else
+    {
+      fail_if (OMX_ErrorNone != tiz_queue_send (p_stage->p_queue, ap_token));
+    }
+}
+
+static void
+wpool_test_process (wpool_test_stage_t * ap_stage, OMX_PTR ap_token)
+{
+  wpool_test_graph_t * p_graph = ap_stage->p_graph;
+
+  if (0 == ap_stage->index)
+    {
+      if (p_graph->produced < WPOOL_TEST_BENCH_BUFFERS)
+        {
+          p_graph->produced++;
+          wpool_test_forward (p_graph, 1, ap_token);
+        }
+      else if (WPOOL_TEST_BENCH_TOKENS == ++p_graph->retired)
+        {
+          (void) tiz_sem_post (p_graph->p_done);
+        }
+    }
+  else
+    {
+      OMX_S32 i = 0;
+      /* Pretend to decode/render something */
+      for (i = 0; i < WPOOL_TEST_BENCH_WORK; ++i)
+        {
+          ap_stage->acc = ap_stage->acc * 1103515245 + 12345;
+        }
+      wpool_test_forward (
+        p_graph, (ap_stage->index + 1) % WPOOL_TEST_BENCH_STAGES, ap_token);
+    }
+}
+
+static void *
+wpool_test_stage_thread (void * ap_arg)
+{
+  wpool_test_stage_t * p_stage = ap_arg;
+  OMX_PTR p_token = NULL;
+
+  for (;;)
+    {
+      fail_if (OMX_ErrorNone != tiz_queue_receive (p_stage->p_queue, &p_token));
+      if (&wpool_test_stop_token == p_token)
+        {
+          break;
+        }
+      wpool_test_process (p_stage, p_token);
+    }
+
+  return NULL;
+}
+
+static void
+wpool_test_stage_task (void * ap_arg)
+{
+  wpool_test_stage_t * p_stage = ap_arg;
+  OMX_PTR p_token = NULL;
+
+  while (OMX_ErrorNone
+         == tiz_mpscq_timed_receive (p_stage->p_inbox, &p_token, 0))
+    {
+      wpool_test_process (p_stage, p_token);
+    }
+}
+
+static void
+wpool_test_bench_run (OMX_S32 a_ngraphs, tiz_wpool_t * ap_pool)
+{
+  wpool_test_graph_t * p_graphs = NULL;
+  tiz_sem_t done;
+  struct rusage ru_start;
+  struct rusage ru_end;
+  OMX_U64 start_ns = 0;
+  OMX_U64 elapsed_ns = 0;
+  double cpu_s = 0;
+  long ctxsw = 0;
+  OMX_S32 nthreads = 0;
+  OMX_S32 g = 0;
+  OMX_S32 s = 0;
+  OMX_S32 t = 0;
+
+  p_graphs = tiz_mem_calloc (a_ngraphs, sizeof (wpool_test_graph_t));
+  fail_if (NULL == p_graphs);
+  fail_if (OMX_ErrorNone != tiz_sem_init (&done, 0));
+
+  for (g = 0; g < a_ngraphs; ++g)
+    {
+      wpool_test_graph_t * p_graph = &(p_graphs[g]);
+      p_graph->pool_mode = ap_pool ? OMX_TRUE : OMX_FALSE;
+      p_graph->p_done = &done;
+      for (s = 0; s < WPOOL_TEST_BENCH_STAGES; ++s)
+        {
+          wpool_test_stage_t * p_stage = &(p_graph->stages[s]);
+          p_stage->p_graph = p_graph;
+          p_stage->index = s;
+          if (ap_pool)
+            {
+              fail_if (OMX_ErrorNone
+                       != tiz_mpscq_init (&(p_stage->p_inbox),
+                                          WPOOL_TEST_BENCH_QUEUE_CAPACITY));
+              fail_if (OMX_ErrorNone
+                       != tiz_wpool_task_init (ap_pool, &(p_stage->p_task),
+                                               wpool_test_stage_task,
+                                               p_stage));
+            }
+          else
+            {
+              fail_if (OMX_ErrorNone
+                       != tiz_queue_init (&(p_stage->p_queue),
+                                          WPOOL_TEST_BENCH_QUEUE_CAPACITY));
+              fail_if (OMX_ErrorNone
+                       != tiz_thread_create (&(p_stage->thread), 0, 0,
+                                             wpool_test_stage_thread,
+                                             p_stage));
+            }
+        }
+    }
+
+  nthreads = wpool_test_thread_count ();
+  (void) getrusage (RUSAGE_SELF, &ru_start);
+  start_ns = mpscq_test_now_ns ();
+
+  for (g = 0; g < a_ngraphs; ++g)
+    {
+      for (t = 0; t < WPOOL_TEST_BENCH_TOKENS; ++t)
+        {
+          wpool_test_forward (&(p_graphs[g]), 0, &(p_graphs[g].tokens[t]));
+        }
+    }
+
+  for (g = 0; g < a_ngraphs; ++g)
+    {
+      fail_if (OMX_ErrorNone != tiz_sem_wait (&done));
+    }
+
+  elapsed_ns = mpscq_test_now_ns () - start_ns;
+  (void) getrusage (RUSAGE_SELF, &ru_end);
+
+  cpu_s = (double) (ru_end.ru_utime.tv_sec - ru_start.ru_utime.tv_sec)
+          + (double) (ru_end.ru_utime.tv_usec - ru_start.ru_utime.tv_usec) / 1e6
+          + (double) (ru_end.ru_stime.tv_sec - ru_start.ru_stime.tv_sec)
+          + (double) (ru_end.ru_stime.tv_usec - ru_start.ru_stime.tv_usec) / 1e6;
+  ctxsw = (ru_end.ru_nvcsw - ru_start.ru_nvcsw)
+          + (ru_end.ru_nivcsw - ru_start.ru_nivcsw);
+
+  fprintf (stderr,
+           "[%-6s] graphs [%3d] threads [%4d] ctx switches [%8ld] "
+           "cpu [%7.3f s] wall [%7.3f s] buffers/sec [%10.0f]\n",
+           ap_pool ? "pool" : "thread", (int) a_ngraphs, (int) nthreads, ctxsw,
+           cpu_s, (double) elapsed_ns / 1e9,
+           (double) a_ngraphs * WPOOL_TEST_BENCH_BUFFERS * 1e9
+             / (double) elapsed_ns);
+
+  for (g = 0; g < a_ngraphs; ++g)
+    {
+      for (s = 0; s < WPOOL_TEST_BENCH_STAGES; ++s)
+        {
+          wpool_test_stage_t * p_stage = &(p_graphs[g].stages[s]);
+          if (ap_pool)
+            {
+              tiz_wpool_task_destroy (p_stage->p_task);
+              fail_if (0 != tiz_mpscq_length (p_stage->p_inbox));
+              tiz_mpscq_destroy (p_stage->p_inbox);
+            }
+          else
+            {
+              void * p_result = NULL;
+              fail_if (OMX_ErrorNone
+                       != tiz_queue_send (p_stage->p_queue,
+                                          &wpool_test_stop_token));
+              tiz_thread_join (&(p_stage->thread), &p_result);
+              tiz_queue_destroy (p_stage->p_queue);
+            }
+        }
+    }
+
+  (void) tiz_sem_destroy (&done);
+  tiz_mem_free (p_graphs);
+}
+
+START_TEST (test_wpool_init_and_destroy)
+{
+  tiz_wpool_t * p_pool = NULL;
+
+  fail_if (OMX_ErrorNone != tiz_wpool_init (&p_pool, 0, "wpooltest"));
+  fail_if (NULL == p_pool);
+  fail_if (tiz_wpool_size (p_pool) < 1);
+  tiz_wpool_destroy (p_pool);
+
+  fail_if (OMX_ErrorNone != tiz_wpool_init (&p_pool, 3, NULL));
+  fail_if (3 != tiz_wpool_size (p_pool));
+  tiz_wpool_destroy (p_pool);
+}
+END_TEST
+
+START_TEST (test_wpool_task_serialized)
+{
+  tiz_wpool_t * p_pool = NULL;
+  tiz_thread_t threads[WPOOL_TEST_NSIGNALLERS];
+  wpool_test_counter_t cnt;
+  OMX_S32 i = 0;
+
+  memset (&cnt, 0, sizeof (cnt));
+
+  fail_if (OMX_ErrorNone
+           != tiz_wpool_init (&p_pool, WPOOL_TEST_NSIGNALLERS, "wpooltest"));
+  fail_if (OMX_ErrorNone
+           != tiz_wpool_task_init (p_pool, &(cnt.p_task),
+                                   wpool_test_counter_run, &cnt));
+  fail_if (OMX_FALSE != tiz_wpool_task_is_current (cnt.p_task));
+  /* Not a worker thread */
+  fail_if (OMX_FALSE != tiz_wpool_task_try_run (cnt.p_task));
+
+  for (i = 0; i < WPOOL_TEST_NSIGNALLERS; ++i)
+    {
+      fail_if (OMX_ErrorNone
+               != tiz_thread_create (&(threads[i]), 0, 0,
+                                     wpool_test_signaller_thread, &cnt));
+    }
+
+  for (i = 0; i < WPOOL_TEST_NSIGNALLERS; ++i)
+    {
+      void * p_result = NULL;
+      tiz_thread_join (&(threads[i]), &p_result);
+    }
+
+  /* Every request is eventually seen by a run of the task */
+  while (WPOOL_TEST_NSIGNALLERS * WPOOL_TEST_SIGNALS_PER_THREAD
+         != __atomic_load_n (&(cnt.processed), __ATOMIC_SEQ_CST))
+    {
+      tiz_sleep (1000);
+    }
+
+  tiz_wpool_task_destroy (cnt.p_task);
+  tiz_wpool_destroy (p_pool);
+
+  fail_if (0 != cnt.overlaps);
+  fail_if (cnt.runs < 1);
+  /* Signals are coalesced */
+  fail_if (cnt.runs > WPOOL_TEST_NSIGNALLERS * WPOOL_TEST_SIGNALS_PER_THREAD);
+}
+END_TEST
+
+START_TEST (test_wpool_benchmark)
+{
+  const OMX_S32 ngraphs[] = {1, 8, 64};
+  OMX_S32 i = 0;
+
+  for (i = 0; i < sizeof (ngraphs) / sizeof (ngraphs[0]); ++i)
+    {
+      tiz_wpool_t * p_pool = NULL;
+
+      wpool_test_bench_run (ngraphs[i], NULL);
+
+      fail_if (OMX_ErrorNone != tiz_wpool_init (&p_pool, 0, "wpoolbench"));
+      wpool_test_bench_run (ngraphs[i], p_pool);
+      tiz_wpool_destroy (p_pool);
+    }
+}
+END_TEST
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
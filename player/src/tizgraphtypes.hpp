@@ -54,6 +54,7 @@ namespace tiz
 {
   class probe;
   class playlist;
+  class playlist_feed;
   namespace graph
   {
     class graph;
@@ -86,5 +87,6 @@ typedef boost::shared_ptr< tiz::graph::iheartconfig > tiziheartconfig_ptr_t;
 typedef boost::shared_ptr< tiz::graph::chromecastconfig > tizchromecastconfig_ptr_t;
 typedef tiz::playlist tizplaylist_t;
 typedef boost::shared_ptr< tiz::playlist > tizplaylist_ptr_t;
+typedef boost::shared_ptr< tiz::playlist_feed > tizplaylistfeed_ptr_t;
 
 #endif  // TIZGRAPHTYPES_HPP
@@ -29,6 +29,8 @@
 #include <config.h>
 #endif
 
+#include <stdlib.h>
+
 #include <boost/foreach.hpp>
 #include <string>
 
@@ -1204,6 +1206,22 @@ bool graph::util::is_mpris_enabled ()
   return is_enabled;
 }
 
+OMX_U32 graph::util::get_http_server_max_clients ()
+{
+  OMX_U32 max_clients = 1;
+  const char *p_max_clients
+      = tiz_rcfile_get_value ("tizonia", "http-server-max-clients");
+  if (p_max_clients)
+  {
+    const long value = strtol (p_max_clients, NULL, 10);
+    if (value > 0)
+    {
+      max_clients = value;
+    }
+  }
+  return max_clients;
+}
+
 void graph::util::copy_omx_string (
     OMX_U8 *p_dest, const std::string &omx_string,
     const size_t max_length /*  = OMX_MAX_STRINGNAME_SIZE */
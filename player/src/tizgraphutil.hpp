@@ -259,6 +259,8 @@ namespace tiz
 
       static bool is_mpris_enabled ();
 
+      static OMX_U32 get_http_server_max_clients ();
+
       static void copy_omx_string (OMX_U8 *p_dest,
                                    const std::string &omx_string,
                                    const size_t max_length
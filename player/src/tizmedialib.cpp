@@ -0,0 +1,908 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizmedialib.cpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Persistent index of the local media library
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <tizplatform.h>
+
+#include "tizprobe.hpp"
+#include "tizmedialib.hpp"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.play.medialib"
+#endif
+
+#define MEDIALIB_FILE_NAME "tizonia/media-library.idx"
+#define MEDIALIB_MAGIC "TIZMLIB"
+#define MEDIALIB_VERSION 1
+#define MEDIALIB_DEFAULT_INDEXER_THREADS 2
+
+namespace  // unnamed namespace
+{
+  /* The index file is laid out as a header, followed by the directory records
+     and the file records (both sorted by path), and a pool of NUL-terminated
+     strings that the records refer to by offset. Offset 0 is the empty
+     string. */
+  struct index_header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t ndirs;
+    uint32_t nfiles;
+    uint32_t reserved;
+    uint64_t strings_len;
+  };
+
+  struct dir_record
+  {
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint32_t path;
+    uint32_t names;
+    uint32_t names_len;
+    uint32_t reserved;
+  };
+
+  enum file_record_str
+  {
+    StrPerformer,
+    StrTrackName,
+    StrAlbumName,
+    StrGenreName,
+    StrCompleteName,
+    StrTitle,
+    StrArtist,
+    StrAlbum,
+    StrYear,
+    StrComment,
+    StrTrack,
+    StrGenre,
+    StrLength,
+    StrMax
+  };
+
+  struct file_record
+  {
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint64_t size;
+    int32_t codec_id;
+    int32_t container_type;
+    uint32_t samplerate;
+    uint32_t bitrate;
+    uint32_t nchannels;
+    uint32_t bitdepth;
+    int32_t endianness;
+    int32_t sign;
+    uint32_t cbr;
+    uint32_t path;
+    uint32_t strings[StrMax];
+    uint32_t reserved;
+  };
+
+  struct index_view
+  {
+    index_view (const void *p_map, const size_t len)
+      : p_hdr (static_cast< const index_header * > (p_map)),
+        p_dirs (NULL),
+        p_files (NULL),
+        p_strings (NULL)
+    {
+      if (p_hdr)
+      {
+        p_dirs = reinterpret_cast< const dir_record * > (p_hdr + 1);
+        p_files = reinterpret_cast< const file_record * > (p_dirs
+                                                            + p_hdr->ndirs);
+        p_strings = reinterpret_cast< const char * > (p_files + p_hdr->nfiles);
+      }
+      (void)len;
+    }
+
+    const char *str (const uint32_t offset) const
+    {
+      return offset < p_hdr->strings_len ? p_strings + offset : "";
+    }
+
+    const index_header *p_hdr;
+    const dir_record *p_dirs;
+    const file_record *p_files;
+    const char *p_strings;
+  };
+
+  template < typename T >
+  struct path_less
+  {
+    path_less (const index_view &view) : view_ (view)
+    {
+    }
+
+    bool operator() (const T &record, const std::string &path) const
+    {
+      return path.compare (view_.str (record.path)) > 0;
+    }
+
+    const index_view &view_;
+  };
+
+  /* Builds the string pool of a new index; strings that repeat a lot (album,
+     artist, ...) are only stored once */
+  class string_pool
+  {
+  public:
+    string_pool () : pool_ (1, '\0'), offsets_ ()
+    {
+    }
+
+    uint32_t add (const std::string &str, const bool dedup = true)
+    {
+      if (str.empty ())
+      {
+        return 0;
+      }
+      if (dedup)
+      {
+        boost::unordered_map< std::string, uint32_t >::const_iterator it
+            = offsets_.find (str);
+        if (it != offsets_.end ())
+        {
+          return it->second;
+        }
+      }
+      const uint32_t offset = pool_.size ();
+      pool_.append (str.c_str (), str.size () + 1);
+      if (dedup)
+      {
+        offsets_[str] = offset;
+      }
+      return offset;
+    }
+
+    uint32_t add_names (const std::string &names)
+    {
+      const uint32_t offset = pool_.size ();
+      pool_.append (names);
+      return offset;
+    }
+
+    const std::string &data () const
+    {
+      return pool_;
+    }
+
+  private:
+    std::string pool_;
+    boost::unordered_map< std::string, uint32_t > offsets_;
+  };
+
+  std::string rc_value (const char *key)
+  {
+    const char *p_value = tiz_rcfile_get_value ("tizonia", key);
+    return p_value ? std::string (p_value) : std::string ();
+  }
+
+  std::string default_index_file ()
+  {
+    const char *p_value = NULL;
+    if ((p_value = getenv ("XDG_CACHE_HOME")) && '\0' != p_value[0])
+    {
+      return std::string (p_value) + "/" MEDIALIB_FILE_NAME;
+    }
+    else if ((p_value = getenv ("HOME")) && '\0' != p_value[0])
+    {
+      return std::string (p_value) + "/.cache/" MEDIALIB_FILE_NAME;
+    }
+    return std::string ();
+  }
+
+  void make_parent_dirs (const std::string &file)
+  {
+    std::string::size_type sep = file.find ('/', 1);
+    while (std::string::npos != sep)
+    {
+      (void)mkdir (file.substr (0, sep).c_str (), 0755);
+      sep = file.find ('/', sep + 1);
+    }
+  }
+
+  bool is_directory (const std::string &path, const struct dirent *p_entry)
+  {
+    struct stat st;
+    if (DT_UNKNOWN != p_entry->d_type)
+    {
+      return DT_DIR == p_entry->d_type;
+    }
+    return (0 == lstat (path.c_str (), &st) && S_ISDIR (st.st_mode));
+  }
+
+  std::string join_path (const std::string &dir, const char *p_name)
+  {
+    std::string path (dir);
+    if (path.empty () || '/' != path[path.size () - 1])
+    {
+      path.append ("/");
+    }
+    return path.append (p_name);
+  }
+
+  bool read_directory (const std::string &dir, std::string &names)
+  {
+    DIR *p_dir = opendir (dir.c_str ());
+    struct dirent *p_entry = NULL;
+
+    if (!p_dir)
+    {
+      return false;
+    }
+
+    while ((p_entry = readdir (p_dir)))
+    {
+      if (0 == strcmp (p_entry->d_name, ".")
+          || 0 == strcmp (p_entry->d_name, ".."))
+      {
+        continue;
+      }
+      names.push_back (
+          is_directory (join_path (dir, p_entry->d_name), p_entry) ? 'd'
+                                                                   : 'f');
+      names.append (p_entry->d_name);
+      names.push_back ('\0');
+    }
+
+    closedir (p_dir);
+    return true;
+  }
+
+  void set_record_info (const tiz::media_info &info, string_pool &pool,
+                        file_record &record)
+  {
+    record.codec_id = info.codec_id;
+    record.container_type = info.container_type;
+    record.samplerate = info.samplerate;
+    record.bitrate = info.bitrate;
+    record.nchannels = info.nchannels;
+    record.bitdepth = info.bitdepth;
+    record.endianness = info.endianness;
+    record.sign = info.sign;
+    record.cbr = info.cbr;
+    record.strings[StrPerformer] = pool.add (info.performer);
+    record.strings[StrTrackName] = pool.add (info.track_name, false);
+    record.strings[StrAlbumName] = pool.add (info.album_name);
+    record.strings[StrGenreName] = pool.add (info.genre_name);
+    record.strings[StrCompleteName] = pool.add (info.complete_name, false);
+    record.strings[StrTitle] = pool.add (info.title, false);
+    record.strings[StrArtist] = pool.add (info.artist);
+    record.strings[StrAlbum] = pool.add (info.album);
+    record.strings[StrYear] = pool.add (info.year);
+    record.strings[StrComment] = pool.add (info.comment);
+    record.strings[StrTrack] = pool.add (info.track);
+    record.strings[StrGenre] = pool.add (info.genre);
+    record.strings[StrLength] = pool.add (info.length);
+  }
+
+  void get_record_info (const index_view &view, const file_record &record,
+                        tiz::media_info &info)
+  {
+    info.codec_id = static_cast< OMX_AUDIO_CODINGTYPE > (record.codec_id);
+    info.container_type
+        = static_cast< OMX_MEDIACONTAINER_FORMATTYPE > (record.container_type);
+    info.samplerate = record.samplerate;
+    info.bitrate = record.bitrate;
+    info.nchannels = record.nchannels;
+    info.bitdepth = record.bitdepth;
+    info.endianness = static_cast< OMX_ENDIANTYPE > (record.endianness);
+    info.sign = static_cast< OMX_NUMERICALDATATYPE > (record.sign);
+    info.cbr = record.cbr;
+    info.performer = view.str (record.strings[StrPerformer]);
+    info.track_name = view.str (record.strings[StrTrackName]);
+    info.album_name = view.str (record.strings[StrAlbumName]);
+    info.genre_name = view.str (record.strings[StrGenreName]);
+    info.complete_name = view.str (record.strings[StrCompleteName]);
+    info.title = view.str (record.strings[StrTitle]);
+    info.artist = view.str (record.strings[StrArtist]);
+    info.album = view.str (record.strings[StrAlbum]);
+    info.year = view.str (record.strings[StrYear]);
+    info.comment = view.str (record.strings[StrComment]);
+    info.track = view.str (record.strings[StrTrack]);
+    info.genre = view.str (record.strings[StrGenre]);
+    info.length = view.str (record.strings[StrLength]);
+  }
+
+  /* Whether the next record to write is the saved one (< 0), the changed
+     one (> 0), or the changed one replacing the saved one (0) */
+  int merge_order (const char *p_saved_path, const std::string *p_changed_path)
+  {
+    if (!p_changed_path)
+    {
+      return -1;
+    }
+    if (!p_saved_path)
+    {
+      return 1;
+    }
+    return -p_changed_path->compare (p_saved_path);
+  }
+
+  bool write_all (const int fd, const void *p_data, size_t len)
+  {
+    const char *p = static_cast< const char * > (p_data);
+    while (len > 0)
+    {
+      const ssize_t written = write (fd, p, len);
+      if (written < 0 && EINTR == errno)
+      {
+        continue;
+      }
+      if (written <= 0)
+      {
+        return false;
+      }
+      p += written;
+      len -= written;
+    }
+    return true;
+  }
+}  // unnamed namespace
+
+//
+// media_info
+//
+tiz::media_info::media_info ()
+  : codec_id (OMX_AUDIO_CodingUnused),
+    container_type (OMX_FORMATMax),
+    samplerate (48000),
+    bitrate (0),
+    nchannels (2),
+    bitdepth (16),
+    endianness (OMX_EndianLittle),
+    sign (OMX_NumericalDataSigned),
+    cbr (false)
+{
+}
+
+//
+// medialib
+//
+tiz::medialib &tiz::medialib::instance ()
+{
+  // Never destroyed, as indexer threads may still be running when the process
+  // exits
+  static medialib *p_medialib = new medialib ();
+  return *p_medialib;
+}
+
+tiz::medialib::medialib ()
+  : mutex_ (),
+    initialised_ (false),
+    enabled_ (false),
+    file_ (),
+    indexer_threads_ (MEDIALIB_DEFAULT_INDEXER_THREADS),
+    p_map_ (NULL),
+    map_len_ (0),
+    dirs_ (),
+    files_ (),
+    dirty_ (false),
+    indexers_ (),
+    pending_ (),
+    next_pending_ (0),
+    active_indexers_ (0),
+    stopping_ (false)
+{
+}
+
+tiz::medialib::~medialib ()
+{
+  unmap_index ();
+}
+
+// Must be called with the mutex held
+void tiz::medialib::init ()
+{
+  if (initialised_)
+  {
+    return;
+  }
+  initialised_ = true;
+
+  const std::string enabled (rc_value ("media-library"));
+  const std::string file (rc_value ("media-library.file"));
+  const std::string threads (rc_value ("media-library.indexer-threads"));
+
+  enabled_ = enabled.empty () || 0 == enabled.compare ("true");
+  file_ = file.empty () ? default_index_file () : file;
+  if (!threads.empty ())
+  {
+    const long value = strtol (threads.c_str (), NULL, 10);
+    indexer_threads_ = value > 0 ? value : 0;
+  }
+
+  if (file_.empty ())
+  {
+    enabled_ = false;
+  }
+
+  if (enabled_ && !map_index ())
+  {
+    TIZ_LOG (TIZ_PRIORITY_NOTICE, "Starting a new media library index [%s]",
+             file_.c_str ());
+  }
+}
+
+bool tiz::medialib::map_index ()
+{
+  struct stat st;
+  const int fd = open (file_.c_str (), O_RDONLY | O_CLOEXEC);
+  bool valid = false;
+
+  assert (!p_map_);
+
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  if (0 == fstat (fd, &st)
+      && static_cast< size_t > (st.st_size) > sizeof (index_header))
+  {
+    void *p_map = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (MAP_FAILED != p_map)
+    {
+      const index_header *p_hdr = static_cast< index_header * > (p_map);
+      const uint64_t expected_len
+          = sizeof (index_header)
+            + static_cast< uint64_t > (p_hdr->ndirs) * sizeof (dir_record)
+            + static_cast< uint64_t > (p_hdr->nfiles) * sizeof (file_record)
+            + p_hdr->strings_len;
+      valid = (0 == memcmp (p_hdr->magic, MEDIALIB_MAGIC, sizeof (MEDIALIB_MAGIC))
+               && MEDIALIB_VERSION == p_hdr->version
+               && expected_len == static_cast< uint64_t > (st.st_size)
+               && p_hdr->strings_len > 0
+               && '\0'
+                      == static_cast< const char * > (
+                             p_map)[st.st_size - 1]);
+      if (valid)
+      {
+        p_map_ = p_map;
+        map_len_ = st.st_size;
+      }
+      else
+      {
+        TIZ_LOG (TIZ_PRIORITY_NOTICE,
+                 "Discarding invalid media library index [%s]",
+                 file_.c_str ());
+        munmap (p_map, st.st_size);
+      }
+    }
+  }
+
+  close (fd);
+  return valid;
+}
+
+void tiz::medialib::unmap_index ()
+{
+  if (p_map_)
+  {
+    munmap (p_map_, map_len_);
+    p_map_ = NULL;
+    map_len_ = 0;
+  }
+}
+
+// Must be called with the mutex held
+bool tiz::medialib::find_dir (const std::string &dir, dir_entry &entry) const
+{
+  dir_map_t::const_iterator it = dirs_.find (dir);
+  if (it != dirs_.end ())
+  {
+    entry = it->second;
+    return true;
+  }
+
+  if (p_map_)
+  {
+    const index_view view (p_map_, map_len_);
+    const dir_record *p_end = view.p_dirs + view.p_hdr->ndirs;
+    const dir_record *p_rec = std::lower_bound (
+        view.p_dirs, p_end, dir, path_less< dir_record > (view));
+    if (p_rec != p_end && 0 == dir.compare (view.str (p_rec->path))
+        && static_cast< uint64_t > (p_rec->names) + p_rec->names_len
+               <= view.p_hdr->strings_len)
+    {
+      entry.mtime_sec = p_rec->mtime_sec;
+      entry.mtime_nsec = p_rec->mtime_nsec;
+      entry.names.assign (view.p_strings + p_rec->names, p_rec->names_len);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Must be called with the mutex held
+bool tiz::medialib::find_file (const std::string &uri,
+                               file_entry &entry) const
+{
+  file_map_t::const_iterator it = files_.find (uri);
+  if (it != files_.end ())
+  {
+    entry = it->second;
+    return true;
+  }
+
+  if (p_map_)
+  {
+    const index_view view (p_map_, map_len_);
+    const file_record *p_end = view.p_files + view.p_hdr->nfiles;
+    const file_record *p_rec = std::lower_bound (
+        view.p_files, p_end, uri, path_less< file_record > (view));
+    if (p_rec != p_end && 0 == uri.compare (view.str (p_rec->path)))
+    {
+      entry.mtime_sec = p_rec->mtime_sec;
+      entry.mtime_nsec = p_rec->mtime_nsec;
+      entry.size = p_rec->size;
+      get_record_info (view, *p_rec, entry.info);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool tiz::medialib::enabled ()
+{
+  boost::lock_guard< boost::mutex > lock (mutex_);
+  init ();
+  return enabled_;
+}
+
+bool tiz::medialib::list_directory (const std::string &dir,
+                                    std::string &names)
+{
+  struct stat st;
+  dir_entry entry;
+  bool found = false;
+
+  if (!enabled ())
+  {
+    names.clear ();
+    return read_directory (dir, names);
+  }
+
+  if (0 != stat (dir.c_str (), &st))
+  {
+    return false;
+  }
+
+  {
+    boost::lock_guard< boost::mutex > lock (mutex_);
+    found = find_dir (dir, entry);
+  }
+
+  if (!found || entry.mtime_sec != st.st_mtim.tv_sec
+      || entry.mtime_nsec != st.st_mtim.tv_nsec)
+  {
+    entry.mtime_sec = st.st_mtim.tv_sec;
+    entry.mtime_nsec = st.st_mtim.tv_nsec;
+    entry.names.clear ();
+    if (!read_directory (dir, entry.names))
+    {
+      return false;
+    }
+    boost::lock_guard< boost::mutex > lock (mutex_);
+    dirs_[dir] = entry;
+    dirty_ = true;
+  }
+
+  names.swap (entry.names);
+  return true;
+}
+
+bool tiz::medialib::lookup (const std::string &uri, media_info &info)
+{
+  struct stat st;
+  file_entry entry;
+
+  if (!enabled () || 0 != stat (uri.c_str (), &st) || !S_ISREG (st.st_mode))
+  {
+    return false;
+  }
+
+  {
+    boost::lock_guard< boost::mutex > lock (mutex_);
+    if (!find_file (uri, entry))
+    {
+      return false;
+    }
+  }
+
+  if (entry.mtime_sec != st.st_mtim.tv_sec
+      || entry.mtime_nsec != st.st_mtim.tv_nsec
+      || entry.size != static_cast< uint64_t > (st.st_size))
+  {
+    TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] changed since it was indexed",
+             uri.c_str ());
+    return false;
+  }
+
+  info = entry.info;
+  return true;
+}
+
+void tiz::medialib::store (const std::string &uri, const media_info &info)
+{
+  struct stat st;
+  file_entry entry;
+
+  if (!enabled () || 0 != stat (uri.c_str (), &st) || !S_ISREG (st.st_mode))
+  {
+    return;
+  }
+
+  entry.mtime_sec = st.st_mtim.tv_sec;
+  entry.mtime_nsec = st.st_mtim.tv_nsec;
+  entry.size = st.st_size;
+  entry.info = info;
+
+  boost::lock_guard< boost::mutex > lock (mutex_);
+  files_[uri] = entry;
+  dirty_ = true;
+}
+
+// Must be called with the mutex held
+bool tiz::medialib::write_index ()
+{
+  const index_view view (p_map_, map_len_);
+  const uint32_t saved_dirs = p_map_ ? view.p_hdr->ndirs : 0;
+  const uint32_t saved_files = p_map_ ? view.p_hdr->nfiles : 0;
+  std::vector< dir_record > dirs;
+  std::vector< file_record > files;
+  string_pool pool;
+  index_header hdr;
+  uint32_t i = 0;
+
+  // Merge the saved records and the changes, both sorted by path
+  dir_map_t::const_iterator dit = dirs_.begin ();
+  for (i = 0; i < saved_dirs || dit != dirs_.end ();)
+  {
+    dir_record rec;
+    memset (&rec, 0, sizeof (rec));
+    const int cmp = merge_order (
+        i < saved_dirs ? view.str (view.p_dirs[i].path) : NULL,
+        dit != dirs_.end () ? &dit->first : NULL);
+    if (cmp < 0)
+    {
+      const dir_record &saved = view.p_dirs[i++];
+      if (static_cast< uint64_t > (saved.names) + saved.names_len
+          > view.p_hdr->strings_len)
+      {
+        continue;
+      }
+      rec = saved;
+      rec.path = pool.add (view.str (saved.path), false);
+      rec.names = pool.add_names (
+          std::string (view.p_strings + saved.names, saved.names_len));
+    }
+    else
+    {
+      if (0 == cmp)
+      {
+        ++i;
+      }
+      rec.mtime_sec = dit->second.mtime_sec;
+      rec.mtime_nsec = dit->second.mtime_nsec;
+      rec.path = pool.add (dit->first, false);
+      rec.names = pool.add_names (dit->second.names);
+      rec.names_len = dit->second.names.size ();
+      ++dit;
+    }
+    dirs.push_back (rec);
+  }
+
+  file_map_t::const_iterator fit = files_.begin ();
+  for (i = 0; i < saved_files || fit != files_.end ();)
+  {
+    file_record rec;
+    memset (&rec, 0, sizeof (rec));
+    const int cmp = merge_order (
+        i < saved_files ? view.str (view.p_files[i].path) : NULL,
+        fit != files_.end () ? &fit->first : NULL);
+    media_info info;
+    if (cmp < 0)
+    {
+      const file_record &saved = view.p_files[i++];
+      rec = saved;
+      get_record_info (view, saved, info);
+      rec.path = pool.add (view.str (saved.path), false);
+    }
+    else
+    {
+      if (0 == cmp)
+      {
+        ++i;
+      }
+      rec.mtime_sec = fit->second.mtime_sec;
+      rec.mtime_nsec = fit->second.mtime_nsec;
+      rec.size = fit->second.size;
+      rec.path = pool.add (fit->first, false);
+      info = fit->second.info;
+      ++fit;
+    }
+    set_record_info (info, pool, rec);
+    files.push_back (rec);
+  }
+
+  if (pool.data ().size () > UINT32_MAX)
+  {
+    TIZ_LOG (TIZ_PRIORITY_ERROR, "Media library index is too large");
+    return false;
+  }
+
+  memset (&hdr, 0, sizeof (hdr));
+  memcpy (hdr.magic, MEDIALIB_MAGIC, sizeof (MEDIALIB_MAGIC));
+  hdr.version = MEDIALIB_VERSION;
+  hdr.ndirs = dirs.size ();
+  hdr.nfiles = files.size ();
+  hdr.strings_len = pool.data ().size ();
+
+  make_parent_dirs (file_);
+  std::string tmp_file (file_ + ".XXXXXX");
+  const int fd = mkstemp (&tmp_file[0]);
+  if (fd < 0)
+  {
+    TIZ_LOG (TIZ_PRIORITY_ERROR, "Unable to create [%s] (%s)",
+             tmp_file.c_str (), strerror (errno));
+    return false;
+  }
+
+  bool ok = write_all (fd, &hdr, sizeof (hdr))
+            && (dirs.empty ()
+                || write_all (fd, &dirs[0], dirs.size () * sizeof (dir_record)))
+            && (files.empty ()
+                || write_all (fd, &files[0],
+                              files.size () * sizeof (file_record)))
+            && write_all (fd, pool.data ().data (), pool.data ().size ());
+  ok = (0 == close (fd)) && ok;
+
+  if (!ok || 0 != rename (tmp_file.c_str (), file_.c_str ()))
+  {
+    TIZ_LOG (TIZ_PRIORITY_ERROR, "Unable to write [%s] (%s)", file_.c_str (),
+             strerror (errno));
+    unlink (tmp_file.c_str ());
+    return false;
+  }
+
+  TIZ_LOG (TIZ_PRIORITY_NOTICE,
+           "Saved media library index [%s]: [%u] directories, [%u] files",
+           file_.c_str (), hdr.ndirs, hdr.nfiles);
+  return true;
+}
+
+bool tiz::medialib::save ()
+{
+  boost::lock_guard< boost::mutex > lock (mutex_);
+  init ();
+  return write_and_remap ();
+}
+
+// Must be called with the mutex held
+bool tiz::medialib::write_and_remap ()
+{
+  if (!enabled_ || !dirty_)
+  {
+    return true;
+  }
+
+  if (!write_index ())
+  {
+    return false;
+  }
+
+  // The new file has everything; drop the changes and map it
+  unmap_index ();
+  dirs_.clear ();
+  files_.clear ();
+  dirty_ = false;
+  (void)map_index ();
+  return true;
+}
+
+void tiz::medialib::indexer ()
+{
+  for (;;)
+  {
+    std::string uri;
+    media_info info;
+    {
+      boost::lock_guard< boost::mutex > lock (mutex_);
+      if (stopping_ || next_pending_ >= pending_.size ())
+      {
+        // The last indexer to finish saves the index
+        if (0 == --active_indexers_ && !stopping_)
+        {
+          (void)write_and_remap ();
+        }
+        break;
+      }
+      uri = pending_[next_pending_++];
+    }
+
+    if (!lookup (uri, info))
+    {
+      // The probe stores its results in the index
+      tiz::probe probe (uri, /* quiet = */ true);
+      (void)probe.get_omx_domain ();
+    }
+  }
+}
+
+void tiz::medialib::start_indexing (const uri_lst_t &uri_list)
+{
+  boost::lock_guard< boost::mutex > lock (mutex_);
+  init ();
+  if (!enabled_ || 0 == indexer_threads_ || !pending_.empty ())
+  {
+    return;
+  }
+
+  // Files are probed in playlist order, so that the tracks that are played
+  // next are the first to be indexed
+  pending_ = uri_list;
+  next_pending_ = 0;
+  stopping_ = false;
+  active_indexers_ = indexer_threads_;
+  for (unsigned int i = 0; i < indexer_threads_; ++i)
+  {
+    indexers_.create_thread (boost::bind (&tiz::medialib::indexer, this));
+  }
+}
+
+void tiz::medialib::stop ()
+{
+  {
+    boost::lock_guard< boost::mutex > lock (mutex_);
+    stopping_ = true;
+  }
+  indexers_.join_all ();
+  (void)save ();
+}
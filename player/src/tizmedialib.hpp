@@ -0,0 +1,169 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizmedialib.hpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Persistent index of the local media library
+ *
+ * The index keeps, for each directory visited during playlist assembly, its
+ * modification time and the names of its entries, and for each probed file,
+ * its size, modification time, codec information and tags. It is stored in a
+ * single file that is mapped read-only; changes are kept in memory until the
+ * index is saved, which replaces the file atomically.
+ *
+ */
+
+#ifndef TIZMEDIALIB_HPP
+#define TIZMEDIALIB_HPP
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
+#include <boost/thread.hpp>
+
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+#include <OMX_Audio.h>
+#include <OMX_TizoniaExt.h>
+
+#include "tizgraphtypes.hpp"
+
+namespace tiz
+{
+  /* The probe results of a media file */
+  struct media_info
+  {
+    media_info ();
+
+    OMX_AUDIO_CODINGTYPE codec_id;
+    OMX_MEDIACONTAINER_FORMATTYPE container_type;
+    OMX_U32 samplerate;
+    OMX_U32 bitrate;
+    OMX_U32 nchannels;
+    OMX_U32 bitdepth;
+    OMX_ENDIANTYPE endianness;
+    OMX_NUMERICALDATATYPE sign;
+    bool cbr;
+
+    /* MediaInfo's general stream fields, used to build the stream title */
+    std::string performer;
+    std::string track_name;
+    std::string album_name;
+    std::string genre_name;
+    std::string complete_name;
+
+    /* TagLib's tags and duration */
+    std::string title;
+    std::string artist;
+    std::string album;
+    std::string year;
+    std::string comment;
+    std::string track;
+    std::string genre;
+    std::string length;
+  };
+
+  class medialib
+  {
+
+  public:
+    static medialib &instance ();
+
+    bool enabled ();
+
+    /* Retrieve the entries of a directory, as a list of NUL-terminated names,
+       each prefixed with 'd' (directory) or 'f' (anything else). Directories
+       whose modification time hasn't changed since the last visit are not
+       read again. Can be called from several threads at a time. */
+    bool list_directory (const std::string &dir, std::string &names);
+
+    /* Retrieve the probe results of a file; fails if the file is not in the
+       index or has changed since it was probed */
+    bool lookup (const std::string &uri, media_info &info);
+    void store (const std::string &uri, const media_info &info);
+
+    /* Probe in the background the files in the list that aren't indexed
+       yet; the index is saved when they are all done */
+    void start_indexing (const uri_lst_t &uri_list);
+
+    /* Stop the background indexing, and save the index */
+    void stop ();
+
+    bool save ();
+
+  private:
+    struct dir_entry
+    {
+      int64_t mtime_sec;
+      int64_t mtime_nsec;
+      // NUL-separated list of names, each prefixed with 'd' (directory) or 'f'
+      std::string names;
+    };
+
+    struct file_entry
+    {
+      int64_t mtime_sec;
+      int64_t mtime_nsec;
+      uint64_t size;
+      media_info info;
+    };
+
+    typedef std::map< std::string, dir_entry > dir_map_t;
+    typedef std::map< std::string, file_entry > file_map_t;
+
+  private:
+    medialib ();
+    ~medialib ();
+
+    void init ();
+    bool map_index ();
+    void unmap_index ();
+    bool find_dir (const std::string &dir, dir_entry &entry) const;
+    bool find_file (const std::string &uri, file_entry &entry) const;
+    bool write_index ();
+    bool write_and_remap ();
+    void indexer ();
+
+  private:
+    boost::mutex mutex_;
+    bool initialised_;
+    bool enabled_;
+    std::string file_;
+    unsigned int indexer_threads_;
+    // The saved index
+    void *p_map_;
+    size_t map_len_;
+    // The changes since the index was saved
+    dir_map_t dirs_;
+    file_map_t files_;
+    bool dirty_;
+    // Background indexing
+    boost::thread_group indexers_;
+    uri_lst_t pending_;
+    size_t next_pending_;
+    unsigned int active_indexers_;
+    bool stopping_;
+  };
+}  // namespace tiz
+
+#endif  // TIZMEDIALIB_HPP
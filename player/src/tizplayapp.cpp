@@ -67,7 +67,9 @@
 #include "tizdaemon.hpp"
 #include "tizgraphmgr.hpp"
 #include "tizgraphtypes.hpp"
+#include "tizmedialib.hpp"
 #include "tizomxutil.hpp"
+#include "tizplaylistfeed.hpp"
 #include <decoders/tizdecgraphmgr.hpp>
 #include <httpclnt/tizhttpclntmgr.hpp>
 #include <httpserv/tizhttpservconfig.hpp>
@@ -641,6 +643,8 @@ void tiz::playapp::set_option_handlers ()
       "log-directory", boost::bind (&tiz::playapp::unique_log_file, this));
   popts_.set_option_handler (
       "debug-info", boost::bind (&tiz::playapp::print_debug_info, this));
+  popts_.set_option_handler (
+      "dump-log", boost::bind (&tiz::playapp::dump_log, this));
   // OMX-related program options
   popts_.set_option_handler ("comp-list",
                              boost::bind (&tiz::playapp::list_of_comps, this));
@@ -745,6 +749,19 @@ tiz::playapp::unique_log_file () const
   return OMX_ErrorNone;
 }
 
+OMX_ERRORTYPE
+tiz::playapp::dump_log () const
+{
+  const std::string &log_file = popts_.dump_log_file ();
+  OMX_ERRORTYPE rc = tiz_log_ring_dump (log_file.c_str (), stdout);
+  if (OMX_ErrorNone != rc)
+  {
+    TIZ_PRINTF_C01 ("Could not read the log file '%s' [%s].",
+                    log_file.c_str (), tiz_err_to_str (rc));
+  }
+  return rc;
+}
+
 OMX_ERRORTYPE
 tiz::playapp::print_debug_info () const
 {
@@ -928,8 +945,8 @@ tiz::playapp::decode_local ()
   const bool shuffle = popts_.shuffle ();
   const bool recurse = popts_.recurse ();
 
-  uri_lst_t file_list;
   std::string error_msg;
+  std::string error_uri;
 
   print_banner ();
 
@@ -948,21 +965,42 @@ tiz::playapp::decode_local ()
   extension_list.insert (".aiff");
   extension_list.insert (".aif");
 
-  // Create a playlist
-  BOOST_FOREACH (std::string uri, uri_list)
+  // Scan the local media in the background; playback starts with the first
+  // track found
+  tizplaylistfeed_ptr_t feed = boost::make_shared< tiz::playlist_feed > (
+      uri_list, shuffle, recurse, extension_list);
+  tiz::playlist_feed::completion_cback_t scan_done;
+  if (!popts_.daemon ())
   {
-    if (!tizplaylist_t::assemble_play_list (
-            uri, shuffle, recurse, extension_list, file_list, error_msg))
-    {
-      TIZ_PRINTF_C01 ("%s (%s).", error_msg.c_str (), uri.c_str ());
-      player_exit_failure ();
-    }
+    // Probe the playlist in the background once the scan is complete
+    scan_done = boost::bind (&tiz::medialib::start_indexing,
+                             &tiz::medialib::instance (), _1);
+  }
+
+  if (!feed->start (error_msg, error_uri, scan_done))
+  {
+    TIZ_PRINTF_C01 ("%s (%s).", error_msg.c_str (), error_uri.c_str ());
+    player_exit_failure ();
+  }
+
+  if (popts_.daemon ())
+  {
+    // The scanning threads would not survive the fork
+    feed->wait ();
+    feed->stop ();
   }
 
   (void)daemonize_if_requested ();
 
+  if (popts_.daemon ())
+  {
+    uri_lst_t file_list;
+    (void)feed->fetch (0, file_list);
+    tiz::medialib::instance ().start_indexing (file_list);
+  }
+
   tizplaylist_ptr_t playlist
-      = boost::make_shared< tiz::playlist > (tiz::playlist (file_list));
+      = boost::make_shared< tiz::playlist > (tiz::playlist (feed, shuffle));
 
   assert (playlist);
 
@@ -981,6 +1019,9 @@ tiz::playapp::decode_local ()
   p_mgr->quit ();
   p_mgr->deinit ();
 
+  feed->stop ();
+  tiz::medialib::instance ().stop ();
+
   return rc;
 }
 
@@ -1074,6 +1115,8 @@ tiz::playapp::serve_stream ()
   p_mgr->quit ();
   p_mgr->deinit ();
 
+  tiz::medialib::instance ().stop ();
+
   return rc;
 }
 
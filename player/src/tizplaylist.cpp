@@ -41,7 +41,9 @@
 
 #include <tizplatform.h>
 
+#include "tizmedialib.hpp"
 #include "tizplaylist.hpp"
+#include "tizplaylistfeed.hpp"
 
 #ifdef TIZ_LOG_CATEGORY_NAME
 #undef TIZ_LOG_CATEGORY_NAME
@@ -50,94 +52,18 @@
 
 namespace  // unnamed namespace
 {
-  struct pathname_of
-  {
-    pathname_of (uri_lst_t &uri_list) : uri_list_ (uri_list)
-    {
-    }
-
-    void operator() (const boost::filesystem::directory_entry &p) const
-    {
-      uri_list_.push_back (p.path ().string ());
-    }
-    uri_lst_t &uri_list_;
-  };
-
   void add_to_extension_list (file_extension_lst_t &list,
                               const std::string &extension)
   {
     list.insert (list.end (), extension);
   }
 
-  OMX_ERRORTYPE
-  process_base_uri (const std::string &uri, uri_lst_t &uri_list,
-                    bool recurse = false)
-  {
-    if (boost::filesystem::exists (uri)
-        && boost::filesystem::is_regular_file (uri))
-    {
-      uri_list.push_back (uri);
-      return OMX_ErrorNone;
-    }
-
-    if (boost::filesystem::exists (uri)
-        && boost::filesystem::is_directory (uri))
-    {
-      if (!recurse)
-      {
-        std::for_each (boost::filesystem::directory_iterator (
-                           boost::filesystem::path (uri)),
-                       boost::filesystem::directory_iterator (),
-                       pathname_of (uri_list));
-        return uri_list.empty () ? OMX_ErrorContentURIError : OMX_ErrorNone;
-      }
-      else
-      {
-        std::for_each (boost::filesystem::recursive_directory_iterator (
-                           boost::filesystem::path (uri)),
-                       boost::filesystem::recursive_directory_iterator (),
-                       pathname_of (uri_list));
-        return uri_list.empty () ? OMX_ErrorContentURIError : OMX_ErrorNone;
-      }
-    }
-
-    return OMX_ErrorContentURIError;
-  }
-
-  OMX_ERRORTYPE
-  filter_unknown_media (const file_extension_lst_t &extension_list,
-                        uri_lst_t &uri_list,
-                        file_extension_lst_t &extension_list_filtered)
+  std::string lower_extension (const std::string &uri)
   {
-    uri_lst_t::iterator it (uri_list.begin ());
-    std::vector< uri_lst_t::iterator > iter_list;
-    file_extension_lst_t ext_lst_cpy (extension_list);
-    uri_lst_t filtered_uri_list;
-
-    while (it != uri_list.end ())
-    {
-      std::string extension (
-          boost::filesystem::path (*it).extension ().string ());
-      boost::algorithm::to_lower (extension);
-      file_extension_lst_t::const_iterator low = std::lower_bound (
-          ext_lst_cpy.begin (), ext_lst_cpy.end (), extension);
-
-      TIZ_LOG (TIZ_PRIORITY_TRACE, "ext [%s] it [%s]", extension.c_str (),
-               (*it).c_str ());
-
-      if (!(low == ext_lst_cpy.end ()) && boost::iequals ((*low), extension))
-      {
-        TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] added to playlist low [%s]",
-                 (*it).c_str (), (*low).c_str ());
-        filtered_uri_list.push_back (*it);
-        extension_list_filtered.insert (extension);
-      }
-      ++it;
-    }
-
-    uri_list = filtered_uri_list;
-    TIZ_LOG (TIZ_PRIORITY_TRACE, "%d elements in playlist", uri_list.size ());
-    return uri_list.empty () ? OMX_ErrorContentURIError : OMX_ErrorNone;
+    std::string extension (
+        boost::filesystem::path (uri).extension ().string ());
+    boost::algorithm::to_lower (extension);
+    return extension;
   }
 
 }  // unnamed namespace
@@ -154,7 +80,10 @@ tiz::playlist::playlist (const uri_lst_t &uri_list /* = uri_lst_t () */,
     current_sub_list_ (-1),
     shuffle_ (shuffle),
     extension_list_ (),
-    single_format_ (Unknown)
+    single_format_ (Unknown),
+    feed_ (),
+    feed_pos_ (0),
+    feed_extension_ ()
 {
   const int list_size = uri_list_.size ();
   if (list_size)
@@ -166,6 +95,24 @@ tiz::playlist::playlist (const uri_lst_t &uri_list /* = uri_lst_t () */,
   scan_list ();
 }
 
+tiz::playlist::playlist (const tizplaylistfeed_ptr_t &feed,
+                         const bool shuffle /* = false */)
+  : uri_list_ (),
+    current_position_ (0),
+    loop_playback_ (false),
+    sub_list_positions_ (),
+    current_sub_list_ (-1),
+    shuffle_ (shuffle),
+    extension_list_ (),
+    single_format_ (Unknown),
+    feed_ (feed),
+    feed_pos_ (0),
+    feed_extension_ ()
+{
+  assert (feed_);
+  absorb ();
+}
+
 tiz::playlist::playlist (const playlist &copy_from)
   : uri_list_ (copy_from.uri_list_),
     current_position_ (copy_from.current_position_),
@@ -174,7 +121,10 @@ tiz::playlist::playlist (const playlist &copy_from)
     current_sub_list_ (copy_from.current_sub_list_),
     shuffle_ (copy_from.shuffle_),
     extension_list_ (copy_from.extension_list_),
-    single_format_ (copy_from.single_format_)
+    single_format_ (copy_from.single_format_),
+    feed_ (copy_from.feed_),
+    feed_pos_ (copy_from.feed_pos_),
+    feed_extension_ (copy_from.feed_extension_)
 {
   const int list_size = uri_list_.size ();
   TIZ_LOG (TIZ_PRIORITY_TRACE, "uri list size [%d]", list_size);
@@ -192,50 +142,29 @@ bool tiz::playlist::assemble_play_list (
     uri_lst_t &uri_list, std::string &error_msg)
 {
   bool list_assembled = false;
-  file_extension_lst_t extension_list_filtered;
 
   try
   {
-    if (base_uri.empty ())
-    {
-      error_msg.assign ("Empty media uri.");
-      goto end;
-    }
-
-    boost::system::error_code errcode;
-    std::string canonical_base_uri
-        = boost::filesystem::canonical (base_uri, errcode).string ();
-    if (errcode.value () != 0)
-    {
-      error_msg.assign (errcode.message ());
-      goto end;
-    }
+    tiz::playlist_feed feed (uri_lst_t (1, base_uri), shuffle_playlist,
+                             recurse, extension_list);
+    std::string error_uri;
 
-    if (OMX_ErrorNone
-        != process_base_uri (canonical_base_uri, uri_list, recurse))
+    if (feed.start (error_msg, error_uri))
     {
-      error_msg.assign ("File not found.");
-      goto end;
-    }
+      feed.wait ();
+      (void)feed.fetch (0, uri_list);
 
-    if (OMX_ErrorNone
-        != filter_unknown_media (extension_list, uri_list,
-                                 extension_list_filtered))
-    {
-      error_msg.assign ("No supported media types found.");
-      goto end;
-    }
+      if (shuffle_playlist)
+      {
+        std::random_shuffle (uri_list.begin (), uri_list.end ());
+      }
+      else
+      {
+        std::sort (uri_list.begin (), uri_list.end ());
+      }
 
-    if (shuffle_playlist)
-    {
-      std::random_shuffle (uri_list.begin (), uri_list.end ());
-    }
-    else
-    {
-      std::sort (uri_list.begin (), uri_list.end ());
+      list_assembled = true;
     }
-
-    list_assembled = true;
   }
   catch (std::exception const &e)
   {
@@ -246,8 +175,6 @@ bool tiz::playlist::assemble_play_list (
     error_msg.assign ("Undefined file system error.");
   }
 
-end:
-
   if (!list_assembled)
   {
     TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s]", error_msg.c_str ());
@@ -258,6 +185,12 @@ end:
 
 void tiz::playlist::skip (const int jump)
 {
+  if (feed_)
+  {
+    // Wait for the scan to catch up if the jump goes past the known tracks
+    absorb (current_position_ + jump >= size ());
+  }
+
   const int list_size = uri_list_.size ();
   TIZ_LOG (TIZ_PRIORITY_TRACE,
            "jump [%d] current_position_ [%d]"
@@ -296,6 +229,12 @@ const std::string &tiz::playlist::get_current_uri () const
 tiz::playlist tiz::playlist::obtain_next_sub_playlist (
     const list_direction_t up_or_down)
 {
+  if (feed_)
+  {
+    const int sub_lists = sub_list_positions_.size () - 1;
+    absorb (DirUp == up_or_down && current_sub_list_ + 1 >= sub_lists);
+  }
+
   if (uri_list_.empty () || single_format ())
   {
     return playlist (get_uri_list ());
@@ -331,6 +270,14 @@ tiz::playlist tiz::playlist::obtain_next_sub_playlist (
              current_sub_list_, position1, position2);
 
     playlist new_list (uri_lst_t (first, last));
+    if (feed_ && position2 == uri_list_.size ())
+    {
+      // The last sub-list keeps growing with the tracks of the same format
+      // that the scan finds next
+      new_list.feed_ = feed_;
+      new_list.feed_pos_ = feed_pos_;
+      new_list.feed_extension_ = lower_extension (*first);
+    }
     assert (new_list.single_format ());
     current_position_ = position1;
 
@@ -373,6 +320,12 @@ bool tiz::playlist::empty () const
 
 bool tiz::playlist::single_format () const
 {
+  if (feed_ && feed_extension_.empty ())
+  {
+    // Tracks of other formats may still be found by the scan
+    return false;
+  }
+
   if (!uri_list_.empty ())
   {
     if (Unknown == single_format_)
@@ -508,6 +461,37 @@ void tiz::playlist::scan_list ()
   }
 }
 
+void tiz::playlist::absorb (const bool wait_for_more /* = false */)
+{
+  uri_lst_t uris;
+  const bool more = feed_->fetch (feed_pos_, uris, wait_for_more);
+
+  uri_lst_t::iterator last = uris.begin ();
+  while (last != uris.end ()
+         && (feed_extension_.empty ()
+             || 0 == lower_extension (*last).compare (feed_extension_)))
+  {
+    ++last;
+  }
+
+  uri_list_.insert (uri_list_.end (), uris.begin (), last);
+  feed_pos_ += last - uris.begin ();
+
+  if (!more || last != uris.end ())
+  {
+    TIZ_LOG (TIZ_PRIORITY_TRACE, "done with the feed at [%lu]",
+             (unsigned long)feed_pos_);
+    feed_.reset ();
+  }
+
+  if (last != uris.begin () || !feed_)
+  {
+    sub_list_positions_.clear ();
+    single_format_ = Unknown;
+    scan_list ();
+  }
+}
+
 int tiz::playlist::find_next_sub_list (const int position) const
 {
   const int list_size = uri_list_.size ();
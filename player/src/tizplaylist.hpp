@@ -46,6 +46,7 @@ namespace tiz
 
   public:
     explicit playlist (const uri_lst_t &uri_list = uri_lst_t (), const bool shuffle = false);
+    playlist (const tizplaylistfeed_ptr_t &feed, const bool shuffle = false);
     playlist (const playlist &playlist);
 
     static bool assemble_play_list (const std::string &base_uri,
@@ -88,6 +89,7 @@ namespace tiz
 
     void scan_list ();
     int find_next_sub_list (const int position) const;
+    void absorb (const bool wait_for_more = false);
 
     // TODO: Possibly use a shared pointer here to make copy a less expensive
     // operation
@@ -99,6 +101,11 @@ namespace tiz
     bool shuffle_;
     mutable file_extension_lst_t extension_list_;
     mutable single_format_t single_format_;
+    // The background scan that is still adding tracks to this list, if any
+    tizplaylistfeed_ptr_t feed_;
+    size_t feed_pos_;
+    // If not empty, only the tracks with this extension are taken from the feed
+    std::string feed_extension_;
   };
 }  // namespace tiz
 
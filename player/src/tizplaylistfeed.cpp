@@ -0,0 +1,464 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizplaylistfeed.cpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Background scan of the local media that makes up a playlist
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/foreach.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <tizplatform.h>
+
+#include "tizmedialib.hpp"
+#include "tizplaylistfeed.hpp"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.play.playlistfeed"
+#endif
+
+#define PLAYLIST_FEED_DEFAULT_THREADS 4
+
+/* Listed directories not yet consumed by the assembler; past this, the listers
+   wait, so that they do not starve the assembler or fill up the memory */
+#define PLAYLIST_FEED_MAX_LOOKAHEAD 32
+
+/* In shuffle mode, the first track is drawn from this many tracks (or from all
+   of them, if there are fewer), so that it is not weighted by the size of its
+   directory */
+#define PLAYLIST_FEED_SHUFFLE_SAMPLE 1000
+
+namespace  // unnamed namespace
+{
+  unsigned int get_scan_threads ()
+  {
+    unsigned int threads = PLAYLIST_FEED_DEFAULT_THREADS;
+    const char *p_threads
+        = tiz_rcfile_get_value ("tizonia", "playlist-scan-threads");
+    if (p_threads)
+    {
+      const long value = strtol (p_threads, NULL, 10);
+      if (value > 0)
+      {
+        threads = value;
+      }
+    }
+    return threads;
+  }
+
+  std::string join_path (const std::string &dir, const std::string &name)
+  {
+    std::string path (dir);
+    if (path.empty () || '/' != path[path.size () - 1])
+    {
+      path.append ("/");
+    }
+    return path.append (name);
+  }
+
+  /* Sorting the entries of each directory by name, with a '/' appended to the
+     names of sub-directories, makes the depth-first traversal produce the
+     paths in the same order as std::sort would */
+  template < typename T >
+  bool entry_less (const T &a, const T &b)
+  {
+    const std::string key_a (a.is_dir ? a.name + "/" : a.name);
+    const std::string key_b (b.is_dir ? b.name + "/" : b.name);
+    return key_a < key_b;
+  }
+}  // unnamed namespace
+
+tiz::playlist_feed::playlist_feed (const uri_lst_t &base_uris,
+                                   const bool shuffle, const bool recurse,
+                                   const file_extension_lst_t &extension_list)
+  : base_uris_ (base_uris),
+    shuffle_ (shuffle),
+    recurse_ (recurse),
+    extension_list_ (extension_list),
+    completion_cback_ (),
+    mutex_ (),
+    cond_ (),
+    threads_ (),
+    pending_dirs_ (),
+    dirs_ (),
+    uris_ (),
+    awaiting_ (false),
+    started_ (false),
+    complete_ (false),
+    stopping_ (false)
+{
+}
+
+tiz::playlist_feed::~playlist_feed ()
+{
+  stop ();
+}
+
+bool tiz::playlist_feed::start (std::string &error_msg,
+                                std::string &error_uri,
+                                const completion_cback_t &completion_cback)
+{
+  assert (!started_);
+
+  BOOST_FOREACH (std::string &uri, base_uris_)
+  {
+    boost::system::error_code errcode;
+    error_uri = uri;
+
+    if (uri.empty ())
+    {
+      error_msg.assign ("Empty media uri.");
+      return false;
+    }
+
+    const std::string canonical_uri
+        = boost::filesystem::canonical (uri, errcode).string ();
+    if (errcode.value () != 0)
+    {
+      error_msg.assign (errcode.message ());
+      return false;
+    }
+
+    if (!boost::filesystem::is_regular_file (canonical_uri, errcode)
+        && !boost::filesystem::is_directory (canonical_uri, errcode))
+    {
+      error_msg.assign ("File not found.");
+      return false;
+    }
+    uri = canonical_uri;
+  }
+
+  completion_cback_ = completion_cback;
+  started_ = true;
+
+  // Make sure the index is initialised before the scanning threads use it
+  (void)tiz::medialib::instance ().enabled ();
+
+  {
+    boost::lock_guard< boost::mutex > lock (mutex_);
+    for (size_t i = 0; i < base_uris_.size (); ++i)
+    {
+      boost::system::error_code errcode;
+      if (boost::filesystem::is_directory (base_uris_[i], errcode))
+      {
+        pending_dirs_[dir_rank_t (1, i)] = base_uris_[i];
+      }
+    }
+  }
+
+  const unsigned int nthreads = get_scan_threads ();
+  for (unsigned int i = 0; i < nthreads; ++i)
+  {
+    threads_.create_thread (boost::bind (&tiz::playlist_feed::lister, this));
+  }
+  threads_.create_thread (boost::bind (&tiz::playlist_feed::assembler, this));
+
+  boost::unique_lock< boost::mutex > lock (mutex_);
+  while (!first_track_known () && !complete_)
+  {
+    cond_.wait (lock);
+  }
+
+  if (uris_.empty ())
+  {
+    error_msg.assign ("No supported media types found.");
+    error_uri = base_uris_.front ();
+    TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s]", error_msg.c_str ());
+    return false;
+  }
+
+  return true;
+}
+
+void tiz::playlist_feed::wait ()
+{
+  boost::unique_lock< boost::mutex > lock (mutex_);
+  while (started_ && !complete_ && !stopping_)
+  {
+    cond_.wait (lock);
+  }
+}
+
+bool tiz::playlist_feed::fetch (const size_t from, uri_lst_t &uri_list,
+                                const bool wait_for_more /* = false */)
+{
+  boost::unique_lock< boost::mutex > lock (mutex_);
+  // Until the list is complete and shuffled, only the first track is known
+  size_t available = 0;
+  for (;;)
+  {
+    available = (shuffle_ && !complete_) ? (first_track_known () ? 1 : 0)
+                                         : uris_.size ();
+    if (!wait_for_more || from < available || complete_ || stopping_)
+    {
+      break;
+    }
+    cond_.wait (lock);
+  }
+
+  if (from < available)
+  {
+    uri_list.insert (uri_list.end (), uris_.begin () + from,
+                     uris_.begin () + available);
+  }
+  return !complete_;
+}
+
+void tiz::playlist_feed::stop ()
+{
+  {
+    boost::lock_guard< boost::mutex > lock (mutex_);
+    stopping_ = true;
+  }
+  cond_.notify_all ();
+  threads_.join_all ();
+}
+
+bool tiz::playlist_feed::first_track_known () const
+{
+  return shuffle_ ? uris_.size () >= PLAYLIST_FEED_SHUFFLE_SAMPLE
+                  : !uris_.empty ();
+}
+
+bool tiz::playlist_feed::is_supported (const std::string &uri) const
+{
+  std::string extension (boost::filesystem::path (uri).extension ().string ());
+  boost::algorithm::to_lower (extension);
+  return extension_list_.find (extension) != extension_list_.end ();
+}
+
+void tiz::playlist_feed::list (const std::string &dir,
+                               dir_entry_lst_t &entries)
+{
+  std::string names;
+
+  if (!tiz::medialib::instance ().list_directory (dir, names))
+  {
+    TIZ_LOG (TIZ_PRIORITY_NOTICE, "Unable to list [%s]", dir.c_str ());
+    return;
+  }
+
+  const char *p_name = names.c_str ();
+  const char *p_end = p_name + names.size ();
+  for (; p_name < p_end; p_name += strlen (p_name) + 1)
+  {
+    dir_entry entry;
+    entry.name.assign (p_name + 1);
+    entry.is_dir = ('d' == *p_name);
+    if (entry.is_dir ? recurse_ : is_supported (entry.name))
+    {
+      entries.push_back (entry);
+    }
+  }
+
+  if (shuffle_)
+  {
+    std::random_shuffle (entries.begin (), entries.end ());
+  }
+  else
+  {
+    std::sort (entries.begin (), entries.end (), entry_less< dir_entry >);
+  }
+}
+
+void tiz::playlist_feed::lister ()
+{
+  for (;;)
+  {
+    dir_rank_t rank;
+    std::string dir;
+    dir_entry_lst_t entries;
+
+    {
+      boost::unique_lock< boost::mutex > lock (mutex_);
+      while ((pending_dirs_.empty ()
+              || (dirs_.size () >= PLAYLIST_FEED_MAX_LOOKAHEAD && !awaiting_))
+             && !complete_ && !stopping_)
+      {
+        cond_.wait (lock);
+      }
+      if (complete_ || stopping_)
+      {
+        break;
+      }
+      // The directory that comes first in the playlist is listed first
+      rank = pending_dirs_.begin ()->first;
+      dir.swap (pending_dirs_.begin ()->second);
+      pending_dirs_.erase (pending_dirs_.begin ());
+    }
+
+    list (dir, entries);
+
+    {
+      boost::lock_guard< boost::mutex > lock (mutex_);
+      for (size_t i = 0; i < entries.size (); ++i)
+      {
+        if (entries[i].is_dir)
+        {
+          dir_rank_t sub_rank (rank);
+          sub_rank.push_back (i);
+          pending_dirs_[sub_rank] = join_path (dir, entries[i].name);
+        }
+      }
+      dir_node &node = dirs_[rank];
+      node.entries.swap (entries);
+      node.listed = true;
+    }
+    cond_.notify_all ();
+  }
+}
+
+bool tiz::playlist_feed::emit_dir (const dir_rank_t &rank,
+                                   const std::string &dir, uri_lst_t &batch)
+{
+  dir_entry_lst_t entries;
+
+  {
+    boost::unique_lock< boost::mutex > lock (mutex_);
+    while (!dirs_[rank].listed && !stopping_)
+    {
+      // Let the listers go past the look-ahead limit; the directory may be
+      // the one they have yet to get to
+      awaiting_ = true;
+      cond_.notify_all ();
+      cond_.wait (lock);
+    }
+    awaiting_ = false;
+    if (stopping_)
+    {
+      return false;
+    }
+    entries.swap (dirs_[rank].entries);
+    dirs_.erase (rank);
+  }
+  cond_.notify_all ();
+
+  // NOTE: The sub-directories are ranked by their position in the listing,
+  // as the listers did
+  for (size_t i = 0; i < entries.size (); ++i)
+  {
+    const std::string path (join_path (dir, entries[i].name));
+    if (!entries[i].is_dir)
+    {
+      batch.push_back (path);
+    }
+    else
+    {
+      dir_rank_t sub_rank (rank);
+      sub_rank.push_back (i);
+      emit (batch);
+      if (!emit_dir (sub_rank, path, batch))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void tiz::playlist_feed::emit (uri_lst_t &batch)
+{
+  if (!batch.empty ())
+  {
+    {
+      boost::lock_guard< boost::mutex > lock (mutex_);
+      const size_t first_new = uris_.size ();
+      uris_.insert (uris_.end (), batch.begin (), batch.end ());
+      if (shuffle_)
+      {
+        // Reservoir sampling: until it is handed out, the first track is
+        // equally likely to be any of the tracks found so far. The random walk
+        // down the tree alone would favour the tracks in small directories.
+        const size_t sample_end
+            = std::min (uris_.size (), size_t (PLAYLIST_FEED_SHUFFLE_SAMPLE));
+        for (size_t i = std::max (first_new, size_t (1)); i < sample_end; ++i)
+        {
+          if (0 == rand () % (i + 1))
+          {
+            std::swap (uris_[0], uris_[i]);
+          }
+        }
+      }
+    }
+    cond_.notify_all ();
+    batch.clear ();
+  }
+}
+
+void tiz::playlist_feed::assembler ()
+{
+  uri_lst_t batch;
+
+  for (size_t i = 0; i < base_uris_.size (); ++i)
+  {
+    const std::string &uri = base_uris_[i];
+    boost::system::error_code errcode;
+    if (!boost::filesystem::is_directory (uri, errcode))
+    {
+      if (is_supported (uri))
+      {
+        batch.push_back (uri);
+      }
+    }
+    else if (!emit_dir (dir_rank_t (1, i), uri, batch))
+    {
+      return;
+    }
+    emit (batch);
+  }
+
+  {
+    boost::lock_guard< boost::mutex > lock (mutex_);
+    if (shuffle_ && uris_.size () > 1)
+    {
+      std::random_shuffle (uris_.begin () + 1, uris_.end ());
+    }
+    complete_ = true;
+  }
+  cond_.notify_all ();
+
+  TIZ_LOG (TIZ_PRIORITY_NOTICE, "Playlist scan complete: [%lu] tracks",
+           (unsigned long)uris_.size ());
+
+  // Keep the directory listings for the next time
+  (void)tiz::medialib::instance ().save ();
+
+  if (completion_cback_)
+  {
+    completion_cback_ (uris_);
+  }
+}
@@ -0,0 +1,141 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizplaylistfeed.hpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Background scan of the local media that makes up a playlist
+ *
+ * A pool of threads lists the directories under the playlist's base uris,
+ * in the order they appear in the playlist, and keeps only the files with a
+ * supported extension. The files are handed out in playlist order as soon as
+ * all the directories that precede them have been listed, so that playback can
+ * start with the first track while the rest of the tree is still being
+ * scanned. In shuffle mode, only the first track is handed out before the scan
+ * is complete; the rest of the list follows, shuffled, once it is. The first
+ * track is drawn uniformly from the first 1000 tracks found by a random walk
+ * down the tree: in larger playlists, it is a little more likely to come from a
+ * small directory than from a large one.
+ *
+ */
+
+#ifndef TIZPLAYLISTFEED_HPP
+#define TIZPLAYLISTFEED_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+#include "tizgraphtypes.hpp"
+
+namespace tiz
+{
+  class playlist_feed
+  {
+
+  public:
+    typedef boost::function< void(const uri_lst_t &) > completion_cback_t;
+
+  public:
+    playlist_feed (const uri_lst_t &base_uris, const bool shuffle,
+                   const bool recurse,
+                   const file_extension_lst_t &extension_list);
+    ~playlist_feed ();
+
+    /* Start the scan, and wait until the first track is known. On error,
+       error_uri is the base uri that could not be used. The callback is
+       invoked from the scanning thread once the scan is complete. */
+    bool start (std::string &error_msg, std::string &error_uri,
+                const completion_cback_t &completion_cback
+                = completion_cback_t ());
+
+    /* Wait until the scan is complete */
+    void wait ();
+
+    /* Retrieve the tracks found after the first 'from' ones, optionally
+       waiting until there is at least one. Returns false once the scan is
+       complete and there are no more tracks to retrieve. */
+    bool fetch (const size_t from, uri_lst_t &uri_list,
+                const bool wait_for_more = false);
+
+    /* Stop the scan */
+    void stop ();
+
+  private:
+    struct dir_entry
+    {
+      std::string name;
+      bool is_dir;
+    };
+
+    typedef std::vector< dir_entry > dir_entry_lst_t;
+
+    struct dir_node
+    {
+      dir_node () : listed (false), entries ()
+      {
+      }
+      bool listed;
+      dir_entry_lst_t entries;
+    };
+
+    // The position of a directory in a depth-first traversal of the playlist.
+    // Unlike its path, it is unique even when the base uris repeat or nest.
+    typedef std::vector< size_t > dir_rank_t;
+    typedef std::map< dir_rank_t, std::string > pending_dir_map_t;
+    typedef std::map< dir_rank_t, dir_node > dir_node_map_t;
+
+  private:
+    bool first_track_known () const;
+    bool is_supported (const std::string &uri) const;
+    void list (const std::string &dir, dir_entry_lst_t &entries);
+    void lister ();
+    bool emit_dir (const dir_rank_t &rank, const std::string &dir,
+                   uri_lst_t &batch);
+    void emit (uri_lst_t &batch);
+    void assembler ();
+
+  private:
+    uri_lst_t base_uris_;
+    const bool shuffle_;
+    const bool recurse_;
+    const file_extension_lst_t extension_list_;
+    completion_cback_t completion_cback_;
+    boost::mutex mutex_;
+    boost::condition_variable cond_;
+    boost::thread_group threads_;
+    // Directories waiting to be listed, in playlist order
+    pending_dir_map_t pending_dirs_;
+    // Directories listed but not yet consumed by the assembler
+    dir_node_map_t dirs_;
+    // The tracks found so far, in playlist order
+    uri_lst_t uris_;
+    // The assembler is waiting for a directory to be listed
+    bool awaiting_;
+    bool started_;
+    bool complete_;
+    bool stopping_;
+  };
+}  // namespace tiz
+
+#endif  // TIZPLAYLISTFEED_HPP
@@ -43,6 +43,7 @@
 
 #include <tizplatform.h>
 
+#include "tizmedialib.hpp"
 #include "tizprobe.hpp"
 
 #ifdef TIZ_LOG_CATEGORY_NAME
@@ -101,38 +102,41 @@ namespace  // unnamed
     return (mi.Open (file_uri) > 0);
   }
 
-  void obtain_stream_title_and_genre (MediaInfoLib::MediaInfo &mi,
+  void obtain_general_info (MediaInfoLib::MediaInfo &mi,
+                            tiz::media_info &info)
+  {
+    info.performer = mi_stream_general_info_to_std_string (mi, L"Performer");
+    info.track_name = mi_stream_general_info_to_std_string (mi, L"Track");
+    info.album_name = mi_stream_general_info_to_std_string (mi, L"Album");
+    info.genre_name = mi_stream_general_info_to_std_string (mi, L"Genre");
+    info.complete_name
+        = mi_stream_general_info_to_std_string (mi, L"CompleteName");
+  }
+
+  void obtain_stream_title_and_genre (const tiz::media_info &info,
                                       const bool quiet,
                                       std::string &stream_title,
                                       std::string &stream_genre)
   {
-    std::string artist (
-        mi_stream_general_info_to_std_string (mi, L"Performer"));
-    std::string title (mi_stream_general_info_to_std_string (mi, L"Track"));
-    std::string album (mi_stream_general_info_to_std_string (mi, L"Album"));
-    std::string genre (mi_stream_general_info_to_std_string (mi, L"Genre"));
-    std::string full_track_name (
-        mi_stream_general_info_to_std_string (mi, L"CompleteName"));
-
-    stream_title.assign (artist);
-    if (!album.empty ())
+    stream_title.assign (info.performer);
+    if (!info.album_name.empty ())
     {
       stream_title.append (" - ");
-      stream_title.append (album);
+      stream_title.append (info.album_name);
     }
 
-    if (!title.empty ())
+    if (!info.track_name.empty ())
     {
       stream_title.append (" - ");
-      stream_title.append (title);
+      stream_title.append (info.track_name);
     }
-    stream_genre.assign (genre);
+    stream_genre.assign (info.genre_name);
 
     if (!quiet)
     {
       if (stream_title.empty ())
       {
-        stream_title.assign (full_track_name);
+        stream_title.assign (info.complete_name);
       }
       boost::replace_all (stream_title, "_", " ");
     }
@@ -188,32 +192,30 @@ namespace  // unnamed
   }
 
   void obtain_stream_properties (MediaInfoLib::MediaInfo &mi,
-                                 OMX_U32 &samplerate, OMX_U32 &bitrate,
-                                 OMX_U32 &nchannels, OMX_U32 &bitdepth,
-                                 OMX_ENDIANTYPE &endianness,
-                                 OMX_NUMERICALDATATYPE &sign,
-                                 bool &stream_is_cbr)
+                                 tiz::media_info &info)
   {
-    mi_stream_audio_info_to_unsigned (mi, L"SamplingRate", samplerate);
-    mi_stream_audio_info_to_unsigned (mi, L"BitRate", bitrate);
-    mi_stream_audio_info_to_unsigned (mi, L"Channel(s)", nchannels);
-    mi_stream_audio_info_to_unsigned (mi, L"BitDepth", bitdepth);
+    mi_stream_audio_info_to_unsigned (mi, L"SamplingRate", info.samplerate);
+    mi_stream_audio_info_to_unsigned (mi, L"BitRate", info.bitrate);
+    mi_stream_audio_info_to_unsigned (mi, L"Channel(s)", info.nchannels);
+    mi_stream_audio_info_to_unsigned (mi, L"BitDepth", info.bitdepth);
 
     std::string en (
         mi_stream_audio_info_to_std_string (mi, L"Format_Settings_Endianness"));
-    endianness = en.empty () ? endianness
-                             : (en.compare ("Little") == 0 ? OMX_EndianLittle
-                                                           : OMX_EndianBig);
+    info.endianness
+        = en.empty () ? info.endianness
+                      : (en.compare ("Little") == 0 ? OMX_EndianLittle
+                                                    : OMX_EndianBig);
 
     std::string s (
         mi_stream_audio_info_to_std_string (mi, L"Format_Settings_Sign"));
-    sign = s.empty () ? sign
-                      : (s.compare ("Signed") == 0 ? OMX_NumericalDataSigned
-                                                   : OMX_NumericalDataUnsigned);
+    info.sign = s.empty ()
+                    ? info.sign
+                    : (s.compare ("Signed") == 0 ? OMX_NumericalDataSigned
+                                                 : OMX_NumericalDataUnsigned);
 
     std::string cbr_or_vbr (
         mi_stream_general_info_to_std_string (mi, L"OverallBitRate_Mode"));
-    stream_is_cbr = (cbr_or_vbr.compare ("CBR") == 0);
+    info.cbr = (cbr_or_vbr.compare ("CBR") == 0);
   }
 
   OMX_MEDIACONTAINER_FORMATTYPE obtain_container_format (
@@ -252,10 +254,12 @@ tiz::probe::probe (const std::string &uri, const bool quiet)
     vorbistype_ (),
     aactype_ (),
     vp8type_ (),
-    meta_file_ (uri.c_str ()),
+    meta_file_ (),
     stream_title_ (),
     stream_genre_ (),
-    stream_is_cbr_ (false)
+    stream_is_cbr_ (false),
+    indexed_info_ (),
+    indexed_ (false)
 {
   // Defaults are the same as in the standard pcm renderer
   pcmtype_.nSize = sizeof(OMX_AUDIO_PARAM_PCMMODETYPE);
@@ -357,6 +361,17 @@ tiz::probe::probe (const std::string &uri, const bool quiet)
   vp8type_.eLevel = OMX_VIDEO_VP8Level_Version0;
   vp8type_.nDCTPartitions = 0; /* 1 DCP partitiion */
   vp8type_.bErrorResilientMode = OMX_FALSE;
+
+  // Files that are in the media library index need not be opened at all
+  indexed_ = tiz::medialib::instance ().lookup (uri_, indexed_info_);
+  if (indexed_)
+  {
+    set_stream_info (indexed_info_);
+  }
+  else
+  {
+    meta_file_ = TagLib::FileRef (uri.c_str ());
+  }
 }
 
 std::string tiz::probe::get_uri () const
@@ -411,72 +426,38 @@ void tiz::probe::probe_stream ()
 
   if (open_media (uri_, mi))
   {
-    OMX_U32 samplerate = 48000;
-    OMX_U32 bitrate = 0;
-    OMX_U32 nchannels = 2;
-    OMX_U32 bitdepth = 16;
-    OMX_ENDIANTYPE endianness = OMX_EndianLittle;
-    OMX_NUMERICALDATATYPE sign = OMX_NumericalDataSigned;
+    tiz::media_info info;
 
     // Get an idea of the container format
-    container_type_ = obtain_container_format (mi);
+    info.container_type = obtain_container_format (mi);
 
     // Get the codec type
-    const OMX_AUDIO_CODINGTYPE codec_id = obtain_codec_id (mi);
+    info.codec_id = obtain_codec_id (mi);
 
-    // Get the stream title and genre
-    obtain_stream_title_and_genre (mi, quiet_, stream_title_, stream_genre_);
+    // Get the fields that make up the stream title and genre
+    obtain_general_info (mi, info);
 
-    TIZ_PRINTF_DBG_RED ("uri [%s] codec_id [%0x]\n", uri_.c_str (), codec_id);
+    TIZ_PRINTF_DBG_RED ("uri [%s] codec_id [%0x]\n", uri_.c_str (),
+                        info.codec_id);
 
     // Grab the sample rate, bitrate, num channels, and sample format (when
     // available), and cbr flag
-    obtain_stream_properties (mi, samplerate, bitrate, nchannels, bitdepth,
-                              endianness, sign, stream_is_cbr_);
-
-    if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingMP2)
-    {
-      set_mp2_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                          sign);
-    }
-    else if (codec_id == OMX_AUDIO_CodingMP3)
-    {
-      set_mp3_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                          sign);
-    }
-    else if (codec_id == OMX_AUDIO_CodingAAC)
-    {
-      set_aac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                          sign);
-    }
-    else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingFLAC)
-    {
-      set_flac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                           sign);
-    }
-    else if (codec_id == OMX_AUDIO_CodingVORBIS)
-    {
-      set_vorbis_codec_info (samplerate, bitrate, nchannels, bitdepth,
-                             endianness, sign);
-    }
-    else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingOPUS)
-    {
-      set_opus_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                           sign);
-    }
-    else if (is_pcm_codec (codec_id))
-    {
-      domain_ = OMX_PortDomainAudio;
-      audio_coding_type_
-          = static_cast< OMX_AUDIO_CODINGTYPE >(OMX_AUDIO_CodingPCM);
-      pcmtype_.nSamplingRate = samplerate;
-      pcmtype_.nChannels = nchannels;
-      pcmtype_.nBitPerSample = bitdepth;
-      pcmtype_.eEndian = endianness;
-      pcmtype_.eNumData = sign;
-    }
+    obtain_stream_properties (mi, info);
 
     mi.Close ();
+
+    set_stream_info (info);
+
+    // Keep the results, and the tags, for the next time this file is probed
+    info.title = title ();
+    info.artist = artist ();
+    info.album = album ();
+    info.year = year ();
+    info.comment = comment ();
+    info.track = track ();
+    info.genre = genre ();
+    info.length = stream_length ();
+    tiz::medialib::instance ().store (uri_, info);
   }
   else
   {
@@ -484,6 +465,63 @@ void tiz::probe::probe_stream ()
   }
 }
 
+void tiz::probe::set_stream_info (const tiz::media_info &info)
+{
+  const OMX_AUDIO_CODINGTYPE codec_id = info.codec_id;
+  const OMX_U32 samplerate = info.samplerate;
+  const OMX_U32 bitrate = info.bitrate;
+  const OMX_U32 nchannels = info.nchannels;
+  const OMX_U32 bitdepth = info.bitdepth;
+  const OMX_ENDIANTYPE endianness = info.endianness;
+  const OMX_NUMERICALDATATYPE sign = info.sign;
+
+  container_type_ = info.container_type;
+  obtain_stream_title_and_genre (info, quiet_, stream_title_, stream_genre_);
+  stream_is_cbr_ = info.cbr;
+
+  if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingMP2)
+  {
+    set_mp2_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                        sign);
+  }
+  else if (codec_id == OMX_AUDIO_CodingMP3)
+  {
+    set_mp3_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                        sign);
+  }
+  else if (codec_id == OMX_AUDIO_CodingAAC)
+  {
+    set_aac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                        sign);
+  }
+  else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingFLAC)
+  {
+    set_flac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                         sign);
+  }
+  else if (codec_id == OMX_AUDIO_CodingVORBIS)
+  {
+    set_vorbis_codec_info (samplerate, bitrate, nchannels, bitdepth,
+                           endianness, sign);
+  }
+  else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingOPUS)
+  {
+    set_opus_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                         sign);
+  }
+  else if (is_pcm_codec (codec_id))
+  {
+    domain_ = OMX_PortDomainAudio;
+    audio_coding_type_
+        = static_cast< OMX_AUDIO_CODINGTYPE >(OMX_AUDIO_CodingPCM);
+    pcmtype_.nSamplingRate = samplerate;
+    pcmtype_.nChannels = nchannels;
+    pcmtype_.nBitPerSample = bitdepth;
+    pcmtype_.eEndian = endianness;
+    pcmtype_.eNumData = sign;
+  }
+}
+
 void tiz::probe::set_mp2_codec_info (const OMX_U32 samplerate,
                                      const OMX_U32 bitrate,
                                      const OMX_U32 nchannels,
@@ -777,38 +815,66 @@ unsigned int tiz::probe::retrieve_meta_data_uint (
 
 std::string tiz::probe::title () const
 {
+  if (indexed_)
+  {
+    return indexed_info_.title;
+  }
   return retrieve_meta_data_str (&TagLib::Tag::title);
 }
 
 std::string tiz::probe::artist () const
 {
+  if (indexed_)
+  {
+    return indexed_info_.artist;
+  }
   return retrieve_meta_data_str (&TagLib::Tag::artist);
 }
 
 std::string tiz::probe::album () const
 {
+  if (indexed_)
+  {
+    return indexed_info_.album;
+  }
   return retrieve_meta_data_str (&TagLib::Tag::album);
 }
 
 std::string tiz::probe::year () const
 {
+  if (indexed_)
+  {
+    return indexed_info_.year;
+  }
   return boost::lexical_cast< std::string >(
       retrieve_meta_data_uint (&TagLib::Tag::year));
 }
 
 std::string tiz::probe::comment () const
 {
+  if (indexed_)
+  {
+    return indexed_info_.comment;
+  }
   return retrieve_meta_data_str (&TagLib::Tag::comment);
 }
 
 std::string tiz::probe::track () const
 {
+  if (indexed_)
+  {
+    return indexed_info_.track;
+  }
   return boost::lexical_cast< std::string >(
       retrieve_meta_data_uint (&TagLib::Tag::track));
 }
 
 std::string tiz::probe::genre () const
 {
+  if (indexed_)
+  {
+    return indexed_info_.genre;
+  }
   return retrieve_meta_data_str (&TagLib::Tag::genre);
 }
 
@@ -816,6 +882,11 @@ std::string tiz::probe::stream_length () const
 {
   std::string length_str;
 
+  if (indexed_)
+  {
+    return indexed_info_.length;
+  }
+
   if (!meta_file_.isNull () && meta_file_.audioProperties ())
   {
     TagLib::AudioProperties *properties = meta_file_.audioProperties ();
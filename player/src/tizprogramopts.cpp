@@ -340,6 +340,7 @@ tiz::programopts::programopts (int argc, char *argv[])
     proxy_password_(),
     log_dir_ (),
     debug_info_ (false),
+    dump_log_file_ (),
     comp_name_ (),
     role_name_ (),
     port_ (TIZ_STREAMING_SERVER_DEFAULT_PORT),
@@ -736,6 +737,11 @@ bool tiz::programopts::debug_info () const
   return debug_info_;
 }
 
+const std::string &tiz::programopts::dump_log_file () const
+{
+  return dump_log_file_;
+}
+
 const std::string &tiz::programopts::component_name () const
 {
   return comp_name_;
@@ -1618,10 +1624,14 @@ void tiz::programopts::init_debug_options ()
           "debug-info", po::bool_switch (&debug_info_)->default_value (false),
           "Print debug-related information.")
       /* TIZ_CLASS_COMMENT: */
+      ("dump-log", po::value (&dump_log_file_),
+       "Print the contents of a binary log file (see 'log.ring-buffer' in "
+       "tizonia.conf).")
+      /* TIZ_CLASS_COMMENT: */
       ;
   register_consume_function (&tiz::programopts::consume_debug_options);
   all_debug_options_
-      = boost::assign::list_of ("log-directory") ("debug-info")
+      = boost::assign::list_of ("log-directory") ("debug-info") ("dump-log")
             .convert_to_container< std::vector< std::string > > ();
 }
 
@@ -2163,6 +2173,11 @@ int tiz::programopts::consume_debug_options (bool &done, std::string &msg)
     rc = EXIT_SUCCESS;
     done = true;
   }
+  if (vm_.count ("dump-log"))
+  {
+    rc = call_handler (option_handlers_map_.find ("dump-log"));
+    done = true;
+  }
   TIZ_PRINTF_DBG_RED ("debug-opts ; rc = [%s]\n",
                       rc == EXIT_SUCCESS ? "SUCCESS" : "FAILURE");
   return rc;
@@ -0,0 +1,357 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_tizmedialib.cpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Media library index unit tests
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <check.h>
+
+#include <set>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "tizmedialib.hpp"
+
+#define MEDIALIB_TEST_TIMEOUT 10
+
+/* NOTE: The tests share one index, so each works in a directory of its own
+   and only checks its own entries */
+static char g_root[] = "/tmp/check_tizmedialib.XXXXXX";
+
+static std::string g_index;
+
+static std::string make_test_dir (void)
+{
+  std::string dir (std::string (g_root) + "/test.XXXXXX");
+  fail_if (NULL == mkdtemp (&dir[0]));
+  return dir;
+}
+
+static void make_file (const std::string &path, const char *p_contents)
+{
+  FILE *p_file = fopen (path.c_str (), "w");
+  fail_if (NULL == p_file);
+  fputs (p_contents, p_file);
+  fclose (p_file);
+}
+
+/* Moves the modification time of a file or directory by 'secs' seconds */
+static void shift_mtime (const std::string &path, const int secs)
+{
+  struct stat st;
+  struct timespec times[2];
+  fail_if (0 != stat (path.c_str (), &st));
+  times[0] = st.st_atim;
+  times[1] = st.st_mtim;
+  times[1].tv_sec += secs;
+  fail_if (0 != utimensat (AT_FDCWD, path.c_str (), times, 0));
+}
+
+static tiz::media_info make_info (const std::string &title,
+                                  const OMX_U32 samplerate)
+{
+  tiz::media_info info;
+  info.codec_id = OMX_AUDIO_CodingMP3;
+  info.container_type = OMX_FORMATMax;
+  info.samplerate = samplerate;
+  info.bitrate = 320000;
+  info.nchannels = 2;
+  info.bitdepth = 16;
+  info.cbr = true;
+  info.performer = "Performer";
+  info.track_name = title;
+  info.album_name = "Album";
+  info.complete_name = "/some/where/" + title;
+  info.title = title;
+  info.artist = "Performer";
+  info.album = "Album";
+  info.year = "1999";
+  info.track = "1";
+  info.length = "3m:20s";
+  /* genre_name, comment and genre are left empty */
+  return info;
+}
+
+static bool same_info (const tiz::media_info &a, const tiz::media_info &b)
+{
+  return a.codec_id == b.codec_id && a.container_type == b.container_type
+         && a.samplerate == b.samplerate && a.bitrate == b.bitrate
+         && a.nchannels == b.nchannels && a.bitdepth == b.bitdepth
+         && a.endianness == b.endianness && a.sign == b.sign
+         && a.cbr == b.cbr && a.performer == b.performer
+         && a.track_name == b.track_name && a.album_name == b.album_name
+         && a.genre_name == b.genre_name
+         && a.complete_name == b.complete_name && a.title == b.title
+         && a.artist == b.artist && a.album == b.album && a.year == b.year
+         && a.comment == b.comment && a.track == b.track
+         && a.genre == b.genre && a.length == b.length;
+}
+
+static std::set< std::string > split_names (const std::string &names)
+{
+  std::set< std::string > entries;
+  std::string::size_type pos = 0;
+  std::string::size_type end = 0;
+  while (std::string::npos != (end = names.find ('\0', pos)))
+  {
+    entries.insert (names.substr (pos, end - pos));
+    pos = end + 1;
+  }
+  fail_if (pos != names.size ());
+  return entries;
+}
+
+static std::set< std::string > list_dir (const std::string &dir)
+{
+  std::string names;
+  fail_if (!tiz::medialib::instance ().list_directory (dir, names));
+  return split_names (names);
+}
+
+/* Checks the index header, and returns its record counts */
+static void read_index_header (uint32_t &ndirs, uint32_t &nfiles)
+{
+  char header[20];
+  uint32_t version = 0;
+  FILE *p_file = fopen (g_index.c_str (), "r");
+  fail_if (NULL == p_file);
+  fail_if (sizeof (header) != fread (header, 1, sizeof (header), p_file));
+  fclose (p_file);
+  fail_if (0 != memcmp (header, "TIZMLIB", 8));
+  memcpy (&version, header + 8, sizeof (version));
+  memcpy (&ndirs, header + 12, sizeof (ndirs));
+  memcpy (&nfiles, header + 16, sizeof (nfiles));
+  fail_if (1 != version);
+}
+
+START_TEST (test_medialib_file_roundtrip)
+{
+  tiz::medialib &medialib = tiz::medialib::instance ();
+  const std::string dir (make_test_dir ());
+  const tiz::media_info a_info (make_info ("a", 44100));
+  const tiz::media_info b_info (make_info ("b", 48000));
+  tiz::media_info info;
+  uint32_t ndirs = 0;
+  uint32_t nfiles = 0;
+
+  fail_if (!medialib.enabled ());
+
+  make_file (dir + "/a.mp3", "a");
+  make_file (dir + "/b.mp3", "bb");
+  make_file (dir + "/c.mp3", "ccc");
+
+  medialib.store (dir + "/a.mp3", a_info);
+  medialib.store (dir + "/b.mp3", b_info);
+  fail_if (!medialib.save ());
+  read_index_header (ndirs, nfiles);
+  fail_if (nfiles < 2);
+
+  /* The results now come from the mapped index */
+  fail_if (!medialib.lookup (dir + "/a.mp3", info));
+  fail_if (!same_info (a_info, info));
+  fail_if (!medialib.lookup (dir + "/b.mp3", info));
+  fail_if (!same_info (b_info, info));
+  fail_if (medialib.lookup (dir + "/c.mp3", info));
+  fail_if (medialib.lookup (dir + "/missing.mp3", info));
+}
+END_TEST
+
+START_TEST (test_medialib_merge)
+{
+  tiz::medialib &medialib = tiz::medialib::instance ();
+  const std::string dir (make_test_dir ());
+  const tiz::media_info m_info (make_info ("m", 44100));
+  const tiz::media_info n_info (make_info ("n", 44100));
+  const tiz::media_info n2_info (make_info ("n2", 96000));
+  const tiz::media_info a_info (make_info ("a", 22050));
+  const tiz::media_info z_info (make_info ("z", 32000));
+  tiz::media_info info;
+  uint32_t ndirs = 0;
+  uint32_t nfiles = 0;
+  uint32_t saved_ndirs = 0;
+  uint32_t saved_nfiles = 0;
+
+  boost::filesystem::create_directories (dir + "/sub");
+  make_file (dir + "/m.mp3", "m");
+  make_file (dir + "/n.mp3", "n");
+  make_file (dir + "/a.mp3", "a");
+  make_file (dir + "/z.mp3", "z");
+
+  medialib.store (dir + "/m.mp3", m_info);
+  medialib.store (dir + "/n.mp3", n_info);
+  fail_if (list_dir (dir).size () != 5);
+  fail_if (!medialib.save ());
+  read_index_header (saved_ndirs, saved_nfiles);
+
+  /* A record that replaces a saved one, and new ones on either side of the
+     saved ones */
+  medialib.store (dir + "/n.mp3", n2_info);
+  medialib.store (dir + "/a.mp3", a_info);
+  medialib.store (dir + "/z.mp3", z_info);
+  fail_if (list_dir (dir + "/sub").size () != 0);
+  fail_if (!medialib.save ());
+
+  /* The replaced record is not kept */
+  read_index_header (ndirs, nfiles);
+  fail_if (saved_ndirs + 1 != ndirs);
+  fail_if (saved_nfiles + 2 != nfiles);
+
+  fail_if (!medialib.lookup (dir + "/a.mp3", info));
+  fail_if (!same_info (a_info, info));
+  fail_if (!medialib.lookup (dir + "/m.mp3", info));
+  fail_if (!same_info (m_info, info));
+  fail_if (!medialib.lookup (dir + "/n.mp3", info));
+  fail_if (!same_info (n2_info, info));
+  fail_if (!medialib.lookup (dir + "/z.mp3", info));
+  fail_if (!same_info (z_info, info));
+
+  {
+    std::set< std::string > expected;
+    expected.insert ("fa.mp3");
+    expected.insert ("fm.mp3");
+    expected.insert ("fn.mp3");
+    expected.insert ("fz.mp3");
+    expected.insert ("dsub");
+    fail_if (expected != list_dir (dir));
+  }
+}
+END_TEST
+
+START_TEST (test_medialib_mtime)
+{
+  tiz::medialib &medialib = tiz::medialib::instance ();
+  const std::string dir (make_test_dir ());
+  const tiz::media_info f_info (make_info ("f", 44100));
+  tiz::media_info info;
+
+  make_file (dir + "/f.mp3", "f");
+  make_file (dir + "/g.mp3", "g");
+  medialib.store (dir + "/f.mp3", f_info);
+  medialib.store (dir + "/g.mp3", f_info);
+  fail_if (list_dir (dir).size () != 2);
+  fail_if (!medialib.save ());
+
+  /* A file whose mtime or size changes is probed again */
+  fail_if (!medialib.lookup (dir + "/f.mp3", info));
+  shift_mtime (dir + "/f.mp3", 1);
+  fail_if (medialib.lookup (dir + "/f.mp3", info));
+  fail_if (!medialib.lookup (dir + "/g.mp3", info));
+  {
+    struct stat st;
+    struct timespec times[2];
+    fail_if (0 != stat ((dir + "/g.mp3").c_str (), &st));
+    make_file (dir + "/g.mp3", "gg");
+    times[0] = st.st_atim;
+    times[1] = st.st_mtim;
+    fail_if (0 != utimensat (AT_FDCWD, (dir + "/g.mp3").c_str (), times, 0));
+  }
+  fail_if (medialib.lookup (dir + "/g.mp3", info));
+
+  /* A directory is only read again when its mtime changes; a file added
+     without changing it is not seen */
+  {
+    struct stat st;
+    struct timespec times[2];
+    fail_if (0 != stat (dir.c_str (), &st));
+    make_file (dir + "/h.mp3", "h");
+    times[0] = st.st_atim;
+    times[1] = st.st_mtim;
+    fail_if (0 != utimensat (AT_FDCWD, dir.c_str (), times, 0));
+  }
+  fail_if (list_dir (dir).size () != 2);
+  shift_mtime (dir, 1);
+  fail_if (list_dir (dir).size () != 3);
+}
+END_TEST
+
+Suite *medialib_suite (void)
+{
+  TCase *tc_medialib;
+  Suite *s = suite_create ("libtizmedialib");
+
+  /* media library index test cases */
+  tc_medialib = tcase_create ("media library index");
+  tcase_set_timeout (tc_medialib, MEDIALIB_TEST_TIMEOUT);
+  tcase_add_test (tc_medialib, test_medialib_file_roundtrip);
+  tcase_add_test (tc_medialib, test_medialib_merge);
+  tcase_add_test (tc_medialib, test_medialib_mtime);
+  suite_add_tcase (s, tc_medialib);
+
+  return s;
+}
+
+int main (void)
+{
+  static char rcfile_env[sizeof (g_root) + 64];
+  std::string rcfile;
+  std::string rc;
+  int number_failed = 0;
+  SRunner *sr = NULL;
+
+  if (NULL == mkdtemp (g_root))
+  {
+    fprintf (stderr, "Unable to create %s\n", g_root);
+    return EXIT_FAILURE;
+  }
+  g_index = std::string (g_root) + "/media-library.idx";
+  rcfile = std::string (g_root) + "/tizonia.conf";
+
+  /* Indexer threads are not needed, as nothing is probed */
+  rc.append ("[tizonia]\n");
+  rc.append ("media-library = true\n");
+  rc.append ("media-library.file = " + g_index + "\n");
+  rc.append ("media-library.indexer-threads = 0\n");
+  FILE *p_file = fopen (rcfile.c_str (), "w");
+  if (!p_file || rc.size () != fwrite (rc.data (), 1, rc.size (), p_file))
+  {
+    fprintf (stderr, "Unable to create %s\n", rcfile.c_str ());
+    return EXIT_FAILURE;
+  }
+  fclose (p_file);
+  snprintf (rcfile_env, sizeof (rcfile_env), "TIZONIA_RC_FILE=%s",
+            rcfile.c_str ());
+  putenv (rcfile_env);
+
+  sr = srunner_create (medialib_suite ());
+  srunner_run_all (sr, CK_VERBOSE);
+  number_failed = srunner_ntests_failed (sr);
+  srunner_free (sr);
+
+  boost::filesystem::remove_all (g_root);
+
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
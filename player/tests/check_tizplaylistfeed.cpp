@@ -0,0 +1,254 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_tizplaylistfeed.cpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Playlist feed unit tests
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <check.h>
+
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "tizplaylistfeed.hpp"
+
+#define PLAYLISTFEED_TEST_TIMEOUT 10
+#define PLAYLISTFEED_TEST_SHUFFLE_RUNS 400
+
+/* NOTE: The feed's listers run on their own threads; the media library index
+   is disabled, so that the tests neither read nor write the user's index */
+#define PLAYLISTFEED_TEST_RCFILE                 \
+  "[tizonia]\n"                                  \
+  "media-library = false\n"                      \
+  "playlist-scan-threads = 4\n"
+
+static char g_root[] = "/tmp/check_tizplaylistfeed.XXXXXX";
+
+static void make_file (const std::string &path)
+{
+  FILE *p_file = fopen (path.c_str (), "w");
+  fail_if (NULL == p_file);
+  fclose (p_file);
+}
+
+/* Creates this tree, with the tracks in playlist order:
+     root/a.mp3
+     root/sub/b.mp3
+     root/sub/deep/c.mp3
+     root/z.mp3
+   plus a few entries that are not part of the playlist */
+static void setup (void)
+{
+  fail_if (NULL == mkdtemp (g_root));
+  const std::string root (g_root);
+  boost::filesystem::create_directories (root + "/sub/deep");
+  boost::filesystem::create_directories (root + "/empty");
+  make_file (root + "/a.mp3");
+  make_file (root + "/z.mp3");
+  make_file (root + "/notes.txt");
+  make_file (root + "/sub/b.mp3");
+  make_file (root + "/sub/deep/c.mp3");
+}
+
+static void teardown (void)
+{
+  boost::filesystem::remove_all (g_root);
+  strcpy (g_root, "/tmp/check_tizplaylistfeed.XXXXXX");
+}
+
+static uri_lst_t tracks_under (const std::string &dir)
+{
+  const std::string root (g_root);
+  const char *p_tracks[]
+      = {"/a.mp3", "/sub/b.mp3", "/sub/deep/c.mp3", "/z.mp3"};
+  uri_lst_t tracks;
+  for (size_t i = 0; i < sizeof (p_tracks) / sizeof (p_tracks[0]); ++i)
+  {
+    const std::string track (root + p_tracks[i]);
+    if (0 == track.compare (0, dir.size () + 1, dir + "/"))
+    {
+      tracks.push_back (track);
+    }
+  }
+  return tracks;
+}
+
+static uri_lst_t scan (const uri_lst_t &base_uris)
+{
+  file_extension_lst_t extensions;
+  std::string error_msg;
+  std::string error_uri;
+  uri_lst_t uris;
+
+  extensions.insert (".mp3");
+  tiz::playlist_feed feed (base_uris, false, true, extensions);
+  fail_if (!feed.start (error_msg, error_uri));
+  feed.wait ();
+  fail_if (feed.fetch (0, uris));
+  return uris;
+}
+
+START_TEST (test_playlistfeed_single_root)
+{
+  const std::string root (g_root);
+  fail_if (tracks_under (root) != scan (uri_lst_t (1, root)));
+}
+END_TEST
+
+START_TEST (test_playlistfeed_duplicate_roots)
+{
+  const std::string root (g_root);
+  uri_lst_t expected (tracks_under (root));
+  uri_lst_t base_uris;
+
+  /* Each base uri contributes its tracks, as if it was the only one */
+  base_uris.push_back (root);
+  base_uris.push_back (root + "/");
+  base_uris.push_back (root);
+  for (size_t i = 1; i < base_uris.size (); ++i)
+  {
+    const uri_lst_t tracks (tracks_under (root));
+    expected.insert (expected.end (), tracks.begin (), tracks.end ());
+  }
+  fail_if (expected != scan (base_uris));
+}
+END_TEST
+
+START_TEST (test_playlistfeed_nested_roots)
+{
+  const std::string root (g_root);
+  uri_lst_t expected;
+  uri_lst_t base_uris;
+
+  base_uris.push_back (root + "/sub");
+  base_uris.push_back (root);
+  base_uris.push_back (root + "/sub/deep");
+  base_uris.push_back (root + "/sub/deep/c.mp3");
+  for (size_t i = 0; i < base_uris.size (); ++i)
+  {
+    const uri_lst_t tracks (
+        boost::filesystem::is_directory (base_uris[i])
+            ? tracks_under (base_uris[i])
+            : uri_lst_t (1, base_uris[i]));
+    expected.insert (expected.end (), tracks.begin (), tracks.end ());
+  }
+  fail_if (expected != scan (base_uris));
+}
+END_TEST
+
+START_TEST (test_playlistfeed_shuffle_first_track)
+{
+  const std::string root (std::string (g_root) + "/shuffle");
+  file_extension_lst_t extensions;
+  int lone_first = 0;
+
+  /* One track in a directory of its own, nine in another one: the first track
+     should be the lone one about one time in ten, not one time in two */
+  boost::filesystem::create_directories (root + "/lone");
+  boost::filesystem::create_directories (root + "/many");
+  make_file (root + "/lone/a.mp3");
+  for (char c = 'a'; c < 'j'; ++c)
+  {
+    make_file (root + "/many/" + c + ".mp3");
+  }
+
+  extensions.insert (".mp3");
+  for (int i = 0; i < PLAYLISTFEED_TEST_SHUFFLE_RUNS; ++i)
+  {
+    std::string error_msg;
+    std::string error_uri;
+    uri_lst_t first;
+    uri_lst_t uris;
+    tiz::playlist_feed feed (uri_lst_t (1, root), true, true, extensions);
+    fail_if (!feed.start (error_msg, error_uri));
+    (void)feed.fetch (0, first);
+    fail_if (first.empty ());
+    feed.wait ();
+    fail_if (feed.fetch (0, uris));
+    fail_if (10 != uris.size () || first[0] != uris[0]);
+    if (root + "/lone/a.mp3" == first[0])
+    {
+      ++lone_first;
+    }
+  }
+  fail_if (lone_first > PLAYLISTFEED_TEST_SHUFFLE_RUNS / 4);
+}
+END_TEST
+
+Suite *playlistfeed_suite (void)
+{
+  TCase *tc_feed;
+  Suite *s = suite_create ("libtizplaylistfeed");
+
+  /* playlist feed test cases */
+  tc_feed = tcase_create ("playlist feed");
+  tcase_set_timeout (tc_feed, PLAYLISTFEED_TEST_TIMEOUT);
+  tcase_add_checked_fixture (tc_feed, setup, teardown);
+  tcase_add_test (tc_feed, test_playlistfeed_single_root);
+  tcase_add_test (tc_feed, test_playlistfeed_duplicate_roots);
+  tcase_add_test (tc_feed, test_playlistfeed_nested_roots);
+  tcase_add_test (tc_feed, test_playlistfeed_shuffle_first_track);
+  suite_add_tcase (s, tc_feed);
+
+  return s;
+}
+
+int main (void)
+{
+  char rcfile[] = "/tmp/check_tizplaylistfeed.conf.XXXXXX";
+  static char rcfile_env[sizeof (rcfile) + 32];
+  int number_failed = 0;
+  int fd = mkstemp (rcfile);
+  SRunner *sr = NULL;
+
+  if (fd < 0
+      || strlen (PLAYLISTFEED_TEST_RCFILE)
+             != (size_t)write (fd, PLAYLISTFEED_TEST_RCFILE,
+                               strlen (PLAYLISTFEED_TEST_RCFILE)))
+  {
+    fprintf (stderr, "Unable to create %s\n", rcfile);
+    return EXIT_FAILURE;
+  }
+  close (fd);
+  snprintf (rcfile_env, sizeof (rcfile_env), "TIZONIA_RC_FILE=%s", rcfile);
+  putenv (rcfile_env);
+
+  sr = srunner_create (playlistfeed_suite ());
+  srunner_run_all (sr, CK_VERBOSE);
+  number_failed = srunner_ntests_failed (sr);
+  srunner_free (sr);
+
+  unlink (rcfile);
+
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
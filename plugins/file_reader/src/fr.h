@@ -47,6 +47,7 @@ extern "C" {
 #define ARATELIA_FILE_READER_PORT_NONCONTIGUOUS OMX_FALSE
 #define ARATELIA_FILE_READER_PORT_ALIGNMENT 0
 #define ARATELIA_FILE_READER_PORT_SUPPLIERPREF OMX_BufferSupplyInput
+#define ARATELIA_FILE_READER_DEFAULT_READAHEAD_KB 1024
 
 #ifdef __cplusplus
 }
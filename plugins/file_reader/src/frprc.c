@@ -31,10 +31,15 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <OMX_Core.h>
 
@@ -59,6 +64,11 @@ static inline void
 close_file (fr_prc_t * ap_prc)
 {
   assert (ap_prc);
+  if (ap_prc->p_map_)
+    {
+      munmap (ap_prc->p_map_, ap_prc->file_size_);
+      ap_prc->p_map_ = NULL;
+    }
   if (ap_prc->p_file_)
     {
       fclose (ap_prc->p_file_);
@@ -80,6 +90,8 @@ reset_stream_parameters (fr_prc_t * ap_prc)
   assert (ap_prc);
   ap_prc->counter_ = 0;
   ap_prc->eos_ = false;
+  ap_prc->offset_ = 0;
+  ap_prc->readahead_end_ = 0;
   if (ap_prc->p_file_)
     {
       rewind (ap_prc->p_file_);
@@ -129,6 +141,124 @@ obtain_uri (fr_prc_t * ap_prc)
   return rc;
 }
 
+static bool
+mmap_requested (fr_prc_t * ap_prc)
+{
+  const char * p_mmap = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION,
+    ARATELIA_FILE_READER_COMPONENT_NAME ".mmap");
+  assert (ap_prc);
+  return (p_mmap && 0 == strncmp (p_mmap, "true", 4));
+}
+
+static uint64_t
+get_readahead_window (fr_prc_t * ap_prc)
+{
+  const char * p_kb = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION,
+    ARATELIA_FILE_READER_COMPONENT_NAME ".readahead_kb");
+  long kb = ARATELIA_FILE_READER_DEFAULT_READAHEAD_KB;
+  assert (ap_prc);
+  if (p_kb)
+    {
+      kb = strtol (p_kb, NULL, 10);
+    }
+  return (kb > 0 ? (uint64_t) kb * 1024 : 0);
+}
+
+static void
+map_file (fr_prc_t * ap_prc)
+{
+  struct stat st;
+  void * p_map = NULL;
+
+  assert (ap_prc);
+  assert (ap_prc->p_file_);
+  assert (!ap_prc->p_map_);
+
+  /* Empty files, pipes and the like are read with stdio */
+  if (0 != fstat (fileno (ap_prc->p_file_), &st) || !S_ISREG (st.st_mode)
+      || 0 == st.st_size)
+    {
+      return;
+    }
+
+  p_map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+                fileno (ap_prc->p_file_), 0);
+  if (MAP_FAILED == p_map)
+    {
+      TIZ_WARN (handleOf (ap_prc), "Unable to map the file (%s); using stdio",
+                strerror (errno));
+      return;
+    }
+
+  (void) madvise (p_map, st.st_size, MADV_SEQUENTIAL);
+  ap_prc->p_map_ = p_map;
+  ap_prc->file_size_ = st.st_size;
+  TIZ_NOTICE (handleOf (ap_prc), "Mapped [%llu] bytes",
+              (unsigned long long) ap_prc->file_size_);
+}
+
+/* Ask the kernel to fetch the window ahead of the read position in the
+   background, so that the reads on the processor's thread are served from the
+   page cache. The window is re-armed when half of it has been consumed. */
+static void
+advise_readahead (fr_prc_t * ap_prc)
+{
+  uint64_t start = 0;
+  uint64_t end = 0;
+
+  assert (ap_prc);
+
+  if (0 == ap_prc->readahead_
+      || ap_prc->offset_ + ap_prc->readahead_ / 2 < ap_prc->readahead_end_)
+    {
+      return;
+    }
+
+  start = MAX (ap_prc->offset_, ap_prc->readahead_end_);
+  end = ap_prc->offset_ + ap_prc->readahead_;
+  if (ap_prc->p_map_)
+    {
+      const uint64_t page_mask = (uint64_t) sysconf (_SC_PAGESIZE) - 1;
+      end = MIN (end, ap_prc->file_size_);
+      start &= ~page_mask;
+      if (end > start)
+        {
+          (void) madvise (ap_prc->p_map_ + start, end - start, MADV_WILLNEED);
+        }
+    }
+  else
+    {
+      (void) posix_fadvise (fileno (ap_prc->p_file_), start, end - start,
+                            POSIX_FADV_WILLNEED);
+    }
+  ap_prc->readahead_end_ = end;
+}
+
+static int
+read_from_file (fr_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * p_hdr)
+{
+  assert (ap_prc);
+  assert (p_hdr);
+  if (ap_prc->p_map_)
+    {
+      const size_t nbytes
+        = MIN (p_hdr->nAllocLen, ap_prc->file_size_ - ap_prc->offset_);
+      memcpy (p_hdr->pBuffer, ap_prc->p_map_ + ap_prc->offset_, nbytes);
+      return nbytes;
+    }
+  return fread (p_hdr->pBuffer, 1, p_hdr->nAllocLen, ap_prc->p_file_);
+}
+
+static bool
+end_of_file (fr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  return (ap_prc->p_map_ ? ap_prc->offset_ >= ap_prc->file_size_
+                         : feof (ap_prc->p_file_));
+}
+
 static OMX_ERRORTYPE
 read_into_buffer (const void * ap_obj, OMX_BUFFERHEADERTYPE * p_hdr)
 {
@@ -138,10 +268,10 @@ read_into_buffer (const void * ap_obj, OMX_BUFFERHEADERTYPE * p_hdr)
   if (p_prc->p_file_ && !(p_prc->eos_))
     {
       int bytes_read = 0;
-      if (!(bytes_read
-            = fread (p_hdr->pBuffer, 1, p_hdr->nAllocLen, p_prc->p_file_)))
+      advise_readahead (p_prc);
+      if (!(bytes_read = read_from_file (p_prc, p_hdr)))
         {
-          if (feof (p_prc->p_file_))
+          if (end_of_file (p_prc))
             {
               TIZ_NOTICE (
                 handleOf (p_prc),
@@ -159,6 +289,7 @@ read_into_buffer (const void * ap_obj, OMX_BUFFERHEADERTYPE * p_hdr)
 
       p_hdr->nFilledLen = bytes_read;
       p_prc->counter_ += p_hdr->nFilledLen;
+      p_prc->offset_ += p_hdr->nFilledLen;
 
       TIZ_TRACE (handleOf (p_prc),
                  "Reading into HEADER [%p]...nFilledLen[%d] "
@@ -179,6 +310,9 @@ fr_prc_ctor (void * ap_obj, va_list * app)
   fr_prc_t * p_prc = super_ctor (typeOf (ap_obj, "frprc"), ap_obj, app);
   assert (p_prc);
   p_prc->p_file_ = NULL;
+  p_prc->p_map_ = NULL;
+  p_prc->file_size_ = 0;
+  p_prc->readahead_ = 0;
   p_prc->p_uri_param_ = NULL;
   reset_stream_parameters (p_prc);
   return p_prc;
@@ -214,6 +348,17 @@ fr_prc_allocate_resources (void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
       return OMX_ErrorInsufficientResources;
     }
 
+  if (mmap_requested (p_prc))
+    {
+      map_file (p_prc);
+    }
+  if (!p_prc->p_map_)
+    {
+      (void) posix_fadvise (fileno (p_prc->p_file_), 0, 0,
+                            POSIX_FADV_SEQUENTIAL);
+    }
+  p_prc->readahead_ = get_readahead_window (p_prc);
+
   return OMX_ErrorNone;
 }
 
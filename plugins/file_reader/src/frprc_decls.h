@@ -34,6 +34,7 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <tizprc_decls.h>
 
@@ -43,6 +44,11 @@ struct fr_prc
   /* Object */
   const tiz_prc_t _;
   FILE * p_file_;
+  uint8_t * p_map_;
+  uint64_t file_size_;
+  uint64_t offset_;
+  uint64_t readahead_;
+  uint64_t readahead_end_;
   OMX_PARAM_CONTENTURITYPE * p_uri_param_;
   OMX_U32 counter_;
   bool eos_;
@@ -52,12 +52,19 @@ extern "C" {
 #define ICE_INITIAL_BURST_SIZE 128000
 #define ICE_MAX_CLIENTS_PER_MOUNTPOINT 10
 #define ICE_DEFAULT_HEADER_TIMEOUT 10
-#define ICE_LISTEN_QUEUE 5
+#define ICE_LISTEN_QUEUE 64
 #define ICE_MIN_BURST_SIZE 1400
 #define ICE_MEDIUM_BURST_SIZE 2800 /* Not used for now */
 #define ICE_MAX_BURST_SIZE 4200    /* Not used for now */
 #define ICE_LISTENER_BUF_SIZE \
   (ICE_MAX_BURST_SIZE + OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE)
+#define ICE_RING_CHUNK_SIZE 4096
+#define ICE_RING_CHUNK_COUNT 256 /* 1 MiB, about a minute at 128 kbps */
+#define ICE_RING_SIZE (ICE_RING_CHUNK_SIZE * ICE_RING_CHUNK_COUNT)
+#define ICE_MAX_BYTES_PER_ROUND (64 * 1024)
+/* Metadata block, plus the ring chunks that a round may span */
+#define ICE_MAX_IOVECS (ICE_MAX_BYTES_PER_ROUND / ICE_RING_CHUNK_SIZE + 2)
+#define ICE_MAX_ZEROCOPY_SENDS 64
 
 #define ICE_SOCK_ERROR (int) -1
 
@@ -23,9 +23,12 @@
  *
  * @brief Tizonia - HTTP renderer's networking functions
  *
- * NOTE: This is work in progress!!!!
- *
- * TODO: Better flow control
+ * The encoded stream is copied once into a ring of fixed-size chunks that
+ * all connected listeners read from, each one at its own stream offset. A
+ * single server timer paces the rate at which OMX buffers are copied into
+ * the ring. Listeners whose socket send buffer fills up wait for an io event
+ * before they are sent any more data, and those that fall behind the oldest
+ * chunk still kept in the ring are dropped.
  *
  */
 
@@ -41,11 +44,15 @@
 #include <netinet/tcp.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netdb.h>
 #include <string.h>
 #include <errno.h>
 #include <time.h>
 #include <sys/ioctl.h>
+#ifdef __linux__
+#include <linux/errqueue.h>
+#endif
 
 #include <tizplatform.h>
 #include <tizutils.h>
@@ -60,6 +67,11 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.http_renderer.prc.net"
 #endif
 
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) \
+  && defined(SO_EE_CODE_ZEROCOPY_COPIED)
+#define HTTPR_HAVE_ZEROCOPY
+#endif
+
 #ifdef INET6_ADDRSTRLEN
 #define ICE_RENDERER_MAX_ADDR_LEN INET6_ADDRSTRLEN
 #else
@@ -70,15 +82,33 @@ typedef struct httpr_connection httpr_connection_t;
 typedef struct httpr_listener httpr_listener_t;
 typedef struct httpr_listener_buffer httpr_listener_buffer_t;
 typedef struct httpr_mount httpr_mount_t;
+typedef struct httpr_chunk httpr_chunk_t;
+typedef struct httpr_ring httpr_ring_t;
 
+/* Holds the HTTP request/response and, while streaming, the ICY metadata
+   block that is due next */
 struct httpr_listener_buffer
 {
   unsigned int len;
-  unsigned int metadata_offset;
-  unsigned int metadata_bytes;
+  unsigned int sent;
   char * p_data;
 };
 
+/* Chunk k of the stream holds the stream bytes [k * ICE_RING_CHUNK_SIZE, (k +
+   1) * ICE_RING_CHUNK_SIZE) and lives in slot k % ICE_RING_CHUNK_COUNT */
+struct httpr_chunk
+{
+  OMX_U8 data[ICE_RING_CHUNK_SIZE];
+  unsigned int refs; /* Number of listeners positioned in this slot */
+};
+
+struct httpr_ring
+{
+  httpr_chunk_t * p_chunks;
+  uint64_t head; /* Stream offset one past the last byte written */
+  uint64_t tail; /* Stream offset of the oldest byte still available */
+};
+
 struct httpr_mount
 {
   OMX_U8 mount_name[OMX_MAX_STRINGNAME_SIZE];
@@ -97,16 +127,12 @@ struct httpr_connection
   httpr_listener_t * p_lstnr;
   time_t con_time;
   uint64_t sent_total;
-  unsigned int sent_last;
-  unsigned int burst_bytes;
-  OMX_S32 initial_burst_bytes;
   bool metadata_delivered;
   int sockfd;
   char * p_host;
   char * p_ip;
   unsigned short port;
   tiz_event_io_t * p_ev_io;
-  tiz_event_timer_t * p_ev_timer;
 };
 
 struct httpr_listener
@@ -114,13 +140,23 @@ struct httpr_listener
   httpr_server_t * p_server;
   httpr_connection_t * p_con;
   int respcode;
-  long intro_offset;
-  unsigned long pos;
+  uint64_t pos;           /* Stream offset of the next byte to send */
+  uint64_t next_metadata; /* Value of sent_total at which the next metadata
+                             block is due */
   httpr_listener_buffer_t buf;
   tiz_http_parser_t * p_parser;
   bool need_response;
-  bool timer_started;
+  bool streaming; /* The request has been served and pos holds a ref on the
+                     ring */
+  bool blocked;   /* Waiting for the socket to become writable */
   bool want_metadata;
+  bool zerocopy; /* Audio is sent with MSG_ZEROCOPY */
+#ifdef HTTPR_HAVE_ZEROCOPY
+  uint32_t zc_sent; /* Zero-copy sends issued ... */
+  uint32_t zc_done; /* ... and those the kernel has notified as complete */
+  uint64_t zc_pos[ICE_MAX_ZEROCOPY_SENDS]; /* Stream offsets of the sends in
+                                              flight */
+#endif
 };
 
 struct httpr_server
@@ -129,9 +165,17 @@ struct httpr_server
   int lstn_sockfd;
   char * p_ip;
   tiz_event_io_t * p_srv_ev_io;
-  OMX_U32 max_clients; /* In future, more than one will be allowed;
-                          only one allowed at the moment. */
+  tiz_event_timer_t * p_ev_timer;
+  bool timer_started;
+  OMX_U32 max_clients;
   tiz_map_t * p_lstnrs;
+  OMX_U32 nstreaming;
+  httpr_ring_t ring;
+  OMX_S32 burst_credit; /* Bytes that may still be copied into the ring before
+                           the next timer tick */
+  bool zerocopy;
+  uint64_t bytes_sent;
+  uint64_t send_calls;
   OMX_BUFFERHEADERTYPE * p_hdr;
   httpr_srv_release_buffer_f pf_release_buf;
   httpr_srv_acquire_buffer_f pf_acquire_buf;
@@ -216,15 +260,54 @@ srv_get_listeners_count (const httpr_server_t * ap_server)
   return rc;
 }
 
-static httpr_listener_t *
-srv_get_first_listener (const httpr_server_t * ap_server)
+static inline httpr_listener_t *
+srv_get_listener_at (const httpr_server_t * ap_server, const int a_pos)
 {
-  httpr_listener_t * p_lstnr = NULL;
-  if (srv_get_listeners_count (ap_server) > 0)
-    {
-      p_lstnr = tiz_map_value_at (ap_server->p_lstnrs, 0);
-    }
-  return p_lstnr;
+  assert (ap_server);
+  assert (a_pos >= 0 && a_pos < srv_get_listeners_count (ap_server));
+  return tiz_map_value_at (ap_server->p_lstnrs, a_pos);
+}
+
+static OMX_ERRORTYPE
+ring_init (httpr_ring_t * ap_ring)
+{
+  assert (ap_ring);
+  ap_ring->p_chunks = (httpr_chunk_t *) tiz_mem_calloc (
+    ICE_RING_CHUNK_COUNT, sizeof (httpr_chunk_t));
+  ap_ring->head = 0;
+  ap_ring->tail = 0;
+  return ap_ring->p_chunks ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
+}
+
+static void
+ring_destroy (httpr_ring_t * ap_ring)
+{
+  assert (ap_ring);
+  tiz_mem_free (ap_ring->p_chunks);
+  ap_ring->p_chunks = NULL;
+}
+
+static inline httpr_chunk_t *
+ring_chunk (const httpr_ring_t * ap_ring, const uint64_t a_pos)
+{
+  assert (ap_ring);
+  assert (ap_ring->p_chunks);
+  return &(ap_ring->p_chunks[(a_pos / ICE_RING_CHUNK_SIZE)
+                             % ICE_RING_CHUNK_COUNT]);
+}
+
+/* Returns the number of contiguous bytes that can be read at a_pos */
+static inline size_t
+ring_peek (const httpr_ring_t * ap_ring, const uint64_t a_pos,
+           const OMX_U8 ** app_data)
+{
+  size_t offset = a_pos % ICE_RING_CHUNK_SIZE;
+  assert (ap_ring);
+  assert (app_data);
+  assert (a_pos >= ap_ring->tail);
+  assert (a_pos <= ap_ring->head);
+  *app_data = ring_chunk (ap_ring, a_pos)->data + offset;
+  return MIN (ICE_RING_CHUNK_SIZE - offset, ap_ring->head - a_pos);
 }
 
 static int
@@ -265,6 +348,29 @@ srv_set_nodelay (const int sock)
                      sizeof (int));
 }
 
+static inline int
+srv_set_zerocopy (const int sock)
+{
+#ifdef HTTPR_HAVE_ZEROCOPY
+  int zerocopy = 1;
+  errno = 0;
+  return setsockopt (sock, SOL_SOCKET, SO_ZEROCOPY, (void *) &zerocopy,
+                     sizeof (zerocopy));
+#else
+  errno = EOPNOTSUPP;
+  return ICE_SOCK_ERROR;
+#endif
+}
+
+static bool
+srv_zerocopy_requested (void)
+{
+  const char * p_zerocopy
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                            "OMX.Aratelia.audio_renderer.http.zerocopy");
+  return (p_zerocopy && 0 == strncmp (p_zerocopy, "true", 4));
+}
+
 static inline int
 srv_set_keepalive (const int sock)
 {
@@ -474,34 +580,29 @@ srv_stop_listener_io_watcher (httpr_listener_t * ap_lstnr)
 }
 
 static OMX_ERRORTYPE
-srv_start_listener_timer_watcher (httpr_listener_t * ap_lstnr,
-                                  const double a_wait_time)
+srv_start_timer_watcher (httpr_server_t * ap_server)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
-  assert (ap_lstnr);
-  if (!ap_lstnr->timer_started)
+  assert (ap_server);
+  if (!ap_server->timer_started)
     {
-      assert (ap_lstnr->p_server);
-      assert (ap_lstnr->p_con);
       tiz_check_omx (tiz_srv_timer_watcher_start (
-        ap_lstnr->p_server->p_parent, ap_lstnr->p_con->p_ev_timer, a_wait_time,
-        a_wait_time));
-      ap_lstnr->timer_started = true;
+        ap_server->p_parent, ap_server->p_ev_timer, ap_server->wait_time,
+        ap_server->wait_time));
+      ap_server->timer_started = true;
     }
   return rc;
 }
 
 static void
-srv_stop_listener_timer_watcher (httpr_listener_t * ap_lstnr)
+srv_stop_timer_watcher (httpr_server_t * ap_server)
 {
-  assert (ap_lstnr);
-  if (ap_lstnr->timer_started)
+  assert (ap_server);
+  if (ap_server->timer_started)
     {
-      assert (ap_lstnr->p_server);
-      assert (ap_lstnr->p_con);
-      (void) tiz_srv_timer_watcher_stop (ap_lstnr->p_server->p_parent,
-                                         ap_lstnr->p_con->p_ev_timer);
-      ap_lstnr->timer_started = false;
+      (void) tiz_srv_timer_watcher_stop (ap_server->p_parent,
+                                         ap_server->p_ev_timer);
+      ap_server->timer_started = false;
     }
 }
 
@@ -519,8 +620,6 @@ srv_destroy_connection (httpr_connection_t * ap_con)
       assert (ap_con->p_lstnr && ap_con->p_lstnr->p_server);
       tiz_srv_io_watcher_destroy (ap_con->p_lstnr->p_server->p_parent,
                                   ap_con->p_ev_io);
-      tiz_srv_timer_watcher_destroy (ap_con->p_lstnr->p_server->p_parent,
-                                     ap_con->p_ev_timer);
       tiz_mem_free (ap_con);
     }
 }
@@ -530,7 +629,6 @@ srv_destroy_listener (httpr_listener_t * ap_lstnr)
 {
   if (ap_lstnr)
     {
-      srv_stop_listener_timer_watcher (ap_lstnr);
       if (ap_lstnr->p_parser)
         {
           tiz_http_parser_destroy (ap_lstnr->p_parser);
@@ -552,6 +650,19 @@ srv_remove_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
   nlstnrs = srv_get_listeners_count (ap_server);
   assert (nlstnrs > 0);
 
+  if (ap_lstnr->streaming)
+    {
+      httpr_chunk_t * p_chunk = ring_chunk (&ap_server->ring, ap_lstnr->pos);
+      assert (p_chunk->refs > 0);
+      assert (ap_server->nstreaming > 0);
+      p_chunk->refs--;
+      ap_lstnr->streaming = false;
+      if (0 == --ap_server->nstreaming)
+        {
+          srv_stop_timer_watcher (ap_server);
+        }
+    }
+
   TIZ_LOG (TIZ_PRIORITY_TRACE,
            "Destroyed listener [%s] - [%d] listeners remaining",
            ap_lstnr->p_con->p_ip, nlstnrs - 1);
@@ -567,7 +678,7 @@ srv_remove_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
 static httpr_connection_t *
 srv_create_connection (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
                        const int connected_sockfd, char * ap_ip,
-                       const unsigned short ap_port, const double a_wait_time)
+                       const unsigned short ap_port)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   httpr_connection_t * p_con = NULL;
@@ -583,17 +694,14 @@ srv_create_connection (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
   goto_end_on_omx_error (rc, p_hdl, "Unable to alloc the connection struct");
 
   p_con->p_lstnr = ap_lstnr;
-  p_con->con_time = 0; /* time (NULL); */
+  p_con->con_time = 0;
   p_con->sent_total = 0;
-  p_con->sent_last = 0;
-  p_con->burst_bytes = 0;
-  p_con->initial_burst_bytes = ap_server->mountpoint.initial_burst_size;
+  p_con->metadata_delivered = false;
   p_con->sockfd = connected_sockfd;
   p_con->p_host = NULL;
   p_con->p_ip = ap_ip;
   p_con->port = ap_port;
   p_con->p_ev_io = NULL;
-  p_con->p_ev_timer = NULL;
 
   /* We are interested in knowing when a listener socket is available for
    * writing */
@@ -601,9 +709,6 @@ srv_create_connection (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
                                 p_con->sockfd, TIZ_EVENT_WRITE, true);
   goto_end_on_omx_error (rc, p_hdl, "Unable to init the client's io event");
 
-  rc = tiz_srv_timer_watcher_init (ap_server->p_parent, &(p_con->p_ev_timer));
-  goto_end_on_omx_error (rc, p_hdl, "Unable to init the client's timer event");
-
 end:
   if (OMX_ErrorNone != rc)
     {
@@ -636,22 +741,27 @@ srv_create_listener (httpr_server_t * ap_server, httpr_listener_t ** app_lstnr,
   goto_end_on_omx_error (rc, p_hdl, "Unable to alloc the listener structure");
 
   p_con = srv_create_connection (ap_server, p_lstnr, a_connected_sockfd, ap_ip,
-                                 ap_port, ap_server->wait_time);
+                                 ap_port);
   rc = p_con ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
   goto_end_on_omx_error (rc, p_hdl, "Unable to init the listener's connection");
 
   p_lstnr->p_server = ap_server;
   p_lstnr->p_con = p_con;
   p_lstnr->respcode = 200;
-  p_lstnr->intro_offset = 0;
   p_lstnr->pos = 0;
+  p_lstnr->next_metadata = 0;
   p_lstnr->buf.len = ICE_LISTENER_BUF_SIZE;
-  p_lstnr->buf.metadata_offset = 0;
-  p_lstnr->buf.metadata_bytes = 0;
+  p_lstnr->buf.sent = 0;
   p_lstnr->p_parser = NULL;
   p_lstnr->need_response = true;
-  p_lstnr->timer_started = false;
+  p_lstnr->streaming = false;
+  p_lstnr->blocked = false;
   p_lstnr->want_metadata = false;
+  p_lstnr->zerocopy = false;
+#ifdef HTTPR_HAVE_ZEROCOPY
+  p_lstnr->zc_sent = 0;
+  p_lstnr->zc_done = 0;
+#endif
 
   p_lstnr->buf.p_data = (char *) tiz_mem_alloc (ICE_LISTENER_BUF_SIZE);
   rc = p_lstnr->buf.p_data ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
@@ -669,6 +779,17 @@ srv_create_listener (httpr_server_t * ap_server, httpr_listener_t ** app_lstnr,
   rc = sockrc < 0 ? OMX_ErrorInsufficientResources : OMX_ErrorNone;
   goto_end_on_socket_error (sockrc, p_hdl, strerror (errno));
 
+  if (ap_server->zerocopy)
+    {
+      /* Not fatal; the listener is simply served with regular sends */
+      p_lstnr->zerocopy = (srv_set_zerocopy (p_lstnr->p_con->sockfd) >= 0);
+      if (!p_lstnr->zerocopy)
+        {
+          TIZ_NOTICE (p_hdl, "SO_ZEROCOPY not available : %s",
+                      strerror (errno));
+        }
+    }
+
   rc = OMX_ErrorNone;
 
 end:
@@ -964,7 +1085,7 @@ srv_handle_listeners_request (httpr_server_t * ap_server,
       && (0 == strncmp ("1", parsed_string, strlen ("1"))))
     {
       TIZ_TRACE (handleOf (ap_server->p_parent), "ICY metadata requested");
-      ap_lstnr->want_metadata = true;
+      ap_lstnr->want_metadata = (ap_server->mountpoint.metadata_period > 0);
     }
 
   /* The request seems ok. Now build the response */
@@ -990,41 +1111,274 @@ end:
   return rc;
 }
 
+static void
+srv_release_empty_buffer (httpr_server_t * ap_server)
+{
+  assert (ap_server);
+  assert (ap_server->p_hdr);
+  ap_server->p_hdr->nFilledLen = 0;
+  ap_server->pf_release_buf (ap_server->p_hdr, ap_server->p_arg);
+  ap_server->p_hdr = NULL;
+}
+
 static OMX_S32
-srv_remove_existing_listener (OMX_PTR ap_key, OMX_PTR ap_value, OMX_PTR ap_arg)
+srv_max_burst_credit (const httpr_server_t * ap_server)
 {
-  httpr_server_t * p_server = ap_arg;
-  httpr_listener_t * p_lstnr = NULL;
+  /* The producer must never lap a listener that has just been started */
+  const OMX_U32 max_burst = MIN (ap_server->mountpoint.initial_burst_size,
+                                 ICE_RING_SIZE / 2);
+  return (OMX_S32) MAX (max_burst, ap_server->burst_size);
+}
 
-  assert (p_server);
-  assert (ap_key);
-  assert (ap_value);
+static void
+srv_add_burst_credit (httpr_server_t * ap_server, const OMX_U32 a_nbytes)
+{
+  assert (ap_server);
+  ap_server->burst_credit
+    = MIN (ap_server->burst_credit + (OMX_S32) a_nbytes,
+           srv_max_burst_credit (ap_server));
+}
+
+#ifdef HTTPR_HAVE_ZEROCOPY
+/* Collects the notifications of MSG_ZEROCOPY sends that the kernel is done
+   with. NOTE: Notifications normally arrive in order; they are treated as if
+   they always did. */
+static void
+srv_reap_zerocopy_sends (httpr_listener_t * ap_lstnr)
+{
+  assert (ap_lstnr);
+  while (ap_lstnr->zc_done != ap_lstnr->zc_sent)
+    {
+      char control[CMSG_SPACE (sizeof (struct sock_extended_err))];
+      struct msghdr msg;
+      struct cmsghdr * p_cm = NULL;
+      struct sock_extended_err * p_serr = NULL;
+
+      tiz_mem_set (&msg, 0, sizeof (msg));
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof (control);
+
+      if (recvmsg (ap_lstnr->p_con->sockfd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT)
+            < 0
+          || NULL == (p_cm = CMSG_FIRSTHDR (&msg)))
+        {
+          break;
+        }
 
-  p_lstnr = (httpr_listener_t *) ap_value;
+      p_serr = (struct sock_extended_err *) CMSG_DATA (p_cm);
+      if (0 != p_serr->ee_errno || SO_EE_ORIGIN_ZEROCOPY != p_serr->ee_origin)
+        {
+          continue;
+        }
 
-  srv_remove_listener (p_server, p_lstnr);
+      /* The notification covers sends [ee_info, ee_data] */
+      if ((int32_t) (p_serr->ee_data + 1 - ap_lstnr->zc_done) > 0)
+        {
+          ap_lstnr->zc_done = p_serr->ee_data + 1;
+        }
 
-  return 0;
+      if (p_serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+        {
+          /* The kernel had to copy the data anyway (e.g. on loopback), so
+             there is nothing to gain with this listener */
+          ap_lstnr->zerocopy = false;
+        }
+    }
 }
+#endif
 
-inline static void
-srv_release_empty_buffer (httpr_server_t * ap_server,
-                          httpr_listener_t * ap_lstnr,
-                          OMX_BUFFERHEADERTYPE ** app_hdr)
+/* The oldest stream offset that this listener may still need; with
+   MSG_ZEROCOPY, the kernel reads from the ring until it notifies the
+   completion of a send */
+static inline uint64_t
+srv_get_oldest_offset (httpr_listener_t * ap_lstnr)
 {
-  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+  assert (ap_lstnr);
+#ifdef HTTPR_HAVE_ZEROCOPY
+  srv_reap_zerocopy_sends (ap_lstnr);
+  if (ap_lstnr->zc_done != ap_lstnr->zc_sent)
+    {
+      return ap_lstnr->zc_pos[ap_lstnr->zc_done % ICE_MAX_ZEROCOPY_SENDS];
+    }
+#endif
+  return ap_lstnr->pos;
+}
+
+static void
+srv_drop_slow_listeners (httpr_server_t * ap_server)
+{
+  int i = 0;
+  assert (ap_server);
+
+  /* Walk the map backwards, so that removing a listener does not change the
+     position of those yet to be visited */
+  for (i = srv_get_listeners_count (ap_server) - 1; i >= 0; --i)
+    {
+      httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, i);
+      assert (p_lstnr);
+      if (p_lstnr->streaming
+          && srv_get_oldest_offset (p_lstnr) < ap_server->ring.tail)
+        {
+          TIZ_NOTICE (handleOf (ap_server->p_parent),
+                      "Dropping slow client [%s:%u] fd [%d] - [%llu] bytes "
+                      "behind",
+                      p_lstnr->p_con->p_ip, p_lstnr->p_con->port,
+                      p_lstnr->p_con->sockfd,
+                      (unsigned long long) (ap_server->ring.head
+                                            - p_lstnr->pos));
+          srv_remove_listener (ap_server, p_lstnr);
+        }
+    }
+}
+
+/* Called before the first byte of a new chunk is written. When the ring is
+   full, the slot about to be reused holds the oldest chunk, which is lost. */
+static void
+srv_reclaim_chunk (httpr_server_t * ap_server)
+{
+  httpr_ring_t * p_ring = NULL;
+
+  assert (ap_server);
+  p_ring = &ap_server->ring;
+  assert (0 == p_ring->head % ICE_RING_CHUNK_SIZE);
+
+  if (p_ring->head >= ICE_RING_SIZE)
+    {
+      p_ring->tail = p_ring->head - ICE_RING_SIZE + ICE_RING_CHUNK_SIZE;
+      /* NOTE: A listener that has caught up with the head holds a ref on this
+         same slot, so a non-zero count only tells that someone might still
+         need the old chunk. Zero-copy sends in flight hold no refs, so
+         every listener is checked when they are enabled. */
+      if (ring_chunk (p_ring, p_ring->head)->refs > 0 || ap_server->zerocopy)
+        {
+          srv_drop_slow_listeners (ap_server);
+        }
+    }
+}
+
+static void
+srv_fill_ring (httpr_server_t * ap_server)
+{
+  httpr_ring_t * p_ring = NULL;
+
+  assert (ap_server);
+  p_ring = &ap_server->ring;
+
+  while (ap_server->burst_credit > 0)
+    {
+      OMX_BUFFERHEADERTYPE * p_hdr = ap_server->p_hdr;
+
+      if (NULL == p_hdr)
+        {
+          if (NULL == (p_hdr = ap_server->pf_acquire_buf (ap_server->p_arg)))
+            {
+              /* no more buffers available at the moment */
+              ap_server->need_more_data = true;
+              break;
+            }
+          ap_server->need_more_data = false;
+          ap_server->p_hdr = p_hdr;
+        }
+
+      if (p_hdr->nFilledLen > 0)
+        {
+          const size_t offset = p_ring->head % ICE_RING_CHUNK_SIZE;
+          size_t to_copy = 0;
+
+          if (0 == offset)
+            {
+              srv_reclaim_chunk (ap_server);
+            }
+
+          to_copy = MIN (ICE_RING_CHUNK_SIZE - offset, p_hdr->nFilledLen);
+          to_copy = MIN (to_copy, (size_t) ap_server->burst_credit);
+          memcpy (ring_chunk (p_ring, p_ring->head)->data + offset,
+                  p_hdr->pBuffer + p_hdr->nOffset, to_copy);
+          p_ring->head += to_copy;
+          p_hdr->nOffset += to_copy;
+          p_hdr->nFilledLen -= to_copy;
+          ap_server->burst_credit -= (OMX_S32) to_copy;
+        }
+
+      if (0 == p_hdr->nFilledLen)
+        {
+          /* Buffer emptied */
+          srv_release_empty_buffer (ap_server);
+        }
+    }
+}
+
+static OMX_ERRORTYPE
+srv_start_streaming (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+{
+  httpr_ring_t * p_ring = NULL;
+  uint64_t start = 0;
 
   assert (ap_server);
   assert (ap_lstnr);
-  assert (app_hdr);
+  assert (!ap_lstnr->streaming);
+  p_ring = &ap_server->ring;
 
-  p_hdr = *app_hdr;
+  if (0 == ap_server->nstreaming)
+    {
+      /* Whatever is in the ring is stale. Start at the head, and let the
+         initial burst be copied into the ring right away. */
+      start = p_ring->head;
+      ap_server->burst_credit = srv_max_burst_credit (ap_server);
+    }
+  else
+    {
+      /* The initial burst is served from the ring's history */
+      const uint64_t burst = MIN (ap_server->mountpoint.initial_burst_size,
+                                  ICE_RING_SIZE / 2);
+      start = p_ring->head > burst ? p_ring->head - burst : 0;
+      start = MAX (start, p_ring->tail);
+    }
 
-  ap_lstnr->pos = 0;
-  p_hdr->nFilledLen = 0;
-  ap_server->pf_release_buf (p_hdr, ap_server->p_arg);
-  *app_hdr = NULL;
-  ap_server->p_hdr = NULL;
+  ap_lstnr->pos = start;
+  ring_chunk (p_ring, start)->refs++;
+  ap_lstnr->streaming = true;
+  ap_lstnr->next_metadata = ap_server->mountpoint.metadata_period;
+  ap_lstnr->p_con->con_time = time (NULL);
+  ap_server->nstreaming++;
+
+  TIZ_TRACE (handleOf (ap_server->p_parent),
+             "Client [%s:%u] streaming from offset [%llu] - [%u] streaming",
+             ap_lstnr->p_con->p_ip, ap_lstnr->p_con->port,
+             (unsigned long long) start, ap_server->nstreaming);
+
+  return srv_start_timer_watcher (ap_server);
+}
+
+static inline void
+srv_advance_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
+                      const size_t a_nbytes)
+{
+  httpr_chunk_t * p_old = NULL;
+  httpr_chunk_t * p_new = NULL;
+
+  assert (ap_server);
+  assert (ap_lstnr);
+  assert (ap_lstnr->pos + a_nbytes <= ap_server->ring.head);
+
+  p_old = ring_chunk (&ap_server->ring, ap_lstnr->pos);
+  ap_lstnr->pos += a_nbytes;
+  ap_lstnr->p_con->sent_total += a_nbytes;
+  p_new = ring_chunk (&ap_server->ring, ap_lstnr->pos);
+  if (p_new != p_old)
+    {
+      assert (p_old->refs > 0);
+      p_old->refs--;
+      p_new->refs++;
+    }
+}
+
+static void
+srv_block_listener (httpr_listener_t * ap_lstnr)
+{
+  assert (ap_lstnr);
+  (void) srv_start_listener_io_watcher (ap_lstnr);
+  ap_lstnr->blocked = true;
 }
 
 static bool
@@ -1057,202 +1411,116 @@ srv_is_listener_ready (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
             }
           lstnr_ready = false;
         }
+      else if (OMX_ErrorNone != (rc = srv_start_streaming (ap_server, ap_lstnr)))
+        {
+          TIZ_ERROR (p_hdl, "[%s] : while starting to stream",
+                     tiz_err_to_str (rc));
+          srv_remove_listener (ap_server, ap_lstnr);
+          lstnr_ready = false;
+        }
     }
   return lstnr_ready;
 }
 
 static inline bool
-srv_is_time_to_send_metadata (httpr_server_t * ap_server,
-                              httpr_listener_t * ap_lstnr)
+srv_is_time_to_send_metadata (const httpr_server_t * ap_server,
+                              const httpr_listener_t * ap_lstnr)
 {
-  if (ap_lstnr->p_con->sent_total == 0)
-    {
-      return false;
-    }
-
-  if (((ap_lstnr->p_con->sent_total + ap_server->burst_size)
-       % ap_server->mountpoint.metadata_period)
-      <= ap_server->burst_size)
-    {
-      return true;
-    }
-
-  return false;
-}
-
-static inline size_t
-srv_get_metadata_offset (const httpr_server_t * ap_server,
-                         const httpr_listener_t * ap_lstnr)
-{
-  size_t offset = 0;
-  if (ap_lstnr->p_con->sent_total != 0)
-    {
-      offset = (ap_server->mountpoint.metadata_period
-                * ((ap_lstnr->p_con->sent_total + ap_server->burst_size)
-                   / ap_server->mountpoint.metadata_period))
-               - ap_lstnr->p_con->sent_total;
-    }
-
-  return offset;
-}
-
-static inline size_t
-srv_get_metadata_length (const httpr_server_t * ap_server,
-                         const httpr_listener_t * ap_lstnr)
-{
-  if (ap_lstnr->p_con->sent_total == 0 || ap_lstnr->p_con->metadata_delivered)
-    {
-      return 0;
-    }
-
-  return strnlen ((char *) ap_server->mountpoint.stream_title,
-                  OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
-}
-
-static void
-srv_arrange_metadata (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
-                      OMX_U8 ** app_buffer, size_t * ap_len)
-{
-  size_t len = 0;
-  httpr_listener_buffer_t * p_lstnr_buf = NULL;
-
   assert (ap_server);
   assert (ap_lstnr);
-  assert (app_buffer);
-  assert (ap_len);
-
-  len = *ap_len;
-  p_lstnr_buf = &ap_lstnr->buf;
-
-  if (0 == len || !ap_lstnr->want_metadata
-      || 0 == ap_server->mountpoint.metadata_period
-      || !srv_is_time_to_send_metadata (ap_server, ap_lstnr))
-    {
-      /* p_lstnr_buf->metadata_bytes = 0; */
-      return;
-    }
-
-  {
-    OMX_U8 * p_buffer = *app_buffer;
-    size_t metadata_offset = srv_get_metadata_offset (ap_server, ap_lstnr);
-
-    if (metadata_offset < len && 0 == p_lstnr_buf->metadata_bytes)
-      {
-        OMX_U8 * p_dest = NULL;
-        OMX_U8 * p_src = NULL;
-        size_t metadata_len = srv_get_metadata_length (ap_server, ap_lstnr);
-        size_t metadata_total = 0;
-        size_t metadata_byte = 0;
-
-        if (metadata_len > 0)
-          {
-            metadata_byte = metadata_len / 16;
-            if (metadata_len % 16)
-              {
-                metadata_byte++;
-              }
-          }
-        else
-          {
-            metadata_byte = 0;
-          }
-
-        metadata_total = (metadata_byte * 16) + 1;
-        p_dest = p_buffer + metadata_offset + metadata_total;
-        p_src = p_buffer + metadata_offset;
-
-        /* Move content to make space for the metadata */
-        memmove (p_dest, p_src, len - metadata_offset);
-
-        p_lstnr_buf->metadata_bytes += metadata_total;
-        p_lstnr_buf->metadata_offset += metadata_offset;
-
-        if (metadata_len)
-          {
-            snprintf ((char *) p_src, metadata_total, "%c%s",
-                      (int) metadata_byte,
-                      (char *) ap_server->mountpoint.stream_title);
-            ap_lstnr->p_con->metadata_delivered = true;
-          }
-        else
-          {
-            p_src[0] = metadata_byte;
-          }
-
-        len += metadata_total;
-        p_lstnr_buf->len = len;
-
-        *ap_len = len;
-        *app_buffer = p_buffer;
-      }
-  }
+  return (ap_lstnr->want_metadata
+          && ap_lstnr->p_con->sent_total == ap_lstnr->next_metadata);
 }
 
+/* Prepares the ICY metadata block that is due next: a length byte (in 16-byte
+   units) followed by the padded stream title. The title is sent once after it
+   changes; the rest of the blocks are empty. */
 static void
-srv_arrange_data (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
-                  OMX_U8 ** app_buffer, size_t * ap_len)
+srv_arrange_metadata (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
 {
-  OMX_U8 * p_buffer = NULL;
-  size_t len = 0;
-  httpr_listener_buffer_t * p_lstnr_buf = NULL;
-  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+  httpr_listener_buffer_t * p_buf = NULL;
+  size_t title_len = 0;
+  size_t nblocks = 0;
 
   assert (ap_server);
   assert (ap_lstnr);
-  assert (app_buffer);
-  assert (ap_len);
+  assert (ap_server->mountpoint.metadata_period > 0);
 
-  p_lstnr_buf = &ap_lstnr->buf;
-  p_hdr = ap_server->p_hdr;
+  p_buf = &ap_lstnr->buf;
+  assert (0 == p_buf->len);
 
-  if (p_hdr && p_hdr->pBuffer && p_hdr->nFilledLen > 0)
+  if (!ap_lstnr->p_con->metadata_delivered)
     {
-      int to_copy = 0;
-      if (ap_server->burst_size > p_lstnr_buf->len)
-        {
-          to_copy = ap_server->burst_size - p_lstnr_buf->len;
-        }
-      if (to_copy > p_hdr->nFilledLen)
-        {
-          to_copy = p_hdr->nFilledLen;
-        }
-      memcpy (p_lstnr_buf->p_data + p_lstnr_buf->len,
-              p_hdr->pBuffer + p_hdr->nOffset, to_copy);
-      p_lstnr_buf->len += to_copy;
-      p_hdr->nFilledLen -= to_copy;
-      p_hdr->nOffset += to_copy;
+      title_len = strnlen ((char *) ap_server->mountpoint.stream_title,
+                           OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
+      ap_lstnr->p_con->metadata_delivered = (title_len > 0);
     }
 
-  p_buffer = (OMX_U8 *) p_lstnr_buf->p_data;
-  len = p_lstnr_buf->len;
+  nblocks = (title_len + 15) / 16;
+  p_buf->len = 1 + nblocks * 16;
+  p_buf->sent = 0;
+  assert (p_buf->len <= ICE_LISTENER_BUF_SIZE);
 
-  srv_arrange_metadata (ap_server, ap_lstnr, &p_buffer, &len);
+  tiz_mem_set (p_buf->p_data, 0, p_buf->len);
+  p_buf->p_data[0] = (char) nblocks;
+  memcpy (p_buf->p_data + 1, ap_server->mountpoint.stream_title, title_len);
 
-  *ap_len = len;
-  *app_buffer = p_buffer;
+  ap_lstnr->next_metadata += ap_server->mountpoint.metadata_period;
 }
 
 static OMX_ERRORTYPE
 srv_write_to_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
-                       const void * ap_buffer, const size_t a_buf_len,
-                       int * a_bytes_written)
+                       const struct iovec * ap_iov, const int a_iovcnt,
+                       const bool a_zerocopy, int * a_bytes_written)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
-  int bytes = 0;
+  ssize_t bytes = 0;
   httpr_connection_t * p_con = NULL;
   int sock = ICE_SOCK_ERROR;
+  int flags = MSG_NOSIGNAL;
+  struct msghdr msg;
 
   assert (ap_server);
   assert (ap_lstnr);
-  assert (ap_buffer);
+  assert (ap_iov);
+  assert (a_iovcnt > 0);
   assert (a_bytes_written);
 
   p_con = ap_lstnr->p_con;
   sock = p_con->sockfd;
   *a_bytes_written = 0;
+
+  tiz_mem_set (&msg, 0, sizeof (msg));
+  msg.msg_iov = (struct iovec *) ap_iov;
+  msg.msg_iovlen = a_iovcnt;
+
+#ifdef HTTPR_HAVE_ZEROCOPY
+  if (a_zerocopy)
+    {
+      flags |= MSG_ZEROCOPY;
+    }
+#endif
+
   errno = 0;
+  bytes = sendmsg (sock, &msg, flags);
+  ap_server->send_calls++;
 
-  bytes = send (sock, (const void *) ap_buffer, a_buf_len, MSG_NOSIGNAL);
+#ifdef HTTPR_HAVE_ZEROCOPY
+  if (bytes < 0 && a_zerocopy && ENOBUFS == errno)
+    {
+      /* Out of memory for pinned pages; copy this time */
+      flags &= ~MSG_ZEROCOPY;
+      errno = 0;
+      bytes = sendmsg (sock, &msg, flags);
+      ap_server->send_calls++;
+    }
+  if (bytes > 0 && (flags & MSG_ZEROCOPY))
+    {
+      ap_lstnr->zc_pos[ap_lstnr->zc_sent % ICE_MAX_ZEROCOPY_SENDS]
+        = ap_lstnr->pos;
+      ap_lstnr->zc_sent++;
+    }
+#endif
 
   if (bytes < 0)
     {
@@ -1269,136 +1537,124 @@ srv_write_to_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
           TIZ_PRINTF_DBG_RED (
             "Recoverable error while writing to the socket"
             "(re-starting io watcher)\n");
-          (void) srv_start_listener_io_watcher (ap_lstnr);
-          srv_stop_listener_timer_watcher (ap_lstnr);
+          srv_block_listener (ap_lstnr);
           rc = OMX_ErrorNotReady;
         }
     }
   else
     {
-      *a_bytes_written = bytes;
+      ap_server->bytes_sent += bytes;
+      *a_bytes_written = (int) bytes;
     }
   return rc;
 }
 
+/* Sends the listener as much as it will take of what it has not seen yet,
+   up to ICE_MAX_BYTES_PER_ROUND, so that no listener can starve the rest.
+   Each call to sendmsg gathers the pending ICY metadata block, if any, and
+   the audio that follows it, straight from the ring's chunks. */
 static OMX_ERRORTYPE
-srv_write_omx_buffer (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+srv_write_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
-  httpr_connection_t * p_con = NULL;
-  int sock = ICE_SOCK_ERROR;
+  httpr_listener_buffer_t * p_buf = NULL;
+  size_t budget = ICE_MAX_BYTES_PER_ROUND;
 
   assert (ap_server);
   assert (ap_lstnr);
-  assert (ap_lstnr->p_con);
+  assert (ap_lstnr->streaming);
+  assert (!ap_lstnr->blocked);
 
-  p_con = ap_lstnr->p_con;
-  sock = p_con->sockfd;
-
-  p_con->sent_last = 0;
+  p_buf = &ap_lstnr->buf;
 
-  if (!srv_is_valid_socket (sock))
+  while (OMX_ErrorNone == rc && budget > 0)
     {
-      TIZ_WARN (handleOf (ap_server->p_parent),
-                "Will destroy listener "
-                "(Invalid listener socket fd [%d])",
-                sock);
-      /* The socket is not valid anymore. The listener will be removed. */
-      rc = OMX_ErrorNoMore;
-    }
-  else
-    {
-      httpr_listener_buffer_t * p_lstnr_buf = &ap_lstnr->buf;
-      OMX_U8 * p_buffer = NULL;
-      size_t len = 0;
+      struct iovec iov[ICE_MAX_IOVECS];
+      int iovcnt = 0;
+      size_t metadata_len = 0;
+      size_t audio_len = 0;
+      size_t audio_max = budget;
+      size_t audio_sent = 0;
+      bool zerocopy = false;
       int bytes = 0;
 
-      /* Obtain a pointer to the data and the amount of data to be written */
-      srv_arrange_data (ap_server, ap_lstnr, &p_buffer, &len);
+      if (0 == p_buf->len && srv_is_time_to_send_metadata (ap_server, ap_lstnr))
+        {
+          srv_arrange_metadata (ap_server, ap_lstnr);
+        }
 
-      if (len > 0)
+      if (p_buf->len > 0)
         {
-          int metadata_sent = 0;
-          tiz_check_omx (
-            srv_write_to_listener (ap_server, ap_lstnr, p_buffer, len, &bytes));
-          assert (bytes >= 0);
+          metadata_len = p_buf->len - p_buf->sent;
+          iov[iovcnt].iov_base = p_buf->p_data + p_buf->sent;
+          iov[iovcnt].iov_len = metadata_len;
+          iovcnt++;
+        }
 
-          p_lstnr_buf->len
-            = bytes > p_lstnr_buf->len ? 0 : (p_lstnr_buf->len - bytes);
+      if (ap_lstnr->want_metadata)
+        {
+          /* No further than the next metadata block */
+          audio_max = MIN (audio_max, ap_lstnr->next_metadata
+                                        - ap_lstnr->p_con->sent_total);
+        }
 
-          if (p_lstnr_buf->len > 0)
+      while (iovcnt < ICE_MAX_IOVECS && audio_len < audio_max)
+        {
+          const OMX_U8 * p_data = NULL;
+          size_t len = ring_peek (&ap_server->ring, ap_lstnr->pos + audio_len,
+                                  &p_data);
+          if (0 == len)
             {
-              memmove (p_lstnr_buf->p_data, p_lstnr_buf->p_data + bytes,
-                       p_lstnr_buf->len);
+              break;
             }
+          len = MIN (len, audio_max - audio_len);
+          iov[iovcnt].iov_base = (void *) p_data;
+          iov[iovcnt].iov_len = len;
+          iovcnt++;
+          audio_len += len;
+        }
 
-          if (bytes > p_lstnr_buf->metadata_offset)
-            {
-              metadata_sent = MIN ((bytes - p_lstnr_buf->metadata_offset),
-                                   p_lstnr_buf->metadata_bytes);
-            }
+      if (0 == metadata_len + audio_len)
+        {
+          /* This listener has caught up with the ring's head */
+          break;
+        }
 
-          if (p_con->initial_burst_bytes > 0)
-            {
-              p_con->initial_burst_bytes -= (bytes - metadata_sent);
-            }
-          else
-            {
-              if (p_con->con_time == 0)
-                {
-                  p_con->con_time = time (NULL);
-                }
-            }
+#ifdef HTTPR_HAVE_ZEROCOPY
+      /* The metadata block gets rewritten, so it is never sent with
+         MSG_ZEROCOPY */
+      zerocopy = (ap_lstnr->zerocopy && 0 == metadata_len
+                  && (ap_lstnr->zc_sent - ap_lstnr->zc_done)
+                       < ICE_MAX_ZEROCOPY_SENDS);
+#endif
 
-          p_con->sent_total += (bytes - metadata_sent);
-          p_con->sent_last = (bytes - metadata_sent);
-          p_con->burst_bytes += (bytes - metadata_sent);
-
-          {
-            time_t t = time (NULL);
-            double d = difftime (t, p_con->con_time);
-            uint64_t rate = d ? p_con->sent_total / (uint64_t) d : 0;
-            TIZ_PRINTF_DBG_BLU (
-              "total [%lld] last [%d] burst [%d] time [%f] rate [%lld] "
-              "server burst [%d] bytes [%d]\n",
-              p_con->sent_total, p_con->sent_last, p_con->burst_bytes, d, rate,
-              ap_server->burst_size, bytes);
-          }
-
-          TIZ_PRINTF_DBG_GRN (
-            "metadata_bytes [%u] < metadata_offset [%u] metadata_sent [%u]\n",
-            p_lstnr_buf->metadata_bytes, p_lstnr_buf->metadata_offset,
-            metadata_sent);
-
-          p_lstnr_buf->metadata_bytes -= metadata_sent;
-          if (p_lstnr_buf->metadata_offset > 0 && p_lstnr_buf->metadata_bytes)
-            {
-              p_lstnr_buf->metadata_offset -= ((unsigned int) bytes);
-            }
-          else
-            {
-              p_lstnr_buf->metadata_offset = 0;
-            }
+      rc = srv_write_to_listener (ap_server, ap_lstnr, iov, iovcnt, zerocopy,
+                                  &bytes);
+      assert (bytes >= 0);
 
-          if (bytes < len)
-            {
-              TIZ_PRINTF_DBG_RED (
-                "NEED TO STOP bytes [%d] < len [%u] p_lstnr_buf->len [%u]\n",
-                bytes, len, p_lstnr_buf->len);
-              (void) srv_start_listener_io_watcher (ap_lstnr);
-              srv_stop_listener_timer_watcher (ap_lstnr);
-              rc = OMX_ErrorNotReady;
-            }
-          else
+      if (metadata_len > 0)
+        {
+          p_buf->sent += MIN ((size_t) bytes, metadata_len);
+          if (p_buf->sent == p_buf->len)
             {
-              if ((p_con->initial_burst_bytes <= 0)
-                  && (p_con->burst_bytes >= ap_server->burst_size))
-                {
-                  rc = srv_start_listener_timer_watcher (ap_lstnr,
-                                                         ap_server->wait_time);
-                }
+              p_buf->len = 0;
+              p_buf->sent = 0;
             }
         }
+
+      if ((size_t) bytes > metadata_len)
+        {
+          audio_sent = bytes - metadata_len;
+          srv_advance_listener (ap_server, ap_lstnr, audio_sent);
+          budget -= audio_sent;
+        }
+
+      if (OMX_ErrorNone == rc && (size_t) bytes < metadata_len + audio_len)
+        {
+          /* The socket's send buffer is full */
+          srv_block_listener (ap_lstnr);
+          rc = OMX_ErrorNotReady;
+        }
     }
 
   return rc;
@@ -1418,14 +1674,6 @@ srv_accept_connection (httpr_server_t * ap_server)
   assert (ap_server);
   p_hdl = handleOf (ap_server->p_parent);
 
-  if (srv_get_listeners_count (ap_server) > 0)
-    {
-      /* This is a simple solution to prevent more than one connection at
-       * a time. One day this could be a multi-client renderer */
-      tiz_map_for_each (ap_server->p_lstnrs, srv_remove_existing_listener,
-                        ap_server);
-    }
-
   if ((p_ip = (char *) tiz_mem_alloc (ICE_RENDERER_MAX_ADDR_LEN)))
     {
       unsigned short port = 0;
@@ -1486,8 +1734,9 @@ end:
     }
   else
     {
-      TIZ_NOTICE (p_hdl, "Client [%s:%u] fd [%d] now connected", p_con->p_ip,
-                  p_con->port, p_con->sockfd);
+      TIZ_NOTICE (p_hdl, "Client [%s:%u] fd [%d] now connected - [%d] clients",
+                  p_con->p_ip, p_con->port, p_con->sockfd,
+                  srv_get_listeners_count (ap_server));
 
       TIZ_PRINTF_DBG_RED ("Client connected [%s:%u]\n", p_con->p_ip,
                           p_con->port);
@@ -1495,7 +1744,7 @@ end:
         "\tburst [%d] sample rate [%u] bitrate [%u] "
         "burst_size [%u] bytes per frame [%u] wait_time [%f] "
         "pkts/s [%f].\n",
-        (unsigned int) p_con->initial_burst_bytes,
+        (unsigned int) ap_server->mountpoint.initial_burst_size,
         (unsigned int) ap_server->sample_rate,
         (unsigned int) ap_server->bitrate, (unsigned int) ap_server->burst_size,
         (unsigned int) ap_server->bytes_per_frame, ap_server->wait_time,
@@ -1511,77 +1760,64 @@ end:
 static OMX_ERRORTYPE
 srv_write (httpr_server_t * ap_server)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
-  httpr_listener_t * p_lstnr = NULL;
-  httpr_connection_t * p_con = NULL;
+  int i = 0;
 
   assert (ap_server);
 
-  if (srv_get_listeners_count (ap_server) <= 0)
+  if (0 == ap_server->nstreaming)
     {
       return OMX_ErrorNoMore;
     }
 
-  /* Until support for multiple listeners gets implemented, there will only be
-     one listener in the map */
-  p_lstnr = srv_get_first_listener (ap_server);
-  assert (p_lstnr);
-  p_con = p_lstnr->p_con;
-  assert (p_con);
+  srv_fill_ring (ap_server);
 
-  srv_stop_listener_io_watcher (p_lstnr);
-  if (!srv_is_listener_ready (ap_server, p_lstnr))
+  /* Walk the map backwards, so that removing a listener does not change the
+     position of those yet to be visited */
+  for (i = srv_get_listeners_count (ap_server) - 1; i >= 0; --i)
     {
-      return OMX_ErrorNotReady;
+      httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, i);
+      assert (p_lstnr);
+      if (p_lstnr->streaming && !p_lstnr->blocked
+          && OMX_ErrorNoMore == srv_write_listener (ap_server, p_lstnr))
+        {
+          srv_remove_listener (ap_server, p_lstnr);
+        }
     }
 
-  srv_start_listener_timer_watcher (p_lstnr, ap_server->wait_time);
+  return OMX_ErrorNone;
+}
 
-  if (p_con->initial_burst_bytes <= 0)
-    {
-      p_con->burst_bytes = 0;
-    }
+static OMX_ERRORTYPE
+srv_write_to_client (httpr_server_t * ap_server, const int a_fd)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  httpr_listener_t * p_lstnr = NULL;
+  int sockfd = a_fd;
 
-  while (1)
-    {
-      if (NULL == p_hdr)
-        {
-          if (NULL == (p_hdr = ap_server->pf_acquire_buf (ap_server->p_arg)))
-            {
-              /* no more buffers available at the moment */
-              ap_server->need_more_data = true;
-              srv_stop_listener_timer_watcher (p_lstnr);
-              rc = OMX_ErrorNone;
-              break;
-            }
-          ap_server->need_more_data = false;
-          ap_server->p_hdr = p_hdr;
-        }
+  assert (ap_server);
 
-      rc = srv_write_omx_buffer (ap_server, p_lstnr);
+  if (NULL == (p_lstnr = tiz_map_find (ap_server->p_lstnrs, &sockfd)))
+    {
+      /* This listener is gone already */
+      return OMX_ErrorNone;
+    }
 
-      if (OMX_ErrorNoMore == rc)
-        {
-          srv_remove_listener (ap_server, p_lstnr);
-          break;
-        }
+  srv_stop_listener_io_watcher (p_lstnr);
 
-      if (OMX_ErrorNotReady == rc
-          || ((p_con->initial_burst_bytes <= 0)
-              && (p_con->burst_bytes >= ap_server->burst_size)))
-        {
-          rc = OMX_ErrorNotReady;
-          break;
-        }
+  if (p_lstnr->need_response)
+    {
+      /* The listener's request is handled now, and its initial burst is sent
+         along with the data due to everyone else */
+      return srv_is_listener_ready (ap_server, p_lstnr) ? srv_write (ap_server)
+                                                       : OMX_ErrorNotReady;
+    }
 
-      /*       if (p_lstnr->pos == ap_server->p_hdr->nFilledLen) */
-      if (0 == ap_server->p_hdr->nFilledLen)
-        {
-          /* Buffer emptied */
-          (void) srv_release_empty_buffer (ap_server, p_lstnr, &p_hdr);
-        }
-    };
+  p_lstnr->blocked = false;
+  if (p_lstnr->streaming
+      && OMX_ErrorNoMore == (rc = srv_write_listener (ap_server, p_lstnr)))
+    {
+      srv_remove_listener (ap_server, p_lstnr);
+    }
 
   return rc;
 }
@@ -1634,6 +1870,8 @@ httpr_srv_destroy (httpr_server_t * ap_server)
   if (ap_server)
     {
       srv_destroy_server_io_watcher (ap_server);
+      tiz_srv_timer_watcher_destroy (ap_server->p_parent,
+                                     ap_server->p_ev_timer);
       if (ICE_SOCK_ERROR != ap_server->lstn_sockfd)
         {
           close (ap_server->lstn_sockfd);
@@ -1645,6 +1883,7 @@ httpr_srv_destroy (httpr_server_t * ap_server)
           tiz_map_clear (ap_server->p_lstnrs);
           tiz_map_destroy (ap_server->p_lstnrs);
         }
+      ring_destroy (&ap_server->ring);
       tiz_mem_free (ap_server);
     }
 }
@@ -1673,8 +1912,15 @@ httpr_srv_init (httpr_server_t ** app_server, void * ap_parent,
   p_server->lstn_sockfd = ICE_SOCK_ERROR;
   p_server->p_ip = NULL;
   p_server->p_srv_ev_io = NULL;
+  p_server->p_ev_timer = NULL;
+  p_server->timer_started = false;
   p_server->max_clients = a_max_clients;
   p_server->p_lstnrs = NULL;
+  p_server->nstreaming = 0;
+  p_server->burst_credit = 0;
+  p_server->zerocopy = srv_zerocopy_requested ();
+  p_server->bytes_sent = 0;
+  p_server->send_calls = 0;
   p_server->p_hdr = NULL;
   p_server->pf_release_buf = a_pf_release_buf;
   p_server->pf_acquire_buf = a_pf_acquire_buf;
@@ -1709,6 +1955,14 @@ httpr_srv_init (httpr_server_t ** app_server, void * ap_parent,
   goto_end_on_omx_error (rc, handleOf (ap_parent),
                          "Unable to init the listeners map");
 
+  rc = ring_init (&(p_server->ring));
+  goto_end_on_omx_error (rc, handleOf (ap_parent),
+                         "Unable to alloc the stream ring");
+
+  rc = tiz_srv_timer_watcher_init (ap_parent, &(p_server->p_ev_timer));
+  goto_end_on_omx_error (rc, handleOf (ap_parent),
+                         "Unable to init the server's timer event");
+
   p_server->lstn_sockfd
     = srv_create_server_socket (p_server, a_port, a_address);
   goto_end_on_socket_error (p_server->lstn_sockfd, handleOf (ap_parent),
@@ -1769,21 +2023,25 @@ end:
 OMX_ERRORTYPE
 httpr_srv_stop (httpr_server_t * ap_server)
 {
-  httpr_listener_t * p_lstnr = NULL;
+  int i = 0;
   assert (ap_server);
   (void) srv_stop_server_io_watcher (ap_server);
-  if (ap_server->p_lstnrs)
+  for (i = srv_get_listeners_count (ap_server) - 1; i >= 0; --i)
     {
-      /* Until support for multiple listeners gets implemented, there will only
-         be one listener in the map */
-      p_lstnr = srv_get_first_listener (ap_server);
-      if (p_lstnr)
-        {
-          srv_stop_listener_io_watcher (p_lstnr);
-          srv_stop_listener_timer_watcher (p_lstnr);
-          srv_remove_listener (ap_server, p_lstnr);
-        }
+      httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, i);
+      assert (p_lstnr);
+      srv_stop_listener_io_watcher (p_lstnr);
+      srv_remove_listener (ap_server, p_lstnr);
     }
+  srv_stop_timer_watcher (ap_server);
+  TIZ_NOTICE (handleOf (ap_server->p_parent),
+              "Sent [%llu] bytes in [%llu] calls ([%.1f] calls/MB)%s",
+              (unsigned long long) ap_server->bytes_sent,
+              (unsigned long long) ap_server->send_calls,
+              ap_server->bytes_sent
+                ? ap_server->send_calls * 1048576.0 / ap_server->bytes_sent
+                : 0.0,
+              ap_server->zerocopy ? " - zero-copy" : "");
   ap_server->running = false;
   ap_server->need_more_data = false;
   return OMX_ErrorNone;
@@ -1821,12 +2079,11 @@ httpr_srv_set_mp3_settings (httpr_server_t * ap_server, const OMX_U32 a_bitrate,
 
   ap_server->wait_time = (1 / ap_server->pkts_per_sec);
 
-  if (srv_get_listeners_count (ap_server) > 0)
+  if (ap_server->timer_started)
     {
-      httpr_listener_t * p_lstnr = srv_get_first_listener (ap_server);
-      assert (p_lstnr);
-      srv_stop_listener_timer_watcher (p_lstnr);
-      srv_start_listener_timer_watcher (p_lstnr, ap_server->wait_time);
+      /* Re-arm the timer with the new period */
+      srv_stop_timer_watcher (ap_server);
+      (void) srv_start_timer_watcher (ap_server);
     }
 
   TIZ_PRINTF_DBG_MAG (
@@ -1904,17 +2161,21 @@ httpr_srv_set_stream_title (httpr_server_t * ap_server,
            OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
   p_mount->stream_title[OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE - 1] = '\0';
 
-  if (srv_get_listeners_count (ap_server) > 0)
-    {
-      httpr_listener_t * p_lstnr = srv_get_first_listener (ap_server);
-      assert (p_lstnr);
-      assert (p_lstnr->p_con);
-      p_lstnr->p_con->metadata_delivered = false;
-      p_lstnr->p_con->initial_burst_bytes
-        = ap_server->mountpoint.initial_burst_size * 0.1;
-      srv_stop_listener_timer_watcher (p_lstnr);
-      srv_start_listener_timer_watcher (p_lstnr, ap_server->wait_time);
-    }
+  {
+    int i = 0;
+    for (i = 0; i < srv_get_listeners_count (ap_server); ++i)
+      {
+        httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, i);
+        assert (p_lstnr);
+        assert (p_lstnr->p_con);
+        p_lstnr->p_con->metadata_delivered = false;
+      }
+  }
+
+  /* Allow a small burst to go out, to help the clients get over the gap
+     between tracks */
+  srv_add_burst_credit (ap_server,
+                        ap_server->mountpoint.initial_burst_size * 0.1);
 }
 
 OMX_ERRORTYPE
@@ -1944,8 +2205,12 @@ httpr_srv_io_event (httpr_server_t * ap_server, const int a_fd)
         }
       else
         {
-          /* The client socket is ready */
-          rc = srv_stream_to_client (ap_server);
+          /* A client socket is ready */
+          rc = srv_write_to_client (ap_server, a_fd);
+          if (OMX_ErrorInsufficientResources != rc)
+            {
+              rc = OMX_ErrorNone;
+            }
         }
     }
   return rc;
@@ -1955,5 +2220,11 @@ OMX_ERRORTYPE
 httpr_srv_timer_event (httpr_server_t * ap_server)
 {
   assert (ap_server);
-  return ap_server->running ? srv_stream_to_client (ap_server) : OMX_ErrorNone;
+  if (!ap_server->running)
+    {
+      return OMX_ErrorNone;
+    }
+  /* One more burst's worth of data may now go into the ring */
+  srv_add_burst_credit (ap_server, ap_server->burst_size);
+  return srv_stream_to_client (ap_server);
 }
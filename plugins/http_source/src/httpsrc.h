@@ -64,6 +64,8 @@ extern "C" {
 #define ARATELIA_HTTP_SOURCE_DEFAULT_BUFFER_SECONDS_YOUTUBE 60
 #define ARATELIA_HTTP_SOURCE_DEFAULT_BUFFER_SECONDS_PLEX 60
 #define ARATELIA_HTTP_SOURCE_DEFAULT_BUFFER_SECONDS_IHEART 120
+#define ARATELIA_HTTP_SOURCE_DEFAULT_PREFETCH_TRACKS 1
+#define ARATELIA_HTTP_SOURCE_MAX_PREFETCH_TRACKS 8
 
 #ifdef __cplusplus
 }
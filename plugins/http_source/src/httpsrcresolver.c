@@ -0,0 +1,255 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   httpsrcresolver.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief Tizonia - HTTP source's background url resolver
+ *
+ * Obtaining the stream url of a track can take a service client several
+ * seconds. After every change of track, a worker thread asks the client to
+ * resolve the urls of the next few entries in the playback queue, one at a
+ * time, so that they are ready by the time the component moves on to them.
+ *
+ * The service clients take the Python interpreter's lock on every call, so
+ * the worker and the component can use the client at the same time. The
+ * worker abandons the entries it had left to resolve when the component
+ * changes track.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <tizplatform.h>
+#include <tizkernel.h>
+
+#include "httpsrc.h"
+#include "httpsrcresolver.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.http_source.prc.resolver"
+#endif
+
+struct httpsrc_resolver
+{
+  void * p_parent;
+  OMX_U32 lookahead;
+  httpsrc_resolver_prefetch_f pf_prefetch;
+  OMX_PTR p_arg;
+  tiz_thread_t thread;
+  /* Protects the fields below */
+  tiz_mutex_t mutex;
+  tiz_cond_t cond;
+  OMX_U32 next_offset;
+  bool stopping;
+};
+
+static OMX_U32
+get_lookahead (void)
+{
+  const char * p_tracks
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                            ARATELIA_HTTP_SOURCE_COMPONENT_NAME
+                            ".prefetch_tracks");
+  long tracks = ARATELIA_HTTP_SOURCE_DEFAULT_PREFETCH_TRACKS;
+  if (p_tracks)
+    {
+      tracks = strtol (p_tracks, NULL, 10);
+    }
+  if (tracks < 0)
+    {
+      tracks = 0;
+    }
+  if (tracks > ARATELIA_HTTP_SOURCE_MAX_PREFETCH_TRACKS)
+    {
+      tracks = ARATELIA_HTTP_SOURCE_MAX_PREFETCH_TRACKS;
+    }
+  return tracks;
+}
+
+static long
+elapsed_ms (const struct timespec * ap_start)
+{
+  struct timespec now;
+  assert (ap_start);
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - ap_start->tv_sec) * 1000
+         + (now.tv_nsec - ap_start->tv_nsec) / 1000000;
+}
+
+static void
+resolve (httpsrc_resolver_t * ap_resolver, const OMX_U32 a_offset)
+{
+  struct timespec start;
+  assert (ap_resolver);
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  ap_resolver->pf_prefetch (ap_resolver->p_arg, a_offset);
+  TIZ_DEBUG (handleOf (ap_resolver->p_parent), "entry +%u resolved in %ld ms",
+             a_offset, elapsed_ms (&start));
+}
+
+static void *
+resolver_thread (void * ap_arg)
+{
+  httpsrc_resolver_t * p_resolver = ap_arg;
+
+  assert (p_resolver);
+
+  (void) tiz_thread_setname (&(p_resolver->thread),
+                             (OMX_STRING) "tizhttpsrcrslv");
+
+  tiz_mutex_lock (&(p_resolver->mutex));
+  for (;;)
+    {
+      OMX_U32 offset = 0;
+
+      while (!p_resolver->stopping
+             && p_resolver->next_offset > p_resolver->lookahead)
+        {
+          tiz_cond_wait (&(p_resolver->cond), &(p_resolver->mutex));
+        }
+
+      if (p_resolver->stopping)
+        {
+          break;
+        }
+
+      offset = p_resolver->next_offset++;
+      tiz_mutex_unlock (&(p_resolver->mutex));
+
+      resolve (p_resolver, offset);
+
+      tiz_mutex_lock (&(p_resolver->mutex));
+    }
+  tiz_mutex_unlock (&(p_resolver->mutex));
+
+  return NULL;
+}
+
+OMX_ERRORTYPE
+httpsrc_resolver_init (httpsrc_resolver_t ** app_resolver, void * ap_parent,
+                       httpsrc_resolver_prefetch_f a_pf_prefetch,
+                       OMX_PTR ap_arg)
+{
+  httpsrc_resolver_t * p_resolver = NULL;
+  const OMX_U32 lookahead = get_lookahead ();
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (app_resolver);
+  assert (ap_parent);
+  assert (a_pf_prefetch);
+
+  *app_resolver = NULL;
+
+  if (0 == lookahead)
+    {
+      TIZ_DEBUG (handleOf (ap_parent), "url prefetching disabled");
+      return OMX_ErrorNone;
+    }
+
+  p_resolver
+    = (httpsrc_resolver_t *) tiz_mem_calloc (1, sizeof (httpsrc_resolver_t));
+  tiz_check_null_ret_oom (p_resolver);
+
+  p_resolver->p_parent = ap_parent;
+  p_resolver->lookahead = lookahead;
+  p_resolver->pf_prefetch = a_pf_prefetch;
+  p_resolver->p_arg = ap_arg;
+  /* Nothing to resolve until the first schedule */
+  p_resolver->next_offset = lookahead + 1;
+  p_resolver->stopping = false;
+
+  if (OMX_ErrorNone != (rc = tiz_mutex_init (&(p_resolver->mutex))))
+    {
+      goto end;
+    }
+
+  if (OMX_ErrorNone != (rc = tiz_cond_init (&(p_resolver->cond))))
+    {
+      tiz_mutex_destroy (&(p_resolver->mutex));
+      goto end;
+    }
+
+  if (OMX_ErrorNone
+      != (rc = tiz_thread_create (&(p_resolver->thread), 0, 0, resolver_thread,
+                                  p_resolver)))
+    {
+      tiz_cond_destroy (&(p_resolver->cond));
+      tiz_mutex_destroy (&(p_resolver->mutex));
+      goto end;
+    }
+
+  TIZ_DEBUG (handleOf (ap_parent), "prefetching the urls of [%u] entries",
+             lookahead);
+
+end:
+
+  if (OMX_ErrorNone != rc)
+    {
+      TIZ_ERROR (handleOf (ap_parent), "[%s] : unable to start the resolver",
+                 tiz_err_to_str (rc));
+      tiz_mem_free (p_resolver);
+      p_resolver = NULL;
+    }
+
+  *app_resolver = p_resolver;
+  return rc;
+}
+
+void
+httpsrc_resolver_destroy (httpsrc_resolver_t * ap_resolver)
+{
+  if (ap_resolver)
+    {
+      void * p_result = NULL;
+
+      tiz_mutex_lock (&(ap_resolver->mutex));
+      ap_resolver->stopping = true;
+      tiz_cond_broadcast (&(ap_resolver->cond));
+      tiz_mutex_unlock (&(ap_resolver->mutex));
+
+      /* This waits for the url being resolved, if any */
+      tiz_thread_join (&(ap_resolver->thread), &p_result);
+
+      tiz_cond_destroy (&(ap_resolver->cond));
+      tiz_mutex_destroy (&(ap_resolver->mutex));
+      tiz_mem_free (ap_resolver);
+    }
+}
+
+void
+httpsrc_resolver_schedule (httpsrc_resolver_t * ap_resolver)
+{
+  if (ap_resolver)
+    {
+      tiz_mutex_lock (&(ap_resolver->mutex));
+      ap_resolver->next_offset = 1;
+      tiz_cond_signal (&(ap_resolver->cond));
+      tiz_mutex_unlock (&(ap_resolver->mutex));
+    }
+}
@@ -0,0 +1,66 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   httpsrcresolver.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief Tizonia - HTTP source's background url resolver
+ *
+ *
+ */
+
+#ifndef HTTPSRCRESOLVER_H
+#define HTTPSRCRESOLVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+typedef struct httpsrc_resolver httpsrc_resolver_t;
+
+/* Resolves the url of the queue entry that is a_offset positions after the
+   current one (1 is the next entry). Called from the resolver's thread. */
+typedef void (*httpsrc_resolver_prefetch_f) (OMX_PTR ap_arg,
+                                             const int a_offset);
+
+/* The number of entries to resolve ahead comes from the component's
+   configuration. When it is zero, *app_resolver is set to NULL; all the other
+   functions accept a NULL resolver, and do nothing with it. */
+OMX_ERRORTYPE
+httpsrc_resolver_init (httpsrc_resolver_t ** app_resolver, void * ap_parent,
+                       httpsrc_resolver_prefetch_f a_pf_prefetch,
+                       OMX_PTR ap_arg);
+
+void
+httpsrc_resolver_destroy (httpsrc_resolver_t * ap_resolver);
+
+/* Resolve the entries that follow the current one, abandoning whatever was
+   left to do for a previous position in the queue */
+void
+httpsrc_resolver_schedule (httpsrc_resolver_t * ap_resolver);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HTTPSRCRESOLVER_H */
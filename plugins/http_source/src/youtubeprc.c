@@ -420,8 +420,8 @@ update_metadata (youtube_prc_t * ap_prc)
 }
 
 static OMX_ERRORTYPE
-obtain_next_url (youtube_prc_t * ap_prc, int a_skip_value,
-                 const int a_position_value)
+retrieve_url (youtube_prc_t * ap_prc, int a_skip_value,
+              const int a_position_value)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   const long pathname_max = PATH_MAX + NAME_MAX;
@@ -489,6 +489,27 @@ obtain_next_url (youtube_prc_t * ap_prc, int a_skip_value,
   return rc;
 }
 
+static OMX_ERRORTYPE
+obtain_next_url (youtube_prc_t * ap_prc, int a_skip_value,
+                 const int a_position_value)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  assert (ap_prc);
+  rc = retrieve_url (ap_prc, a_skip_value, a_position_value);
+  /* Get the urls that follow ready in the background */
+  httpsrc_resolver_schedule (ap_prc->p_resolver_);
+  return rc;
+}
+
+static void
+prefetch_url (OMX_PTR ap_arg, const int a_offset)
+{
+  youtube_prc_t * p_prc = ap_arg;
+  assert (p_prc);
+  assert (p_prc->p_youtube_);
+  (void) tiz_youtube_prefetch_url (p_prc->p_youtube_, a_offset);
+}
+
 static OMX_ERRORTYPE
 release_buffer (youtube_prc_t * ap_prc)
 {
@@ -776,6 +797,7 @@ youtube_prc_ctor (void * ap_obj, va_list * app)
   p_prc->p_uri_param_ = NULL;
   p_prc->p_trans_ = NULL;
   p_prc->p_youtube_ = NULL;
+  p_prc->p_resolver_ = NULL;
   p_prc->eos_ = false;
   p_prc->port_disabled_ = false;
   p_prc->uri_changed_ = false;
@@ -822,6 +844,8 @@ youtube_prc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
     &(p_prc->p_youtube_), (const char *) &(p_prc->session_.cApiKey)));
 
   tiz_check_omx (enqueue_playlist_items (p_prc));
+  tiz_check_omx (
+    httpsrc_resolver_init (&(p_prc->p_resolver_), p_prc, prefetch_url, p_prc));
   tiz_check_omx (obtain_next_url (p_prc, 1, IGNORE_VALUE));
 
   {
@@ -853,6 +877,8 @@ youtube_prc_deallocate_resources (void * ap_prc)
   tiz_urltrans_destroy (p_prc->p_trans_);
   p_prc->p_trans_ = NULL;
   delete_uri (p_prc);
+  httpsrc_resolver_destroy (p_prc->p_resolver_);
+  p_prc->p_resolver_ = NULL;
   tiz_youtube_destroy (p_prc->p_youtube_);
   p_prc->p_youtube_ = NULL;
   return OMX_ErrorNone;
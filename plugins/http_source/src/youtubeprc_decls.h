@@ -41,6 +41,8 @@ extern "C" {
 #include <tizplatform.h>
 #include <tizyoutube_c.h>
 
+#include "httpsrcresolver.h"
+
 typedef struct youtube_prc youtube_prc_t;
 struct youtube_prc
 {
@@ -55,6 +57,7 @@ struct youtube_prc
   OMX_PARAM_CONTENTURITYPE * p_uri_param_;
   tiz_urltrans_t * p_trans_;
   tiz_youtube_t * p_youtube_;
+  httpsrc_resolver_t * p_resolver_;
   bool eos_;
   bool port_disabled_;
   bool uri_changed_;
@@ -23,6 +23,8 @@
  *
  * @brief  Tizonia - MP4 demuxer filter processor
  *
+ * The input stream is demuxed in memory, as it arrives (see mp4stream.h).
+ *
  * TODO: Seek support.
  *
  */
@@ -33,12 +35,8 @@
 
 #include <assert.h>
 #include <stdlib.h>
-#include <errno.h>
-#include <unistd.h>
-#include <limits.h>
 #include <string.h>
-#include <stdarg.h>
-#include <alloca.h>
+#include <time.h>
 
 #include <OMX_TizoniaExt.h>
 
@@ -56,34 +54,9 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.mp4_demuxer.filter.prc"
 #endif
 
-static mp4dmuxflt_prc_t * gp_prc = NULL;
-
-#define FILE_SIZE 7747480
-#define MP4V2_INT_MAX_FAILED_ATTEMPTS 20
-
 /* Forward declarations */
 static OMX_ERRORTYPE
 mp4dmuxflt_prc_deallocate_resources (void *);
-static OMX_ERRORTYPE
-store_data (mp4dmuxflt_prc_t * ap_prc);
-static void
-reset_mp4v2_members (mp4dmuxflt_prc_t * ap_prc);
-static OMX_ERRORTYPE
-send_port_auto_detect_events (mp4dmuxflt_prc_t * ap_prc);
-
-#define on_nestegg_error_ret_omx_oom(expr)                            \
-  do                                                                  \
-    {                                                                 \
-      int nestegg_error = 0;                                          \
-      if (0 != (nestegg_error = (expr)))                              \
-        {                                                             \
-          TIZ_ERROR (handleOf (ap_prc),                               \
-                     "[OMX_ErrorInsufficientResources] : while using" \
-                     " libnestegg");                                  \
-          return OMX_ErrorInsufficientResources;                      \
-        }                                                             \
-    }                                                                 \
-  while (0)
 
 static inline OMX_BUFFERHEADERTYPE *
 get_mp4_hdr (mp4dmuxflt_prc_t * ap_prc)
@@ -93,134 +66,27 @@ get_mp4_hdr (mp4dmuxflt_prc_t * ap_prc)
                                     ARATELIA_MP4_DEMUXER_FILTER_PORT_0_INDEX);
 }
 
-static void
-mp4_log_cback (MP4LogLevel loglevel, const char * fmt, va_list ap)
+static double
+now_ms (void)
 {
-  #define MAX_ALLOCA_BUF 1024
-  char * buffer = alloca (MAX_ALLOCA_BUF);
-  vsnprintf (buffer, MAX_ALLOCA_BUF, fmt, ap);
-
-  /* typedef enum {
-     MP4_LOG_NONE = 0,
-     MP4_LOG_ERROR = 1,
-     MP4_LOG_WARNING = 2,
-     MP4_LOG_INFO = 3,
-     MP4_LOG_VERBOSE1 = 4,
-     MP4_LOG_VERBOSE2 = 5,
-     MP4_LOG_VERBOSE3 = 6,
-     MP4_LOG_VERBOSE4 = 7
-     }  MP4LogLevel;
-  */
-
-  switch(loglevel)
-    {
-    case MP4_LOG_ERROR:
-      {
-        TIZ_ERROR(handleOf(gp_prc), "%s", buffer);
-      }
-      break;
-    case MP4_LOG_INFO:
-      {
-        TIZ_NOTICE(handleOf(gp_prc), "%s", buffer);
-      }
-      break;
-    case MP4_LOG_WARNING:
-      {
-        TIZ_DEBUG(handleOf(gp_prc), "%s", buffer);
-      }
-      break;
-    default:
-      {
-        TIZ_TRACE(handleOf(gp_prc), "%s", buffer);
-      }
-      break;
-    };
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
 }
 
-static void *
-mp4_open_cback (const char * name, MP4FileMode mode)
-{
-  TIZ_TRACE(handleOf(gp_prc), "file name [%s]", name);
-  return gp_prc;
-}
-
-static int
-mp4_seek_cback (void * ap_handle, int64_t pos)
+static bool
+samples_pending (mp4dmuxflt_prc_t * ap_prc)
 {
-  mp4dmuxflt_prc_t * p_prc = ap_handle;
-  assert (gp_prc == ap_handle);
-  assert (p_prc);
-  TIZ_TRACE(handleOf(gp_prc), "pos [%lld]", pos);
-  (void)tiz_buffer_seek (p_prc->p_mp4_store_, pos, TIZ_BUFFER_SEEK_SET);
-  return 0;
-}
-
-static int
-mp4_read_cback (void * ap_handle, void * ap_buffer, int64_t a_size,
-                int64_t * ap_nin, int64_t a_maxChunkSize)
-{
-  mp4dmuxflt_prc_t * p_prc = ap_handle;
-  int retval = -1;
-
-  assert (gp_prc == ap_handle);
-  assert (p_prc);
-  assert (ap_buffer);
-  assert (ap_nin);
-
-  *ap_nin = 0;
-
-  if (tiz_filter_prc_is_eos (p_prc)
-      && tiz_buffer_available (p_prc->p_mp4_store_) == 0)
-    {
-      TIZ_DEBUG (handleOf (p_prc), "out of compressed data");
-      return 1;
-    }
-
-  (void) store_data (p_prc);
-
-  if (ap_buffer && a_size > 0)
-    {
-      if (tiz_buffer_available (p_prc->p_mp4_store_) >= a_size)
-        {
-          memcpy (ap_buffer, tiz_buffer_get (p_prc->p_mp4_store_), a_size);
-          tiz_buffer_advance (p_prc->p_mp4_store_, a_size);
-          *ap_nin = a_size;
-          retval = 0;
-        }
-      else
-        {
-          TIZ_DEBUG (handleOf (p_prc), "out of compressed data");
-          retval = 1;
-        }
-    }
-
-  TIZ_DEBUG (handleOf (p_prc), "a_size [%lld] nin [%lld]", a_size, *ap_nin);
-
-  return retval;
-}
-
-static int
-mp4_write_cback (void * handle, const void * buffer, int64_t size, int64_t * nout,
-           int64_t maxChunkSize)
-{
-  TIZ_TRACE(handleOf(gp_prc), "");
-  return 0;
-}
-
-static int
-mp4_close_cback (void * handle)
-{
-  TIZ_TRACE(handleOf(gp_prc), "");
-  return 0;
+  mp4_stream_sample_t sample;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  assert (ap_prc);
+  rc = mp4_stream_peek_sample (ap_prc->p_stream_, &sample);
+  /* At the end of the stream, a sample that is still waiting for its data will
+     never be complete */
+  return (OMX_ErrorNone == rc || OMX_ErrorStreamCorrupt == rc
+          || (OMX_ErrorNotReady == rc && !tiz_filter_prc_is_eos (ap_prc)));
 }
 
-/* static int64_t */
-/* mp4_get_size (void * handle) */
-/* { */
-/*   TIZ_TRACE(handleOf(gp_prc), "FILE_SIZE"); */
-/*   return FILE_SIZE; */
-/* } */
-
 static void
 propagate_eos_if_required (mp4dmuxflt_prc_t * ap_prc,
                            OMX_BUFFERHEADERTYPE * ap_out_hdr)
@@ -229,8 +95,7 @@ propagate_eos_if_required (mp4dmuxflt_prc_t * ap_prc,
   assert (ap_out_hdr);
 
   /* If EOS, propagate the flag to the next component */
-  if (tiz_filter_prc_is_eos (ap_prc)
-      && tiz_buffer_available (ap_prc->p_mp4_store_) == 0)
+  if (tiz_filter_prc_is_eos (ap_prc) && !samples_pending (ap_prc))
     {
       ap_out_hdr->nFlags |= OMX_BUFFERFLAG_EOS;
       tiz_filter_prc_update_eos_flag (ap_prc, false);
@@ -335,100 +200,54 @@ deliver_codec_metadata (mp4dmuxflt_prc_t * ap_prc, const OMX_U32 a_pid)
   return OMX_ErrorNone;
 }
 
-/* static OMX_ERRORTYPE */
-/* store_audio_codec_metadata (mp4dmuxflt_prc_t * ap_prc, */
-/*                             unsigned char * ap_codec_data, size_t a_length) */
-/* { */
-/*   int pushed = 0; */
-/*   assert (ap_prc); */
-/*   assert (ap_codec_data); */
-/*   assert (a_length); */
-
-/*   pushed = tiz_buffer_push (ap_prc->p_aud_store_, ap_codec_data, a_length); */
-/*   tiz_check_true_ret_val ((pushed == a_length), OMX_ErrorInsufficientResources); */
-/*   tiz_check_omx ( */
-/*     tiz_vector_push_back (ap_prc->p_aud_header_lengths_, &a_length)); */
-
-/*   return OMX_ErrorNone; */
-/* } */
-
-/* static OMX_ERRORTYPE */
-/* store_video_codec_metadata (mp4dmuxflt_prc_t * ap_prc, */
-/*                             unsigned char * ap_codec_data, size_t a_length) */
-/* { */
-/*   int pushed = 0; */
-/*   assert (ap_prc); */
-/*   assert (ap_codec_data); */
-/*   assert (a_length); */
-
-/*   pushed = tiz_buffer_push (ap_prc->p_vid_store_, ap_codec_data, a_length); */
-/*   tiz_check_true_ret_val ((pushed == a_length), OMX_ErrorInsufficientResources); */
-/*   tiz_check_omx ( */
-/*     tiz_vector_push_back (ap_prc->p_vid_header_lengths_, &a_length)); */
-
-/*   return OMX_ErrorNone; */
-/* } */
-
-static mp4_track_type_t
-get_track_type (mp4dmuxflt_prc_t * ap_prc, const MP4FileHandle a_mp4hdl,
-                const MP4TrackId tid)
+static OMX_ERRORTYPE
+store_audio_codec_metadata (mp4dmuxflt_prc_t * ap_prc,
+                            const uint8_t * ap_codec_data, size_t a_length)
+{
+  int pushed = 0;
+  assert (ap_prc);
+  assert (ap_codec_data);
+  assert (a_length);
+
+  pushed = tiz_buffer_push (ap_prc->p_aud_store_, ap_codec_data, a_length);
+  tiz_check_true_ret_val ((pushed == a_length), OMX_ErrorInsufficientResources);
+  tiz_check_omx (
+    tiz_vector_push_back (ap_prc->p_aud_header_lengths_, &a_length));
+
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+store_video_codec_metadata (mp4dmuxflt_prc_t * ap_prc,
+                            const uint8_t * ap_codec_data, size_t a_length)
 {
-  char * p_track_type = NULL;
+  int pushed = 0;
   assert (ap_prc);
-  assert (a_mp4hdl != MP4_INVALID_FILE_HANDLE);
-  assert (MP4_INVALID_TRACK_ID != tid);
-
-  {
-    p_track_type = (char *) MP4GetTrackType (a_mp4hdl, tid);
-    if (p_track_type)
-      {
-        if (!strcmp (p_track_type, MP4_AUDIO_TRACK_TYPE))
-          {
-            ap_prc->track_type_ = mp4_track_audio;
-          }
-        else if (!strcmp (p_track_type, MP4_VIDEO_TRACK_TYPE))
-          {
-            ap_prc->track_type_ = mp4_track_video;
-          }
-        else if (!strcmp (p_track_type, MP4_HINT_TRACK_TYPE))
-          {
-            ap_prc->track_type_ = mp4_track_hint;
-          }
-        else if (strcmp (p_track_type, MP4_CNTL_TRACK_TYPE) == 0)
-          {
-            ap_prc->track_type_ = mp4_track_cntl;
-          }
-        else if (!strcmp (p_track_type, MP4_OD_TRACK_TYPE))
-          {
-            ap_prc->track_type_ = mp4_track_od;
-          }
-        else if (!strcmp (p_track_type, MP4_SCENE_TRACK_TYPE))
-          {
-            ap_prc->track_type_ = mp4_track_scene;
-          }
-        else
-          {
-            ap_prc->track_type_ = mp4_track_unknown;
-          }
-      }
-  }
-  return ap_prc->track_type_;
+  assert (ap_codec_data);
+  assert (a_length);
+
+  pushed = tiz_buffer_push (ap_prc->p_vid_store_, ap_codec_data, a_length);
+  tiz_check_true_ret_val ((pushed == a_length), OMX_ErrorInsufficientResources);
+  tiz_check_omx (
+    tiz_vector_push_back (ap_prc->p_vid_header_lengths_, &a_length));
+
+  return OMX_ErrorNone;
 }
 
-#ifndef NDEBUG
 static void
-print_track_info (mp4dmuxflt_prc_t * ap_prc, const MP4TrackId tid)
+print_track_info (mp4dmuxflt_prc_t * ap_prc, const char * ap_kind,
+                  const mp4_stream_track_info_t * ap_info)
 {
   assert (ap_prc);
-  assert (ap_prc->mp4v2_hdl_ != MP4_INVALID_FILE_HANDLE);
-  if (MP4_INVALID_TRACK_ID != tid)
-    {
-      char * p_track_nfo = MP4Info (ap_prc->mp4v2_hdl_, tid);
-      TIZ_DEBUG (handleOf (ap_prc), "track info: ", (p_track_nfo ? p_track_nfo : ""));
-      tiz_mem_free (p_track_nfo);
-    }
+  assert (ap_info);
+  TIZ_DEBUG (handleOf (ap_prc),
+             "%s track: id %u codec %d timescale %u duration %llu samples %u "
+             "rate %u channels %u size %ux%u config %zu bytes",
+             ap_kind, ap_info->id, ap_info->codec, ap_info->timescale,
+             (unsigned long long) ap_info->duration, ap_info->nsamples,
+             ap_info->sample_rate, ap_info->channels, ap_info->width,
+             ap_info->height, ap_info->config_len);
 }
-#endif
 
 static OMX_ERRORTYPE
 prepare_port_auto_detection (mp4dmuxflt_prc_t * ap_prc)
@@ -458,169 +277,220 @@ prepare_port_auto_detection (mp4dmuxflt_prc_t * ap_prc)
 }
 
 static OMX_ERRORTYPE
-get_temp_file(mp4dmuxflt_prc_t * ap_prc)
+store_data (mp4dmuxflt_prc_t * ap_prc)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
-  assert(ap_prc);
+  assert (ap_prc);
 
-  static char template[] = "/tmp/tizonia-mp4dmux-XXXXXX";
-  if (!ap_prc->tmp_fd_1_)
+  OMX_BUFFERHEADERTYPE * p_in = get_mp4_hdr (ap_prc);
+  if (p_in)
     {
-      char fname[PATH_MAX];
-      strcpy(fname, template);
-      if ((ap_prc->tmp_fd_1_ = mkstemp (fname)) == -1)
+      TIZ_TRACE (handleOf (ap_prc), "received [%llu] incoming [%u]",
+                 (unsigned long long) mp4_stream_received (ap_prc->p_stream_),
+                 p_in->nFilledLen);
+      if (0 == mp4_stream_received (ap_prc->p_stream_))
+        {
+          ap_prc->first_data_ms_ = now_ms ();
+        }
+      /* The parser keeps only the bytes it still needs */
+      rc = mp4_stream_push (ap_prc->p_stream_, p_in->pBuffer + p_in->nOffset,
+                            p_in->nFilledLen);
+      if (OMX_ErrorNone != rc)
         {
-          TIZ_ERROR (handleOf (ap_prc), "Error creating temp file (%s)",
-                     strerror (errno));
-          rc = OMX_ErrorInsufficientResources;
+          TIZ_ERROR (handleOf (ap_prc),
+                     "[%s] : while parsing the stream - buffered [%zu] bytes",
+                     tiz_err_to_str (rc),
+                     mp4_stream_peak_buffered (ap_prc->p_stream_));
+          if (OMX_ErrorStreamCorrupt == rc)
+            {
+              rc = OMX_ErrorStreamCorruptFatal;
+            }
         }
+      tiz_check_omx (release_input_header (ap_prc));
     }
   return rc;
 }
 
+static void
+log_first_sample (mp4dmuxflt_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  if (!ap_prc->first_sample_delivered_)
+    {
+      ap_prc->first_sample_delivered_ = true;
+      TIZ_NOTICE (handleOf (ap_prc),
+                  "first sample after [%.2f] ms - received [%llu] bytes - "
+                  "buffered [%zu] bytes",
+                  now_ms () - ap_prc->first_data_ms_,
+                  (unsigned long long) mp4_stream_received (ap_prc->p_stream_),
+                  mp4_stream_peak_buffered (ap_prc->p_stream_));
+    }
+}
+
 static OMX_ERRORTYPE
-store_data (mp4dmuxflt_prc_t * ap_prc)
+extract_track_data (mp4dmuxflt_prc_t * ap_prc,
+                    const mp4_stream_sample_t * ap_sample, const OMX_U32 a_pid)
 {
-  bool rc = OMX_ErrorNone;
+  OMX_ERRORTYPE rc = OMX_ErrorNotReady;
+  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+
   assert (ap_prc);
+  assert (ap_sample);
 
-  OMX_BUFFERHEADERTYPE * p_in = get_mp4_hdr (ap_prc);
-  if (p_in)
+  if (tiz_filter_prc_is_port_disabled (ap_prc, a_pid))
+    {
+      /* Nobody is interested in this track */
+      mp4_stream_next_sample (ap_prc->p_stream_);
+      ap_prc->sample_offset_ = 0;
+      rc = OMX_ErrorNone;
+    }
+  else if ((p_hdr = tiz_filter_prc_get_header (ap_prc, a_pid)))
     {
-      const void *p_buf = p_in->pBuffer + p_in->nOffset;
-      const size_t count = p_in->nFilledLen;
-      tiz_check_omx (get_temp_file (ap_prc));
-      if (write (ap_prc->tmp_fd_1_, p_buf, count) != count)
+      size_t nbytes_to_copy = 0;
+
+      if (0 == ap_prc->sample_offset_)
         {
-          TIZ_ERROR (handleOf (ap_prc),
-                     "Error writing to temp file (%s)",
-                     strerror (errno));
+          p_hdr->nTimeStamp = (OMX_TICKS) ap_sample->dts_us;
+          if (ap_prc->adts_ && ap_sample->is_audio
+              && ap_sample->len + MP4_STREAM_ADTS_HEADER_LEN
+                   <= MP4_STREAM_ADTS_MAX_FRAME_LEN
+              && TIZ_OMX_BUF_AVAIL (p_hdr) >= MP4_STREAM_ADTS_HEADER_LEN)
+            {
+              mp4_stream_adts_header (ap_prc->p_stream_, ap_sample->len,
+                                      TIZ_OMX_BUF_PTR (p_hdr)
+                                        + p_hdr->nFilledLen);
+              p_hdr->nFilledLen += MP4_STREAM_ADTS_HEADER_LEN;
+            }
+        }
+
+      /* Samples larger than the omx buffer are split across buffers */
+      nbytes_to_copy = MIN (TIZ_OMX_BUF_AVAIL (p_hdr),
+                            ap_sample->len - ap_prc->sample_offset_);
+      memcpy (TIZ_OMX_BUF_PTR (p_hdr) + p_hdr->nFilledLen,
+              ap_sample->p_data + ap_prc->sample_offset_, nbytes_to_copy);
+      p_hdr->nFilledLen += nbytes_to_copy;
+      ap_prc->sample_offset_ += nbytes_to_copy;
+
+      if (ap_prc->sample_offset_ >= ap_sample->len)
+        {
+          /* Consume the sample before releasing the buffer, so that EOS can be
+             detected */
+          mp4_stream_next_sample (ap_prc->p_stream_);
+          ap_prc->sample_offset_ = 0;
+          rc = OMX_ErrorNone;
+        }
+
+      TIZ_DEBUG (handleOf (ap_prc), "copy to buffer p_hdr [%p] - len %u",
+                 p_hdr, p_hdr->nFilledLen);
+      log_first_sample (ap_prc);
+      tiz_check_omx (release_output_header (ap_prc, a_pid));
+      if (OMX_ErrorNotReady == rc)
+        {
+          /* The rest of the sample goes into the next buffer */
+          rc = OMX_ErrorNone;
         }
-      rc = release_input_header (ap_prc);
     }
+
   return rc;
 }
 
-/* static OMX_ERRORTYPE */
-/* extract_track_data (mp4dmuxflt_prc_t * ap_prc, const unsigned int a_track, */
-/*                     const OMX_U32 a_pid) */
-/* { */
-/*   OMX_ERRORTYPE rc = OMX_ErrorNotReady; */
-/*   OMX_BUFFERHEADERTYPE * p_hdr = NULL; */
-
-/*   if (!tiz_filter_prc_is_port_disabled (ap_prc, a_pid)) */
-/*     { */
-/*       p_hdr = tiz_filter_prc_get_header (ap_prc, a_pid); */
-/*       if (p_hdr) */
-/*         { */
-/*           assert (ap_prc); */
-
-/*           /\* Extract a packet *\/ */
-
-/*           /\* Release the OMX buffer *\/ */
-/*           if (TIZ_OMX_BUF_FILL_LEN (p_hdr) > 0) */
-/*             { */
-/*               tiz_check_omx (release_output_header (ap_prc, a_pid)); */
-/*             } */
-/*         } /\* if (p_hdr) *\/ */
-/*     }     /\* if (!tiz_filter_prc_is_port_disabled (ap_prc, a_pid)) *\/ */
-
-/*   /\* Release the ne packet if all chunks have been processed *\/ */
-
-/*   return rc; */
-/* } */
-
-/* static OMX_ERRORTYPE */
-/* extract_track_audio_data (mp4dmuxflt_prc_t * ap_prc, */
-/*                           const unsigned int a_track) */
-/* { */
-/*   OMX_ERRORTYPE rc = OMX_ErrorNone; */
-/*   assert (ap_prc); */
-/*   rc = extract_track_data (ap_prc, a_track, */
-/*                            ARATELIA_MP4_DEMUXER_FILTER_PORT_1_INDEX); */
-/*   return rc; */
-/* } */
-
-/* static OMX_ERRORTYPE */
-/* extract_track_video_data (mp4dmuxflt_prc_t * ap_prc, */
-/*                           const unsigned int a_track) */
-/* { */
-/*   OMX_ERRORTYPE rc = OMX_ErrorNone; */
-/*   assert (ap_prc); */
-/*   rc = extract_track_data (ap_prc, a_track, */
-/*                            ARATELIA_MP4_DEMUXER_FILTER_PORT_2_INDEX); */
-/*   return rc; */
-/* } */
-
-/* static bool */
-/* able_to_demux (mp4dmuxflt_prc_t * ap_prc) */
-/* { */
-/*   bool rc = true; */
-/*   bool compressed_data_avail */
-/*     = (tiz_buffer_available (ap_prc->p_mp4_store_) > 0); */
-/*   bool enough_compressed_data_avail */
-/*     = compressed_data_avail */
-/*       && !(tiz_buffer_available (ap_prc->p_mp4_store_)); */
-
-/*   if (!compressed_data_avail && tiz_filter_prc_is_eos (ap_prc)) */
-/*     { */
-/*       release_output_header (ap_prc, ARATELIA_MP4_DEMUXER_FILTER_PORT_1_INDEX); */
-/*       release_output_header (ap_prc, ARATELIA_MP4_DEMUXER_FILTER_PORT_2_INDEX); */
-/*     } */
-
-/*   if (!compressed_data_avail || !enough_compressed_data_avail */
-/*       || (!tiz_filter_prc_output_headers_available (ap_prc))) */
-/*     { */
-/*       rc = false; */
-/*     } */
-
-/*   TIZ_DEBUG (handleOf (ap_prc), "able to demux - %s", rc ? "YES" : "NO"); */
-
-/*   return rc; */
-/* } */
-
-/* static OMX_ERRORTYPE */
-/* read_packet (mp4dmuxflt_prc_t * ap_prc) */
-/* { */
-/*   OMX_ERRORTYPE rc = OMX_ErrorNotReady; */
-
-/*   assert (ap_prc); */
-
-/*   return rc; */
-/* } */
-
-/* static OMX_ERRORTYPE */
-/* demux_stream (mp4dmuxflt_prc_t * ap_prc) */
-/* { */
-/*   OMX_ERRORTYPE rc = OMX_ErrorNotReady; */
-
-/*   assert (ap_prc); */
-
-/*   while (able_to_demux (ap_prc)) */
-/*     { */
-/*       rc = read_packet (ap_prc); */
-/*     } */
-
-/*   return rc; */
-/* } */
+static bool
+able_to_demux (mp4dmuxflt_prc_t * ap_prc)
+{
+  bool rc = true;
+  bool samples_avail = samples_pending (ap_prc);
+
+  if (!samples_avail && tiz_filter_prc_is_eos (ap_prc))
+    {
+      release_output_header (ap_prc, ARATELIA_MP4_DEMUXER_FILTER_PORT_1_INDEX);
+      release_output_header (ap_prc, ARATELIA_MP4_DEMUXER_FILTER_PORT_2_INDEX);
+    }
+
+  if (!samples_avail || (!tiz_filter_prc_output_headers_available (ap_prc)))
+    {
+      rc = false;
+    }
+
+  TIZ_DEBUG (handleOf (ap_prc), "able to demux - %s", rc ? "YES" : "NO");
+
+  return rc;
+}
 
 static OMX_ERRORTYPE
-alloc_input_store (mp4dmuxflt_prc_t * ap_prc)
+read_packet (mp4dmuxflt_prc_t * ap_prc)
 {
-  OMX_PARAM_PORTDEFINITIONTYPE port_def;
+  mp4_stream_sample_t sample;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
   assert (ap_prc);
 
-  TIZ_INIT_OMX_PORT_STRUCT (port_def, ARATELIA_MP4_DEMUXER_FILTER_PORT_0_INDEX);
-  tiz_check_omx (
-    tiz_api_GetParameter (tiz_get_krn (handleOf (ap_prc)), handleOf (ap_prc),
-                          OMX_IndexParamPortDefinition, &port_def));
+  rc = mp4_stream_peek_sample (ap_prc->p_stream_, &sample);
+  if (OMX_ErrorNone == rc)
+    {
+      rc = extract_track_data (ap_prc, &sample,
+                               sample.is_audio
+                                 ? ARATELIA_MP4_DEMUXER_FILTER_PORT_1_INDEX
+                                 : ARATELIA_MP4_DEMUXER_FILTER_PORT_2_INDEX);
+    }
+  else if (OMX_ErrorStreamCorrupt == rc)
+    {
+      TIZ_WARN (handleOf (ap_prc), "Unable to locate sample; skipping it");
+      mp4_stream_next_sample (ap_prc->p_stream_);
+      ap_prc->sample_offset_ = 0;
+      rc = OMX_ErrorNone;
+    }
+  else
+    {
+      TIZ_DEBUG (handleOf (ap_prc), "peek sample return code [%s]",
+                 tiz_err_to_str (rc));
+      rc = OMX_ErrorNotReady;
+    }
 
-  assert (ap_prc->p_mp4_store_ == NULL);
-  tiz_check_omx (
-    tiz_buffer_init (&(ap_prc->p_mp4_store_), port_def.nBufferSize * 4));
+  return rc;
+}
+
+static OMX_ERRORTYPE
+demux_stream (mp4dmuxflt_prc_t * ap_prc)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNotReady;
+
+  assert (ap_prc);
+  assert (ap_prc->p_stream_);
 
-  /* Will need to seek on this buffer  */
-  return tiz_buffer_seek_mode (ap_prc->p_mp4_store_, TIZ_BUFFER_SEEKABLE);
+  /* NOTE: Stop when no progress is made, e.g. the next sample belongs to a
+     port that has no buffers available at the moment */
+  while (able_to_demux (ap_prc) && OMX_ErrorNone == (rc = read_packet (ap_prc)))
+    {
+    }
+
+  return rc;
+}
+
+static size_t
+get_max_mdat_buffered (mp4dmuxflt_prc_t * ap_prc)
+{
+  const char * p_mb = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION,
+    ARATELIA_MP4_DEMUXER_COMPONENT_NAME ".max_mdat_buffered_mb");
+  long mb = 0;
+  assert (ap_prc);
+  if (p_mb)
+    {
+      mb = strtol (p_mb, NULL, 10);
+    }
+  /* 0 means the parser's default */
+  return (mb > 0 ? (size_t) mb * 1024 * 1024 : 0);
+}
+
+static OMX_ERRORTYPE
+alloc_stream (mp4dmuxflt_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  assert (!ap_prc->p_stream_);
+  tiz_check_omx (mp4_stream_init (&(ap_prc->p_stream_)));
+  mp4_stream_set_max_mdat_buffered (ap_prc->p_stream_,
+                                    get_max_mdat_buffered (ap_prc));
+  return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
@@ -661,72 +531,6 @@ alloc_output_stores (mp4dmuxflt_prc_t * ap_prc)
   return OMX_ErrorNone;
 }
 
-static inline void
-dealloc_mp4v2 (
-  /*@special@ */ mp4dmuxflt_prc_t * ap_prc)
-/*@releases ap_prc->p_ne_@ */
-/*@ensures isnull ap_prc->p_ne_@ */
-{
-  assert (ap_prc);
-  if (MP4_IS_VALID_FILE_HANDLE (ap_prc->mp4v2_hdl_))
-    {
-      MP4Close (ap_prc->mp4v2_hdl_, 0);
-      ap_prc->mp4v2_hdl_ = MP4_INVALID_FILE_HANDLE;
-    }
-}
-
-static OMX_ERRORTYPE
-alloc_mp4v2 (mp4dmuxflt_prc_t * ap_prc)
-{
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  assert (ap_prc);
-  TIZ_TRACE(handleOf(ap_prc), "");
-  if (!MP4_IS_VALID_FILE_HANDLE (ap_prc->mp4v2_hdl_))
-    {
-/*       const MP4FileProvider provider */
-/*         = {mp4_open_cback, mp4_seek_cback, mp4_read_cback, mp4_write_cback, */
-/*            mp4_close_cback, mp4_get_size}; */
-      const MP4FileProvider provider
-        = {mp4_open_cback, mp4_seek_cback, mp4_read_cback, mp4_write_cback,
-           mp4_close_cback};
-      ap_prc->mp4v2_hdl_ = MP4ReadProvider ("Tizonia", &provider);
-      TIZ_TRACE(handleOf(ap_prc), "MP4ReadProvider");
-      if (!MP4_IS_VALID_FILE_HANDLE (ap_prc->mp4v2_hdl_))
-        {
-          /* We'll assume mp4v2 has not initialised correctly because there is
-             not enough input data yet... we'll wait for more data to arrive, but
-             we'll also give up after the max number of failed attempts. */
-          dealloc_mp4v2 (ap_prc);
-          reset_mp4v2_members (ap_prc);
-          tiz_buffer_seek (ap_prc->p_mp4_store_, 0, TIZ_BUFFER_SEEK_SET);
-          ap_prc->mp4v2_failed_init_count_ += 1;
-          rc = OMX_ErrorNotReady;
-          TIZ_ERROR (handleOf (ap_prc),
-                     "[OMX_ErrorNotReady] on MP4ReadProvider");
-        }
-      else
-        {
-          rc = send_port_auto_detect_events (ap_prc);
-          ap_prc->mp4v2_inited_ = true;
-        }
-      TIZ_DEBUG (handleOf (ap_prc), "mp4v2 inited = %s",
-                 (ap_prc->mp4v2_inited_ ? "TRUE" : "FALSE"));
-    }
-  return rc;
-}
-
-static void
-reset_mp4v2_members (mp4dmuxflt_prc_t * ap_prc)
-{
-  assert (ap_prc);
-  assert (!MP4_IS_VALID_FILE_HANDLE (ap_prc->mp4v2_hdl_));
-  ap_prc->mp4v2_inited_ = false;
-  ap_prc->mp4v2_duration_ = 0;
-  ap_prc->track_type_ = mp4_track_unknown;
-  ap_prc->audio_type_ = mp4_audio_unknown;
-  ap_prc->video_type_ = mp4_video_unknown;
-}
-
 static void
 reset_stream_parameters (mp4dmuxflt_prc_t * ap_prc)
 {
@@ -739,11 +543,20 @@ reset_stream_parameters (mp4dmuxflt_prc_t * ap_prc)
   ap_prc->video_auto_detect_on_ = false;
   ap_prc->video_coding_type_ = OMX_VIDEO_CodingUnused;
 
-  dealloc_mp4v2 (ap_prc);
-  reset_mp4v2_members (ap_prc);
-  ap_prc->mp4v2_failed_init_count_ = 0;
+  if (ap_prc->p_stream_ && mp4_stream_received (ap_prc->p_stream_) > 0)
+    {
+      TIZ_DEBUG (handleOf (ap_prc),
+                 "received [%llu] bytes - peak buffered [%zu] bytes",
+                 (unsigned long long) mp4_stream_received (ap_prc->p_stream_),
+                 mp4_stream_peak_buffered (ap_prc->p_stream_));
+    }
+  mp4_stream_reset (ap_prc->p_stream_);
+  ap_prc->stream_inited_ = false;
+  ap_prc->sample_offset_ = 0;
+  ap_prc->adts_ = false;
+  ap_prc->first_data_ms_ = 0;
+  ap_prc->first_sample_delivered_ = false;
 
-  tiz_buffer_clear (ap_prc->p_mp4_store_);
   tiz_buffer_clear (ap_prc->p_aud_store_);
   tiz_buffer_clear (ap_prc->p_vid_store_);
   tiz_vector_clear (ap_prc->p_aud_header_lengths_);
@@ -753,21 +566,21 @@ reset_stream_parameters (mp4dmuxflt_prc_t * ap_prc)
 }
 
 static inline void
-dealloc_input_store (
+dealloc_stream (
   /*@special@ */ mp4dmuxflt_prc_t * ap_prc)
-/*@releases ap_prc->p_mp4_store_@ */
-/*@ensures isnull ap_prc->p_mp4_store_@ */
+/*@releases ap_prc->p_stream_@ */
+/*@ensures isnull ap_prc->p_stream_@ */
 {
   assert (ap_prc);
-  tiz_buffer_destroy (ap_prc->p_mp4_store_);
-  ap_prc->p_mp4_store_ = NULL;
+  mp4_stream_destroy (ap_prc->p_stream_);
+  ap_prc->p_stream_ = NULL;
 }
 
 static inline void
 dealloc_output_stores (
   /*@special@ */ mp4dmuxflt_prc_t * ap_prc)
-/*@releases ap_prc->p_mp4_store_@ */
-/*@ensures isnull ap_prc->p_mp4_store_@ */
+/*@releases ap_prc->p_aud_store_@ */
+/*@ensures isnull ap_prc->p_aud_store_@ */
 {
   assert (ap_prc);
   tiz_buffer_destroy (ap_prc->p_aud_store_);
@@ -826,99 +639,105 @@ set_video_coding_on_port (mp4dmuxflt_prc_t * ap_prc)
 
 static OMX_ERRORTYPE
 read_audio_codec_metadata (mp4dmuxflt_prc_t * ap_prc,
-                           const MP4TrackId a_track_id,
-                           const int a_track_type)
+                           const mp4_stream_track_info_t * ap_info)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
   assert (ap_prc);
 
-  if (mp4_track_audio == a_track_type)
+  /* Do nothing if there is no audio track */
+  if (ap_info)
     {
-      mp4_audio_type_t audio_type = mp4_audio_unknown;
-      uint32_t time_scale = 0;
-      MP4Duration track_duration = 0;
-      double ms_duration = .0;
-      uint32_t avg_bitrate = 0;
-      char * p_track_nfo = mp4_get_audio_info (
-        ap_prc->mp4v2_hdl_, a_track_id, &audio_type, &time_scale,
-        &track_duration, &ms_duration, &avg_bitrate);
-      tiz_mem_free(p_track_nfo);
-      p_track_nfo = NULL;
-
-      switch(audio_type)
+      print_track_info (ap_prc, "audio", ap_info);
+      switch (ap_info->codec)
         {
-        case mp4_audio_mp3:
-          {
-            ap_prc->audio_coding_type_ = OMX_AUDIO_CodingMP3;
-          }
-          break;
-        case mp4_audio_aac:
-        case mp4_audio_aac_from_mov:
-          {
-            ap_prc->audio_coding_type_ = OMX_AUDIO_CodingAAC;
-          }
-          break;
-        case mp4_audio_amr:
-        case mp4_audio_amrwb:
-          {
-            ap_prc->audio_coding_type_ = OMX_AUDIO_CodingAMR;
-          }
-          break;
-        default:
-          ap_prc->audio_coding_type_ = OMX_AUDIO_CodingUnused;
-          break;
+          case mp4_stream_codec_mp3:
+            {
+              ap_prc->audio_coding_type_ = OMX_AUDIO_CodingMP3;
+            }
+            break;
+          case mp4_stream_codec_aac:
+            {
+              ap_prc->audio_coding_type_ = OMX_AUDIO_CodingAAC;
+              /* The samples are framed as ADTS, which carries the decoder
+                 configuration with every frame */
+              ap_prc->adts_ = ap_info->adts;
+            }
+            break;
+          case mp4_stream_codec_amr:
+          case mp4_stream_codec_amrwb:
+            {
+              ap_prc->audio_coding_type_ = OMX_AUDIO_CodingAMR;
+            }
+            break;
+          default:
+            ap_prc->audio_coding_type_ = OMX_AUDIO_CodingUnused;
+            break;
         };
 
-      /* Do nothing if track type is not audio */
+      if (!ap_prc->adts_ && ap_info->config_len > 0)
+        {
+          tiz_check_omx (store_audio_codec_metadata (
+            ap_prc, ap_info->p_config, ap_info->config_len));
+        }
+
       tiz_check_omx (set_audio_coding_on_port (ap_prc));
     }
-  return rc;
+  return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
 read_video_codec_metadata (mp4dmuxflt_prc_t * ap_prc,
-                           const unsigned int a_track_id,
-                           const int a_track_type)
+                           const mp4_stream_track_info_t * ap_info)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
   assert (ap_prc);
 
-  /* Do nothing if track type is not video */
-  tiz_check_omx (set_video_coding_on_port (ap_prc));
-  return rc;
+  /* Do nothing if there is no video track */
+  if (ap_info)
+    {
+      print_track_info (ap_prc, "video", ap_info);
+      switch (ap_info->codec)
+        {
+          case mp4_stream_codec_avc:
+            {
+              ap_prc->video_coding_type_ = OMX_VIDEO_CodingAVC;
+            }
+            break;
+          case mp4_stream_codec_mpeg4:
+            {
+              ap_prc->video_coding_type_ = OMX_VIDEO_CodingMPEG4;
+            }
+            break;
+          case mp4_stream_codec_mpeg2:
+          case mp4_stream_codec_mpeg1:
+            {
+              ap_prc->video_coding_type_ = OMX_VIDEO_CodingMPEG2;
+            }
+            break;
+          default:
+            ap_prc->video_coding_type_ = OMX_VIDEO_CodingUnused;
+            break;
+        };
+
+      if (ap_info->config_len > 0)
+        {
+          tiz_check_omx (store_video_codec_metadata (
+            ap_prc, ap_info->p_config, ap_info->config_len));
+        }
+
+      tiz_check_omx (set_video_coding_on_port (ap_prc));
+    }
+  return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
 obtain_track_info (mp4dmuxflt_prc_t * ap_prc)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  MP4TrackId track_id = MP4_INVALID_TRACK_ID;
-  uint32_t i = 0;
-  uint32_t ntracks = 0;
-
   assert (ap_prc);
-  assert (ap_prc->mp4v2_hdl_ != MP4_INVALID_FILE_HANDLE);
-
-  /* Obtain the number of tracks */
-  ntracks = MP4GetNumberOfTracks (ap_prc->mp4v2_hdl_, NULL, 0);
-
-  for (i = 0; i < ntracks; ++i)
-    {
-      mp4_track_type_t track_type = mp4_track_unknown;
-
-      track_id = MP4FindTrackId (ap_prc->mp4v2_hdl_, i, NULL, 0);
-      track_type = get_track_type (ap_prc, ap_prc->mp4v2_hdl_, track_id);
-
-#ifndef NDEBUG
-      print_track_info (ap_prc, track_id);
-#endif
-
-      tiz_check_omx (
-        read_audio_codec_metadata (ap_prc, track_id, track_type));
-      tiz_check_omx (
-        read_video_codec_metadata (ap_prc, track_id, track_type));
-    }
-  return rc;
+  assert (mp4_stream_is_ready (ap_prc->p_stream_));
+  tiz_check_omx (read_audio_codec_metadata (
+    ap_prc, mp4_stream_audio_track (ap_prc->p_stream_)));
+  tiz_check_omx (read_video_codec_metadata (
+    ap_prc, mp4_stream_video_track (ap_prc->p_stream_)));
+  return OMX_ErrorNone;
 }
 
 static void
@@ -958,14 +777,14 @@ send_port_auto_detect_events (mp4dmuxflt_prc_t * ap_prc)
   OMX_ERRORTYPE rc = obtain_track_info (ap_prc);
   if (OMX_ErrorNone == rc)
     {
-      if (mp4_audio_unknown != ap_prc->audio_type_)
+      if (mp4_stream_audio_track (ap_prc->p_stream_))
         {
           send_auto_detect_event (ap_prc, &(ap_prc->audio_coding_type_),
                                   OMX_AUDIO_CodingUnused,
                                   OMX_AUDIO_CodingAutoDetect,
                                   ARATELIA_MP4_DEMUXER_FILTER_PORT_1_INDEX);
         }
-      if (mp4_video_unknown != ap_prc->video_type_)
+      if (mp4_stream_video_track (ap_prc->p_stream_))
         {
           send_auto_detect_event (ap_prc, &(ap_prc->video_coding_type_),
                                   OMX_VIDEO_CodingUnused,
@@ -998,19 +817,12 @@ mp4dmuxflt_prc_ctor (void * ap_prc, va_list * app)
   mp4dmuxflt_prc_t * p_prc
     = super_ctor (typeOf (ap_prc, "mp4dmuxfltprc"), ap_prc, app);
   assert (p_prc);
-  p_prc->tmp_fd_1_ = -1;
-  p_prc->tmp_fd_2_ = -1;
-  p_prc->mp4v2_hdl_ = MP4_INVALID_FILE_HANDLE;
-  p_prc->mp4v2_inited_ = false;
-  p_prc->mp4v2_duration_ = 0;
-  p_prc->p_mp4_store_ = NULL;
+  p_prc->p_stream_ = NULL;
   p_prc->p_aud_store_ = NULL;
   p_prc->p_vid_store_ = NULL;
   p_prc->p_aud_header_lengths_ = NULL;
   p_prc->p_vid_header_lengths_ = NULL;
   reset_stream_parameters (p_prc);
-  MP4SetLogCallback(mp4_log_cback);
-  gp_prc = ap_prc;
   return p_prc;
 }
 
@@ -1018,7 +830,6 @@ static void *
 mp4dmuxflt_prc_dtor (void * ap_obj)
 {
   (void) mp4dmuxflt_prc_deallocate_resources (ap_obj);
-  gp_prc = NULL;
   return super_dtor (typeOf (ap_obj, "mp4dmuxfltprc"), ap_obj);
 }
 
@@ -1032,7 +843,7 @@ mp4dmuxflt_prc_allocate_resources (void * ap_prc, OMX_U32 a_pid)
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   mp4dmuxflt_prc_t * p_prc = ap_prc;
   assert (p_prc);
-  tiz_check_omx (alloc_input_store (p_prc));
+  tiz_check_omx (alloc_stream (p_prc));
   tiz_check_omx (alloc_output_stores (p_prc));
   return rc;
 }
@@ -1043,8 +854,7 @@ mp4dmuxflt_prc_deallocate_resources (void * ap_prc)
   mp4dmuxflt_prc_t * p_prc = ap_prc;
   assert (p_prc);
   dealloc_output_stores (p_prc);
-  dealloc_input_store (p_prc);
-  dealloc_mp4v2 (p_prc);
+  dealloc_stream (p_prc);
   return OMX_ErrorNone;
 }
 
@@ -1082,26 +892,43 @@ mp4dmuxflt_prc_buffers_ready (const void * ap_prc)
 
   assert (p_prc);
 
-  TIZ_TRACE(handleOf(ap_prc), "buffer ready");
-
   tiz_check_omx (store_data (p_prc));
 
-  if (!p_prc->mp4v2_inited_)
+  if (!p_prc->stream_inited_)
     {
-      rc = alloc_mp4v2 (p_prc);
-      if (OMX_ErrorNotReady == rc)
+      if (mp4_stream_is_ready (p_prc->p_stream_))
+        {
+          rc = send_port_auto_detect_events (p_prc);
+          p_prc->stream_inited_ = true;
+        }
+      else if (tiz_filter_prc_is_eos (p_prc))
+        {
+          /* The whole stream has been received, but there was no 'moov' */
+          TIZ_ERROR (handleOf (p_prc), "[OMX_ErrorStreamCorruptFatal] : "
+                                       "no movie box found");
+          rc = OMX_ErrorStreamCorruptFatal;
+        }
+    }
+
+  if (p_prc->stream_inited_ && OMX_ErrorNone == rc)
+    {
+      tiz_check_omx (deliver_codec_metadata (
+        p_prc, ARATELIA_MP4_DEMUXER_FILTER_PORT_1_INDEX));
+      tiz_check_omx (deliver_codec_metadata (
+        p_prc, ARATELIA_MP4_DEMUXER_FILTER_PORT_2_INDEX));
+
+      if ((p_prc->audio_metadata_delivered_
+           || tiz_filter_prc_is_port_disabled (
+                p_prc, ARATELIA_MP4_DEMUXER_FILTER_PORT_1_INDEX))
+          && (p_prc->video_metadata_delivered_
+              || tiz_filter_prc_is_port_disabled (
+                   p_prc, ARATELIA_MP4_DEMUXER_FILTER_PORT_2_INDEX)))
         {
-          if (MP4V2_INT_MAX_FAILED_ATTEMPTS > p_prc->mp4v2_failed_init_count_)
+          rc = demux_stream (p_prc);
+          if (OMX_ErrorNotReady == rc)
             {
-              /* Need to wait for more stream data to be able to initialise the
-                 mp4v2 object */
               rc = OMX_ErrorNone;
             }
-          else
-            {
-              /* It's time to give up */
-              rc = OMX_ErrorStreamCorruptFatal;
-            }
         }
     }
 
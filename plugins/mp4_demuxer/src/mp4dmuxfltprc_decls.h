@@ -34,8 +34,6 @@ extern "C" {
 
 #include <stdbool.h>
 
-#include <mp4v2/mp4v2.h>
-
 #include <OMX_Core.h>
 
 #include <tizplatform.h>
@@ -43,23 +41,19 @@ extern "C" {
 #include <tizfilterprc.h>
 #include <tizfilterprc_decls.h>
 
-#include "mp4info.h"
+#include "mp4stream.h"
 
 typedef struct mp4dmuxflt_prc mp4dmuxflt_prc_t;
 struct mp4dmuxflt_prc
 {
   /* Object */
   const tiz_filter_prc_t _;
-  int tmp_fd_1_;
-  int tmp_fd_2_;
-  MP4FileHandle mp4v2_hdl_;
-  bool mp4v2_inited_;
-  uint64_t mp4v2_duration_;
-  mp4_track_type_t track_type_;
-  mp4_audio_type_t audio_type_;
-  mp4_video_type_t video_type_;
-  int mp4v2_failed_init_count_;
-  tiz_buffer_t * p_mp4_store_;
+  mp4_stream_t * p_stream_;
+  bool stream_inited_;
+  size_t sample_offset_;
+  bool adts_;
+  double first_data_ms_;
+  bool first_sample_delivered_;
   tiz_buffer_t * p_aud_store_;
   tiz_buffer_t * p_vid_store_;
   tiz_vector_t * p_aud_header_lengths_;
@@ -0,0 +1,1306 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   mp4stream.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Incremental MP4 box parser
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <string.h>
+
+#include <tizplatform.h>
+
+#include "mp4stream.h"
+
+#define MP4_STREAM_FOURCC(a, b, c, d)                                  \
+  (((uint32_t) (a) << 24) | ((uint32_t) (b) << 16) | ((uint32_t) (c) << 8) \
+   | (uint32_t) (d))
+
+#define MP4_STREAM_BOX_FTYP MP4_STREAM_FOURCC ('f', 't', 'y', 'p')
+#define MP4_STREAM_BOX_STYP MP4_STREAM_FOURCC ('s', 't', 'y', 'p')
+#define MP4_STREAM_BOX_MOOV MP4_STREAM_FOURCC ('m', 'o', 'o', 'v')
+#define MP4_STREAM_BOX_MDAT MP4_STREAM_FOURCC ('m', 'd', 'a', 't')
+#define MP4_STREAM_BOX_FREE MP4_STREAM_FOURCC ('f', 'r', 'e', 'e')
+#define MP4_STREAM_BOX_SKIP MP4_STREAM_FOURCC ('s', 'k', 'i', 'p')
+#define MP4_STREAM_BOX_WIDE MP4_STREAM_FOURCC ('w', 'i', 'd', 'e')
+#define MP4_STREAM_BOX_PDIN MP4_STREAM_FOURCC ('p', 'd', 'i', 'n')
+#define MP4_STREAM_BOX_TRAK MP4_STREAM_FOURCC ('t', 'r', 'a', 'k')
+#define MP4_STREAM_BOX_TKHD MP4_STREAM_FOURCC ('t', 'k', 'h', 'd')
+#define MP4_STREAM_BOX_MDIA MP4_STREAM_FOURCC ('m', 'd', 'i', 'a')
+#define MP4_STREAM_BOX_MDHD MP4_STREAM_FOURCC ('m', 'd', 'h', 'd')
+#define MP4_STREAM_BOX_HDLR MP4_STREAM_FOURCC ('h', 'd', 'l', 'r')
+#define MP4_STREAM_BOX_MINF MP4_STREAM_FOURCC ('m', 'i', 'n', 'f')
+#define MP4_STREAM_BOX_STBL MP4_STREAM_FOURCC ('s', 't', 'b', 'l')
+#define MP4_STREAM_BOX_STSD MP4_STREAM_FOURCC ('s', 't', 's', 'd')
+#define MP4_STREAM_BOX_STTS MP4_STREAM_FOURCC ('s', 't', 't', 's')
+#define MP4_STREAM_BOX_STSC MP4_STREAM_FOURCC ('s', 't', 's', 'c')
+#define MP4_STREAM_BOX_STSZ MP4_STREAM_FOURCC ('s', 't', 's', 'z')
+#define MP4_STREAM_BOX_STCO MP4_STREAM_FOURCC ('s', 't', 'c', 'o')
+#define MP4_STREAM_BOX_CO64 MP4_STREAM_FOURCC ('c', 'o', '6', '4')
+#define MP4_STREAM_BOX_ESDS MP4_STREAM_FOURCC ('e', 's', 'd', 's')
+#define MP4_STREAM_BOX_WAVE MP4_STREAM_FOURCC ('w', 'a', 'v', 'e')
+#define MP4_STREAM_BOX_AVCC MP4_STREAM_FOURCC ('a', 'v', 'c', 'C')
+
+#define MP4_STREAM_HDLR_SOUN MP4_STREAM_FOURCC ('s', 'o', 'u', 'n')
+#define MP4_STREAM_HDLR_VIDE MP4_STREAM_FOURCC ('v', 'i', 'd', 'e')
+
+#define MP4_STREAM_ENTRY_MP4A MP4_STREAM_FOURCC ('m', 'p', '4', 'a')
+#define MP4_STREAM_ENTRY_MP3 MP4_STREAM_FOURCC ('.', 'm', 'p', '3')
+#define MP4_STREAM_ENTRY_SAMR MP4_STREAM_FOURCC ('s', 'a', 'm', 'r')
+#define MP4_STREAM_ENTRY_SAWB MP4_STREAM_FOURCC ('s', 'a', 'w', 'b')
+#define MP4_STREAM_ENTRY_AVC1 MP4_STREAM_FOURCC ('a', 'v', 'c', '1')
+#define MP4_STREAM_ENTRY_AVC3 MP4_STREAM_FOURCC ('a', 'v', 'c', '3')
+#define MP4_STREAM_ENTRY_MP4V MP4_STREAM_FOURCC ('m', 'p', '4', 'v')
+
+/* Limits that stop a damaged stream from making us buffer without bound */
+#define MP4_STREAM_MAX_MOOV_SIZE (64 * 1024 * 1024)
+/* The sample data that may be held while waiting for a 'moov' that follows
+   it (see mp4_stream_set_max_mdat_buffered) */
+#define MP4_STREAM_DEFAULT_MAX_MDAT_BUFFERED (256 * 1024 * 1024)
+#define MP4_STREAM_MAX_SAMPLE_SIZE (16 * 1024 * 1024)
+#define MP4_STREAM_MIN_BUFFER_SIZE (64 * 1024)
+
+typedef struct mp4_stream_stsc mp4_stream_stsc_t;
+struct mp4_stream_stsc
+{
+  uint32_t first_chunk;
+  uint32_t samples_per_chunk;
+};
+
+typedef struct mp4_stream_stts mp4_stream_stts_t;
+struct mp4_stream_stts
+{
+  uint32_t count;
+  uint32_t delta;
+};
+
+typedef struct mp4_stream_track mp4_stream_track_t;
+struct mp4_stream_track
+{
+  mp4_stream_track_info_t info;
+  uint32_t handler;
+  uint8_t * p_config;
+  uint32_t fixed_size;
+  uint32_t * p_sizes;
+  uint64_t * p_chunks;
+  uint32_t nchunks;
+  mp4_stream_stsc_t * p_stsc;
+  uint32_t nstsc;
+  mp4_stream_stts_t * p_stts;
+  uint32_t nstts;
+  uint32_t aac_profile;
+  uint32_t aac_sf_index;
+  uint32_t aac_channels;
+  /* Sample cursor */
+  bool active;
+  uint32_t sample;
+  uint32_t chunk;
+  uint32_t chunk_sample;
+  uint32_t stsc_idx;
+  uint64_t offset;
+  uint32_t stts_idx;
+  uint32_t stts_left;
+  uint64_t dts;
+};
+
+struct mp4_stream
+{
+  /* The bytes held, i.e. stream offsets [base, base + len) */
+  uint8_t * p_buf;
+  size_t cap;
+  size_t head;
+  size_t len;
+  uint64_t base;
+  size_t peak;
+  /* Top-level box scanning */
+  uint64_t box_pos;
+  bool moov_done;
+  bool mdat_seen;
+  uint64_t mdat_pos;
+  size_t max_mdat_buffered;
+  /* Selected tracks */
+  mp4_stream_track_t audio;
+  mp4_stream_track_t video;
+  mp4_stream_track_t * p_current;
+};
+
+static inline uint16_t
+rd16 (const uint8_t * p)
+{
+  return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+static inline uint32_t
+rd32 (const uint8_t * p)
+{
+  return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16)
+         | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+static inline uint64_t
+rd64 (const uint8_t * p)
+{
+  return ((uint64_t) rd32 (p) << 32) | rd32 (p + 4);
+}
+
+static bool
+next_box (const uint8_t * ap_data, const size_t a_len, size_t * ap_pos,
+          uint32_t * ap_type, const uint8_t ** app_payload,
+          size_t * ap_payload_len)
+{
+  const size_t pos = *ap_pos;
+  uint64_t size = 0;
+  size_t hdr = 8;
+
+  if (pos > a_len || a_len - pos < 8)
+    {
+      return false;
+    }
+
+  size = rd32 (ap_data + pos);
+  *ap_type = rd32 (ap_data + pos + 4);
+  if (1 == size)
+    {
+      if (a_len - pos < 16)
+        {
+          return false;
+        }
+      size = rd64 (ap_data + pos + 8);
+      hdr = 16;
+    }
+  else if (0 == size)
+    {
+      /* The box extends to the end of its container */
+      size = a_len - pos;
+    }
+
+  if (size < hdr || size > a_len - pos)
+    {
+      return false;
+    }
+
+  *app_payload = ap_data + pos + hdr;
+  *ap_payload_len = (size_t) size - hdr;
+  *ap_pos = pos + (size_t) size;
+  return true;
+}
+
+static bool
+find_box (const uint8_t * ap_data, const size_t a_len, const uint32_t a_type,
+          const uint8_t ** app_payload, size_t * ap_payload_len)
+{
+  size_t pos = 0;
+  uint32_t type = 0;
+  while (next_box (ap_data, a_len, &pos, &type, app_payload, ap_payload_len))
+    {
+      if (a_type == type)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+static void
+free_track (mp4_stream_track_t * ap_track)
+{
+  assert (ap_track);
+  tiz_mem_free (ap_track->p_config);
+  tiz_mem_free (ap_track->p_sizes);
+  tiz_mem_free (ap_track->p_chunks);
+  tiz_mem_free (ap_track->p_stsc);
+  tiz_mem_free (ap_track->p_stts);
+  memset (ap_track, 0, sizeof (mp4_stream_track_t));
+}
+
+/*
+ * Sample description
+ */
+
+static uint32_t
+get_bits (const uint8_t * ap_data, const size_t a_len, size_t * ap_bit,
+          const unsigned int a_nbits, bool * ap_ok)
+{
+  uint32_t val = 0;
+  unsigned int i = 0;
+  for (i = 0; i < a_nbits; ++i, ++(*ap_bit))
+    {
+      if (*ap_bit / 8 >= a_len)
+        {
+          *ap_ok = false;
+          return 0;
+        }
+      val = (val << 1) | ((ap_data[*ap_bit / 8] >> (7 - *ap_bit % 8)) & 0x1);
+    }
+  return val;
+}
+
+static void
+parse_aac_config (mp4_stream_track_t * ap_track)
+{
+  static const uint32_t rates[]
+    = {96000, 88200, 64000, 48000, 44100, 32000, 24000,
+       22050, 16000, 12000, 11025, 8000,  7350};
+  const uint8_t * p_cfg = ap_track->p_config;
+  const size_t len = ap_track->info.config_len;
+  size_t bit = 0;
+  bool ok = true;
+  uint32_t aot = 0;
+  uint32_t sf_index = 0;
+  uint32_t channels = 0;
+
+  /* AudioSpecificConfig, see ISO/IEC 14496-3 */
+  aot = get_bits (p_cfg, len, &bit, 5, &ok);
+  if (31 == aot)
+    {
+      aot = 32 + get_bits (p_cfg, len, &bit, 6, &ok);
+    }
+  sf_index = get_bits (p_cfg, len, &bit, 4, &ok);
+  if (15 == sf_index)
+    {
+      (void) get_bits (p_cfg, len, &bit, 24, &ok);
+    }
+  channels = get_bits (p_cfg, len, &bit, 4, &ok);
+  if (5 == aot || 29 == aot)
+    {
+      /* Explicit SBR/PS signalling; ADTS carries the core profile */
+      if (15 == get_bits (p_cfg, len, &bit, 4, &ok))
+        {
+          (void) get_bits (p_cfg, len, &bit, 24, &ok);
+        }
+      aot = get_bits (p_cfg, len, &bit, 5, &ok);
+    }
+
+  if (ok && sf_index < sizeof (rates) / sizeof (rates[0]))
+    {
+      if (0 == ap_track->info.sample_rate)
+        {
+          ap_track->info.sample_rate = rates[sf_index];
+        }
+      if (channels > 0)
+        {
+          ap_track->info.channels = channels;
+        }
+      ap_track->aac_profile = aot;
+      ap_track->aac_sf_index = sf_index;
+      ap_track->aac_channels = channels;
+      ap_track->info.adts = (aot >= 1 && aot <= 4 && channels > 0 && channels < 8);
+    }
+}
+
+static bool
+read_descriptor (const uint8_t ** app_data, size_t * ap_len, uint8_t * ap_tag,
+                 size_t * ap_desc_len)
+{
+  const uint8_t * p = *app_data;
+  size_t len = *ap_len;
+  size_t desc_len = 0;
+  int i = 0;
+
+  if (len < 2)
+    {
+      return false;
+    }
+  *ap_tag = *p++;
+  --len;
+  for (i = 0;; ++i)
+    {
+      uint8_t b = 0;
+      if (4 == i || 0 == len)
+        {
+          return false;
+        }
+      b = *p++;
+      --len;
+      desc_len = (desc_len << 7) | (b & 0x7F);
+      if (!(b & 0x80))
+        {
+          break;
+        }
+    }
+  if (desc_len > len)
+    {
+      return false;
+    }
+  *app_data = p;
+  *ap_len = desc_len;
+  *ap_desc_len = desc_len;
+  return true;
+}
+
+static OMX_ERRORTYPE
+copy_config (mp4_stream_track_t * ap_track, const uint8_t * ap_data,
+             const size_t a_len)
+{
+  tiz_mem_free (ap_track->p_config);
+  ap_track->p_config = NULL;
+  ap_track->info.p_config = NULL;
+  ap_track->info.config_len = 0;
+  if (a_len > 0)
+    {
+      ap_track->p_config = tiz_mem_alloc (a_len);
+      tiz_check_null_ret_oom (ap_track->p_config);
+      memcpy (ap_track->p_config, ap_data, a_len);
+      ap_track->info.p_config = ap_track->p_config;
+      ap_track->info.config_len = a_len;
+    }
+  return OMX_ErrorNone;
+}
+
+/* On return, ap_oti holds the objectTypeIndication, or 0 if the box could not
+   be parsed */
+static OMX_ERRORTYPE
+parse_esds (mp4_stream_track_t * ap_track, const uint8_t * ap_data,
+            size_t a_len, uint8_t * ap_oti)
+{
+  const uint8_t * p = ap_data;
+  size_t len = a_len;
+  size_t desc_len = 0;
+  uint8_t tag = 0;
+  uint8_t flags = 0;
+
+  *ap_oti = 0;
+
+  /* Skip version and flags */
+  if (len < 4)
+    {
+      return OMX_ErrorNone;
+    }
+  p += 4;
+  len -= 4;
+
+  /* ES_Descriptor */
+  if (!read_descriptor (&p, &len, &tag, &desc_len) || 0x03 != tag || len < 3)
+    {
+      return OMX_ErrorNone;
+    }
+  flags = p[2];
+  p += 3;
+  len -= 3;
+  if (flags & 0x80)
+    {
+      if (len < 2)
+        {
+          return OMX_ErrorNone;
+        }
+      p += 2;
+      len -= 2;
+    }
+  if (flags & 0x40)
+    {
+      if (len < 1 || len < 1 + (size_t) p[0])
+        {
+          return OMX_ErrorNone;
+        }
+      len -= 1 + p[0];
+      p += 1 + p[0];
+    }
+  if (flags & 0x20)
+    {
+      if (len < 2)
+        {
+          return OMX_ErrorNone;
+        }
+      p += 2;
+      len -= 2;
+    }
+
+  /* DecoderConfigDescriptor */
+  if (!read_descriptor (&p, &len, &tag, &desc_len) || 0x04 != tag || len < 13)
+    {
+      return OMX_ErrorNone;
+    }
+  *ap_oti = p[0];
+  p += 13;
+  len -= 13;
+
+  /* DecoderSpecificInfo (optional) */
+  if (read_descriptor (&p, &len, &tag, &desc_len) && 0x05 == tag)
+    {
+      return copy_config (ap_track, p, desc_len);
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+parse_audio_entry (mp4_stream_track_t * ap_track, const uint32_t a_type,
+                   const uint8_t * ap_data, const size_t a_len)
+{
+  size_t children = 28;
+  uint16_t version = 0;
+
+  if (a_len < children)
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+
+  version = rd16 (ap_data + 8);
+  ap_track->info.channels = rd16 (ap_data + 16);
+  ap_track->info.sample_rate = rd32 (ap_data + 24) >> 16;
+
+  /* QuickTime sound description versions 1 and 2 are longer */
+  if (1 == version)
+    {
+      children += 16;
+    }
+  else if (2 == version)
+    {
+      children += 36;
+      ap_track->info.sample_rate = 0;
+    }
+  if (a_len < children)
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+
+  if (MP4_STREAM_ENTRY_MP4A == a_type)
+    {
+      const uint8_t * p_box = NULL;
+      size_t box_len = 0;
+      uint8_t oti = 0;
+      if (find_box (ap_data + children, a_len - children, MP4_STREAM_BOX_ESDS,
+                    &p_box, &box_len)
+          || (find_box (ap_data + children, a_len - children,
+                        MP4_STREAM_BOX_WAVE, &p_box, &box_len)
+              && find_box (p_box, box_len, MP4_STREAM_BOX_ESDS, &p_box,
+                           &box_len)))
+        {
+          tiz_check_omx (parse_esds (ap_track, p_box, box_len, &oti));
+        }
+      switch (oti)
+        {
+          case 0x40:
+          case 0x66:
+          case 0x67:
+          case 0x68:
+            {
+              ap_track->info.codec = mp4_stream_codec_aac;
+              parse_aac_config (ap_track);
+            }
+            break;
+          case 0x69:
+          case 0x6B:
+            {
+              ap_track->info.codec = mp4_stream_codec_mp3;
+            }
+            break;
+          default:
+            break;
+        };
+    }
+  else if (MP4_STREAM_ENTRY_MP3 == a_type)
+    {
+      ap_track->info.codec = mp4_stream_codec_mp3;
+    }
+  else if (MP4_STREAM_ENTRY_SAMR == a_type)
+    {
+      ap_track->info.codec = mp4_stream_codec_amr;
+    }
+  else if (MP4_STREAM_ENTRY_SAWB == a_type)
+    {
+      ap_track->info.codec = mp4_stream_codec_amrwb;
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+parse_video_entry (mp4_stream_track_t * ap_track, const uint32_t a_type,
+                   const uint8_t * ap_data, const size_t a_len)
+{
+  const size_t children = 78;
+  const uint8_t * p_box = NULL;
+  size_t box_len = 0;
+
+  if (a_len < children)
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+
+  ap_track->info.width = rd16 (ap_data + 24);
+  ap_track->info.height = rd16 (ap_data + 26);
+
+  if (MP4_STREAM_ENTRY_AVC1 == a_type || MP4_STREAM_ENTRY_AVC3 == a_type)
+    {
+      ap_track->info.codec = mp4_stream_codec_avc;
+      if (find_box (ap_data + children, a_len - children, MP4_STREAM_BOX_AVCC,
+                    &p_box, &box_len))
+        {
+          tiz_check_omx (copy_config (ap_track, p_box, box_len));
+        }
+    }
+  else if (MP4_STREAM_ENTRY_MP4V == a_type
+           && find_box (ap_data + children, a_len - children,
+                        MP4_STREAM_BOX_ESDS, &p_box, &box_len))
+    {
+      uint8_t oti = 0;
+      tiz_check_omx (parse_esds (ap_track, p_box, box_len, &oti));
+      if (0x20 == oti)
+        {
+          ap_track->info.codec = mp4_stream_codec_mpeg4;
+        }
+      else if (oti >= 0x60 && oti <= 0x65)
+        {
+          ap_track->info.codec = mp4_stream_codec_mpeg2;
+        }
+      else if (0x6A == oti)
+        {
+          ap_track->info.codec = mp4_stream_codec_mpeg1;
+        }
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+parse_stsd (mp4_stream_track_t * ap_track, const uint8_t * ap_data,
+            const size_t a_len)
+{
+  size_t pos = 8;
+  uint32_t type = 0;
+  const uint8_t * p_entry = NULL;
+  size_t entry_len = 0;
+
+  /* Only the first sample description is used */
+  if (a_len < 8 || 0 == rd32 (ap_data + 4)
+      || !next_box (ap_data, a_len, &pos, &type, &p_entry, &entry_len))
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+
+  if (MP4_STREAM_HDLR_SOUN == ap_track->handler)
+    {
+      return parse_audio_entry (ap_track, type, p_entry, entry_len);
+    }
+  return parse_video_entry (ap_track, type, p_entry, entry_len);
+}
+
+/*
+ * Sample tables
+ */
+
+static OMX_ERRORTYPE
+parse_stts (mp4_stream_track_t * ap_track, const uint8_t * ap_data,
+            const size_t a_len)
+{
+  uint32_t count = 0;
+  uint32_t i = 0;
+  if (a_len < 8 || (count = rd32 (ap_data + 4)) > (a_len - 8) / 8)
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+  if (count > 0)
+    {
+      ap_track->p_stts = tiz_mem_alloc (count * sizeof (mp4_stream_stts_t));
+      tiz_check_null_ret_oom (ap_track->p_stts);
+      for (i = 0; i < count; ++i)
+        {
+          ap_track->p_stts[i].count = rd32 (ap_data + 8 + i * 8);
+          ap_track->p_stts[i].delta = rd32 (ap_data + 12 + i * 8);
+        }
+    }
+  ap_track->nstts = count;
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+parse_stsc (mp4_stream_track_t * ap_track, const uint8_t * ap_data,
+            const size_t a_len)
+{
+  uint32_t count = 0;
+  uint32_t i = 0;
+  if (a_len < 8 || 0 == (count = rd32 (ap_data + 4))
+      || count > (a_len - 8) / 12)
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+  ap_track->p_stsc = tiz_mem_alloc (count * sizeof (mp4_stream_stsc_t));
+  tiz_check_null_ret_oom (ap_track->p_stsc);
+  for (i = 0; i < count; ++i)
+    {
+      ap_track->p_stsc[i].first_chunk = rd32 (ap_data + 8 + i * 12);
+      ap_track->p_stsc[i].samples_per_chunk = rd32 (ap_data + 12 + i * 12);
+    }
+  ap_track->nstsc = count;
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+parse_stsz (mp4_stream_track_t * ap_track, const uint8_t * ap_data,
+            const size_t a_len)
+{
+  uint32_t count = 0;
+  uint32_t i = 0;
+  if (a_len < 12 || 0 == (count = rd32 (ap_data + 8)))
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+  ap_track->fixed_size = rd32 (ap_data + 4);
+  if (0 == ap_track->fixed_size)
+    {
+      if (count > (a_len - 12) / 4)
+        {
+          return OMX_ErrorStreamCorrupt;
+        }
+      ap_track->p_sizes = tiz_mem_alloc (count * sizeof (uint32_t));
+      tiz_check_null_ret_oom (ap_track->p_sizes);
+      for (i = 0; i < count; ++i)
+        {
+          ap_track->p_sizes[i] = rd32 (ap_data + 12 + i * 4);
+        }
+    }
+  ap_track->info.nsamples = count;
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+parse_chunk_offsets (mp4_stream_track_t * ap_track, const uint8_t * ap_data,
+                     const size_t a_len, const size_t a_entry_len)
+{
+  uint32_t count = 0;
+  uint32_t i = 0;
+  if (a_len < 8 || 0 == (count = rd32 (ap_data + 4))
+      || count > (a_len - 8) / a_entry_len)
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+  ap_track->p_chunks = tiz_mem_alloc (count * sizeof (uint64_t));
+  tiz_check_null_ret_oom (ap_track->p_chunks);
+  for (i = 0; i < count; ++i)
+    {
+      const uint8_t * p = ap_data + 8 + i * a_entry_len;
+      ap_track->p_chunks[i] = (8 == a_entry_len ? rd64 (p) : rd32 (p));
+    }
+  ap_track->nchunks = count;
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+parse_stbl (mp4_stream_track_t * ap_track, const uint8_t * ap_data,
+            const size_t a_len)
+{
+  const uint8_t * p_box = NULL;
+  size_t box_len = 0;
+
+  if (!find_box (ap_data, a_len, MP4_STREAM_BOX_STSD, &p_box, &box_len))
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+  tiz_check_omx (parse_stsd (ap_track, p_box, box_len));
+
+  if (find_box (ap_data, a_len, MP4_STREAM_BOX_STTS, &p_box, &box_len))
+    {
+      tiz_check_omx (parse_stts (ap_track, p_box, box_len));
+    }
+
+  if (!find_box (ap_data, a_len, MP4_STREAM_BOX_STSC, &p_box, &box_len))
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+  tiz_check_omx (parse_stsc (ap_track, p_box, box_len));
+
+  if (!find_box (ap_data, a_len, MP4_STREAM_BOX_STSZ, &p_box, &box_len))
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+  tiz_check_omx (parse_stsz (ap_track, p_box, box_len));
+
+  if (find_box (ap_data, a_len, MP4_STREAM_BOX_STCO, &p_box, &box_len))
+    {
+      return parse_chunk_offsets (ap_track, p_box, box_len, 4);
+    }
+  if (find_box (ap_data, a_len, MP4_STREAM_BOX_CO64, &p_box, &box_len))
+    {
+      return parse_chunk_offsets (ap_track, p_box, box_len, 8);
+    }
+  return OMX_ErrorStreamCorrupt;
+}
+
+static OMX_ERRORTYPE
+parse_mdia (mp4_stream_track_t * ap_track, const uint8_t * ap_data,
+            const size_t a_len)
+{
+  const uint8_t * p_box = NULL;
+  size_t box_len = 0;
+
+  if (find_box (ap_data, a_len, MP4_STREAM_BOX_MDHD, &p_box, &box_len)
+      && box_len >= 20)
+    {
+      if (1 == p_box[0] && box_len >= 32)
+        {
+          ap_track->info.timescale = rd32 (p_box + 20);
+          ap_track->info.duration = rd64 (p_box + 24);
+        }
+      else
+        {
+          ap_track->info.timescale = rd32 (p_box + 12);
+          ap_track->info.duration = rd32 (p_box + 16);
+        }
+    }
+
+  if (!find_box (ap_data, a_len, MP4_STREAM_BOX_HDLR, &p_box, &box_len)
+      || box_len < 12)
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+  ap_track->handler = rd32 (p_box + 8);
+  if (MP4_STREAM_HDLR_SOUN != ap_track->handler
+      && MP4_STREAM_HDLR_VIDE != ap_track->handler)
+    {
+      /* Not a track we are interested in */
+      return OMX_ErrorStreamCorrupt;
+    }
+
+  if (!find_box (ap_data, a_len, MP4_STREAM_BOX_MINF, &p_box, &box_len)
+      || !find_box (p_box, box_len, MP4_STREAM_BOX_STBL, &p_box, &box_len))
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+  return parse_stbl (ap_track, p_box, box_len);
+}
+
+static OMX_ERRORTYPE
+parse_trak (mp4_stream_t * ap_stream, const uint8_t * ap_data,
+            const size_t a_len)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  mp4_stream_track_t track;
+  mp4_stream_track_t * p_slot = NULL;
+  const uint8_t * p_box = NULL;
+  size_t box_len = 0;
+
+  memset (&track, 0, sizeof (track));
+
+  if (find_box (ap_data, a_len, MP4_STREAM_BOX_TKHD, &p_box, &box_len)
+      && box_len >= 24)
+    {
+      track.info.id = rd32 (p_box + (1 == p_box[0] ? 20 : 12));
+    }
+
+  if (!find_box (ap_data, a_len, MP4_STREAM_BOX_MDIA, &p_box, &box_len))
+    {
+      return OMX_ErrorNone;
+    }
+
+  rc = parse_mdia (&track, p_box, box_len);
+  if (OMX_ErrorNone == rc && mp4_stream_codec_unknown != track.info.codec)
+    {
+      p_slot = (MP4_STREAM_HDLR_SOUN == track.handler) ? &(ap_stream->audio)
+                                                        : &(ap_stream->video);
+      if (mp4_stream_codec_unknown == p_slot->info.codec)
+        {
+          *p_slot = track;
+          return OMX_ErrorNone;
+        }
+    }
+
+  /* Tracks that can not be used, and the second and following tracks of each
+     type, are just ignored */
+  free_track (&track);
+  return (OMX_ErrorInsufficientResources == rc ? rc : OMX_ErrorNone);
+}
+
+static OMX_ERRORTYPE
+parse_moov (mp4_stream_t * ap_stream, const uint8_t * ap_data,
+            const size_t a_len)
+{
+  size_t pos = 0;
+  uint32_t type = 0;
+  const uint8_t * p_box = NULL;
+  size_t box_len = 0;
+
+  while (next_box (ap_data, a_len, &pos, &type, &p_box, &box_len))
+    {
+      if (MP4_STREAM_BOX_TRAK == type)
+        {
+          tiz_check_omx (parse_trak (ap_stream, p_box, box_len));
+        }
+    }
+
+  if (mp4_stream_codec_unknown == ap_stream->audio.info.codec
+      && mp4_stream_codec_unknown == ap_stream->video.info.codec)
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+  return OMX_ErrorNone;
+}
+
+/*
+ * Sample cursors
+ */
+
+static uint32_t
+chunk_samples (mp4_stream_track_t * ap_track)
+{
+  while (ap_track->stsc_idx + 1 < ap_track->nstsc
+         && ap_track->chunk + 1
+              >= ap_track->p_stsc[ap_track->stsc_idx + 1].first_chunk)
+    {
+      ++ap_track->stsc_idx;
+    }
+  return ap_track->p_stsc[ap_track->stsc_idx].samples_per_chunk;
+}
+
+static void
+settle_cursor (mp4_stream_track_t * ap_track)
+{
+  if (ap_track->sample >= ap_track->info.nsamples)
+    {
+      ap_track->active = false;
+    }
+  while (ap_track->active
+         && ap_track->chunk_sample >= chunk_samples (ap_track))
+    {
+      ap_track->chunk_sample = 0;
+      if (++ap_track->chunk >= ap_track->nchunks)
+        {
+          /* The sample tables are shorter than the sample count */
+          ap_track->active = false;
+        }
+      else
+        {
+          ap_track->offset = ap_track->p_chunks[ap_track->chunk];
+        }
+    }
+}
+
+static void
+load_stts_entry (mp4_stream_track_t * ap_track)
+{
+  while (ap_track->stts_idx < ap_track->nstts
+         && 0 == (ap_track->stts_left
+                  = ap_track->p_stts[ap_track->stts_idx].count))
+    {
+      ++ap_track->stts_idx;
+    }
+}
+
+static void
+start_cursor (mp4_stream_track_t * ap_track)
+{
+  ap_track->active = (mp4_stream_codec_unknown != ap_track->info.codec);
+  ap_track->sample = 0;
+  ap_track->chunk = 0;
+  ap_track->chunk_sample = 0;
+  ap_track->stsc_idx = 0;
+  ap_track->offset = ap_track->active ? ap_track->p_chunks[0] : 0;
+  ap_track->stts_idx = 0;
+  ap_track->stts_left = 0;
+  ap_track->dts = 0;
+  if (ap_track->active)
+    {
+      load_stts_entry (ap_track);
+      settle_cursor (ap_track);
+    }
+}
+
+static inline uint32_t
+sample_size (const mp4_stream_track_t * ap_track)
+{
+  return ap_track->fixed_size ? ap_track->fixed_size
+                              : ap_track->p_sizes[ap_track->sample];
+}
+
+static void
+advance_cursor (mp4_stream_track_t * ap_track)
+{
+  assert (ap_track->active);
+  ap_track->offset += sample_size (ap_track);
+  ++ap_track->sample;
+  ++ap_track->chunk_sample;
+  if (ap_track->stts_idx < ap_track->nstts)
+    {
+      ap_track->dts += ap_track->p_stts[ap_track->stts_idx].delta;
+      if (0 == --ap_track->stts_left)
+        {
+          ++ap_track->stts_idx;
+          load_stts_entry (ap_track);
+        }
+    }
+  settle_cursor (ap_track);
+}
+
+static mp4_stream_track_t *
+next_track (mp4_stream_t * ap_stream)
+{
+  mp4_stream_track_t * p_aud = &(ap_stream->audio);
+  mp4_stream_track_t * p_vid = &(ap_stream->video);
+  if (p_aud->active && p_vid->active)
+    {
+      return (p_aud->offset <= p_vid->offset) ? p_aud : p_vid;
+    }
+  return p_aud->active ? p_aud : (p_vid->active ? p_vid : NULL);
+}
+
+/*
+ * Stream buffer
+ */
+
+static void
+trim_buffer (mp4_stream_t * ap_stream)
+{
+  const uint64_t end = ap_stream->base + ap_stream->len;
+  uint64_t keep = ap_stream->box_pos;
+
+  if (ap_stream->moov_done)
+    {
+      mp4_stream_track_t * p_track = next_track (ap_stream);
+      keep = p_track ? p_track->offset : end;
+    }
+  else if (ap_stream->mdat_seen)
+    {
+      /* The sample data needs to be kept until the 'moov' arrives */
+      keep = ap_stream->mdat_pos;
+    }
+
+  if (keep > end)
+    {
+      keep = end;
+    }
+  if (keep > ap_stream->base)
+    {
+      const size_t ndrop = (size_t) (keep - ap_stream->base);
+      ap_stream->head += ndrop;
+      ap_stream->len -= ndrop;
+      ap_stream->base = keep;
+    }
+  if (0 == ap_stream->len)
+    {
+      ap_stream->head = 0;
+    }
+}
+
+static OMX_ERRORTYPE
+append_data (mp4_stream_t * ap_stream, const uint8_t * ap_data,
+             const size_t a_len)
+{
+  if (ap_stream->head + ap_stream->len + a_len > ap_stream->cap)
+    {
+      if (ap_stream->head > 0)
+        {
+          memmove (ap_stream->p_buf, ap_stream->p_buf + ap_stream->head,
+                   ap_stream->len);
+          ap_stream->head = 0;
+        }
+      if (ap_stream->len + a_len > ap_stream->cap)
+        {
+          size_t cap = ap_stream->cap ? ap_stream->cap
+                                      : MP4_STREAM_MIN_BUFFER_SIZE;
+          uint8_t * p_buf = NULL;
+          while (cap < ap_stream->len + a_len)
+            {
+              cap *= 2;
+            }
+          p_buf = tiz_mem_realloc (ap_stream->p_buf, cap);
+          tiz_check_null_ret_oom (p_buf);
+          ap_stream->p_buf = p_buf;
+          ap_stream->cap = cap;
+        }
+    }
+  memcpy (ap_stream->p_buf + ap_stream->head + ap_stream->len, ap_data, a_len);
+  ap_stream->len += a_len;
+  if (ap_stream->len > ap_stream->peak)
+    {
+      ap_stream->peak = ap_stream->len;
+    }
+  return OMX_ErrorNone;
+}
+
+static bool
+is_top_level_box (const uint32_t a_type)
+{
+  return (MP4_STREAM_BOX_FTYP == a_type || MP4_STREAM_BOX_STYP == a_type
+          || MP4_STREAM_BOX_MOOV == a_type || MP4_STREAM_BOX_MDAT == a_type
+          || MP4_STREAM_BOX_FREE == a_type || MP4_STREAM_BOX_SKIP == a_type
+          || MP4_STREAM_BOX_WIDE == a_type || MP4_STREAM_BOX_PDIN == a_type);
+}
+
+static OMX_ERRORTYPE
+scan_boxes (mp4_stream_t * ap_stream)
+{
+  while (!ap_stream->moov_done)
+    {
+      const uint64_t end = ap_stream->base + ap_stream->len;
+      const uint8_t * p_box = NULL;
+      uint64_t size = 0;
+      uint32_t type = 0;
+      size_t hdr = 8;
+
+      if (ap_stream->box_pos + 8 > end)
+        {
+          break;
+        }
+
+      assert (ap_stream->box_pos >= ap_stream->base);
+      p_box = ap_stream->p_buf + ap_stream->head
+              + (size_t) (ap_stream->box_pos - ap_stream->base);
+      size = rd32 (p_box);
+      type = rd32 (p_box + 4);
+
+      if (0 == ap_stream->box_pos && !is_top_level_box (type))
+        {
+          /* This is not an MP4 stream */
+          return OMX_ErrorStreamCorrupt;
+        }
+
+      if (1 == size)
+        {
+          if (ap_stream->box_pos + 16 > end)
+            {
+              break;
+            }
+          size = rd64 (p_box + 8);
+          hdr = 16;
+        }
+
+      /* NOTE: This also rejects a box of size 0 (i.e. one that extends to
+         the end of the stream), as the 'moov' could not follow it */
+      if (size < hdr)
+        {
+          return OMX_ErrorStreamCorrupt;
+        }
+
+      if (MP4_STREAM_BOX_MOOV == type)
+        {
+          if (size > MP4_STREAM_MAX_MOOV_SIZE)
+            {
+              return OMX_ErrorStreamCorrupt;
+            }
+          if (ap_stream->box_pos + size > end)
+            {
+              /* Wait for the rest of the box */
+              break;
+            }
+          tiz_check_omx (parse_moov (ap_stream, p_box + hdr,
+                                     (size_t) size - hdr));
+          ap_stream->moov_done = true;
+          start_cursor (&(ap_stream->audio));
+          start_cursor (&(ap_stream->video));
+        }
+      else if (MP4_STREAM_BOX_MDAT == type && !ap_stream->mdat_seen)
+        {
+          ap_stream->mdat_seen = true;
+          ap_stream->mdat_pos = ap_stream->box_pos + hdr;
+        }
+      ap_stream->box_pos += size;
+    }
+  return OMX_ErrorNone;
+}
+
+/*
+ * API
+ */
+
+OMX_ERRORTYPE
+mp4_stream_init (mp4_stream_t ** app_stream)
+{
+  mp4_stream_t * p_stream = NULL;
+  assert (app_stream);
+  p_stream = tiz_mem_calloc (1, sizeof (mp4_stream_t));
+  tiz_check_null_ret_oom (p_stream);
+  p_stream->max_mdat_buffered = MP4_STREAM_DEFAULT_MAX_MDAT_BUFFERED;
+  *app_stream = p_stream;
+  return OMX_ErrorNone;
+}
+
+void
+mp4_stream_destroy (mp4_stream_t * ap_stream)
+{
+  if (ap_stream)
+    {
+      mp4_stream_reset (ap_stream);
+      tiz_mem_free (ap_stream->p_buf);
+      tiz_mem_free (ap_stream);
+    }
+}
+
+void
+mp4_stream_set_max_mdat_buffered (mp4_stream_t * ap_stream, size_t a_max)
+{
+  assert (ap_stream);
+  ap_stream->max_mdat_buffered
+    = a_max > 0 ? a_max : MP4_STREAM_DEFAULT_MAX_MDAT_BUFFERED;
+}
+
+void
+mp4_stream_reset (mp4_stream_t * ap_stream)
+{
+  if (ap_stream)
+    {
+      free_track (&(ap_stream->audio));
+      free_track (&(ap_stream->video));
+      ap_stream->p_current = NULL;
+      ap_stream->head = 0;
+      ap_stream->len = 0;
+      ap_stream->base = 0;
+      ap_stream->peak = 0;
+      ap_stream->box_pos = 0;
+      ap_stream->moov_done = false;
+      ap_stream->mdat_seen = false;
+      ap_stream->mdat_pos = 0;
+    }
+}
+
+OMX_ERRORTYPE
+mp4_stream_push (mp4_stream_t * ap_stream, const uint8_t * ap_data,
+                 size_t a_len)
+{
+  assert (ap_stream);
+  assert (ap_data || 0 == a_len);
+  if (a_len > 0)
+    {
+      /* The 'moov' follows the sample data, which is all kept until then */
+      if (ap_stream->mdat_seen && !ap_stream->moov_done
+          && ap_stream->len + a_len > ap_stream->max_mdat_buffered)
+        {
+          return OMX_ErrorInsufficientResources;
+        }
+      tiz_check_omx (append_data (ap_stream, ap_data, a_len));
+      tiz_check_omx (scan_boxes (ap_stream));
+      trim_buffer (ap_stream);
+    }
+  return OMX_ErrorNone;
+}
+
+bool
+mp4_stream_is_ready (const mp4_stream_t * ap_stream)
+{
+  assert (ap_stream);
+  return ap_stream->moov_done;
+}
+
+const mp4_stream_track_info_t *
+mp4_stream_audio_track (const mp4_stream_t * ap_stream)
+{
+  assert (ap_stream);
+  return (mp4_stream_codec_unknown != ap_stream->audio.info.codec
+            ? &(ap_stream->audio.info)
+            : NULL);
+}
+
+const mp4_stream_track_info_t *
+mp4_stream_video_track (const mp4_stream_t * ap_stream)
+{
+  assert (ap_stream);
+  return (mp4_stream_codec_unknown != ap_stream->video.info.codec
+            ? &(ap_stream->video.info)
+            : NULL);
+}
+
+OMX_ERRORTYPE
+mp4_stream_peek_sample (mp4_stream_t * ap_stream,
+                        mp4_stream_sample_t * ap_sample)
+{
+  mp4_stream_track_t * p_track = NULL;
+  uint32_t size = 0;
+
+  assert (ap_stream);
+  assert (ap_sample);
+
+  ap_stream->p_current = NULL;
+  if (!ap_stream->moov_done)
+    {
+      return OMX_ErrorNotReady;
+    }
+  if (!(p_track = next_track (ap_stream)))
+    {
+      return OMX_ErrorNoMore;
+    }
+
+  ap_stream->p_current = p_track;
+  size = sample_size (p_track);
+  if (size > MP4_STREAM_MAX_SAMPLE_SIZE || p_track->offset < ap_stream->base)
+    {
+      return OMX_ErrorStreamCorrupt;
+    }
+  if (p_track->offset - ap_stream->base > ap_stream->len
+      || size > ap_stream->len - (p_track->offset - ap_stream->base))
+    {
+      return OMX_ErrorNotReady;
+    }
+
+  ap_sample->is_audio = (p_track == &(ap_stream->audio));
+  ap_sample->p_data = ap_stream->p_buf + ap_stream->head
+                      + (size_t) (p_track->offset - ap_stream->base);
+  ap_sample->len = size;
+  ap_sample->dts_us
+    = p_track->info.timescale
+        ? (p_track->dts * 1000000) / p_track->info.timescale
+        : 0;
+  return OMX_ErrorNone;
+}
+
+void
+mp4_stream_next_sample (mp4_stream_t * ap_stream)
+{
+  assert (ap_stream);
+  if (ap_stream->p_current && ap_stream->p_current->active)
+    {
+      advance_cursor (ap_stream->p_current);
+      ap_stream->p_current = NULL;
+      trim_buffer (ap_stream);
+    }
+}
+
+void
+mp4_stream_adts_header (const mp4_stream_t * ap_stream, size_t a_len,
+                        uint8_t * ap_hdr)
+{
+  const mp4_stream_track_t * p_track = NULL;
+  const size_t frame_len = a_len + MP4_STREAM_ADTS_HEADER_LEN;
+
+  assert (ap_stream);
+  assert (ap_hdr);
+  assert (ap_stream->audio.info.adts);
+  assert (frame_len <= MP4_STREAM_ADTS_MAX_FRAME_LEN);
+
+  p_track = &(ap_stream->audio);
+
+  ap_hdr[0] = 0xFF;
+  ap_hdr[1] = 0xF1; /* MPEG-4, no CRC */
+  ap_hdr[2] = (uint8_t) (((p_track->aac_profile - 1) << 6)
+                         | (p_track->aac_sf_index << 2)
+                         | ((p_track->aac_channels >> 2) & 0x1));
+  ap_hdr[3] = (uint8_t) (((p_track->aac_channels & 0x3) << 6)
+                         | ((frame_len >> 11) & 0x3));
+  ap_hdr[4] = (uint8_t) ((frame_len >> 3) & 0xFF);
+  ap_hdr[5] = (uint8_t) (((frame_len & 0x7) << 5) | 0x1F);
+  ap_hdr[6] = 0xFC;
+}
+
+uint64_t
+mp4_stream_received (const mp4_stream_t * ap_stream)
+{
+  assert (ap_stream);
+  return ap_stream->base + ap_stream->len;
+}
+
+size_t
+mp4_stream_peak_buffered (const mp4_stream_t * ap_stream)
+{
+  assert (ap_stream);
+  return ap_stream->peak;
+}
@@ -0,0 +1,164 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   mp4stream.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Incremental MP4 box parser
+ *
+ * The parser is fed with the stream bytes as they arrive. It buffers the
+ * 'moov' box, builds the sample tables of the first audio and the first video
+ * tracks, and then hands out the samples in file order as soon as their bytes
+ * are available. Bytes that are no longer needed are discarded, so with a
+ * 'moov' that precedes the 'mdat' the amount of data held is bounded by the
+ * track interleaving. When the 'moov' is at the end of the file, the 'mdat'
+ * payload needs to be kept in memory until the 'moov' arrives.
+ *
+ */
+
+#ifndef MP4STREAM_H
+#define MP4STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+#define MP4_STREAM_ADTS_HEADER_LEN 7
+/* ADTS frame lengths (header included) are 13-bit values */
+#define MP4_STREAM_ADTS_MAX_FRAME_LEN 8191
+
+typedef enum mp4_stream_codec mp4_stream_codec_t;
+enum mp4_stream_codec
+{
+  mp4_stream_codec_unknown,
+  mp4_stream_codec_aac,
+  mp4_stream_codec_mp3,
+  mp4_stream_codec_amr,
+  mp4_stream_codec_amrwb,
+  mp4_stream_codec_avc,
+  mp4_stream_codec_mpeg4,
+  mp4_stream_codec_mpeg2,
+  mp4_stream_codec_mpeg1
+};
+
+typedef struct mp4_stream_track_info mp4_stream_track_info_t;
+struct mp4_stream_track_info
+{
+  uint32_t id;
+  mp4_stream_codec_t codec;
+  uint32_t timescale;
+  uint64_t duration;
+  uint32_t nsamples;
+  uint32_t sample_rate;
+  uint32_t channels;
+  uint32_t width;
+  uint32_t height;
+  /* Decoder configuration: the AudioSpecificConfig or DecoderSpecificInfo
+     from 'esds', or the contents of 'avcC' */
+  const uint8_t * p_config;
+  size_t config_len;
+  /* Whether the samples of an AAC track can be framed as ADTS */
+  bool adts;
+};
+
+typedef struct mp4_stream_sample mp4_stream_sample_t;
+struct mp4_stream_sample
+{
+  bool is_audio;
+  const uint8_t * p_data;
+  size_t len;
+  uint64_t dts_us;
+};
+
+typedef struct mp4_stream mp4_stream_t;
+
+OMX_ERRORTYPE
+mp4_stream_init (mp4_stream_t ** app_stream);
+
+void
+mp4_stream_destroy (mp4_stream_t * ap_stream);
+
+void
+mp4_stream_reset (mp4_stream_t * ap_stream);
+
+/* Limit the bytes held while the 'moov' box is expected after the sample
+   data (0 restores the default, 256 MiB) */
+void
+mp4_stream_set_max_mdat_buffered (mp4_stream_t * ap_stream, size_t a_max);
+
+/* Append stream bytes, and parse as much of them as possible. Returns
+   OMX_ErrorStreamCorrupt if the data is not a valid MP4 stream, or
+   OMX_ErrorInsufficientResources if the 'moov' box has not arrived within
+   the limit set with mp4_stream_set_max_mdat_buffered. */
+OMX_ERRORTYPE
+mp4_stream_push (mp4_stream_t * ap_stream, const uint8_t * ap_data,
+                 size_t a_len);
+
+/* True once the 'moov' box has been parsed */
+bool
+mp4_stream_is_ready (const mp4_stream_t * ap_stream);
+
+/* The selected tracks, or NULL if the stream has none of that type */
+const mp4_stream_track_info_t *
+mp4_stream_audio_track (const mp4_stream_t * ap_stream);
+
+const mp4_stream_track_info_t *
+mp4_stream_video_track (const mp4_stream_t * ap_stream);
+
+/* Retrieve the next sample in file order, without consuming it. Returns
+   OMX_ErrorNone if the sample is available, OMX_ErrorNotReady if more stream
+   data is needed, OMX_ErrorNoMore after the last sample, and
+   OMX_ErrorStreamCorrupt if the sample can not be located (it can be skipped
+   with mp4_stream_next_sample). The sample data remains valid until the next
+   call to mp4_stream_push or mp4_stream_next_sample. */
+OMX_ERRORTYPE
+mp4_stream_peek_sample (mp4_stream_t * ap_stream,
+                        mp4_stream_sample_t * ap_sample);
+
+/* Consume the sample last returned by mp4_stream_peek_sample */
+void
+mp4_stream_next_sample (mp4_stream_t * ap_stream);
+
+/* Build the ADTS header of an audio sample of a_len bytes; only valid if the
+   audio track's 'adts' flag is set, and the resulting frame is no longer than
+   MP4_STREAM_ADTS_MAX_FRAME_LEN */
+void
+mp4_stream_adts_header (const mp4_stream_t * ap_stream, size_t a_len,
+                        uint8_t * ap_hdr);
+
+/* Bytes received so far, and largest amount of them held at any one time */
+uint64_t
+mp4_stream_received (const mp4_stream_t * ap_stream);
+
+size_t
+mp4_stream_peak_buffered (const mp4_stream_t * ap_stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MP4STREAM_H */
@@ -32,9 +32,9 @@
 
 #include <assert.h>
 #include <errno.h>
-#include <math.h>
+#include <stdlib.h>
 #include <string.h>
-#include <byteswap.h>
+#include <stdbool.h>
 
 #include <tizplatform.h>
 
@@ -379,6 +379,52 @@ using_null_alsa_device (ar_prc_t * ap_prc)
                       OMX_MAX_STRINGNAME_SIZE));
 }
 
+static bool
+mmap_access_requested (ar_prc_t * ap_prc)
+{
+  const char * p_mmap = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION,
+    "OMX.Aratelia.audio_renderer.alsa.pcm.alsa_mmap");
+  assert (ap_prc);
+  return (p_mmap && 0 == strncmp (p_mmap, "true", 4));
+}
+
+static float
+get_default_gain (ar_prc_t * ap_prc)
+{
+  const char * p_default_gain = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION,
+    "OMX.Aratelia.audio_renderer.alsa.pcm.default_gain");
+  float default_gain = ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE;
+  assert (ap_prc);
+
+  if (p_default_gain)
+    {
+      char * end = NULL;
+      const float gain = strtof (p_default_gain, &end);
+      if (p_default_gain == end || errno == ERANGE)
+        {
+          TIZ_ERROR (handleOf (ap_prc), "Unable to parse gain '%s'",
+                     p_default_gain);
+          errno = 0;
+        }
+      else if (gain > ARATELIA_AUDIO_RENDERER_MAX_GAIN_VALUE
+               || gain < ARATELIA_AUDIO_RENDERER_MIN_GAIN_VALUE)
+        {
+          TIZ_NOTICE (handleOf (ap_prc),
+                      "Gain %.2f dB is out of range. Using default value "
+                      "%.2f dB",
+                      gain, ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE);
+        }
+      else
+        {
+          TIZ_NOTICE (handleOf (ap_prc), "Gain parsed: %.2f dB", gain);
+          default_gain = gain;
+        }
+    }
+  return default_gain;
+}
+
 static inline OMX_ERRORTYPE
 start_io_watcher (ar_prc_t * ap_prc)
 {
@@ -436,85 +482,61 @@ do_flush (ar_prc_t * ap_prc)
   return release_header (ap_prc);
 }
 
-static float
-sint_to_float (const int a_sample)
+static tiz_pcm_fmt_t
+pcm_format (const ar_prc_t * ap_prc)
 {
-  float f;
-  if (a_sample >= 0)
-    {
-      f = a_sample / 32767.0;
-    }
-  else
+  assert (ap_prc);
+  /* NOTE: 32-bit streams are float (see
+     retrieve_alsa_pcm_format_and_num_channels) */
+  switch (ap_prc->pcmmode_.nBitPerSample)
     {
-      f = a_sample / 32768.0;
-    }
-  return f;
+      case 24:
+        return TIZ_PCM_FMT_S24;
+      case 32:
+        return TIZ_PCM_FMT_FLOAT;
+      default:
+        return TIZ_PCM_FMT_S16;
+    };
 }
 
-static int
-float_to_sint (const float a_sample)
+static bool
+is_host_byte_order (const OMX_ENDIANTYPE a_endian)
 {
-  float f;
-  f = a_sample * 32767;
-  if (f < -32768)
-    {
-      f = -32768;
-    }
-  if (f > 32767)
-    {
-      f = 32767;
-    }
-  return (int) f;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return OMX_EndianBig == a_endian;
+#else
+  return OMX_EndianLittle == a_endian;
+#endif
 }
 
 static void
-adjust_gain (const ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr,
-             const snd_pcm_uframes_t a_samples_per_channel)
+adjust_gain (const ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
 {
   assert (ap_prc);
   assert (ap_hdr);
 
-  if (ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE != ap_prc->gain_)
+  /* Only touch the samples the first time the header is seen */
+  if (ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE != ap_prc->gain_
+      && !ap_hdr->nOffset)
     {
-      int i;
-      int gainadj = (int) (ap_prc->gain_ * 256.);
-      float gain = pow (10., gainadj / 5120.);
-      /*       gain = 3.1f; */
-      /*       fprintf (stderr, "%f samples %ld\n", gain, a_samples_per_channel); */
-      OMX_S16 * pcm = (OMX_S16 *) (ap_hdr->pBuffer + ap_hdr->nOffset);
-      for (i = 0; i < a_samples_per_channel; i++)
+      const tiz_pcm_fmt_t fmt = pcm_format (ap_prc);
+      const size_t samples = ap_hdr->nFilledLen / tiz_pcm_sample_size (fmt);
+      const bool swap = !is_host_byte_order (ap_prc->pcmmode_.eEndian);
+      void * p_pcm = ap_hdr->pBuffer + ap_hdr->nOffset;
+
+      /* Samples need to be in host byte order to be scaled */
+      if (swap)
+        {
+          tiz_pcm_byteswap (p_pcm, samples, fmt);
+        }
+      tiz_pcm_gain (p_pcm, samples, fmt, tiz_pcm_db_to_gain (ap_prc->gain_));
+      if (swap)
         {
-          float f = sint_to_float (*pcm);
-          f *= gain;
-          int v = float_to_sint (f);
-          *(pcm++) = (v > 32767) ? 32767 : ((v < -32768) ? -32768 : v);
-          f = sint_to_float (*pcm);
-          f *= gain;
-          v = float_to_sint (f);
-          *(pcm++) = (v > 32767) ? 32767 : ((v < -32768) ? -32768 : v);
+          tiz_pcm_byteswap (p_pcm, samples, fmt);
         }
     }
 }
 
-static void
-swap_byte_order_s16 (const ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr,
-                     const int a_samples)
-{
-  assert (ap_prc);
-  assert (ap_hdr);
-  assert (ap_hdr->pBuffer);
-
-  {
-    OMX_S16 * p_pcm = (OMX_S16 *) (ap_hdr->pBuffer + ap_hdr->nOffset);
-    int i = 0;
-    for (i = 0; i < a_samples; ++i)
-      {
-        *p_pcm = bswap_16 (*p_pcm);
-        p_pcm++;
-      }
-  }
-}
-
 static void
 swap_byte_order (const ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
 {
@@ -523,8 +545,8 @@ swap_byte_order (const ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
 
   if (ap_prc->swap_byte_order_ && !ap_hdr->nOffset)
     {
-      const int bytes_per_sample = ap_prc->pcmmode_.nBitPerSample / 8;
-      const int samples = ap_hdr->nFilledLen / bytes_per_sample;
+      const tiz_pcm_fmt_t fmt = pcm_format (ap_prc);
+      const size_t samples = ap_hdr->nFilledLen / tiz_pcm_sample_size (fmt);
       TIZ_DEBUG (handleOf (ap_prc),
                  "nBitPerSample = [%d] "
                  "nFilledLen = [%d] "
@@ -532,19 +554,7 @@ swap_byte_order (const ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
                  "nOffset = [%d]",
                  ap_prc->pcmmode_.nBitPerSample, ap_hdr->nFilledLen, samples,
                  ap_hdr->nOffset);
-
-      switch (ap_prc->pcmmode_.nBitPerSample)
-        {
-          case 16:
-            {
-              swap_byte_order_s16 (ap_prc, ap_hdr, samples);
-            }
-            break;
-          default:
-            {
-            }
-            break;
-        };
+      tiz_pcm_byteswap (ap_hdr->pBuffer + ap_hdr->nOffset, samples, fmt);
     }
 }
 
@@ -802,7 +812,6 @@ apply_ramp_step (ar_prc_t * ap_prc)
 static OMX_ERRORTYPE
 arrange_samples_buffer (ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr,
                         unsigned long int a_sample_size,
-                        unsigned long int a_step,
                         snd_pcm_uframes_t a_samples_per_channel,
                         const void ** app_buffer)
 {
@@ -816,26 +825,21 @@ arrange_samples_buffer (ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr,
 
   if (ap_prc->pcmmode_.nChannels < ap_prc->num_channels_supported_)
     {
-      snd_pcm_uframes_t i = 0;
+      const size_t nbytes
+        = a_samples_per_channel * a_sample_size * ap_prc->num_channels_supported_;
+      void * p_dst = NULL;
       tiz_buffer_clear (ap_prc->p_sample_buf_);
-      while (i < a_samples_per_channel)
+      if (!(p_dst = tiz_buffer_reserve (ap_prc->p_sample_buf_, nbytes)))
         {
-          int j = 0;
-          while (j < ap_prc->num_channels_supported_)
-            {
-              if (a_sample_size
-                  != tiz_buffer_push (ap_prc->p_sample_buf_,
-                                      p_hdr_buf + (a_step * i), a_sample_size))
-                {
-                  TIZ_ERROR (handleOf (ap_prc),
-                             "Unable to copy all sample data into the buffer");
-                  /* Early return */
-                  return OMX_ErrorInsufficientResources;
-                }
-              j += 1;
-            }
-          i += 1;
+          TIZ_ERROR (handleOf (ap_prc),
+                     "Unable to copy all sample data into the buffer");
+          /* Early return */
+          return OMX_ErrorInsufficientResources;
         }
+      tiz_pcm_upmix (p_dst, p_hdr_buf, a_samples_per_channel,
+                     pcm_format (ap_prc), ap_prc->pcmmode_.nChannels,
+                     ap_prc->num_channels_supported_);
+      (void) tiz_buffer_commit (ap_prc->p_sample_buf_, nbytes);
       *app_buffer = tiz_buffer_get (ap_prc->p_sample_buf_);
       TIZ_DEBUG (
         handleOf (ap_prc),
@@ -851,6 +855,126 @@ arrange_samples_buffer (ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr,
   return OMX_ErrorNone;
 }
 
+/* Gain, byte order and channel arrangement, done in place on a_nframes
+   frames that have just been copied (and up-mixed) into alsa's ring. */
+static void
+process_mmap_frames (const ar_prc_t * ap_prc, void * ap_frames,
+                     const snd_pcm_uframes_t a_nframes)
+{
+  const tiz_pcm_fmt_t fmt = pcm_format (ap_prc);
+  const size_t samples = a_nframes * ap_prc->num_channels_supported_;
+  const bool stream_is_host = is_host_byte_order (ap_prc->pcmmode_.eEndian);
+  /* The byte order alsa has been configured with */
+  const bool alsa_is_host = (stream_is_host != ap_prc->swap_byte_order_);
+  bool is_host = stream_is_host;
+
+  if (ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE != ap_prc->gain_)
+    {
+      if (!is_host)
+        {
+          tiz_pcm_byteswap (ap_frames, samples, fmt);
+          is_host = true;
+        }
+      tiz_pcm_gain (ap_frames, samples, fmt,
+                    tiz_pcm_db_to_gain (ap_prc->gain_));
+    }
+
+  if (is_host != alsa_is_host)
+    {
+      tiz_pcm_byteswap (ap_frames, samples, fmt);
+    }
+}
+
+static OMX_ERRORTYPE
+render_buffer_mmap (ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  const tiz_pcm_fmt_t fmt = pcm_format (ap_prc);
+  const unsigned long int step
+    = tiz_pcm_sample_size (fmt) * ap_prc->pcmmode_.nChannels;
+  snd_pcm_uframes_t samples_per_channel = 0;
+
+  assert (ap_prc);
+  assert (ap_hdr);
+  assert (ap_hdr->nFilledLen > 0);
+
+  samples_per_channel = ap_hdr->nFilledLen / step;
+
+  while (samples_per_channel > 0 && OMX_ErrorNone == rc)
+    {
+      const snd_pcm_channel_area_t * p_areas = NULL;
+      snd_pcm_uframes_t offset = 0;
+      snd_pcm_uframes_t frames = 0;
+      snd_pcm_sframes_t avail = 0;
+      snd_pcm_sframes_t err = 0;
+
+      avail = snd_pcm_avail_update (ap_prc->p_pcm_);
+      if (0 == avail)
+        {
+          /* alsa's ring is full */
+          rc = OMX_ErrorNoMore;
+          break;
+        }
+
+      frames = MIN (samples_per_channel, (snd_pcm_uframes_t) MAX (avail, 0));
+      if (avail > 0)
+        {
+          err = snd_pcm_mmap_begin (ap_prc->p_pcm_, &p_areas, &offset, &frames);
+        }
+      else
+        {
+          err = avail;
+        }
+
+      if (err >= 0)
+        {
+          /* Interleaved access: all channels share the first area */
+          OMX_U8 * p_dst = (OMX_U8 *) p_areas[0].addr
+                           + (p_areas[0].first + offset * p_areas[0].step) / 8;
+          tiz_pcm_upmix (p_dst, ap_hdr->pBuffer + ap_hdr->nOffset, frames, fmt,
+                         ap_prc->pcmmode_.nChannels,
+                         ap_prc->num_channels_supported_);
+          process_mmap_frames (ap_prc, p_dst, frames);
+          err = snd_pcm_mmap_commit (ap_prc->p_pcm_, offset, frames);
+          if (err >= 0 && (snd_pcm_uframes_t) err != frames)
+            {
+              err = -EPIPE;
+            }
+        }
+
+      if (err < 0)
+        {
+          /* This should handle -EINTR (interrupted system call), -EPIPE
+           * (overrun or underrun) and -ESTRPIPE (stream is suspended) */
+          err = snd_pcm_recover (ap_prc->p_pcm_, (int) err, 0);
+          if (err < 0)
+            {
+              TIZ_ERROR (handleOf (ap_prc), "snd_pcm_recover error: %s",
+                         snd_strerror ((int) err));
+              rc = OMX_ErrorUnderflow;
+            }
+        }
+      else
+        {
+          ap_hdr->nOffset += frames * step;
+          ap_hdr->nFilledLen -= frames * step;
+          samples_per_channel -= frames;
+        }
+    }
+
+  /* Unlike snd_pcm_writei, committing frames does not start the stream;
+     start it once the ring is full or the last frames have been queued */
+  if (OMX_ErrorUnderflow != rc
+      && SND_PCM_STATE_PREPARED == snd_pcm_state (ap_prc->p_pcm_)
+      && (OMX_ErrorNoMore == rc
+          || (ap_hdr->nFlags & OMX_BUFFERFLAG_EOS) != 0))
+    {
+      bail_on_snd_pcm_error (snd_pcm_start (ap_prc->p_pcm_));
+    }
+
+  return rc;
+}
+
 static OMX_ERRORTYPE
 render_buffer (ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
 {
@@ -862,12 +986,17 @@ render_buffer (ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
   assert (ap_prc);
   assert (ap_hdr);
 
+  if (ap_prc->mmap_enabled_)
+    {
+      return render_buffer_mmap (ap_prc, ap_hdr);
+    }
+
   sample_size = ap_prc->pcmmode_.nBitPerSample / 8;
   step = sample_size * ap_prc->pcmmode_.nChannels;
   assert (ap_hdr->nFilledLen > 0);
   samples_per_channel = ap_hdr->nFilledLen / step;
 
-  adjust_gain (ap_prc, ap_hdr, samples_per_channel);
+  adjust_gain (ap_prc, ap_hdr);
   swap_byte_order (ap_prc, ap_hdr);
 
   while (samples_per_channel > 0 && OMX_ErrorNone == rc)
@@ -875,7 +1004,7 @@ render_buffer (ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
       const void * p_buffer = NULL;
       snd_pcm_sframes_t err = 0;
 
-      tiz_check_omx (arrange_samples_buffer (ap_prc, ap_hdr, sample_size, step,
+      tiz_check_omx (arrange_samples_buffer (ap_prc, ap_hdr, sample_size,
                                              samples_per_channel, &p_buffer));
 
       err = snd_pcm_writei (ap_prc->p_pcm_, p_buffer, samples_per_channel);
@@ -1005,6 +1134,7 @@ ar_prc_ctor (void * ap_prc, va_list * app)
   p_prc->p_pcm_name_ = NULL;
   p_prc->p_mixer_name_ = NULL;
   p_prc->swap_byte_order_ = false;
+  p_prc->mmap_enabled_ = false;
   p_prc->num_channels_supported_ = 0;
   p_prc->p_sample_buf_ = NULL;
   p_prc->descriptor_count_ = 0;
@@ -1016,7 +1146,7 @@ ar_prc_ctor (void * ap_prc, va_list * app)
   p_prc->port_disabled_ = false;
   p_prc->awaiting_io_ev_ = false;
   p_prc->nflags_ = 0;
-  p_prc->gain_ = ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE;
+  p_prc->gain_ = get_default_gain (p_prc);
   p_prc->volume_ = ARATELIA_AUDIO_RENDERER_DEFAULT_VOLUME_VALUE;
   p_prc->ramp_enabled_ = false;
   p_prc->ramp_step_ = 0;
@@ -1115,13 +1245,37 @@ ar_prc_prepare_to_transfer (void * ap_prc, OMX_U32 TIZ_UNUSED (a_pid))
       tiz_check_omx (retrieve_alsa_pcm_format_and_num_channels (
         p_prc, &snd_pcm_format, &p_prc->num_channels_supported_));
 
+      /* Direct access to alsa's ring is optional. It is only attempted when
+         alsa's sample width matches the stream's (e.g. not for 24-bit
+         samples in 32-bit containers) */
+      p_prc->mmap_enabled_
+        = mmap_access_requested (p_prc)
+          && (snd_pcm_format_physical_width (snd_pcm_format)
+              == (int) p_prc->pcmmode_.nBitPerSample);
+
       /* This sets the hardware and software parameters in a convenient way. */
-      bail_on_snd_pcm_error (snd_pcm_set_params (
-        p_prc->p_pcm_, snd_pcm_format, SND_PCM_ACCESS_RW_INTERLEAVED,
-        (unsigned int) p_prc->num_channels_supported_,
-        p_prc->pcmmode_.nSamplingRate, 0, /* allow alsa-lib resampling */
-        100000                            /* overall latency in us */
-        ));
+      if (p_prc->mmap_enabled_
+          && snd_pcm_set_params (p_prc->p_pcm_, snd_pcm_format,
+                                 SND_PCM_ACCESS_MMAP_INTERLEAVED,
+                                 (unsigned int) p_prc->num_channels_supported_,
+                                 p_prc->pcmmode_.nSamplingRate, 0, 100000)
+               < 0)
+        {
+          TIZ_NOTICE (handleOf (p_prc),
+                      "mmap access not supported by [%s]; using writei",
+                      get_alsa_device (p_prc));
+          p_prc->mmap_enabled_ = false;
+        }
+
+      if (!p_prc->mmap_enabled_)
+        {
+          bail_on_snd_pcm_error (snd_pcm_set_params (
+            p_prc->p_pcm_, snd_pcm_format, SND_PCM_ACCESS_RW_INTERLEAVED,
+            (unsigned int) p_prc->num_channels_supported_,
+            p_prc->pcmmode_.nSamplingRate, 0, /* allow alsa-lib resampling */
+            100000                            /* overall latency in us */
+            ));
+        }
 
       bail_on_snd_pcm_error (snd_pcm_poll_descriptors (
         p_prc->p_pcm_, p_prc->p_fds_, p_prc->descriptor_count_));
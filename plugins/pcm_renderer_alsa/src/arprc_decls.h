@@ -52,6 +52,7 @@ struct ar_prc
   char * p_pcm_name_;
   char * p_mixer_name_;
   bool swap_byte_order_;
+  bool mmap_enabled_;
   unsigned int num_channels_supported_;
   tiz_buffer_t * p_sample_buf_;
   int descriptor_count_;
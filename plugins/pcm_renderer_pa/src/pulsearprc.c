@@ -34,6 +34,7 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <stdbool.h>
 
 #include <tizplatform.h>
 
@@ -156,6 +157,42 @@ get_default_volume (pulsear_prc_t * ap_prc)
   return default_vol;
 }
 
+static float
+get_default_gain (pulsear_prc_t * ap_prc)
+{
+  const char * p_default_gain = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION,
+    "OMX.Aratelia.audio_renderer.pulseaudio.pcm.default_gain");
+  float default_gain = ARATELIA_PCM_RENDERER_DEFAULT_GAIN_VALUE;
+  assert (ap_prc);
+
+  if (p_default_gain)
+    {
+      char * end = NULL;
+      const float gain = strtof (p_default_gain, &end);
+      if (p_default_gain == end || errno == ERANGE)
+        {
+          TIZ_ERROR (handleOf (ap_prc), "Unable to parse gain '%s'",
+                     p_default_gain);
+          errno = 0;
+        }
+      else if (gain > ARATELIA_PCM_RENDERER_MAX_GAIN_VALUE
+               || gain < ARATELIA_PCM_RENDERER_MIN_GAIN_VALUE)
+        {
+          TIZ_NOTICE (handleOf (ap_prc),
+                      "Gain %.2f dB is out of range. Using default value "
+                      "%.2f dB",
+                      gain, ARATELIA_PCM_RENDERER_DEFAULT_GAIN_VALUE);
+        }
+      else
+        {
+          TIZ_NOTICE (handleOf (ap_prc), "Gain parsed: %.2f dB", gain);
+          default_gain = gain;
+        }
+    }
+  return default_gain;
+}
+
 static OMX_ERRORTYPE
 set_component_volume (pulsear_prc_t * ap_prc)
 {
@@ -230,6 +267,58 @@ ready_to_process (pulsear_prc_t * ap_prc)
           && !ap_prc->port_disabled_ && !ap_prc->stopped_);
 }
 
+static tiz_pcm_fmt_t
+pcm_format (const pulsear_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  /* NOTE: 32-bit streams are float (see init_pulseaudio_sample_spec) */
+  switch (ap_prc->pcmmode_.nBitPerSample)
+    {
+      case 24:
+        return TIZ_PCM_FMT_S24;
+      case 32:
+        return TIZ_PCM_FMT_FLOAT;
+      default:
+        return TIZ_PCM_FMT_S16;
+    };
+}
+
+static bool
+is_host_byte_order (const OMX_ENDIANTYPE a_endian)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return OMX_EndianBig == a_endian;
+#else
+  return OMX_EndianLittle == a_endian;
+#endif
+}
+
+static void
+adjust_gain (const pulsear_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
+{
+  assert (ap_prc);
+  assert (ap_hdr);
+
+  if (ARATELIA_PCM_RENDERER_DEFAULT_GAIN_VALUE != ap_prc->gain_)
+    {
+      const tiz_pcm_fmt_t fmt = pcm_format (ap_prc);
+      const size_t samples = ap_hdr->nFilledLen / tiz_pcm_sample_size (fmt);
+      const bool swap = !is_host_byte_order (ap_prc->pcmmode_.eEndian);
+      void * p_pcm = ap_hdr->pBuffer + ap_hdr->nOffset;
+
+      /* Samples need to be in host byte order to be scaled */
+      if (swap)
+        {
+          tiz_pcm_byteswap (p_pcm, samples, fmt);
+        }
+      tiz_pcm_gain (p_pcm, samples, fmt, tiz_pcm_db_to_gain (ap_prc->gain_));
+      if (swap)
+        {
+          tiz_pcm_byteswap (p_pcm, samples, fmt);
+        }
+    }
+}
+
 static OMX_BUFFERHEADERTYPE *
 get_header (pulsear_prc_t * ap_prc)
 {
@@ -248,6 +337,7 @@ get_header (pulsear_prc_t * ap_prc)
               TIZ_TRACE (handleOf (ap_prc),
                          "Claimed HEADER [%p]...nFilledLen [%d]",
                          ap_prc->p_inhdr_, ap_prc->p_inhdr_->nFilledLen);
+              adjust_gain (ap_prc, ap_prc->p_inhdr_);
             }
         }
       p_hdr = ap_prc->p_inhdr_;
@@ -1044,7 +1134,7 @@ pulsear_prc_ctor (void * ap_prc, va_list * app)
   p_prc->pa_stream_state_ = PA_STREAM_UNCONNECTED;
   p_prc->pa_nbytes_ = 0;
   p_prc->p_ev_timer_ = NULL;
-  p_prc->gain_ = ARATELIA_PCM_RENDERER_DEFAULT_GAIN_VALUE;
+  p_prc->gain_ = get_default_gain (ap_prc);
   p_prc->volume_ = get_default_volume (ap_prc);
   p_prc->pending_volume_ = 0;
   p_prc->ramp_enabled_ = false;
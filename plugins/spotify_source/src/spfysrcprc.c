@@ -37,6 +37,7 @@
 #include <time.h>
 #include <pwd.h>
 #include <unistd.h>
+#include <sys/eventfd.h>
 #include <sys/types.h>
 
 #include <OMX_TizoniaExt.h>
@@ -55,10 +56,15 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.spotify_source.prc"
 #endif
 
-#define SPFYSRC_MIN_QUEUE_UNUSED_SPACES 5
 #define SPFYSRC_MAX_STRING_SIZE 2 * OMX_MAX_STRINGNAME_SIZE
 #define SPFYSRC_MAX_WAIT_TIME_SECONDS 25
 
+/* Room for twice the maximum cache size, so that libspotify never needs to be
+   turned away while delivery is being paused */
+#define SPFYSRC_RING_CAPACITY                                        \
+  (2 * ((ARATELIA_SPOTIFY_SOURCE_DEFAULT_BIT_RATE_KBITS * 1000) / 8) \
+   * ARATELIA_SPOTIFY_SOURCE_MAX_CACHE_SECONDS)
+
 #define IGNORE_VALUE INT_MAX
 
 /* This macro assumes the existence of an "ap_prc" local variable */
@@ -85,6 +91,8 @@ omx_preferred_bitrate_to_spfy (
   const OMX_TIZONIA_AUDIO_SPOTIFYBITRATETYPE a_bitrate_type, int * ap_bitrate);
 static void
 end_of_track_handler (OMX_PTR ap_prc, tiz_event_pluggable_t * ap_event);
+static void
+handle_end_of_track (spfysrc_prc_t * ap_prc);
 static OMX_ERRORTYPE
 obtain_next_url (spfysrc_prc_t * ap_prc, const int a_skip_value,
                  const int a_position_value, bool a_need_url_removed);
@@ -108,15 +116,6 @@ extern const uint8_t g_appkey[];
 /* The size of the application key. */
 extern const size_t g_appkey_size;
 
-typedef struct spfy_music_delivery_data spfy_music_delivery_data_t;
-struct spfy_music_delivery_data
-{
-  sp_session * p_sess;
-  sp_audioformat format;
-  void * p_frames;
-  int num_frames;
-};
-
 typedef struct spfy_login_failure_data spfy_login_failure_data_t;
 struct spfy_login_failure_data
 {
@@ -183,7 +182,10 @@ reset_stream_parameters (spfysrc_prc_t * ap_prc)
   TIZ_INIT_OMX_STRUCT (ap_prc->playlist_position_);
   ap_prc->last_changed_config_ = OMX_IndexMax;
   ap_prc->need_url_removed_ = false;
-  tiz_buffer_clear (ap_prc->p_store_);
+  if (ap_prc->p_ring_)
+    {
+      tiz_spscring_clear (ap_prc->p_ring_);
+    }
   ap_prc->initial_cache_bytes_
     = ((ARATELIA_SPOTIFY_SOURCE_DEFAULT_BIT_RATE_KBITS * 1000) / 8)
       * ARATELIA_SPOTIFY_SOURCE_DEFAULT_CACHE_SECONDS;
@@ -201,6 +203,7 @@ process_spotify_event (spfysrc_prc_t * ap_prc,
   p_event = tiz_mem_calloc (1, sizeof (tiz_event_pluggable_t));
   if (p_event)
     {
+      (void) __atomic_add_fetch (&(ap_prc->nallocs_), 1, __ATOMIC_RELAXED);
       p_event->p_servant = ap_prc;
       p_event->pf_hdlr = apf_hdlr;
       p_event->p_data = ap_data;
@@ -220,6 +223,7 @@ post_spotify_event (spfysrc_prc_t * ap_prc, tiz_event_pluggable_hdlr_f apf_hdlr,
   p_event = tiz_mem_calloc (1, sizeof (tiz_event_pluggable_t));
   if (p_event)
     {
+      (void) __atomic_add_fetch (&(ap_prc->nallocs_), 1, __ATOMIC_RELAXED);
       p_event->p_servant = ap_prc;
       p_event->pf_hdlr = apf_hdlr;
       p_event->p_data = ap_data;
@@ -631,34 +635,88 @@ end:
 static OMX_ERRORTYPE
 allocate_temp_data_store (spfysrc_prc_t * ap_prc)
 {
-  OMX_PARAM_PORTDEFINITIONTYPE port_def;
   assert (ap_prc);
-  TIZ_INIT_OMX_PORT_STRUCT (port_def, ARATELIA_SPOTIFY_SOURCE_PORT_INDEX);
+  assert (ap_prc->p_ring_ == NULL);
+  assert (ap_prc->p_ev_io_ == NULL);
+
   tiz_check_omx (
-    tiz_api_GetParameter (tiz_get_krn (handleOf (ap_prc)), handleOf (ap_prc),
-                          OMX_IndexParamPortDefinition, &port_def));
-  assert (ap_prc->p_store_ == NULL);
-  return tiz_buffer_init (&(ap_prc->p_store_), port_def.nBufferSize);
+    tiz_spscring_init (&(ap_prc->p_ring_), SPFYSRC_RING_CAPACITY));
+
+  /* libspotify's thread uses this to wake up the component's thread, instead
+     of posting an event for every chunk of PCM data */
+  if ((ap_prc->event_fd_ = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+    {
+      TIZ_ERROR (handleOf (ap_prc),
+                 "[OMX_ErrorInsufficientResources] : "
+                 "Unable to create the eventfd.");
+      return OMX_ErrorInsufficientResources;
+    }
+  tiz_check_omx (tiz_srv_io_watcher_init (ap_prc, &(ap_prc->p_ev_io_),
+                                          ap_prc->event_fd_, TIZ_EVENT_READ,
+                                          false));
+  return tiz_srv_io_watcher_start (ap_prc, ap_prc->p_ev_io_);
 }
 
 static inline void
 deallocate_temp_data_store (
   /*@special@ */ spfysrc_prc_t * ap_prc)
-/*@releases ap_prc->p_store_@ */
-/*@ensures isnull ap_prc->p_store_@ */
+/*@releases ap_prc->p_ring_@ */
+/*@ensures isnull ap_prc->p_ring_@ */
 {
   assert (ap_prc);
-  tiz_buffer_destroy (ap_prc->p_store_);
-  ap_prc->p_store_ = NULL;
+  if (ap_prc->p_ev_io_)
+    {
+      (void) tiz_srv_io_watcher_stop (ap_prc, ap_prc->p_ev_io_);
+      tiz_srv_io_watcher_destroy (ap_prc, ap_prc->p_ev_io_);
+      ap_prc->p_ev_io_ = NULL;
+    }
+  if (ap_prc->event_fd_ >= 0)
+    {
+      (void) close (ap_prc->event_fd_);
+      ap_prc->event_fd_ = -1;
+    }
+  tiz_spscring_destroy (ap_prc->p_ring_);
+  ap_prc->p_ring_ = NULL;
 }
 
-static inline int
-copy_to_omx_buffer (OMX_BUFFERHEADERTYPE * ap_hdr, const void * ap_src,
-                    const int nbytes)
+/* Called from libspotify's thread. Only the first call after the component's
+   thread has acknowledged the previous wake-up needs the system call. */
+static void
+wake_component (spfysrc_prc_t * ap_prc)
 {
-  int n = MIN (nbytes, ap_hdr->nAllocLen - ap_hdr->nFilledLen);
+  assert (ap_prc);
+  if (!__atomic_exchange_n (&(ap_prc->signalled_), 1, __ATOMIC_ACQ_REL)
+      && ap_prc->event_fd_ >= 0)
+    {
+      const uint64_t one = 1;
+      (void) !write (ap_prc->event_fd_, &one, sizeof (one));
+    }
+}
+
+static void
+report_allocations (spfysrc_prc_t * ap_prc)
+{
+  const OMX_U32 nallocs
+    = __atomic_exchange_n (&(ap_prc->nallocs_), 0, __ATOMIC_RELAXED);
+  const double seconds
+    = (ap_prc->samplerate_ > 0 && ap_prc->num_channels_ > 0)
+        ? (double) ap_prc->pcm_bytes_
+            / (ap_prc->samplerate_ * ap_prc->num_channels_ * sizeof (int16_t))
+        : 0.0;
+  TIZ_NOTICE (handleOf (ap_prc),
+              "pluggable event allocations [%u] in [%.1f] secs of playback "
+              "[%.3f/sec] (the audio itself goes through the ring buffer)",
+              nallocs, seconds, seconds > 0.0 ? nallocs / seconds : 0.0);
+  ap_prc->pcm_bytes_ = 0;
+}
+
+static inline OMX_U32
+read_into_omx_buffer (OMX_BUFFERHEADERTYPE * ap_hdr, tiz_spscring_t * ap_ring,
+                      const OMX_U32 nbytes)
+{
+  OMX_U32 n = MIN (nbytes, ap_hdr->nAllocLen - ap_hdr->nFilledLen);
   assert (n > 0);
-  (void) memcpy (ap_hdr->pBuffer + ap_hdr->nOffset, ap_src, n);
+  n = tiz_spscring_read (ap_ring, ap_hdr->pBuffer + ap_hdr->nOffset, n);
   ap_hdr->nFilledLen += n;
   ap_hdr->nOffset += n;
   TIZ_PRINTF_DBG_YEL (
@@ -778,7 +836,8 @@ reevaluate_cache (spfysrc_prc_t * ap_prc)
 
   if (ap_prc->p_sp_session_ && !ap_prc->initial_cache_bytes_)
     {
-      const int current_cache_bytes = tiz_buffer_available (ap_prc->p_store_);
+      const int current_cache_bytes
+        = tiz_spscring_available (ap_prc->p_ring_);
       if (current_cache_bytes > ap_prc->max_cache_bytes_
           && !ap_prc->spotify_paused_)
         {
@@ -794,38 +853,64 @@ reevaluate_cache (spfysrc_prc_t * ap_prc)
     }
 }
 
+/* The delivery callback only changes the format when the ring is empty, so
+   the data available at this point is all in the format it last published */
+static void
+update_pcm_format (spfysrc_prc_t * ap_prc)
+{
+  const int channels
+    = __atomic_load_n (&(ap_prc->ring_channels_), __ATOMIC_ACQUIRE);
+  const int samplerate
+    = __atomic_load_n (&(ap_prc->ring_samplerate_), __ATOMIC_ACQUIRE);
+  assert (ap_prc);
+
+  if (ap_prc->auto_detect_on_ || (int) ap_prc->num_channels_ != channels
+      || (int) ap_prc->samplerate_ != samplerate)
+    {
+      ap_prc->auto_detect_on_ = false;
+      ap_prc->num_channels_ = channels;
+      ap_prc->samplerate_ = samplerate;
+      ap_prc->audio_coding_type_ = OMX_AUDIO_CodingPCM;
+      set_audio_coding_on_port (ap_prc);
+      set_pcm_audio_info_on_port (ap_prc);
+      /* And now trigger the OMX_EventPortFormatDetected and
+         OMX_EventPortSettingsChanged events or a
+         OMX_ErrorFormatNotDetected event */
+      send_port_auto_detect_events (ap_prc);
+    }
+}
+
 static OMX_ERRORTYPE
 consume_cache (spfysrc_prc_t * ap_prc)
 {
+  OMX_U32 nbytes_stored = 0;
   assert (ap_prc);
 
-  /* Also, control here the delivery of the next eos flag */
-  if (ap_prc->eos_ && ap_prc->bytes_till_eos_ <= 0)
+  nbytes_stored = tiz_spscring_available (ap_prc->p_ring_);
+  if (nbytes_stored > 0)
     {
-      ap_prc->bytes_till_eos_ = tiz_buffer_available (ap_prc->p_store_);
+      update_pcm_format (ap_prc);
     }
 
   TIZ_TRACE (handleOf (ap_prc),
-             "store [%d] initial_cache [%d] min_cache [%d] max_cache [%d]",
-             tiz_buffer_available (ap_prc->p_store_),
-             ap_prc->initial_cache_bytes_, ap_prc->min_cache_bytes_,
-             ap_prc->max_cache_bytes_);
+             "store [%u] initial_cache [%d] min_cache [%d] max_cache [%d]",
+             nbytes_stored, ap_prc->initial_cache_bytes_,
+             ap_prc->min_cache_bytes_, ap_prc->max_cache_bytes_);
 
-  if (tiz_buffer_available (ap_prc->p_store_) > ap_prc->initial_cache_bytes_)
+  if ((int) nbytes_stored > ap_prc->initial_cache_bytes_)
     {
-      int nbytes_stored = 0;
       OMX_BUFFERHEADERTYPE * p_out = NULL;
 
       /* Reset the initial size */
       ap_prc->initial_cache_bytes_ = 0;
 
-      while ((nbytes_stored = tiz_buffer_available (ap_prc->p_store_)) > 0
-             && (p_out = buffer_needed (ap_prc)) != NULL)
+      while (nbytes_stored > 0 && (p_out = buffer_needed (ap_prc)) != NULL)
         {
-          int nbytes_copied = copy_to_omx_buffer (
-            p_out, tiz_buffer_get (ap_prc->p_store_), nbytes_stored);
+          const OMX_U32 nbytes_copied
+            = read_into_omx_buffer (p_out, ap_prc->p_ring_, nbytes_stored);
+          nbytes_stored -= nbytes_copied;
+          ap_prc->pcm_bytes_ += nbytes_copied;
           tiz_check_omx (release_buffer (ap_prc));
-          (void) tiz_buffer_advance (ap_prc->p_store_, nbytes_copied);
           p_out = NULL;
         }
     }
@@ -1044,20 +1129,6 @@ logged_in (sp_session * sess, sp_error error)
     }
 }
 
-static void
-notify_main_thread_handler (OMX_PTR ap_prc, tiz_event_pluggable_t * ap_event)
-{
-  spfysrc_prc_t * p_prc = ap_prc;
-  assert (p_prc);
-  assert (ap_event);
-  tiz_mem_free (ap_event);
-  p_prc->keep_processing_sp_events_ = true;
-  if (!p_prc->stopping_)
-    {
-      (void) process_spotify_session_events (p_prc);
-    }
-}
-
 /**
  * This callback is called from an internal libspotify thread to ask us to
  * reiterate the main loop.
@@ -1067,13 +1138,10 @@ notify_main_thread_handler (OMX_PTR ap_prc, tiz_event_pluggable_t * ap_event)
 static void
 notify_main_thread (sp_session * sess)
 {
-
-  if (tiz_comp_event_queue_unused_spaces (handleOf (sp_session_userdata (sess)))
-      >= SPFYSRC_MIN_QUEUE_UNUSED_SPACES)
-    {
-      post_spotify_event (sp_session_userdata (sess),
-                          notify_main_thread_handler, sess);
-    }
+  spfysrc_prc_t * p_prc = sp_session_userdata (sess);
+  assert (p_prc);
+  __atomic_store_n (&(p_prc->notify_pending_), 1, __ATOMIC_RELEASE);
+  wake_component (p_prc);
 }
 
 /**
@@ -1097,82 +1165,35 @@ metadata_updated (sp_session * sess)
   start_playback (p_prc);
 }
 
-static void
-music_delivery_handler (OMX_PTR ap_prc, tiz_event_pluggable_t * ap_event)
+/* Make a_format the format of the data that follows in the ring. Data in
+   different formats is never mixed in the ring; the component's thread needs
+   to drain the old data before the format can change. */
+static bool
+publish_pcm_format (spfysrc_prc_t * ap_prc, const sp_audioformat * ap_format)
 {
-  spfysrc_prc_t * p_prc = ap_prc;
-
-  assert (p_prc);
-  assert (ap_event);
-
-  TIZ_TRACE (handleOf (ap_prc), "p_data [%p] ", ap_event->p_data);
-
-  /* Decide if spotify music delivery needs pause/re-start */
-  reevaluate_cache (ap_prc);
-
-  if (!p_prc->stopping_ && ap_event->p_data)
+  assert (ap_prc);
+  assert (ap_format);
+  if (__atomic_load_n (&(ap_prc->ring_channels_), __ATOMIC_RELAXED)
+        != ap_format->channels
+      || __atomic_load_n (&(ap_prc->ring_samplerate_), __ATOMIC_RELAXED)
+           != ap_format->sample_rate)
     {
-      spfy_music_delivery_data_t * p_data = ap_event->p_data;
-      int nbytes
-        = p_data->num_frames * sizeof (int16_t) * p_data->format.channels;
-      OMX_U8 * p_in = (OMX_U8 *) p_data->p_frames;
-      OMX_BUFFERHEADERTYPE * p_out = NULL;
-
-      TIZ_TRACE (handleOf (ap_prc),
-                 "nbytes [%d] spotify_paused_ [%s] store [%d]", nbytes,
-                 p_prc->spotify_paused_ ? "YES" : "NO",
-                 tiz_buffer_available (p_prc->p_store_));
-
-      consume_cache (p_prc);
-      if (!p_prc->spotify_paused_)
+      if (tiz_spscring_available (ap_prc->p_ring_) > 0)
         {
-          while (nbytes > 0 && (p_out = buffer_needed (p_prc)) != NULL
-                 && !p_prc->initial_cache_bytes_)
-            {
-              int nbytes_copied = copy_to_omx_buffer (p_out, p_in, nbytes);
-              (void) release_buffer (p_prc);
-              nbytes -= nbytes_copied;
-              p_in += nbytes_copied;
-            }
+          return false;
         }
-
-      if (nbytes > 0)
-        {
-          int nbytes_stored = 0;
-          if ((nbytes_stored = tiz_buffer_push (p_prc->p_store_, p_in, nbytes))
-              < nbytes)
-            {
-              TIZ_ERROR (handleOf (p_prc),
-                         "Unable to store all the data (wanted %d, "
-                         "stored %d).",
-                         nbytes, nbytes_stored);
-              assert (0);
-            }
-          nbytes -= nbytes_stored;
-        }
-      if (p_prc->auto_detect_on_
-          || p_prc->num_channels_ != p_data->format.channels
-          || p_prc->samplerate_ != p_data->format.sample_rate)
-        {
-          p_prc->auto_detect_on_ = false;
-          p_prc->num_channels_ = p_data->format.channels;
-          p_prc->samplerate_ = p_data->format.sample_rate;
-          p_prc->audio_coding_type_ = OMX_AUDIO_CodingPCM;
-          set_audio_coding_on_port (p_prc);
-          set_pcm_audio_info_on_port (p_prc);
-          /* And now trigger the OMX_EventPortFormatDetected and
-             OMX_EventPortSettingsChanged events or a
-             OMX_ErrorFormatNotDetected event */
-          send_port_auto_detect_events (p_prc);
-        }
-      tiz_mem_free (p_data->p_frames);
-      tiz_mem_free (ap_event->p_data);
+      __atomic_store_n (&(ap_prc->ring_channels_), ap_format->channels,
+                        __ATOMIC_RELEASE);
+      __atomic_store_n (&(ap_prc->ring_samplerate_), ap_format->sample_rate,
+                        __ATOMIC_RELEASE);
     }
-  tiz_mem_free (ap_event);
+  return true;
 }
 
 /**
  * This callback is used from libspotify whenever there is PCM data available.
+ * The frames are copied straight into the ring; whatever does not fit is left
+ * for libspotify to deliver again later.
  *
  * @note This function is called from an internal session thread!
  */
@@ -1180,57 +1201,49 @@ static int
 music_delivery (sp_session * sess, const sp_audioformat * format,
                 const void * frames, int num_frames)
 {
+  spfysrc_prc_t * p_prc = sp_session_userdata (sess);
   int num_frames_delivered = 0;
-  if (num_frames > 0)
+  assert (p_prc);
+  if (num_frames > 0 && p_prc->p_ring_)
     {
-      /* We'll only send another pluggable event into the component's main
-         event queue if there are a few spaces available. Otherwise, we'll ask
-         Spotify to wait a little. */
-      if (tiz_comp_event_queue_unused_spaces (
-            handleOf (sp_session_userdata (sess)))
-          >= SPFYSRC_MIN_QUEUE_UNUSED_SPACES)
+      OMX_U32 frame_size = 0;
+      assert (format);
+      assert (frames);
+      frame_size = sizeof (int16_t) * format->channels;
+      if (publish_pcm_format (p_prc, format))
         {
-          spfy_music_delivery_data_t * p_data
-            = tiz_mem_calloc (1, sizeof (spfy_music_delivery_data_t));
-          if (p_data)
+          num_frames_delivered
+            = MIN (num_frames,
+                   (int) (tiz_spscring_space (p_prc->p_ring_) / frame_size));
+          if (num_frames_delivered > 0)
             {
-              size_t pcm_buffer_len
-                = num_frames * sizeof (int16_t) * format->channels;
-              assert (sess);
-              assert (format);
-              assert (frames);
-              p_data->p_sess = sess;
-              p_data->format.sample_type = format->sample_type;
-              p_data->format.sample_rate = format->sample_rate;
-              p_data->format.channels = format->channels;
-              p_data->p_frames = tiz_mem_alloc (pcm_buffer_len);
-              memcpy (p_data->p_frames, frames, pcm_buffer_len);
-              p_data->num_frames = num_frames;
-              TIZ_PRINTF_DBG_YEL (
-                "music_delivery - num frames : %d pcm_buffer_len : %d - "
-                "spaces %d\n",
-                num_frames, pcm_buffer_len,
-                tiz_comp_event_queue_unused_spaces (
-                  handleOf (sp_session_userdata (sess))));
-              post_spotify_event (sp_session_userdata (sess),
-                                  music_delivery_handler, p_data);
-              num_frames_delivered = num_frames;
+              (void) tiz_spscring_write (p_prc->p_ring_, frames,
+                                         num_frames_delivered * frame_size);
             }
         }
+      TIZ_PRINTF_DBG_YEL (
+        "music_delivery - num frames : %d delivered : %d - ring %u\n",
+        num_frames, num_frames_delivered,
+        tiz_spscring_available (p_prc->p_ring_));
+      /* Even if nothing fitted, make sure the ring is being drained */
+      wake_component (p_prc);
     }
   return num_frames_delivered;
 }
 
 static void
-end_of_track_handler (OMX_PTR ap_prc, tiz_event_pluggable_t * ap_event)
+handle_end_of_track (spfysrc_prc_t * ap_prc)
 {
   spfysrc_prc_t * p_prc = ap_prc;
   assert (p_prc);
-  assert (ap_event);
 
-  if (!p_prc->stopping_ && ap_event->p_data)
+  if (!p_prc->stopping_)
     {
+      /* The ring holds what is left of this track; the next one will not
+         start delivering until it is loaded below */
       p_prc->eos_ = true;
+      p_prc->bytes_till_eos_ = tiz_spscring_available (p_prc->p_ring_);
+      report_allocations (p_prc);
 
       if (p_prc->p_sp_track_)
         {
@@ -1268,6 +1281,17 @@ end_of_track_handler (OMX_PTR ap_prc, tiz_event_pluggable_t * ap_event)
       start_playback (p_prc);
       (void) process_spotify_session_events (p_prc);
     }
+}
+
+static void
+end_of_track_handler (OMX_PTR ap_prc, tiz_event_pluggable_t * ap_event)
+{
+  assert (ap_prc);
+  assert (ap_event);
+  if (ap_event->p_data)
+    {
+      handle_end_of_track (ap_prc);
+    }
   tiz_mem_free (ap_event);
 }
 
@@ -1279,8 +1303,11 @@ end_of_track_handler (OMX_PTR ap_prc, tiz_event_pluggable_t * ap_event)
 static void
 end_of_track (sp_session * sess)
 {
+  spfysrc_prc_t * p_prc = sp_session_userdata (sess);
+  assert (p_prc);
   TIZ_PRINTF_DBG_YEL ("end_of_track\n");
-  post_spotify_event (sp_session_userdata (sess), end_of_track_handler, sess);
+  __atomic_store_n (&(p_prc->end_of_track_pending_), 1, __ATOMIC_RELEASE);
+  wake_component (p_prc);
 }
 
 static void
@@ -1576,7 +1603,16 @@ spfysrc_prc_ctor (void * ap_obj, va_list * app)
   p_prc->initial_cache_bytes_ = 0;
   p_prc->min_cache_bytes_ = 0;
   p_prc->max_cache_bytes_ = 0;
-  p_prc->p_store_ = NULL;
+  p_prc->p_ring_ = NULL;
+  p_prc->p_ev_io_ = NULL;
+  p_prc->event_fd_ = -1;
+  p_prc->signalled_ = 0;
+  p_prc->notify_pending_ = 0;
+  p_prc->end_of_track_pending_ = 0;
+  p_prc->ring_channels_ = 0;
+  p_prc->ring_samplerate_ = 0;
+  p_prc->nallocs_ = 0;
+  p_prc->pcm_bytes_ = 0;
   p_prc->p_session_timer_ = NULL;
   p_prc->p_shuffle_lst_ = NULL;
   TIZ_INIT_OMX_STRUCT (p_prc->session_);
@@ -1766,6 +1802,7 @@ spfysrc_prc_stop_and_return (void * ap_obj)
   p_prc->transfering_ = false;
   p_prc->stopping_ = true;
   stop_spotify (p_prc);
+  report_allocations (p_prc);
   return OMX_ErrorNone;
 }
 
@@ -1783,19 +1820,59 @@ spfysrc_prc_buffers_ready (const void * ap_obj)
     {
       start_playback (p_prc);
     }
-  if (p_prc->transfering_ && p_prc->spotify_paused_)
+  if (p_prc->transfering_)
     {
       rc = consume_cache (p_prc);
       /* Decide if spotify music delivery needs pause/re-start */
       reevaluate_cache (p_prc);
     }
-  else
+  if (OMX_ErrorNone == rc && !p_prc->spotify_paused_)
     {
       rc = process_spotify_session_events (p_prc);
     }
   return rc;
 }
 
+static OMX_ERRORTYPE
+spfysrc_prc_io_ready (void * ap_prc, tiz_event_io_t * ap_ev_io, int a_fd,
+                      int a_events)
+{
+  spfysrc_prc_t * p_prc = ap_prc;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  assert (p_prc);
+
+  if (ap_ev_io == p_prc->p_ev_io_)
+    {
+      uint64_t count = 0;
+      (void) !read (p_prc->event_fd_, &count, sizeof (count));
+      /* Anything libspotify's thread delivers from now on signals again */
+      (void) __atomic_exchange_n (&(p_prc->signalled_), 0, __ATOMIC_ACQ_REL);
+
+      if (!p_prc->stopping_)
+        {
+          rc = consume_cache (p_prc);
+          /* Decide if spotify music delivery needs pause/re-start */
+          reevaluate_cache (p_prc);
+        }
+
+      if (__atomic_exchange_n (&(p_prc->notify_pending_), 0, __ATOMIC_ACQ_REL))
+        {
+          p_prc->keep_processing_sp_events_ = true;
+          if (!p_prc->stopping_)
+            {
+              (void) process_spotify_session_events (p_prc);
+            }
+        }
+
+      if (__atomic_exchange_n (&(p_prc->end_of_track_pending_), 0,
+                               __ATOMIC_ACQ_REL))
+        {
+          handle_end_of_track (p_prc);
+        }
+    }
+  return rc;
+}
+
 static OMX_ERRORTYPE
 spfysrc_prc_timer_ready (void * ap_prc, tiz_event_timer_t * ap_ev_timer,
                          void * ap_arg, const uint32_t a_id)
@@ -1995,6 +2072,8 @@ spfysrc_prc_init (void * ap_tos, void * ap_hdl)
      /* TIZ_CLASS_COMMENT: */
      tiz_srv_timer_ready, spfysrc_prc_timer_ready,
      /* TIZ_CLASS_COMMENT: */
+     tiz_srv_io_ready, spfysrc_prc_io_ready,
+     /* TIZ_CLASS_COMMENT: */
      tiz_prc_buffers_ready, spfysrc_prc_buffers_ready,
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_pause, spfysrc_prc_pause,
@@ -58,7 +58,16 @@ struct spfysrc_prc
   int initial_cache_bytes_;
   int min_cache_bytes_;
   int max_cache_bytes_;
-  tiz_buffer_t * p_store_; /* The component's pcm buffer */
+  tiz_spscring_t * p_ring_;  /* PCM written by libspotify's thread */
+  tiz_event_io_t * p_ev_io_; /* Watches event_fd_ */
+  int event_fd_;             /* Wakes up the component's thread */
+  int signalled_;            /* An unread wake-up is pending on event_fd_ */
+  int notify_pending_;       /* libspotify asked us to process its events */
+  int end_of_track_pending_; /* libspotify reported the end of the track */
+  int ring_channels_;        /* Format of the PCM currently in the ring */
+  int ring_samplerate_;
+  OMX_U32 nallocs_;          /* Pluggable events since the last report */
+  OMX_U64 pcm_bytes_;        /* PCM bytes handed over since the last report */
   tiz_event_timer_t * p_session_timer_;
   tiz_shuffle_lst_t * p_shuffle_lst_;
   OMX_TIZONIA_AUDIO_PARAM_SPOTIFYSESSIONTYPE session_;
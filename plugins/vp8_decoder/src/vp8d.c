@@ -33,6 +33,8 @@
 #include <assert.h>
 #include <string.h>
 
+#include <OMX_TizoniaExt.h>
+
 #include <tizplatform.h>
 
 #include <tizkernel.h>
@@ -56,6 +58,7 @@
  *
  * - Component name : "OMX.Aratelia.video_decoder.vp8"
  * - Implements role: "video_decoder.vp8"
+ * - Implements role: "video_decoder.vp9"
  *
  *@ingroup plugins
  */
@@ -152,6 +155,42 @@ instantiate_input_port (OMX_HANDLETYPE ap_hdl)
                       NULL /* OMX_VIDEO_PARAM_BITRATETYPE */);
 }
 
+static OMX_PTR
+instantiate_vp9_input_port (OMX_HANDLETYPE ap_hdl)
+{
+  OMX_VIDEO_PORTDEFINITIONTYPE portdef;
+  OMX_VIDEO_CODINGTYPE encodings[] = {OMX_VIDEO_CodingVP9, OMX_VIDEO_CodingMax};
+  OMX_COLOR_FORMATTYPE formats[] = {
+    OMX_COLOR_FormatUnused, OMX_COLOR_FormatYUV420Planar, OMX_COLOR_FormatMax};
+  tiz_port_options_t vp9_port_opts = {
+    OMX_PortDomainVideo,
+    OMX_DirInput,
+    ARATELIA_VP8_DECODER_PORT_MIN_BUF_COUNT,
+    ARATELIA_VP8_DECODER_PORT_MIN_INPUT_BUF_SIZE,
+    ARATELIA_VP8_DECODER_PORT_NONCONTIGUOUS,
+    ARATELIA_VP8_DECODER_PORT_ALIGNMENT,
+    ARATELIA_VP8_DECODER_PORT_SUPPLIERPREF,
+    {ARATELIA_VP8_DECODER_INPUT_PORT_INDEX, NULL, NULL, NULL},
+    1 /* slave port */
+  };
+
+  /* Same defaults as the VP8 role */
+  portdef.pNativeRender = NULL;
+  portdef.nFrameWidth = 176;
+  portdef.nFrameHeight = 144;
+  portdef.nStride = 0;
+  portdef.nSliceHeight = 0;
+  portdef.nBitrate = 64000;
+  portdef.xFramerate = 15 << 16;
+  portdef.bFlagErrorConcealment = OMX_FALSE;
+  portdef.eCompressionFormat = OMX_VIDEO_CodingVP9;
+  portdef.eColorFormat = OMX_COLOR_FormatUnused;
+  portdef.pNativeWindow = NULL;
+
+  return factory_new (tiz_get_type (ap_hdl, "vp9dinport"), &vp9_port_opts,
+                      &portdef, &encodings, &formats);
+}
+
 static OMX_PTR
 instantiate_output_port (OMX_HANDLETYPE ap_hdl)
 {
@@ -207,11 +246,14 @@ instantiate_processor (OMX_HANDLETYPE ap_hdl)
 OMX_ERRORTYPE
 OMX_ComponentInit (OMX_HANDLETYPE ap_hdl)
 {
-  tiz_role_factory_t role_factory;
-  const tiz_role_factory_t * rf_list[] = {&role_factory};
+  tiz_role_factory_t vp8_role;
+  tiz_role_factory_t vp9_role;
+  const tiz_role_factory_t * rf_list[] = {&vp8_role, &vp9_role};
   tiz_type_factory_t vp8d_inport_type;
+  tiz_type_factory_t vp9d_inport_type;
   tiz_type_factory_t vp8dprc_type;
   const tiz_type_factory_t * tf_list[] = {&vp8d_inport_type,
+                                          &vp9d_inport_type,
                                           &vp8dprc_type};
   const tiz_eglimage_hook_t egl_validation_hook = {
     ARATELIA_VP8_DECODER_OUTPUT_PORT_INDEX,
@@ -219,18 +261,30 @@ OMX_ComponentInit (OMX_HANDLETYPE ap_hdl)
     NULL
   };
 
-  strcpy ((OMX_STRING) role_factory.role, ARATELIA_VP8_DECODER_DEFAULT_ROLE);
-  role_factory.pf_cport = instantiate_config_port;
-  role_factory.pf_port[0] = instantiate_input_port;
-  role_factory.pf_port[1] = instantiate_output_port;
-  role_factory.nports = 2;
-  role_factory.pf_proc = instantiate_processor;
+  strcpy ((OMX_STRING) vp8_role.role, ARATELIA_VP8_DECODER_DEFAULT_ROLE);
+  vp8_role.pf_cport = instantiate_config_port;
+  vp8_role.pf_port[0] = instantiate_input_port;
+  vp8_role.pf_port[1] = instantiate_output_port;
+  vp8_role.nports = 2;
+  vp8_role.pf_proc = instantiate_processor;
+
+  strcpy ((OMX_STRING) vp9_role.role, ARATELIA_VP8_DECODER_VP9_ROLE);
+  vp9_role.pf_cport = instantiate_config_port;
+  vp9_role.pf_port[0] = instantiate_vp9_input_port;
+  vp9_role.pf_port[1] = instantiate_output_port;
+  vp9_role.nports = 2;
+  vp9_role.pf_proc = instantiate_processor;
 
   strcpy ((OMX_STRING) vp8d_inport_type.class_name, "vp8dinport_class");
   vp8d_inport_type.pf_class_init = vp8d_inport_class_init;
   strcpy ((OMX_STRING) vp8d_inport_type.object_name, "vp8dinport");
   vp8d_inport_type.pf_object_init = vp8d_inport_init;
 
+  strcpy ((OMX_STRING) vp9d_inport_type.class_name, "vp9dinport_class");
+  vp9d_inport_type.pf_class_init = vp9d_inport_class_init;
+  strcpy ((OMX_STRING) vp9d_inport_type.object_name, "vp9dinport");
+  vp9d_inport_type.pf_object_init = vp9d_inport_init;
+
   strcpy ((OMX_STRING) vp8dprc_type.class_name, "vp8dprc_class");
   vp8dprc_type.pf_class_init = vp8d_prc_class_init;
   strcpy ((OMX_STRING) vp8dprc_type.object_name, "vp8dprc");
@@ -239,16 +293,19 @@ OMX_ComponentInit (OMX_HANDLETYPE ap_hdl)
   /* Initialize the component infrastructure */
   tiz_check_omx (tiz_comp_init (ap_hdl, ARATELIA_VP8_DECODER_COMPONENT_NAME));
 
-  /* Register the "vp8dprc" class */
-  tiz_check_omx (tiz_comp_register_types (ap_hdl, tf_list, 2));
+  /* Register the "vp8dinport", "vp9dinport" and "vp8dprc" classes */
+  tiz_check_omx (tiz_comp_register_types (ap_hdl, tf_list, 3));
 
-  /* Register the component role */
-  tiz_check_omx (tiz_comp_register_roles (ap_hdl, rf_list, 1));
+  /* Register the component roles */
+  tiz_check_omx (tiz_comp_register_roles (ap_hdl, rf_list, 2));
 
-  /* Register the egl image validation hook for the default role */
+  /* Register the egl image validation hook for both roles */
   tiz_check_omx (tiz_comp_register_role_eglimage_hook (
     ap_hdl, (const OMX_U8 *) ARATELIA_VP8_DECODER_DEFAULT_ROLE,
     &egl_validation_hook));
+  tiz_check_omx (tiz_comp_register_role_eglimage_hook (
+    ap_hdl, (const OMX_U8 *) ARATELIA_VP8_DECODER_VP9_ROLE,
+    &egl_validation_hook));
 
   return OMX_ErrorNone;
 }
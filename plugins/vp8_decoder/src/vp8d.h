@@ -38,6 +38,7 @@ extern "C" {
 #define ARATELIA_VP8_DECODER_DEFAULT_FRAME_WIDTH 176
 #define ARATELIA_VP8_DECODER_DEFAULT_FRAME_HEIGHT 144
 #define ARATELIA_VP8_DECODER_DEFAULT_ROLE "video_decoder.vp8"
+#define ARATELIA_VP8_DECODER_VP9_ROLE "video_decoder.vp9"
 #define ARATELIA_VP8_DECODER_COMPONENT_NAME "OMX.Aratelia.video_decoder.vp8"
 /* With libtizonia, port indexes must start at index 0 */
 #define ARATELIA_VP8_DECODER_INPUT_PORT_INDEX 0
@@ -49,6 +50,9 @@ extern "C" {
 #define ARATELIA_VP8_DECODER_PORT_NONCONTIGUOUS OMX_FALSE
 #define ARATELIA_VP8_DECODER_PORT_ALIGNMENT 0
 #define ARATELIA_VP8_DECODER_PORT_SUPPLIERPREF OMX_BufferSupplyInput
+/* 0 = one decoder thread per online cpu, up to the maximum below */
+#define ARATELIA_VP8_DECODER_DEFAULT_THREADS 0
+#define ARATELIA_VP8_DECODER_MAX_THREADS 8
 
 #ifdef __cplusplus
 }
@@ -48,8 +48,9 @@ static void * vp8d_inport_dtor (void * ap_obj)
  */
 
 static OMX_ERRORTYPE
-vp8d_inport_SetParameter (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
-                          OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+inport_SetParameter (const char * ap_type_name, const void * ap_obj,
+                     OMX_HANDLETYPE ap_hdl, OMX_INDEXTYPE a_index,
+                     OMX_PTR ap_struct)
 {
   OMX_ERRORTYPE err = OMX_ErrorNone;
 
@@ -75,7 +76,7 @@ vp8d_inport_SetParameter (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
     if (i_def->format.video.nSliceHeight == 0)
       i_def->format.video.nSliceHeight = i_def->format.video.nFrameHeight;
 
-    err = super_SetParameter (typeOf (ap_obj, "vp8dinport"), ap_obj,
+    err = super_SetParameter (typeOf (ap_obj, ap_type_name), ap_obj,
                               ap_hdl, a_index, ap_struct);
     if (err == OMX_ErrorNone) {
       tiz_port_t * p_obj = (tiz_port_t *) ap_obj;
@@ -94,6 +95,14 @@ vp8d_inport_SetParameter (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
   return err;
 }
 
+static OMX_ERRORTYPE
+vp8d_inport_SetParameter (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                          OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  return inport_SetParameter ("vp8dinport", ap_obj, ap_hdl, a_index,
+                              ap_struct);
+}
+
 /*
  * vp8dinport_class
  */
@@ -142,3 +151,78 @@ vp8d_inport_init (void * ap_tos, void * ap_hdl)
 
    return vp8dinport;
 }
+
+/*
+ * vp9dinport class
+ */
+
+static void * vp9d_inport_ctor (void * ap_obj, va_list * app)
+{
+   return super_ctor (typeOf (ap_obj, "vp9dinport"), ap_obj, app);
+}
+
+static void * vp9d_inport_dtor (void * ap_obj)
+{
+   return super_dtor (typeOf (ap_obj, "vp9dinport"), ap_obj);
+}
+
+/*
+ * from tiz_api
+ */
+
+static OMX_ERRORTYPE
+vp9d_inport_SetParameter (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                          OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  return inport_SetParameter ("vp9dinport", ap_obj, ap_hdl, a_index,
+                              ap_struct);
+}
+
+/*
+ * vp9dinport_class
+ */
+
+static void *
+vp9d_inport_class_ctor (void * ap_obj, va_list * app)
+{
+   /* NOTE: Class methods might be added in the future. None for now. */
+   return super_ctor (typeOf (ap_obj, "vp9dinport_class"), ap_obj, app);
+}
+
+/*
+ * initialization
+ */
+
+void *
+vp9d_inport_class_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizvideoport = tiz_get_type(ap_hdl, "tizvideoport");
+  void * vp9dinport_class
+    = factory_new(classOf(tizvideoport), "vp9dinport_class",
+                  classOf(tizvideoport), sizeof(vp9d_inport_class_t),
+                  ap_tos, ap_hdl, ctor, vp9d_inport_class_ctor, 0);
+  return vp9dinport_class;
+}
+
+void *
+vp9d_inport_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizvideoport = tiz_get_type (ap_hdl, "tizvideoport");
+  void * vp9dinport_class = tiz_get_type (ap_hdl, "vp9dinport_class");
+  void * vp9dinport = factory_new
+    /* TIZ_CLASS_COMMENT: class type, class name, parent, size */
+    (vp9dinport_class, "vp9dinport", tizvideoport,
+    sizeof (vp9d_inport_t),
+    /* TIZ_CLASS_COMMENT: class constructor */
+    ap_tos, ap_hdl,
+    /* TIZ_CLASS_COMMENT: class constructor */
+    ctor, vp9d_inport_ctor,
+    /* TIZ_CLASS_COMMENT: class destructor */
+    dtor, vp9d_inport_dtor,
+    /* TIZ_CLASS_COMMENT: */
+    tiz_api_SetParameter, vp9d_inport_SetParameter,
+    /* TIZ_CLASS_COMMENT: stop value*/
+    0);
+
+   return vp9dinport;
+}
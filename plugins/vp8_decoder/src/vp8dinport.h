@@ -28,6 +28,10 @@ void *
 vp8d_inport_class_init (void * ap_tos, void * ap_hdl);
 void *
 vp8d_inport_init (void * ap_tos, void * ap_hdl);
+void *
+vp9d_inport_class_init (void * ap_tos, void * ap_hdl);
+void *
+vp9d_inport_init (void * ap_tos, void * ap_hdl);
 
 #ifdef __cplusplus
 }
@@ -21,6 +21,7 @@
 #define VP8DINPORT_DECLS_H
 
 #include <tizvp8port_decls.h>
+#include <tizvideoport_decls.h>
 
 typedef struct vp8d_inport vp8d_inport_t;
 struct vp8d_inport
@@ -37,4 +38,19 @@ struct vp8d_inport_class
    /* NOTE: Class methods might be added in the future */
 };
 
+typedef struct vp9d_inport vp9d_inport_t;
+struct vp9d_inport
+{
+   /* Object */
+   const tiz_videoport_t _;
+};
+
+typedef struct vp9d_inport_class vp9d_inport_class_t;
+struct vp9d_inport_class
+{
+   /* Class */
+   const tiz_videoport_class_t _;
+   /* NOTE: Class methods might be added in the future */
+};
+
 #endif /* VP8DINPORT_DECLS_H */
@@ -36,6 +36,9 @@
 #include <assert.h>
 #include <limits.h>
 #include <string.h>
+#include <unistd.h>
+
+#include <OMX_TizoniaExt.h>
 
 #include <tizplatform.h>
 
@@ -78,7 +81,11 @@
                  ap_prc->info_.type == STREAM_RAW                           \
                    ? "RAW"                                                  \
                    : (ap_prc->info_.type == STREAM_IVF ? "IVF" : "UKNOWN"), \
-                 ap_prc->info_.fourcc == VP8_FOURCC ? "VP8" : "OTHER",      \
+                 same_fourcc (ap_prc->info_.fourcc, VP8_FOURCC)             \
+                   ? "VP8"                                                  \
+                   : (same_fourcc (ap_prc->info_.fourcc, VP9_FOURCC)        \
+                        ? "VP9"                                             \
+                        : "OTHER"),                                         \
                  ap_prc->info_.width, ap_prc->info_.height,                 \
                  ap_prc->info_.fps_den, ap_prc->info_.fps_num);             \
     }                                                                       \
@@ -92,8 +99,49 @@ static const struct
   unsigned int fourcc_mask;
 } ifaces[] = {
   {"vp8", &vpx_codec_vp8_dx_algo, VP8_FOURCC, 0x00FFFFFF},
+  {"vp9", &vpx_codec_vp9_dx_algo, VP9_FOURCC, 0x00FFFFFF},
 };
 
+static bool
+same_fourcc (const unsigned int a_fourcc1, const unsigned int a_fourcc2)
+{
+  /* Ignore the version number, e.g. 'VP80' vs 'VP8' */
+  return (a_fourcc1 & 0x00FFFFFF) == (a_fourcc2 & 0x00FFFFFF);
+}
+
+static unsigned int
+get_decoder_threads (vp8d_prc_t * ap_prc)
+{
+  const char * p_threads
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                            ARATELIA_VP8_DECODER_COMPONENT_NAME ".threads");
+  long threads = ARATELIA_VP8_DECODER_DEFAULT_THREADS;
+  assert (ap_prc);
+  if (p_threads)
+    {
+      threads = strtol (p_threads, NULL, 10);
+    }
+  if (threads <= 0)
+    {
+      threads = sysconf (_SC_NPROCESSORS_ONLN);
+    }
+  if (threads > ARATELIA_VP8_DECODER_MAX_THREADS)
+    {
+      threads = ARATELIA_VP8_DECODER_MAX_THREADS;
+    }
+  return threads > 0 ? threads : 1;
+}
+
+static bool
+frame_parallel_requested (vp8d_prc_t * ap_prc)
+{
+  const char * p_fp = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION,
+    ARATELIA_VP8_DECODER_COMPONENT_NAME ".frame_parallel");
+  assert (ap_prc);
+  return (p_fp && 0 == strncmp (p_fp, "true", 4));
+}
+
 /* NOTE: Code from libvpx's mem_ops.h */
 static unsigned int
 mem_get_le16 (const void * vmem)
@@ -453,7 +501,8 @@ buffer_emptied (vp8d_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
 }
 
 static void
-buffer_filled (vp8d_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
+buffer_filled (vp8d_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr,
+               const bool a_eos)
 {
   assert (ap_prc);
   assert (ap_hdr);
@@ -463,13 +512,14 @@ buffer_filled (vp8d_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
     {
       ap_hdr->nOffset = 0;
 
-      if (ap_prc->eos_)
+      if (a_eos)
         {
           /* EOS has been received and all the input data has been consumed
        * already, so its time to propagate the EOS flag */
           ap_prc->p_outhdr_->nFlags |= OMX_BUFFERFLAG_EOS;
-          /* Reset the flag so we are ready to receive a new stream */
+          /* Reset the flags so we are ready to receive a new stream */
           ap_prc->eos_ = false;
+          ap_prc->flushed_ = false;
         }
 
       (void) tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)),
@@ -491,6 +541,13 @@ obtain_stream_info (vp8d_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * p_inhdr)
     {
       VP8DPRC_LOG_STATE (ap_prc);
 
+      if (!same_fourcc (ap_prc->info_.fourcc, ap_prc->fourcc_))
+        {
+          TIZ_ERROR (handleOf (ap_prc),
+                     "The stream's codec does not match the component's role");
+          return OMX_ErrorFormatNotDetected;
+        }
+
       if (STREAM_IVF == ap_prc->info_.type)
         {
           /* Make sure we skip the IVF header the next time we read from the
@@ -692,27 +749,77 @@ read_frame (vp8d_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_inhdr)
   return rc;
 }
 
-static void
-out_put (OMX_BUFFERHEADERTYPE * p_hdr, const uint8_t * buf, unsigned int len)
+static OMX_U8 *
+copy_plane (OMX_U8 * ap_dst, const uint8_t * ap_src, const int a_stride,
+            const unsigned int a_width, const unsigned int a_height)
+{
+  unsigned int y;
+
+  if (a_stride == (int) a_width)
+    {
+      memcpy (ap_dst, ap_src, a_width * a_height);
+      return ap_dst + a_width * a_height;
+    }
+
+  for (y = 0; y < a_height; y++)
+    {
+      memcpy (ap_dst, ap_src, a_width);
+      ap_dst += a_width;
+      ap_src += a_stride;
+    }
+  return ap_dst;
+}
+
+static OMX_ERRORTYPE
+copy_frame (vp8d_prc_t * ap_prc, const vpx_image_t * ap_img,
+            OMX_BUFFERHEADERTYPE * ap_hdr)
 {
-  memcpy (p_hdr->pBuffer + p_hdr->nOffset, buf, len);
-  p_hdr->nOffset += len;
-  p_hdr->nFilledLen = p_hdr->nOffset;
+  const unsigned int uv_width = (1 + ap_img->d_w) / 2;
+  const unsigned int uv_height = (1 + ap_img->d_h) / 2;
+  const size_t frame_len
+    = ap_img->d_w * ap_img->d_h + 2 * uv_width * uv_height;
+  OMX_U8 * p_dst = NULL;
+
+  assert (ap_prc);
+  assert (ap_img);
+  assert (ap_hdr);
 
-  if (p_hdr->nFilledLen > p_hdr->nAllocLen)
+  if (VPX_IMG_FMT_I420 != ap_img->fmt)
     {
-      TIZ_LOG (TIZ_PRIORITY_TRACE, "len [%d] nFilledLen [%d] nAllocLen [%d]",
-               len, p_hdr->nFilledLen, p_hdr->nAllocLen);
-      assert (p_hdr->nFilledLen <= p_hdr->nAllocLen);
+      TIZ_ERROR (handleOf (ap_prc),
+                 "Unsupported image format [%0x] (only 8-bit 4:2:0 is "
+                 "supported)",
+                 ap_img->fmt);
+      return OMX_ErrorFormatNotDetected;
     }
+
+  if (frame_len > ap_hdr->nAllocLen - ap_hdr->nOffset)
+    {
+      TIZ_ERROR (handleOf (ap_prc),
+                 "Frame does not fit : frame [%u] bytes nAllocLen [%u]",
+                 (unsigned int) frame_len, ap_hdr->nAllocLen);
+      return OMX_ErrorInsufficientResources;
+    }
+
+  /* The output buffer holds the planes back to back, without padding */
+  p_dst = ap_hdr->pBuffer + ap_hdr->nOffset;
+  p_dst = copy_plane (p_dst, ap_img->planes[VPX_PLANE_Y],
+                      ap_img->stride[VPX_PLANE_Y], ap_img->d_w, ap_img->d_h);
+  p_dst = copy_plane (p_dst, ap_img->planes[VPX_PLANE_U],
+                      ap_img->stride[VPX_PLANE_U], uv_width, uv_height);
+  (void) copy_plane (p_dst, ap_img->planes[VPX_PLANE_V],
+                     ap_img->stride[VPX_PLANE_V], uv_width, uv_height);
+
+  ap_hdr->nOffset += frame_len;
+  ap_hdr->nFilledLen = ap_hdr->nOffset;
+
+  return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
 decode_frame (vp8d_prc_t * ap_prc)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
-  vpx_codec_iter_t iter = NULL;
-  vpx_image_t * img = NULL;
   vp8d_codec_buffer_t * p_buf = NULL;
 
   assert (ap_prc);
@@ -724,54 +831,32 @@ decode_frame (vp8d_prc_t * ap_prc)
                       (unsigned int) (p_buf->filled_len), NULL, 0),
     OMX_ErrorStreamCorrupt);
 
-  if ((img = vpx_codec_get_frame (&(ap_prc->vp8ctx_), &iter)))
-    {
-      unsigned int y;
-      uint8_t * buf = img->planes[VPX_PLANE_Y];
-
-#if 0
-      {
-        TIZ_DEBUG (handleOf (ap_prc),
-                   "d_w = %u "
-                   "d_h = %u "
-                   "stride[VPX_PLANE_Y] = %d "
-                   "stride[VPX_PLANE_U] = %d "
-                   "stride[VPX_PLANE_V] = %d "
-                   "img fmt = %0x "
-                   "color = %0x "
-                   "range = %0x",
-                   img->d_w, img->d_h, img->stride[VPX_PLANE_Y],
-                   img->stride[VPX_PLANE_U], img->stride[VPX_PLANE_V],
-                   img->fmt, img->cs, img->range);
-        }
-#endif
+end:
 
-      for (y = 0; y < img->d_h; y++)
-        {
-          out_put (ap_prc->p_outhdr_, buf, img->d_w);
-          buf += img->stride[VPX_PLANE_Y];
-        }
+  /* The decoded frames are retrieved with a fresh iterator */
+  ap_prc->iter_ = NULL;
+  p_buf->filled_len = 0;
 
-      buf = img->planes[VPX_PLANE_U];
+  return rc;
+}
 
-      for (y = 0; y < (1 + img->d_h) / 2; y++)
-        {
-          out_put (ap_prc->p_outhdr_, buf, (1 + img->d_w) / 2);
-          buf += img->stride[VPX_PLANE_U];
-        }
+static OMX_ERRORTYPE
+flush_decoder (vp8d_prc_t * ap_prc)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
 
-      buf = img->planes[VPX_PLANE_V];
+  assert (ap_prc);
 
-      for (y = 0; y < (1 + img->d_h) / 2; y++)
-        {
-          out_put (ap_prc->p_outhdr_, buf, (1 + img->d_w) / 2);
-          buf += img->stride[VPX_PLANE_V];
-        }
-    }
+  /* Let the decoder know there is no more data, so that the frames still in
+     flight in its threads are output */
+  bail_on_vpx_err_with_omx_err (
+    vpx_codec_decode (&(ap_prc->vp8ctx_), NULL, 0, NULL, 0),
+    OMX_ErrorStreamCorrupt);
 
 end:
 
-  p_buf->filled_len = 0;
+  ap_prc->iter_ = NULL;
+  ap_prc->flushed_ = true;
 
   return rc;
 }
@@ -782,6 +867,7 @@ decode_stream (vp8d_prc_t * ap_prc)
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   OMX_BUFFERHEADERTYPE * p_inhdr = NULL;
   OMX_BUFFERHEADERTYPE * p_outhdr = NULL;
+  vpx_image_t * p_img = NULL;
   assert (ap_prc);
 
   /* Step 1: peak at the stream and find the stream parameters */
@@ -792,29 +878,53 @@ decode_stream (vp8d_prc_t * ap_prc)
       ap_prc->first_buf_ = false;
     }
 
-  while (!ap_prc->eos_ && (p_inhdr = get_input_buffer (ap_prc))
-         && (p_outhdr = get_output_buffer (ap_prc)))
+  while ((p_outhdr = get_output_buffer (ap_prc)))
     {
-      /* Step 2: Read a frame into our internal storage */
-      if (p_inhdr->nFilledLen > 0 && !ap_prc->out_port_disabled_)
+      /* Step 2: Output the next decoded frame, if there is one */
+      if ((p_img = vpx_codec_get_frame (&(ap_prc->vp8ctx_), &(ap_prc->iter_))))
+        {
+          tiz_check_omx (copy_frame (ap_prc, p_img, p_outhdr));
+          /* With frame threading, there may be more frames to come once the
+             decoder has been flushed; the EOS flag then goes out in a buffer
+             of its own */
+          buffer_filled (ap_prc, p_outhdr,
+                         ap_prc->eos_ && !ap_prc->frame_threading_);
+          continue;
+        }
+
+      if (ap_prc->eos_)
+        {
+          if (ap_prc->frame_threading_ && !ap_prc->flushed_)
+            {
+              tiz_check_omx (flush_decoder (ap_prc));
+            }
+          else
+            {
+              /* All the frames are out, propagate the EOS flag */
+              buffer_filled (ap_prc, p_outhdr, true);
+            }
+          continue;
+        }
+
+      if (!(p_inhdr = get_input_buffer (ap_prc)))
+        {
+          break;
+        }
+
+      /* Step 3: Read a frame into our internal storage, and decode it */
+      if (p_inhdr->nFilledLen > 0)
         {
           if (OMX_ErrorNone == read_frame (ap_prc, p_inhdr))
             {
-              /* Step 3: Decode the frame just read */
               tiz_check_omx (decode_frame (ap_prc));
             }
         }
 
-      /* Step 4: Get rid of input and output buffers, if we can */
+      /* Step 4: Get rid of the input buffer, if we can */
       if (p_inhdr->nFilledLen == 0)
         {
           buffer_emptied (ap_prc, p_inhdr);
         }
-
-      if (p_outhdr->nFilledLen > 0 || ap_prc->eos_)
-        {
-          buffer_filled (ap_prc, p_outhdr);
-        }
     }
 
   return rc;
@@ -842,8 +952,10 @@ reset_stream_parameters (vp8d_prc_t * ap_prc)
                           OMX_IndexParamPortDefinition, &(ap_prc->port_def_)));
   ap_prc->p_inhdr_ = 0;
   ap_prc->p_outhdr_ = 0;
+  ap_prc->iter_ = NULL;
   ap_prc->first_buf_ = true;
   ap_prc->eos_ = false;
+  ap_prc->flushed_ = false;
   return OMX_ErrorNone;
 }
 
@@ -891,6 +1003,9 @@ vp8d_prc_ctor (void * ap_obj, va_list * app)
 {
   vp8d_prc_t * p_prc = super_ctor (typeOf (ap_obj, "vp8dprc"), ap_obj, app);
   assert (p_prc);
+  p_prc->p_iface_ = ifaces[0].iface;
+  p_prc->fourcc_ = ifaces[0].fourcc;
+  p_prc->frame_threading_ = false;
   p_prc->in_port_disabled_ = false;
   p_prc->out_port_disabled_ = false;
   (void) reset_stream_parameters (p_prc);
@@ -909,11 +1024,45 @@ vp8d_prc_dtor (void * ap_obj)
  * from tiz_srv class
  */
 
+static OMX_ERRORTYPE
+select_codec (vp8d_prc_t * ap_prc)
+{
+  OMX_PARAM_PORTDEFINITIONTYPE port_def;
+  unsigned int fourcc = VP8_FOURCC;
+  size_t i = 0;
+
+  assert (ap_prc);
+
+  /* The role in use is given away by the input port's encoding */
+  TIZ_INIT_OMX_PORT_STRUCT (port_def, ARATELIA_VP8_DECODER_INPUT_PORT_INDEX);
+  tiz_check_omx (
+    tiz_api_GetParameter (tiz_get_krn (handleOf (ap_prc)), handleOf (ap_prc),
+                          OMX_IndexParamPortDefinition, &port_def));
+
+  if (OMX_VIDEO_CodingVP9 == port_def.format.video.eCompressionFormat)
+    {
+      fourcc = VP9_FOURCC;
+    }
+
+  for (i = 0; i < sizeof (ifaces) / sizeof (ifaces[0]); i++)
+    {
+      if (fourcc == ifaces[i].fourcc)
+        {
+          ap_prc->p_iface_ = ifaces[i].iface;
+          ap_prc->fourcc_ = ifaces[i].fourcc;
+          break;
+        }
+    }
+
+  return OMX_ErrorNone;
+}
+
 static OMX_ERRORTYPE
 vp8d_prc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   vp8d_prc_t * ap_prc = ap_obj;
+  vpx_codec_dec_cfg_t cfg;
   int flags = 0;
 
   assert (ap_prc);
@@ -922,11 +1071,46 @@ vp8d_prc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
   /*   flags = (postprc ? VPX_CODEC_USE_POSTPRC : 0) | */
   /*     (ec_enabled ? VPX_CODEC_USE_ERROR_CONCEALMENT : 0); */
 
+  tiz_check_omx (select_codec (ap_prc));
+
+  tiz_mem_set (&cfg, 0, sizeof (cfg));
+  cfg.threads = get_decoder_threads (ap_prc);
+
+  ap_prc->frame_threading_ = false;
+  if (frame_parallel_requested (ap_prc))
+    {
+#ifdef VPX_CODEC_USE_FRAME_THREADING
+      if (vpx_codec_get_caps (ap_prc->p_iface_) & VPX_CODEC_CAP_FRAME_THREADING)
+        {
+          flags |= VPX_CODEC_USE_FRAME_THREADING;
+          ap_prc->frame_threading_ = true;
+        }
+#endif
+      if (!ap_prc->frame_threading_)
+        {
+          TIZ_NOTICE (handleOf (ap_prc),
+                      "Frame-parallel decoding is not available with [%s]",
+                      vpx_codec_iface_name (ap_prc->p_iface_));
+        }
+    }
+
   /* Initialize codec */
   bail_on_vpx_err_with_omx_err (
-    vpx_codec_dec_init (&(ap_prc->vp8ctx_), ifaces[0].iface, NULL, flags),
+    vpx_codec_dec_init (&(ap_prc->vp8ctx_), ap_prc->p_iface_, &cfg, flags),
     OMX_ErrorInsufficientResources);
 
+#ifdef VPX_CTRL_VP9D_SET_ROW_MT
+  if (VP9_FOURCC == ap_prc->fourcc_ && cfg.threads > 1)
+    {
+      /* Decode rows in parallel too, not just tiles */
+      (void) vpx_codec_control (&(ap_prc->vp8ctx_), VP9D_SET_ROW_MT, 1);
+    }
+#endif
+
+  TIZ_DEBUG (handleOf (ap_prc), "[%s] threads [%u] frame threading [%s]",
+             vpx_codec_iface_name (ap_prc->p_iface_), cfg.threads,
+             ap_prc->frame_threading_ ? "YES" : "NO");
+
 end:
 
   return rc;
@@ -91,6 +91,11 @@ struct vp8d_prc
   OMX_BUFFERHEADERTYPE * p_inhdr_;
   OMX_BUFFERHEADERTYPE * p_outhdr_;
   vpx_codec_ctx_t vp8ctx_;
+  vpx_codec_iface_t * p_iface_;
+  unsigned int fourcc_;
+  vpx_codec_iter_t iter_;
+  bool frame_threading_;
+  bool flushed_;
   bool in_port_disabled_;
   bool out_port_disabled_;
   bool first_buf_;
@@ -73,7 +73,10 @@ instantiate_input_port (OMX_HANDLETYPE ap_hdl)
     ARATELIA_YUV_RENDERER_PORT_NONCONTIGUOUS,
     ARATELIA_YUV_RENDERER_PORT_ALIGNMENT,
     ARATELIA_YUV_RENDERER_PORT_SUPPLIERPREF,
-    {ARATELIA_YUV_RENDERER_PORT_INDEX, NULL, NULL, NULL},
+    /* The buffers are backed by SDL overlays whenever possible, so that
+       frames are rendered without copying them */
+    {ARATELIA_YUV_RENDERER_PORT_INDEX, sdlivr_prc_alloc_hook,
+     sdlivr_prc_free_hook, ap_hdl},
     0 /* use 0 for now */
   };
 
@@ -46,6 +46,10 @@ extern "C" {
 #define ARATELIA_YUV_RENDERER_PORT_NONCONTIGUOUS OMX_FALSE
 #define ARATELIA_YUV_RENDERER_PORT_ALIGNMENT 0
 #define ARATELIA_YUV_RENDERER_PORT_SUPPLIERPREF OMX_BufferSupplyInput
+#define ARATELIA_YUV_RENDERER_MAX_OVERLAY_BUFFERS 16
+#define ARATELIA_YUV_RENDERER_DEFAULT_MAX_LATENESS_MS 40
+/* Frames presented later than this are counted as late */
+#define ARATELIA_YUV_RENDERER_LATE_TOLERANCE_MS 5
 
 #ifdef __cplusplus
 }
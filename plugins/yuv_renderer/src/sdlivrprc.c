@@ -32,11 +32,14 @@
 
 #include <assert.h>
 #include <limits.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <tizplatform.h>
 
 #include <tizkernel.h>
+#include <tizscheduler.h>
 #include <tizservant_decls.h>
 
 #include "sdlivr.h"
@@ -48,104 +51,465 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.yuv_renderer.prc"
 #endif
 
+/* Frames due sooner than this are presented right away */
+#define SDLIVR_PRC_MIN_WAIT_MS 1.0
+
 /* forward declarations */
 static OMX_ERRORTYPE
 sdlivr_prc_deallocate_resources (void * ap_obj);
+static OMX_ERRORTYPE
+sdlivr_prc_buffers_ready (const void * ap_obj);
+
+static double
+now_ms (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static bool
+config_bool (const char * ap_value, const bool a_default)
+{
+  return ap_value ? 0 == strncmp (ap_value, "true", 4) : a_default;
+}
+
+static int
+frame_pitch (const OMX_VIDEO_PORTDEFINITIONTYPE * ap_vpd)
+{
+  assert (ap_vpd);
+  /* align pitch on 16-pixel boundary, unless the port says otherwise */
+  return ap_vpd->nStride == 0 ? (int) ((ap_vpd->nFrameWidth + 15) & ~15)
+                              : (int) ap_vpd->nStride;
+}
+
+static bool
+set_video_mode (sdlivr_prc_t * ap_prc)
+{
+  const int width = ap_prc->port_def_.nFrameWidth;
+  const int height = ap_prc->port_def_.nFrameHeight;
+  assert (ap_prc);
+  if (!ap_prc->p_surface || ap_prc->p_surface->w != width
+      || ap_prc->p_surface->h != height)
+    {
+      SDL_WM_SetCaption ("Tizonia YUV renderer", "YUV");
+      ap_prc->p_surface
+        = SDL_SetVideoMode (width, height, 0, SDL_HWSURFACE | SDL_ASYNCBLIT
+                                                | SDL_HWACCEL | SDL_RESIZABLE);
+    }
+  return ap_prc->p_surface != NULL;
+}
 
 static OMX_ERRORTYPE
-sdlivr_prc_render_buffer (const sdlivr_prc_t * ap_prc,
-                          OMX_BUFFERHEADERTYPE * p_hdr)
+update_port_def (sdlivr_prc_t * ap_prc)
+{
+  OMX_PARAM_PORTDEFINITIONTYPE portdef;
+  TIZ_INIT_OMX_PORT_STRUCT (portdef, ARATELIA_YUV_RENDERER_PORT_INDEX);
+
+  assert (ap_prc);
+
+  /* Retrieve port def from port */
+  tiz_check_omx (tiz_api_GetParameter (tiz_get_krn (handleOf (ap_prc)),
+                                       handleOf (ap_prc),
+                                       OMX_IndexParamPortDefinition, &portdef));
+
+  ap_prc->port_def_ = portdef.format.video;
+  return OMX_ErrorNone;
+}
+
+/*
+ * Overlay-backed buffers
+ */
+
+static bool
+overlay_matches_port_layout (const sdlivr_prc_t * ap_prc,
+                             const SDL_Overlay * ap_overlay,
+                             const OMX_U32 a_size)
 {
+  const int pitch0 = frame_pitch (&(ap_prc->port_def_));
+  const int pitch1 = pitch0 / 2;
+  const OMX_U32 height = ap_prc->port_def_.nFrameHeight;
+
+  /* The decoder writes the planes back to back, with the port's stride; the
+     overlay can only be handed out if its pixels are laid out the same way */
+  return (ap_overlay->planes == 3 && ap_overlay->pitches[0] == pitch0
+          && ap_overlay->pitches[1] == pitch1
+          && ap_overlay->pitches[2] == pitch1
+          && ap_overlay->pixels[1] == ap_overlay->pixels[0] + pitch0 * height
+          && ap_overlay->pixels[2]
+               == ap_overlay->pixels[1] + pitch1 * (height / 2)
+          && a_size <= pitch0 * height + 2 * pitch1 * (height / 2));
+}
+
+static SDL_Overlay *
+create_buffer_overlay (sdlivr_prc_t * ap_prc, const OMX_U32 a_size)
+{
+  SDL_Overlay * p_overlay = NULL;
+
   assert (ap_prc);
 
-  if (ap_prc->p_overlay)
+  if (ap_prc->noverlay_bufs_ >= ARATELIA_YUV_RENDERER_MAX_OVERLAY_BUFFERS
+      || !SDL_WasInit (SDL_INIT_VIDEO)
+      || OMX_ErrorNone != update_port_def (ap_prc) || !set_video_mode (ap_prc))
     {
-      const OMX_VIDEO_PORTDEFINITIONTYPE * p_vpd = &(ap_prc->port_def_);
+      return NULL;
+    }
 
-      /* AVPicture pict; */
-      SDL_Rect rect;
-      uint8_t * y;
-      uint8_t * u;
-      uint8_t * v;
-      unsigned int bytes;
-      int pitch0, pitch1;
+  /* IYUV has the same plane order as OMX_COLOR_FormatYUV420Planar */
+  p_overlay = SDL_CreateYUVOverlay (ap_prc->port_def_.nFrameWidth,
+                                    ap_prc->port_def_.nFrameHeight,
+                                    SDL_IYUV_OVERLAY, ap_prc->p_surface);
+  if (p_overlay
+      && (!overlay_matches_port_layout (ap_prc, p_overlay, a_size)
+          || 0 != SDL_LockYUVOverlay (p_overlay)))
+    {
+      SDL_FreeYUVOverlay (p_overlay);
+      p_overlay = NULL;
+    }
+  return p_overlay;
+}
 
-      if (p_vpd->nStride == 0)
-        {
-          /* align pitch on 16-pixel boundary. */
-          pitch0 = (p_vpd->nFrameWidth + 15) & ~15;
-        }
-      else
+static SDL_Overlay *
+find_buffer_overlay (const sdlivr_prc_t * ap_prc, const OMX_U8 * ap_buf)
+{
+  OMX_U32 i = 0;
+  assert (ap_prc);
+  for (i = 0; i < ap_prc->noverlay_bufs_; ++i)
+    {
+      if (ap_prc->overlay_bufs_[i].p_buf == ap_buf)
         {
-          pitch0 = p_vpd->nStride;
+          return ap_prc->overlay_bufs_[i].p_overlay;
         }
-      pitch1 = pitch0 / 2;
+    }
+  return NULL;
+}
 
-      /* hard-coded to be YUV420 plannar */
-      y = p_hdr->pBuffer;
-      u = y + pitch0 * p_vpd->nFrameHeight;
-      v = u + pitch1 * p_vpd->nFrameHeight / 2;
+static void
+quit_sdl (sdlivr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  /* This frees p_prc->p_surface */
+  SDL_Quit ();
+  ap_prc->p_surface = NULL;
+  ap_prc->quit_pending_ = false;
+}
 
-      SDL_LockYUVOverlay (ap_prc->p_overlay);
+OMX_U8 *
+sdlivr_prc_alloc_hook (OMX_U32 * ap_size, OMX_PTR * app_port_priv,
+                       void * ap_args)
+{
+  sdlivr_prc_t * p_prc = tiz_get_prc (ap_args);
+  SDL_Overlay * p_overlay = NULL;
 
-      if (ap_prc->p_overlay->pitches[0] != pitch0
-          || ap_prc->p_overlay->pitches[1] != pitch1
-          || ap_prc->p_overlay->pitches[2] != pitch1)
-        {
-          int hh;
-          uint8_t * y2;
-          uint8_t * u2;
-          uint8_t * v2;
+  assert (ap_size && *ap_size > 0);
 
-          y2 = ap_prc->p_overlay->pixels[0];
-          u2 = ap_prc->p_overlay->pixels[2];
-          v2 = ap_prc->p_overlay->pixels[1];
+  if (p_prc && (p_overlay = create_buffer_overlay (p_prc, *ap_size)))
+    {
+      sdlivr_overlay_buffer_t * p_ob
+        = &(p_prc->overlay_bufs_[p_prc->noverlay_bufs_++]);
+      p_ob->p_overlay = p_overlay;
+      p_ob->p_buf = p_overlay->pixels[0];
+      TIZ_TRACE (handleOf (p_prc), "overlay buffer [%p] size [%u]",
+                 p_ob->p_buf, *ap_size);
+      return p_ob->p_buf;
+    }
 
-          for (hh = 0; hh < p_vpd->nFrameHeight; hh++)
-            {
-              memcpy (y2, y, ap_prc->p_overlay->pitches[0]);
-              y2 += ap_prc->p_overlay->pitches[0];
-              y += pitch0;
-            }
-          for (hh = 0; hh < p_vpd->nFrameHeight / 2; hh++)
-            {
-              memcpy (u2, u, ap_prc->p_overlay->pitches[2]);
-              u2 += ap_prc->p_overlay->pitches[2];
-              u += pitch1;
-            }
-          for (hh = 0; hh < p_vpd->nFrameHeight / 2; hh++)
+  /* Frames in this buffer will be copied into the overlay */
+  return tiz_mem_calloc ((size_t) *ap_size, sizeof (OMX_U8));
+}
+
+void
+sdlivr_prc_free_hook (OMX_PTR ap_buf, OMX_PTR ap_port_priv, void * ap_args)
+{
+  sdlivr_prc_t * p_prc = tiz_get_prc (ap_args);
+  OMX_U32 i = 0;
+
+  assert (ap_buf);
+
+  for (i = 0; p_prc && i < p_prc->noverlay_bufs_; ++i)
+    {
+      if (p_prc->overlay_bufs_[i].p_buf == ap_buf)
+        {
+          SDL_UnlockYUVOverlay (p_prc->overlay_bufs_[i].p_overlay);
+          SDL_FreeYUVOverlay (p_prc->overlay_bufs_[i].p_overlay);
+          p_prc->overlay_bufs_[i]
+            = p_prc->overlay_bufs_[--p_prc->noverlay_bufs_];
+          if (0 == p_prc->noverlay_bufs_ && p_prc->quit_pending_)
             {
-              memcpy (v2, v, ap_prc->p_overlay->pitches[1]);
-              v2 += ap_prc->p_overlay->pitches[1];
-              v += pitch1;
+              quit_sdl (p_prc);
             }
+          return;
         }
-      else
-        {
-          bytes = pitch0 * p_vpd->nFrameHeight;
-          memcpy (ap_prc->p_overlay->pixels[0], y, bytes);
+    }
+
+  tiz_mem_free (ap_buf);
+}
+
+/*
+ * Rendering
+ */
+
+static void
+copy_to_overlay (const sdlivr_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * p_hdr)
+{
+  const OMX_VIDEO_PORTDEFINITIONTYPE * p_vpd = &(ap_prc->port_def_);
+  uint8_t * y;
+  uint8_t * u;
+  uint8_t * v;
+  unsigned int bytes;
+  int pitch0, pitch1;
+
+  pitch0 = frame_pitch (p_vpd);
+  pitch1 = pitch0 / 2;
+
+  /* hard-coded to be YUV420 plannar */
+  y = p_hdr->pBuffer;
+  u = y + pitch0 * p_vpd->nFrameHeight;
+  v = u + pitch1 * p_vpd->nFrameHeight / 2;
+
+  SDL_LockYUVOverlay (ap_prc->p_overlay);
+
+  if (ap_prc->p_overlay->pitches[0] != pitch0
+      || ap_prc->p_overlay->pitches[1] != pitch1
+      || ap_prc->p_overlay->pitches[2] != pitch1)
+    {
+      int hh;
+      uint8_t * y2;
+      uint8_t * u2;
+      uint8_t * v2;
 
-          bytes = pitch1 * p_vpd->nFrameHeight / 2;
-          memcpy (ap_prc->p_overlay->pixels[2], u, bytes);
+      y2 = ap_prc->p_overlay->pixels[0];
+      u2 = ap_prc->p_overlay->pixels[2];
+      v2 = ap_prc->p_overlay->pixels[1];
 
-          bytes = pitch1 * p_vpd->nFrameHeight / 2;
-          memcpy (ap_prc->p_overlay->pixels[1], v, bytes);
+      for (hh = 0; hh < p_vpd->nFrameHeight; hh++)
+        {
+          memcpy (y2, y, ap_prc->p_overlay->pitches[0]);
+          y2 += ap_prc->p_overlay->pitches[0];
+          y += pitch0;
+        }
+      for (hh = 0; hh < p_vpd->nFrameHeight / 2; hh++)
+        {
+          memcpy (u2, u, ap_prc->p_overlay->pitches[2]);
+          u2 += ap_prc->p_overlay->pitches[2];
+          u += pitch1;
         }
+      for (hh = 0; hh < p_vpd->nFrameHeight / 2; hh++)
+        {
+          memcpy (v2, v, ap_prc->p_overlay->pitches[1]);
+          v2 += ap_prc->p_overlay->pitches[1];
+          v += pitch1;
+        }
+    }
+  else
+    {
+      bytes = pitch0 * p_vpd->nFrameHeight;
+      memcpy (ap_prc->p_overlay->pixels[0], y, bytes);
+
+      bytes = pitch1 * p_vpd->nFrameHeight / 2;
+      memcpy (ap_prc->p_overlay->pixels[2], u, bytes);
 
-      SDL_UnlockYUVOverlay (ap_prc->p_overlay);
+      bytes = pitch1 * p_vpd->nFrameHeight / 2;
+      memcpy (ap_prc->p_overlay->pixels[1], v, bytes);
+    }
+
+  SDL_UnlockYUVOverlay (ap_prc->p_overlay);
+}
 
-      rect.x = 0;
-      rect.y = 0;
-      rect.w = p_vpd->nFrameWidth;
-      rect.h = p_vpd->nFrameHeight;
+static OMX_ERRORTYPE
+sdlivr_prc_render_buffer (const sdlivr_prc_t * ap_prc,
+                          OMX_BUFFERHEADERTYPE * p_hdr)
+{
+  SDL_Overlay * p_overlay = NULL;
+  SDL_Rect rect;
+
+  assert (ap_prc);
+
+  rect.x = 0;
+  rect.y = 0;
+  rect.w = ap_prc->port_def_.nFrameWidth;
+  rect.h = ap_prc->port_def_.nFrameHeight;
+
+  if ((p_overlay = find_buffer_overlay (ap_prc, p_hdr->pBuffer)))
+    {
+      /* The frame is already in the overlay */
+      SDL_UnlockYUVOverlay (p_overlay);
+      SDL_DisplayYUVOverlay (p_overlay, &rect);
+      SDL_LockYUVOverlay (p_overlay);
+    }
+  else if (ap_prc->p_overlay)
+    {
+      copy_to_overlay (ap_prc, p_hdr);
       SDL_DisplayYUVOverlay (ap_prc->p_overlay, &rect);
     }
 
-  p_hdr->nFilledLen = 0;
+  return OMX_ErrorNone;
+}
+
+/*
+ * Frame pacing
+ */
+
+static OMX_TICKS
+frame_duration_us (const sdlivr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  /* xFramerate is in Q16 format */
+  return ap_prc->port_def_.xFramerate > 0
+           ? (OMX_TICKS) (1000000.0 * 65536 / ap_prc->port_def_.xFramerate)
+           : 40000;
+}
+
+static double
+frame_due_ms (sdlivr_prc_t * ap_prc, const OMX_BUFFERHEADERTYPE * ap_hdr)
+{
+  OMX_TICKS ts = ap_hdr->nTimeStamp;
+
+  assert (ap_prc);
+
+  if (!ap_prc->clock_started_ || (ap_hdr->nFlags & OMX_BUFFERFLAG_STARTTIME))
+    {
+      /* Anchor the media clock to this frame */
+      ap_prc->clock_origin_ms_ = now_ms ();
+      ap_prc->clock_origin_ts_ = ts;
+      ap_prc->clock_started_ = true;
+    }
+  else if (ts <= ap_prc->last_ts_)
+    {
+      /* No usable timestamps in the stream; go by the port's frame rate */
+      ts = ap_prc->last_ts_ + frame_duration_us (ap_prc);
+    }
+  ap_prc->last_ts_ = ts;
+
+  return ap_prc->clock_origin_ms_ + (ts - ap_prc->clock_origin_ts_) / 1000.0;
+}
+
+static void
+update_stats (sdlivr_prc_t * ap_prc, const double a_now_ms,
+              const double a_lateness_ms, const bool a_rendered)
+{
+  sdlivr_stats_t * p_stats = &(ap_prc->stats_);
+
+  if (0 == p_stats->frames++)
+    {
+      p_stats->first_ms = a_now_ms;
+    }
+  p_stats->last_ms = a_now_ms;
+
+  if (!a_rendered)
+    {
+      p_stats->dropped++;
+      return;
+    }
+
+  p_stats->rendered++;
+  if (ap_prc->pacing_)
+    {
+      const double jitter = a_lateness_ms < 0 ? -a_lateness_ms : a_lateness_ms;
+      if (a_lateness_ms > ARATELIA_YUV_RENDERER_LATE_TOLERANCE_MS)
+        {
+          p_stats->late++;
+        }
+      p_stats->jitter_sum_ms += jitter;
+      if (jitter > p_stats->jitter_max_ms)
+        {
+          p_stats->jitter_max_ms = jitter;
+        }
+    }
+}
+
+static void
+log_stats (sdlivr_prc_t * ap_prc)
+{
+  sdlivr_stats_t * p_stats = &(ap_prc->stats_);
+  const double elapsed_ms = p_stats->last_ms - p_stats->first_ms;
+
+  if (p_stats->frames > 0)
+    {
+      TIZ_NOTICE (
+        handleOf (ap_prc),
+        "frames [%u] rendered [%u] late [%u] dropped [%u] "
+        "throughput [%.2f fps] jitter avg [%.2f ms] max [%.2f ms]",
+        p_stats->frames, p_stats->rendered, p_stats->late, p_stats->dropped,
+        elapsed_ms > 0 ? (p_stats->frames - 1) * 1000.0 / elapsed_ms : 0.0,
+        p_stats->rendered > 0 ? p_stats->jitter_sum_ms / p_stats->rendered
+                              : 0.0,
+        p_stats->jitter_max_ms);
+    }
+  tiz_mem_set (p_stats, 0, sizeof (sdlivr_stats_t));
+}
+
+static void
+cancel_wait (sdlivr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  if (ap_prc->waiting_)
+    {
+      (void) tiz_srv_timer_watcher_stop (ap_prc, ap_prc->p_timer_);
+      ap_prc->waiting_ = false;
+    }
+}
 
+static OMX_ERRORTYPE
+return_held_frame (sdlivr_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_hdr = ap_prc->p_hdr_;
+  cancel_wait (ap_prc);
+  ap_prc->clock_started_ = false;
+  if (p_hdr)
+    {
+      ap_prc->p_hdr_ = NULL;
+      return tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                     ARATELIA_YUV_RENDERER_PORT_INDEX, p_hdr);
+    }
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+present_frame (sdlivr_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_hdr = ap_prc->p_hdr_;
+
+  assert (ap_prc);
+  assert (p_hdr);
+
+  if (p_hdr->nFilledLen > 0)
+    {
+      const double now = now_ms ();
+      const double lateness = ap_prc->pacing_ ? now - ap_prc->due_ms_ : 0;
+      const bool render = lateness <= ap_prc->max_lateness_ms_;
+
+      if (lateness < -SDLIVR_PRC_MIN_WAIT_MS)
+        {
+          /* Hold on to the frame until it is due */
+          ap_prc->waiting_ = true;
+          return tiz_srv_timer_watcher_start (ap_prc, ap_prc->p_timer_,
+                                              -lateness / 1000.0, 0);
+        }
+
+      if (render)
+        {
+          tiz_check_omx (sdlivr_prc_render_buffer (ap_prc, p_hdr));
+        }
+      update_stats (ap_prc, now, lateness, render);
+    }
+
+  if (p_hdr->nFlags & OMX_BUFFERFLAG_EOS)
+    {
+      TIZ_TRACE (handleOf (ap_prc), "OMX_BUFFERFLAG_EOS in HEADER [%p]", p_hdr);
+      log_stats (ap_prc);
+      /* The next stream gets a clock of its own */
+      ap_prc->clock_started_ = false;
+      tiz_srv_issue_event ((OMX_PTR) ap_prc, OMX_EventBufferFlag, 0,
+                           p_hdr->nFlags, NULL);
+    }
+
+  p_hdr->nFilledLen = 0;
+  ap_prc->p_hdr_ = NULL;
+  return tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                 ARATELIA_YUV_RENDERER_PORT_INDEX, p_hdr);
+}
+
 /*
  * sdlivrprc
  */
@@ -154,10 +518,39 @@ static void *
 sdlivr_prc_ctor (void * ap_obj, va_list * app)
 {
   sdlivr_prc_t * p_prc = super_ctor (typeOf (ap_obj, "sdlivrprc"), ap_obj, app);
+  const char * p_lateness = NULL;
   assert (p_prc);
   tiz_mem_set (&(p_prc->port_def_), 0, sizeof (OMX_VIDEO_PORTDEFINITIONTYPE));
   p_prc->p_surface = NULL;
   p_prc->p_overlay = NULL;
+  p_prc->noverlay_bufs_ = 0;
+  p_prc->quit_pending_ = false;
+  p_prc->headless_ = config_bool (
+    tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                          ARATELIA_YUV_RENDERER_COMPONENT_NAME ".headless"),
+    false);
+  p_prc->pacing_ = config_bool (
+    tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                          ARATELIA_YUV_RENDERER_COMPONENT_NAME ".pacing"),
+    true);
+  p_prc->max_lateness_ms_ = ARATELIA_YUV_RENDERER_DEFAULT_MAX_LATENESS_MS;
+  if ((p_lateness = tiz_rcfile_get_value (
+         TIZ_RCFILE_PLUGINS_DATA_SECTION,
+         ARATELIA_YUV_RENDERER_COMPONENT_NAME ".max_lateness_ms")))
+    {
+      p_prc->max_lateness_ms_ = strtod (p_lateness, NULL);
+    }
+  p_prc->p_timer_ = NULL;
+  p_prc->p_hdr_ = NULL;
+  p_prc->due_ms_ = 0;
+  p_prc->waiting_ = false;
+  p_prc->paused_ = false;
+  p_prc->paused_ms_ = 0;
+  p_prc->clock_started_ = false;
+  p_prc->clock_origin_ms_ = 0;
+  p_prc->clock_origin_ts_ = 0;
+  p_prc->last_ts_ = 0;
+  tiz_mem_set (&(p_prc->stats_), 0, sizeof (sdlivr_stats_t));
   p_prc->port_disabled_ = false;
   return p_prc;
 }
@@ -176,13 +569,25 @@ sdlivr_prc_dtor (void * ap_obj)
 static OMX_ERRORTYPE
 sdlivr_prc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
 {
+  sdlivr_prc_t * p_prc = ap_obj;
   OMX_ERRORTYPE rc = OMX_ErrorNone;
+  assert (p_prc);
+  if (p_prc->headless_)
+    {
+      /* Render into memory only */
+      setenv ("SDL_VIDEODRIVER", "dummy", 1);
+    }
   if (-1 == SDL_Init (SDL_INIT_VIDEO))
     {
       rc = OMX_ErrorInsufficientResources;
       TIZ_ERROR (handleOf (ap_obj), "[%s] : while initializing SDL [%s]",
                  tiz_err_to_str (rc), SDL_GetError ());
     }
+  p_prc->quit_pending_ = false;
+  if (OMX_ErrorNone == rc && !p_prc->p_timer_)
+    {
+      rc = tiz_srv_timer_watcher_init (p_prc, &(p_prc->p_timer_));
+    }
   return rc;
 }
 
@@ -191,14 +596,27 @@ sdlivr_prc_deallocate_resources (void * ap_obj)
 {
   sdlivr_prc_t * p_prc = ap_obj;
   assert (p_prc);
+  if (p_prc->p_timer_)
+    {
+      cancel_wait (p_prc);
+      tiz_srv_timer_watcher_destroy (p_prc, p_prc->p_timer_);
+      p_prc->p_timer_ = NULL;
+    }
   if (p_prc->p_overlay)
     {
       SDL_FreeYUVOverlay (p_prc->p_overlay);
       p_prc->p_overlay = NULL;
     }
-  /* This frees p_prc->p_surface */
-  SDL_Quit ();
-  p_prc->p_surface = NULL;
+  if (p_prc->noverlay_bufs_ > 0)
+    {
+      /* Some buffers still live in overlays; the last of them to be freed
+         shuts SDL down */
+      p_prc->quit_pending_ = true;
+    }
+  else
+    {
+      quit_sdl (p_prc);
+    }
   return OMX_ErrorNone;
 }
 
@@ -206,39 +624,33 @@ static OMX_ERRORTYPE
 sdlivr_prc_prepare_to_transfer (void * ap_obj, OMX_U32 a_pid)
 {
   sdlivr_prc_t * p_prc = ap_obj;
-  OMX_PARAM_PORTDEFINITIONTYPE portdef;
-  TIZ_INIT_OMX_PORT_STRUCT (portdef, ARATELIA_YUV_RENDERER_PORT_INDEX);
 
   assert (p_prc);
 
-  /* Retrieve port def from port */
-  tiz_check_omx (tiz_api_GetParameter (tiz_get_krn (handleOf (p_prc)),
-                                       handleOf (p_prc),
-                                       OMX_IndexParamPortDefinition, &portdef));
-
-  p_prc->port_def_ = portdef.format.video;
+  tiz_check_omx (update_port_def (p_prc));
 
   TIZ_TRACE (
     handleOf (p_prc),
     "nFrameWidth = [%u] nFrameHeight = [%u] "
     "nStride = [%d] nSliceHeight = [%u] nBitrate = [%u] "
-    "xFramerate = [%u] eCompressionFormat = [%0x] eColorFormat = [%0x]",
+    "xFramerate = [%u] eCompressionFormat = [%0x] eColorFormat = [%0x] "
+    "overlay buffers = [%u]",
     p_prc->port_def_.nFrameWidth, p_prc->port_def_.nFrameHeight,
     p_prc->port_def_.nStride, p_prc->port_def_.nSliceHeight,
     p_prc->port_def_.nBitrate, p_prc->port_def_.xFramerate,
-    p_prc->port_def_.eCompressionFormat, p_prc->port_def_.eColorFormat);
+    p_prc->port_def_.eCompressionFormat, p_prc->port_def_.eColorFormat,
+    p_prc->noverlay_bufs_);
 
-  SDL_WM_SetCaption ("Tizonia YUV renderer", "YUV");
-
-  p_prc->p_surface = SDL_SetVideoMode (
-    p_prc->port_def_.nFrameWidth, p_prc->port_def_.nFrameHeight, 0,
-    SDL_HWSURFACE | SDL_ASYNCBLIT | SDL_HWACCEL | SDL_RESIZABLE);
+  (void) set_video_mode (p_prc);
 
   assert (!p_prc->p_overlay);
   p_prc->p_overlay = SDL_CreateYUVOverlay (p_prc->port_def_.nFrameWidth,
                                            p_prc->port_def_.nFrameHeight,
                                            SDL_YV12_OVERLAY, p_prc->p_surface);
 
+  p_prc->clock_started_ = false;
+  tiz_mem_set (&(p_prc->stats_), 0, sizeof (sdlivr_stats_t));
+
   return p_prc->p_overlay ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
 }
 
@@ -249,10 +661,7 @@ sdlivr_prc_transfer_and_process (void * ap_obj, OMX_U32 a_pid)
   assert (p_prc);
   if (!p_prc->p_overlay)
     {
-      p_prc->p_surface = SDL_SetVideoMode (
-        p_prc->port_def_.nFrameWidth, p_prc->port_def_.nFrameHeight, 0,
-        SDL_HWSURFACE | SDL_ASYNCBLIT | SDL_HWACCEL | SDL_RESIZABLE);
-
+      (void) set_video_mode (p_prc);
       p_prc->p_overlay = SDL_CreateYUVOverlay (
         p_prc->port_def_.nFrameWidth, p_prc->port_def_.nFrameHeight,
         SDL_YV12_OVERLAY, p_prc->p_surface);
@@ -265,11 +674,28 @@ sdlivr_prc_stop_and_return (void * ap_obj)
 {
   sdlivr_prc_t * p_prc = ap_obj;
   assert (p_prc);
+  tiz_check_omx (return_held_frame (p_prc));
+  log_stats (p_prc);
   SDL_FreeYUVOverlay (p_prc->p_overlay);
   p_prc->p_overlay = NULL;
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+sdlivr_prc_timer_ready (void * ap_prc, tiz_event_timer_t * ap_ev_timer,
+                        void * ap_arg, const uint32_t a_id)
+{
+  sdlivr_prc_t * p_prc = ap_prc;
+  assert (p_prc);
+  if (ap_ev_timer == p_prc->p_timer_ && p_prc->waiting_)
+    {
+      /* The frame held is now due */
+      cancel_wait (p_prc);
+      return sdlivr_prc_buffers_ready (p_prc);
+    }
+  return OMX_ErrorNone;
+}
+
 /*
  * from tiz_prc class
  */
@@ -278,38 +704,68 @@ static OMX_ERRORTYPE
 sdlivr_prc_buffers_ready (const void * ap_obj)
 {
   sdlivr_prc_t * p_prc = (sdlivr_prc_t *) ap_obj;
-  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
   void * p_krn = tiz_get_krn (handleOf (ap_obj));
 
   assert (p_prc);
 
-  if (!p_prc->port_disabled_)
+  while (!p_prc->port_disabled_ && !p_prc->paused_ && !p_prc->waiting_)
     {
-      tiz_check_omx (tiz_krn_claim_buffer (
-        p_krn, ARATELIA_YUV_RENDERER_PORT_INDEX, 0, &p_hdr));
-
-      while (!p_prc->port_disabled_ && p_hdr)
+      if (!p_prc->p_hdr_)
         {
-          if (p_hdr)
+          tiz_check_omx (tiz_krn_claim_buffer (
+            p_krn, ARATELIA_YUV_RENDERER_PORT_INDEX, 0, &(p_prc->p_hdr_)));
+          if (!p_prc->p_hdr_)
             {
-              tiz_check_omx (sdlivr_prc_render_buffer (ap_obj, p_hdr));
-              if (p_hdr->nFlags & OMX_BUFFERFLAG_EOS)
-                {
-                  TIZ_TRACE (handleOf (ap_obj),
-                             "OMX_BUFFERFLAG_EOS in HEADER [%p]", p_hdr);
-                  tiz_srv_issue_event ((OMX_PTR) ap_obj, OMX_EventBufferFlag, 0,
-                                       p_hdr->nFlags, NULL);
-                }
-              tiz_check_omx (tiz_krn_release_buffer (
-                p_krn, ARATELIA_YUV_RENDERER_PORT_INDEX, p_hdr));
-              tiz_check_omx (tiz_krn_claim_buffer (
-                p_krn, ARATELIA_YUV_RENDERER_PORT_INDEX, 0, &p_hdr));
+              break;
+            }
+          if (p_prc->pacing_ && p_prc->p_hdr_->nFilledLen > 0)
+            {
+              p_prc->due_ms_ = frame_due_ms (p_prc, p_prc->p_hdr_);
             }
         }
+      tiz_check_omx (present_frame (p_prc));
     }
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+sdlivr_prc_pause (const void * ap_obj)
+{
+  sdlivr_prc_t * p_prc = (sdlivr_prc_t *) ap_obj;
+  assert (p_prc);
+  cancel_wait (p_prc);
+  p_prc->paused_ = true;
+  p_prc->paused_ms_ = now_ms ();
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+sdlivr_prc_resume (const void * ap_obj)
+{
+  sdlivr_prc_t * p_prc = (sdlivr_prc_t *) ap_obj;
+  double paused_for_ms = 0;
+  assert (p_prc);
+  /* The media clock doesn't run while paused */
+  paused_for_ms = now_ms () - p_prc->paused_ms_;
+  p_prc->clock_origin_ms_ += paused_for_ms;
+  p_prc->due_ms_ += paused_for_ms;
+  p_prc->paused_ = false;
+  return sdlivr_prc_buffers_ready (p_prc);
+}
+
+static OMX_ERRORTYPE
+sdlivr_prc_port_flush (const void * ap_obj, OMX_U32 a_pid)
+{
+  sdlivr_prc_t * p_prc = (sdlivr_prc_t *) ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  assert (p_prc);
+  if (OMX_ALL == a_pid || ARATELIA_YUV_RENDERER_PORT_INDEX == a_pid)
+    {
+      rc = return_held_frame (p_prc);
+    }
+  return rc;
+}
+
 static OMX_ERRORTYPE
 sdlivr_prc_port_disable (const void * ap_obj, OMX_U32 a_pid)
 {
@@ -319,6 +775,7 @@ sdlivr_prc_port_disable (const void * ap_obj, OMX_U32 a_pid)
   if (OMX_ALL == a_pid || ARATELIA_YUV_RENDERER_PORT_INDEX == a_pid)
     {
       p_prc->port_disabled_ = true;
+      tiz_check_omx (return_held_frame (p_prc));
       rc = sdlivr_prc_deallocate_resources (p_prc);
     }
   return rc;
@@ -402,6 +859,14 @@ sdlivr_prc_init (void * ap_tos, void * ap_hdl)
      /* TIZ_CLASS_COMMENT: */
      tiz_srv_stop_and_return, sdlivr_prc_stop_and_return,
      /* TIZ_CLASS_COMMENT: */
+     tiz_srv_timer_ready, sdlivr_prc_timer_ready,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_pause, sdlivr_prc_pause,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_resume, sdlivr_prc_resume,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_flush, sdlivr_prc_port_flush,
+     /* TIZ_CLASS_COMMENT: */
      tiz_prc_port_disable, sdlivr_prc_port_disable,
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_port_enable, sdlivr_prc_port_enable,
@@ -33,11 +33,20 @@
 extern "C" {
 #endif
 
+#include <OMX_Types.h>
+
 void *
 sdlivr_prc_class_init (void * ap_tos, void * ap_hdl);
 void *
 sdlivr_prc_init (void * ap_tos, void * ap_hdl);
 
+/* Port buffer allocation hooks; ap_args is the component handle */
+OMX_U8 *
+sdlivr_prc_alloc_hook (OMX_U32 * ap_size, OMX_PTR * app_port_priv,
+                       void * ap_args);
+void
+sdlivr_prc_free_hook (OMX_PTR ap_buf, OMX_PTR ap_port_priv, void * ap_args);
+
 #ifdef __cplusplus
 }
 #endif
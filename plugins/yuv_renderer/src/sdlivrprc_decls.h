@@ -38,6 +38,28 @@ extern "C" {
 
 #include <tizprc_decls.h>
 
+#include "sdlivr.h"
+
+typedef struct sdlivr_overlay_buffer sdlivr_overlay_buffer_t;
+struct sdlivr_overlay_buffer
+{
+  SDL_Overlay * p_overlay;
+  OMX_U8 * p_buf;
+};
+
+typedef struct sdlivr_stats sdlivr_stats_t;
+struct sdlivr_stats
+{
+  OMX_U32 frames;
+  OMX_U32 rendered;
+  OMX_U32 late;
+  OMX_U32 dropped;
+  double jitter_sum_ms;
+  double jitter_max_ms;
+  double first_ms;
+  double last_ms;
+};
+
 typedef struct sdlivr_prc sdlivr_prc_t;
 struct sdlivr_prc
 {
@@ -46,6 +68,26 @@ struct sdlivr_prc
   OMX_VIDEO_PORTDEFINITIONTYPE port_def_;
   SDL_Surface * p_surface;
   SDL_Overlay * p_overlay;
+  /* Overlays whose pixels back the port's buffers */
+  sdlivr_overlay_buffer_t
+    overlay_bufs_[ARATELIA_YUV_RENDERER_MAX_OVERLAY_BUFFERS];
+  OMX_U32 noverlay_bufs_;
+  bool quit_pending_;
+  bool headless_;
+  bool pacing_;
+  double max_lateness_ms_;
+  tiz_event_timer_t * p_timer_;
+  OMX_BUFFERHEADERTYPE * p_hdr_;
+  double due_ms_;
+  bool waiting_;
+  bool paused_;
+  double paused_ms_;
+  /* Media clock */
+  bool clock_started_;
+  double clock_origin_ms_;
+  OMX_TICKS clock_origin_ts_;
+  OMX_TICKS last_ts_;
+  sdlivr_stats_t stats_;
   bool port_disabled_;
 };
 
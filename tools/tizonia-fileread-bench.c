@@ -0,0 +1,287 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizonia-fileread-bench.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Page cache benchmark for the binary file reader's read paths
+ *
+ * Reads a file the way OMX.Aratelia.file_reader.binary does (see
+ * plugins/file_reader/src/frprc.c): with fread, or by copying out of a
+ * mapping, one port buffer at a time, with the same read-ahead window
+ * re-armed when half of it has been consumed. Each path is timed with the
+ * file in the page cache (hot) and after evicting it with
+ * POSIX_FADV_DONTNEED (cold).
+ *
+ * Build and run:
+ *
+ *   gcc -O2 -o tizonia-fileread-bench tizonia-fileread-bench.c
+ *   head -c 256M /dev/urandom > /tmp/data
+ *   ./tizonia-fileread-bench /tmp/data
+ *
+ * NOTE: Eviction only works for pages that are not dirty or mapped by
+ * another process, so cold-cache figures vary between runs and machines.
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* The port's minimum buffer size and the default readahead_kb */
+#define FILEREAD_BENCH_DEFAULT_BUF_SIZE (4 * 1024)
+#define FILEREAD_BENCH_DEFAULT_READAHEAD_KB 1024
+#define FILEREAD_BENCH_DEFAULT_RUNS 3
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+typedef struct fileread_bench fileread_bench_t;
+struct fileread_bench
+{
+  FILE * p_file;
+  uint8_t * p_map;
+  uint64_t file_size;
+  uint64_t offset;
+  uint64_t readahead;
+  uint64_t readahead_end;
+};
+
+static double
+now_ms (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void
+evict_file (const char * ap_path)
+{
+  int fd = open (ap_path, O_RDONLY);
+  if (fd >= 0)
+    {
+      (void) fdatasync (fd);
+      (void) posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
+      close (fd);
+    }
+}
+
+/* Same policy as frprc.c's advise_readahead */
+static void
+advise_readahead (fileread_bench_t * ap_bench)
+{
+  uint64_t start = 0;
+  uint64_t end = 0;
+
+  if (0 == ap_bench->readahead
+      || ap_bench->offset + ap_bench->readahead / 2 < ap_bench->readahead_end)
+    {
+      return;
+    }
+
+  start = MAX (ap_bench->offset, ap_bench->readahead_end);
+  end = ap_bench->offset + ap_bench->readahead;
+  if (ap_bench->p_map)
+    {
+      const uint64_t page_mask = (uint64_t) sysconf (_SC_PAGESIZE) - 1;
+      end = MIN (end, ap_bench->file_size);
+      start &= ~page_mask;
+      if (end > start)
+        {
+          (void) madvise (ap_bench->p_map + start, end - start,
+                          MADV_WILLNEED);
+        }
+    }
+  else
+    {
+      (void) posix_fadvise (fileno (ap_bench->p_file), start, end - start,
+                            POSIX_FADV_WILLNEED);
+    }
+  ap_bench->readahead_end = end;
+}
+
+/* Returns the time taken to read the whole file, in ms, or a negative value
+   on error */
+static double
+read_file (const char * ap_path, const bool a_mmap, const size_t a_buf_size,
+           const uint64_t a_readahead)
+{
+  fileread_bench_t bench;
+  struct stat st;
+  uint8_t * p_buf = malloc (a_buf_size);
+  double start = now_ms ();
+  double elapsed = -1;
+  size_t nbytes = 0;
+
+  memset (&bench, 0, sizeof (bench));
+  bench.readahead = a_readahead;
+
+  if (!p_buf || !(bench.p_file = fopen (ap_path, "r"))
+      || 0 != fstat (fileno (bench.p_file), &st))
+    {
+      goto end;
+    }
+  bench.file_size = st.st_size;
+
+  if (a_mmap)
+    {
+      void * p_map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+                           fileno (bench.p_file), 0);
+      if (MAP_FAILED == p_map)
+        {
+          goto end;
+        }
+      (void) madvise (p_map, st.st_size, MADV_SEQUENTIAL);
+      bench.p_map = p_map;
+    }
+  else
+    {
+      (void) posix_fadvise (fileno (bench.p_file), 0, 0,
+                            POSIX_FADV_SEQUENTIAL);
+    }
+
+  do
+    {
+      advise_readahead (&bench);
+      if (bench.p_map)
+        {
+          nbytes = MIN (a_buf_size, bench.file_size - bench.offset);
+          memcpy (p_buf, bench.p_map + bench.offset, nbytes);
+        }
+      else
+        {
+          nbytes = fread (p_buf, 1, a_buf_size, bench.p_file);
+        }
+      bench.offset += nbytes;
+    }
+  while (nbytes > 0);
+
+  if (bench.offset == bench.file_size)
+    {
+      elapsed = now_ms () - start;
+    }
+
+end:
+
+  if (bench.p_map)
+    {
+      munmap (bench.p_map, bench.file_size);
+    }
+  if (bench.p_file)
+    {
+      fclose (bench.p_file);
+    }
+  free (p_buf);
+  return elapsed;
+}
+
+static void
+usage (const char * ap_prog)
+{
+  fprintf (stderr,
+           "%s [-b buffer_bytes] [-r readahead_kb] [-n runs] file\n"
+           "  -b : size of each read (default: %d)\n"
+           "  -r : read-ahead window in KiB, 0 to disable (default: %d)\n"
+           "  -n : runs of each case (default: %d)\n",
+           ap_prog, FILEREAD_BENCH_DEFAULT_BUF_SIZE,
+           FILEREAD_BENCH_DEFAULT_READAHEAD_KB, FILEREAD_BENCH_DEFAULT_RUNS);
+  exit (EXIT_FAILURE);
+}
+
+int
+main (int argc, char ** argv)
+{
+  size_t buf_size = FILEREAD_BENCH_DEFAULT_BUF_SIZE;
+  long readahead_kb = FILEREAD_BENCH_DEFAULT_READAHEAD_KB;
+  int runs = FILEREAD_BENCH_DEFAULT_RUNS;
+  const char * p_path = NULL;
+  int cold = 0;
+  int mode = 0;
+  int opt = 0;
+
+  while (-1 != (opt = getopt (argc, argv, "b:r:n:h")))
+    {
+      switch (opt)
+        {
+          case 'b':
+            buf_size = strtoul (optarg, NULL, 10);
+            break;
+          case 'r':
+            readahead_kb = strtol (optarg, NULL, 10);
+            break;
+          case 'n':
+            runs = atoi (optarg);
+            break;
+          default:
+            usage (argv[0]);
+        }
+    }
+  if (optind >= argc || 0 == buf_size || runs <= 0)
+    {
+      usage (argv[0]);
+    }
+  p_path = argv[optind];
+
+  printf ("%s: %zu-byte reads, %ld KiB read-ahead\n", p_path, buf_size,
+          readahead_kb);
+  for (cold = 0; cold < 2; ++cold)
+    {
+      for (mode = 0; mode < 2; ++mode)
+        {
+          int i = 0;
+          printf ("%s cache, %-5s:", cold ? "cold" : "hot ",
+                  mode ? "mmap" : "stdio");
+          for (i = 0; i < runs; ++i)
+            {
+              double ms = 0;
+              if (cold)
+                {
+                  evict_file (p_path);
+                }
+              else if (0 == i)
+                {
+                  /* Warm the cache up */
+                  (void) read_file (p_path, false, buf_size, 0);
+                }
+              ms = read_file (p_path, mode, buf_size,
+                              readahead_kb > 0 ? (uint64_t) readahead_kb * 1024
+                                               : 0);
+              if (ms < 0)
+                {
+                  fprintf (stderr, "\nUnable to read %s\n", p_path);
+                  return EXIT_FAILURE;
+                }
+              printf (" %.1f ms", ms);
+            }
+          printf ("\n");
+        }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,333 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizonia-medialib-bench.cpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Playlist assembly benchmark for the player's media library index
+ *
+ * Generates a synthetic tree of empty .mp3 files (100k by default, 50 per
+ * directory) and times tiz::playlist::assemble_play_list on it:
+ *
+ *   - without the index (media-library = false);
+ *   - with no index file yet (cold), which reads every directory and saves
+ *     the index;
+ *   - with the index just saved (warm);
+ *   - after adding one file, which reads one directory again and rewrites
+ *     the index.
+ *
+ * Each run is made in a child process of its own, as the player would, so
+ * that the index is mapped afresh every time.
+ *
+ * Build and run, from the top of the source tree:
+ *
+ *   g++ -O2 -o tizonia-medialib-bench tools/tizonia-medialib-bench.cpp \
+ *       player/src/tizplaylist.cpp player/src/tizplaylistfeed.cpp \
+ *       player/src/tizmedialib.cpp player/src/tizprobe.cpp -Iplayer/src \
+ *       $(pkg-config --cflags --libs tizilheaders libtizplatform taglib \
+ *         libmediainfo) \
+ *       -lboost_filesystem -lboost_system -lboost_thread
+ *   ./tizonia-medialib-bench
+ *
+ * NOTE: The page cache is left as it is, so the figures are for a warm file
+ * system; the tree is removed on exit unless -k is given.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "tizplaylist.hpp"
+
+#define MEDIALIB_BENCH_DEFAULT_FILES 100000
+#define MEDIALIB_BENCH_DEFAULT_FILES_PER_DIR 50
+#define MEDIALIB_BENCH_DEFAULT_RUNS 3
+/* Leaf directories are grouped under this many top-level directories */
+#define MEDIALIB_BENCH_DIRS_PER_TOP_DIR 50
+
+namespace  // unnamed namespace
+{
+  double now_ms ()
+  {
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+  }
+
+  bool make_file (const std::string &path)
+  {
+    const int fd = open (path.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+      return false;
+    }
+    close (fd);
+    return true;
+  }
+
+  std::string leaf_dir (const std::string &root, const long index)
+  {
+    char name[64];
+    snprintf (name, sizeof (name), "/artist%04ld/album%04ld",
+              index / MEDIALIB_BENCH_DIRS_PER_TOP_DIR, index);
+    return root + name;
+  }
+
+  bool make_tree (const std::string &root, const long nfiles,
+                  const long files_per_dir, long &ndirs)
+  {
+    std::string dir;
+    ndirs = 0;
+    for (long i = 0; i < nfiles; ++i)
+    {
+      char name[32];
+      if (0 == i % files_per_dir)
+      {
+        dir = leaf_dir (root, i / files_per_dir);
+        boost::filesystem::create_directories (dir);
+        ++ndirs;
+      }
+      snprintf (name, sizeof (name), "/track%03ld.mp3", i % files_per_dir);
+      if (!make_file (dir + name))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool write_rc_file (const std::string &path, const bool enabled,
+                      const std::string &index)
+  {
+    FILE *p_file = fopen (path.c_str (), "w");
+    if (!p_file)
+    {
+      return false;
+    }
+    // No indexer threads: nothing is probed here
+    fprintf (p_file,
+             "[tizonia]\n"
+             "media-library = %s\n"
+             "media-library.file = %s\n"
+             "media-library.indexer-threads = 0\n",
+             enabled ? "true" : "false", index.c_str ());
+    return 0 == fclose (p_file);
+  }
+
+  /* Assembles the playlist in a child process; returns the time taken in
+     ms, or a negative value on error */
+  double assemble (const std::string &root, const std::string &rc_file,
+                   const long expected)
+  {
+    int fds[2];
+    double ms = -1;
+    pid_t pid = 0;
+    int status = 0;
+
+    if (0 != pipe (fds) || (pid = fork ()) < 0)
+    {
+      return -1;
+    }
+
+    if (0 == pid)
+    {
+      file_extension_lst_t extensions;
+      uri_lst_t uris;
+      std::string error_msg;
+      double start = 0;
+
+      close (fds[0]);
+      setenv ("TIZONIA_RC_FILE", rc_file.c_str (), 1);
+      extensions.insert (".mp3");
+      start = now_ms ();
+      if (tiz::playlist::assemble_play_list (root, false, true, extensions,
+                                             uris, error_msg)
+          && static_cast< long > (uris.size ()) == expected)
+      {
+        ms = now_ms () - start;
+      }
+      else
+      {
+        fprintf (stderr, "\n%ld tracks found, %ld expected %s\n",
+                 static_cast< long > (uris.size ()), expected,
+                 error_msg.c_str ());
+      }
+      _exit (sizeof (ms) == write (fds[1], &ms, sizeof (ms)) ? EXIT_SUCCESS
+                                                              : EXIT_FAILURE);
+    }
+
+    close (fds[1]);
+    if (sizeof (ms) != read (fds[0], &ms, sizeof (ms)))
+    {
+      ms = -1;
+    }
+    close (fds[0]);
+    while (waitpid (pid, &status, 0) < 0 && EINTR == errno)
+    {
+    }
+    return ms;
+  }
+
+  void usage (const char *p_prog)
+  {
+    fprintf (stderr,
+             "%s [-n files] [-d files_per_dir] [-r runs] [-k] [dir]\n"
+             "  -n : number of files in the tree (default: %d)\n"
+             "  -d : files in each directory (default: %d)\n"
+             "  -r : runs of each case (default: %d)\n"
+             "  -k : keep the tree and the index\n"
+             "  dir: where to create the tree (default: a new directory in "
+             "/tmp)\n",
+             p_prog, MEDIALIB_BENCH_DEFAULT_FILES,
+             MEDIALIB_BENCH_DEFAULT_FILES_PER_DIR,
+             MEDIALIB_BENCH_DEFAULT_RUNS);
+    exit (EXIT_FAILURE);
+  }
+}  // unnamed namespace
+
+int main (int argc, char **argv)
+{
+  long nfiles = MEDIALIB_BENCH_DEFAULT_FILES;
+  long files_per_dir = MEDIALIB_BENCH_DEFAULT_FILES_PER_DIR;
+  int runs = MEDIALIB_BENCH_DEFAULT_RUNS;
+  bool keep = false;
+  char tmp_dir[] = "/tmp/tizonia-medialib-bench.XXXXXX";
+  std::string base;
+  long ndirs = 0;
+  int opt = 0;
+
+  while (-1 != (opt = getopt (argc, argv, "n:d:r:kh")))
+  {
+    switch (opt)
+    {
+      case 'n':
+        nfiles = strtol (optarg, NULL, 10);
+        break;
+      case 'd':
+        files_per_dir = strtol (optarg, NULL, 10);
+        break;
+      case 'r':
+        runs = atoi (optarg);
+        break;
+      case 'k':
+        keep = true;
+        break;
+      default:
+        usage (argv[0]);
+    }
+  }
+  if (nfiles <= 0 || files_per_dir <= 0 || runs <= 0)
+  {
+    usage (argv[0]);
+  }
+  if (optind < argc)
+  {
+    base = argv[optind];
+  }
+  else if (mkdtemp (tmp_dir))
+  {
+    base = tmp_dir;
+  }
+  else
+  {
+    fprintf (stderr, "Unable to create %s\n", tmp_dir);
+    return EXIT_FAILURE;
+  }
+
+  const std::string root (base + "/tree");
+  const std::string index (base + "/media-library.idx");
+  const std::string rc_off (base + "/tizonia-off.conf");
+  const std::string rc_on (base + "/tizonia-on.conf");
+  const char *p_cases[] = {"no index", "cold index", "warm index",
+                           "one new file"};
+  long expected = nfiles;
+  int rc = EXIT_SUCCESS;
+
+  printf ("Creating %ld files in %s...", nfiles, root.c_str ());
+  fflush (stdout);
+  if (!make_tree (root, nfiles, files_per_dir, ndirs)
+      || !write_rc_file (rc_off, false, index)
+      || !write_rc_file (rc_on, true, index))
+  {
+    fprintf (stderr, "\nUnable to create the tree in %s\n", base.c_str ());
+    return EXIT_FAILURE;
+  }
+  printf (" %ld directories\n", ndirs);
+
+  for (size_t c = 0; c < sizeof (p_cases) / sizeof (p_cases[0]); ++c)
+  {
+    printf ("%-12s:", p_cases[c]);
+    for (int i = 0; i < runs; ++i)
+    {
+      double ms = 0;
+      if (1 == c)
+      {
+        (void)unlink (index.c_str ());
+      }
+      else if (3 == c)
+      {
+        char name[32];
+        snprintf (name, sizeof (name), "/new%04d.mp3", i);
+        if (!make_file (leaf_dir (root, i % ndirs) + name))
+        {
+          rc = EXIT_FAILURE;
+          break;
+        }
+        ++expected;
+      }
+      if ((ms = assemble (root, 0 == c ? rc_off : rc_on, expected)) < 0)
+      {
+        rc = EXIT_FAILURE;
+        break;
+      }
+      printf (" %.1f ms", ms);
+      fflush (stdout);
+    }
+    printf ("\n");
+    if (EXIT_SUCCESS != rc)
+    {
+      break;
+    }
+  }
+
+  if (!keep)
+  {
+    boost::filesystem::remove_all (root);
+    (void)unlink (index.c_str ());
+    (void)unlink (rc_off.c_str ());
+    (void)unlink (rc_on.c_str ());
+    if (optind >= argc)
+    {
+      (void)rmdir (base.c_str ());
+    }
+  }
+
+  return rc;
+}
@@ -0,0 +1,393 @@
+/**
+ * Copyright (C) 2011-2020 Aratelia Limited - Juan A. Rubio and contributors
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizonia-vp8dec-bench.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Frames/sec benchmark for the VP8/VP9 decoder's libvpx set-up
+ *
+ * Decodes a file the way OMX.Aratelia.video_decoder.vp8 does (see
+ * plugins/vp8_decoder/src/vp8dprc.c): with the same decoder configuration
+ * (threads, frame-parallel mode, VP9 row-based multi-threading) and copying
+ * each frame into a packed YUV420 planar buffer, as the component does with
+ * its output buffers. The decoding rate is reported with and without the
+ * copy.
+ *
+ * The component only parses IVF and raw streams, so WebM fixtures are
+ * remuxed to IVF first. Build and run:
+ *
+ *   gcc -O2 -o tizonia-vp8dec-bench tizonia-vp8dec-bench.c \
+ *       $(pkg-config --cflags --libs vpx)
+ *   ffmpeg -i fixture.webm -an -c:v copy fixture.ivf
+ *   ./tizonia-vp8dec-bench -t 4 fixture.ivf
+ */
+
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vpx/vp8dx.h>
+#include <vpx/vpx_decoder.h>
+
+/* Same limits as the component's */
+#define VP8DEC_BENCH_MAX_THREADS 8
+#define VP8DEC_BENCH_DEFAULT_RUNS 3
+
+#define VP8DEC_BENCH_IVF_FILE_HDR_SZ 32
+#define VP8DEC_BENCH_IVF_FRAME_HDR_SZ 12
+
+typedef struct vp8dec_bench_frame vp8dec_bench_frame_t;
+struct vp8dec_bench_frame
+{
+  const uint8_t * p_data;
+  unsigned int size;
+};
+
+typedef struct vp8dec_bench_stream vp8dec_bench_stream_t;
+struct vp8dec_bench_stream
+{
+  uint8_t * p_file;
+  vpx_codec_iface_t * p_iface;
+  unsigned int width;
+  unsigned int height;
+  vp8dec_bench_frame_t * p_frames;
+  unsigned int nframes;
+};
+
+static double
+now_ms (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static unsigned int
+mem_get_le16 (const uint8_t * ap_mem)
+{
+  return (ap_mem[1] << 8) | ap_mem[0];
+}
+
+static unsigned int
+mem_get_le32 (const uint8_t * ap_mem)
+{
+  return ((unsigned int) ap_mem[3] << 24) | (ap_mem[2] << 16)
+         | (ap_mem[1] << 8) | ap_mem[0];
+}
+
+/* Reads the whole file, and indexes its frames */
+static bool
+load_ivf (const char * ap_path, vp8dec_bench_stream_t * ap_stream)
+{
+  FILE * p_file = fopen (ap_path, "rb");
+  long size = 0;
+  long offset = VP8DEC_BENCH_IVF_FILE_HDR_SZ;
+  bool loaded = false;
+
+  memset (ap_stream, 0, sizeof (*ap_stream));
+
+  if (!p_file || 0 != fseek (p_file, 0, SEEK_END) || (size = ftell (p_file)) < 0
+      || 0 != fseek (p_file, 0, SEEK_SET)
+      || size < VP8DEC_BENCH_IVF_FILE_HDR_SZ
+      || !(ap_stream->p_file = malloc (size))
+      || 1 != fread (ap_stream->p_file, size, 1, p_file)
+      || 0 != memcmp (ap_stream->p_file, "DKIF", 4))
+    {
+      goto end;
+    }
+
+  if (0 == memcmp (ap_stream->p_file + 8, "VP80", 4))
+    {
+      ap_stream->p_iface = vpx_codec_vp8_dx ();
+    }
+  else if (0 == memcmp (ap_stream->p_file + 8, "VP90", 4))
+    {
+      ap_stream->p_iface = vpx_codec_vp9_dx ();
+    }
+  else
+    {
+      goto end;
+    }
+  ap_stream->width = mem_get_le16 (ap_stream->p_file + 12);
+  ap_stream->height = mem_get_le16 (ap_stream->p_file + 14);
+
+  /* At most one frame per frame header */
+  ap_stream->p_frames
+    = calloc (size / VP8DEC_BENCH_IVF_FRAME_HDR_SZ + 1,
+              sizeof (vp8dec_bench_frame_t));
+  if (!ap_stream->p_frames)
+    {
+      goto end;
+    }
+  while (offset + VP8DEC_BENCH_IVF_FRAME_HDR_SZ <= size)
+    {
+      const unsigned int frame_size
+        = mem_get_le32 (ap_stream->p_file + offset);
+      offset += VP8DEC_BENCH_IVF_FRAME_HDR_SZ;
+      if (frame_size > size - offset)
+        {
+          break;
+        }
+      ap_stream->p_frames[ap_stream->nframes].p_data
+        = ap_stream->p_file + offset;
+      ap_stream->p_frames[ap_stream->nframes].size = frame_size;
+      ap_stream->nframes++;
+      offset += frame_size;
+    }
+  loaded = ap_stream->nframes > 0;
+
+end:
+
+  if (p_file)
+    {
+      fclose (p_file);
+    }
+  return loaded;
+}
+
+/* Same as the component's copy_plane */
+static uint8_t *
+copy_plane (uint8_t * ap_dst, const uint8_t * ap_src, const int a_stride,
+            const unsigned int a_width, const unsigned int a_height)
+{
+  unsigned int y = 0;
+
+  if (a_stride == (int) a_width)
+    {
+      memcpy (ap_dst, ap_src, a_width * a_height);
+      return ap_dst + a_width * a_height;
+    }
+
+  for (y = 0; y < a_height; y++)
+    {
+      memcpy (ap_dst, ap_src, a_width);
+      ap_dst += a_width;
+      ap_src += a_stride;
+    }
+  return ap_dst;
+}
+
+static bool
+copy_frame (const vpx_image_t * ap_img, uint8_t * ap_buf, const size_t a_len)
+{
+  const unsigned int uv_width = (1 + ap_img->d_w) / 2;
+  const unsigned int uv_height = (1 + ap_img->d_h) / 2;
+  uint8_t * p_dst = ap_buf;
+
+  if (VPX_IMG_FMT_I420 != ap_img->fmt
+      || ap_img->d_w * ap_img->d_h + 2 * uv_width * uv_height > a_len)
+    {
+      return false;
+    }
+
+  p_dst = copy_plane (p_dst, ap_img->planes[VPX_PLANE_Y],
+                      ap_img->stride[VPX_PLANE_Y], ap_img->d_w, ap_img->d_h);
+  p_dst = copy_plane (p_dst, ap_img->planes[VPX_PLANE_U],
+                      ap_img->stride[VPX_PLANE_U], uv_width, uv_height);
+  (void) copy_plane (p_dst, ap_img->planes[VPX_PLANE_V],
+                     ap_img->stride[VPX_PLANE_V], uv_width, uv_height);
+  return true;
+}
+
+/* Decodes the whole stream once; returns the number of frames output, or -1
+   on error */
+static int
+decode_stream (const vp8dec_bench_stream_t * ap_stream,
+               const unsigned int a_threads, const bool a_frame_parallel,
+               uint8_t * ap_buf, const size_t a_len, double * ap_total_ms,
+               double * ap_copy_ms)
+{
+  vpx_codec_ctx_t ctx;
+  vpx_codec_dec_cfg_t cfg;
+  vpx_codec_iter_t iter = NULL;
+  vpx_image_t * p_img = NULL;
+  const double start = now_ms ();
+  int flags = 0;
+  int frames = 0;
+  unsigned int i = 0;
+
+  memset (&cfg, 0, sizeof (cfg));
+  cfg.threads = a_threads;
+#ifdef VPX_CODEC_USE_FRAME_THREADING
+  if (a_frame_parallel
+      && (vpx_codec_get_caps (ap_stream->p_iface)
+          & VPX_CODEC_CAP_FRAME_THREADING))
+    {
+      flags |= VPX_CODEC_USE_FRAME_THREADING;
+    }
+#endif
+
+  if (VPX_CODEC_OK
+      != vpx_codec_dec_init (&ctx, ap_stream->p_iface, &cfg, flags))
+    {
+      fprintf (stderr, "Unable to initialise the decoder\n");
+      return -1;
+    }
+#ifdef VPX_CTRL_VP9D_SET_ROW_MT
+  if (vpx_codec_vp9_dx () == ap_stream->p_iface && a_threads > 1)
+    {
+      (void) vpx_codec_control (&ctx, VP9D_SET_ROW_MT, 1);
+    }
+#endif
+
+  *ap_copy_ms = 0;
+  /* The extra, empty, round flushes the frames still in flight */
+  for (i = 0; i <= ap_stream->nframes; ++i)
+    {
+      const bool flush = (i == ap_stream->nframes);
+      const uint8_t * p_data = flush ? NULL : ap_stream->p_frames[i].p_data;
+      const unsigned int size = flush ? 0 : ap_stream->p_frames[i].size;
+      if (VPX_CODEC_OK != vpx_codec_decode (&ctx, p_data, size, NULL, 0))
+        {
+          fprintf (stderr, "Unable to decode frame %u: %s\n", i,
+                   vpx_codec_error (&ctx));
+          frames = -1;
+          break;
+        }
+      iter = NULL;
+      while ((p_img = vpx_codec_get_frame (&ctx, &iter)))
+        {
+          const double copy_start = now_ms ();
+          if (!copy_frame (p_img, ap_buf, a_len))
+            {
+              fprintf (stderr, "Unsupported frame format or size\n");
+              frames = -1;
+              break;
+            }
+          *ap_copy_ms += now_ms () - copy_start;
+          ++frames;
+        }
+      if (frames < 0)
+        {
+          break;
+        }
+    }
+
+  (void) vpx_codec_destroy (&ctx);
+  *ap_total_ms = now_ms () - start;
+  return frames;
+}
+
+static void
+usage (const char * ap_prog)
+{
+  fprintf (stderr,
+           "%s [-t threads] [-f] [-n runs] file.ivf\n"
+           "  -t : decoder threads, 0 for one per online cpu, capped at %d "
+           "(default: 0)\n"
+           "  -f : request frame-parallel decoding\n"
+           "  -n : runs (default: %d)\n",
+           ap_prog, VP8DEC_BENCH_MAX_THREADS, VP8DEC_BENCH_DEFAULT_RUNS);
+  exit (EXIT_FAILURE);
+}
+
+int
+main (int argc, char ** argv)
+{
+  vp8dec_bench_stream_t stream;
+  long threads = 0;
+  bool frame_parallel = false;
+  int runs = VP8DEC_BENCH_DEFAULT_RUNS;
+  uint8_t * p_buf = NULL;
+  size_t len = 0;
+  int opt = 0;
+  int i = 0;
+
+  while (-1 != (opt = getopt (argc, argv, "t:fn:h")))
+    {
+      switch (opt)
+        {
+          case 't':
+            threads = strtol (optarg, NULL, 10);
+            break;
+          case 'f':
+            frame_parallel = true;
+            break;
+          case 'n':
+            runs = atoi (optarg);
+            break;
+          default:
+            usage (argv[0]);
+        }
+    }
+  if (optind >= argc || runs <= 0)
+    {
+      usage (argv[0]);
+    }
+
+  /* Same policy as the component's get_decoder_threads */
+  if (threads <= 0)
+    {
+      threads = sysconf (_SC_NPROCESSORS_ONLN);
+    }
+  if (threads > VP8DEC_BENCH_MAX_THREADS)
+    {
+      threads = VP8DEC_BENCH_MAX_THREADS;
+    }
+  if (threads <= 0)
+    {
+      threads = 1;
+    }
+
+  if (!load_ivf (argv[optind], &stream))
+    {
+      fprintf (stderr, "Unable to read %s (only VP8/VP9 IVF is supported)\n",
+               argv[optind]);
+      return EXIT_FAILURE;
+    }
+
+  len = stream.width * stream.height
+        + 2 * ((1 + stream.width) / 2) * ((1 + stream.height) / 2);
+  if (!(p_buf = malloc (len)))
+    {
+      return EXIT_FAILURE;
+    }
+
+  printf ("%s: %s %ux%u, %u frames, %ld threads%s\n", argv[optind],
+          vpx_codec_iface_name (stream.p_iface), stream.width, stream.height,
+          stream.nframes, threads, frame_parallel ? ", frame-parallel" : "");
+  for (i = 0; i < runs; ++i)
+    {
+      double total_ms = 0;
+      double copy_ms = 0;
+      const int frames
+        = decode_stream (&stream, threads, frame_parallel, p_buf, len,
+                         &total_ms, &copy_ms);
+      if (frames <= 0)
+        {
+          return EXIT_FAILURE;
+        }
+      printf ("run %d: %.1f fps (%.1f fps without the copy), "
+              "copy %.2f ms/frame\n",
+              i + 1, frames * 1000.0 / total_ms,
+              frames * 1000.0 / (total_ms - copy_ms), copy_ms / frames);
+    }
+
+  free (p_buf);
+  free (stream.p_frames);
+  free (stream.p_file);
+  return EXIT_SUCCESS;
+}